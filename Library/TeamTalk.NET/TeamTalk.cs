@@ -554,12 +554,20 @@ namespace BearWare
     /** @brief The protocols supported for transferring a
      * #BearWare.DesktopWindow.
      *
-     * So far only one, UDP-based, protocol is supported. */
+     * Both protocols are UDP-based and produce ZLIB compressed
+     * blocks, so a receiver can decode either. A receiver's
+     * #BearWare.DesktopWindow always reports
+     * #DesktopProtocol.DESKTOPPROTOCOL_ZLIB_1. */
     public enum DesktopProtocol : uint
     {
         /** @brief Desktop protocol based on ZLIB for image
          * compression and UDP for data transmission. */
-        DESKTOPPROTOCOL_ZLIB_1  = 1
+        DESKTOPPROTOCOL_ZLIB_1  = 1,
+        /** @brief Same as #DesktopProtocol.DESKTOPPROTOCOL_ZLIB_1
+         * but blocks are compressed for speed instead of size.
+         * Reduces the time it takes to process a desktop update at
+         * the cost of more bandwidth. */
+        DESKTOPPROTOCOL_ZLIB_FAST = 2
     }
 
     /**
@@ -596,6 +604,33 @@ namespace BearWare
         public int nFrameBufferSize;
     }
 
+    /**
+     * @brief A rectangle in the bitmap of a #BearWare.DesktopWindow
+     * which has changed since the previous desktop update.
+     *
+     * @see TeamTalkBase.SendDesktopWindowEx() */
+    [StructLayout(LayoutKind.Sequential)]
+    public struct DesktopRegion
+    {
+        /** @brief The left position in pixels. */
+        public int nX;
+        /** @brief The scan-line in @c frameBuffer of
+         * #BearWare.DesktopWindow where the region starts. */
+        public int nY;
+        /** @brief The width in pixels of the region. */
+        public int nWidth;
+        /** @brief The number of scan-lines in the region. */
+        public int nHeight;
+
+        public DesktopRegion(int x, int y, int width, int height)
+        {
+            nX = x;
+            nY = y;
+            nWidth = width;
+            nHeight = height;
+        }
+    }
+
     /**
      * @brief The state of a key (or mouse button), i.e. if it's
      * pressed or released. @see DesktopInput */
@@ -1412,6 +1447,11 @@ namespace BearWare
         public long nFilesRx;
         /** @brief The server's uptime in msec. */
         public long nUptimeMSec;
+        /** @brief The number of silent voice frames which clients
+         * did not transmit because of discontinuous transmission
+         * (DTX). Only unencrypted voice packets are counted.
+         * @see OpusCodec.bDTX */
+        public long nVoiceFramesSuppressed;
     }
 
     /**
@@ -1854,6 +1894,36 @@ namespace BearWare
         /** @brief Number of media file video frames dropped because user 
          * application didn't retrieve video frames in time. */
         public long nMediaFileVideoFramesDropped;
+        /** @brief Number of voice packets which arrived after their
+         * playout deadline and were discarded. */
+        public long nVoicePacketsLate;
+        /** @brief Number of voice frames which were lost and instead
+         * recovered from forward error correction data or
+         * interpolated by the audio codec. */
+        public long nVoiceFramesConcealed;
+        /** @brief Number of media file audio packets which arrived
+         * after their playout deadline and were discarded. */
+        public long nMediaFileAudioPacketsLate;
+        /** @brief Number of media file audio frames which were lost
+         * and instead recovered or interpolated by the audio codec. */
+        public long nMediaFileAudioFramesConcealed;
+        /** @brief Inter-arrival jitter of voice packets in msec. The
+         * jitter buffer adapts its playout delay to this value. */
+        public int nVoiceJitterMSec;
+        /** @brief Inter-arrival jitter of media file audio packets in
+         * msec. */
+        public int nMediaFileAudioJitterMSec;
+        /** @brief Number of video frames which were decoded ahead of
+         * TeamTalkBase.AcquireUserVideoCaptureFrame() but discarded
+         * because the user application didn't retrieve them in
+         * time. Frames are only decoded ahead once the user
+         * application has retrieved a video frame. */
+        public long nVideoCaptureFramesSkipped;
+        /** @brief Number of media file video frames which were
+         * decoded ahead of TeamTalkBase.AcquireUserMediaVideoFrame()
+         * but discarded because the user application didn't retrieve
+         * them in time. */
+        public long nMediaFileVideoFramesSkipped;
     }
 
     /** 
@@ -2237,6 +2307,30 @@ namespace BearWare
         /** @brief The number of seconds nothing has been received by
          * the client on UDP. */
         public int nUdpServerSilenceSec;
+        /** @brief The number of voice frames from the sound input
+         * device which were dropped because the audio encoder could
+         * not keep up. */
+        public int nVoiceCaptureOverruns;
+        /** @brief The number of silent voice frames which were not
+         * transmitted because of discontinuous transmission (DTX).
+         * @see OpusCodec.bDTX */
+        public int nVoiceFramesSuppressed;
+        /** @brief The number of events which were merged into an
+         * event of the same kind already in the #BearWare.TTMessage
+         * queue because TeamTalkBase.GetMessage() could not keep
+         * up. */
+        public int nEventsCoalesced;
+        /** @brief The number of events which were dropped because
+         * the #BearWare.TTMessage queue overflowed.
+         * @see ClientError.INTERR_TTMESSAGE_QUEUE_OVERFLOW */
+        public int nEventsDropped;
+        /** @brief The maximum size in bytes of the payload data
+         * currently put in UDP packets to the server. This is
+         * raised above the default by TeamTalkBase.QueryMaxPayload()
+         * if the path to the server allows it and reverted if packets
+         * of this size are lost.
+         * @see ClientEvent.CLIENTEVENT_CON_MAX_PAYLOAD_UPDATED */
+        public int nMaxPayloadSize;
     }
 
     /** @addtogroup errorhandling
@@ -2523,9 +2617,12 @@ namespace BearWare
          *
          * The message queue for events has overflowed because
          * TeamTalkBase.GetMessage() has not drained the queue in
-         * time. The #BearWare.TTMessage message queue will suspend
-         * event handling once the queue overflows and resumes event
-         * handling again when the message queue has been drained. */
+         * time. Event handling continues but events which only report
+         * the latest state of a user or stream, e.g.
+         * #ClientEvent.CLIENTEVENT_USER_STATECHANGE and
+         * #ClientEvent.CLIENTEVENT_USER_AUDIOBLOCK, are dropped until
+         * the message queue has been drained. Other events are never
+         * dropped. @see ClientStatistics.nEventsDropped */
         INTERR_TTMESSAGE_QUEUE_OVERFLOW         = 10004
     }
 
@@ -2597,7 +2694,10 @@ namespace BearWare
          * @param ttType #TTType.__INT32
          * @param nPayloadSize Placed in union of #BearWare.TTMessage. The
          * maximum size in bytes of the payload data which is put in
-         * UDP packets. 0 means the max payload query failed.  @see
+         * UDP packets. 0 means the max payload query failed. Also
+         * posted when a payload size above the default found by
+         * TeamTalkBase.QueryMaxPayload() falls back to the default
+         * size due to packet loss.  @see
          * TeamTalkBase.QueryMaxPayload() */
         CLIENTEVENT_CON_MAX_PAYLOAD_UPDATED = CLIENTEVENT_NONE + 40,
         /** 
@@ -3372,6 +3472,18 @@ namespace BearWare
         /** @brief Get the DLL's version number. */
         public static string GetVersion() { return Marshal.PtrToStringAuto(TTDLL.TT_GetVersion()); }
 
+        /**
+         * @brief Share a fixed number of network threads between
+         * client instances created afterwards.
+         *
+         * @param nThreads Number of shared network threads. 0 means
+         * every client instance has its own network thread.
+         * @see TT_SetSharedReactorThreads() */
+        public static bool SetSharedReactorThreads(int nThreads)
+        {
+            return TTDLL.TT_SetSharedReactorThreads(nThreads);
+        }
+
         /** 
          * @brief Create a new TeamTalk client instance.
          *
@@ -3494,6 +3606,27 @@ namespace BearWare
             return TTDLL.TT_GetMessage(m_ttInst, ref pMsg, ref nWaitMs);
         }
 
+        /**
+         * @brief Poll for several events in the client instance.
+         *
+         * Same as GetMessage() but retrieves all queued events, up to
+         * the length of @c pMsgs, in one call.
+         *
+         * @param pMsgs Array of TTMessage which will hold the events
+         * that have occured.
+         * @param nWaitMs The amount of time to wait for the first
+         * event. If -1 the function will block forever or until the
+         * next event occurs.
+         * @return The number of events placed in @c pMsgs.
+         * @see GetMessage() */
+        public int GetMessages(TTMessage[] pMsgs, int nWaitMs)
+        {
+            int nCount = pMsgs.Length;
+            if (!TTDLL.TT_GetMessages(m_ttInst, pMsgs, ref nCount, nWaitMs))
+                return 0;
+            return nCount;
+        }
+
         /**
          * @brief Cause client instance event thread to schedule an update
          * event.
@@ -4735,6 +4868,36 @@ namespace BearWare
             return TTDLL.TT_SendDesktopWindow(m_ttInst, ref lpDesktopWindow, nConvertBmpFormat);
         }
 
+        /**
+         * @brief Transmit a desktop window (bitmap) where only the
+         * specified regions have changed.
+         *
+         * Same as TeamTalkBase.SendDesktopWindow() except only the
+         * parts of the bitmap which intersect @c lpDirtyRegions are
+         * checked for changes. Use this if e.g. the operating system
+         * reports which parts of the screen have been redrawn since
+         * it avoids scanning the entire bitmap. Changes outside the
+         * regions are not transmitted. If the call fails the regions
+         * must be included again in the next call.
+         *
+         * The first bitmap of a desktop session is always transmitted
+         * entirely.
+         *
+         * @param lpDesktopWindow Properties of the bitmap. Set the @c nSessionID 
+         * property to 0.
+         * @param nConvertBmpFormat Before transmission convert the bitmap to this 
+         * format.
+         * @param lpDirtyRegions Regions which have changed since the
+         * previous call.
+         * @return See TeamTalkBase.SendDesktopWindow(). */
+        public int SendDesktopWindowEx(DesktopWindow lpDesktopWindow,
+                                       BitmapFormat nConvertBmpFormat,
+                                       DesktopRegion[] lpDirtyRegions)
+        {
+            return TTDLL.TT_SendDesktopWindowEx(m_ttInst, ref lpDesktopWindow, nConvertBmpFormat,
+                                                lpDirtyRegions, lpDirtyRegions.Length);
+        }
+
         /**
          * @brief Close the current desktop session.
          *
@@ -80,12 +80,19 @@ namespace c_tt
         [DllImport(dllname, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
         public static extern IntPtr TT_InitTeamTalkPoll();
         [DllImport(dllname, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public static extern bool TT_SetSharedReactorThreads(int nThreads);
+        [DllImport(dllname, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
         public static extern bool TT_CloseTeamTalk(IntPtr lpTTInstance);
         [DllImport(dllname, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
         public static extern bool TT_GetMessage(IntPtr lpTTInstance,
                                                ref BearWare.TTMessage pMsg,
                                                ref int pnWaitMs);
         [DllImport(dllname, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public static extern bool TT_GetMessages(IntPtr lpTTInstance,
+                                                [In, Out] BearWare.TTMessage[] pMsgs,
+                                                ref int pnCount,
+                                                int nWaitMs);
+        [DllImport(dllname, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
         public static extern bool TT_PumpMessage(IntPtr lpTTInstance,
                                                  BearWare.ClientEvent nClientEvent,
                                                  int nIdentifier);
@@ -234,6 +241,12 @@ namespace c_tt
                                                ref BearWare.DesktopWindow lpDesktopWindow,
                                                BearWare.BitmapFormat nConvertBmpFormat);
         [DllImport(dllname, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public static extern int TT_SendDesktopWindowEx(IntPtr lpTTInstance,
+                                                        ref BearWare.DesktopWindow lpDesktopWindow,
+                                                        BearWare.BitmapFormat nConvertBmpFormat,
+                                                        [In] BearWare.DesktopRegion[] lpDirtyRegions,
+                                                        int nDirtyRegionsCount);
+        [DllImport(dllname, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
         public static extern bool TT_CloseDesktopWindow(IntPtr lpTTInstance);
         [DllImport(dllname, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
         public static extern IntPtr TT_Palette_GetColorTable(BearWare.BitmapFormat nBmpPalette,
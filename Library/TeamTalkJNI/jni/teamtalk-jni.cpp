@@ -41,6 +41,13 @@ extern "C" {
         return NEW_JSTRING(env, ttv);
     }
 
+    JNIEXPORT jboolean JNICALL Java_dk_bearware_TeamTalkBase_setSharedReactorThreads(JNIEnv* env,
+                                                                                    jclass,
+                                                                                    jint nThreads)
+    {
+        return TT_SetSharedReactorThreads(nThreads);
+    }
+
     JNIEXPORT jlong JNICALL Java_dk_bearware_TeamTalkBase_initTeamTalkPoll(JNIEnv* env,
                                                                            jobject thiz)
     {
@@ -71,6 +78,37 @@ extern "C" {
         return b;
     }
 
+    JNIEXPORT jint JNICALL Java_dk_bearware_TeamTalkBase_getMessages(JNIEnv* env,
+                                                                     jobject thiz,
+                                                                     jlong lpTTInstance,
+                                                                     jobjectArray pMsgs,
+                                                                     jint nWaitMs)
+    {
+        THROW_NULLEX(env, pMsgs, 0);
+
+        INT32 count = env->GetArrayLength(pMsgs);
+        if(count <= 0)
+            return 0;
+
+        std::vector<TTMessage> msgs(count);
+        if(!TT_GetMessages(reinterpret_cast<TTInstance*>(lpTTInstance),
+                           &msgs[0], &count, nWaitMs))
+            return 0;
+
+        for(INT32 i=0;i<count;i++)
+        {
+            jobject msg = env->GetObjectArrayElement(pMsgs, i);
+            if(!msg)
+            {
+                msg = newObject(env, JCLS_TTMESSAGE);
+                env->SetObjectArrayElement(pMsgs, i, msg);
+            }
+            setTTMessage(env, msgs[i], msg);
+            env->DeleteLocalRef(msg);
+        }
+        return count;
+    }
+
     JNIEXPORT jboolean JNICALL Java_dk_bearware_TeamTalkBase_pumpMessage(JNIEnv* env,
                                                                          jobject thiz,
                                                                          jlong lpTTInstance,
@@ -513,15 +551,44 @@ extern "C" {
         if(!vidframe)
             return NULL;
 
-        jclass cls = env->FindClass("dk/bearware/VideoFrame");
-        jobject vidframe_obj = newObject(env, cls);
+        jobject vidframe_obj = newObject(env, JCLS_VIDEOFRAME);
         setVideoFrame(env, *vidframe, vidframe_obj);
 
         TT_ReleaseUserVideoCaptureFrame(reinterpret_cast<TTInstance*>(lpTTInstance), vidframe);
         return vidframe_obj;
     }
 
-// ReleaseUserVideoCaptureFrame()
+    JNIEXPORT jobject JNICALL Java_dk_bearware_TeamTalkBase_acquireUserVideoCaptureFrameDirect(JNIEnv* env,
+                                                                                               jobject thiz,
+                                                                                               jlong lpTTInstance,
+                                                                                               jint nUserID)
+    {
+        VideoFrame* vidframe = TT_AcquireUserVideoCaptureFrame(reinterpret_cast<TTInstance*>(lpTTInstance),
+                                                               nUserID);
+        if(!vidframe)
+            return NULL;
+
+        jobject vidframe_obj = newObject(env, JCLS_VIDEOFRAME);
+        if(!setVideoFrame(env, *vidframe, vidframe_obj, true))
+        {
+            TT_ReleaseUserVideoCaptureFrame(reinterpret_cast<TTInstance*>(lpTTInstance), vidframe);
+            return NULL;
+        }
+        return vidframe_obj;
+    }
+
+    JNIEXPORT jboolean JNICALL Java_dk_bearware_TeamTalkBase_releaseUserVideoCaptureFrame(JNIEnv* env,
+                                                                                          jobject thiz,
+                                                                                          jlong lpTTInstance,
+                                                                                          jobject lpVideoFrame)
+    {
+        THROW_NULLEX(env, lpVideoFrame, false);
+
+        VideoFrame* vidframe = detachVideoFrame(env, lpVideoFrame);
+        if(!vidframe)
+            return false;
+        return TT_ReleaseUserVideoCaptureFrame(reinterpret_cast<TTInstance*>(lpTTInstance), vidframe);
+    }
 
     JNIEXPORT jboolean JNICALL Java_dk_bearware_TeamTalkBase_startStreamingMediaFileToChannel(JNIEnv* env,
                                                                                               jobject thiz,
@@ -576,8 +643,7 @@ extern "C" {
         if(!vidframe)
             return NULL;
 
-        jclass cls = env->FindClass("dk/bearware/VideoFrame");
-        jobject vidframe_obj = newObject(env, cls);
+        jobject vidframe_obj = newObject(env, JCLS_VIDEOFRAME);
         setVideoFrame(env, *vidframe, vidframe_obj);
 
         TT_ReleaseUserMediaVideoFrame(reinterpret_cast<TTInstance*>(lpTTInstance), vidframe);
@@ -585,15 +651,38 @@ extern "C" {
 
     }
 
-/*
-    JNIEXPORT jobject JNICALL Java_dk_bearware_TeamTalkBase_releaseUserMediaVideoFrame(JNIEnv* env,
-                                                                                       jobject thiz,
-                                                                                       jlong lpTTInstance,
-                                                                                       jobject lpVideoFrame)
+    JNIEXPORT jobject JNICALL Java_dk_bearware_TeamTalkBase_acquireUserMediaVideoFrameDirect(JNIEnv* env,
+                                                                                             jobject thiz,
+                                                                                             jlong lpTTInstance,
+                                                                                             jint nUserID)
+    {
+        VideoFrame* vidframe = TT_AcquireUserMediaVideoFrame(reinterpret_cast<TTInstance*>(lpTTInstance),
+                                                             nUserID);
+        if(!vidframe)
+            return NULL;
+
+        jobject vidframe_obj = newObject(env, JCLS_VIDEOFRAME);
+        if(!setVideoFrame(env, *vidframe, vidframe_obj, true))
+        {
+            TT_ReleaseUserMediaVideoFrame(reinterpret_cast<TTInstance*>(lpTTInstance), vidframe);
+            return NULL;
+        }
+        return vidframe_obj;
+    }
+
+    JNIEXPORT jboolean JNICALL Java_dk_bearware_TeamTalkBase_releaseUserMediaVideoFrame(JNIEnv* env,
+                                                                                        jobject thiz,
+                                                                                        jlong lpTTInstance,
+                                                                                        jobject lpVideoFrame)
     {
-        return NULL;
+        THROW_NULLEX(env, lpVideoFrame, false);
+
+        VideoFrame* vidframe = detachVideoFrame(env, lpVideoFrame);
+        if(!vidframe)
+            return false;
+        return TT_ReleaseUserMediaVideoFrame(reinterpret_cast<TTInstance*>(lpTTInstance), vidframe);
     }
-*/
+
     JNIEXPORT jint JNICALL Java_dk_bearware_TeamTalkBase_sendDesktopWindow(JNIEnv* env,
                                                                            jobject thiz,
                                                                            jlong lpTTInstance,
@@ -622,6 +711,50 @@ extern "C" {
        return ret;
     }
 
+    JNIEXPORT jint JNICALL Java_dk_bearware_TeamTalkBase_sendDesktopWindowEx(JNIEnv* env,
+                                                                             jobject thiz,
+                                                                             jlong lpTTInstance,
+                                                                             jobject lpDesktopWindow,
+                                                                             jint nConvertBmpFormat,
+                                                                             jobjectArray lpDirtyRegions)
+    {
+        THROW_NULLEX(env, lpDesktopWindow, -1);
+        THROW_NULLEX(env, lpDirtyRegions, -1);
+
+        DesktopWindow wnd;
+        setDesktopWindow(env, wnd, lpDesktopWindow, J2N);
+
+        jsize len = env->GetArrayLength(lpDirtyRegions);
+        std::vector<DesktopRegion> regions(len);
+        for(jsize i=0;i<len;i++)
+        {
+            jobject region = env->GetObjectArrayElement(lpDirtyRegions, i);
+            THROW_NULLEX(env, region, -1);
+            setDesktopRegion(env, regions[i], region, J2N);
+            env->DeleteLocalRef(region);
+        }
+
+        jclass cls = env->GetObjectClass(lpDesktopWindow);
+        jfieldID fid_frmbuf = env->GetFieldID(cls, "frameBuffer", "[B");
+        assert(fid_frmbuf);
+
+        jbyteArray buf = (jbyteArray)env->GetObjectField(lpDesktopWindow, fid_frmbuf);
+        jbyte* bufptr = env->GetByteArrayElements(buf, 0);
+        if(!bufptr)
+            return -1;
+
+        wnd.frameBuffer = bufptr;
+        wnd.nFrameBufferSize = env->GetArrayLength(buf);
+
+        jint ret = TT_SendDesktopWindowEx(reinterpret_cast<TTInstance*>(lpTTInstance),
+                                          &wnd, (BitmapFormat)nConvertBmpFormat,
+                                          len? &regions[0] : NULL, len);
+
+        //bitmap is only read so discard changes
+        env->ReleaseByteArrayElements(buf, bufptr, JNI_ABORT);
+        return ret;
+    }
+
     JNIEXPORT jboolean JNICALL Java_dk_bearware_TeamTalkBase_closeDesktopWindow(JNIEnv* env,
                                                                                 jobject thiz,
                                                                                 jlong lpTTInstance)
@@ -666,8 +799,7 @@ extern "C" {
         if(!deskwnd)
             return NULL;
 
-        jclass cls = env->FindClass("dk/bearware/DesktopWindow");
-        jobject deskwnd_obj = newObject(env, cls);
+        jobject deskwnd_obj = newObject(env, JCLS_DESKTOPWINDOW);
         setDesktopWindow(env, *deskwnd, deskwnd_obj, N2J);
 
         TT_ReleaseUserDesktopWindow(reinterpret_cast<TTInstance*>(lpTTInstance), deskwnd);
@@ -684,14 +816,44 @@ extern "C" {
         if(!deskwnd)
             return NULL;
 
-        jclass cls = env->FindClass("dk/bearware/DesktopWindow");
-        jobject deskwnd_obj = newObject(env, cls);
+        jobject deskwnd_obj = newObject(env, JCLS_DESKTOPWINDOW);
         setDesktopWindow(env, *deskwnd, deskwnd_obj, N2J);
 
         TT_ReleaseUserDesktopWindow(reinterpret_cast<TTInstance*>(lpTTInstance), deskwnd);
         return deskwnd_obj;
     }
 
+    JNIEXPORT jobject JNICALL Java_dk_bearware_TeamTalkBase_acquireUserDesktopWindowDirect(JNIEnv* env,
+                                                                                           jobject thiz,
+                                                                                           jlong lpTTInstance,
+                                                                                           jint nUserID,
+                                                                                           jint nBitmapFormat) {
+        DesktopWindow* deskwnd = TT_AcquireUserDesktopWindowEx(reinterpret_cast<TTInstance*>(lpTTInstance),
+                                                               nUserID, (BitmapFormat)nBitmapFormat);
+        if(!deskwnd)
+            return NULL;
+
+        jobject deskwnd_obj = newObject(env, JCLS_DESKTOPWINDOW);
+        if(!setDesktopWindow(env, *deskwnd, deskwnd_obj, N2J, true))
+        {
+            TT_ReleaseUserDesktopWindow(reinterpret_cast<TTInstance*>(lpTTInstance), deskwnd);
+            return NULL;
+        }
+        return deskwnd_obj;
+    }
+
+    JNIEXPORT jboolean JNICALL Java_dk_bearware_TeamTalkBase_releaseUserDesktopWindow(JNIEnv* env,
+                                                                                      jobject thiz,
+                                                                                      jlong lpTTInstance,
+                                                                                      jobject lpDesktopWindow) {
+        THROW_NULLEX(env, lpDesktopWindow, false);
+
+        DesktopWindow* deskwnd = detachDesktopWindow(env, lpDesktopWindow);
+        if(!deskwnd)
+            return false;
+        return TT_ReleaseUserDesktopWindow(reinterpret_cast<TTInstance*>(lpTTInstance), deskwnd);
+    }
+
     JNIEXPORT jboolean JNICALL Java_dk_bearware_TeamTalkBase_connect(JNIEnv* env,
                                                                      jobject thiz,
                                                                      jlong lpTTInstance,
@@ -1623,13 +1785,44 @@ extern "C" {
                                                         (StreamType)nStreamType, nUserID);
         if(!audblock)
             return NULL;
-        jclass cls = env->FindClass("dk/bearware/AudioBlock");
-        jobject audblk_obj = newObject(env, cls);
+        jobject audblk_obj = newObject(env, JCLS_AUDIOBLOCK);
         setAudioBlock(env, *audblock, audblk_obj);
         TT_ReleaseUserAudioBlock(reinterpret_cast<TTInstance*>(lpTTInstance), audblock);
         return audblk_obj;
     }
 
+    JNIEXPORT jobject JNICALL Java_dk_bearware_TeamTalkBase_acquireUserAudioBlockDirect(JNIEnv* env,
+                                                                                        jobject thiz,
+                                                                                        jlong lpTTInstance,
+                                                                                        jint nStreamType,
+                                                                                        jint nUserID)
+    {
+        AudioBlock* audblock = TT_AcquireUserAudioBlock(reinterpret_cast<TTInstance*>(lpTTInstance),
+                                                        (StreamType)nStreamType, nUserID);
+        if(!audblock)
+            return NULL;
+        jobject audblk_obj = newObject(env, JCLS_AUDIOBLOCK);
+        if(!setAudioBlock(env, *audblock, audblk_obj, true))
+        {
+            TT_ReleaseUserAudioBlock(reinterpret_cast<TTInstance*>(lpTTInstance), audblock);
+            return NULL;
+        }
+        return audblk_obj;
+    }
+
+    JNIEXPORT jboolean JNICALL Java_dk_bearware_TeamTalkBase_releaseUserAudioBlock(JNIEnv* env,
+                                                                                   jobject thiz,
+                                                                                   jlong lpTTInstance,
+                                                                                   jobject lpAudioBlock)
+    {
+        THROW_NULLEX(env, lpAudioBlock, false);
+
+        AudioBlock* audblock = detachAudioBlock(env, lpAudioBlock);
+        if(!audblock)
+            return false;
+        return TT_ReleaseUserAudioBlock(reinterpret_cast<TTInstance*>(lpTTInstance), audblock);
+    }
+
     JNIEXPORT jboolean JNICALL Java_dk_bearware_TeamTalkBase_getFileTransferInfo(JNIEnv* env,
                                                                                  jobject thiz,
                                                                                  jlong lpTTInstance,
@@ -51,6 +51,481 @@ jobject newObject(JNIEnv* env, jclass cls_obj)
     return newObj;
 }
 
+static const char* jclass_names[JCLS_COUNT] =
+{
+    "dk/bearware/TTMessage",
+    "dk/bearware/Channel",
+    "dk/bearware/ClientErrorMsg",
+    "dk/bearware/DesktopInput",
+    "dk/bearware/FileTransfer",
+    "dk/bearware/MediaFileInfo",
+    "dk/bearware/RemoteFile",
+    "dk/bearware/ServerProperties",
+    "dk/bearware/ServerStatistics",
+    "dk/bearware/TextMessage",
+    "dk/bearware/User",
+    "dk/bearware/UserAccount",
+    "dk/bearware/BannedUser",
+    "dk/bearware/VideoFrame",
+    "dk/bearware/AudioBlock",
+    "dk/bearware/DesktopWindow",
+    "dk/bearware/AudioCodec",
+    "dk/bearware/SpeexCodec",
+    "dk/bearware/SpeexVBRCodec",
+    "dk/bearware/OpusCodec",
+    "dk/bearware/AudioConfig",
+    "dk/bearware/AudioFormat",
+    "dk/bearware/VideoFormat",
+    "dk/bearware/AbusePrevention",
+    "dk/bearware/ClientStatistics",
+    "dk/bearware/UserStatistics",
+};
+
+// global references so the classes cannot be unloaded, which would
+// invalidate the cached IDs
+static jclass jclasses[JCLS_COUNT];
+static jmethodID jctors[JCLS_COUNT];
+
+static struct
+{
+    jfieldID event, src, type;
+    jfieldID channel, cemsg, deskinput, ftx, mfi, rfile, srvp, srvs,
+        txtmsg, usr, acc, ban, act, bremain, streamid, payload, st;
+} fid_ttmsg;
+
+static struct
+{
+    jfieldID w, h, sid, kfrm, frmbuf, directbuf, nativeptr;
+} fid_vidframe;
+
+static struct
+{
+    jfieldID sid, sr, ch, audbuf, sn, si, directbuf, nativeptr;
+} fid_audblock;
+
+static struct
+{
+    jfieldID w, h, bmpfmt, bpl, sesid, frmbuf, directbuf, nativeptr;
+} fid_deskwnd;
+
+static struct
+{
+    jfieldID codec, speex, speexvbr, opus;
+} fid_audiocodec;
+
+static struct
+{
+    jfieldID bandmode, quality, msec, stereo;
+} fid_spx;
+
+static struct
+{
+    jfieldID bandmode, quality, bitrate, maxbitrate, msec, dtx, stereo;
+} fid_spxvbr;
+
+static struct
+{
+    jfieldID sr, ch, app, comp, fec, dtx, br, vbr, vbrc, msec;
+} fid_opuscodec;
+
+static struct
+{
+    jfieldID parentid, chanid, name, topic, passwd, prot, chantype,
+        userdata, quota, oppasswd, maxusers, codec, audcfg, queueusers;
+} fid_channel;
+
+static struct
+{
+    jfieldID userid, username, userdata, usertype, ipaddr, version, chanid,
+        lsub, psub, nickname, stmode, stmsg, state, folder, volvoice,
+        volmf, stopvoice, stopmf, pbvoice, pbmf, mfbuf, vbuf, cltname;
+} fid_usr;
+
+static struct
+{
+    jfieldID agc, gainlevel;
+} fid_audiocfg;
+
+static struct
+{
+    jfieldID name, motd, motdraw, maxusers, maxattempts, iplogins, voicetx,
+        vidcaptx, mftx, desktx, totaltx, save, tcp, udp, tmout, srvver,
+        srvprot;
+} fid_srvprop;
+
+static struct
+{
+    jfieldID udpsent, udprecv, voicesent, voicerecv, videosent, videorecv,
+        mfaudsent, mfaudrecv, mfvidsent, mfvidrecv, desksent, deskrecv,
+        udpping, tcpping, tcpsilen, udpsilen, vcoverrun, vcsuppress,
+        evcoalesced, evdropped, maxpayload;
+} fid_cltstats;
+
+static struct
+{
+    jfieldID type, fromid, username, toid, chanid, msg;
+} fid_txtmsg;
+
+static struct
+{
+    jfieldID user, passwd, type, data, ur, note, initchan, op, audbps,
+        abuse;
+} fid_account;
+
+static struct
+{
+    jfieldID totaltx, totalrx, voicetx, voicerx, videotx, videorx, mftx,
+        mfrx, desktx, deskrx, uptm, vsuppress;
+} fid_srvstats;
+
+static struct
+{
+    jfieldID id, cid, name, size, user;
+} fid_rfile;
+
+static struct
+{
+    jfieldID voirx, voilost, vidrx, vidftx, vidflost, vidfdropped, mfaudrx,
+        mfaudlost, mfvidrx, mfvidftx, mfvidflost, mfvidfdropped, voilate,
+        voiconceal, mfaudlate, mfaudconceal, voijitter, mfaudjitter,
+        vidfskipped, mfvidfskipped;
+} fid_usrstats;
+
+static struct
+{
+    jfieldID status, txid, chanid, filepath, rempath, size, txed, inbound;
+} fid_filetx;
+
+static struct
+{
+    jfieldID ipaddr, chan, time, nick, username, bantype;
+} fid_ban;
+
+static struct
+{
+    jfieldID err, msg;
+} fid_cemsg;
+
+static struct
+{
+    jfieldID x, y, keycode, keystate;
+} fid_deskinput;
+
+static struct
+{
+    jfieldID status, fname, audfmt, vidfmt, dur;
+} fid_mfi;
+
+static struct
+{
+    jfieldID audfmt, sr, ch;
+} fid_audiofmt;
+
+static struct
+{
+    jfieldID w, h, fpsN, fpsD, fcc;
+} fid_videofmt;
+
+static struct
+{
+    jfieldID cmds, msec;
+} fid_abuseprev;
+
+jobject newObject(JNIEnv* env, JClassID cls)
+{
+    assert(jclasses[cls]);
+    jobject newObj = env->NewObject(jclasses[cls], jctors[cls]);
+    assert(newObj);
+    return newObj;
+}
+
+static jfieldID getFieldID(JNIEnv* env, JClassID cls, const char* name, const char* sig)
+{
+    jfieldID fid = env->GetFieldID(jclasses[cls], name, sig);
+    assert(fid);
+    return fid;
+}
+
+extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved)
+{
+    JNIEnv* env;
+    if(vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK)
+        return JNI_ERR;
+
+    for(int i=0;i<JCLS_COUNT;i++)
+    {
+        jclass cls = env->FindClass(jclass_names[i]);
+        if(!cls)
+            return JNI_ERR;
+        jclasses[i] = static_cast<jclass>(env->NewGlobalRef(cls));
+        env->DeleteLocalRef(cls);
+        jctors[i] = env->GetMethodID(jclasses[i], "<init>", "()V");
+        assert(jctors[i]);
+    }
+
+    fid_ttmsg.event = getFieldID(env, JCLS_TTMESSAGE, "nClientEvent", "I");
+    fid_ttmsg.src = getFieldID(env, JCLS_TTMESSAGE, "nSource", "I");
+    fid_ttmsg.type = getFieldID(env, JCLS_TTMESSAGE, "ttType", "I");
+    fid_ttmsg.channel = getFieldID(env, JCLS_TTMESSAGE, "channel", "Ldk/bearware/Channel;");
+    fid_ttmsg.cemsg = getFieldID(env, JCLS_TTMESSAGE, "clienterrormsg", "Ldk/bearware/ClientErrorMsg;");
+    fid_ttmsg.deskinput = getFieldID(env, JCLS_TTMESSAGE, "desktopinput", "Ldk/bearware/DesktopInput;");
+    fid_ttmsg.ftx = getFieldID(env, JCLS_TTMESSAGE, "filetransfer", "Ldk/bearware/FileTransfer;");
+    fid_ttmsg.mfi = getFieldID(env, JCLS_TTMESSAGE, "mediafileinfo", "Ldk/bearware/MediaFileInfo;");
+    fid_ttmsg.rfile = getFieldID(env, JCLS_TTMESSAGE, "remotefile", "Ldk/bearware/RemoteFile;");
+    fid_ttmsg.srvp = getFieldID(env, JCLS_TTMESSAGE, "serverproperties", "Ldk/bearware/ServerProperties;");
+    fid_ttmsg.srvs = getFieldID(env, JCLS_TTMESSAGE, "serverstatistics", "Ldk/bearware/ServerStatistics;");
+    fid_ttmsg.txtmsg = getFieldID(env, JCLS_TTMESSAGE, "textmessage", "Ldk/bearware/TextMessage;");
+    fid_ttmsg.usr = getFieldID(env, JCLS_TTMESSAGE, "user", "Ldk/bearware/User;");
+    fid_ttmsg.acc = getFieldID(env, JCLS_TTMESSAGE, "useraccount", "Ldk/bearware/UserAccount;");
+    fid_ttmsg.ban = getFieldID(env, JCLS_TTMESSAGE, "banneduser", "Ldk/bearware/BannedUser;");
+    fid_ttmsg.act = getFieldID(env, JCLS_TTMESSAGE, "bActive", "Z");
+    fid_ttmsg.bremain = getFieldID(env, JCLS_TTMESSAGE, "nBytesRemain", "I");
+    fid_ttmsg.streamid = getFieldID(env, JCLS_TTMESSAGE, "nStreamID", "I");
+    fid_ttmsg.payload = getFieldID(env, JCLS_TTMESSAGE, "nPayloadSize", "I");
+    fid_ttmsg.st = getFieldID(env, JCLS_TTMESSAGE, "nStreamType", "I");
+
+    fid_vidframe.w = getFieldID(env, JCLS_VIDEOFRAME, "nWidth", "I");
+    fid_vidframe.h = getFieldID(env, JCLS_VIDEOFRAME, "nHeight", "I");
+    fid_vidframe.sid = getFieldID(env, JCLS_VIDEOFRAME, "nStreamID", "I");
+    fid_vidframe.kfrm = getFieldID(env, JCLS_VIDEOFRAME, "bKeyFrame", "Z");
+    fid_vidframe.frmbuf = getFieldID(env, JCLS_VIDEOFRAME, "frameBuffer", "[B");
+    fid_vidframe.directbuf = getFieldID(env, JCLS_VIDEOFRAME, "directBuffer", "Ljava/nio/ByteBuffer;");
+    fid_vidframe.nativeptr = getFieldID(env, JCLS_VIDEOFRAME, "nativePtr", "J");
+
+    fid_audblock.sid = getFieldID(env, JCLS_AUDIOBLOCK, "nStreamID", "I");
+    fid_audblock.sr = getFieldID(env, JCLS_AUDIOBLOCK, "nSampleRate", "I");
+    fid_audblock.ch = getFieldID(env, JCLS_AUDIOBLOCK, "nChannels", "I");
+    fid_audblock.audbuf = getFieldID(env, JCLS_AUDIOBLOCK, "lpRawAudio", "[B");
+    fid_audblock.sn = getFieldID(env, JCLS_AUDIOBLOCK, "nSamples", "I");
+    fid_audblock.si = getFieldID(env, JCLS_AUDIOBLOCK, "uSampleIndex", "I");
+    fid_audblock.directbuf = getFieldID(env, JCLS_AUDIOBLOCK, "directBuffer", "Ljava/nio/ByteBuffer;");
+    fid_audblock.nativeptr = getFieldID(env, JCLS_AUDIOBLOCK, "nativePtr", "J");
+
+    fid_deskwnd.w = getFieldID(env, JCLS_DESKTOPWINDOW, "nWidth", "I");
+    fid_deskwnd.h = getFieldID(env, JCLS_DESKTOPWINDOW, "nHeight", "I");
+    fid_deskwnd.bmpfmt = getFieldID(env, JCLS_DESKTOPWINDOW, "bmpFormat", "I");
+    fid_deskwnd.bpl = getFieldID(env, JCLS_DESKTOPWINDOW, "nBytesPerLine", "I");
+    fid_deskwnd.sesid = getFieldID(env, JCLS_DESKTOPWINDOW, "nSessionID", "I");
+    fid_deskwnd.frmbuf = getFieldID(env, JCLS_DESKTOPWINDOW, "frameBuffer", "[B");
+    fid_deskwnd.directbuf = getFieldID(env, JCLS_DESKTOPWINDOW, "directBuffer", "Ljava/nio/ByteBuffer;");
+    fid_deskwnd.nativeptr = getFieldID(env, JCLS_DESKTOPWINDOW, "nativePtr", "J");
+
+
+    fid_audiocodec.codec = getFieldID(env, JCLS_AUDIOCODEC, "nCodec", "I");
+    fid_audiocodec.speex = getFieldID(env, JCLS_AUDIOCODEC, "speex", "Ldk/bearware/SpeexCodec;");
+    fid_audiocodec.speexvbr = getFieldID(env, JCLS_AUDIOCODEC, "speex_vbr", "Ldk/bearware/SpeexVBRCodec;");
+    fid_audiocodec.opus = getFieldID(env, JCLS_AUDIOCODEC, "opus", "Ldk/bearware/OpusCodec;");
+
+    fid_spx.bandmode = getFieldID(env, JCLS_SPEEXCODEC, "nBandmode", "I");
+    fid_spx.quality = getFieldID(env, JCLS_SPEEXCODEC, "nQuality", "I");
+    fid_spx.msec = getFieldID(env, JCLS_SPEEXCODEC, "nTxIntervalMSec", "I");
+    fid_spx.stereo = getFieldID(env, JCLS_SPEEXCODEC, "bStereoPlayback", "Z");
+
+    fid_spxvbr.bandmode = getFieldID(env, JCLS_SPEEXVBRCODEC, "nBandmode", "I");
+    fid_spxvbr.quality = getFieldID(env, JCLS_SPEEXVBRCODEC, "nQuality", "I");
+    fid_spxvbr.bitrate = getFieldID(env, JCLS_SPEEXVBRCODEC, "nBitRate", "I");
+    fid_spxvbr.maxbitrate = getFieldID(env, JCLS_SPEEXVBRCODEC, "nMaxBitRate", "I");
+    fid_spxvbr.msec = getFieldID(env, JCLS_SPEEXVBRCODEC, "nTxIntervalMSec", "I");
+    fid_spxvbr.dtx = getFieldID(env, JCLS_SPEEXVBRCODEC, "bDTX", "Z");
+    fid_spxvbr.stereo = getFieldID(env, JCLS_SPEEXVBRCODEC, "bStereoPlayback", "Z");
+
+    fid_opuscodec.sr = getFieldID(env, JCLS_OPUSCODEC, "nSampleRate", "I");
+    fid_opuscodec.ch = getFieldID(env, JCLS_OPUSCODEC, "nChannels", "I");
+    fid_opuscodec.app = getFieldID(env, JCLS_OPUSCODEC, "nApplication", "I");
+    fid_opuscodec.comp = getFieldID(env, JCLS_OPUSCODEC, "nComplexity", "I");
+    fid_opuscodec.fec = getFieldID(env, JCLS_OPUSCODEC, "bFEC", "Z");
+    fid_opuscodec.dtx = getFieldID(env, JCLS_OPUSCODEC, "bDTX", "Z");
+    fid_opuscodec.br = getFieldID(env, JCLS_OPUSCODEC, "nBitRate", "I");
+    fid_opuscodec.vbr = getFieldID(env, JCLS_OPUSCODEC, "bVBR", "Z");
+    fid_opuscodec.vbrc = getFieldID(env, JCLS_OPUSCODEC, "bVBRConstraint", "Z");
+    fid_opuscodec.msec = getFieldID(env, JCLS_OPUSCODEC, "nTxIntervalMSec", "I");
+
+    fid_channel.parentid = getFieldID(env, JCLS_CHANNEL, "nParentID", "I");
+    fid_channel.chanid = getFieldID(env, JCLS_CHANNEL, "nChannelID", "I");
+    fid_channel.name = getFieldID(env, JCLS_CHANNEL, "szName", "Ljava/lang/String;");
+    fid_channel.topic = getFieldID(env, JCLS_CHANNEL, "szTopic", "Ljava/lang/String;");
+    fid_channel.passwd = getFieldID(env, JCLS_CHANNEL, "szPassword", "Ljava/lang/String;");
+    fid_channel.prot = getFieldID(env, JCLS_CHANNEL, "bPassword", "Z");
+    fid_channel.chantype = getFieldID(env, JCLS_CHANNEL, "uChannelType", "I");
+    fid_channel.userdata = getFieldID(env, JCLS_CHANNEL, "nUserData", "I");
+    fid_channel.quota = getFieldID(env, JCLS_CHANNEL, "nDiskQuota", "J");
+    fid_channel.oppasswd = getFieldID(env, JCLS_CHANNEL, "szOpPassword", "Ljava/lang/String;");
+    fid_channel.maxusers = getFieldID(env, JCLS_CHANNEL, "nMaxUsers", "I");
+    fid_channel.codec = getFieldID(env, JCLS_CHANNEL, "audiocodec", "Ldk/bearware/AudioCodec;");
+    fid_channel.audcfg = getFieldID(env, JCLS_CHANNEL, "audiocfg", "Ldk/bearware/AudioConfig;");
+    fid_channel.queueusers = getFieldID(env, JCLS_CHANNEL, "transmitUsersQueue", "[I");
+
+    fid_usr.userid = getFieldID(env, JCLS_USER, "nUserID", "I");
+    fid_usr.username = getFieldID(env, JCLS_USER, "szUsername", "Ljava/lang/String;");
+    fid_usr.userdata = getFieldID(env, JCLS_USER, "nUserData", "I");
+    fid_usr.usertype = getFieldID(env, JCLS_USER, "uUserType", "I");
+    fid_usr.ipaddr = getFieldID(env, JCLS_USER, "szIPAddress", "Ljava/lang/String;");
+    fid_usr.version = getFieldID(env, JCLS_USER, "uVersion", "I");
+    fid_usr.chanid = getFieldID(env, JCLS_USER, "nChannelID", "I");
+    fid_usr.lsub = getFieldID(env, JCLS_USER, "uLocalSubscriptions", "I");
+    fid_usr.psub = getFieldID(env, JCLS_USER, "uPeerSubscriptions", "I");
+    fid_usr.nickname = getFieldID(env, JCLS_USER, "szNickname", "Ljava/lang/String;");
+    fid_usr.stmode = getFieldID(env, JCLS_USER, "nStatusMode", "I");
+    fid_usr.stmsg = getFieldID(env, JCLS_USER, "szStatusMsg", "Ljava/lang/String;");
+    fid_usr.state = getFieldID(env, JCLS_USER, "uUserState", "I");
+    fid_usr.folder = getFieldID(env, JCLS_USER, "szMediaStorageDir", "Ljava/lang/String;");
+    fid_usr.volvoice = getFieldID(env, JCLS_USER, "nVolumeVoice", "I");
+    fid_usr.volmf = getFieldID(env, JCLS_USER, "nVolumeMediaFile", "I");
+    fid_usr.stopvoice = getFieldID(env, JCLS_USER, "nStoppedDelayVoice", "I");
+    fid_usr.stopmf = getFieldID(env, JCLS_USER, "nStoppedDelayMediaFile", "I");
+    fid_usr.pbvoice = getFieldID(env, JCLS_USER, "stereoPlaybackVoice", "[Z");
+    fid_usr.pbmf = getFieldID(env, JCLS_USER, "stereoPlaybackMediaFile", "[Z");
+    fid_usr.mfbuf = getFieldID(env, JCLS_USER, "nBufferMSecMediaFile", "I");
+    fid_usr.vbuf = getFieldID(env, JCLS_USER, "nBufferMSecVoice", "I");
+    fid_usr.cltname = getFieldID(env, JCLS_USER, "szClientName", "Ljava/lang/String;");
+
+    fid_audiocfg.agc = getFieldID(env, JCLS_AUDIOCONFIG, "bEnableAGC", "Z");
+    fid_audiocfg.gainlevel = getFieldID(env, JCLS_AUDIOCONFIG, "nGainLevel", "I");
+
+    fid_srvprop.name = getFieldID(env, JCLS_SERVERPROPERTIES, "szServerName", "Ljava/lang/String;");
+    fid_srvprop.motd = getFieldID(env, JCLS_SERVERPROPERTIES, "szMOTD", "Ljava/lang/String;");
+    fid_srvprop.motdraw = getFieldID(env, JCLS_SERVERPROPERTIES, "szMOTDRaw", "Ljava/lang/String;");
+    fid_srvprop.maxusers = getFieldID(env, JCLS_SERVERPROPERTIES, "nMaxUsers", "I");
+    fid_srvprop.maxattempts = getFieldID(env, JCLS_SERVERPROPERTIES, "nMaxLoginAttempts", "I");
+    fid_srvprop.iplogins = getFieldID(env, JCLS_SERVERPROPERTIES, "nMaxLoginsPerIPAddress", "I");
+    fid_srvprop.voicetx = getFieldID(env, JCLS_SERVERPROPERTIES, "nMaxVoiceTxPerSecond", "I");
+    fid_srvprop.vidcaptx = getFieldID(env, JCLS_SERVERPROPERTIES, "nMaxVideoCaptureTxPerSecond", "I");
+    fid_srvprop.mftx = getFieldID(env, JCLS_SERVERPROPERTIES, "nMaxMediaFileTxPerSecond", "I");
+    fid_srvprop.desktx = getFieldID(env, JCLS_SERVERPROPERTIES, "nMaxDesktopTxPerSecond", "I");
+    fid_srvprop.totaltx = getFieldID(env, JCLS_SERVERPROPERTIES, "nMaxTotalTxPerSecond", "I");
+    fid_srvprop.save = getFieldID(env, JCLS_SERVERPROPERTIES, "bAutoSave", "Z");
+    fid_srvprop.tcp = getFieldID(env, JCLS_SERVERPROPERTIES, "nTcpPort", "I");
+    fid_srvprop.udp = getFieldID(env, JCLS_SERVERPROPERTIES, "nUdpPort", "I");
+    fid_srvprop.tmout = getFieldID(env, JCLS_SERVERPROPERTIES, "nUserTimeout", "I");
+    fid_srvprop.srvver = getFieldID(env, JCLS_SERVERPROPERTIES, "szServerVersion", "Ljava/lang/String;");
+    fid_srvprop.srvprot = getFieldID(env, JCLS_SERVERPROPERTIES, "szServerProtocolVersion", "Ljava/lang/String;");
+
+    fid_cltstats.udpsent = getFieldID(env, JCLS_CLIENTSTATISTICS, "nUdpBytesSent", "J");
+    fid_cltstats.udprecv = getFieldID(env, JCLS_CLIENTSTATISTICS, "nUdpBytesRecv", "J");
+    fid_cltstats.voicesent = getFieldID(env, JCLS_CLIENTSTATISTICS, "nVoiceBytesSent", "J");
+    fid_cltstats.voicerecv = getFieldID(env, JCLS_CLIENTSTATISTICS, "nVoiceBytesRecv", "J");
+    fid_cltstats.videosent = getFieldID(env, JCLS_CLIENTSTATISTICS, "nVideoCaptureBytesSent", "J");
+    fid_cltstats.videorecv = getFieldID(env, JCLS_CLIENTSTATISTICS, "nVideoCaptureBytesRecv", "J");
+    fid_cltstats.mfaudsent = getFieldID(env, JCLS_CLIENTSTATISTICS, "nMediaFileAudioBytesSent", "J");
+    fid_cltstats.mfaudrecv = getFieldID(env, JCLS_CLIENTSTATISTICS, "nMediaFileAudioBytesRecv", "J");
+    fid_cltstats.mfvidsent = getFieldID(env, JCLS_CLIENTSTATISTICS, "nMediaFileVideoBytesSent", "J");
+    fid_cltstats.mfvidrecv = getFieldID(env, JCLS_CLIENTSTATISTICS, "nMediaFileVideoBytesRecv", "J");
+    fid_cltstats.desksent = getFieldID(env, JCLS_CLIENTSTATISTICS, "nDesktopBytesSent", "J");
+    fid_cltstats.deskrecv = getFieldID(env, JCLS_CLIENTSTATISTICS, "nDesktopBytesRecv", "J");
+    fid_cltstats.udpping = getFieldID(env, JCLS_CLIENTSTATISTICS, "nUdpPingTimeMs", "I");
+    fid_cltstats.tcpping = getFieldID(env, JCLS_CLIENTSTATISTICS, "nTcpPingTimeMs", "I");
+    fid_cltstats.tcpsilen = getFieldID(env, JCLS_CLIENTSTATISTICS, "nTcpServerSilenceSec", "I");
+    fid_cltstats.udpsilen = getFieldID(env, JCLS_CLIENTSTATISTICS, "nUdpServerSilenceSec", "I");
+    fid_cltstats.vcoverrun = getFieldID(env, JCLS_CLIENTSTATISTICS, "nVoiceCaptureOverruns", "I");
+    fid_cltstats.vcsuppress = getFieldID(env, JCLS_CLIENTSTATISTICS, "nVoiceFramesSuppressed", "I");
+    fid_cltstats.evcoalesced = getFieldID(env, JCLS_CLIENTSTATISTICS, "nEventsCoalesced", "I");
+    fid_cltstats.evdropped = getFieldID(env, JCLS_CLIENTSTATISTICS, "nEventsDropped", "I");
+    fid_cltstats.maxpayload = getFieldID(env, JCLS_CLIENTSTATISTICS, "nMaxPayloadSize", "I");
+
+    fid_txtmsg.type = getFieldID(env, JCLS_TEXTMESSAGE, "nMsgType", "I");
+    fid_txtmsg.fromid = getFieldID(env, JCLS_TEXTMESSAGE, "nFromUserID", "I");
+    fid_txtmsg.username = getFieldID(env, JCLS_TEXTMESSAGE, "szFromUsername", "Ljava/lang/String;");
+    fid_txtmsg.toid = getFieldID(env, JCLS_TEXTMESSAGE, "nToUserID", "I");
+    fid_txtmsg.chanid = getFieldID(env, JCLS_TEXTMESSAGE, "nChannelID", "I");
+    fid_txtmsg.msg = getFieldID(env, JCLS_TEXTMESSAGE, "szMessage", "Ljava/lang/String;");
+
+    fid_account.user = getFieldID(env, JCLS_USERACCOUNT, "szUsername", "Ljava/lang/String;");
+    fid_account.passwd = getFieldID(env, JCLS_USERACCOUNT, "szPassword", "Ljava/lang/String;");
+    fid_account.type = getFieldID(env, JCLS_USERACCOUNT, "uUserType", "I");
+    fid_account.data = getFieldID(env, JCLS_USERACCOUNT, "nUserData", "I");
+    fid_account.ur = getFieldID(env, JCLS_USERACCOUNT, "uUserRights", "I");
+    fid_account.note = getFieldID(env, JCLS_USERACCOUNT, "szNote", "Ljava/lang/String;");
+    fid_account.initchan = getFieldID(env, JCLS_USERACCOUNT, "szInitChannel", "Ljava/lang/String;");
+    fid_account.op = getFieldID(env, JCLS_USERACCOUNT, "autoOperatorChannels", "[I");
+    fid_account.audbps = getFieldID(env, JCLS_USERACCOUNT, "nAudioCodecBpsLimit", "I");
+    fid_account.abuse = getFieldID(env, JCLS_USERACCOUNT, "abusePrevent", "Ldk/bearware/AbusePrevention;");
+
+    fid_srvstats.totaltx = getFieldID(env, JCLS_SERVERSTATISTICS, "nTotalBytesTX", "J");
+    fid_srvstats.totalrx = getFieldID(env, JCLS_SERVERSTATISTICS, "nTotalBytesRX", "J");
+    fid_srvstats.voicetx = getFieldID(env, JCLS_SERVERSTATISTICS, "nVoiceBytesTX", "J");
+    fid_srvstats.voicerx = getFieldID(env, JCLS_SERVERSTATISTICS, "nVoiceBytesRX", "J");
+    fid_srvstats.videotx = getFieldID(env, JCLS_SERVERSTATISTICS, "nVideoCaptureBytesTX", "J");
+    fid_srvstats.videorx = getFieldID(env, JCLS_SERVERSTATISTICS, "nVideoCaptureBytesRX", "J");
+    fid_srvstats.mftx = getFieldID(env, JCLS_SERVERSTATISTICS, "nMediaFileBytesTX", "J");
+    fid_srvstats.mfrx = getFieldID(env, JCLS_SERVERSTATISTICS, "nMediaFileBytesRX", "J");
+    fid_srvstats.desktx = getFieldID(env, JCLS_SERVERSTATISTICS, "nDesktopBytesTX", "J");
+    fid_srvstats.deskrx = getFieldID(env, JCLS_SERVERSTATISTICS, "nDesktopBytesRX", "J");
+    fid_srvstats.uptm = getFieldID(env, JCLS_SERVERSTATISTICS, "nUptimeMSec", "J");
+    fid_srvstats.vsuppress = getFieldID(env, JCLS_SERVERSTATISTICS, "nVoiceFramesSuppressed", "J");
+
+    fid_rfile.id = getFieldID(env, JCLS_REMOTEFILE, "nFileID", "I");
+    fid_rfile.cid = getFieldID(env, JCLS_REMOTEFILE, "nChannelID", "I");
+    fid_rfile.name = getFieldID(env, JCLS_REMOTEFILE, "szFileName", "Ljava/lang/String;");
+    fid_rfile.size = getFieldID(env, JCLS_REMOTEFILE, "nFileSize", "J");
+    fid_rfile.user = getFieldID(env, JCLS_REMOTEFILE, "szUsername", "Ljava/lang/String;");
+
+    fid_usrstats.voirx = getFieldID(env, JCLS_USERSTATISTICS, "nVoicePacketsRecv", "J");
+    fid_usrstats.voilost = getFieldID(env, JCLS_USERSTATISTICS, "nVoicePacketsLost", "J");
+    fid_usrstats.vidrx = getFieldID(env, JCLS_USERSTATISTICS, "nVideoCapturePacketsRecv", "J");
+    fid_usrstats.vidftx = getFieldID(env, JCLS_USERSTATISTICS, "nVideoCaptureFramesRecv", "J");
+    fid_usrstats.vidflost = getFieldID(env, JCLS_USERSTATISTICS, "nVideoCaptureFramesLost", "J");
+    fid_usrstats.vidfdropped = getFieldID(env, JCLS_USERSTATISTICS, "nVideoCaptureFramesDropped", "J");
+    fid_usrstats.mfaudrx = getFieldID(env, JCLS_USERSTATISTICS, "nMediaFileAudioPacketsRecv", "J");
+    fid_usrstats.mfaudlost = getFieldID(env, JCLS_USERSTATISTICS, "nMediaFileAudioPacketsLost", "J");
+    fid_usrstats.mfvidrx = getFieldID(env, JCLS_USERSTATISTICS, "nMediaFileVideoPacketsRecv", "J");
+    fid_usrstats.mfvidftx = getFieldID(env, JCLS_USERSTATISTICS, "nMediaFileVideoFramesRecv", "J");
+    fid_usrstats.mfvidflost = getFieldID(env, JCLS_USERSTATISTICS, "nMediaFileVideoFramesLost", "J");
+    fid_usrstats.mfvidfdropped = getFieldID(env, JCLS_USERSTATISTICS, "nMediaFileVideoFramesDropped", "J");
+    fid_usrstats.voilate = getFieldID(env, JCLS_USERSTATISTICS, "nVoicePacketsLate", "J");
+    fid_usrstats.voiconceal = getFieldID(env, JCLS_USERSTATISTICS, "nVoiceFramesConcealed", "J");
+    fid_usrstats.mfaudlate = getFieldID(env, JCLS_USERSTATISTICS, "nMediaFileAudioPacketsLate", "J");
+    fid_usrstats.mfaudconceal = getFieldID(env, JCLS_USERSTATISTICS, "nMediaFileAudioFramesConcealed", "J");
+    fid_usrstats.voijitter = getFieldID(env, JCLS_USERSTATISTICS, "nVoiceJitterMSec", "I");
+    fid_usrstats.mfaudjitter = getFieldID(env, JCLS_USERSTATISTICS, "nMediaFileAudioJitterMSec", "I");
+    fid_usrstats.vidfskipped = getFieldID(env, JCLS_USERSTATISTICS, "nVideoCaptureFramesSkipped", "J");
+    fid_usrstats.mfvidfskipped = getFieldID(env, JCLS_USERSTATISTICS, "nMediaFileVideoFramesSkipped", "J");
+
+    fid_filetx.status = getFieldID(env, JCLS_FILETRANSFER, "nStatus", "I");
+    fid_filetx.txid = getFieldID(env, JCLS_FILETRANSFER, "nTransferID", "I");
+    fid_filetx.chanid = getFieldID(env, JCLS_FILETRANSFER, "nChannelID", "I");
+    fid_filetx.filepath = getFieldID(env, JCLS_FILETRANSFER, "szLocalFilePath", "Ljava/lang/String;");
+    fid_filetx.rempath = getFieldID(env, JCLS_FILETRANSFER, "szRemoteFileName", "Ljava/lang/String;");
+    fid_filetx.size = getFieldID(env, JCLS_FILETRANSFER, "nFileSize", "J");
+    fid_filetx.txed = getFieldID(env, JCLS_FILETRANSFER, "nTransferred", "J");
+    fid_filetx.inbound = getFieldID(env, JCLS_FILETRANSFER, "bInbound", "Z");
+
+    fid_ban.ipaddr = getFieldID(env, JCLS_BANNEDUSER, "szIPAddress", "Ljava/lang/String;");
+    fid_ban.chan = getFieldID(env, JCLS_BANNEDUSER, "szChannelPath", "Ljava/lang/String;");
+    fid_ban.time = getFieldID(env, JCLS_BANNEDUSER, "szBanTime", "Ljava/lang/String;");
+    fid_ban.nick = getFieldID(env, JCLS_BANNEDUSER, "szNickname", "Ljava/lang/String;");
+    fid_ban.username = getFieldID(env, JCLS_BANNEDUSER, "szUsername", "Ljava/lang/String;");
+    fid_ban.bantype = getFieldID(env, JCLS_BANNEDUSER, "uBanTypes", "I");
+
+    fid_cemsg.err = getFieldID(env, JCLS_CLIENTERRORMSG, "nErrorNo", "I");
+    fid_cemsg.msg = getFieldID(env, JCLS_CLIENTERRORMSG, "szErrorMsg", "Ljava/lang/String;");
+
+    fid_deskinput.x = getFieldID(env, JCLS_DESKTOPINPUT, "uMousePosX", "I");
+    fid_deskinput.y = getFieldID(env, JCLS_DESKTOPINPUT, "uMousePosY", "I");
+    fid_deskinput.keycode = getFieldID(env, JCLS_DESKTOPINPUT, "uKeyCode", "I");
+    fid_deskinput.keystate = getFieldID(env, JCLS_DESKTOPINPUT, "uKeyState", "I");
+
+    fid_mfi.status = getFieldID(env, JCLS_MEDIAFILEINFO, "nStatus", "I");
+    fid_mfi.fname = getFieldID(env, JCLS_MEDIAFILEINFO, "szFileName", "Ljava/lang/String;");
+    fid_mfi.audfmt = getFieldID(env, JCLS_MEDIAFILEINFO, "audioFmt", "Ldk/bearware/AudioFormat;");
+    fid_mfi.vidfmt = getFieldID(env, JCLS_MEDIAFILEINFO, "videoFmt", "Ldk/bearware/VideoFormat;");
+    fid_mfi.dur = getFieldID(env, JCLS_MEDIAFILEINFO, "uDurationMSec", "I");
+
+    fid_audiofmt.audfmt = getFieldID(env, JCLS_AUDIOFORMAT, "nAudioFmt", "I");
+    fid_audiofmt.sr = getFieldID(env, JCLS_AUDIOFORMAT, "nSampleRate", "I");
+    fid_audiofmt.ch = getFieldID(env, JCLS_AUDIOFORMAT, "nChannels", "I");
+
+    fid_videofmt.w = getFieldID(env, JCLS_VIDEOFORMAT, "nWidth", "I");
+    fid_videofmt.h = getFieldID(env, JCLS_VIDEOFORMAT, "nHeight", "I");
+    fid_videofmt.fpsN = getFieldID(env, JCLS_VIDEOFORMAT, "nFPS_Numerator", "I");
+    fid_videofmt.fpsD = getFieldID(env, JCLS_VIDEOFORMAT, "nFPS_Denominator", "I");
+    fid_videofmt.fcc = getFieldID(env, JCLS_VIDEOFORMAT, "picFourCC", "I");
+
+    fid_abuseprev.cmds = getFieldID(env, JCLS_ABUSEPREVENTION, "nCommandsLimit", "I");
+    fid_abuseprev.msec = getFieldID(env, JCLS_ABUSEPREVENTION, "nCommandsIntervalMSec", "I");
+
+    return JNI_VERSION_1_6;
+}
+
 jobject newSoundDevice(JNIEnv* env, const SoundDevice& dev)
 {
     jclass cls_snddev = env->FindClass("dk/bearware/SoundDevice");
@@ -127,11 +602,9 @@ jobject newVideoDevice(JNIEnv* env, VideoCaptureDevice& dev)
 }
 
 jobject newChannel(JNIEnv* env, const Channel* lpChannel) {
-    jclass cls = env->FindClass("dk/bearware/Channel");
-    assert(cls);
     jobject channel_obj = NULL;
     if(lpChannel) {
-        channel_obj = newObject(env, cls);
+        channel_obj = newObject(env, JCLS_CHANNEL);
         assert(channel_obj);
         setChannel(env, const_cast<Channel&>(*lpChannel), channel_obj, N2J);
     }
@@ -139,11 +612,9 @@ jobject newChannel(JNIEnv* env, const Channel* lpChannel) {
 }
 
 jobject newUser(JNIEnv* env, const User* lpUser) {
-    jclass cls = env->FindClass("dk/bearware/User");
-    assert(cls);
     jobject user_obj = NULL;
     if(lpUser) {
-        user_obj = newObject(env, cls);
+        user_obj = newObject(env, JCLS_USER);
         assert(user_obj);
         setUser(env, const_cast<User&>(*lpUser), user_obj);
     }
@@ -152,11 +623,10 @@ jobject newUser(JNIEnv* env, const User* lpUser) {
 
 jobject newClientErrorMsg(JNIEnv* env, const ClientErrorMsg* lpClientErrorMsg) {
 
-    jclass cls = env->FindClass("dk/bearware/ClientErrorMsg");
     jobject errmsg_obj = NULL;
 
     if(lpClientErrorMsg) {
-        errmsg_obj = newObject(env, cls);
+        errmsg_obj = newObject(env, JCLS_CLIENTERRORMSG);
         assert(errmsg_obj);
         setClientErrorMsg(env, const_cast<ClientErrorMsg&>(*lpClientErrorMsg), errmsg_obj, N2J);
     }
@@ -164,11 +634,10 @@ jobject newClientErrorMsg(JNIEnv* env, const ClientErrorMsg* lpClientErrorMsg) {
 }
 
 jobject newUserAccount(JNIEnv* env, const UserAccount* lpUserAccount) {
-    jclass cls = env->FindClass("dk/bearware/UserAccount");
     jobject ua_obj = NULL;
 
     if(lpUserAccount) {
-        ua_obj = newObject(env, cls);
+        ua_obj = newObject(env, JCLS_USERACCOUNT);
         assert(ua_obj);
         setUserAccount(env, const_cast<UserAccount&>(*lpUserAccount), ua_obj, N2J);
     }
@@ -176,11 +645,10 @@ jobject newUserAccount(JNIEnv* env, const UserAccount* lpUserAccount) {
 }
 
 jobject newTextMessage(JNIEnv* env, const TextMessage* lpTextMessage) {
-    jclass cls = env->FindClass("dk/bearware/TextMessage");
     jobject tm_obj = NULL;
 
     if(lpTextMessage) {
-        tm_obj = newObject(env, cls);
+        tm_obj = newObject(env, JCLS_TEXTMESSAGE);
         assert(tm_obj);
         setTextMessage(env, const_cast<TextMessage&>(*lpTextMessage), tm_obj, N2J);
     }
@@ -188,11 +656,10 @@ jobject newTextMessage(JNIEnv* env, const TextMessage* lpTextMessage) {
 }
 
 jobject newRemoteFile(JNIEnv* env, const RemoteFile* lpRemoteFile) {
-    jclass cls = env->FindClass("dk/bearware/RemoteFile");
     jobject rf_obj = NULL;
 
     if(lpRemoteFile) {
-        rf_obj = newObject(env, cls);
+        rf_obj = newObject(env, JCLS_REMOTEFILE);
         assert(rf_obj);
         setRemoteFile(env, const_cast<RemoteFile&>(*lpRemoteFile), rf_obj, N2J);
     }
@@ -201,11 +668,10 @@ jobject newRemoteFile(JNIEnv* env, const RemoteFile* lpRemoteFile) {
 }
 
 jobject newServerProperties(JNIEnv* env, const ServerProperties* lpServerProperties) {
-    jclass cls = env->FindClass("dk/bearware/ServerProperties");
     jobject sp_obj = NULL;
 
     if(lpServerProperties) {
-        sp_obj = newObject(env, cls);
+        sp_obj = newObject(env, JCLS_SERVERPROPERTIES);
         assert(sp_obj);
         setServerProperties(env, const_cast<ServerProperties&>(*lpServerProperties), sp_obj, N2J);
     }
@@ -213,10 +679,9 @@ jobject newServerProperties(JNIEnv* env, const ServerProperties* lpServerPropert
 }
 
 jobject newAbusePrevention(JNIEnv* env, const AbusePrevention* lpAbusePrevent) {
-    jclass cls = env->FindClass("dk/bearware/AbusePrevention");
     jobject ap_obj = NULL;
     if(lpAbusePrevent) {
-        ap_obj = newObject(env, cls);
+        ap_obj = newObject(env, JCLS_ABUSEPREVENTION);
         assert(ap_obj);
         setAbusePrevention(env, const_cast<AbusePrevention&>(*lpAbusePrevent), ap_obj, N2J);
     }
@@ -225,332 +690,191 @@ jobject newAbusePrevention(JNIEnv* env, const AbusePrevention* lpAbusePrevent) {
 
 void setChannel(JNIEnv* env, Channel& chan, jobject lpChannel, JConvert conv)
 {
-    jclass cls_chan = env->GetObjectClass(lpChannel);
-    jfieldID fid_parentid = env->GetFieldID(cls_chan, "nParentID", "I");
-    jfieldID fid_chanid = env->GetFieldID(cls_chan, "nChannelID", "I");
-    jfieldID fid_name = env->GetFieldID(cls_chan, "szName", "Ljava/lang/String;");
-    jfieldID fid_topic = env->GetFieldID(cls_chan, "szTopic", "Ljava/lang/String;");
-    jfieldID fid_passwd = env->GetFieldID(cls_chan, "szPassword", "Ljava/lang/String;");
-    jfieldID fid_prot = env->GetFieldID(cls_chan, "bPassword", "Z");
-    jfieldID fid_chantype = env->GetFieldID(cls_chan, "uChannelType", "I");
-    jfieldID fid_userdata = env->GetFieldID(cls_chan, "nUserData", "I");
-    jfieldID fid_quota = env->GetFieldID(cls_chan, "nDiskQuota", "J");
-    jfieldID fid_oppasswd = env->GetFieldID(cls_chan, "szOpPassword", "Ljava/lang/String;");
-    jfieldID fid_maxusers = env->GetFieldID(cls_chan, "nMaxUsers", "I");
-    jfieldID fid_codec = env->GetFieldID(cls_chan, "audiocodec", "Ldk/bearware/AudioCodec;");
-    jfieldID fid_audcfg = env->GetFieldID(cls_chan, "audiocfg", "Ldk/bearware/AudioConfig;");
-    // jfieldID fid_txusers = env->GetFieldID(cls_chan, "transmitUsers", "[[I");
-    jfieldID fid_queueusers = env->GetFieldID(cls_chan, "transmitUsersQueue", "[I");
-
-    assert(fid_parentid);
-    assert(fid_chanid);
-    assert(fid_name);
-    assert(fid_topic);
-    assert(fid_passwd);
-    assert(fid_prot);
-    assert(fid_codec);
-    assert(fid_audcfg);
-    assert(fid_chantype);
-    assert(fid_userdata);
-    assert(fid_quota);
-    assert(fid_oppasswd);
-    assert(fid_maxusers);
-    // assert(fid_txusers);
-    assert(fid_queueusers);
-
     if(conv == N2J)
     {
-        env->SetIntField(lpChannel, fid_parentid, chan.nParentID);
-        env->SetIntField(lpChannel, fid_chanid, chan.nChannelID);
-        env->SetObjectField(lpChannel, fid_name, NEW_JSTRING(env, chan.szName));
-        env->SetObjectField(lpChannel, fid_topic, NEW_JSTRING(env, chan.szTopic));
-        env->SetObjectField(lpChannel, fid_passwd, NEW_JSTRING(env, chan.szPassword));
-        env->SetBooleanField(lpChannel, fid_prot, chan.bPassword);
-        env->SetIntField(lpChannel, fid_chantype, chan.uChannelType);
-        env->SetIntField(lpChannel, fid_userdata, chan.nUserData);
-        env->SetLongField(lpChannel, fid_quota, chan.nDiskQuota);
-        env->SetObjectField(lpChannel, fid_oppasswd, NEW_JSTRING(env, chan.szOpPassword));
-        env->SetIntField(lpChannel, fid_maxusers, chan.nMaxUsers);
-
-        jclass cls_codec = env->FindClass("dk/bearware/AudioCodec");
-        jobject newObj = newObject(env, cls_codec);
-        env->SetObjectField(lpChannel, fid_codec, newObj);
-
-        jclass cls_audcfg = env->FindClass("dk/bearware/AudioConfig");
-        newObj = newObject(env, cls_audcfg);
-        env->SetObjectField(lpChannel, fid_audcfg, newObj);
+        env->SetIntField(lpChannel, fid_channel.parentid, chan.nParentID);
+        env->SetIntField(lpChannel, fid_channel.chanid, chan.nChannelID);
+        env->SetObjectField(lpChannel, fid_channel.name, NEW_JSTRING(env, chan.szName));
+        env->SetObjectField(lpChannel, fid_channel.topic, NEW_JSTRING(env, chan.szTopic));
+        env->SetObjectField(lpChannel, fid_channel.passwd, NEW_JSTRING(env, chan.szPassword));
+        env->SetBooleanField(lpChannel, fid_channel.prot, chan.bPassword);
+        env->SetIntField(lpChannel, fid_channel.chantype, chan.uChannelType);
+        env->SetIntField(lpChannel, fid_channel.userdata, chan.nUserData);
+        env->SetLongField(lpChannel, fid_channel.quota, chan.nDiskQuota);
+        env->SetObjectField(lpChannel, fid_channel.oppasswd, NEW_JSTRING(env, chan.szOpPassword));
+        env->SetIntField(lpChannel, fid_channel.maxusers, chan.nMaxUsers);
+
+        jobject newObj = newObject(env, JCLS_AUDIOCODEC);
+        env->SetObjectField(lpChannel, fid_channel.codec, newObj);
+
+        newObj = newObject(env, JCLS_AUDIOCONFIG);
+        env->SetObjectField(lpChannel, fid_channel.audcfg, newObj);
 
         jintArray intArr = env->NewIntArray(TT_TRANSMITQUEUE_MAX);
         jint tmp[TT_TRANSMITQUEUE_MAX] = {0};
         env->SetIntArrayRegion(intArr, 0, TT_TRANSMITQUEUE_MAX, TO_JINT_ARRAY(chan.transmitUsersQueue, tmp, TT_TRANSMITQUEUE_MAX));
-        env->SetObjectField(lpChannel, fid_queueusers, intArr);
+        env->SetObjectField(lpChannel, fid_channel.queueusers, intArr);
     }
     else
     {
-        chan.nParentID = env->GetIntField(lpChannel, fid_parentid);
-        chan.nChannelID = env->GetIntField(lpChannel, fid_chanid);
-        TT_STRCPY(chan.szName, ttstr(env, (jstring)env->GetObjectField(lpChannel, fid_name)));
-        TT_STRCPY(chan.szTopic, ttstr(env, (jstring)env->GetObjectField(lpChannel, fid_topic)));
-        TT_STRCPY(chan.szPassword, ttstr(env, (jstring)env->GetObjectField(lpChannel, fid_passwd)));
-        chan.uChannelType = env->GetIntField(lpChannel, fid_chantype);
-        chan.nUserData = env->GetIntField(lpChannel, fid_userdata);
-        chan.nDiskQuota = env->GetLongField(lpChannel, fid_quota);
-        TT_STRCPY(chan.szOpPassword, ttstr(env, (jstring)env->GetObjectField(lpChannel, fid_oppasswd)));
-        chan.nMaxUsers = env->GetIntField(lpChannel, fid_maxusers);
-        jintArray intArr = (jintArray)env->GetObjectField(lpChannel, fid_queueusers);
+        chan.nParentID = env->GetIntField(lpChannel, fid_channel.parentid);
+        chan.nChannelID = env->GetIntField(lpChannel, fid_channel.chanid);
+        TT_STRCPY(chan.szName, ttstr(env, (jstring)env->GetObjectField(lpChannel, fid_channel.name)));
+        TT_STRCPY(chan.szTopic, ttstr(env, (jstring)env->GetObjectField(lpChannel, fid_channel.topic)));
+        TT_STRCPY(chan.szPassword, ttstr(env, (jstring)env->GetObjectField(lpChannel, fid_channel.passwd)));
+        chan.uChannelType = env->GetIntField(lpChannel, fid_channel.chantype);
+        chan.nUserData = env->GetIntField(lpChannel, fid_channel.userdata);
+        chan.nDiskQuota = env->GetLongField(lpChannel, fid_channel.quota);
+        TT_STRCPY(chan.szOpPassword, ttstr(env, (jstring)env->GetObjectField(lpChannel, fid_channel.oppasswd)));
+        chan.nMaxUsers = env->GetIntField(lpChannel, fid_channel.maxusers);
+        jintArray intArr = (jintArray)env->GetObjectField(lpChannel, fid_channel.queueusers);
         jint tmp[TT_TRANSMITQUEUE_MAX] = {0};
         env->GetIntArrayRegion(intArr, 0, TT_TRANSMITQUEUE_MAX, tmp);
         TO_INT32_ARRAY(tmp, chan.transmitUsersQueue, TT_TRANSMITQUEUE_MAX);
     }
 
-    setAudioCodec(env, chan.audiocodec, env->GetObjectField(lpChannel, fid_codec), conv);
-    setAudioConfig(env, chan.audiocfg, env->GetObjectField(lpChannel, fid_audcfg), conv);
+    setAudioCodec(env, chan.audiocodec, env->GetObjectField(lpChannel, fid_channel.codec), conv);
+    setAudioConfig(env, chan.audiocfg, env->GetObjectField(lpChannel, fid_channel.audcfg), conv);
 }
 
 void setUser(JNIEnv* env, const User& user, jobject lpUser)
 {
-    jclass cls_user = env->GetObjectClass(lpUser);
-    jfieldID fid_userid = env->GetFieldID(cls_user, "nUserID", "I");
-    jfieldID fid_username = env->GetFieldID(cls_user, "szUsername", "Ljava/lang/String;");
-    jfieldID fid_userdata = env->GetFieldID(cls_user, "nUserData", "I");
-    jfieldID fid_usertype = env->GetFieldID(cls_user, "uUserType", "I");
-    jfieldID fid_ipaddr = env->GetFieldID(cls_user, "szIPAddress", "Ljava/lang/String;");
-    jfieldID fid_version = env->GetFieldID(cls_user, "uVersion", "I");
-    jfieldID fid_chanid = env->GetFieldID(cls_user, "nChannelID", "I");
-    jfieldID fid_lsub = env->GetFieldID(cls_user, "uLocalSubscriptions", "I");
-    jfieldID fid_psub = env->GetFieldID(cls_user, "uPeerSubscriptions", "I");
-    jfieldID fid_nickname = env->GetFieldID(cls_user, "szNickname", "Ljava/lang/String;");
-    jfieldID fid_stmode = env->GetFieldID(cls_user, "nStatusMode", "I");
-    jfieldID fid_stmsg = env->GetFieldID(cls_user, "szStatusMsg", "Ljava/lang/String;");
-    jfieldID fid_state = env->GetFieldID(cls_user, "uUserState", "I");
-    jfieldID fid_folder = env->GetFieldID(cls_user, "szMediaStorageDir", "Ljava/lang/String;");
-    jfieldID fid_volvoice = env->GetFieldID(cls_user, "nVolumeVoice", "I");
-    jfieldID fid_volmf = env->GetFieldID(cls_user, "nVolumeMediaFile", "I");
-    jfieldID fid_stopvoice = env->GetFieldID(cls_user, "nStoppedDelayVoice", "I");
-    jfieldID fid_stopmf = env->GetFieldID(cls_user, "nStoppedDelayMediaFile", "I");
-    jfieldID fid_pbvoice = env->GetFieldID(cls_user, "stereoPlaybackVoice", "[Z");
-    jfieldID fid_pbmf = env->GetFieldID(cls_user, "stereoPlaybackMediaFile", "[Z");
-    jfieldID fid_mfbuf = env->GetFieldID(cls_user, "nBufferMSecMediaFile", "I");
-    jfieldID fid_vbuf = env->GetFieldID(cls_user, "nBufferMSecVoice", "I");
-    jfieldID fid_cltname = env->GetFieldID(cls_user, "szClientName", "Ljava/lang/String;");
-
-    assert(fid_userid);
-    assert(fid_username);
-    assert(fid_userdata);
-    assert(fid_usertype);
-    assert(fid_ipaddr);
-    assert(fid_version);
-    assert(fid_chanid);
-    assert(fid_lsub);
-    assert(fid_psub);
-    assert(fid_nickname);
-    assert(fid_stmode);
-    assert(fid_stmsg);
-    assert(fid_state);
-    assert(fid_folder);
-    assert(fid_volvoice);
-    assert(fid_volmf);
-    assert(fid_stopvoice);
-    assert(fid_stopmf);
-    assert(fid_pbvoice);
-    assert(fid_pbmf);
-    assert(fid_mfbuf);
-    assert(fid_vbuf);
-    assert(fid_cltname);
-    
-    env->SetIntField(lpUser, fid_userid, user.nUserID);
-    env->SetObjectField(lpUser, fid_username, NEW_JSTRING(env, user.szUsername));
-    env->SetIntField(lpUser, fid_userdata, user.nUserData);
-    env->SetIntField(lpUser, fid_usertype, user.uUserType);
-    env->SetObjectField(lpUser, fid_ipaddr, NEW_JSTRING(env, user.szIPAddress));
-    env->SetIntField(lpUser, fid_version, user.uVersion);
-    env->SetIntField(lpUser, fid_chanid, user.nChannelID);
-    env->SetIntField(lpUser, fid_lsub, user.uLocalSubscriptions);
-    env->SetIntField(lpUser, fid_psub, user.uPeerSubscriptions);
-    env->SetObjectField(lpUser, fid_nickname, NEW_JSTRING(env, user.szNickname));
-    env->SetIntField(lpUser, fid_stmode, user.nStatusMode);
-    env->SetObjectField(lpUser, fid_stmsg, NEW_JSTRING(env, user.szStatusMsg));
-    env->SetIntField(lpUser, fid_state, user.uUserState);
-    env->SetObjectField(lpUser, fid_folder, NEW_JSTRING(env, user.szMediaStorageDir));
-    env->SetIntField(lpUser, fid_volvoice, user.nVolumeVoice);
-    env->SetIntField(lpUser, fid_volmf, user.nVolumeMediaFile);
-    env->SetIntField(lpUser, fid_stopvoice, user.nStoppedDelayVoice);
-    env->SetIntField(lpUser, fid_stopmf, user.nStoppedDelayMediaFile);
+    env->SetIntField(lpUser, fid_usr.userid, user.nUserID);
+    env->SetObjectField(lpUser, fid_usr.username, NEW_JSTRING(env, user.szUsername));
+    env->SetIntField(lpUser, fid_usr.userdata, user.nUserData);
+    env->SetIntField(lpUser, fid_usr.usertype, user.uUserType);
+    env->SetObjectField(lpUser, fid_usr.ipaddr, NEW_JSTRING(env, user.szIPAddress));
+    env->SetIntField(lpUser, fid_usr.version, user.uVersion);
+    env->SetIntField(lpUser, fid_usr.chanid, user.nChannelID);
+    env->SetIntField(lpUser, fid_usr.lsub, user.uLocalSubscriptions);
+    env->SetIntField(lpUser, fid_usr.psub, user.uPeerSubscriptions);
+    env->SetObjectField(lpUser, fid_usr.nickname, NEW_JSTRING(env, user.szNickname));
+    env->SetIntField(lpUser, fid_usr.stmode, user.nStatusMode);
+    env->SetObjectField(lpUser, fid_usr.stmsg, NEW_JSTRING(env, user.szStatusMsg));
+    env->SetIntField(lpUser, fid_usr.state, user.uUserState);
+    env->SetObjectField(lpUser, fid_usr.folder, NEW_JSTRING(env, user.szMediaStorageDir));
+    env->SetIntField(lpUser, fid_usr.volvoice, user.nVolumeVoice);
+    env->SetIntField(lpUser, fid_usr.volmf, user.nVolumeMediaFile);
+    env->SetIntField(lpUser, fid_usr.stopvoice, user.nStoppedDelayVoice);
+    env->SetIntField(lpUser, fid_usr.stopmf, user.nStoppedDelayMediaFile);
     jbooleanArray boolArray = env->NewBooleanArray(2);
     jboolean tmp[2];
     tmp[0] = user.stereoPlaybackVoice[0] != 0;
     tmp[1] = user.stereoPlaybackVoice[1] != 0;
     env->SetBooleanArrayRegion(boolArray, 0, 2, tmp);
-    env->SetObjectField(lpUser, fid_pbvoice, boolArray);
+    env->SetObjectField(lpUser, fid_usr.pbvoice, boolArray);
     boolArray = env->NewBooleanArray(2);
     tmp[0] = user.stereoPlaybackMediaFile[0] != 0;
     tmp[1] = user.stereoPlaybackMediaFile[1] != 0;
     env->SetBooleanArrayRegion(boolArray, 0, 2, tmp);
-    env->SetObjectField(lpUser, fid_pbmf, boolArray);
-    env->SetIntField(lpUser, fid_mfbuf, user.nBufferMSecMediaFile);
-    env->SetIntField(lpUser, fid_vbuf, user.nBufferMSecVoice);
-    env->SetObjectField(lpUser, fid_cltname, NEW_JSTRING(env, user.szClientName));
+    env->SetObjectField(lpUser, fid_usr.pbmf, boolArray);
+    env->SetIntField(lpUser, fid_usr.mfbuf, user.nBufferMSecMediaFile);
+    env->SetIntField(lpUser, fid_usr.vbuf, user.nBufferMSecVoice);
+    env->SetObjectField(lpUser, fid_usr.cltname, NEW_JSTRING(env, user.szClientName));
 }
 
 void setTTMessage(JNIEnv* env, TTMessage& msg, jobject pMsg)
 {
-    jclass ttmsg_class = env->GetObjectClass(pMsg);
-    jfieldID fid_event = env->GetFieldID(ttmsg_class, "nClientEvent", "I");
-    jfieldID fid_src = env->GetFieldID(ttmsg_class, "nSource", "I");
-    jfieldID fid_type = env->GetFieldID(ttmsg_class, "ttType", "I");
-
-    assert(fid_event);
-    assert(fid_src);
-    assert(fid_type);
-
-    env->SetIntField(pMsg, fid_event, msg.nClientEvent);
-    env->SetIntField(pMsg, fid_src, msg.nSource);
-    env->SetIntField(pMsg, fid_type, msg.ttType);
-
-    jfieldID fid_channel = env->GetFieldID(ttmsg_class, "channel", "Ldk/bearware/Channel;");
-    jfieldID fid_cemsg = env->GetFieldID(ttmsg_class, "clienterrormsg", "Ldk/bearware/ClientErrorMsg;");
-    jfieldID fid_deskinput = env->GetFieldID(ttmsg_class, "desktopinput", "Ldk/bearware/DesktopInput;");
-    jfieldID fid_ftx = env->GetFieldID(ttmsg_class, "filetransfer", "Ldk/bearware/FileTransfer;");
-    jfieldID fid_mfi = env->GetFieldID(ttmsg_class, "mediafileinfo", "Ldk/bearware/MediaFileInfo;");
-    jfieldID fid_rfile = env->GetFieldID(ttmsg_class, "remotefile", "Ldk/bearware/RemoteFile;");
-    jfieldID fid_srvp = env->GetFieldID(ttmsg_class, "serverproperties", "Ldk/bearware/ServerProperties;");
-    jfieldID fid_srvs = env->GetFieldID(ttmsg_class, "serverstatistics", "Ldk/bearware/ServerStatistics;");
-    jfieldID fid_txtmsg = env->GetFieldID(ttmsg_class, "textmessage", "Ldk/bearware/TextMessage;");
-    jfieldID fid_usr = env->GetFieldID(ttmsg_class, "user", "Ldk/bearware/User;");
-    jfieldID fid_acc = env->GetFieldID(ttmsg_class, "useraccount", "Ldk/bearware/UserAccount;");
-    jfieldID fid_ban = env->GetFieldID(ttmsg_class, "banneduser", "Ldk/bearware/BannedUser;");
-    jfieldID fid_act = env->GetFieldID(ttmsg_class, "bActive", "Z");
-    jfieldID fid_bremain = env->GetFieldID(ttmsg_class, "nBytesRemain", "I");
-    jfieldID fid_streamid = env->GetFieldID(ttmsg_class, "nStreamID", "I");
-    jfieldID fid_payload = env->GetFieldID(ttmsg_class, "nPayloadSize", "I");
-    jfieldID fid_st = env->GetFieldID(ttmsg_class, "nStreamType", "I");
-
-    assert(fid_channel);
-    assert(fid_cemsg);
-    assert(fid_deskinput);
-    assert(fid_ftx);
-    assert(fid_mfi);
-    assert(fid_rfile);
-    assert(fid_srvp);
-    assert(fid_srvs);
-    assert(fid_txtmsg);
-    assert(fid_usr);
-    assert(fid_acc);
-    assert(fid_ban);
-    assert(fid_act);
-    assert(fid_bremain);
-    assert(fid_streamid);
-    assert(fid_payload);
-    assert(fid_st);
+    env->SetIntField(pMsg, fid_ttmsg.event, msg.nClientEvent);
+    env->SetIntField(pMsg, fid_ttmsg.src, msg.nSource);
+    env->SetIntField(pMsg, fid_ttmsg.type, msg.ttType);
 
     switch(msg.ttType)
     {
     case __CHANNEL :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/Channel");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_CHANNEL);
         setChannel(env, msg.channel, newObj, N2J);
-        env->SetObjectField(pMsg, fid_channel, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.channel, newObj);
     }
     break;
     case __CLIENTERRORMSG :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/ClientErrorMsg");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_CLIENTERRORMSG);
         setClientErrorMsg(env, msg.clienterrormsg, newObj, N2J);
-        env->SetObjectField(pMsg, fid_cemsg, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.cemsg, newObj);
     }
     break;
     case __DESKTOPINPUT :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/DesktopInput");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_DESKTOPINPUT);
         setDesktopInput(env, msg.desktopinput, newObj, N2J);
-        env->SetObjectField(pMsg, fid_deskinput, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.deskinput, newObj);
     }
     break;
     case __FILETRANSFER :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/FileTransfer");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_FILETRANSFER);
         setFileTransfer(env, msg.filetransfer, newObj);
-        env->SetObjectField(pMsg, fid_ftx, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.ftx, newObj);
     }
     break;
     case __MEDIAFILEINFO :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/MediaFileInfo");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_MEDIAFILEINFO);
         setMediaFileInfo(env, msg.mediafileinfo, newObj);
-        env->SetObjectField(pMsg, fid_mfi, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.mfi, newObj);
     }
     break;
     case __REMOTEFILE :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/RemoteFile");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_REMOTEFILE);
         setRemoteFile(env, msg.remotefile, newObj, N2J);
-        env->SetObjectField(pMsg, fid_rfile, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.rfile, newObj);
     }
     break;
     case __SERVERPROPERTIES :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/ServerProperties");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_SERVERPROPERTIES);
         setServerProperties(env, msg.serverproperties, newObj, N2J);
-        env->SetObjectField(pMsg, fid_srvp, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.srvp, newObj);
     }
     break;
     case __SERVERSTATISTICS :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/ServerStatistics");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_SERVERSTATISTICS);
         setServerStatistics(env, msg.serverstatistics, newObj, N2J);
-        env->SetObjectField(pMsg, fid_srvs, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.srvs, newObj);
     }
     break;
     case __TEXTMESSAGE :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/TextMessage");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_TEXTMESSAGE);
         setTextMessage(env, msg.textmessage, newObj, N2J);
-        env->SetObjectField(pMsg, fid_txtmsg, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.txtmsg, newObj);
     }
     break;
     case __USER :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/User");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_USER);
         setUser(env, msg.user, newObj);
-        env->SetObjectField(pMsg, fid_usr, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.usr, newObj);
     }
     break;
     case __USERACCOUNT :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/UserAccount");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_USERACCOUNT);
         setUserAccount(env, msg.useraccount, newObj, N2J);
-        env->SetObjectField(pMsg, fid_acc, newObj);
+        env->SetObjectField(pMsg, fid_ttmsg.acc, newObj);
     }
     break;
     case __BANNEDUSER :
     {
-        jclass cls_obj = env->FindClass("dk/bearware/BannedUser");
-        jobject newObj = newObject(env, cls_obj);
+        jobject newObj = newObject(env, JCLS_BANNEDUSER);
         setBannedUser(env, msg.banneduser, newObj, N2J);
-        env->SetObjectField(pMsg, fid_ban, newObj);        
+        env->SetObjectField(pMsg, fid_ttmsg.ban, newObj);
     }
     break;
     case __TTBOOL :
-        env->SetBooleanField(pMsg, fid_act, msg.bActive);
+        env->SetBooleanField(pMsg, fid_ttmsg.act, msg.bActive);
         break;
     case __INT32 :
-        env->SetIntField(pMsg, fid_bremain, msg.nBytesRemain);
-        env->SetIntField(pMsg, fid_streamid, msg.nStreamID);
-        env->SetIntField(pMsg, fid_payload, msg.nPayloadSize);
+        env->SetIntField(pMsg, fid_ttmsg.bremain, msg.nBytesRemain);
+        env->SetIntField(pMsg, fid_ttmsg.streamid, msg.nStreamID);
+        env->SetIntField(pMsg, fid_ttmsg.payload, msg.nPayloadSize);
         break;
     case __STREAMTYPE :
-        env->SetIntField(pMsg, fid_st, msg.nStreamType);
+        env->SetIntField(pMsg, fid_ttmsg.st, msg.nStreamType);
         break;
     case __NONE :
         break;
@@ -584,180 +908,103 @@ jint getIntPtr(JNIEnv* env, jobject intptr)
 
 void setAudioCodec(JNIEnv* env, AudioCodec& codec, jobject lpAudioCodec, JConvert conv)
 {
-    jclass cls_codec = env->GetObjectClass(lpAudioCodec);
-    jfieldID fid_codec = env->GetFieldID(cls_codec, "nCodec", "I");
-    assert(fid_codec);
-
     int conv_codec;
     if(conv == N2J)
     {
         conv_codec = codec.nCodec;
-        env->SetIntField(lpAudioCodec, fid_codec, codec.nCodec);
+        env->SetIntField(lpAudioCodec, fid_audiocodec.codec, codec.nCodec);
     }
     else
     {
         ZERO_STRUCT(codec);
-        conv_codec = env->GetIntField(lpAudioCodec, fid_codec);
-        codec.nCodec = (Codec)env->GetIntField(lpAudioCodec, fid_codec);
+        conv_codec = env->GetIntField(lpAudioCodec, fid_audiocodec.codec);
+        codec.nCodec = (Codec)conv_codec;
     }
 
     switch(conv_codec)
     {
     case SPEEX_CODEC :
     {
-        jfieldID fid_speex = env->GetFieldID(cls_codec,
-                                             "speex",
-                                             "Ldk/bearware/SpeexCodec;");
-        jclass cls_spx = env->FindClass("dk/bearware/SpeexCodec");
-        jfieldID fid_bandmode = env->GetFieldID(cls_spx,
-                                                "nBandmode", "I");
-        jfieldID fid_quality = env->GetFieldID(cls_spx,
-                                               "nQuality", "I");
-        jfieldID fid_msec = env->GetFieldID(cls_spx, 
-                                            "nTxIntervalMSec", "I");
-        jfieldID fid_stereo = env->GetFieldID(cls_spx,
-                                              "bStereoPlayback", "Z");
-        assert(fid_speex);
-        assert(fid_bandmode);
-        assert(fid_quality);
-        assert(fid_msec);
-        assert(fid_stereo);
-
         if(conv == N2J)
         {
-            jobject newObj = newObject(env, cls_spx);
+            jobject newObj = newObject(env, JCLS_SPEEXCODEC);
 
-            env->SetIntField(newObj, fid_bandmode, codec.speex.nBandmode);
-            env->SetIntField(newObj, fid_quality, codec.speex.nQuality);
-            env->SetIntField(newObj, fid_msec, codec.speex.nTxIntervalMSec);
-            env->SetBooleanField(newObj, fid_stereo, codec.speex.bStereoPlayback);
-            env->SetObjectField(lpAudioCodec, fid_speex, newObj);
+            env->SetIntField(newObj, fid_spx.bandmode, codec.speex.nBandmode);
+            env->SetIntField(newObj, fid_spx.quality, codec.speex.nQuality);
+            env->SetIntField(newObj, fid_spx.msec, codec.speex.nTxIntervalMSec);
+            env->SetBooleanField(newObj, fid_spx.stereo, codec.speex.bStereoPlayback);
+            env->SetObjectField(lpAudioCodec, fid_audiocodec.speex, newObj);
         }
         else
         {
-            jobject speex_obj = env->GetObjectField(lpAudioCodec, fid_speex);
+            jobject speex_obj = env->GetObjectField(lpAudioCodec, fid_audiocodec.speex);
             assert(speex_obj);
-            codec.speex.nBandmode = env->GetIntField(speex_obj, fid_bandmode);
-            codec.speex.nQuality = env->GetIntField(speex_obj, fid_quality);
-            codec.speex.nTxIntervalMSec = env->GetIntField(speex_obj, fid_msec);
-            codec.speex.bStereoPlayback = env->GetBooleanField(speex_obj, fid_stereo);
+            codec.speex.nBandmode = env->GetIntField(speex_obj, fid_spx.bandmode);
+            codec.speex.nQuality = env->GetIntField(speex_obj, fid_spx.quality);
+            codec.speex.nTxIntervalMSec = env->GetIntField(speex_obj, fid_spx.msec);
+            codec.speex.bStereoPlayback = env->GetBooleanField(speex_obj, fid_spx.stereo);
         }
     }
     break;
     case SPEEX_VBR_CODEC :
     {
-        jfieldID fid_speexvbr = env->GetFieldID(cls_codec,
-                                                "speex_vbr",
-                                                "Ldk/bearware/SpeexVBRCodec;");
-
-        jclass cls_spx = env->FindClass("dk/bearware/SpeexVBRCodec");
-        jfieldID fid_bandmode = env->GetFieldID(cls_spx,
-                                                "nBandmode", "I");
-        jfieldID fid_quality = env->GetFieldID(cls_spx,
-                                               "nQuality", "I");
-        jfieldID fid_bitrate = env->GetFieldID(cls_spx, 
-                                               "nBitRate", "I");
-        jfieldID fid_maxbitrate = env->GetFieldID(cls_spx, 
-                                                  "nMaxBitRate", "I");
-        jfieldID fid_msec = env->GetFieldID(cls_spx, 
-                                            "nTxIntervalMSec", "I");
-        jfieldID fid_dtx = env->GetFieldID(cls_spx,
-                                           "bDTX", "Z");
-        jfieldID fid_stereo = env->GetFieldID(cls_spx,
-                                              "bStereoPlayback", "Z");
-        assert(fid_speexvbr);
-        assert(fid_stereo);
-        assert(fid_dtx);
-        assert(fid_msec);
-        assert(fid_maxbitrate);
-        assert(fid_bitrate);
-        assert(fid_quality);
-        assert(fid_bandmode);
-
         if(conv == N2J)
         {
-            jobject newObj = newObject(env, cls_spx);
-
-            env->SetIntField(newObj, fid_bandmode, codec.speex_vbr.nBandmode);
-            env->SetIntField(newObj, fid_quality, codec.speex_vbr.nQuality);
-            env->SetIntField(newObj, fid_bitrate, codec.speex_vbr.nBitRate);
-            env->SetIntField(newObj, fid_maxbitrate, codec.speex_vbr.nMaxBitRate);
-            env->SetBooleanField(newObj, fid_dtx, codec.speex_vbr.bDTX);
-            env->SetIntField(newObj, fid_msec, codec.speex_vbr.nTxIntervalMSec);
-            env->SetBooleanField(newObj, fid_stereo, codec.speex_vbr.bStereoPlayback);
-            env->SetObjectField(lpAudioCodec, fid_speexvbr, newObj);
+            jobject newObj = newObject(env, JCLS_SPEEXVBRCODEC);
+
+            env->SetIntField(newObj, fid_spxvbr.bandmode, codec.speex_vbr.nBandmode);
+            env->SetIntField(newObj, fid_spxvbr.quality, codec.speex_vbr.nQuality);
+            env->SetIntField(newObj, fid_spxvbr.bitrate, codec.speex_vbr.nBitRate);
+            env->SetIntField(newObj, fid_spxvbr.maxbitrate, codec.speex_vbr.nMaxBitRate);
+            env->SetBooleanField(newObj, fid_spxvbr.dtx, codec.speex_vbr.bDTX);
+            env->SetIntField(newObj, fid_spxvbr.msec, codec.speex_vbr.nTxIntervalMSec);
+            env->SetBooleanField(newObj, fid_spxvbr.stereo, codec.speex_vbr.bStereoPlayback);
+            env->SetObjectField(lpAudioCodec, fid_audiocodec.speexvbr, newObj);
         }
         else
         {
-            jobject speexvbr_obj = env->GetObjectField(lpAudioCodec, fid_speexvbr);
-            codec.speex_vbr.nBandmode = env->GetIntField(speexvbr_obj, fid_bandmode);
-            codec.speex_vbr.nQuality = env->GetIntField(speexvbr_obj, fid_quality);
-            codec.speex_vbr.nBitRate = env->GetIntField(speexvbr_obj, fid_bitrate);
-            codec.speex_vbr.nMaxBitRate = env->GetIntField(speexvbr_obj, fid_maxbitrate);
-            codec.speex_vbr.bDTX = env->GetBooleanField(speexvbr_obj, fid_dtx);
-            codec.speex_vbr.nTxIntervalMSec = env->GetIntField(speexvbr_obj, fid_msec);
-            codec.speex_vbr.bStereoPlayback = env->GetBooleanField(speexvbr_obj, fid_stereo);
+            jobject speexvbr_obj = env->GetObjectField(lpAudioCodec, fid_audiocodec.speexvbr);
+            codec.speex_vbr.nBandmode = env->GetIntField(speexvbr_obj, fid_spxvbr.bandmode);
+            codec.speex_vbr.nQuality = env->GetIntField(speexvbr_obj, fid_spxvbr.quality);
+            codec.speex_vbr.nBitRate = env->GetIntField(speexvbr_obj, fid_spxvbr.bitrate);
+            codec.speex_vbr.nMaxBitRate = env->GetIntField(speexvbr_obj, fid_spxvbr.maxbitrate);
+            codec.speex_vbr.bDTX = env->GetBooleanField(speexvbr_obj, fid_spxvbr.dtx);
+            codec.speex_vbr.nTxIntervalMSec = env->GetIntField(speexvbr_obj, fid_spxvbr.msec);
+            codec.speex_vbr.bStereoPlayback = env->GetBooleanField(speexvbr_obj, fid_spxvbr.stereo);
         }
     }
     break;
     case OPUS_CODEC :
     {
-        jfieldID fid_opus = env->GetFieldID(cls_codec, "opus",
-                                            "Ldk/bearware/OpusCodec;");
-
-        jclass cls_opus = env->FindClass("dk/bearware/OpusCodec");
-        jfieldID fid_sr = env->GetFieldID(cls_opus, "nSampleRate", "I");
-        jfieldID fid_ch = env->GetFieldID(cls_opus, "nChannels", "I");
-        jfieldID fid_app = env->GetFieldID(cls_opus, "nApplication", "I");
-        jfieldID fid_comp = env->GetFieldID(cls_opus, "nComplexity", "I");
-        jfieldID fid_fec = env->GetFieldID(cls_opus, "bFEC", "Z");
-        jfieldID fid_dtx = env->GetFieldID(cls_opus, "bDTX", "Z");
-        jfieldID fid_br = env->GetFieldID(cls_opus, "nBitRate", "I");
-        jfieldID fid_vbr = env->GetFieldID(cls_opus, "bVBR", "Z");
-        jfieldID fid_vbrc = env->GetFieldID(cls_opus, "bVBRConstraint", "Z");
-        jfieldID fid_msec = env->GetFieldID(cls_opus, "nTxIntervalMSec", "I");
-
-        assert(fid_opus);
-        assert(fid_sr);
-        assert(fid_ch);
-        assert(fid_app);
-        assert(fid_comp);
-        assert(fid_fec);
-        assert(fid_dtx);
-        assert(fid_br);
-        assert(fid_vbr);
-        assert(fid_vbrc);
-        assert(fid_msec);
-
         if(conv == N2J)
         {
-            jobject newObj = newObject(env, cls_opus);
-
-            env->SetIntField(newObj, fid_sr, codec.opus.nSampleRate);
-            env->SetIntField(newObj, fid_ch, codec.opus.nChannels);
-            env->SetIntField(newObj, fid_app, codec.opus.nApplication);
-            env->SetIntField(newObj, fid_comp, codec.opus.nComplexity);
-            env->SetBooleanField(newObj, fid_fec, codec.opus.bFEC);
-            env->SetBooleanField(newObj, fid_dtx, codec.opus.bDTX);
-            env->SetIntField(newObj, fid_br, codec.opus.nBitRate);
-            env->SetBooleanField(newObj, fid_vbr, codec.opus.bVBR);
-            env->SetBooleanField(newObj, fid_vbrc, codec.opus.bVBRConstraint);
-            env->SetIntField(newObj, fid_msec, codec.opus.nTxIntervalMSec);
-            env->SetObjectField(lpAudioCodec, fid_opus, newObj);
+            jobject newObj = newObject(env, JCLS_OPUSCODEC);
+
+            env->SetIntField(newObj, fid_opuscodec.sr, codec.opus.nSampleRate);
+            env->SetIntField(newObj, fid_opuscodec.ch, codec.opus.nChannels);
+            env->SetIntField(newObj, fid_opuscodec.app, codec.opus.nApplication);
+            env->SetIntField(newObj, fid_opuscodec.comp, codec.opus.nComplexity);
+            env->SetBooleanField(newObj, fid_opuscodec.fec, codec.opus.bFEC);
+            env->SetBooleanField(newObj, fid_opuscodec.dtx, codec.opus.bDTX);
+            env->SetIntField(newObj, fid_opuscodec.br, codec.opus.nBitRate);
+            env->SetBooleanField(newObj, fid_opuscodec.vbr, codec.opus.bVBR);
+            env->SetBooleanField(newObj, fid_opuscodec.vbrc, codec.opus.bVBRConstraint);
+            env->SetIntField(newObj, fid_opuscodec.msec, codec.opus.nTxIntervalMSec);
+            env->SetObjectField(lpAudioCodec, fid_audiocodec.opus, newObj);
         }
         else
         {
-            jobject opus_obj = env->GetObjectField(lpAudioCodec, fid_opus);
-            codec.opus.nSampleRate = env->GetIntField(opus_obj, fid_sr);
-            codec.opus.nChannels = env->GetIntField(opus_obj, fid_ch);
-            codec.opus.nApplication = env->GetIntField(opus_obj, fid_app);
-            codec.opus.nComplexity = env->GetIntField(opus_obj, fid_comp);
-            codec.opus.bFEC = env->GetBooleanField(opus_obj, fid_fec);
-            codec.opus.bDTX = env->GetBooleanField(opus_obj, fid_dtx);
-            codec.opus.nBitRate = env->GetIntField(opus_obj, fid_br);
-            codec.opus.bVBR = env->GetBooleanField(opus_obj, fid_vbr);
-            codec.opus.bVBRConstraint = env->GetBooleanField(opus_obj, fid_vbrc);
-            codec.opus.nTxIntervalMSec = env->GetIntField(opus_obj, fid_msec);
+            jobject opus_obj = env->GetObjectField(lpAudioCodec, fid_audiocodec.opus);
+            codec.opus.nSampleRate = env->GetIntField(opus_obj, fid_opuscodec.sr);
+            codec.opus.nChannels = env->GetIntField(opus_obj, fid_opuscodec.ch);
+            codec.opus.nApplication = env->GetIntField(opus_obj, fid_opuscodec.app);
+            codec.opus.nComplexity = env->GetIntField(opus_obj, fid_opuscodec.comp);
+            codec.opus.bFEC = env->GetBooleanField(opus_obj, fid_opuscodec.fec);
+            codec.opus.bDTX = env->GetBooleanField(opus_obj, fid_opuscodec.dtx);
+            codec.opus.nBitRate = env->GetIntField(opus_obj, fid_opuscodec.br);
+            codec.opus.bVBR = env->GetBooleanField(opus_obj, fid_opuscodec.vbr);
+            codec.opus.bVBRConstraint = env->GetBooleanField(opus_obj, fid_opuscodec.vbrc);
+            codec.opus.nTxIntervalMSec = env->GetIntField(opus_obj, fid_opuscodec.msec);
         }
     }
     break;
@@ -766,22 +1013,16 @@ void setAudioCodec(JNIEnv* env, AudioCodec& codec, jobject lpAudioCodec, JConver
 
 void setAudioConfig(JNIEnv* env, AudioConfig& audcfg, jobject lpAudioConfig, JConvert conv)
 {
-    jclass cls_cfg = env->GetObjectClass(lpAudioConfig);
-    jfieldID fid_agc = env->GetFieldID(cls_cfg, "bEnableAGC", "Z");
-    jfieldID fid_gainlevel = env->GetFieldID(cls_cfg, "nGainLevel", "I");
-    assert(fid_agc);
-    assert(fid_gainlevel);
-
     if(conv == N2J)
     {
-        env->SetBooleanField(lpAudioConfig, fid_agc, audcfg.bEnableAGC);
-        env->SetIntField(lpAudioConfig, fid_gainlevel, audcfg.nGainLevel);
+        env->SetBooleanField(lpAudioConfig, fid_audiocfg.agc, audcfg.bEnableAGC);
+        env->SetIntField(lpAudioConfig, fid_audiocfg.gainlevel, audcfg.nGainLevel);
     }
     else
     {
         ZERO_STRUCT(audcfg);
-        audcfg.bEnableAGC = env->GetBooleanField(lpAudioConfig, fid_agc);
-        audcfg.nGainLevel = env->GetIntField(lpAudioConfig, fid_gainlevel);
+        audcfg.bEnableAGC = env->GetBooleanField(lpAudioConfig, fid_audiocfg.agc);
+        audcfg.nGainLevel = env->GetIntField(lpAudioConfig, fid_audiocfg.gainlevel);
     }
 }
 
@@ -840,244 +1081,135 @@ void setSpeexDSP(JNIEnv* env, SpeexDSP& spxdsp, jobject lpSpeexDSP, JConvert con
 
 void setServerProperties(JNIEnv* env, ServerProperties& srvprop, jobject lpServerProperties, JConvert conv)
 {
-    jclass cls_srv = env->GetObjectClass(lpServerProperties);
-    
-    jfieldID fid_name = env->GetFieldID(cls_srv, "szServerName", "Ljava/lang/String;");
-    jfieldID fid_motd = env->GetFieldID(cls_srv, "szMOTD", "Ljava/lang/String;");
-    jfieldID fid_motdraw = env->GetFieldID(cls_srv, "szMOTDRaw", "Ljava/lang/String;");
-    jfieldID fid_maxusers = env->GetFieldID(cls_srv, "nMaxUsers", "I");
-    jfieldID fid_maxattempts = env->GetFieldID(cls_srv, "nMaxLoginAttempts", "I");
-    jfieldID fid_iplogins = env->GetFieldID(cls_srv, "nMaxLoginsPerIPAddress", "I");
-    jfieldID fid_voicetx = env->GetFieldID(cls_srv, "nMaxVoiceTxPerSecond", "I");
-    jfieldID fid_vidcaptx = env->GetFieldID(cls_srv, "nMaxVideoCaptureTxPerSecond", "I");
-    jfieldID fid_mftx = env->GetFieldID(cls_srv, "nMaxMediaFileTxPerSecond", "I");
-    jfieldID fid_desktx = env->GetFieldID(cls_srv, "nMaxDesktopTxPerSecond", "I");
-    jfieldID fid_totaltx = env->GetFieldID(cls_srv, "nMaxTotalTxPerSecond", "I");
-    jfieldID fid_save = env->GetFieldID(cls_srv, "bAutoSave", "Z");
-    jfieldID fid_tcp = env->GetFieldID(cls_srv, "nTcpPort", "I");
-    jfieldID fid_udp = env->GetFieldID(cls_srv, "nUdpPort", "I");
-    jfieldID fid_tmout = env->GetFieldID(cls_srv, "nUserTimeout", "I");
-    jfieldID fid_srvver = env->GetFieldID(cls_srv, "szServerVersion", "Ljava/lang/String;");
-    jfieldID fid_srvprot = env->GetFieldID(cls_srv, "szServerProtocolVersion", "Ljava/lang/String;");
-
-    assert(fid_name);
-    assert(fid_motd);
-    assert(fid_motdraw);
-    assert(fid_maxusers);
-    assert(fid_maxattempts);
-    assert(fid_iplogins);
-    assert(fid_voicetx);
-    assert(fid_vidcaptx);
-    assert(fid_mftx);
-    assert(fid_desktx);
-    assert(fid_totaltx);
-    assert(fid_save);
-    assert(fid_tcp);
-    assert(fid_udp);
-    assert(fid_tmout);
-    assert(fid_srvver);
-    assert(fid_srvprot);
-
     if(conv == N2J)
     {
-        env->SetObjectField(lpServerProperties, fid_name, NEW_JSTRING(env, srvprop.szServerName));
-        env->SetObjectField(lpServerProperties, fid_motd, NEW_JSTRING(env, srvprop.szMOTD));
-        env->SetObjectField(lpServerProperties, fid_motdraw, NEW_JSTRING(env, srvprop.szMOTDRaw));
-        env->SetIntField(lpServerProperties, fid_maxusers, srvprop.nMaxUsers);
-        env->SetIntField(lpServerProperties, fid_maxattempts, srvprop.nMaxLoginAttempts);
-        env->SetIntField(lpServerProperties, fid_iplogins, srvprop.nMaxLoginsPerIPAddress);
-        env->SetIntField(lpServerProperties, fid_voicetx, srvprop.nMaxVoiceTxPerSecond);
-        env->SetIntField(lpServerProperties, fid_vidcaptx, srvprop.nMaxVideoCaptureTxPerSecond);
-        env->SetIntField(lpServerProperties, fid_mftx, srvprop.nMaxMediaFileTxPerSecond);
-        env->SetIntField(lpServerProperties, fid_desktx, srvprop.nMaxDesktopTxPerSecond);
-        env->SetIntField(lpServerProperties, fid_totaltx, srvprop.nMaxTotalTxPerSecond);
-        env->SetBooleanField(lpServerProperties, fid_save, srvprop.bAutoSave);
-        env->SetIntField(lpServerProperties, fid_tcp, srvprop.nTcpPort);
-        env->SetIntField(lpServerProperties, fid_udp, srvprop.nUdpPort);
-        env->SetIntField(lpServerProperties, fid_tmout, srvprop.nUserTimeout);
-        env->SetObjectField(lpServerProperties, fid_srvver, NEW_JSTRING(env, srvprop.szServerVersion));
-        env->SetObjectField(lpServerProperties, fid_srvprot, NEW_JSTRING(env, srvprop.szServerProtocolVersion));
+        env->SetObjectField(lpServerProperties, fid_srvprop.name, NEW_JSTRING(env, srvprop.szServerName));
+        env->SetObjectField(lpServerProperties, fid_srvprop.motd, NEW_JSTRING(env, srvprop.szMOTD));
+        env->SetObjectField(lpServerProperties, fid_srvprop.motdraw, NEW_JSTRING(env, srvprop.szMOTDRaw));
+        env->SetIntField(lpServerProperties, fid_srvprop.maxusers, srvprop.nMaxUsers);
+        env->SetIntField(lpServerProperties, fid_srvprop.maxattempts, srvprop.nMaxLoginAttempts);
+        env->SetIntField(lpServerProperties, fid_srvprop.iplogins, srvprop.nMaxLoginsPerIPAddress);
+        env->SetIntField(lpServerProperties, fid_srvprop.voicetx, srvprop.nMaxVoiceTxPerSecond);
+        env->SetIntField(lpServerProperties, fid_srvprop.vidcaptx, srvprop.nMaxVideoCaptureTxPerSecond);
+        env->SetIntField(lpServerProperties, fid_srvprop.mftx, srvprop.nMaxMediaFileTxPerSecond);
+        env->SetIntField(lpServerProperties, fid_srvprop.desktx, srvprop.nMaxDesktopTxPerSecond);
+        env->SetIntField(lpServerProperties, fid_srvprop.totaltx, srvprop.nMaxTotalTxPerSecond);
+        env->SetBooleanField(lpServerProperties, fid_srvprop.save, srvprop.bAutoSave);
+        env->SetIntField(lpServerProperties, fid_srvprop.tcp, srvprop.nTcpPort);
+        env->SetIntField(lpServerProperties, fid_srvprop.udp, srvprop.nUdpPort);
+        env->SetIntField(lpServerProperties, fid_srvprop.tmout, srvprop.nUserTimeout);
+        env->SetObjectField(lpServerProperties, fid_srvprop.srvver, NEW_JSTRING(env, srvprop.szServerVersion));
+        env->SetObjectField(lpServerProperties, fid_srvprop.srvprot, NEW_JSTRING(env, srvprop.szServerProtocolVersion));
     }
     else
     {
         ZERO_STRUCT(srvprop);
-        TT_STRCPY(srvprop.szServerName, ttstr(env, (jstring)env->GetObjectField(lpServerProperties, fid_name)));
-        TT_STRCPY(srvprop.szMOTD, ttstr(env, (jstring)env->GetObjectField(lpServerProperties, fid_motd)));
-        TT_STRCPY(srvprop.szMOTDRaw, ttstr(env, (jstring)env->GetObjectField(lpServerProperties, fid_motdraw)));
-        srvprop.nMaxUsers = env->GetIntField(lpServerProperties, fid_maxusers);
-        srvprop.nMaxLoginAttempts = env->GetIntField(lpServerProperties, fid_maxattempts);
-        srvprop.nMaxLoginsPerIPAddress = env->GetIntField(lpServerProperties, fid_iplogins);
-        srvprop.nMaxVoiceTxPerSecond = env->GetIntField(lpServerProperties, fid_voicetx);
-        srvprop.nMaxVideoCaptureTxPerSecond = env->GetIntField(lpServerProperties, fid_vidcaptx);
-        srvprop.nMaxMediaFileTxPerSecond = env->GetIntField(lpServerProperties, fid_mftx);
-        srvprop.nMaxDesktopTxPerSecond = env->GetIntField(lpServerProperties, fid_desktx);
-        srvprop.nMaxTotalTxPerSecond = env->GetIntField(lpServerProperties, fid_totaltx);
-        srvprop.bAutoSave = env->GetBooleanField(lpServerProperties, fid_save);
-        srvprop.nTcpPort = env->GetIntField(lpServerProperties, fid_tcp);
-        srvprop.nUdpPort = env->GetIntField(lpServerProperties, fid_udp);
-        srvprop.nUserTimeout = env->GetIntField(lpServerProperties, fid_tmout);
-        TT_STRCPY(srvprop.szServerVersion, ttstr(env, (jstring)env->GetObjectField(lpServerProperties, fid_srvver)));
-        TT_STRCPY(srvprop.szServerProtocolVersion, ttstr(env, (jstring)env->GetObjectField(lpServerProperties, fid_srvprot)));
+        TT_STRCPY(srvprop.szServerName, ttstr(env, (jstring)env->GetObjectField(lpServerProperties, fid_srvprop.name)));
+        TT_STRCPY(srvprop.szMOTD, ttstr(env, (jstring)env->GetObjectField(lpServerProperties, fid_srvprop.motd)));
+        TT_STRCPY(srvprop.szMOTDRaw, ttstr(env, (jstring)env->GetObjectField(lpServerProperties, fid_srvprop.motdraw)));
+        srvprop.nMaxUsers = env->GetIntField(lpServerProperties, fid_srvprop.maxusers);
+        srvprop.nMaxLoginAttempts = env->GetIntField(lpServerProperties, fid_srvprop.maxattempts);
+        srvprop.nMaxLoginsPerIPAddress = env->GetIntField(lpServerProperties, fid_srvprop.iplogins);
+        srvprop.nMaxVoiceTxPerSecond = env->GetIntField(lpServerProperties, fid_srvprop.voicetx);
+        srvprop.nMaxVideoCaptureTxPerSecond = env->GetIntField(lpServerProperties, fid_srvprop.vidcaptx);
+        srvprop.nMaxMediaFileTxPerSecond = env->GetIntField(lpServerProperties, fid_srvprop.mftx);
+        srvprop.nMaxDesktopTxPerSecond = env->GetIntField(lpServerProperties, fid_srvprop.desktx);
+        srvprop.nMaxTotalTxPerSecond = env->GetIntField(lpServerProperties, fid_srvprop.totaltx);
+        srvprop.bAutoSave = env->GetBooleanField(lpServerProperties, fid_srvprop.save);
+        srvprop.nTcpPort = env->GetIntField(lpServerProperties, fid_srvprop.tcp);
+        srvprop.nUdpPort = env->GetIntField(lpServerProperties, fid_srvprop.udp);
+        srvprop.nUserTimeout = env->GetIntField(lpServerProperties, fid_srvprop.tmout);
+        TT_STRCPY(srvprop.szServerVersion, ttstr(env, (jstring)env->GetObjectField(lpServerProperties, fid_srvprop.srvver)));
+        TT_STRCPY(srvprop.szServerProtocolVersion, ttstr(env, (jstring)env->GetObjectField(lpServerProperties, fid_srvprop.srvprot)));
     }
 }
 
 void setClientStatistics(JNIEnv* env, const ClientStatistics& stats, jobject lpStats)
 {
-    jclass cls_stats = env->GetObjectClass(lpStats);
-
-    jfieldID fid_udpsent = env->GetFieldID(cls_stats, "nUdpBytesSent", "J");
-    jfieldID fid_udprecv = env->GetFieldID(cls_stats, "nUdpBytesRecv", "J");
-    jfieldID fid_voicesent = env->GetFieldID(cls_stats, "nVoiceBytesSent", "J");
-    jfieldID fid_voicerecv = env->GetFieldID(cls_stats, "nVoiceBytesRecv", "J");
-    jfieldID fid_videosent = env->GetFieldID(cls_stats, "nVideoCaptureBytesSent", "J");
-    jfieldID fid_videorecv = env->GetFieldID(cls_stats, "nVideoCaptureBytesRecv", "J");
-    jfieldID fid_mfaudsent = env->GetFieldID(cls_stats, "nMediaFileAudioBytesSent", "J");
-    jfieldID fid_mfaudrecv = env->GetFieldID(cls_stats, "nMediaFileAudioBytesRecv", "J");
-    jfieldID fid_mfvidsent = env->GetFieldID(cls_stats, "nMediaFileVideoBytesSent", "J");
-    jfieldID fid_mfvidrecv = env->GetFieldID(cls_stats, "nMediaFileVideoBytesRecv", "J");
-    jfieldID fid_desksent = env->GetFieldID(cls_stats, "nDesktopBytesSent", "J");
-    jfieldID fid_deskrecv = env->GetFieldID(cls_stats, "nDesktopBytesRecv", "J");
-    jfieldID fid_udpping = env->GetFieldID(cls_stats, "nUdpPingTimeMs", "I");
-    jfieldID fid_tcpping = env->GetFieldID(cls_stats, "nTcpPingTimeMs", "I");
-    jfieldID fid_tcpsilen = env->GetFieldID(cls_stats, "nTcpServerSilenceSec", "I");
-    jfieldID fid_udpsilen = env->GetFieldID(cls_stats, "nUdpServerSilenceSec", "I");
-
-    assert(fid_udpsent);
-    assert(fid_udprecv);
-    assert(fid_voicesent);
-    assert(fid_voicerecv);
-    assert(fid_videosent);
-    assert(fid_videorecv);
-    assert(fid_mfaudsent);
-    assert(fid_mfaudrecv);
-    assert(fid_mfvidsent);
-    assert(fid_mfvidrecv);
-    assert(fid_desksent);
-    assert(fid_deskrecv);
-    assert(fid_udpping);
-    assert(fid_tcpping);
-    assert(fid_tcpsilen);
-    assert(fid_udpsilen);
-
-    env->SetLongField(lpStats, fid_udpsent, stats.nUdpBytesSent);
-    env->SetLongField(lpStats, fid_udprecv, stats.nUdpBytesRecv);
-    env->SetLongField(lpStats, fid_voicesent, stats.nVoiceBytesSent);
-    env->SetLongField(lpStats, fid_voicerecv, stats.nVoiceBytesRecv);
-    env->SetLongField(lpStats, fid_videosent, stats.nVideoCaptureBytesSent);
-    env->SetLongField(lpStats, fid_videorecv, stats.nVideoCaptureBytesRecv);
-    env->SetLongField(lpStats, fid_mfaudsent, stats.nMediaFileAudioBytesSent);
-    env->SetLongField(lpStats, fid_mfaudrecv, stats.nMediaFileAudioBytesRecv);
-    env->SetLongField(lpStats, fid_mfvidsent, stats.nMediaFileVideoBytesSent);
-    env->SetLongField(lpStats, fid_mfvidrecv, stats.nMediaFileVideoBytesRecv);
-    env->SetLongField(lpStats, fid_desksent, stats.nDesktopBytesSent);
-    env->SetLongField(lpStats, fid_deskrecv, stats.nDesktopBytesRecv);
-    env->SetIntField(lpStats, fid_udpping, stats.nUdpPingTimeMs);
-    env->SetIntField(lpStats, fid_tcpping, stats.nTcpPingTimeMs);
-    env->SetIntField(lpStats, fid_tcpsilen, stats.nTcpServerSilenceSec);
-    env->SetIntField(lpStats, fid_udpsilen, stats.nUdpServerSilenceSec);
+    env->SetLongField(lpStats, fid_cltstats.udpsent, stats.nUdpBytesSent);
+    env->SetLongField(lpStats, fid_cltstats.udprecv, stats.nUdpBytesRecv);
+    env->SetLongField(lpStats, fid_cltstats.voicesent, stats.nVoiceBytesSent);
+    env->SetLongField(lpStats, fid_cltstats.voicerecv, stats.nVoiceBytesRecv);
+    env->SetLongField(lpStats, fid_cltstats.videosent, stats.nVideoCaptureBytesSent);
+    env->SetLongField(lpStats, fid_cltstats.videorecv, stats.nVideoCaptureBytesRecv);
+    env->SetLongField(lpStats, fid_cltstats.mfaudsent, stats.nMediaFileAudioBytesSent);
+    env->SetLongField(lpStats, fid_cltstats.mfaudrecv, stats.nMediaFileAudioBytesRecv);
+    env->SetLongField(lpStats, fid_cltstats.mfvidsent, stats.nMediaFileVideoBytesSent);
+    env->SetLongField(lpStats, fid_cltstats.mfvidrecv, stats.nMediaFileVideoBytesRecv);
+    env->SetLongField(lpStats, fid_cltstats.desksent, stats.nDesktopBytesSent);
+    env->SetLongField(lpStats, fid_cltstats.deskrecv, stats.nDesktopBytesRecv);
+    env->SetIntField(lpStats, fid_cltstats.udpping, stats.nUdpPingTimeMs);
+    env->SetIntField(lpStats, fid_cltstats.tcpping, stats.nTcpPingTimeMs);
+    env->SetIntField(lpStats, fid_cltstats.tcpsilen, stats.nTcpServerSilenceSec);
+    env->SetIntField(lpStats, fid_cltstats.udpsilen, stats.nUdpServerSilenceSec);
+    env->SetIntField(lpStats, fid_cltstats.vcoverrun, stats.nVoiceCaptureOverruns);
+    env->SetIntField(lpStats, fid_cltstats.vcsuppress, stats.nVoiceFramesSuppressed);
+    env->SetIntField(lpStats, fid_cltstats.evcoalesced, stats.nEventsCoalesced);
+    env->SetIntField(lpStats, fid_cltstats.evdropped, stats.nEventsDropped);
+    env->SetIntField(lpStats, fid_cltstats.maxpayload, stats.nMaxPayloadSize);
 }
 
 void setTextMessage(JNIEnv* env, TextMessage& msg, jobject lpTextMessage, JConvert conv)
 {
-    jclass cls_txtmsg = env->GetObjectClass(lpTextMessage);
-    
-    jfieldID fid_type = env->GetFieldID(cls_txtmsg, "nMsgType", "I");
-    jfieldID fid_fromid = env->GetFieldID(cls_txtmsg, "nFromUserID", "I");
-    jfieldID fid_username = env->GetFieldID(cls_txtmsg, "szFromUsername", "Ljava/lang/String;");
-    jfieldID fid_toid = env->GetFieldID(cls_txtmsg, "nToUserID", "I");
-    jfieldID fid_chanid = env->GetFieldID(cls_txtmsg, "nChannelID", "I");
-    jfieldID fid_msg = env->GetFieldID(cls_txtmsg, "szMessage", "Ljava/lang/String;");
-
-    assert(fid_type);
-    assert(fid_fromid);
-    assert(fid_username);
-    assert(fid_toid);
-    assert(fid_chanid);
-    assert(fid_msg);
-
     if(conv == N2J)
     {
-        env->SetIntField(lpTextMessage, fid_type, msg.nMsgType);
-        env->SetIntField(lpTextMessage, fid_fromid, msg.nFromUserID);
-        env->SetObjectField(lpTextMessage, fid_username, NEW_JSTRING(env, msg.szFromUsername));
-        env->SetIntField(lpTextMessage, fid_toid, msg.nToUserID);
-        env->SetIntField(lpTextMessage, fid_chanid, msg.nChannelID);
-        env->SetObjectField(lpTextMessage, fid_msg, NEW_JSTRING(env, msg.szMessage));
+        env->SetIntField(lpTextMessage, fid_txtmsg.type, msg.nMsgType);
+        env->SetIntField(lpTextMessage, fid_txtmsg.fromid, msg.nFromUserID);
+        env->SetObjectField(lpTextMessage, fid_txtmsg.username, NEW_JSTRING(env, msg.szFromUsername));
+        env->SetIntField(lpTextMessage, fid_txtmsg.toid, msg.nToUserID);
+        env->SetIntField(lpTextMessage, fid_txtmsg.chanid, msg.nChannelID);
+        env->SetObjectField(lpTextMessage, fid_txtmsg.msg, NEW_JSTRING(env, msg.szMessage));
     }
     else
     {
         ZERO_STRUCT(msg);
-        msg.nMsgType = (TextMsgType)env->GetIntField(lpTextMessage, fid_type);
-        msg.nFromUserID = env->GetIntField(lpTextMessage, fid_fromid);
-        TT_STRCPY(msg.szFromUsername, ttstr(env, (jstring)env->GetObjectField(lpTextMessage, fid_username)));
-        msg.nToUserID = env->GetIntField(lpTextMessage, fid_toid);
-        msg.nChannelID = env->GetIntField(lpTextMessage, fid_chanid);
-        TT_STRCPY(msg.szMessage, ttstr(env, (jstring)env->GetObjectField(lpTextMessage, fid_msg)));
+        msg.nMsgType = (TextMsgType)env->GetIntField(lpTextMessage, fid_txtmsg.type);
+        msg.nFromUserID = env->GetIntField(lpTextMessage, fid_txtmsg.fromid);
+        TT_STRCPY(msg.szFromUsername, ttstr(env, (jstring)env->GetObjectField(lpTextMessage, fid_txtmsg.username)));
+        msg.nToUserID = env->GetIntField(lpTextMessage, fid_txtmsg.toid);
+        msg.nChannelID = env->GetIntField(lpTextMessage, fid_txtmsg.chanid);
+        TT_STRCPY(msg.szMessage, ttstr(env, (jstring)env->GetObjectField(lpTextMessage, fid_txtmsg.msg)));
     }
 }
 
 void setUserAccount(JNIEnv* env, UserAccount& account, jobject lpAccount, JConvert conv)
 {
-    jclass cls_account = env->GetObjectClass(lpAccount);
-    
-    jfieldID fid_user = env->GetFieldID(cls_account, "szUsername", "Ljava/lang/String;");
-    jfieldID fid_passwd = env->GetFieldID(cls_account, "szPassword", "Ljava/lang/String;");
-    jfieldID fid_type = env->GetFieldID(cls_account, "uUserType", "I");
-    jfieldID fid_data = env->GetFieldID(cls_account, "nUserData", "I");
-    jfieldID fid_ur = env->GetFieldID(cls_account, "uUserRights", "I");
-    jfieldID fid_note = env->GetFieldID(cls_account, "szNote", "Ljava/lang/String;");
-    jfieldID fid_initchan = env->GetFieldID(cls_account, "szInitChannel", "Ljava/lang/String;");
-    jfieldID fid_op = env->GetFieldID(cls_account, "autoOperatorChannels", "[I");
-    jfieldID fid_audbps = env->GetFieldID(cls_account, "nAudioCodecBpsLimit", "I");
-    jfieldID fid_abuse = env->GetFieldID(cls_account, "abusePrevent", "Ldk/bearware/AbusePrevention;");
-
-    assert(fid_user);
-    assert(fid_passwd);
-    assert(fid_type);
-    assert(fid_data);
-    assert(fid_note);
-    assert(fid_initchan);
-    assert(fid_op);
-    assert(fid_ur);
-    assert(fid_audbps);
-    assert(fid_abuse);
-
     if(conv == N2J)
     {
-        env->SetObjectField(lpAccount, fid_user, NEW_JSTRING(env, account.szUsername));
-        env->SetObjectField(lpAccount, fid_passwd, NEW_JSTRING(env, account.szPassword));
-        env->SetIntField(lpAccount, fid_type, account.uUserType);
-        env->SetIntField(lpAccount, fid_ur, account.uUserRights);
-        env->SetIntField(lpAccount, fid_data, account.nUserData);
-        env->SetObjectField(lpAccount, fid_note, NEW_JSTRING(env, account.szNote));
-        env->SetObjectField(lpAccount, fid_initchan, NEW_JSTRING(env, account.szInitChannel));
+        env->SetObjectField(lpAccount, fid_account.user, NEW_JSTRING(env, account.szUsername));
+        env->SetObjectField(lpAccount, fid_account.passwd, NEW_JSTRING(env, account.szPassword));
+        env->SetIntField(lpAccount, fid_account.type, account.uUserType);
+        env->SetIntField(lpAccount, fid_account.ur, account.uUserRights);
+        env->SetIntField(lpAccount, fid_account.data, account.nUserData);
+        env->SetObjectField(lpAccount, fid_account.note, NEW_JSTRING(env, account.szNote));
+        env->SetObjectField(lpAccount, fid_account.initchan, NEW_JSTRING(env, account.szInitChannel));
         jintArray intArr = env->NewIntArray(TT_CHANNELS_OPERATOR_MAX);
         jint tmp[TT_CHANNELS_OPERATOR_MAX] = {0};
         env->SetIntArrayRegion(intArr, 0, TT_CHANNELS_OPERATOR_MAX, TO_JINT_ARRAY(account.autoOperatorChannels, tmp, TT_CHANNELS_OPERATOR_MAX));
-        env->SetObjectField(lpAccount, fid_op, intArr);
-        env->SetIntField(lpAccount, fid_audbps, account.nAudioCodecBpsLimit);
+        env->SetObjectField(lpAccount, fid_account.op, intArr);
+        env->SetIntField(lpAccount, fid_account.audbps, account.nAudioCodecBpsLimit);
         
         jobject ap_obj = newAbusePrevention(env, &account.abusePrevent);
         assert(ap_obj);
         setAbusePrevention(env, account.abusePrevent, ap_obj, conv);
-        env->SetObjectField(lpAccount, fid_abuse, ap_obj);
+        env->SetObjectField(lpAccount, fid_account.abuse, ap_obj);
     }
     else
     {
         ZERO_STRUCT(account);
-        TT_STRCPY(account.szUsername, ttstr(env, (jstring)env->GetObjectField(lpAccount, fid_user)));
-        TT_STRCPY(account.szPassword, ttstr(env, (jstring)env->GetObjectField(lpAccount, fid_passwd)));
-        account.uUserType = env->GetIntField(lpAccount, fid_type);
-        account.uUserRights = env->GetIntField(lpAccount, fid_ur);
-        account.nUserData = env->GetIntField(lpAccount, fid_data);
-        TT_STRCPY(account.szNote, ttstr(env, (jstring)env->GetObjectField(lpAccount, fid_note)));
-        TT_STRCPY(account.szInitChannel, ttstr(env, (jstring)env->GetObjectField(lpAccount, fid_initchan)));
-        jintArray intArr = (jintArray)env->GetObjectField(lpAccount, fid_op);
+        TT_STRCPY(account.szUsername, ttstr(env, (jstring)env->GetObjectField(lpAccount, fid_account.user)));
+        TT_STRCPY(account.szPassword, ttstr(env, (jstring)env->GetObjectField(lpAccount, fid_account.passwd)));
+        account.uUserType = env->GetIntField(lpAccount, fid_account.type);
+        account.uUserRights = env->GetIntField(lpAccount, fid_account.ur);
+        account.nUserData = env->GetIntField(lpAccount, fid_account.data);
+        TT_STRCPY(account.szNote, ttstr(env, (jstring)env->GetObjectField(lpAccount, fid_account.note)));
+        TT_STRCPY(account.szInitChannel, ttstr(env, (jstring)env->GetObjectField(lpAccount, fid_account.initchan)));
+        jintArray intArr = (jintArray)env->GetObjectField(lpAccount, fid_account.op);
         jint tmp[TT_CHANNELS_OPERATOR_MAX] = {0};
         env->GetIntArrayRegion(intArr, 0, TT_CHANNELS_OPERATOR_MAX, tmp);
         TO_INT32_ARRAY(tmp, account.autoOperatorChannels, TT_CHANNELS_OPERATOR_MAX);
-        account.nAudioCodecBpsLimit = env->GetIntField(lpAccount, fid_audbps);
-        jobject ap_obj = env->GetObjectField(lpAccount, fid_abuse);
+        account.nAudioCodecBpsLimit = env->GetIntField(lpAccount, fid_account.audbps);
+        jobject ap_obj = env->GetObjectField(lpAccount, fid_account.abuse);
         assert(ap_obj);
         setAbusePrevention(env, account.abusePrevent, ap_obj, conv);
     }
@@ -1085,454 +1217,341 @@ void setUserAccount(JNIEnv* env, UserAccount& account, jobject lpAccount, JConve
 
 void setServerStatistics(JNIEnv* env, ServerStatistics& stats, jobject lpServerStatistics, JConvert conv)
 {
-    jclass cls_srvstats = env->GetObjectClass(lpServerStatistics);
-    
-    jfieldID fid_totaltx = env->GetFieldID(cls_srvstats, "nTotalBytesTX", "J");
-    jfieldID fid_totalrx = env->GetFieldID(cls_srvstats, "nTotalBytesRX", "J");
-    jfieldID fid_voicetx = env->GetFieldID(cls_srvstats, "nVoiceBytesTX", "J");
-    jfieldID fid_voicerx = env->GetFieldID(cls_srvstats, "nVoiceBytesRX", "J");
-    jfieldID fid_videotx = env->GetFieldID(cls_srvstats, "nVideoCaptureBytesTX", "J");
-    jfieldID fid_videorx = env->GetFieldID(cls_srvstats, "nVideoCaptureBytesRX", "J");
-    jfieldID fid_mftx = env->GetFieldID(cls_srvstats, "nMediaFileBytesTX", "J");
-    jfieldID fid_mfrx = env->GetFieldID(cls_srvstats, "nMediaFileBytesRX", "J");
-    jfieldID fid_desktx = env->GetFieldID(cls_srvstats, "nDesktopBytesTX", "J");
-    jfieldID fid_deskrx = env->GetFieldID(cls_srvstats, "nDesktopBytesRX", "J");
-    jfieldID fid_uptm = env->GetFieldID(cls_srvstats, "nUptimeMSec", "J");
-
-    assert(fid_totaltx);
-    assert(fid_totalrx);
-    assert(fid_voicetx);
-    assert(fid_voicerx);
-    assert(fid_videotx);
-    assert(fid_videorx);
-    assert(fid_mftx);
-    assert(fid_mfrx);
-    assert(fid_desktx);
-    assert(fid_deskrx);
-    assert(fid_uptm);
-
     if(conv == N2J)
     {
-        env->SetLongField(lpServerStatistics, fid_totaltx, stats.nTotalBytesTX);
-        env->SetLongField(lpServerStatistics, fid_totalrx, stats.nTotalBytesRX);
-        env->SetLongField(lpServerStatistics, fid_voicetx, stats.nVoiceBytesTX);
-        env->SetLongField(lpServerStatistics, fid_voicerx, stats.nVoiceBytesRX);
-        env->SetLongField(lpServerStatistics, fid_videotx, stats.nVideoCaptureBytesTX);
-        env->SetLongField(lpServerStatistics, fid_videorx, stats.nVideoCaptureBytesRX);
-        env->SetLongField(lpServerStatistics, fid_mftx, stats.nMediaFileBytesTX);
-        env->SetLongField(lpServerStatistics, fid_mfrx, stats.nMediaFileBytesRX);
-        env->SetLongField(lpServerStatistics, fid_desktx, stats.nDesktopBytesTX);
-        env->SetLongField(lpServerStatistics, fid_deskrx, stats.nDesktopBytesRX);
-        env->SetLongField(lpServerStatistics, fid_uptm, stats.nUptimeMSec);
+        env->SetLongField(lpServerStatistics, fid_srvstats.totaltx, stats.nTotalBytesTX);
+        env->SetLongField(lpServerStatistics, fid_srvstats.totalrx, stats.nTotalBytesRX);
+        env->SetLongField(lpServerStatistics, fid_srvstats.voicetx, stats.nVoiceBytesTX);
+        env->SetLongField(lpServerStatistics, fid_srvstats.voicerx, stats.nVoiceBytesRX);
+        env->SetLongField(lpServerStatistics, fid_srvstats.videotx, stats.nVideoCaptureBytesTX);
+        env->SetLongField(lpServerStatistics, fid_srvstats.videorx, stats.nVideoCaptureBytesRX);
+        env->SetLongField(lpServerStatistics, fid_srvstats.mftx, stats.nMediaFileBytesTX);
+        env->SetLongField(lpServerStatistics, fid_srvstats.mfrx, stats.nMediaFileBytesRX);
+        env->SetLongField(lpServerStatistics, fid_srvstats.desktx, stats.nDesktopBytesTX);
+        env->SetLongField(lpServerStatistics, fid_srvstats.deskrx, stats.nDesktopBytesRX);
+        env->SetLongField(lpServerStatistics, fid_srvstats.uptm, stats.nUptimeMSec);
+        env->SetLongField(lpServerStatistics, fid_srvstats.vsuppress, stats.nVoiceFramesSuppressed);
     }
     else
     {
         ZERO_STRUCT(stats);
-        stats.nTotalBytesTX = env->GetLongField(lpServerStatistics, fid_totaltx);
-        stats.nTotalBytesRX = env->GetLongField(lpServerStatistics, fid_totalrx);
-        stats.nVoiceBytesTX = env->GetLongField(lpServerStatistics, fid_voicetx);
-        stats.nVoiceBytesRX = env->GetLongField(lpServerStatistics, fid_voicerx);
-        stats.nVideoCaptureBytesTX = env->GetLongField(lpServerStatistics, fid_videotx);
-        stats.nVideoCaptureBytesRX = env->GetLongField(lpServerStatistics, fid_videorx);
-        stats.nMediaFileBytesTX = env->GetLongField(lpServerStatistics, fid_mftx);
-        stats.nMediaFileBytesRX = env->GetLongField(lpServerStatistics, fid_mfrx);
-        stats.nDesktopBytesTX = env->GetLongField(lpServerStatistics, fid_desktx);
-        stats.nDesktopBytesRX = env->GetLongField(lpServerStatistics, fid_deskrx);
-        stats.nUptimeMSec = env->GetLongField(lpServerStatistics, fid_uptm);
+        stats.nTotalBytesTX = env->GetLongField(lpServerStatistics, fid_srvstats.totaltx);
+        stats.nTotalBytesRX = env->GetLongField(lpServerStatistics, fid_srvstats.totalrx);
+        stats.nVoiceBytesTX = env->GetLongField(lpServerStatistics, fid_srvstats.voicetx);
+        stats.nVoiceBytesRX = env->GetLongField(lpServerStatistics, fid_srvstats.voicerx);
+        stats.nVideoCaptureBytesTX = env->GetLongField(lpServerStatistics, fid_srvstats.videotx);
+        stats.nVideoCaptureBytesRX = env->GetLongField(lpServerStatistics, fid_srvstats.videorx);
+        stats.nMediaFileBytesTX = env->GetLongField(lpServerStatistics, fid_srvstats.mftx);
+        stats.nMediaFileBytesRX = env->GetLongField(lpServerStatistics, fid_srvstats.mfrx);
+        stats.nDesktopBytesTX = env->GetLongField(lpServerStatistics, fid_srvstats.desktx);
+        stats.nDesktopBytesRX = env->GetLongField(lpServerStatistics, fid_srvstats.deskrx);
+        stats.nUptimeMSec = env->GetLongField(lpServerStatistics, fid_srvstats.uptm);
+        stats.nVoiceFramesSuppressed = env->GetLongField(lpServerStatistics, fid_srvstats.vsuppress);
     }
 }
 
 void setRemoteFile(JNIEnv* env, RemoteFile& fileinfo, jobject lpRemoteFile, JConvert conv)
 {
-    jclass cls_finfo = env->GetObjectClass(lpRemoteFile);
-    
-    jfieldID fid_id = env->GetFieldID(cls_finfo, "nFileID", "I");
-    jfieldID fid_cid = env->GetFieldID(cls_finfo, "nChannelID", "I");
-    jfieldID fid_name = env->GetFieldID(cls_finfo, "szFileName", "Ljava/lang/String;");
-    jfieldID fid_size = env->GetFieldID(cls_finfo, "nFileSize", "J");
-    jfieldID fid_user = env->GetFieldID(cls_finfo, "szUsername", "Ljava/lang/String;");
-
-    assert(fid_id);
-    assert(fid_cid);
-    assert(fid_name);
-    assert(fid_size);
-    assert(fid_user);
-
     if(conv == N2J) {
-        env->SetIntField(lpRemoteFile, fid_id, fileinfo.nFileID);
-        env->SetIntField(lpRemoteFile, fid_cid, fileinfo.nChannelID);
-        env->SetObjectField(lpRemoteFile, fid_name, NEW_JSTRING(env, fileinfo.szFileName));
-        env->SetLongField(lpRemoteFile, fid_size, fileinfo.nFileSize);
-        env->SetObjectField(lpRemoteFile, fid_user, NEW_JSTRING(env, fileinfo.szUsername));
+        env->SetIntField(lpRemoteFile, fid_rfile.id, fileinfo.nFileID);
+        env->SetIntField(lpRemoteFile, fid_rfile.cid, fileinfo.nChannelID);
+        env->SetObjectField(lpRemoteFile, fid_rfile.name, NEW_JSTRING(env, fileinfo.szFileName));
+        env->SetLongField(lpRemoteFile, fid_rfile.size, fileinfo.nFileSize);
+        env->SetObjectField(lpRemoteFile, fid_rfile.user, NEW_JSTRING(env, fileinfo.szUsername));
     }
     else {
         ZERO_STRUCT(fileinfo);
-        fileinfo.nFileID = env->GetIntField(lpRemoteFile, fid_id);
-        fileinfo.nChannelID = env->GetIntField(lpRemoteFile, fid_cid);
-        TT_STRCPY(fileinfo.szFileName, ttstr(env, (jstring)env->GetObjectField(lpRemoteFile, fid_name)));
-        fileinfo.nFileSize = env->GetLongField(lpRemoteFile, fid_size);
-        TT_STRCPY(fileinfo.szUsername, ttstr(env, (jstring)env->GetObjectField(lpRemoteFile, fid_user)));
+        fileinfo.nFileID = env->GetIntField(lpRemoteFile, fid_rfile.id);
+        fileinfo.nChannelID = env->GetIntField(lpRemoteFile, fid_rfile.cid);
+        TT_STRCPY(fileinfo.szFileName, ttstr(env, (jstring)env->GetObjectField(lpRemoteFile, fid_rfile.name)));
+        fileinfo.nFileSize = env->GetLongField(lpRemoteFile, fid_rfile.size);
+        TT_STRCPY(fileinfo.szUsername, ttstr(env, (jstring)env->GetObjectField(lpRemoteFile, fid_rfile.user)));
     }
 }
 
 void setUserStatistics(JNIEnv* env, const UserStatistics& stats, jobject lpUserStatistics)
 {
-    jclass cls_stats = env->GetObjectClass(lpUserStatistics);
-    
-    jfieldID fid_voirx = env->GetFieldID(cls_stats, "nVoicePacketsRecv", "J");
-    jfieldID fid_voilost = env->GetFieldID(cls_stats, "nVoicePacketsLost", "J");
-    jfieldID fid_vidrx = env->GetFieldID(cls_stats, "nVideoCapturePacketsRecv", "J");
-    jfieldID fid_vidftx = env->GetFieldID(cls_stats, "nVideoCaptureFramesRecv", "J");
-    jfieldID fid_vidflost = env->GetFieldID(cls_stats, "nVideoCaptureFramesLost", "J");
-    jfieldID fid_vidfdropped = env->GetFieldID(cls_stats, "nVideoCaptureFramesDropped", "J");
-
-    jfieldID fid_mfaudrx = env->GetFieldID(cls_stats, "nMediaFileAudioPacketsRecv", "J");
-    jfieldID fid_mfaudlost = env->GetFieldID(cls_stats, "nMediaFileAudioPacketsLost", "J");
-    jfieldID fid_mfvidrx = env->GetFieldID(cls_stats, "nMediaFileVideoPacketsRecv", "J");
-    jfieldID fid_mfvidftx = env->GetFieldID(cls_stats, "nMediaFileVideoFramesRecv", "J");
-    jfieldID fid_mfvidflost = env->GetFieldID(cls_stats, "nMediaFileVideoFramesLost", "J");
-    jfieldID fid_mfvidfdropped = env->GetFieldID(cls_stats, "nMediaFileVideoFramesDropped", "J");
-
-    assert(fid_voirx);
-    assert(fid_voilost);
-    assert(fid_vidrx);
-    assert(fid_vidftx);
-    assert(fid_vidflost);
-    assert(fid_vidfdropped);
-    assert(fid_mfaudrx);
-    assert(fid_mfaudlost);
-    assert(fid_mfvidrx);
-    assert(fid_mfvidftx);
-    assert(fid_mfvidflost);
-    assert(fid_mfvidfdropped);
-
-    env->SetLongField(lpUserStatistics, fid_voirx, stats.nVoicePacketsRecv);
-    env->SetLongField(lpUserStatistics, fid_voilost, stats.nVoicePacketsLost);
-    env->SetLongField(lpUserStatistics, fid_vidrx, stats.nVideoCapturePacketsRecv);
-    env->SetLongField(lpUserStatistics, fid_vidftx, stats.nVideoCaptureFramesRecv);
-    env->SetLongField(lpUserStatistics, fid_vidflost, stats.nVideoCaptureFramesLost);
-    env->SetLongField(lpUserStatistics, fid_vidfdropped, stats.nVideoCaptureFramesDropped);
-    env->SetLongField(lpUserStatistics, fid_mfaudrx, stats.nMediaFileAudioPacketsRecv);
-    env->SetLongField(lpUserStatistics, fid_mfaudlost, stats.nMediaFileAudioPacketsLost);
-    env->SetLongField(lpUserStatistics, fid_mfvidrx, stats.nMediaFileVideoPacketsRecv);
-    env->SetLongField(lpUserStatistics, fid_mfvidftx, stats.nMediaFileVideoFramesRecv);
-    env->SetLongField(lpUserStatistics, fid_mfvidflost, stats.nMediaFileVideoFramesLost);
-    env->SetLongField(lpUserStatistics, fid_mfvidfdropped, stats.nMediaFileVideoFramesDropped);
+    env->SetLongField(lpUserStatistics, fid_usrstats.voirx, stats.nVoicePacketsRecv);
+    env->SetLongField(lpUserStatistics, fid_usrstats.voilost, stats.nVoicePacketsLost);
+    env->SetLongField(lpUserStatistics, fid_usrstats.vidrx, stats.nVideoCapturePacketsRecv);
+    env->SetLongField(lpUserStatistics, fid_usrstats.vidftx, stats.nVideoCaptureFramesRecv);
+    env->SetLongField(lpUserStatistics, fid_usrstats.vidflost, stats.nVideoCaptureFramesLost);
+    env->SetLongField(lpUserStatistics, fid_usrstats.vidfdropped, stats.nVideoCaptureFramesDropped);
+    env->SetLongField(lpUserStatistics, fid_usrstats.mfaudrx, stats.nMediaFileAudioPacketsRecv);
+    env->SetLongField(lpUserStatistics, fid_usrstats.mfaudlost, stats.nMediaFileAudioPacketsLost);
+    env->SetLongField(lpUserStatistics, fid_usrstats.mfvidrx, stats.nMediaFileVideoPacketsRecv);
+    env->SetLongField(lpUserStatistics, fid_usrstats.mfvidftx, stats.nMediaFileVideoFramesRecv);
+    env->SetLongField(lpUserStatistics, fid_usrstats.mfvidflost, stats.nMediaFileVideoFramesLost);
+    env->SetLongField(lpUserStatistics, fid_usrstats.mfvidfdropped, stats.nMediaFileVideoFramesDropped);
+    env->SetLongField(lpUserStatistics, fid_usrstats.voilate, stats.nVoicePacketsLate);
+    env->SetLongField(lpUserStatistics, fid_usrstats.voiconceal, stats.nVoiceFramesConcealed);
+    env->SetLongField(lpUserStatistics, fid_usrstats.mfaudlate, stats.nMediaFileAudioPacketsLate);
+    env->SetLongField(lpUserStatistics, fid_usrstats.mfaudconceal, stats.nMediaFileAudioFramesConcealed);
+    env->SetIntField(lpUserStatistics, fid_usrstats.voijitter, stats.nVoiceJitterMSec);
+    env->SetIntField(lpUserStatistics, fid_usrstats.mfaudjitter, stats.nMediaFileAudioJitterMSec);
+    env->SetLongField(lpUserStatistics, fid_usrstats.vidfskipped, stats.nVideoCaptureFramesSkipped);
+    env->SetLongField(lpUserStatistics, fid_usrstats.mfvidfskipped, stats.nMediaFileVideoFramesSkipped);
 }
 
 void setFileTransfer(JNIEnv* env, const FileTransfer& filetx, jobject lpFileTransfer)
 {
-    jclass cls_ftx = env->GetObjectClass(lpFileTransfer);
-
-    jfieldID fid_status = env->GetFieldID(cls_ftx, "nStatus", "I");
-    jfieldID fid_txid = env->GetFieldID(cls_ftx, "nTransferID", "I");
-    jfieldID fid_chanid = env->GetFieldID(cls_ftx, "nChannelID", "I");
-    jfieldID fid_filepath = env->GetFieldID(cls_ftx, "szLocalFilePath", "Ljava/lang/String;");
-    jfieldID fid_rempath = env->GetFieldID(cls_ftx, "szRemoteFileName", "Ljava/lang/String;");
-    jfieldID fid_size = env->GetFieldID(cls_ftx, "nFileSize", "J");
-    jfieldID fid_txed = env->GetFieldID(cls_ftx, "nTransferred", "J");
-    jfieldID fid_inbound = env->GetFieldID(cls_ftx, "bInbound", "Z");
-
-    assert(fid_status);
-    assert(fid_txid);
-    assert(fid_chanid);
-    assert(fid_filepath);
-    assert(fid_rempath);
-    assert(fid_size);
-    assert(fid_txed);
-    assert(fid_inbound);
-
-    env->SetIntField(lpFileTransfer, fid_status, filetx.nStatus);
-    env->SetIntField(lpFileTransfer, fid_txid, filetx.nTransferID);
-    env->SetIntField(lpFileTransfer, fid_chanid, filetx.nChannelID);
-    env->SetObjectField(lpFileTransfer, fid_filepath, NEW_JSTRING(env, filetx.szLocalFilePath));
-    env->SetObjectField(lpFileTransfer, fid_rempath, NEW_JSTRING(env, filetx.szRemoteFileName));
-    env->SetLongField(lpFileTransfer, fid_size, filetx.nFileSize);
-    env->SetLongField(lpFileTransfer, fid_txed, filetx.nTransferred);
-    env->SetBooleanField(lpFileTransfer, fid_inbound, filetx.bInbound);
+    env->SetIntField(lpFileTransfer, fid_filetx.status, filetx.nStatus);
+    env->SetIntField(lpFileTransfer, fid_filetx.txid, filetx.nTransferID);
+    env->SetIntField(lpFileTransfer, fid_filetx.chanid, filetx.nChannelID);
+    env->SetObjectField(lpFileTransfer, fid_filetx.filepath, NEW_JSTRING(env, filetx.szLocalFilePath));
+    env->SetObjectField(lpFileTransfer, fid_filetx.rempath, NEW_JSTRING(env, filetx.szRemoteFileName));
+    env->SetLongField(lpFileTransfer, fid_filetx.size, filetx.nFileSize);
+    env->SetLongField(lpFileTransfer, fid_filetx.txed, filetx.nTransferred);
+    env->SetBooleanField(lpFileTransfer, fid_filetx.inbound, filetx.bInbound);
 }
 
 void setBannedUser(JNIEnv* env, BannedUser& banned, jobject lpBannedUser, JConvert conv)
 {
-   jclass cls_ban = env->GetObjectClass(lpBannedUser);
-
-   jfieldID fid_ipaddr = env->GetFieldID(cls_ban, "szIPAddress", "Ljava/lang/String;");
-   jfieldID fid_chan = env->GetFieldID(cls_ban, "szChannelPath", "Ljava/lang/String;");
-   jfieldID fid_time = env->GetFieldID(cls_ban, "szBanTime", "Ljava/lang/String;");
-   jfieldID fid_nick = env->GetFieldID(cls_ban, "szNickname", "Ljava/lang/String;");
-   jfieldID fid_username = env->GetFieldID(cls_ban, "szUsername", "Ljava/lang/String;");
-   jfieldID fid_bantype = env->GetFieldID(cls_ban, "uBanTypes", "I");
-
-   assert(fid_ipaddr);
-   assert(fid_chan);
-   assert(fid_time);
-   assert(fid_nick);
-   assert(fid_username);
-   assert(fid_bantype);
-
    if (conv == N2J)
    {
-       env->SetObjectField(lpBannedUser, fid_ipaddr, NEW_JSTRING(env, banned.szIPAddress));
-       env->SetObjectField(lpBannedUser, fid_chan, NEW_JSTRING(env, banned.szChannelPath));
-       env->SetObjectField(lpBannedUser, fid_time, NEW_JSTRING(env, banned.szBanTime));
-       env->SetObjectField(lpBannedUser, fid_nick, NEW_JSTRING(env, banned.szNickname));
-       env->SetObjectField(lpBannedUser, fid_username, NEW_JSTRING(env, banned.szUsername));
-       env->SetIntField(lpBannedUser, fid_bantype, banned.uBanTypes);
+       env->SetObjectField(lpBannedUser, fid_ban.ipaddr, NEW_JSTRING(env, banned.szIPAddress));
+       env->SetObjectField(lpBannedUser, fid_ban.chan, NEW_JSTRING(env, banned.szChannelPath));
+       env->SetObjectField(lpBannedUser, fid_ban.time, NEW_JSTRING(env, banned.szBanTime));
+       env->SetObjectField(lpBannedUser, fid_ban.nick, NEW_JSTRING(env, banned.szNickname));
+       env->SetObjectField(lpBannedUser, fid_ban.username, NEW_JSTRING(env, banned.szUsername));
+       env->SetIntField(lpBannedUser, fid_ban.bantype, banned.uBanTypes);
    }
    else
    {
        ZERO_STRUCT(banned);
-       TT_STRCPY(banned.szIPAddress, ttstr(env, (jstring)env->GetObjectField(lpBannedUser, fid_ipaddr)));
-       TT_STRCPY(banned.szChannelPath, ttstr(env, (jstring)env->GetObjectField(lpBannedUser, fid_chan)));
-       TT_STRCPY(banned.szBanTime, ttstr(env, (jstring)env->GetObjectField(lpBannedUser, fid_time)));
-       TT_STRCPY(banned.szNickname, ttstr(env, (jstring)env->GetObjectField(lpBannedUser, fid_nick)));
-       TT_STRCPY(banned.szUsername, ttstr(env, (jstring)env->GetObjectField(lpBannedUser, fid_username)));
-       banned.uBanTypes = env->GetIntField(lpBannedUser, fid_bantype);
+       TT_STRCPY(banned.szIPAddress, ttstr(env, (jstring)env->GetObjectField(lpBannedUser, fid_ban.ipaddr)));
+       TT_STRCPY(banned.szChannelPath, ttstr(env, (jstring)env->GetObjectField(lpBannedUser, fid_ban.chan)));
+       TT_STRCPY(banned.szBanTime, ttstr(env, (jstring)env->GetObjectField(lpBannedUser, fid_ban.time)));
+       TT_STRCPY(banned.szNickname, ttstr(env, (jstring)env->GetObjectField(lpBannedUser, fid_ban.nick)));
+       TT_STRCPY(banned.szUsername, ttstr(env, (jstring)env->GetObjectField(lpBannedUser, fid_ban.username)));
+       banned.uBanTypes = env->GetIntField(lpBannedUser, fid_ban.bantype);
    }
 }
 
 void setClientErrorMsg(JNIEnv* env, ClientErrorMsg& cemsg, jobject lpClientErrorMsg, JConvert conv)
 {
-   jclass cls_msg = env->GetObjectClass(lpClientErrorMsg);
-
-   jfieldID fid_err = env->GetFieldID(cls_msg, "nErrorNo", "I");
-   jfieldID fid_msg = env->GetFieldID(cls_msg, "szErrorMsg", "Ljava/lang/String;");
-
-   assert(fid_err);
-   assert(fid_msg);
-
    if(conv == N2J)
    {
-       env->SetIntField(lpClientErrorMsg, fid_err, cemsg.nErrorNo);
-       env->SetObjectField(lpClientErrorMsg, fid_msg, NEW_JSTRING(env, cemsg.szErrorMsg));
+       env->SetIntField(lpClientErrorMsg, fid_cemsg.err, cemsg.nErrorNo);
+       env->SetObjectField(lpClientErrorMsg, fid_cemsg.msg, NEW_JSTRING(env, cemsg.szErrorMsg));
    }
    else
    {
        ZERO_STRUCT(cemsg);
-       cemsg.nErrorNo = env->GetIntField(lpClientErrorMsg, fid_err);
-       TT_STRCPY(cemsg.szErrorMsg, ttstr(env, (jstring)env->GetObjectField(lpClientErrorMsg, fid_msg)));
+       cemsg.nErrorNo = env->GetIntField(lpClientErrorMsg, fid_cemsg.err);
+       TT_STRCPY(cemsg.szErrorMsg, ttstr(env, (jstring)env->GetObjectField(lpClientErrorMsg, fid_cemsg.msg)));
    }
 }
 
 void setDesktopInput(JNIEnv* env, DesktopInput& input, jobject lpDesktopInput, JConvert conv)
 {
-   jclass cls = env->GetObjectClass(lpDesktopInput);
-
-   jfieldID fid_x = env->GetFieldID(cls, "uMousePosX", "I");
-   jfieldID fid_y = env->GetFieldID(cls, "uMousePosY", "I");
-   jfieldID fid_keycode = env->GetFieldID(cls, "uKeyCode", "I");
-   jfieldID fid_keystate = env->GetFieldID(cls, "uKeyState", "I");
-
-   assert(fid_x);
-   assert(fid_y);
-   assert(fid_keycode);
-   assert(fid_keystate);
-
    if(conv == N2J)
    {
-       env->SetIntField(lpDesktopInput, fid_x, input.uMousePosX);
-       env->SetIntField(lpDesktopInput, fid_y, input.uMousePosY);
-       env->SetIntField(lpDesktopInput, fid_keycode, input.uKeyCode);
-       env->SetIntField(lpDesktopInput, fid_keystate, input.uKeyState);
+       env->SetIntField(lpDesktopInput, fid_deskinput.x, input.uMousePosX);
+       env->SetIntField(lpDesktopInput, fid_deskinput.y, input.uMousePosY);
+       env->SetIntField(lpDesktopInput, fid_deskinput.keycode, input.uKeyCode);
+       env->SetIntField(lpDesktopInput, fid_deskinput.keystate, input.uKeyState);
    }
    else
    {
        ZERO_STRUCT(input);
-       input.uMousePosX = (UINT16)env->GetIntField(lpDesktopInput, fid_x);
-       input.uMousePosY = (UINT16)env->GetIntField(lpDesktopInput, fid_y);
-       input.uKeyCode = env->GetIntField(lpDesktopInput, fid_keycode);
-       input.uKeyState = env->GetIntField(lpDesktopInput, fid_keystate);
+       input.uMousePosX = (UINT16)env->GetIntField(lpDesktopInput, fid_deskinput.x);
+       input.uMousePosY = (UINT16)env->GetIntField(lpDesktopInput, fid_deskinput.y);
+       input.uKeyCode = env->GetIntField(lpDesktopInput, fid_deskinput.keycode);
+       input.uKeyState = env->GetIntField(lpDesktopInput, fid_deskinput.keystate);
    }
 }
 
-void setDesktopWindow(JNIEnv* env, DesktopWindow& deskwnd, jobject lpDesktopWindow, JConvert conv)
+void setDesktopRegion(JNIEnv* env, DesktopRegion& region, jobject lpDesktopRegion, JConvert conv)
 {
-   jclass cls = env->GetObjectClass(lpDesktopWindow);
+   jclass cls = env->GetObjectClass(lpDesktopRegion);
 
+   jfieldID fid_x = env->GetFieldID(cls, "nX", "I");
+   jfieldID fid_y = env->GetFieldID(cls, "nY", "I");
    jfieldID fid_w = env->GetFieldID(cls, "nWidth", "I");
    jfieldID fid_h = env->GetFieldID(cls, "nHeight", "I");
-   jfieldID fid_bmpfmt = env->GetFieldID(cls, "bmpFormat", "I");
-   jfieldID fid_bpl = env->GetFieldID(cls, "nBytesPerLine", "I");
-   jfieldID fid_sesid = env->GetFieldID(cls, "nSessionID", "I");
-   jfieldID fid_frmbuf = env->GetFieldID(cls, "frameBuffer", "[B");
 
+   assert(fid_x);
+   assert(fid_y);
    assert(fid_w);
    assert(fid_h);
-   assert(fid_bmpfmt);
-   assert(fid_bpl);
-   assert(fid_sesid);
-   assert(fid_frmbuf);
 
    if(conv == N2J)
    {
+       env->SetIntField(lpDesktopRegion, fid_x, region.nX);
+       env->SetIntField(lpDesktopRegion, fid_y, region.nY);
+       env->SetIntField(lpDesktopRegion, fid_w, region.nWidth);
+       env->SetIntField(lpDesktopRegion, fid_h, region.nHeight);
+   }
+   else
+   {
+       ZERO_STRUCT(region);
+       region.nX = env->GetIntField(lpDesktopRegion, fid_x);
+       region.nY = env->GetIntField(lpDesktopRegion, fid_y);
+       region.nWidth = env->GetIntField(lpDesktopRegion, fid_w);
+       region.nHeight = env->GetIntField(lpDesktopRegion, fid_h);
+   }
+}
 
-       jbyteArray buf = env->NewByteArray(deskwnd.nFrameBufferSize);
-       jbyte* bufptr = env->GetByteArrayElements(buf, 0);
-       if(!bufptr)
-           return;
-
-       memcpy(bufptr, deskwnd.frameBuffer, deskwnd.nFrameBufferSize);
-       env->ReleaseByteArrayElements(buf, bufptr, 0);
-
-       env->SetIntField(lpDesktopWindow, fid_w, deskwnd.nWidth);
-       env->SetIntField(lpDesktopWindow, fid_h, deskwnd.nHeight);
-       env->SetIntField(lpDesktopWindow, fid_bmpfmt, deskwnd.bmpFormat);
-       env->SetIntField(lpDesktopWindow, fid_bpl, deskwnd.nBytesPerLine);
-       env->SetIntField(lpDesktopWindow, fid_sesid, deskwnd.nSessionID);
-       env->SetObjectField(lpDesktopWindow, fid_frmbuf, buf);
+bool setDesktopWindow(JNIEnv* env, DesktopWindow& deskwnd, jobject lpDesktopWindow, JConvert conv, bool bDirect)
+{
+   if(conv == N2J)
+   {
+       if(bDirect)
+       {
+           jobject buf = env->NewDirectByteBuffer(deskwnd.frameBuffer, deskwnd.nFrameBufferSize);
+           if(!buf)
+               return false;
+           env->SetObjectField(lpDesktopWindow, fid_deskwnd.directbuf, buf);
+           env->SetLongField(lpDesktopWindow, fid_deskwnd.nativeptr, reinterpret_cast<jlong>(&deskwnd));
+       }
+       else
+       {
+           jbyteArray buf = env->NewByteArray(deskwnd.nFrameBufferSize);
+           if(!buf)
+               return false;
+           env->SetByteArrayRegion(buf, 0, deskwnd.nFrameBufferSize,
+                                   static_cast<const jbyte*>(deskwnd.frameBuffer));
+           env->SetObjectField(lpDesktopWindow, fid_deskwnd.frmbuf, buf);
+       }
+
+       env->SetIntField(lpDesktopWindow, fid_deskwnd.w, deskwnd.nWidth);
+       env->SetIntField(lpDesktopWindow, fid_deskwnd.h, deskwnd.nHeight);
+       env->SetIntField(lpDesktopWindow, fid_deskwnd.bmpfmt, deskwnd.bmpFormat);
+       env->SetIntField(lpDesktopWindow, fid_deskwnd.bpl, deskwnd.nBytesPerLine);
+       env->SetIntField(lpDesktopWindow, fid_deskwnd.sesid, deskwnd.nSessionID);
    }
    else
    {
        ZERO_STRUCT(deskwnd);
-       deskwnd.nWidth = env->GetIntField(lpDesktopWindow, fid_w);
-       deskwnd.nHeight = env->GetIntField(lpDesktopWindow, fid_h);
-       deskwnd.bmpFormat = (BitmapFormat)env->GetIntField(lpDesktopWindow, fid_bmpfmt);
-       deskwnd.nBytesPerLine = env->GetIntField(lpDesktopWindow, fid_bpl);
-       deskwnd.nSessionID = env->GetIntField(lpDesktopWindow, fid_sesid);
+       deskwnd.nWidth = env->GetIntField(lpDesktopWindow, fid_deskwnd.w);
+       deskwnd.nHeight = env->GetIntField(lpDesktopWindow, fid_deskwnd.h);
+       deskwnd.bmpFormat = (BitmapFormat)env->GetIntField(lpDesktopWindow, fid_deskwnd.bmpfmt);
+       deskwnd.nBytesPerLine = env->GetIntField(lpDesktopWindow, fid_deskwnd.bpl);
+       deskwnd.nSessionID = env->GetIntField(lpDesktopWindow, fid_deskwnd.sesid);
    }
+   return true;
 }
 
-void setVideoFrame(JNIEnv* env, VideoFrame& vidframe, jobject lpVideoFrame)
+bool setVideoFrame(JNIEnv* env, VideoFrame& vidframe, jobject lpVideoFrame, bool bDirect)
 {
-   jclass cls = env->GetObjectClass(lpVideoFrame);
-
-   jfieldID fid_w = env->GetFieldID(cls, "nWidth", "I");
-   jfieldID fid_h = env->GetFieldID(cls, "nHeight", "I");
-   jfieldID fid_sid = env->GetFieldID(cls, "nStreamID", "I");
-   jfieldID fid_kfrm = env->GetFieldID(cls, "bKeyFrame", "Z");
-   jfieldID fid_frmbuf = env->GetFieldID(cls, "frameBuffer", "[B");
+   if(bDirect)
+   {
+       jobject buf = env->NewDirectByteBuffer(vidframe.frameBuffer, vidframe.nFrameBufferSize);
+       if(!buf)
+           return false;
+       env->SetObjectField(lpVideoFrame, fid_vidframe.directbuf, buf);
+       env->SetLongField(lpVideoFrame, fid_vidframe.nativeptr, reinterpret_cast<jlong>(&vidframe));
+   }
+   else
+   {
+       jbyteArray buf = env->NewByteArray(vidframe.nFrameBufferSize);
+       if(!buf)
+           return false;
+       env->SetByteArrayRegion(buf, 0, vidframe.nFrameBufferSize,
+                               static_cast<const jbyte*>(vidframe.frameBuffer));
+       env->SetObjectField(lpVideoFrame, fid_vidframe.frmbuf, buf);
+   }
 
-   assert(fid_w);
-   assert(fid_h);
-   assert(fid_sid);
-   assert(fid_kfrm);
-   assert(fid_frmbuf);
-
-   jbyteArray buf = env->NewByteArray(vidframe.nFrameBufferSize);
-   jbyte* bufptr = env->GetByteArrayElements(buf, 0);
-   if(!bufptr)
-       return;
-
-   memcpy(bufptr, vidframe.frameBuffer, vidframe.nFrameBufferSize);
-   env->ReleaseByteArrayElements(buf, bufptr, 0);
-
-   env->SetIntField(lpVideoFrame, fid_w, vidframe.nWidth);
-   env->SetIntField(lpVideoFrame, fid_h, vidframe.nHeight);
-   env->SetIntField(lpVideoFrame, fid_sid, vidframe.nStreamID);
-   env->SetBooleanField(lpVideoFrame, fid_kfrm, vidframe.bKeyFrame);
-   env->SetObjectField(lpVideoFrame, fid_frmbuf, buf);
+   env->SetIntField(lpVideoFrame, fid_vidframe.w, vidframe.nWidth);
+   env->SetIntField(lpVideoFrame, fid_vidframe.h, vidframe.nHeight);
+   env->SetIntField(lpVideoFrame, fid_vidframe.sid, vidframe.nStreamID);
+   env->SetBooleanField(lpVideoFrame, fid_vidframe.kfrm, vidframe.bKeyFrame);
+   return true;
 }
 
-void setAudioBlock(JNIEnv* env, AudioBlock& audblock, jobject lpAudioBlock)
+bool setAudioBlock(JNIEnv* env, AudioBlock& audblock, jobject lpAudioBlock, bool bDirect)
 {
-    jclass cls = env->GetObjectClass(lpAudioBlock);
-
-    jfieldID fid_sid = env->GetFieldID(cls, "nStreamID", "I");
-    jfieldID fid_sr = env->GetFieldID(cls, "nSampleRate", "I");
-    jfieldID fid_ch = env->GetFieldID(cls, "nChannels", "I");
-    jfieldID fid_audbuf = env->GetFieldID(cls, "lpRawAudio", "[B");
-    jfieldID fid_sn = env->GetFieldID(cls, "nSamples", "I");
-    jfieldID fid_si = env->GetFieldID(cls, "uSampleIndex", "I");
-
-    assert(fid_sid);
-    assert(fid_sr);
-    assert(fid_ch);
-    assert(fid_audbuf);
-    assert(fid_sn);
-    assert(fid_si);
-
     int size = audblock.nSamples * sizeof(short) * audblock.nChannels;
-    jbyteArray buf = env->NewByteArray(size);
-    jbyte* bufptr = env->GetByteArrayElements(buf, 0);
-    if(!bufptr)
-        return;
-    memcpy(bufptr, audblock.lpRawAudio, size);
-    env->ReleaseByteArrayElements(buf, bufptr, 0);
-
-    env->SetIntField(lpAudioBlock, fid_sid, audblock.nStreamID);
-    env->SetIntField(lpAudioBlock, fid_sr, audblock.nSampleRate);
-    env->SetIntField(lpAudioBlock, fid_ch, audblock.nChannels);
-    env->SetObjectField(lpAudioBlock, fid_audbuf, buf);
-    env->SetIntField(lpAudioBlock, fid_sn, audblock.nSamples);
-    env->SetIntField(lpAudioBlock, fid_si, audblock.uSampleIndex);
+    if(bDirect)
+    {
+        jobject buf = env->NewDirectByteBuffer(audblock.lpRawAudio, size);
+        if(!buf)
+            return false;
+        env->SetObjectField(lpAudioBlock, fid_audblock.directbuf, buf);
+        env->SetLongField(lpAudioBlock, fid_audblock.nativeptr, reinterpret_cast<jlong>(&audblock));
+    }
+    else
+    {
+        jbyteArray buf = env->NewByteArray(size);
+        if(!buf)
+            return false;
+        env->SetByteArrayRegion(buf, 0, size, static_cast<const jbyte*>(audblock.lpRawAudio));
+        env->SetObjectField(lpAudioBlock, fid_audblock.audbuf, buf);
+    }
+
+    env->SetIntField(lpAudioBlock, fid_audblock.sid, audblock.nStreamID);
+    env->SetIntField(lpAudioBlock, fid_audblock.sr, audblock.nSampleRate);
+    env->SetIntField(lpAudioBlock, fid_audblock.ch, audblock.nChannels);
+    env->SetIntField(lpAudioBlock, fid_audblock.sn, audblock.nSamples);
+    env->SetIntField(lpAudioBlock, fid_audblock.si, audblock.uSampleIndex);
+    return true;
 }
 
-void setMediaFileInfo(JNIEnv* env, MediaFileInfo& mfi, jobject lpMediaFileInfo)
+// The direct buffer is cleared so the Java object no longer refers
+// to memory which is about to be released.
+DesktopWindow* detachDesktopWindow(JNIEnv* env, jobject lpDesktopWindow)
 {
-   jclass cls = env->GetObjectClass(lpMediaFileInfo);
+    jlong ptr = env->GetLongField(lpDesktopWindow, fid_deskwnd.nativeptr);
+    env->SetLongField(lpDesktopWindow, fid_deskwnd.nativeptr, 0);
+    env->SetObjectField(lpDesktopWindow, fid_deskwnd.directbuf, NULL);
+    return reinterpret_cast<DesktopWindow*>(ptr);
+}
 
-   jfieldID fid_status = env->GetFieldID(cls, "nStatus", "I");
-   jfieldID fid_fname = env->GetFieldID(cls, "szFileName", "Ljava/lang/String;");
-   jfieldID fid_audfmt = env->GetFieldID(cls, "audioFmt", "Ldk/bearware/AudioFormat;");
-   jfieldID fid_vidfmt = env->GetFieldID(cls, "videoFmt", "Ldk/bearware/VideoFormat;");
-   jfieldID fid_dur = env->GetFieldID(cls, "uDurationMSec", "I");
+VideoFrame* detachVideoFrame(JNIEnv* env, jobject lpVideoFrame)
+{
+    jlong ptr = env->GetLongField(lpVideoFrame, fid_vidframe.nativeptr);
+    env->SetLongField(lpVideoFrame, fid_vidframe.nativeptr, 0);
+    env->SetObjectField(lpVideoFrame, fid_vidframe.directbuf, NULL);
+    return reinterpret_cast<VideoFrame*>(ptr);
+}
 
-   assert(fid_status);
-   assert(fid_fname);
-   assert(fid_audfmt);
-   assert(fid_vidfmt);
-   assert(fid_dur);
+AudioBlock* detachAudioBlock(JNIEnv* env, jobject lpAudioBlock)
+{
+    jlong ptr = env->GetLongField(lpAudioBlock, fid_audblock.nativeptr);
+    env->SetLongField(lpAudioBlock, fid_audblock.nativeptr, 0);
+    env->SetObjectField(lpAudioBlock, fid_audblock.directbuf, NULL);
+    return reinterpret_cast<AudioBlock*>(ptr);
+}
 
-   env->SetIntField(lpMediaFileInfo, fid_status, mfi.nStatus);
-   env->SetObjectField(lpMediaFileInfo, fid_fname, NEW_JSTRING(env, mfi.szFileName));
+void setMediaFileInfo(JNIEnv* env, MediaFileInfo& mfi, jobject lpMediaFileInfo)
+{
+   env->SetIntField(lpMediaFileInfo, fid_mfi.status, mfi.nStatus);
+   env->SetObjectField(lpMediaFileInfo, fid_mfi.fname, NEW_JSTRING(env, mfi.szFileName));
    
-   jclass cls_audfmt = env->FindClass("dk/bearware/AudioFormat");
-   jclass cls_vidfmt = env->FindClass("dk/bearware/VideoFormat");
-   jobject audfmt_obj = newObject(env, cls_audfmt);
-   jobject vidfmt_obj = newObject(env, cls_vidfmt);
+   jobject audfmt_obj = newObject(env, JCLS_AUDIOFORMAT);
+   jobject vidfmt_obj = newObject(env, JCLS_VIDEOFORMAT);
    setAudioFormat(env, mfi.audioFmt, audfmt_obj);
    setVideoFormat(env, mfi.videoFmt, vidfmt_obj, N2J);
-   env->SetObjectField(lpMediaFileInfo, fid_audfmt, audfmt_obj);
-   env->SetObjectField(lpMediaFileInfo, fid_vidfmt, vidfmt_obj);
-   env->SetIntField(lpMediaFileInfo, fid_dur, mfi.uDurationMSec);
+   env->SetObjectField(lpMediaFileInfo, fid_mfi.audfmt, audfmt_obj);
+   env->SetObjectField(lpMediaFileInfo, fid_mfi.vidfmt, vidfmt_obj);
+   env->SetIntField(lpMediaFileInfo, fid_mfi.dur, mfi.uDurationMSec);
 }
 
 void setAudioFormat(JNIEnv* env, const AudioFormat& fmt, jobject lpAudioFormat)
 {
-    jclass cls = env->GetObjectClass(lpAudioFormat);
-    jfieldID fid_audfmt = env->GetFieldID(cls, "nAudioFmt", "I");
-    jfieldID fid_sr = env->GetFieldID(cls, "nSampleRate", "I");
-    jfieldID fid_ch = env->GetFieldID(cls, "nChannels", "I");
-    
-    assert(fid_audfmt);
-    assert(fid_sr);
-    assert(fid_ch);
-
-    env->SetIntField(lpAudioFormat, fid_audfmt, fmt.nAudioFmt);
-    env->SetIntField(lpAudioFormat, fid_sr, fmt.nSampleRate);
-    env->SetIntField(lpAudioFormat, fid_ch, fmt.nChannels);
+    env->SetIntField(lpAudioFormat, fid_audiofmt.audfmt, fmt.nAudioFmt);
+    env->SetIntField(lpAudioFormat, fid_audiofmt.sr, fmt.nSampleRate);
+    env->SetIntField(lpAudioFormat, fid_audiofmt.ch, fmt.nChannels);
 }
 
 void setVideoFormat(JNIEnv* env, VideoFormat& fmt, jobject lpVideoFormat, JConvert conv)
 {
-    jclass cls = env->GetObjectClass(lpVideoFormat);
-    jfieldID fid_w = env->GetFieldID(cls, "nWidth", "I");
-    jfieldID fid_h = env->GetFieldID(cls, "nHeight", "I");
-    jfieldID fid_fpsN = env->GetFieldID(cls, "nFPS_Numerator", "I");
-    jfieldID fid_fpsD = env->GetFieldID(cls, "nFPS_Denominator", "I");
-    jfieldID fid_fcc = env->GetFieldID(cls, "picFourCC", "I");
-    
-    assert(fid_w);
-    assert(fid_h);
-    assert(fid_fpsN);
-    assert(fid_fpsD);
-    assert(fid_fcc);
-
     if(conv == N2J)
     {
-        env->SetIntField(lpVideoFormat, fid_w, fmt.nWidth);
-        env->SetIntField(lpVideoFormat, fid_h, fmt.nHeight);
-        env->SetIntField(lpVideoFormat, fid_fpsN, fmt.nFPS_Numerator);
-        env->SetIntField(lpVideoFormat, fid_fpsD, fmt.nFPS_Denominator);
-        env->SetIntField(lpVideoFormat, fid_fcc, fmt.picFourCC);
+        env->SetIntField(lpVideoFormat, fid_videofmt.w, fmt.nWidth);
+        env->SetIntField(lpVideoFormat, fid_videofmt.h, fmt.nHeight);
+        env->SetIntField(lpVideoFormat, fid_videofmt.fpsN, fmt.nFPS_Numerator);
+        env->SetIntField(lpVideoFormat, fid_videofmt.fpsD, fmt.nFPS_Denominator);
+        env->SetIntField(lpVideoFormat, fid_videofmt.fcc, fmt.picFourCC);
     }
     else
     {
-        fmt.nWidth = env->GetIntField(lpVideoFormat, fid_w);
-        fmt.nHeight = env->GetIntField(lpVideoFormat, fid_h);
-        fmt.nFPS_Numerator = env->GetIntField(lpVideoFormat, fid_fpsN);
-        fmt.nFPS_Denominator = env->GetIntField(lpVideoFormat, fid_fpsD);
-        fmt.picFourCC = (FourCC)env->GetIntField(lpVideoFormat, fid_fcc);
+        fmt.nWidth = env->GetIntField(lpVideoFormat, fid_videofmt.w);
+        fmt.nHeight = env->GetIntField(lpVideoFormat, fid_videofmt.h);
+        fmt.nFPS_Numerator = env->GetIntField(lpVideoFormat, fid_videofmt.fpsN);
+        fmt.nFPS_Denominator = env->GetIntField(lpVideoFormat, fid_videofmt.fpsD);
+        fmt.picFourCC = (FourCC)env->GetIntField(lpVideoFormat, fid_videofmt.fcc);
     }
 }
 
@@ -1598,18 +1617,12 @@ void setWebMVP8Codec(JNIEnv* env, WebMVP8Codec& webm_vp8, jobject lpWebMVP8Codec
 }
 
 void setAbusePrevention(JNIEnv* env, AbusePrevention& abuse, jobject lpAbusePrevention, JConvert conv) {
-    jclass cls = env->GetObjectClass(lpAbusePrevention);
-    jfieldID fid_cmds = env->GetFieldID(cls, "nCommandsLimit", "I");
-    jfieldID fid_msec = env->GetFieldID(cls, "nCommandsIntervalMSec", "I");
-    assert(fid_cmds);
-    assert(fid_msec);
-
     if(conv == N2J) {
-        env->SetIntField(lpAbusePrevention, fid_cmds, abuse.nCommandsLimit);
-        env->SetIntField(lpAbusePrevention, fid_msec, abuse.nCommandsIntervalMSec);
+        env->SetIntField(lpAbusePrevention, fid_abuseprev.cmds, abuse.nCommandsLimit);
+        env->SetIntField(lpAbusePrevention, fid_abuseprev.msec, abuse.nCommandsIntervalMSec);
     }
     else {
-        abuse.nCommandsLimit = env->GetIntField(lpAbusePrevention, fid_cmds);
-        abuse.nCommandsIntervalMSec = env->GetIntField(lpAbusePrevention, fid_msec);
+        abuse.nCommandsLimit = env->GetIntField(lpAbusePrevention, fid_abuseprev.cmds);
+        abuse.nCommandsIntervalMSec = env->GetIntField(lpAbusePrevention, fid_abuseprev.msec);
     }
 }
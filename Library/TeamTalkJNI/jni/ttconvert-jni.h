@@ -97,7 +97,43 @@ enum JConvert
     J2N = 2
 };
 
+// Classes which are instantiated on every event or media frame, or
+// which are converted when polling statistics. The class references
+// and their field IDs are looked up once in JNI_OnLoad() instead of
+// on every conversion.
+enum JClassID
+{
+    JCLS_TTMESSAGE,
+    JCLS_CHANNEL,
+    JCLS_CLIENTERRORMSG,
+    JCLS_DESKTOPINPUT,
+    JCLS_FILETRANSFER,
+    JCLS_MEDIAFILEINFO,
+    JCLS_REMOTEFILE,
+    JCLS_SERVERPROPERTIES,
+    JCLS_SERVERSTATISTICS,
+    JCLS_TEXTMESSAGE,
+    JCLS_USER,
+    JCLS_USERACCOUNT,
+    JCLS_BANNEDUSER,
+    JCLS_VIDEOFRAME,
+    JCLS_AUDIOBLOCK,
+    JCLS_DESKTOPWINDOW,
+    JCLS_AUDIOCODEC,
+    JCLS_SPEEXCODEC,
+    JCLS_SPEEXVBRCODEC,
+    JCLS_OPUSCODEC,
+    JCLS_AUDIOCONFIG,
+    JCLS_AUDIOFORMAT,
+    JCLS_VIDEOFORMAT,
+    JCLS_ABUSEPREVENTION,
+    JCLS_CLIENTSTATISTICS,
+    JCLS_USERSTATISTICS,
+    JCLS_COUNT
+};
+
 jobject newObject(JNIEnv* env, jclass cls_obj);
+jobject newObject(JNIEnv* env, JClassID cls);
 jobject newSoundDevice(JNIEnv* env, const SoundDevice& dev);
 jobject newVideoDevice(JNIEnv* env, VideoCaptureDevice& dev);
 jobject newChannel(JNIEnv* env, const Channel* lpChannel);
@@ -127,9 +163,18 @@ void setFileTransfer(JNIEnv* env, const FileTransfer& filetx, jobject lpFileTran
 void setBannedUser(JNIEnv* env, BannedUser& banned, jobject lpBannedUser, JConvert conv);
 void setClientErrorMsg(JNIEnv* env, ClientErrorMsg& cemsg, jobject lpClientErrorMsg, JConvert conv);
 void setDesktopInput(JNIEnv* env, DesktopInput& input, jobject lpDesktopInput, JConvert conv);
-void setDesktopWindow(JNIEnv* env, DesktopWindow& deskwnd, jobject lpDesktopWindow, JConvert conv);
-void setVideoFrame(JNIEnv* env, VideoFrame& vidframe, jobject lpVideoFrame);
-void setAudioBlock(JNIEnv* env, AudioBlock& audblock, jobject lpAudioBlock);
+void setDesktopRegion(JNIEnv* env, DesktopRegion& region, jobject lpDesktopRegion, JConvert conv);
+// If 'bDirect' is true the Java object's 'directBuffer' refers to
+// the native memory of the frame, which must stay acquired until the
+// Java object is passed to detach*(). Returns false if the Java
+// buffer could not be allocated, in which case the frame is not
+// attached to the Java object and the caller must release it.
+bool setDesktopWindow(JNIEnv* env, DesktopWindow& deskwnd, jobject lpDesktopWindow, JConvert conv, bool bDirect = false);
+bool setVideoFrame(JNIEnv* env, VideoFrame& vidframe, jobject lpVideoFrame, bool bDirect = false);
+bool setAudioBlock(JNIEnv* env, AudioBlock& audblock, jobject lpAudioBlock, bool bDirect = false);
+DesktopWindow* detachDesktopWindow(JNIEnv* env, jobject lpDesktopWindow);
+VideoFrame* detachVideoFrame(JNIEnv* env, jobject lpVideoFrame);
+AudioBlock* detachAudioBlock(JNIEnv* env, jobject lpAudioBlock);
 void setMediaFileInfo(JNIEnv* env, MediaFileInfo& mfi, jobject lpMediaFileInfo);
 void setAudioFormat(JNIEnv* env, const AudioFormat& fmt, jobject lpAudioFormat);
 void setVideoFormat(JNIEnv* env, VideoFormat& fmt, jobject lpVideoFormat, JConvert conv);
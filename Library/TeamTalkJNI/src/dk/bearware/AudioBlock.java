@@ -30,6 +30,10 @@ public class AudioBlock {
     public byte[] lpRawAudio;
     public int nSamples;
     public int uSampleIndex;
+    /* Native audio memory when acquired by *Direct(). Only valid
+     * until the block is released. */
+    public java.nio.ByteBuffer directBuffer;
+    long nativePtr;
     
     public AudioBlock() {}
 }
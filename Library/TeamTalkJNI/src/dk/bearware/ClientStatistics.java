@@ -41,4 +41,9 @@ public class ClientStatistics
     public int nTcpPingTimeMs;
     public int nTcpServerSilenceSec;
     public int nUdpServerSilenceSec;
+    public int nVoiceCaptureOverruns;
+    public int nVoiceFramesSuppressed;
+    public int nEventsCoalesced;
+    public int nEventsDropped;
+    public int nMaxPayloadSize;
 }
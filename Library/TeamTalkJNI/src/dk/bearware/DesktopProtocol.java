@@ -25,4 +25,5 @@ package dk.bearware;
 
 public interface DesktopProtocol {
     public int DESKTOPPROTOCOL_ZLIB_1  = 1;
+    public int DESKTOPPROTOCOL_ZLIB_FAST  = 2;
 }
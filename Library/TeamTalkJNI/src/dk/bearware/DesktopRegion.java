@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+package dk.bearware;
+
+public class DesktopRegion {
+
+    public int nX;
+    public int nY;
+    public int nWidth;
+    public int nHeight;
+
+    public DesktopRegion() {}
+
+    public DesktopRegion(int nX, int nY, int nWidth, int nHeight) {
+        this.nX = nX;
+        this.nY = nY;
+        this.nWidth = nWidth;
+        this.nHeight = nHeight;
+    }
+}
@@ -31,5 +31,9 @@ public class DesktopWindow {
     public int nSessionID;
     public /* DesktopProtocol */ int nProtocol;
     public byte[] frameBuffer;
+    /* Native frame memory when acquired by *Direct(). Only valid
+     * until the window is released. */
+    public java.nio.ByteBuffer directBuffer;
+    long nativePtr;
     public DesktopWindow() {}
 }
@@ -37,4 +37,5 @@ public class ServerStatistics
     public long nDesktopBytesRX;
 	//TODO: nUsersServed, nUsersPeak, nFilesTx, nFilesRx
     public long nUptimeMSec;
+    public long nVoiceFramesSuppressed;
 }
@@ -31,6 +31,8 @@ public abstract class TeamTalkBase
 
     public static native String getVersion();
 
+    public static native boolean setSharedReactorThreads(int nThreads);
+
     private native long initTeamTalkPoll();
 
     protected TeamTalkBase(boolean create_instance) {
@@ -55,6 +57,14 @@ public abstract class TeamTalkBase
         return getMessage(ttInst, pMsg, pnWaitMs);
     }
 
+    private native int getMessages(long lpTTInstance,
+                                   TTMessage[] pMsgs,
+                                   int nWaitMs);
+    public int getMessages(TTMessage[] pMsgs,
+                           int nWaitMs) {
+        return getMessages(ttInst, pMsgs, nWaitMs);
+    }
+
     private native boolean pumpMessage(long lpTTInstance,
                                        int nClientEvent,
                                        int nIdentifier);
@@ -262,13 +272,19 @@ public abstract class TeamTalkBase
         return acquireUserVideoCaptureFrame(ttInst, nUserID);
     }
 
-/*
-    private native boolean releaseVideoCaptureFrame(long lpTTInstance,
-                                                      int nUserID);
-    public boolean releaseVideoCaptureFrame(int nUserID) {
-        return releaseVideoCaptureFrame(ttInst, nUserID);
+    /* Zero-copy version of acquireUserVideoCaptureFrame(). The
+     * frame must be passed to releaseUserVideoCaptureFrame(). */
+    private native VideoFrame acquireUserVideoCaptureFrameDirect(long lpTTInstance,
+                                                                 int nUserID);
+    public VideoFrame acquireUserVideoCaptureFrameDirect(int nUserID) {
+        return acquireUserVideoCaptureFrameDirect(ttInst, nUserID);
+    }
+
+    private native boolean releaseUserVideoCaptureFrame(long lpTTInstance,
+                                                        VideoFrame lpVideoFrame);
+    public boolean releaseUserVideoCaptureFrame(VideoFrame lpVideoFrame) {
+        return releaseUserVideoCaptureFrame(ttInst, lpVideoFrame);
     }
-*/
 
     private native boolean startStreamingMediaFileToChannel(long lpTTInstance,
                                                             String szMediaFilePath,
@@ -293,13 +309,19 @@ public abstract class TeamTalkBase
         return acquireUserMediaVideoFrame(ttInst, nUserID);
     }
 
-/*
+    /* Zero-copy version of acquireUserMediaVideoFrame(). The frame
+     * must be passed to releaseUserMediaVideoFrame(). */
+    private native VideoFrame acquireUserMediaVideoFrameDirect(long lpTTInstance,
+                                                               int nUserID);
+    public VideoFrame acquireUserMediaVideoFrameDirect(int nUserID) {
+        return acquireUserMediaVideoFrameDirect(ttInst, nUserID);
+    }
+
     private native boolean releaseUserMediaVideoFrame(long lpTTInstance,
-                                                      int nUserID);
-    public boolean releaseUserMediaVideoFrame(int nUserID) {
-        return releaseUserMediaVideoFrame(ttInst, nUserID);
+                                                      VideoFrame lpVideoFrame);
+    public boolean releaseUserMediaVideoFrame(VideoFrame lpVideoFrame) {
+        return releaseUserMediaVideoFrame(ttInst, lpVideoFrame);
     }
-*/
     private native int sendDesktopWindow(long lpTTInstance,
                                          DesktopWindow lpDesktopWindow,
                                          int nConvertBitmap);
@@ -308,6 +330,16 @@ public abstract class TeamTalkBase
         return sendDesktopWindow(ttInst, lpDesktopWindow, nConvertBitmap);
     }
 
+    private native int sendDesktopWindowEx(long lpTTInstance,
+                                           DesktopWindow lpDesktopWindow,
+                                           int nConvertBitmap,
+                                           DesktopRegion[] lpDirtyRegions);
+    public int sendDesktopWindowEx(DesktopWindow lpDesktopWindow,
+                                   int nConvertBitmap,
+                                   DesktopRegion[] lpDirtyRegions) {
+        return sendDesktopWindowEx(ttInst, lpDesktopWindow, nConvertBitmap, lpDirtyRegions);
+    }
+
     private native boolean closeDesktopWindow(long lpTTInstance);
     public boolean closeDesktopWindow() {
         return closeDesktopWindow(ttInst);
@@ -341,6 +373,22 @@ public abstract class TeamTalkBase
         return acquireUserDesktopWindowEx(ttInst, nUserID, nBitmapFormat);
     }
 
+    /* Zero-copy version of acquireUserDesktopWindowEx(). The window
+     * must be passed to releaseUserDesktopWindow(). */
+    private native DesktopWindow acquireUserDesktopWindowDirect(long lpTTInstance,
+                                                                int nUserID,
+                                                                int nBitmapFormat);
+    public DesktopWindow acquireUserDesktopWindowDirect(int nUserID,
+                                                        int /*BitmapFormat*/nBitmapFormat) {
+        return acquireUserDesktopWindowDirect(ttInst, nUserID, nBitmapFormat);
+    }
+
+    private native boolean releaseUserDesktopWindow(long lpTTInstance,
+                                                    DesktopWindow lpDesktopWindow);
+    public boolean releaseUserDesktopWindow(DesktopWindow lpDesktopWindow) {
+        return releaseUserDesktopWindow(ttInst, lpDesktopWindow);
+    }
+
     private native boolean connect(long lpTTInstance,
                                    String szHostAddress,
                                    int nTcpPort, 
@@ -756,6 +804,18 @@ public abstract class TeamTalkBase
     public AudioBlock acquireUserAudioBlock(int nStreamType, int nUserID) {
         return acquireUserAudioBlock(ttInst, nStreamType, nUserID);
     }
+    /* Zero-copy version of acquireUserAudioBlock(). The block must be
+     * passed to releaseUserAudioBlock(). */
+    private native AudioBlock acquireUserAudioBlockDirect(long lpTTInstance,
+                                                          int nStreamType, int nUserID);
+    public AudioBlock acquireUserAudioBlockDirect(int nStreamType, int nUserID) {
+        return acquireUserAudioBlockDirect(ttInst, nStreamType, nUserID);
+    }
+    private native boolean releaseUserAudioBlock(long lpTTInstance,
+                                                 AudioBlock lpAudioBlock);
+    public boolean releaseUserAudioBlock(AudioBlock lpAudioBlock) {
+        return releaseUserAudioBlock(ttInst, lpAudioBlock);
+    }
     private native boolean getFileTransferInfo(long lpTTInstance,
                                                int nTransferID, FileTransfer lpFileTransfer);
     public boolean getFileTransferInfo(int nTransferID, FileTransfer lpFileTransfer) {
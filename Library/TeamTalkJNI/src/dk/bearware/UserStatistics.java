@@ -37,4 +37,12 @@ public class UserStatistics
     public long nMediaFileVideoFramesRecv;
     public long nMediaFileVideoFramesLost;
     public long nMediaFileVideoFramesDropped;
+    public long nVoicePacketsLate;
+    public long nVoiceFramesConcealed;
+    public long nMediaFileAudioPacketsLate;
+    public long nMediaFileAudioFramesConcealed;
+    public int nVoiceJitterMSec;
+    public int nMediaFileAudioJitterMSec;
+    public long nVideoCaptureFramesSkipped;
+    public long nMediaFileVideoFramesSkipped;
 }
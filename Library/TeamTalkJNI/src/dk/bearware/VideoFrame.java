@@ -29,5 +29,9 @@ public class VideoFrame {
     public int nStreamID;
     public boolean bKeyFrame;
     public byte[] frameBuffer;
+    /* Native frame memory when acquired by *Direct(). Only valid
+     * until the frame is released. */
+    public java.nio.ByteBuffer directBuffer;
+    long nativePtr;
     public VideoFrame() {}
 }
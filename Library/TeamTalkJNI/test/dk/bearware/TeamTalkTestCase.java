@@ -1901,4 +1901,138 @@ public class TeamTalkTestCase extends TeamTalkTestCaseBase {
         srvprop.nUserTimeout = orgValue;
         assertTrue("update server", waitCmdSuccess(ttadmin, ttadmin.doUpdateServer(srvprop), DEF_WAIT));
     }
+
+    public void test_AudioBlockDirect() {
+        String USERNAME = "tt_test", PASSWORD = "tt_test", NICKNAME = "jUnit - " + getCurrentMethod();
+        int USERRIGHTS = UserRight.USERRIGHT_CREATE_TEMPORARY_CHANNEL |
+            UserRight.USERRIGHT_TRANSMIT_VOICE | UserRight.USERRIGHT_VIEW_ALL_USERS;
+        makeUserAccount(NICKNAME, USERNAME, PASSWORD, USERRIGHTS);
+
+        TeamTalkBase ttclient = newClientInstance();
+
+        TTMessage msg = new TTMessage();
+
+        connect(ttclient);
+        initSound(ttclient);
+        login(ttclient, NICKNAME, USERNAME, PASSWORD);
+        joinRoot(ttclient);
+
+        assertTrue("vox", ttclient.enableVoiceTransmission(true));
+
+        assertTrue("enable aud cb", ttclient.enableAudioBlockEvent(0, StreamType.STREAMTYPE_VOICE, true));
+
+        assertTrue("gimme voice audioblock", waitForEvent(ttclient, ClientEvent.CLIENTEVENT_USER_AUDIOBLOCK, DEF_WAIT, msg));
+
+        AudioBlock block = ttclient.acquireUserAudioBlockDirect(StreamType.STREAMTYPE_VOICE, 0);
+        assertTrue("direct aud block", block != null);
+        assertTrue("aud block has samples", block.nSamples > 0);
+        assertTrue("direct buffer", block.directBuffer != null && block.directBuffer.isDirect());
+        assertEquals("direct buffer size", block.nSamples * 2 * block.nChannels,
+                     block.directBuffer.capacity());
+
+        //read from native memory while the block is acquired
+        block.directBuffer.get(block.directBuffer.capacity() - 1);
+
+        assertTrue("release aud block", ttclient.releaseUserAudioBlock(block));
+        assertFalse("release aud block twice", ttclient.releaseUserAudioBlock(block));
+
+        assertTrue("disable aud cb", ttclient.enableAudioBlockEvent(0, StreamType.STREAMTYPE_VOICE, false));
+    }
+
+    public void test_DesktopWindowDirect() {
+
+        final String USERNAME = "tt_test", PASSWORD = "tt_test", NICKNAME = "jUnit - " + getCurrentMethod();
+        int USERRIGHTS = UserRight.USERRIGHT_CREATE_TEMPORARY_CHANNEL |
+                         UserRight.USERRIGHT_TRANSMIT_DESKTOP | UserRight.USERRIGHT_MULTI_LOGIN;
+        makeUserAccount(NICKNAME, USERNAME, PASSWORD, USERRIGHTS);
+        TeamTalkBase ttclient = newClientInstance();
+        connect(ttclient);
+        login(ttclient, NICKNAME, USERNAME, PASSWORD);
+        joinRoot(ttclient);
+
+        DesktopWindow wnd = new DesktopWindow();
+        wnd.nWidth = 128;
+        wnd.nHeight = 128;
+        wnd.bmpFormat = BitmapFormat.BMP_RGB32;
+        wnd.nProtocol = DesktopProtocol.DESKTOPPROTOCOL_ZLIB_1;
+        wnd.frameBuffer = new byte[wnd.nWidth * wnd.nHeight * 4];
+
+        assertTrue("send desktop window", ttclient.sendDesktopWindow(wnd, BitmapFormat.BMP_RGB32)>0);
+
+        TTMessage msg = new TTMessage();
+
+        while(waitForEvent(ttclient, ClientEvent.CLIENTEVENT_DESKTOPWINDOW_TRANSFER, 
+                           DEF_WAIT, msg) && msg.nBytesRemain > 0) {
+        }
+        assertTrue("All bytes transferred", msg.nBytesRemain == 0);
+
+        //only the top left corner has changed
+        for(int i=0;i<32;i++)
+            wnd.frameBuffer[i] = (byte)0xFF;
+        DesktopRegion[] regions = { new DesktopRegion(0, 0, 8, 1) };
+        assertTrue("send dirty region", ttclient.sendDesktopWindowEx(wnd, BitmapFormat.BMP_RGB32, regions)>0);
+
+        while(waitForEvent(ttclient, ClientEvent.CLIENTEVENT_DESKTOPWINDOW_TRANSFER, 
+                           DEF_WAIT, msg) && msg.nBytesRemain > 0) {
+        }
+        assertTrue("All update bytes transferred", msg.nBytesRemain == 0);
+
+        assertTrue("Subscribe to own", ttclient.doSubscribe(ttclient.getMyUserID(), Subscription.SUBSCRIBE_DESKTOP)>0);
+
+        assertTrue("Wait for desktop window", waitForEvent(ttclient, ClientEvent.CLIENTEVENT_USER_DESKTOPWINDOW, DEF_WAIT, msg));
+
+        DesktopWindow wnd2 = ttclient.acquireUserDesktopWindowDirect(msg.nSource, BitmapFormat.BMP_RGB32);
+        assertTrue("direct desktop window", wnd2 != null);
+        assertEquals("width", wnd.nWidth, wnd2.nWidth);
+        assertEquals("height", wnd.nHeight, wnd2.nHeight);
+        assertTrue("direct buffer", wnd2.directBuffer != null && wnd2.directBuffer.isDirect());
+        assertEquals("length", wnd.frameBuffer.length, wnd2.directBuffer.capacity());
+        assertEquals("dirty region", (byte)0xFF, wnd2.directBuffer.get(0));
+
+        assertTrue("release desktop window", ttclient.releaseUserDesktopWindow(wnd2));
+        assertFalse("release desktop window twice", ttclient.releaseUserDesktopWindow(wnd2));
+
+        assertTrue("Close desktop", ttclient.closeDesktopWindow());
+    }
+
+    public void test_GetMessages() {
+        TeamTalkBase ttclient = newClientInstance();
+        connect(ttclient);
+
+        int[] cmdids = new int[10];
+        for(int i=0;i<cmdids.length;i++) {
+            cmdids[i] = ttclient.doPing();
+            assertTrue("ping", cmdids[i] > 0);
+        }
+
+        //command replies must be retrieved in the order they were posted
+        TTMessage[] msgs = new TTMessage[4];
+        int replies = 0;
+        while(replies < cmdids.length) {
+            int n = ttclient.getMessages(msgs, DEF_WAIT);
+            assertTrue("got messages", n > 0 && n <= msgs.length);
+            for(int i=0;i<n;i++) {
+                if(msgs[i].nClientEvent == ClientEvent.CLIENTEVENT_CMD_PROCESSING && !msgs[i].bActive)
+                    assertEquals("reply order", cmdids[replies++], msgs[i].nSource);
+            }
+        }
+    }
+
+    public void test_SharedReactorThreads() {
+        assertFalse("negative thread count", TeamTalkBase.setSharedReactorThreads(-1));
+        assertTrue("shared threads", TeamTalkBase.setSharedReactorThreads(2));
+        try {
+            TeamTalkBase[] clients = new TeamTalkBase[4];
+            for(int i=0;i<clients.length;i++) {
+                clients[i] = newClientInstance();
+                connect(clients[i]);
+            }
+            for(TeamTalkBase ttclient : clients) {
+                assertTrue("ping", waitCmdComplete(ttclient, ttclient.doPing(), DEF_WAIT));
+            }
+        }
+        finally {
+            assertTrue("own threads", TeamTalkBase.setSharedReactorThreads(0));
+        }
+    }
 }
@@ -0,0 +1,1162 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ *
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+/* Headless load generator which puts a TeamTalk server under the
+ * load of many users from a single process.
+ *
+ * Every simulated user has its own TCP command connection and UDP
+ * socket and speaks the same protocol as ClientNode. The first user
+ * creates a channel tree below the root channel (unless it already
+ * exists) and then all users log in and are spread evenly across
+ * the channels of the tree. The first users of each channel stream
+ * voice, video and desktop packets at a fixed rate and every user
+ * acts as a receiver which measures forwarding latency (from the
+ * packets' timestamp since all users share one clock) and loss
+ * (from gaps in packet numbers).
+ *
+ * Voice frames are random data of an Opus-like size unless a file of
+ * prerecorded frames is given. The file contains the frames back to
+ * back, each prefixed by its size as a 16-bit little-endian integer,
+ * and is sent in a loop. The server forwards encoded audio without
+ * decoding it so only the sizes and rate matter.
+ *
+ * The account used for logging in must be allowed to create
+ * channels and the server must allow the number of users from one
+ * IP-address. Per interval rows are written as CSV to stdout:
+ *
+ * second,users,voice_tx,voice_rx,voice_loss_pct,voice_p50_msec,voice_p99_msec,video_tx,video_rx,video_loss_pct,video_p50_msec,video_p99_msec,desktop_tx,desktop_rx,desktop_p50_msec,desktop_p99_msec,server_cpu_pct,loadgen_cpu_pct
+ *
+ * server_cpu_pct is only measured if the server's process id is
+ * given (Linux only). A summary is written to stderr.
+ *
+ * Usage: loadgen [-h host] [-p port] [-u users] [-l username:password]
+ *                [-c fanout[,fanout...]] [-v voice senders per channel]
+ *                [-V video senders per channel] [-D desktop senders per channel]
+ *                [-f voice frames file] [-t seconds] [-i report interval seconds]
+ *                [-s server pid] */
+
+#include <teamtalk/PacketHandler.h>
+#include <teamtalk/PacketLayout.h>
+#include <teamtalk/Commands.h>
+#include <teamtalk/Common.h>
+#include <myace/MyACE.h>
+
+#include <ace/Reactor.h>
+#include <ace/Select_Reactor.h>
+#if defined(ACE_HAS_EVENT_POLL) || defined(ACE_HAS_DEV_POLL)
+#include <ace/Dev_Poll_Reactor.h>
+#endif
+#include <ace/SOCK_Connector.h>
+#include <ace/SOCK_Stream.h>
+#include <ace/Get_Opt.h>
+#include <ace/OS_NS_stdlib.h>
+#include <ace/OS_NS_sys_time.h>
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+
+using namespace teamtalk;
+
+#define TICK_MSEC               5
+#define HELLO_RETRY_MSEC        500
+#define CONNECT_TIMEOUT_SEC     5
+#define SETUP_TIMEOUT_SEC       30
+#define UDP_RECV_BUF_SIZE       (64*1024)
+#define UDP_SEND_BUF_SIZE       (64*1024)
+//latency histogram has 1 msec buckets
+#define MAX_LATENCY_MSEC        2000
+
+#define VIDEO_WIDTH             320
+#define VIDEO_HEIGHT            240
+#define DESKTOP_WIDTH           640
+#define DESKTOP_HEIGHT          480
+#define DESKTOP_SESSIONID       1
+
+enum
+{
+    CMDID_LOGIN = 1,
+    CMDID_JOIN,
+    CMDID_MAKECHANNEL
+};
+
+enum MediaType
+{
+    MEDIA_VOICE,
+    MEDIA_VIDEO,
+    MEDIA_DESKTOP,
+    MEDIA_COUNT
+};
+
+struct LoadConfig
+{
+    ACE_TString host = ACE_TEXT("127.0.0.1");
+    int port = 10333;
+    int users = 100;
+    ACE_TString username, password;
+    std::vector<int> fanout = { 4 };
+    int senders[MEDIA_COUNT] = { 1, 0, 0 };
+    //send interval and payload size of each media type
+    int interval_msec[MEDIA_COUNT] = { 20, 1000 / 15, 1000 };
+    int payload_bytes[MEDIA_COUNT] = { 80, 1000, 1000 };
+    int opus_bitrate = 32000;
+    std::string voice_file;
+    int duration_sec = 60;
+    int report_sec = 5;
+    int server_pid = 0;
+};
+
+struct MediaStats
+{
+    long sent = 0, received = 0, lost = 0;
+    std::vector<uint32_t> latency;
+
+    MediaStats() : latency(MAX_LATENCY_MSEC + 1) { }
+
+    void AddLatency(int msec)
+    {
+        msec = std::max(0, std::min(msec, MAX_LATENCY_MSEC));
+        latency[msec]++;
+    }
+
+    int Percentile(double p) const
+    {
+        long target = long(received * p + 0.5), n = 0;
+        for(size_t i=0;i<latency.size();i++)
+        {
+            n += latency[i];
+            if(n >= target && n > 0)
+                return int(i);
+        }
+        return 0;
+    }
+
+    double LossPercent() const
+    {
+        return received + lost? 100.0 * lost / (received + lost) : 0;
+    }
+
+    void Add(const MediaStats& s)
+    {
+        sent += s.sent;
+        received += s.received;
+        lost += s.lost;
+        for(size_t i=0;i<latency.size();i++)
+            latency[i] += s.latency[i];
+    }
+};
+
+//a channel in the tree created below the root channel
+struct TreeChannel
+{
+    ACE_TString name;
+    //index of parent in tree or -1 if root channel is parent
+    int parent;
+    int chanid = 0;
+    bool requested = false;
+};
+
+class LoadGen;
+
+class LoadUser : public ACE_Event_Handler
+               , public PacketListener
+{
+public:
+    enum State
+    {
+        STATE_CONNECTING,
+        STATE_HELLO,
+        STATE_LOGIN,
+        STATE_SETUP,
+        STATE_JOIN,
+        STATE_ACTIVE,
+        STATE_FAILED
+    };
+
+    LoadUser(LoadGen& gen, int index, ACE_Reactor* r);
+    ~LoadUser();
+
+    bool Connect(const ACE_INET_Addr& tcpaddr, const ACE_INET_Addr& udpaddr);
+    void Close();
+
+    State GetState() const { return m_state; }
+    int GetIndex() const { return m_index; }
+
+    //join 'chanid' once logged in
+    void SetChannel(int chanid) { m_chanid = chanid; }
+    void Join();
+    void SetSender(MediaType type, uint32_t first_send);
+
+    void Tick(uint32_t now);
+
+    void DoMakeChannel(int parentid, const ACE_TString& name, const AudioCodec& codec);
+
+    //ACE_Event_Handler
+    int handle_input(ACE_HANDLE fd = ACE_INVALID_HANDLE);
+    int handle_close(ACE_HANDLE, ACE_Reactor_Mask mask);
+    ACE_HANDLE get_handle() const { return m_stream.get_handle(); }
+
+    //PacketListener
+    void ReceivedPacket(const char* data_buf, int data_len,
+                        const ACE_INET_Addr& addr);
+
+private:
+    void ProcessCommand(const ACE_CString& line);
+    void HandleEnd(const mstrings_t& properties);
+    void TransmitCommand(ACE_TString command);
+    void SendPacket(const FieldPacket& packet);
+    void Fail(const ACE_TString& reason);
+
+    void SendVoice(uint32_t now);
+    void SendVideo(uint32_t now);
+    void SendDesktop(uint32_t now);
+    void ReceivedStreamPacket(MediaType type, const FieldPacket& packet,
+                              uint32_t packet_no, bool wrap16);
+
+    LoadGen& m_gen;
+    int m_index;
+    State m_state = STATE_CONNECTING;
+    ACE_SOCK_Stream m_stream;
+    PacketHandler m_packethandler;
+    ACE_INET_Addr m_udpaddr;
+    std::string m_recvbuffer;
+
+    int m_userid = 0, m_chanid = 0;
+    int m_keepalive_msec = 30000;
+    uint32_t m_next_keepalive = 0, m_next_hello = 0;
+    int m_error = TT_CMDERR_SUCCESS;
+    ACE_TString m_errmsg;
+
+    bool m_sender[MEDIA_COUNT] = {};
+    uint32_t m_next_send[MEDIA_COUNT] = {};
+    uint32_t m_packet_no[MEDIA_COUNT] = {};
+    size_t m_voice_frame = 0;
+
+    //(src_userid << 8 | packet kind) -> last packet number received
+    std::map<uint32_t, uint32_t> m_last_packet;
+};
+
+class LoadGen : public ACE_Event_Handler
+{
+public:
+    LoadGen(const LoadConfig& cfg, ACE_Reactor* r);
+    ~LoadGen();
+
+    bool Run();
+    bool SetupDone() const { return m_setup_done; }
+
+    const LoadConfig& GetConfig() const { return m_cfg; }
+    MediaStats& GetStats(MediaType type) { return m_interval[type]; }
+
+    //payload of voice frame 'n' (loops the prerecorded frames)
+    const std::vector<char>& GetVoiceFrame(size_t n) const
+    { return m_voice_frames[n % m_voice_frames.size()]; }
+    const std::vector<char>& GetPayload(MediaType type) const
+    { return m_payload[type]; }
+
+    //callbacks from setup user
+    void OnSetupLoggedIn(LoadUser& user);
+    void OnAddChannel(LoadUser& user, int chanid, int parentid,
+                      const ACE_TString& name);
+    void OnMakeChannelDone(LoadUser& user, bool success);
+
+    int handle_timeout(const ACE_Time_Value& tv, const void* arg);
+
+private:
+    bool LoadVoiceFrames();
+    void BuildTree();
+    int GetParentID(const TreeChannel& chan) const;
+    void MakeChannels(LoadUser& user);
+    bool ConnectUsers();
+    void Report(bool final);
+    bool GetServerCPU(double& seconds) const;
+    double GetOwnCPU() const;
+
+    LoadConfig m_cfg;
+    ACE_Reactor* m_reactor;
+    ACE_INET_Addr m_tcpaddr, m_udpaddr;
+    std::vector<LoadUser*> m_users;
+    std::vector<TreeChannel> m_tree;
+    int m_rootid = 0;
+    bool m_setup_done = false, m_setup_failed = false;
+    AudioCodec m_codec;
+
+    std::vector< std::vector<char> > m_voice_frames;
+    std::vector<char> m_payload[MEDIA_COUNT];
+
+    MediaStats m_interval[MEDIA_COUNT], m_total[MEDIA_COUNT];
+    ACE_Time_Value m_start, m_last_report;
+    double m_server_cpu = 0, m_own_cpu = 0;
+    double m_server_cpu_total = 0;
+    int m_reports = 0;
+};
+
+LoadUser::LoadUser(LoadGen& gen, int index, ACE_Reactor* r)
+    : ACE_Event_Handler(r)
+    , m_gen(gen)
+    , m_index(index)
+    , m_packethandler(r)
+{
+}
+
+LoadUser::~LoadUser()
+{
+    Close();
+}
+
+bool LoadUser::Connect(const ACE_INET_Addr& tcpaddr, const ACE_INET_Addr& udpaddr)
+{
+    m_udpaddr = udpaddr;
+
+    ACE_SOCK_Connector connector;
+    ACE_Time_Value timeout(CONNECT_TIMEOUT_SEC);
+    if(connector.connect(m_stream, tcpaddr, &timeout) < 0)
+    {
+        Fail(ACE_TEXT("TCP connect failed"));
+        return false;
+    }
+
+    ACE_INET_Addr localaddr((u_short)0);
+    if(!m_packethandler.open(localaddr, UDP_RECV_BUF_SIZE, UDP_SEND_BUF_SIZE))
+    {
+        Fail(ACE_TEXT("UDP open failed"));
+        return false;
+    }
+    m_packethandler.AddListener(this);
+
+    if(reactor()->register_handler(this, ACE_Event_Handler::READ_MASK) < 0)
+    {
+        Fail(ACE_TEXT("Failed to register TCP handler"));
+        return false;
+    }
+    return true;
+}
+
+void LoadUser::Close()
+{
+    if(m_stream.get_handle() != ACE_INVALID_HANDLE)
+    {
+        reactor()->remove_handler(this, ACE_Event_Handler::ALL_EVENTS_MASK |
+                                  ACE_Event_Handler::DONT_CALL);
+        m_stream.close();
+    }
+    if(m_packethandler.get_handle() != ACE_INVALID_HANDLE)
+    {
+        m_packethandler.RemoveListener(this);
+        m_packethandler.close();
+    }
+}
+
+void LoadUser::SetSender(MediaType type, uint32_t first_send)
+{
+    m_sender[type] = true;
+    m_next_send[type] = first_send;
+}
+
+void LoadUser::Fail(const ACE_TString& reason)
+{
+    if(m_state != STATE_FAILED)
+        fprintf(stderr, "user %d: %s\n", m_index, reason.c_str());
+    m_state = STATE_FAILED;
+}
+
+void LoadUser::TransmitCommand(ACE_TString command)
+{
+    command += EOL;
+    if(m_stream.send_n(command.c_str(), command.length()) < 0)
+        Fail(ACE_TEXT("TCP send failed"));
+}
+
+void LoadUser::SendPacket(const FieldPacket& packet)
+{
+    int buffers;
+    const iovec* vv = packet.GetPacket(buffers);
+    m_packethandler.sock_i().send(vv, buffers, m_udpaddr);
+}
+
+void LoadUser::DoMakeChannel(int parentid, const ACE_TString& name,
+                             const AudioCodec& codec)
+{
+    ACE_TString command = CLIENT_MAKECHANNEL;
+    AppendProperty(TT_PARENTID, parentid, command);
+    AppendProperty(TT_CHANNAME, name, command);
+    AppendProperty(TT_AUDIOCODEC, codec, command);
+    AppendProperty(TT_CHANNELTYPE, (int)CHANNEL_DEFAULT, command);
+    AppendProperty(TT_CMDID, (int)CMDID_MAKECHANNEL, command);
+    TransmitCommand(command);
+}
+
+int LoadUser::handle_input(ACE_HANDLE)
+{
+    char buf[0x10000];
+    ssize_t ret = m_stream.recv(buf, sizeof(buf));
+    if(ret <= 0)
+    {
+        Fail(ACE_TEXT("Disconnected from server"));
+        return -1;
+    }
+
+    m_recvbuffer.append(buf, ret);
+    size_t begin = 0, end;
+    while((end = m_recvbuffer.find('\n', begin)) != std::string::npos)
+    {
+        ProcessCommand(ACE_CString(m_recvbuffer.c_str() + begin, end - begin + 1));
+        begin = end + 1;
+    }
+    m_recvbuffer.erase(0, begin);
+    return 0;
+}
+
+int LoadUser::handle_close(ACE_HANDLE, ACE_Reactor_Mask)
+{
+    m_stream.close();
+    return 0;
+}
+
+void LoadUser::ProcessCommand(const ACE_CString& line)
+{
+    ACE_CString cmd;
+    if(!GetCmd(line, cmd))
+        return;
+
+    //only the setup user needs the channels and nobody needs the
+    //notifications about other users
+    bool setup = m_index == 0 && (m_state == STATE_LOGIN || m_state == STATE_SETUP);
+    if(cmd != SERVER_WELCOME && cmd != SERVER_ERROR && cmd != SERVER_ENDCMD &&
+       (cmd != SERVER_ADDCHANNEL || !setup))
+        return;
+
+    mstrings_t properties;
+    if(ExtractProperties(line, properties) < 0)
+        return;
+
+    if(cmd == SERVER_WELCOME)
+    {
+        int usertimeout = 0;
+        GetProperty(properties, TT_USERID, m_userid);
+        GetProperty(properties, TT_USERTIMEOUT, usertimeout);
+        if(usertimeout > 1)
+            m_keepalive_msec = usertimeout * 1000 / 2;
+        m_state = STATE_HELLO;
+        m_next_hello = GETTIMESTAMP();
+    }
+    else if(cmd == SERVER_ERROR)
+    {
+        GetProperty(properties, TT_ERRORNUM, m_error);
+        GetProperty(properties, TT_ERRORMSG, m_errmsg);
+    }
+    else if(cmd == SERVER_ADDCHANNEL)
+    {
+        int chanid = 0, parentid = 0;
+        ACE_TString name;
+        GetProperty(properties, TT_CHANNELID, chanid);
+        GetProperty(properties, TT_PARENTID, parentid);
+        GetProperty(properties, TT_CHANNAME, name);
+        m_gen.OnAddChannel(*this, chanid, parentid, name);
+    }
+    else if(cmd == SERVER_ENDCMD)
+        HandleEnd(properties);
+}
+
+void LoadUser::HandleEnd(const mstrings_t& properties)
+{
+    int cmdid = 0;
+    GetProperty(properties, TT_CMDID, cmdid);
+
+    int error = m_error;
+    m_error = TT_CMDERR_SUCCESS;
+
+    if(error != TT_CMDERR_SUCCESS)
+    {
+        if(cmdid == CMDID_MAKECHANNEL)
+            m_gen.OnMakeChannelDone(*this, false);
+
+        ACE_TString reason = ACE_TEXT("Command failed: ") + m_errmsg;
+        Fail(reason);
+        return;
+    }
+
+    switch(cmdid)
+    {
+    case CMDID_LOGIN :
+        if(m_index == 0 && !m_gen.SetupDone())
+        {
+            m_state = STATE_SETUP;
+            m_gen.OnSetupLoggedIn(*this);
+        }
+        else
+            Join();
+        break;
+    case CMDID_JOIN :
+        m_state = STATE_ACTIVE;
+        break;
+    case CMDID_MAKECHANNEL :
+        m_gen.OnMakeChannelDone(*this, true);
+        break;
+    }
+}
+
+void LoadUser::Join()
+{
+    if(!m_chanid)
+        return;
+
+    ACE_TString command = CLIENT_JOINCHANNEL;
+    AppendProperty(TT_CHANNELID, m_chanid, command);
+    AppendProperty(TT_CMDID, (int)CMDID_JOIN, command);
+    TransmitCommand(command);
+    m_state = STATE_JOIN;
+}
+
+void LoadUser::Tick(uint32_t now)
+{
+    switch(m_state)
+    {
+    case STATE_HELLO :
+        //repeat until server acknowledges like TIMER_UDPCONNECT_ID
+        if(W32_GEQ(now, m_next_hello))
+        {
+            SendPacket(HelloPacket(m_userid, now));
+            m_next_hello = now + HELLO_RETRY_MSEC;
+        }
+        return;
+    case STATE_LOGIN :
+    case STATE_SETUP :
+    case STATE_JOIN :
+    case STATE_ACTIVE :
+        break;
+    default :
+        return;
+    }
+
+    if(W32_GEQ(now, m_next_keepalive))
+    {
+        TransmitCommand(CLIENT_KEEPALIVE);
+        SendPacket(KeepAlivePacket(m_userid, now));
+        m_next_keepalive = now + m_keepalive_msec;
+    }
+
+    if(m_state != STATE_ACTIVE)
+        return;
+
+    const LoadConfig& cfg = m_gen.GetConfig();
+    for(int i=0;i<MEDIA_COUNT;i++)
+    {
+        //catch up if reactor was busy
+        while(m_sender[i] && W32_GEQ(now, m_next_send[i]))
+        {
+            switch(i)
+            {
+            case MEDIA_VOICE : SendVoice(now); break;
+            case MEDIA_VIDEO : SendVideo(now); break;
+            case MEDIA_DESKTOP : SendDesktop(now); break;
+            }
+            m_gen.GetStats(MediaType(i)).sent++;
+            m_next_send[i] += cfg.interval_msec[i];
+        }
+    }
+}
+
+void LoadUser::SendVoice(uint32_t now)
+{
+    const std::vector<char>& frame = m_gen.GetVoiceFrame(m_voice_frame++);
+    VoicePacket packet(PACKET_KIND_VOICE, m_userid, now, 1,
+                       uint16_t(++m_packet_no[MEDIA_VOICE]),
+                       &frame[0], uint16_t(frame.size()));
+    packet.SetChannel(m_chanid);
+    SendPacket(packet);
+}
+
+void LoadUser::SendVideo(uint32_t now)
+{
+    const std::vector<char>& frame = m_gen.GetPayload(MEDIA_VIDEO);
+    uint16_t width = VIDEO_WIDTH, height = VIDEO_HEIGHT;
+    VideoPacket packet(PACKET_KIND_VIDEO, m_userid, now, 1,
+                       ++m_packet_no[MEDIA_VIDEO], &width, &height,
+                       &frame[0], uint16_t(frame.size()));
+    packet.SetChannel(m_chanid);
+    SendPacket(packet);
+}
+
+void LoadUser::SendDesktop(uint32_t now)
+{
+    //each update replaces a single block. Acks from the server are
+    //ignored so lost updates aren't retransmitted
+    const std::vector<char>& block = m_gen.GetPayload(MEDIA_DESKTOP);
+    map_block_t blocks;
+    desktop_block b;
+    b.block_data = &block[0];
+    b.block_size = uint16_t(block.size());
+    blocks[uint16_t(m_packet_no[MEDIA_DESKTOP] % 16)] = b;
+
+    block_frags_t frags;
+    mmap_dup_blocks_t dups;
+    if(m_packet_no[MEDIA_DESKTOP]++ == 0)
+    {
+        DesktopPacket packet(m_userid, now, DESKTOP_SESSIONID,
+                             DESKTOP_WIDTH, DESKTOP_HEIGHT, BMP_RGB8_PALETTE,
+                             0, 1, blocks, frags, dups);
+        packet.SetChannel(m_chanid);
+        SendPacket(packet);
+    }
+    else
+    {
+        DesktopPacket packet(m_userid, now, DESKTOP_SESSIONID, 0, 1,
+                             blocks, frags, dups);
+        packet.SetChannel(m_chanid);
+        SendPacket(packet);
+    }
+}
+
+void LoadUser::ReceivedPacket(const char* data_buf, int data_len,
+                              const ACE_INET_Addr& addr)
+{
+    FieldPacket packet(data_buf, data_len);
+    if(!packet.ValidatePacket())
+        return;
+
+    switch(packet.GetKind())
+    {
+    case PACKET_KIND_HELLO :
+        if(m_state == STATE_HELLO)
+        {
+            //UDP is connected so now login like ClientNode::DoLogin()
+            const LoadConfig& cfg = m_gen.GetConfig();
+            ACE_TString nickname = ACE_TEXT("loadgen-") + i2string(m_index);
+            ACE_TString command = CLIENT_LOGIN;
+            AppendProperty(TT_NICKNAME, nickname, command);
+            AppendProperty(TT_USERNAME, cfg.username, command);
+            AppendProperty(TT_PASSWORD, cfg.password, command);
+            AppendProperty(TT_CLIENTNAME, ACE_TString(ACE_TEXT("loadgen")), command);
+            AppendProperty(TT_PROTOCOL, ACE_TString(TEAMTALK_PROTOCOL_VERSION), command);
+            AppendProperty(TT_CMDID, (int)CMDID_LOGIN, command);
+            m_state = STATE_LOGIN;
+            m_next_keepalive = GETTIMESTAMP() + m_keepalive_msec;
+            TransmitCommand(command);
+        }
+        break;
+    case PACKET_KIND_VOICE :
+    {
+        AudioPacket audpkt(data_buf, data_len);
+        ReceivedStreamPacket(MEDIA_VOICE, audpkt, audpkt.GetPacketNumber(), true);
+        break;
+    }
+    case PACKET_KIND_VIDEO :
+    {
+        VideoPacket vidpkt(data_buf, data_len);
+        ReceivedStreamPacket(MEDIA_VIDEO, vidpkt, vidpkt.GetPacketNo(), false);
+        break;
+    }
+    case PACKET_KIND_DESKTOP :
+    {
+        //desktop packets are retransmitted by the server's
+        //DesktopTransmitter so loss is not measured
+        DesktopPacket deskpkt(data_buf, data_len);
+        MediaStats& stats = m_gen.GetStats(MEDIA_DESKTOP);
+        stats.received++;
+        stats.AddLatency(int(GETTIMESTAMP() - deskpkt.GetTime()));
+
+        std::set<uint16_t> acked;
+        acked.insert(deskpkt.GetPacketIndex());
+        DesktopAckPacket ackpkt(m_userid, GETTIMESTAMP(),
+                                deskpkt.GetSrcUserID(), deskpkt.GetSessionID(),
+                                deskpkt.GetTime(), acked, packet_range_t());
+        ackpkt.SetChannel(m_chanid);
+        SendPacket(ackpkt);
+        break;
+    }
+    }
+}
+
+void LoadUser::ReceivedStreamPacket(MediaType type, const FieldPacket& packet,
+                                    uint32_t packet_no, bool wrap16)
+{
+    MediaStats& stats = m_gen.GetStats(type);
+    stats.received++;
+    stats.AddLatency(int(GETTIMESTAMP() - packet.GetTime()));
+
+    uint32_t key = (uint32_t(packet.GetSrcUserID()) << 8) | packet.GetKind();
+    std::map<uint32_t, uint32_t>::iterator ii = m_last_packet.find(key);
+    if(ii == m_last_packet.end())
+    {
+        m_last_packet[key] = packet_no;
+        return;
+    }
+
+    int32_t gap = wrap16? int16_t(packet_no - ii->second) : int32_t(packet_no - ii->second);
+    //reordered or duplicate packets are ignored
+    if(gap <= 0)
+        return;
+    stats.lost += gap - 1;
+    ii->second = packet_no;
+}
+
+LoadGen::LoadGen(const LoadConfig& cfg, ACE_Reactor* r)
+    : ACE_Event_Handler(r)
+    , m_cfg(cfg)
+    , m_reactor(r)
+    , m_tcpaddr(u_short(cfg.port), cfg.host.c_str())
+    , m_udpaddr(u_short(cfg.port), cfg.host.c_str())
+{
+    m_codec.codec = CODEC_OPUS;
+    m_codec.opus.samplerate = 48000;
+    m_codec.opus.channels = 1;
+    m_codec.opus.application = 2048; //OPUS_APPLICATION_VOIP
+    m_codec.opus.complexity = 10;
+    m_codec.opus.fec = true;
+    m_codec.opus.dtx = false;
+    m_codec.opus.bitrate = cfg.opus_bitrate;
+    m_codec.opus.vbr = true;
+    m_codec.opus.vbr_constraint = false;
+    m_codec.opus.frame_size = 48000 * cfg.interval_msec[MEDIA_VOICE] / 1000;
+
+    for(int i=0;i<MEDIA_COUNT;i++)
+    {
+        m_payload[i].resize(m_cfg.payload_bytes[i]);
+        for(size_t j=0;j<m_payload[i].size();j++)
+            m_payload[i][j] = char(ACE_OS::rand());
+    }
+}
+
+LoadGen::~LoadGen()
+{
+    m_reactor->cancel_timer(this);
+    for(size_t i=0;i<m_users.size();i++)
+        delete m_users[i];
+}
+
+bool LoadGen::LoadVoiceFrames()
+{
+    if(m_cfg.voice_file.empty())
+    {
+        m_voice_frames.push_back(m_payload[MEDIA_VOICE]);
+        return true;
+    }
+
+    FILE* f = fopen(m_cfg.voice_file.c_str(), "rb");
+    if(!f)
+    {
+        fprintf(stderr, "Failed to open %s\n", m_cfg.voice_file.c_str());
+        return false;
+    }
+
+    unsigned char hdr[2];
+    while(fread(hdr, 1, 2, f) == 2)
+    {
+        size_t len = hdr[0] | (hdr[1] << 8);
+        if(len == 0 || len > MAX_ENC_FRAMESIZE)
+            break;
+        std::vector<char> frame(len);
+        if(fread(&frame[0], 1, len, f) != len)
+            break;
+        m_voice_frames.push_back(frame);
+    }
+    fclose(f);
+
+    if(m_voice_frames.empty())
+    {
+        fprintf(stderr, "No voice frames in %s\n", m_cfg.voice_file.c_str());
+        return false;
+    }
+    return true;
+}
+
+void LoadGen::BuildTree()
+{
+    //level by level so parents are always created before children
+    int level_begin = 0, level_end = 0;
+    for(size_t l=0;l<m_cfg.fanout.size();l++)
+    {
+        int parents = l == 0? 1 : level_end - level_begin;
+        for(int p=0;p<parents;p++)
+        {
+            for(int c=0;c<m_cfg.fanout[l];c++)
+            {
+                TreeChannel chan;
+                chan.parent = l == 0? -1 : level_begin + p;
+                chan.name = (l == 0? ACE_TString(ACE_TEXT("loadgen")) :
+                             m_tree[chan.parent].name) + ACE_TEXT("-") + i2string(c + 1);
+                m_tree.push_back(chan);
+            }
+        }
+        if(l > 0)
+            level_begin = level_end;
+        level_end = int(m_tree.size());
+    }
+}
+
+int LoadGen::GetParentID(const TreeChannel& chan) const
+{
+    return chan.parent < 0? m_rootid : m_tree[chan.parent].chanid;
+}
+
+void LoadGen::MakeChannels(LoadUser& user)
+{
+    bool done = true;
+    for(size_t i=0;i<m_tree.size();i++)
+    {
+        TreeChannel& chan = m_tree[i];
+        if(chan.chanid)
+            continue;
+        done = false;
+        int parentid = GetParentID(chan);
+        if(parentid && !chan.requested)
+        {
+            user.DoMakeChannel(parentid, chan.name, m_codec);
+            chan.requested = true;
+        }
+    }
+    m_setup_done = done;
+}
+
+void LoadGen::OnSetupLoggedIn(LoadUser& user)
+{
+    if(!m_rootid)
+    {
+        fprintf(stderr, "Root channel not found\n");
+        m_setup_failed = true;
+        return;
+    }
+    MakeChannels(user);
+}
+
+void LoadGen::OnAddChannel(LoadUser& user, int chanid, int parentid,
+                           const ACE_TString& name)
+{
+    if(parentid == 0)
+    {
+        m_rootid = chanid;
+        return;
+    }
+    for(size_t i=0;i<m_tree.size();i++)
+    {
+        if(m_tree[i].name == name && GetParentID(m_tree[i]) == parentid)
+            m_tree[i].chanid = chanid;
+    }
+}
+
+void LoadGen::OnMakeChannelDone(LoadUser& user, bool success)
+{
+    if(!success)
+    {
+        m_setup_failed = true;
+        return;
+    }
+    MakeChannels(user);
+}
+
+bool LoadGen::ConnectUsers()
+{
+    //users in each channel in the order they are assigned
+    std::vector<int> chan_users(m_tree.size());
+    uint32_t now = GETTIMESTAMP();
+    for(int i=0;i<m_cfg.users;i++)
+    {
+        if(i > 0)
+        {
+            LoadUser* user;
+            ACE_NEW_RETURN(user, LoadUser(*this, i, m_reactor), false);
+            m_users.push_back(user);
+            user->Connect(m_tcpaddr, m_udpaddr);
+        }
+
+        size_t c = i % m_tree.size();
+        m_users[i]->SetChannel(m_tree[c].chanid);
+        for(int m=0;m<MEDIA_COUNT;m++)
+        {
+            //spread senders over the send interval
+            if(chan_users[c] < m_cfg.senders[m])
+                m_users[i]->SetSender(MediaType(m), now + ACE_OS::rand() % m_cfg.interval_msec[m]);
+        }
+        chan_users[c]++;
+
+        //let the reactor keep up with the logins
+        if(i % 50 == 0)
+        {
+            ACE_Time_Value tv = ACE_Time_Value::zero;
+            m_reactor->handle_events(&tv);
+        }
+    }
+    return true;
+}
+
+bool LoadGen::Run()
+{
+    if(!LoadVoiceFrames())
+        return false;
+
+    BuildTree();
+    if(m_tree.empty())
+    {
+        fprintf(stderr, "Channel tree is empty\n");
+        return false;
+    }
+
+    ACE_Time_Value tick(0, TICK_MSEC * 1000);
+    m_reactor->schedule_timer(this, 0, tick, tick);
+
+    //the first user creates the channel tree
+    LoadUser* setup;
+    ACE_NEW_RETURN(setup, LoadUser(*this, 0, m_reactor), false);
+    m_users.push_back(setup);
+    if(!setup->Connect(m_tcpaddr, m_udpaddr))
+        return false;
+
+    ACE_Time_Value deadline = ACE_OS::gettimeofday() + ACE_Time_Value(SETUP_TIMEOUT_SEC);
+    while(!m_setup_done && !m_setup_failed &&
+          setup->GetState() != LoadUser::STATE_FAILED &&
+          ACE_OS::gettimeofday() < deadline)
+    {
+        ACE_Time_Value tv(0, 100000);
+        m_reactor->handle_events(&tv);
+    }
+    if(!m_setup_done)
+    {
+        fprintf(stderr, "Failed to create channel tree\n");
+        return false;
+    }
+    fprintf(stderr, "Created %d channels. Logging in %d users\n",
+            int(m_tree.size()), m_cfg.users);
+
+    if(!ConnectUsers())
+        return false;
+
+    //channel tree is ready so setup user can join
+    setup->Join();
+
+    printf("second,users,voice_tx,voice_rx,voice_loss_pct,voice_p50_msec,voice_p99_msec,"
+           "video_tx,video_rx,video_loss_pct,video_p50_msec,video_p99_msec,"
+           "desktop_tx,desktop_rx,desktop_p50_msec,desktop_p99_msec,"
+           "server_cpu_pct,loadgen_cpu_pct\n");
+
+    m_start = m_last_report = ACE_OS::gettimeofday();
+    GetServerCPU(m_server_cpu);
+    m_own_cpu = GetOwnCPU();
+    for(int i=0;i<MEDIA_COUNT;i++)
+        m_interval[i] = MediaStats();
+
+    ACE_Time_Value end_time = m_start + ACE_Time_Value(m_cfg.duration_sec);
+    while(ACE_OS::gettimeofday() < end_time)
+    {
+        ACE_Time_Value tv(0, 100000);
+        m_reactor->handle_events(&tv);
+    }
+
+    m_reactor->cancel_timer(this);
+    Report(true);
+
+    for(size_t i=0;i<m_users.size();i++)
+        m_users[i]->Close();
+    return true;
+}
+
+int LoadGen::handle_timeout(const ACE_Time_Value& tv, const void* arg)
+{
+    uint32_t now = GETTIMESTAMP();
+    for(size_t i=0;i<m_users.size();i++)
+        m_users[i]->Tick(now);
+
+    if(m_start != ACE_Time_Value::zero &&
+       ACE_OS::gettimeofday() - m_last_report >= ACE_Time_Value(m_cfg.report_sec))
+    {
+        Report(false);
+    }
+    return 0;
+}
+
+void LoadGen::Report(bool final)
+{
+    ACE_Time_Value now = ACE_OS::gettimeofday();
+    double elapsed = (now - m_last_report).msec() / 1000.0;
+    if(elapsed <= 0)
+        return;
+
+    double server_cpu = 0, server_pct = -1;
+    if(GetServerCPU(server_cpu))
+    {
+        server_pct = 100.0 * (server_cpu - m_server_cpu) / elapsed;
+        m_server_cpu_total += server_cpu - m_server_cpu;
+        m_server_cpu = server_cpu;
+    }
+    double own_cpu = GetOwnCPU();
+    double own_pct = 100.0 * (own_cpu - m_own_cpu) / elapsed;
+    m_own_cpu = own_cpu;
+
+    int active = 0;
+    for(size_t i=0;i<m_users.size();i++)
+        active += m_users[i]->GetState() == LoadUser::STATE_ACTIVE;
+
+    const MediaStats& voice = m_interval[MEDIA_VOICE];
+    const MediaStats& video = m_interval[MEDIA_VIDEO];
+    const MediaStats& desktop = m_interval[MEDIA_DESKTOP];
+    printf("%ld,%d,%ld,%ld,%.2f,%d,%d,%ld,%ld,%.2f,%d,%d,%ld,%ld,%d,%d,%.1f,%.1f\n",
+           long((now - m_start).sec()), active,
+           voice.sent, voice.received, voice.LossPercent(),
+           voice.Percentile(0.5), voice.Percentile(0.99),
+           video.sent, video.received, video.LossPercent(),
+           video.Percentile(0.5), video.Percentile(0.99),
+           desktop.sent, desktop.received,
+           desktop.Percentile(0.5), desktop.Percentile(0.99),
+           server_pct, own_pct);
+    fflush(stdout);
+
+    for(int i=0;i<MEDIA_COUNT;i++)
+    {
+        m_total[i].Add(m_interval[i]);
+        m_interval[i] = MediaStats();
+    }
+    m_last_report = now;
+    m_reports++;
+
+    if(!final)
+        return;
+
+    const char* names[MEDIA_COUNT] = { "voice", "video", "desktop" };
+    fprintf(stderr, "%d of %d users active\n", active, m_cfg.users);
+    for(int i=0;i<MEDIA_COUNT;i++)
+    {
+        const MediaStats& s = m_total[i];
+        fprintf(stderr, "%-8s %ld sent, %ld received, %.2f%% lost, "
+                "latency p50 %d msec, p99 %d msec\n", names[i],
+                s.sent, s.received, s.LossPercent(),
+                s.Percentile(0.5), s.Percentile(0.99));
+    }
+    double duration = (now - m_start).msec() / 1000.0;
+    if(m_cfg.server_pid && duration > 0)
+        fprintf(stderr, "server CPU %.1f%%\n", 100.0 * m_server_cpu_total / duration);
+}
+
+bool LoadGen::GetServerCPU(double& seconds) const
+{
+    if(!m_cfg.server_pid)
+        return false;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", m_cfg.server_pid);
+    FILE* f = fopen(path, "r");
+    if(!f)
+        return false;
+    char buf[1024];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+
+    //process name may contain spaces so skip to after it
+    const char* fields = strrchr(buf, ')');
+    unsigned long utime, stime;
+    if(!fields || sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                         &utime, &stime) != 2)
+        return false;
+
+    seconds = double(utime + stime) / sysconf(_SC_CLK_TCK);
+    return true;
+}
+
+double LoadGen::GetOwnCPU() const
+{
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) < 0)
+        return 0;
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0 +
+        usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+}
+
+int ACE_TMAIN(int argc, ACE_TCHAR* argv[])
+{
+    LoadConfig cfg;
+
+    ACE_Get_Opt opt(argc, argv, ACE_TEXT("h:p:u:l:c:v:V:D:f:t:i:s:"));
+    int c;
+    while((c = opt()) != -1)
+    {
+        ACE_TString arg = opt.opt_arg()? opt.opt_arg() : ACE_TEXT("");
+        switch(c)
+        {
+        case 'h' : cfg.host = arg; break;
+        case 'p' : cfg.port = ACE_OS::atoi(arg.c_str()); break;
+        case 'u' : cfg.users = ACE_OS::atoi(arg.c_str()); break;
+        case 'l' :
+        {
+            size_t colon = arg.find(':');
+            cfg.username = arg.substr(0, colon);
+            if(colon != ACE_TString::npos)
+                cfg.password = arg.substr(colon + 1);
+            break;
+        }
+        case 'c' :
+        {
+            cfg.fanout.clear();
+            strings_t tokens = tokenize(arg, ACE_TEXT(","));
+            for(size_t i=0;i<tokens.size();i++)
+                cfg.fanout.push_back(ACE_OS::atoi(tokens[i].c_str()));
+            break;
+        }
+        case 'v' : cfg.senders[MEDIA_VOICE] = ACE_OS::atoi(arg.c_str()); break;
+        case 'V' : cfg.senders[MEDIA_VIDEO] = ACE_OS::atoi(arg.c_str()); break;
+        case 'D' : cfg.senders[MEDIA_DESKTOP] = ACE_OS::atoi(arg.c_str()); break;
+        case 'f' : cfg.voice_file = arg.c_str(); break;
+        case 't' : cfg.duration_sec = ACE_OS::atoi(arg.c_str()); break;
+        case 'i' : cfg.report_sec = ACE_OS::atoi(arg.c_str()); break;
+        case 's' : cfg.server_pid = ACE_OS::atoi(arg.c_str()); break;
+        default :
+            fprintf(stderr, "Usage: loadgen [-h host] [-p port] [-u users] "
+                    "[-l username:password] [-c fanout[,fanout...]] "
+                    "[-v voice senders] [-V video senders] [-D desktop senders] "
+                    "[-f voice frames file] [-t seconds] [-i report interval] "
+                    "[-s server pid]\n");
+            return 1;
+        }
+    }
+    if(cfg.users <= 0 || cfg.duration_sec <= 0 || cfg.report_sec <= 0)
+    {
+        fprintf(stderr, "Invalid arguments\n");
+        return 1;
+    }
+
+    //every user needs a TCP and a UDP socket
+    struct rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rlim_t(cfg.users * 2 + 64))
+    {
+        rl.rlim_cur = std::min(rl.rlim_max, rlim_t(cfg.users * 2 + 64));
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+#if defined(ACE_HAS_EVENT_POLL) || defined(ACE_HAS_DEV_POLL)
+    //select() cannot handle thousands of sockets
+    ACE_Dev_Poll_Reactor* impl;
+    ACE_NEW_RETURN(impl, ACE_Dev_Poll_Reactor(cfg.users * 2 + 64), 1);
+#else
+    ACE_Select_Reactor* impl;
+    ACE_NEW_RETURN(impl, ACE_Select_Reactor(), 1);
+#endif
+    ACE_Reactor reactor(impl, true);
+
+    LoadGen gen(cfg, &reactor);
+    return gen.Run()? 0 : 1;
+}
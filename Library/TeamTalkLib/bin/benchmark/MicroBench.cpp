@@ -0,0 +1,712 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ *
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+/* Micro-benchmarks of the packet, codec and DSP hot paths.
+ *
+ * Every test is calibrated so one run takes about 1/5 of the time
+ * given per test, then run 5 times and the median is reported. No
+ * sound or video devices are needed so the results of two commits
+ * can be compared on any Linux box. Results are written as CSV to
+ * stdout:
+ *
+ * suite,name,iterations,nsec_per_op,mbytes_per_sec
+ *
+ * 'mbytes_per_sec' is 0 for tests that do not process a buffer.
+ * Only tests whose "suite/name" contains 'filter' are run.
+ *
+ * Usage: microbench [filter] [msec per test] */
+
+#include <teamtalk/PacketLayout.h>
+#include <teamtalk/Commands.h>
+#include <teamtalk/DesktopSession.h>
+#include <teamtalk/server/ServerNode.h>
+#include <teamtalk/server/ServerUser.h>
+#include <teamtalk/server/ServerChannel.h>
+#include <soundsystem/SoundSystemBase.h>
+#include <codec/AudioResampler.h>
+#include <codec/MediaUtil.h>
+#include <codec/VideoConvert.h>
+#if defined(ENABLE_OPUS)
+#include <codec/OpusEncoder.h>
+#include <codec/OpusDecoder.h>
+#endif
+#if defined(ENABLE_SPEEX)
+#include <codec/SpeexEncoder.h>
+#include <codec/SpeexDecoder.h>
+#endif
+
+#include <ace/OS_main.h>
+#include <ace/Reactor.h>
+#include <ace/Thread.h>
+
+#include <zlib.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace teamtalk;
+using namespace soundsystem;
+
+#define REPEATS         5
+#define DEFAULT_MSEC    500
+
+typedef std::function<void()> benchfunc_t;
+
+static std::string filter;
+static int msec_per_test = DEFAULT_MSEC;
+
+//results are added here so the compiler cannot drop the work
+static volatile uint32_t sink;
+
+static void Consume(uint32_t value)
+{
+    sink = sink + value;
+}
+
+static double TimeIterations(const benchfunc_t& op, long iterations)
+{
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for(long i=0;i<iterations;i++)
+        op();
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - begin;
+    return double(elapsed.count());
+}
+
+static void RunBench(const char* suite, const std::string& name,
+                     double bytes_per_op, const benchfunc_t& op)
+{
+    std::string fullname = std::string(suite) + "/" + name;
+    if(filter.size() && fullname.find(filter) == std::string::npos)
+        return;
+
+    //warm up caches and lazily allocated buffers
+    op();
+
+    double target = msec_per_test * 1e6 / REPEATS;
+    long iterations = 1;
+    while(TimeIterations(op, iterations) < target && iterations < (1L << 30))
+        iterations *= 2;
+
+    std::vector<double> nsec_per_op;
+    for(int r=0;r<REPEATS;r++)
+        nsec_per_op.push_back(TimeIterations(op, iterations) / iterations);
+    std::sort(nsec_per_op.begin(), nsec_per_op.end());
+    double median = nsec_per_op[REPEATS / 2];
+
+    double mbytes_per_sec = 0;
+    if(bytes_per_op > 0 && median > 0)
+        mbytes_per_sec = (bytes_per_op / median) * 1e9 / (1024 * 1024);
+
+    printf("%s,%s,%ld,%.1f,%.1f\n", suite, name.c_str(), iterations,
+           median, mbytes_per_sec);
+    fflush(stdout);
+}
+
+static std::string Name(const char* prefix, int value)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s_%d", prefix, value);
+    return buf;
+}
+
+static void FillRandom(std::vector<char>& buf, size_t size)
+{
+    buf.resize(size);
+    for(size_t i=0;i<buf.size();i++)
+        buf[i] = char(rand());
+}
+
+static void FillTone(std::vector<short>& buf, int samples, int channels,
+                     int samplerate)
+{
+    buf.resize(samples * channels);
+    for(int i=0;i<samples;i++)
+    {
+        short v = short(8000 * sin(2.0 * M_PI * 440.0 * i / samplerate));
+        for(int c=0;c<channels;c++)
+            buf[i * channels + c] = v;
+    }
+}
+
+//copy the iovec buffers of a packet into one datagram
+static std::vector<char> Flatten(const FieldPacket& packet)
+{
+    std::vector<char> data;
+    int buffers = 0;
+    const iovec* v = packet.GetPacket(buffers);
+    for(int i=0;i<buffers;i++)
+    {
+        const char* base = reinterpret_cast<const char*>(v[i].iov_base);
+        data.insert(data.end(), base, base + v[i].iov_len);
+    }
+    return data;
+}
+
+/* FieldPacket construction and parsing */
+
+#define VOICE_ENC_BYTES     80
+#define VIDEO_ENC_BYTES     1000
+#define DESKTOP_BLOCKS      8
+#define DESKTOP_BLOCK_BYTES 120
+
+static VoicePacket* NewVoicePacket(const std::vector<char>& enc, uint16_t packet_no)
+{
+    VoicePacket* packet = new VoicePacket(PACKET_KIND_VOICE, 1, GETTIMESTAMP(), 1,
+                                          packet_no, &enc[0], uint16_t(enc.size()));
+    packet->SetChannel(2);
+    return packet;
+}
+
+static VideoPacket* NewVideoPacket(const std::vector<char>& enc, uint32_t packet_no)
+{
+    uint16_t width = 640, height = 480;
+    VideoPacket* packet = new VideoPacket(PACKET_KIND_VIDEO, 1, GETTIMESTAMP(), 1,
+                                          packet_no, &width, &height,
+                                          &enc[0], uint16_t(enc.size()));
+    packet->SetChannel(2);
+    return packet;
+}
+
+static DesktopPacket* NewDesktopPacket(const std::vector<char>& blockdata)
+{
+    map_block_t blocks;
+    for(int i=0;i<DESKTOP_BLOCKS;i++)
+    {
+        desktop_block block;
+        block.block_data = &blockdata[i * DESKTOP_BLOCK_BYTES];
+        block.block_size = DESKTOP_BLOCK_BYTES;
+        blocks[uint16_t(i)] = block;
+    }
+    DesktopPacket* packet = new DesktopPacket(1, GETTIMESTAMP(), 1, 640, 480, BMP_RGB32,
+                                              0, 1, blocks, block_frags_t(),
+                                              mmap_dup_blocks_t());
+    packet->SetChannel(2);
+    return packet;
+}
+
+static void BenchPackets()
+{
+    std::vector<char> voice_enc, video_enc, desktop_data;
+    FillRandom(voice_enc, VOICE_ENC_BYTES);
+    FillRandom(video_enc, VIDEO_ENC_BYTES);
+    FillRandom(desktop_data, DESKTOP_BLOCKS * DESKTOP_BLOCK_BYTES);
+
+    uint16_t packet_no = 0;
+    RunBench("packet", "voice_build", VOICE_ENC_BYTES, [&]()
+    {
+        std::unique_ptr<VoicePacket> p(NewVoicePacket(voice_enc, packet_no++));
+        Consume(p->GetPacketSize());
+    });
+
+    std::unique_ptr<VoicePacket> voice(NewVoicePacket(voice_enc, 1));
+    std::vector<char> voice_data = Flatten(*voice);
+    RunBench("packet", "voice_parse", VOICE_ENC_BYTES, [&]()
+    {
+        VoicePacket p(&voice_data[0], uint16_t(voice_data.size()));
+        uint16_t len = 0;
+        p.ValidatePacket();
+        p.GetEncodedAudio(len);
+        Consume(len + p.GetPacketNumber() + p.GetStreamID());
+    });
+
+    RunBench("packet", "video_build", VIDEO_ENC_BYTES, [&]()
+    {
+        std::unique_ptr<VideoPacket> p(NewVideoPacket(video_enc, packet_no++));
+        Consume(p->GetPacketSize());
+    });
+
+    std::unique_ptr<VideoPacket> video(NewVideoPacket(video_enc, 1));
+    std::vector<char> video_data = Flatten(*video);
+    RunBench("packet", "video_parse", VIDEO_ENC_BYTES, [&]()
+    {
+        VideoPacket p(&video_data[0], uint16_t(video_data.size()));
+        uint16_t len = 0;
+        p.ValidatePacket();
+        p.GetEncodedData(len);
+        Consume(len + p.GetPacketNo());
+    });
+
+    RunBench("packet", "desktop_build", DESKTOP_BLOCKS * DESKTOP_BLOCK_BYTES, [&]()
+    {
+        std::unique_ptr<DesktopPacket> p(NewDesktopPacket(desktop_data));
+        Consume(p->GetPacketSize());
+    });
+
+    std::unique_ptr<DesktopPacket> desktop(NewDesktopPacket(desktop_data));
+    std::vector<char> desktop_pkt = Flatten(*desktop);
+    RunBench("packet", "desktop_parse", DESKTOP_BLOCKS * DESKTOP_BLOCK_BYTES, [&]()
+    {
+        DesktopPacket p(&desktop_pkt[0], uint16_t(desktop_pkt.size()));
+        map_block_t blocks;
+        p.ValidatePacket();
+        p.GetBlocks(blocks);
+        Consume(uint32_t(blocks.size()));
+    });
+}
+
+/* CryptPacket encrypt/decrypt */
+
+static void BenchCrypt()
+{
+#if defined(ENABLE_ENCRYPTION)
+    uint8_t key[CRYPTKEY_SIZE];
+    for(int i=0;i<CRYPTKEY_SIZE;i++)
+        key[i] = uint8_t(rand());
+
+    std::vector<char> voice_enc, video_enc;
+    FillRandom(voice_enc, VOICE_ENC_BYTES);
+    FillRandom(video_enc, VIDEO_ENC_BYTES);
+
+    std::unique_ptr<VoicePacket> voice(NewVoicePacket(voice_enc, 1));
+    RunBench("crypt", "voice_encrypt", VOICE_ENC_BYTES, [&]()
+    {
+        CryptVoicePacket p(*voice, key);
+        Consume(p.GetPacketSize());
+    });
+
+    std::vector<char> voice_data = Flatten(CryptVoicePacket(*voice, key));
+    RunBench("crypt", "voice_decrypt", VOICE_ENC_BYTES, [&]()
+    {
+        CryptVoicePacket p(&voice_data[0], uint16_t(voice_data.size()));
+        std::unique_ptr<VoicePacket> decrypted(p.Decrypt(key));
+        Consume(decrypted.get() != NULL);
+    });
+
+    std::unique_ptr<VideoPacket> video(NewVideoPacket(video_enc, 1));
+    RunBench("crypt", "video_encrypt", VIDEO_ENC_BYTES, [&]()
+    {
+        CryptVideoCapturePacket p(*video, key);
+        Consume(p.GetPacketSize());
+    });
+
+    std::vector<char> video_data = Flatten(CryptVideoCapturePacket(*video, key));
+    RunBench("crypt", "video_decrypt", VIDEO_ENC_BYTES, [&]()
+    {
+        CryptVideoCapturePacket p(&video_data[0], uint16_t(video_data.size()));
+        std::unique_ptr<VideoPacket> decrypted(p.Decrypt(key));
+        Consume(decrypted.get() != NULL);
+    });
+#endif
+}
+
+/* ServerNode::GetPacketDestinations on a synthetic channel tree */
+
+#define SUBCHANNELS 8
+
+static void BenchServer()
+{
+    //never deleted since ~ServerNode() calls StopServer() which
+    //requires a ServerNodeListener
+    ServerNode* servernode = new ServerNode(ACE_TEXT("microbench"),
+                                            ACE_Reactor::instance(),
+                                            ACE_Reactor::instance(),
+                                            ACE_Reactor::instance());
+    servernode->m_reactor_thr_id = ACE_Thread::self();
+
+    const int usercounts[] = { 10, 100, 1000 };
+    for(size_t n=0;n<sizeof(usercounts)/sizeof(usercounts[0]);n++)
+    {
+        int usercount = usercounts[n];
+
+        serverchannel_t root(new ServerChannel(1));
+        serverchannel_t chan;
+        for(int c=0;c<SUBCHANNELS;c++)
+        {
+            chan = serverchannel_t(new ServerChannel(root, 2 + c, Name("chan", c).c_str()));
+            root->AddSubChannel(chan);
+        }
+
+        //all users are in the last sub-channel
+        std::vector<serveruser_t> users;
+        for(int i=0;i<usercount;i++)
+        {
+            serveruser_t user(new ServerUser(i + 1, *servernode, ACE_INVALID_HANDLE));
+            user->SetUdpAddress(ACE_INET_Addr(u_short(10000 + i), ACE_UINT32(INADDR_LOOPBACK)));
+            user->SetPacketProtocol(TEAMTALK_PACKET_PROTOCOL);
+            chan->AddUser(user->GetUserID(), user);
+            users.push_back(user);
+        }
+
+        std::vector<char> voice_enc;
+        FillRandom(voice_enc, VOICE_ENC_BYTES);
+        std::unique_ptr<VoicePacket> packet(NewVoicePacket(voice_enc, 1));
+        packet->SetChannel(uint16_t(chan->GetChannelID()));
+
+        const ServerUser& src = *users[0];
+        RunBench("server", Name("destinations_users", usercount), 0, [&]()
+        {
+            std::vector<ACE_INET_Addr> addrs;
+            servernode->GetPacketDestinations(src, *chan, *packet, SUBSCRIBE_VOICE,
+                                              SUBSCRIBE_INTERCEPT_VOICE, addrs);
+            Consume(uint32_t(addrs.size()));
+        });
+
+        chan->SetChannelType(CHANNEL_OPERATOR_RECVONLY);
+        chan->AddOperator(users[usercount - 1]->GetUserID());
+        RunBench("server", Name("destinations_recvonly_users", usercount), 0, [&]()
+        {
+            std::vector<ACE_INET_Addr> addrs;
+            servernode->GetPacketDestinations(src, *chan, *packet, SUBSCRIBE_VOICE,
+                                              SUBSCRIBE_INTERCEPT_VOICE, addrs);
+            Consume(uint32_t(addrs.size()));
+        });
+    }
+}
+
+/* ExtractProperties/AppendProperty */
+
+static ACE_TString BuildAddUser()
+{
+    ACE_TString cmd = ACE_TEXT("adduser");
+    AppendProperty(ACE_TEXT("userid"), 1234, cmd);
+    AppendProperty(ACE_TEXT("nickname"), ACE_TString(ACE_TEXT("Some \"quoted\" nickname")), cmd);
+    AppendProperty(ACE_TEXT("username"), ACE_TString(ACE_TEXT("someuser")), cmd);
+    AppendProperty(ACE_TEXT("ipaddr"), ACE_TString(ACE_TEXT("192.168.100.123")), cmd);
+    AppendProperty(ACE_TEXT("statusmode"), 0, cmd);
+    AppendProperty(ACE_TEXT("statusmsg"), ACE_TString(ACE_TEXT("Away\r\nfor lunch")), cmd);
+    AppendProperty(ACE_TEXT("usertype"), 1, cmd);
+    AppendProperty(ACE_TEXT("chanid"), 42, cmd);
+    AppendProperty(ACE_TEXT("sublocal"), ACE_UINT32(SUBSCRIBE_LOCAL_DEFAULT), cmd);
+    AppendProperty(ACE_TEXT("subpeer"), ACE_UINT32(SUBSCRIBE_PEER_DEFAULT), cmd);
+    AppendProperty(ACE_TEXT("clientname"), ACE_TString(ACE_TEXT("TeamTalk")), cmd);
+    AppendProperty(ACE_TEXT("version"), ACE_TString(ACE_TEXT("5.3.0.4900")), cmd);
+    cmd += EOL;
+    return cmd;
+}
+
+static void BenchCommands()
+{
+    ACE_TString line = BuildAddUser();
+    double bytes = double(line.length() * sizeof(ACE_TCHAR));
+
+    RunBench("command", "extract_adduser", bytes, [&]()
+    {
+        mstrings_t properties;
+        Consume(ExtractProperties(line, properties));
+    });
+
+    RunBench("command", "append_adduser", bytes, [&]()
+    {
+        Consume(uint32_t(BuildAddUser().length()));
+    });
+}
+
+/* MuxPlayers and SOFTGAIN */
+
+#define MUX_SAMPLERATE  48000
+#define MUX_CHANNELS    2
+#define MUX_FRAMESIZE   (MUX_SAMPLERATE * 20 / 1000)
+
+class TonePlayer : public StreamPlayer
+{
+public:
+    TonePlayer() { FillTone(m_tone, MUX_FRAMESIZE, MUX_CHANNELS, MUX_SAMPLERATE); }
+
+    bool StreamPlayerCb(const OutputStreamer& streamer, short* buffer, int samples)
+    {
+        memcpy(buffer, &m_tone[0], PCM16_BYTES(samples, streamer.channels));
+        return true;
+    }
+    void StreamPlayerCbEnded() {}
+
+private:
+    std::vector<short> m_tone;
+};
+
+static void BenchAudio()
+{
+    int sndgrpid = SOUNDSYSTEM->OpenSoundGroup();
+    std::vector<short> tmp_buffer(MUX_FRAMESIZE * MUX_CHANNELS);
+    std::vector<short> playback(MUX_FRAMESIZE * MUX_CHANNELS);
+    int frame_bytes = int(PCM16_BYTES(MUX_FRAMESIZE, MUX_CHANNELS));
+
+    const int playercounts[] = { 1, 8, 32 };
+    for(size_t n=0;n<sizeof(playercounts)/sizeof(playercounts[0]);n++)
+    {
+        TonePlayer player;
+        std::vector<OutputStreamer*> streamers;
+        for(int i=0;i<playercounts[n];i++)
+        {
+            streamers.push_back(new OutputStreamer(&player, sndgrpid, MUX_FRAMESIZE,
+                                                   MUX_SAMPLERATE, MUX_CHANNELS,
+                                                   SOUND_API_NOSOUND));
+            //not default volume so SoftVolume() applies SOFTGAIN
+            streamers.back()->volume = VOLUME_DEFAULT / 2;
+        }
+
+        RunBench("audio", Name("muxplayers", playercounts[n]),
+                 double(frame_bytes) * playercounts[n], [&]()
+        {
+            memset(&playback[0], 0, frame_bytes);
+            MuxPlayers(streamers, &tmp_buffer[0], &playback[0]);
+            Consume(uint32_t(playback[0]));
+        });
+
+        for(size_t i=0;i<streamers.size();i++)
+            delete streamers[i];
+    }
+
+    std::vector<short> tone;
+    FillTone(tone, MUX_FRAMESIZE, MUX_CHANNELS, MUX_SAMPLERATE);
+    RunBench("audio", "softgain", frame_bytes, [&]()
+    {
+        short* buffer = &tmp_buffer[0];
+        memcpy(buffer, &tone[0], frame_bytes);
+        SOFTGAIN(buffer, MUX_FRAMESIZE, MUX_CHANNELS, 0.5f);
+        Consume(uint32_t(buffer[1]));
+    });
+
+    SOUNDSYSTEM->RemoveSoundGroup(sndgrpid);
+}
+
+/* AudioResampler implementations */
+
+struct ResamplerConfig
+{
+    int in_rate, in_channels, out_rate, out_channels;
+};
+
+static void BenchResamplers()
+{
+    struct Backend
+    {
+        const char* name;
+        AudioResamplerType type;
+    };
+    const Backend backends[] =
+    {
+        { "polyphase", AUDIORESAMPLER_POLYPHASE },
+#if defined(ENABLE_SPEEX)
+        { "speex", AUDIORESAMPLER_SPEEX },
+#endif
+#if defined(ENABLE_FFMPEG3)
+        { "ffmpeg", AUDIORESAMPLER_FFMPEG },
+#endif
+    };
+    const ResamplerConfig configs[] =
+    {
+        { 48000, 1, 16000, 1 },
+        { 16000, 1, 48000, 1 },
+        { 44100, 2, 48000, 2 },
+    };
+
+    for(size_t b=0;b<sizeof(backends)/sizeof(backends[0]);b++)
+    {
+        for(size_t c=0;c<sizeof(configs)/sizeof(configs[0]);c++)
+        {
+            const ResamplerConfig& cfg = configs[c];
+            audio_resampler_t resampler = MakeAudioResampler(cfg.in_channels, cfg.in_rate,
+                                                             cfg.out_channels, cfg.out_rate,
+                                                             backends[b].type);
+            if(resampler.null())
+                continue;
+
+            //20 msec blocks
+            int in_samples = cfg.in_rate / 50, out_samples = cfg.out_rate / 50;
+            std::vector<short> input, output(out_samples * cfg.out_channels);
+            FillTone(input, in_samples, cfg.in_channels, cfg.in_rate);
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s_%dx%d_to_%dx%d", backends[b].name,
+                     cfg.in_rate, cfg.in_channels, cfg.out_rate, cfg.out_channels);
+            RunBench("resampler", name, double(PCM16_BYTES(in_samples, cfg.in_channels)), [&]()
+            {
+                Consume(resampler->Resample(&input[0], in_samples,
+                                            &output[0], out_samples));
+            });
+        }
+    }
+}
+
+/* Opus/Speex encode and decode */
+
+static void BenchCodecs()
+{
+#if defined(ENABLE_OPUS)
+    {
+        const int samplerate = 48000, channels = 1, framesize = samplerate / 50;
+        std::vector<short> input, output(framesize * channels);
+        FillTone(input, framesize, channels, samplerate);
+        std::vector<char> enc(4000);
+
+        OpusEncode encoder;
+        OpusDecode decoder;
+        if(encoder.Open(samplerate, channels, OPUS_APPLICATION_VOIP) &&
+           encoder.SetBitrate(32000) && decoder.Open(samplerate, channels))
+        {
+            RunBench("codec", "opus_encode_48000x1", PCM16_BYTES(framesize, channels), [&]()
+            {
+                Consume(encoder.Encode(&input[0], framesize, &enc[0], int(enc.size())));
+            });
+
+            int enc_len = encoder.Encode(&input[0], framesize, &enc[0], int(enc.size()));
+            RunBench("codec", "opus_decode_48000x1", PCM16_BYTES(framesize, channels), [&]()
+            {
+                Consume(decoder.Decode(&enc[0], enc_len, &output[0], framesize));
+            });
+        }
+    }
+#endif
+
+#if defined(ENABLE_SPEEX)
+    {
+        const int samplerate = 16000, framesize = samplerate / 50;
+        std::vector<short> input, output(framesize);
+        FillTone(input, framesize, 1, samplerate);
+        std::vector<char> enc(1000);
+
+        SpeexEncoder encoder;
+        SpeexDecoder decoder;
+        if(encoder.Initialize(SPEEX_MODEID_WB, 4, 8) &&
+           decoder.Initialize(SPEEX_MODEID_WB))
+        {
+            RunBench("codec", "speex_encode_16000x1", PCM16_BYTES(framesize, 1), [&]()
+            {
+                Consume(encoder.Encode(&input[0], &enc[0], int(enc.size())));
+            });
+
+            int enc_len = encoder.Encode(&input[0], &enc[0], int(enc.size()));
+            RunBench("codec", "speex_decode_16000x1", PCM16_BYTES(framesize, 1), [&]()
+            {
+                Consume(decoder.Decode(&enc[0], enc_len, &output[0]));
+            });
+        }
+    }
+#endif
+}
+
+/* RGB32ToI420/I420ToRGB32 */
+
+static void BenchVideo()
+{
+    const int sizes[][2] = { { 640, 480 }, { 1280, 720 } };
+    for(size_t s=0;s<sizeof(sizes)/sizeof(sizes[0]);s++)
+    {
+        int width = sizes[s][0], height = sizes[s][1];
+        std::vector<char> rgb32, i420;
+        FillRandom(rgb32, RGB32_BYTES(width, height));
+        FillRandom(i420, I420_BYTES(width, height));
+
+        char name[64];
+        snprintf(name, sizeof(name), "rgb32_to_i420_%dx%d", width, height);
+        RunBench("video", name, RGB32_BYTES(width, height), [&]()
+        {
+            RGB32ToI420(&rgb32[0], width, height, false, &i420[0]);
+            Consume(uint32_t(i420[0]));
+        });
+
+        snprintf(name, sizeof(name), "i420_to_rgb32_%dx%d", width, height);
+        RunBench("video", name, RGB32_BYTES(width, height), [&]()
+        {
+            I420ToRGB32(&i420[0], width, height, &rgb32[0]);
+            Consume(uint32_t(rgb32[0]));
+        });
+    }
+}
+
+/* desktop block CRC and compression */
+
+#define DESKTOP_BLOCK_WIDTH     51
+#define DESKTOP_BLOCK_HEIGHT    20
+#define COMPRESS_WINDOW_BITS    12
+
+static void BenchDesktop()
+{
+    //a gradient with a bit of noise compresses like a typical
+    //screen region rather than like random data
+    std::vector<char> block(RGB32_BYTES(DESKTOP_BLOCK_WIDTH, DESKTOP_BLOCK_HEIGHT));
+    for(size_t i=0;i<block.size();i++)
+        block[i] = char((i / 4) % DESKTOP_BLOCK_WIDTH * 4 + (rand() % 4 == 0));
+
+    RunBench("desktop", "block_crc32c", double(block.size()), [&]()
+    {
+        Consume(BlockCRC32C(&block[0], block.size()));
+    });
+
+    struct Level
+    {
+        const char* name;
+        int level;
+    };
+    const Level levels[] =
+    {
+        { "block_deflate_default", Z_DEFAULT_COMPRESSION },
+        { "block_deflate_fast", Z_BEST_SPEED },
+    };
+    for(size_t l=0;l<sizeof(levels)/sizeof(levels[0]);l++)
+    {
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));
+        if(deflateInit2(&strm, levels[l].level, Z_DEFLATED, COMPRESS_WINDOW_BITS,
+                        8, Z_DEFAULT_STRATEGY) != Z_OK)
+            continue;
+
+        std::vector<char> out(deflateBound(&strm, uLong(block.size())));
+        RunBench("desktop", levels[l].name, double(block.size()), [&]()
+        {
+            deflateReset(&strm);
+            strm.next_in = reinterpret_cast<Bytef*>(&block[0]);
+            strm.avail_in = uInt(block.size());
+            strm.next_out = reinterpret_cast<Bytef*>(&out[0]);
+            strm.avail_out = uInt(out.size());
+            deflate(&strm, Z_FINISH);
+            Consume(uint32_t(strm.total_out));
+        });
+        deflateEnd(&strm);
+    }
+}
+
+int ACE_TMAIN(int argc, ACE_TCHAR* argv[])
+{
+    if(argc > 1)
+        filter = argv[1];
+    if(argc > 2)
+        msec_per_test = std::max(1, atoi(argv[2]));
+
+    srand(0);
+
+    printf("suite,name,iterations,nsec_per_op,mbytes_per_sec\n");
+
+    BenchPackets();
+    BenchCrypt();
+    BenchServer();
+    BenchCommands();
+    BenchAudio();
+    BenchResamplers();
+    BenchCodecs();
+    BenchVideo();
+    BenchDesktop();
+
+    fprintf(stderr, "Video conversion: %s\n",
+            GetVideoConvertImplName(GetVideoConvertImpl()));
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+/* Compares the resampler backends on throughput and accuracy.
+ *
+ * A 1 kHz sine is fed through each backend in 10 msec blocks like
+ * the sound system callbacks do. Results are written as CSV to
+ * stdout:
+ *
+ * backend,in_rate,in_channels,out_rate,out_channels,nsec_per_sample,realtime_factor,snr_db,fifo_errors
+ *
+ * Usage: resamplerbench [seconds of audio per test] */
+
+#include <codec/AudioResampler.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#if !defined(M_PI)
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TONE_FREQUENCY 1000.0
+#define TONE_AMPLITUDE 10000.0
+#define BLOCK_MSEC 10
+//max delay in output samples searched when measuring accuracy
+#define MAX_DELAY 512
+
+struct Backend
+{
+    AudioResamplerType type;
+    const char* name;
+};
+
+static void GenerateTone(std::vector<short>& buffer, int samples, int channels,
+                         int samplerate, long& sample_index)
+{
+    for(int i=0;i<samples;i++)
+    {
+        double t = double(sample_index++) / samplerate;
+        short v = short(TONE_AMPLITUDE * sin(2.0 * M_PI * TONE_FREQUENCY * t));
+        for(int c=0;c<channels;c++)
+            buffer[i * channels + c] = v;
+    }
+}
+
+//signal-to-noise ratio of first channel against an ideal tone at
+//the best matching delay
+static double MeasureSNR(const std::vector<short>& output, int channels, int samplerate)
+{
+    size_t samples = output.size() / channels;
+    //skip filter settling
+    size_t start = MAX_DELAY + samplerate / 10;
+    if(samples <= start)
+        return 0;
+
+    double best = -1000;
+    for(int delay=0;delay<MAX_DELAY;delay++)
+    {
+        double signal = 0, noise = 0;
+        for(size_t i=start;i<samples;i++)
+        {
+            double t = double(long(i) - delay) / samplerate;
+            double ref = TONE_AMPLITUDE * sin(2.0 * M_PI * TONE_FREQUENCY * t);
+            double err = output[i * channels] - ref;
+            signal += ref * ref;
+            noise += err * err;
+        }
+        double snr = (noise > 0)? 10.0 * log10(signal / noise) : 200.0;
+        if(snr > best)
+            best = snr;
+    }
+    return best;
+}
+
+static void RunTest(const Backend& backend, int in_rate, int in_channels,
+                    int out_rate, int out_channels, int seconds)
+{
+    audio_resampler_t resampler = MakeAudioResampler(in_channels, in_rate,
+                                                     out_channels, out_rate,
+                                                     backend.type);
+    if(resampler.null())
+        return;
+
+    int in_samples = in_rate * BLOCK_MSEC / 1000;
+    int out_samples = out_rate * BLOCK_MSEC / 1000;
+    int blocks = seconds * 1000 / BLOCK_MSEC;
+
+    std::vector<short> input(in_samples * in_channels);
+    std::vector<short> output(out_samples * out_channels);
+    //one second of output is kept for measuring accuracy
+    std::vector<short> captured;
+    captured.reserve(out_rate * out_channels);
+
+    long sample_index = 0;
+    std::chrono::nanoseconds elapsed(0);
+    for(int b=0;b<blocks;b++)
+    {
+        GenerateTone(input, in_samples, in_channels, in_rate, sample_index);
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        resampler->Resample(&input[0], in_samples, &output[0], out_samples);
+        elapsed += std::chrono::steady_clock::now() - begin;
+
+        if(captured.size() < size_t(out_rate * out_channels))
+            captured.insert(captured.end(), output.begin(), output.end());
+    }
+
+    double nsec = double(elapsed.count());
+    double total_out = double(blocks) * out_samples;
+    printf("%s,%d,%d,%d,%d,%.2f,%.1f,%.1f,%d\n", backend.name,
+           in_rate, in_channels, out_rate, out_channels,
+           nsec / total_out, (seconds * 1e9) / (nsec > 0? nsec : 1),
+           MeasureSNR(captured, out_channels, out_rate),
+           resampler->GetFIFOErrors());
+}
+
+int main(int argc, char* argv[])
+{
+    int seconds = (argc > 1)? atoi(argv[1]) : 60;
+    if(seconds < 1)
+        seconds = 1;
+
+    const Backend backends[] =
+    {
+        { AUDIORESAMPLER_POLYPHASE, "polyphase" },
+        { AUDIORESAMPLER_SPEEX,     "speex" },
+        { AUDIORESAMPLER_FFMPEG,    "ffmpeg" },
+        { AUDIORESAMPLER_DMO,       "dmo" },
+    };
+    const int rates[][2] =
+    {
+        { 44100, 48000 }, { 48000, 44100 },
+        { 48000, 16000 }, { 16000, 48000 },
+        { 48000, 8000 },  { 32000, 44100 },
+    };
+    const int channels[][2] = { { 1, 1 }, { 2, 2 }, { 2, 1 }, { 1, 2 } };
+
+    printf("backend,in_rate,in_channels,out_rate,out_channels,"
+           "nsec_per_sample,realtime_factor,snr_db,fifo_errors\n");
+
+    for(size_t b=0;b<sizeof(backends)/sizeof(backends[0]);b++)
+    {
+        for(size_t r=0;r<sizeof(rates)/sizeof(rates[0]);r++)
+        {
+            for(size_t c=0;c<sizeof(channels)/sizeof(channels[0]);c++)
+            {
+                RunTest(backends[b], rates[r][0], channels[c][0],
+                        rates[r][1], channels[c][1], seconds);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+/* Checks and times the color space conversions of each
+ * implementation the CPU supports.
+ *
+ * The scalar implementation is first compared to the converters it
+ * replaced, and every SIMD implementation to the scalar one, on
+ * random frames of even and odd sizes. The program exits with 1 if
+ * any output differs. Timings are written as CSV to stdout:
+ *
+ * impl,conversion,width,height,usec_per_frame,mpixels_per_sec
+ *
+ * Usage: videoconvertbench [frames per test] */
+
+#include <codec/VideoConvert.h>
+#include <codec/MediaUtil.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+enum Conversion
+{
+    CONV_I420_TO_RGB32,
+    CONV_RGB32_TO_I420,
+    CONV_YUY2_TO_I420,
+    CONV_NV12_TO_I420,
+    CONV_I420_SCALE_HALF,
+    CONV_COUNT
+};
+
+static const char* conversion_names[CONV_COUNT] =
+{
+    "i420_to_rgb32", "rgb32_to_i420", "yuy2_to_i420", "nv12_to_i420", "i420_scale_half"
+};
+
+struct Frame
+{
+    int width, height;
+    std::vector<char> rgb32, i420, yuy2, nv12;
+    std::vector<char> out;
+
+    Frame(int w, int h) : width(w), height(h)
+    {
+        int uv_size = ((w + 1) / 2) * ((h + 1) / 2);
+        Fill(rgb32, RGB32_BYTES(w, h));
+        Fill(i420, I420_BYTES(w, h));
+        Fill(yuy2, ((w + 1) / 2) * 4 * h);
+        Fill(nv12, w * h + uv_size * 2);
+        out.resize(RGB32_BYTES(w, h));
+    }
+
+    static void Fill(std::vector<char>& buf, int size)
+    {
+        buf.resize(size);
+        for(size_t i=0;i<buf.size();i++)
+            buf[i] = char(rand());
+    }
+};
+
+static void Convert(Conversion conv, Frame& frm)
+{
+    int w = frm.width, h = frm.height;
+    int uv_width = (w + 1) / 2;
+    uint8_t* out = reinterpret_cast<uint8_t*>(&frm.out[0]);
+
+    switch(conv)
+    {
+    case CONV_I420_TO_RGB32 :
+        I420ToRGB32(&frm.i420[0], w, h, &frm.out[0]);
+        break;
+    case CONV_RGB32_TO_I420 :
+        RGB32ToI420(&frm.rgb32[0], w, h, true, &frm.out[0]);
+        break;
+    case CONV_YUY2_TO_I420 :
+        YUY2ToI420(&frm.yuy2[0], w, h, &frm.out[0]);
+        break;
+    case CONV_NV12_TO_I420 :
+    {
+        const uint8_t* nv12 = reinterpret_cast<const uint8_t*>(&frm.nv12[0]);
+        NV12ToI420(nv12, w, nv12 + w * h, uv_width * 2, w, h,
+                   out, w, out + w * h, uv_width,
+                   out + w * h + uv_width * ((h + 1) / 2), uv_width);
+        break;
+    }
+    case CONV_I420_SCALE_HALF :
+        I420Scale(&frm.i420[0], w, h, &frm.out[0], (w + 1) / 2, (h + 1) / 2);
+        break;
+    case CONV_COUNT :
+        break;
+    }
+}
+
+/* The converters which VideoConvert replaced, copied from
+ * MediaUtil.cpp, VpxDecoder.cpp and VpxEncoder.cpp. Only the
+ * vpx_image_t argument has been replaced by planes and strides. */
+namespace legacy
+{
+    inline uint8_t CLAMP(int v)
+    {
+        if (v > 255)
+            return 255;
+        else if (v < 0)
+            return 0;
+        return (uint8_t)v;
+    }
+
+    //MediaUtil.cpp
+    void I420ToRGB32(const char* i420, int width, int height, char* rgb32)
+    {
+        const int uv_width = (width + 1) / 2;
+        const uint8_t* ptry = reinterpret_cast<const uint8_t*>(i420);
+        const uint8_t* ptru = ptry + width * height;
+        const uint8_t* ptrv = ptru + uv_width * ((height + 1) / 2);
+        uint8_t* ptro = reinterpret_cast<uint8_t*>(rgb32);
+
+        for(int i=0;i<height;i++)
+        {
+            const uint8_t* y_line = ptry + i * width;
+            const uint8_t* u_line = ptru + (i / 2) * uv_width;
+            const uint8_t* v_line = ptrv + (i / 2) * uv_width;
+            for(int j=0;j<width;j++)
+            {
+                int pr = (-56992 + v_line[j / 2] * 409) >> 8;
+                int pg = (34784 - u_line[j / 2] * 100 - v_line[j / 2] * 208) >> 8;
+                int pb = (-70688 + u_line[j / 2] * 516) >> 8;
+                int y = 298 * y_line[j] >> 8;
+                *ptro++ = CLAMP(y + pb);
+                *ptro++ = CLAMP(y + pg);
+                *ptro++ = CLAMP(y + pr);
+                *ptro++ = 255;
+            }
+        }
+    }
+
+    inline uint8_t CLAMP(short v)
+    {
+        if (v > 255)
+            return 255;
+        else if (v < 0)
+            return 0;
+        return (uint8_t)v;
+    }
+
+    /* VpxDecoder.cpp. Converts pixel pairs, so for odd widths it
+     * reads one luma sample past the width and writes one pixel past
+     * the end of each line. */
+    void I420toRGB32(const uint8_t* ptry, int y_stride,
+                     const uint8_t* ptru, int u_stride,
+                     const uint8_t* ptrv, int v_stride,
+                     unsigned int d_w, unsigned int d_h, uint8_t* outbuf)
+    {
+        uint8_t * ptro = outbuf;
+
+        for (unsigned int i = 0; i < d_h; i++) 
+        {
+            uint8_t* ptro2 = ptro;
+            for (unsigned int j = 0; j < d_w; j += 2) 
+            {
+                short pr, pg, pb, y;
+                short r, g, b;
+
+                pr = (-56992 + ptrv[j / 2] * 409) >> 8;
+                pg = (34784 - ptru[j / 2] * 100 - ptrv[j / 2] * 208) >> 8;
+                pb = (short)((-70688 + ptru[j / 2] * 516) >> 8);
+
+                y = 298*ptry[j] >> 8;
+                r = y + pr;
+                g = y + pg;
+                b = y + pb;
+
+                *ptro2++ = CLAMP(b);
+                *ptro2++ = CLAMP(g);
+                *ptro2++ = CLAMP(r);
+                *ptro2++ = 255;
+                y = 298*ptry[j + 1] >> 8;
+                r = y + pr;
+                g = y + pg;
+                b = y + pb;
+
+                *ptro2++ = CLAMP(b);
+                *ptro2++ = CLAMP(g);
+                *ptro2++ = CLAMP(r);
+                *ptro2++ = 255;
+            }
+            ptry += y_stride;
+            if (i & 1) 
+            {
+                ptru += u_stride;
+                ptrv += v_stride;
+            }
+            ptro += d_w * 4;
+        }
+    }
+
+#define rgbtoy(b, g, r, y) \
+y=(unsigned char)(((int)(30*r) + (int)(59*g) + (int)(11*b))/100)
+
+#define rgbtoyuv(b, g, r, y, u, v) \
+rgbtoy(b, g, r, y); \
+u=(unsigned char)(((int)(-17*r) - (int)(33*g) + (int)(50*b)+12800)/100); \
+v=(unsigned char)(((int)(50*r) - (int)(42*g) - (int)(8*b)+12800)/100)
+
+    /* VpxEncoder.cpp. Output is YV12, i.e. V plane before U plane.
+     * Only even sizes are supported. */
+    void RGB32toYUV420P(const unsigned char * rgb,
+                        unsigned char * yuv,
+                        unsigned rgbIncrement,
+                        unsigned char flip,
+                        int srcFrameWidth, int srcFrameHeight)
+    {
+        unsigned int planeSize;
+        unsigned int halfWidth;
+
+        unsigned char * yplane;
+        unsigned char * uplane;
+        unsigned char * vplane;
+        const unsigned char * rgbIndex;
+
+        int x, y;
+        unsigned char * yline;
+        unsigned char * uline;
+        unsigned char * vline;
+
+        planeSize = srcFrameWidth * srcFrameHeight;
+        halfWidth = srcFrameWidth >> 1;
+
+        // get pointers to the data
+        yplane = yuv;
+        uplane = yuv + planeSize;
+        vplane = yuv + planeSize + (planeSize >> 2);
+        rgbIndex = rgb;
+
+        for (y = 0; y < srcFrameHeight; y++)
+        {
+            yline = yplane + (y * srcFrameWidth);
+            uline = uplane + ((y >> 1) * halfWidth);
+            vline = vplane + ((y >> 1) * halfWidth);
+
+            if (flip)
+                rgbIndex = rgb + (srcFrameWidth*(srcFrameHeight-1-y)*rgbIncrement);
+
+            for (x = 0; x < (int) srcFrameWidth; x+=2)
+            {
+                rgbtoyuv(rgbIndex[2], rgbIndex[1], rgbIndex[0], *yline, *uline, *vline);
+                rgbIndex += rgbIncrement;
+                yline++;
+                rgbtoyuv(rgbIndex[2], rgbIndex[1], rgbIndex[0], *yline, *uline, *vline);
+                rgbIndex += rgbIncrement;
+                yline++;
+                uline++;
+                vline++;
+            }
+        }
+    }
+#undef rgbtoyuv
+#undef rgbtoy
+}
+
+static bool CompareLegacy(const char* conversion, const char* legacy_name,
+                          const Frame& frm, const std::vector<char>& out,
+                          const std::vector<char>& expected)
+{
+    if(out == expected)
+        return true;
+    fprintf(stderr, "%s differs from %s at %dx%d\n", conversion, legacy_name,
+            frm.width, frm.height);
+    return false;
+}
+
+/* Compare scalar output byte by byte with the replaced converters.
+ *
+ * The VpxDecoder converter is given planes with one byte of padding
+ * per line, as a vpx_image_t has, and an output buffer with room for
+ * the extra pixel it writes on odd widths.
+ *
+ * The VpxEncoder converter only handles even sizes, so for odd sizes
+ * it converts the frame with its last column and line repeated. This
+ * gives the chroma VideoConvert documents for partial 2x2 blocks. */
+static bool VerifyLegacy()
+{
+    const int sizes[][2] = { { 2, 2 }, { 1, 1 }, { 3, 1 }, { 1, 3 }, { 17, 5 },
+                             { 33, 7 }, { 50, 31 }, { 176, 144 }, { 641, 481 } };
+    SetVideoConvertImpl(VIDEOCONVERT_SCALAR);
+
+    bool ok = true;
+    for(size_t s=0;s<sizeof(sizes)/sizeof(sizes[0]);s++)
+    {
+        Frame frm(sizes[s][0], sizes[s][1]);
+        const int w = frm.width, h = frm.height;
+        const int uv_w = (w + 1) / 2, uv_h = (h + 1) / 2;
+
+        //I420 to RGB32
+        std::vector<char> out(RGB32_BYTES(w, h)), expected(RGB32_BYTES(w, h));
+        I420ToRGB32(&frm.i420[0], w, h, &out[0]);
+        legacy::I420ToRGB32(&frm.i420[0], w, h, &expected[0]);
+        ok &= CompareLegacy(conversion_names[CONV_I420_TO_RGB32],
+                            "MediaUtil I420ToRGB32", frm, out, expected);
+
+        const int y_stride = w + 1, uv_stride = uv_w + 1;
+        std::vector<uint8_t> y(y_stride * h), u(uv_stride * uv_h), v(uv_stride * uv_h);
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(&frm.i420[0]);
+        for(int i=0;i<h;i++)
+            memcpy(&y[i * y_stride], src + i * w, w);
+        for(int i=0;i<uv_h;i++)
+        {
+            memcpy(&u[i * uv_stride], src + w * h + i * uv_w, uv_w);
+            memcpy(&v[i * uv_stride], src + w * h + uv_w * uv_h + i * uv_w, uv_w);
+        }
+        std::vector<uint8_t> vpx_out(RGB32_BYTES(w, h) + 4);
+        legacy::I420toRGB32(&y[0], y_stride, &u[0], uv_stride, &v[0], uv_stride,
+                            w, h, &vpx_out[0]);
+        expected.assign(vpx_out.begin(), vpx_out.begin() + RGB32_BYTES(w, h));
+        ok &= CompareLegacy(conversion_names[CONV_I420_TO_RGB32],
+                            "VpxDecoder I420toRGB32", frm, out, expected);
+
+        //RGB32 to I420, top-down and bottom-up
+        const int even_w = uv_w * 2, even_h = uv_h * 2;
+        std::vector<char> even_rgb32(RGB32_BYTES(even_w, even_h));
+        for(int i=0;i<even_h;i++)
+        {
+            for(int j=0;j<even_w;j++)
+            {
+                //repeat last column and line
+                int line = std::min(i, h - 1);
+                memcpy(&even_rgb32[(i * even_w + j) * 4],
+                       &frm.rgb32[(line * w + std::min(j, w - 1)) * 4], 4);
+            }
+        }
+        for(int bottom_up=0;bottom_up<2;bottom_up++)
+        {
+            const char* rgb32 = &frm.rgb32[0];
+            std::vector<char> flipped;
+            if(bottom_up)
+            {
+                //make the odd line padding the bottom line of the image
+                flipped.resize(RGB32_BYTES(even_w, even_h));
+                for(int i=0;i<even_h;i++)
+                {
+                    int line = std::max(i - (even_h - h), 0);
+                    for(int j=0;j<even_w;j++)
+                        memcpy(&flipped[(i * even_w + j) * 4],
+                               &frm.rgb32[(line * w + std::min(j, w - 1)) * 4], 4);
+                }
+            }
+
+            out.assign(I420_BYTES(w, h), 0);
+            RGB32ToI420(rgb32, w, h, bottom_up != 0, &out[0]);
+
+            std::vector<char> yv12(I420_BYTES(even_w, even_h));
+            legacy::RGB32toYUV420P(reinterpret_cast<const unsigned char*>(bottom_up? &flipped[0] : &even_rgb32[0]),
+                                   reinterpret_cast<unsigned char*>(&yv12[0]),
+                                   4, bottom_up, even_w, even_h);
+
+            //crop to odd size and swap chroma planes
+            expected.assign(I420_BYTES(w, h), 0);
+            const char* yv12_v = &yv12[even_w * even_h];
+            const char* yv12_u = yv12_v + uv_w * uv_h;
+            for(int i=0;i<h;i++)
+                memcpy(&expected[i * w], &yv12[i * even_w], w);
+            memcpy(&expected[w * h], yv12_u, uv_w * uv_h);
+            memcpy(&expected[w * h + uv_w * uv_h], yv12_v, uv_w * uv_h);
+            ok &= CompareLegacy(conversion_names[CONV_RGB32_TO_I420],
+                                bottom_up? "VpxEncoder RGB32toYUV420P (bottom-up)" :
+                                "VpxEncoder RGB32toYUV420P", frm, out, expected);
+        }
+    }
+    return ok;
+}
+
+static bool Verify(VideoConvertImpl impl)
+{
+    const int sizes[][2] = { { 2, 2 }, { 1, 1 }, { 17, 5 }, { 33, 7 },
+                             { 50, 31 }, { 176, 144 }, { 641, 481 } };
+    bool ok = true;
+    for(size_t s=0;s<sizeof(sizes)/sizeof(sizes[0]);s++)
+    {
+        Frame frm(sizes[s][0], sizes[s][1]);
+        for(int c=0;c<CONV_COUNT;c++)
+        {
+            SetVideoConvertImpl(VIDEOCONVERT_SCALAR);
+            Convert(Conversion(c), frm);
+            std::vector<char> expected = frm.out;
+
+            SetVideoConvertImpl(impl);
+            Convert(Conversion(c), frm);
+            if(frm.out != expected)
+            {
+                fprintf(stderr, "%s: %s differs from scalar at %dx%d\n",
+                        GetVideoConvertImplName(impl), conversion_names[c],
+                        frm.width, frm.height);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    int frames = (argc > 1)? atoi(argv[1]) : 200;
+    if(frames < 1)
+        frames = 1;
+
+    const VideoConvertImpl impls[] = { VIDEOCONVERT_SCALAR, VIDEOCONVERT_SSE2,
+                                       VIDEOCONVERT_AVX2, VIDEOCONVERT_NEON };
+    const int resolutions[][2] = { { 320, 240 }, { 640, 480 }, { 1280, 720 },
+                                   { 1920, 1080 } };
+
+    bool ok = VerifyLegacy();
+    for(size_t i=0;i<sizeof(impls)/sizeof(impls[0]);i++)
+    {
+        if(SetVideoConvertImpl(impls[i]))
+            ok &= Verify(impls[i]);
+    }
+    if(!ok)
+        return 1;
+
+    printf("impl,conversion,width,height,usec_per_frame,mpixels_per_sec\n");
+
+    for(size_t r=0;r<sizeof(resolutions)/sizeof(resolutions[0]);r++)
+    {
+        Frame frm(resolutions[r][0], resolutions[r][1]);
+        for(size_t i=0;i<sizeof(impls)/sizeof(impls[0]);i++)
+        {
+            if(!SetVideoConvertImpl(impls[i]))
+                continue;
+
+            for(int c=0;c<CONV_COUNT;c++)
+            {
+                std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                for(int f=0;f<frames;f++)
+                    Convert(Conversion(c), frm);
+                std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - begin;
+
+                double usec = double(elapsed.count()) / 1000.0 / frames;
+                double pixels = double(frm.width) * frm.height;
+                printf("%s,%s,%d,%d,%.1f,%.1f\n", GetVideoConvertImplName(impls[i]),
+                       conversion_names[c], frm.width, frm.height, usec,
+                       usec > 0? pixels / usec : 0);
+            }
+        }
+    }
+    return 0;
+}
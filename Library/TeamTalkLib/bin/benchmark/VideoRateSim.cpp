@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+
+/* Loopback simulation of video capture rate control.
+ *
+ * One sender streams to two receivers through simulated paths with a
+ * drop-tail bottleneck (bandwidth cap), random packet loss and a
+ * base round-trip time. Receivers send the same reports as
+ * ClientNode::SendVideoFeedback() and the sender runs
+ * VideoRateControl once per second exactly like
+ * ClientNode::UpdateVideoRate().
+ *
+ * The scenario is run twice: once with a fixed bitrate (no feedback)
+ * and once adaptive. A frame is "frozen" if it cannot be decoded
+ * because a frame it depends on was lost and no key frame has
+ * arrived since. Per second rows are written as CSV to stdout:
+ *
+ * mode,second,cap_kbps,loss_pct,target_kbps,fps,rtt_msec,recv_kbps,frames_lost,frames_frozen
+ *
+ * A summary per mode is written to stderr.
+ *
+ * Usage: videoratesim [seconds per phase] */
+
+#include <teamtalk/client/VideoRateControl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+using namespace teamtalk;
+
+#define CAPTURE_FPS         30
+#define MAX_BITRATE         1000    //kbit/sec of VideoCodec
+#define KEYFRAME_SIZE       5       //key frame is this many times bigger
+#define KEYFRAME_MAX_DIST   128     //VP8's default kf_max_dist
+#define PACKET_SIZE         1200
+#define QUEUE_MSEC          200     //bottleneck buffer
+#define RECEIVERS           2
+
+struct Phase
+{
+    int cap_kbps[RECEIVERS];
+    double loss[RECEIVERS];
+};
+
+static const Phase phases[] =
+{
+    { { 3000, 3000 }, { 0.0,  0.0 } },
+    { {  400, 3000 }, { 0.0,  0.0 } },  //receiver 1 bandwidth drops
+    { { 3000, 3000 }, { 0.05, 0.0 } },  //light random loss
+    { { 3000,  600 }, { 0.15, 0.0 } },  //heavy loss and a capped receiver
+    { { 3000, 3000 }, { 0.0,  0.0 } },  //recovery
+};
+#define PHASES (sizeof(phases) / sizeof(phases[0]))
+
+struct InFlight
+{
+    int frame_no;
+    bool keyframe;
+    uint32_t sent, arrive;
+    int bytes;
+    bool lost;
+};
+
+struct Path
+{
+    int base_rtt;
+    double queue_bytes;    //bytes waiting at the bottleneck
+    uint32_t last_drain;
+    std::deque<InFlight> flight;
+
+    //receiver state
+    int next_frame;        //next frame number expected
+    bool broken;           //reference chain broken, waiting for key frame
+    int frames_recv, frames_lost;
+    bool keyframe_request;
+    uint32_t echo_time, echo_rx;
+    bool have_echo;
+
+    //per second stats
+    int sec_bytes, sec_lost, sec_frozen;
+    int rtt;
+
+    Path() : base_rtt(60), queue_bytes(0), last_drain(0)
+           , next_frame(0), broken(false), frames_recv(0), frames_lost(0)
+           , keyframe_request(false), echo_time(0), echo_rx(0), have_echo(false)
+           , sec_bytes(0), sec_lost(0), sec_frozen(0), rtt(0) {}
+};
+
+struct Totals
+{
+    long frames, lost, frozen;
+    Totals() : frames(0), lost(0), frozen(0) {}
+};
+
+static double Random()
+{
+    return double(rand()) / RAND_MAX;
+}
+
+static void Drain(Path& path, int cap_kbps, uint32_t now)
+{
+    double bytes_per_msec = cap_kbps / 8.0;
+    path.queue_bytes = std::max(0.0, path.queue_bytes -
+                                bytes_per_msec * (now - path.last_drain));
+    path.last_drain = now;
+}
+
+//push frame through bottleneck. Frame is lost if any of its packets are
+static void SendFrame(Path& path, const Phase& phase, int r, uint32_t now,
+                      int frame_no, bool keyframe, int bytes)
+{
+    Drain(path, phase.cap_kbps[r], now);
+
+    double bytes_per_msec = phase.cap_kbps[r] / 8.0;
+    double queue_max = bytes_per_msec * QUEUE_MSEC;
+    bool lost = false;
+    for(int remain = bytes; remain > 0; remain -= PACKET_SIZE)
+    {
+        int pkt = std::min(remain, PACKET_SIZE);
+        if(path.queue_bytes + pkt > queue_max || Random() < phase.loss[r])
+            lost = true;
+        else
+            path.queue_bytes += pkt;
+    }
+
+    InFlight f;
+    f.frame_no = frame_no;
+    f.keyframe = keyframe;
+    f.sent = now;
+    f.arrive = now + uint32_t(path.queue_bytes / bytes_per_msec) + path.base_rtt / 2;
+    f.bytes = bytes;
+    f.lost = lost;
+    path.flight.push_back(f);
+}
+
+static void Receive(Path& path, uint32_t now)
+{
+    while(path.flight.size() && path.flight.front().arrive <= now)
+    {
+        InFlight f = path.flight.front();
+        path.flight.pop_front();
+        if(f.lost)
+        {
+            //receiver notices missing frame when next one arrives
+            continue;
+        }
+
+        int lost = f.frame_no - path.next_frame;
+        path.frames_lost += lost;
+        path.sec_lost += lost;
+        if(lost)
+        {
+            path.broken = true;
+            path.keyframe_request = true;
+        }
+        if(f.keyframe)
+            path.broken = false;
+        if(path.broken)
+            path.sec_frozen++;
+
+        path.next_frame = f.frame_no + 1;
+        path.frames_recv++;
+        path.sec_bytes += f.bytes;
+        path.echo_time = f.sent;
+        path.echo_rx = now;
+        path.have_echo = true;
+    }
+}
+
+static void RunScenario(bool adaptive, int phase_sec, Totals& totals)
+{
+    srand(1);
+
+    VideoRateControl ratectrl;
+    ratectrl.Reset(MAX_BITRATE, CAPTURE_FPS);
+
+    std::vector<Path> paths(RECEIVERS);
+    paths[1].base_rtt = 150;
+
+    int bitrate = MAX_BITRATE, fps = CAPTURE_FPS;
+    bool force_keyframe = false;
+    int frame_no = 0, skipped = 0, since_keyframe = 0;
+    const uint32_t frame_msec = 1000 / CAPTURE_FPS;
+    const uint32_t duration = PHASES * phase_sec * 1000;
+
+    //reports in transit to the sender: (arrival time, receiver, report)
+    struct Report { uint32_t arrive; int userid; int recv, lost, rtt; bool kf; };
+    std::deque<Report> reports;
+
+    for(uint32_t now = 1; now <= duration; now++)
+    {
+        const Phase& phase = phases[(now - 1) / (phase_sec * 1000)];
+
+        //capture and encode
+        if(now % frame_msec == 0)
+        {
+            int step = 1;
+            if(fps < CAPTURE_FPS)
+                step = (CAPTURE_FPS + fps / 2) / fps;
+            if(++skipped >= step)
+            {
+                skipped = 0;
+                bool keyframe = frame_no == 0 || force_keyframe ||
+                    since_keyframe >= KEYFRAME_MAX_DIST;
+                force_keyframe = false;
+                int bytes = bitrate * 1000 / 8 * step / CAPTURE_FPS;
+                bytes = int(bytes * (0.8 + 0.4 * Random()));
+                if(keyframe)
+                {
+                    bytes *= KEYFRAME_SIZE;
+                    since_keyframe = 0;
+                }
+                since_keyframe++;
+                for(int r=0;r<RECEIVERS;r++)
+                    SendFrame(paths[r], phase, r, now, frame_no, keyframe, bytes);
+                frame_no++;
+                totals.frames += RECEIVERS;
+            }
+        }
+
+        for(int r=0;r<RECEIVERS;r++)
+            Receive(paths[r], now);
+
+        //receiver reports, ClientNode::SendVideoFeedback()
+        if(now % 1000 == 0)
+        {
+            for(int r=0;r<RECEIVERS;r++)
+            {
+                Path& p = paths[r];
+                if(!p.have_echo)
+                    continue;
+                Report rep;
+                rep.arrive = now + p.base_rtt / 2;
+                rep.userid = r + 1;
+                rep.recv = p.frames_recv;
+                rep.lost = p.frames_lost;
+                rep.kf = p.keyframe_request;
+                //RTT measured by sender. Add return trip to time held
+                rep.rtt = int(rep.arrive - p.echo_time) - int(now - p.echo_rx);
+                p.rtt = rep.rtt;
+                reports.push_back(rep);
+                p.frames_recv = p.frames_lost = 0;
+                p.keyframe_request = false;
+                p.have_echo = false;
+            }
+        }
+
+        while(reports.size() && reports.front().arrive <= now)
+        {
+            const Report& rep = reports.front();
+            if(adaptive)
+                ratectrl.ReceiverReport(rep.userid, now, rep.recv, rep.lost,
+                                        rep.rtt, rep.kf);
+            reports.pop_front();
+        }
+
+        //sender's one second timer, ClientNode::UpdateVideoRate()
+        if(now % 1000 == 500 && adaptive)
+        {
+            VideoRateTarget target = ratectrl.Update(now);
+            bitrate = target.bitrate;
+            fps = target.fps;
+            force_keyframe |= target.keyframe;
+        }
+
+        if(now % 1000 == 0)
+        {
+            for(int r=0;r<RECEIVERS;r++)
+            {
+                Path& p = paths[r];
+                printf("%s,%u,%d,%d,%d,%d,%d,%d,%d,%d\n",
+                       adaptive? "adaptive" : "fixed", now / 1000,
+                       phase.cap_kbps[r], int(phase.loss[r] * 100),
+                       bitrate, fps, p.rtt, p.sec_bytes * 8 / 1000,
+                       p.sec_lost, p.sec_frozen);
+                totals.lost += p.sec_lost;
+                totals.frozen += p.sec_frozen;
+                p.sec_bytes = p.sec_lost = p.sec_frozen = 0;
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int phase_sec = argc > 1? atoi(argv[1]) : 20;
+    if(phase_sec <= 0)
+        phase_sec = 20;
+
+    printf("mode,second,cap_kbps,loss_pct,target_kbps,fps,rtt_msec,recv_kbps,frames_lost,frames_frozen\n");
+
+    Totals fixed, adaptive;
+    RunScenario(false, phase_sec, fixed);
+    RunScenario(true, phase_sec, adaptive);
+
+    fprintf(stderr, "fixed:    %ld frames sent, %ld lost, %ld frozen\n",
+            fixed.frames, fixed.lost, fixed.frozen);
+    fprintf(stderr, "adaptive: %ld frames sent, %ld lost, %ld frozen\n",
+            adaptive.frames, adaptive.lost, adaptive.frozen);
+    return 0;
+}
@@ -1325,6 +1325,7 @@ void Convert(const teamtalk::ServerStats& stats, ServerStatistics& result)
     result.nUsersPeak = stats.userspeak;
     result.nFilesTx = stats.files_bytessent;
     result.nFilesRx = stats.files_bytesreceived;
+    result.nVoiceFramesSuppressed = stats.voice_frames_suppressed;
     ACE_UINT64 msec = 0;
     stats.starttime.msec(msec);
     result.nUptimeMSec = msec;
@@ -1430,6 +1431,14 @@ void Convert(const teamtalk::ClientUserStats& stats, UserStatistics& result)
     result.nMediaFileVideoFramesRecv = stats.mediafile_video_frames_recv;
     result.nMediaFileVideoFramesLost = stats.mediafile_video_frames_lost;
     result.nMediaFileVideoFramesDropped = stats.mediafile_video_frames_dropped;
+    result.nVoicePacketsLate = stats.voicepackets_late;
+    result.nVoiceFramesConcealed = stats.voiceframes_concealed;
+    result.nMediaFileAudioPacketsLate = stats.mediafile_audiopackets_late;
+    result.nMediaFileAudioFramesConcealed = stats.mediafile_audioframes_concealed;
+    result.nVoiceJitterMSec = stats.voice_jitter_msec;
+    result.nMediaFileAudioJitterMSec = stats.mediafile_audio_jitter_msec;
+    result.nVideoCaptureFramesSkipped = stats.vidcapframes_skipped;
+    result.nMediaFileVideoFramesSkipped = stats.mediafile_video_frames_skipped;
 }
 
 void Convert(const teamtalk::ClientStats& stats, ClientStatistics& result)
@@ -1452,6 +1461,11 @@ void Convert(const teamtalk::ClientStats& stats, ClientStatistics& result)
     result.nUdpPingTimeMs = stats.udpping_time;
     result.nTcpServerSilenceSec = stats.tcp_silence_sec;
     result.nUdpServerSilenceSec = stats.udp_silence_sec;
+    result.nVoiceCaptureOverruns = stats.voicecapture_overruns;
+    result.nVoiceFramesSuppressed = stats.voiceframes_suppressed;
+    result.nEventsCoalesced = 0;
+    result.nEventsDropped = 0;
+    result.nMaxPayloadSize = stats.max_payload_size;
 }
 
 void Convert(const teamtalk::DesktopInput& input, DesktopInput& result)
@@ -25,58 +25,78 @@
 #include <teamtalk/ttassert.h>
 #include "Convert.h"
 
-#define INTMSG_MAX_SIZE (0x7F000000)
-#define INTMSG_SUSPEND_SIZE (1024*1024)
+//Limits are in number of events instead of bytes since every queued
+//TTMessage has the same size. The former 256 KB coalesce and 1 MB
+//overflow limits correspond to roughly the counts below.
 
-struct IntTTMessage
+//number of preallocated events in the queue
+#define INTMSG_RING_SIZE 256
+//replace queued events by newer events of same kind above this count
+#define INTMSG_COALESCE_COUNT 64
+//drop events which can be coalesced but have no queued event above
+//this count
+#define INTMSG_OVERFLOW_COUNT INTMSG_RING_SIZE
+
+void InitMsg(TTMessage& msg, ClientEvent event, INT32 nSource, TTType ttType)
+{
+    msg.nClientEvent = event;
+    msg.nSource = nSource;
+    msg.ttType = ttType;
+    msg.uReserved = 0;
+}
+
+//only copy the part of the union which is used
+void CopyMsg(TTMessage& dest, const TTMessage& src)
+{
+    dest.nClientEvent = src.nClientEvent;
+    dest.nSource = src.nSource;
+    dest.ttType = src.ttType;
+    dest.uReserved = src.uReserved;
+    int size = TT_DBG_SIZEOF(src.ttType);
+    if(size>0)
+        ACE_OS::memcpy(dest.data, src.data, size);
+}
+
+//events which only report the latest state of a user or stream so a
+//queued event can be replaced by a newer one
+bool GetCoalesceKey(const TTMessage& msg, ACE_UINT64& key)
 {
-    ClientEvent event;
-    UINT32 nSource;
-    TTType ttType;
-    union
+    ACE_UINT32 id;
+    switch(msg.nClientEvent)
     {
-        char data[1];
-        VOID* any;
-        Channel* chan;
-        User* user;
-        UserAccount* useraccount;
-        RemoteFile* remotefile;
-        TextMessage* textmessage;
-        ServerProperties* serverproperties;
-        ServerStatistics* serverstatistics;
-        FileTransfer* filetransfer;
-        ClientErrorMsg* clienterrmsg;
-        DesktopInput* desktopinput;
-        BannedUser* banneduser;
-        TTBOOL* active;
-        INT32* bytesremain;
-        INT32* stream_id;
-        INT32* payload_size;
-        MediaFileInfo* mediafileinfo;
-        StreamType* streamtype;
-    };
-};
-
-IntTTMessage* MakeMsgBlock(ACE_Message_Block*& mb,
-                           ClientEvent event,
-                           UINT32 nSource,
-                           TTType ttType)
-{
-    int size = TT_DBG_SIZEOF(ttType);
-    ACE_NEW_RETURN(mb, ACE_Message_Block(sizeof(IntTTMessage) + size), NULL);
-    IntTTMessage* ret = reinterpret_cast<IntTTMessage*>(mb->rd_ptr());
-    ret->event = event;
-    ret->nSource = nSource;
-    ret->ttType = ttType;
-    if(size)
-        ret->any = &mb->rd_ptr()[sizeof(IntTTMessage)];
-    else
-        ret->any = NULL;
-    return ret;
+    case CLIENTEVENT_USER_STATECHANGE :
+    case CLIENTEVENT_CMD_USER_UPDATE :
+        id = msg.user.nUserID;
+        break;
+    case CLIENTEVENT_USER_AUDIOBLOCK :
+        id = msg.nSource | (ACE_UINT32(msg.nStreamType) << 16);
+        break;
+    case CLIENTEVENT_USER_VIDEOCAPTURE :
+    case CLIENTEVENT_USER_MEDIAFILE_VIDEO :
+    case CLIENTEVENT_USER_DESKTOPWINDOW :
+    case CLIENTEVENT_USER_DESKTOPCURSOR :
+    case CLIENTEVENT_DESKTOPWINDOW_TRANSFER :
+        id = msg.nSource;
+        break;
+    default :
+        return false;
+    }
+    key = (ACE_UINT64(msg.nClientEvent) << 32) | id;
+    return true;
 }
 
+//user ID of the coalesce key (the lower 16 bits of the ID)
+#define COALESCE_KEY_USERID(key) int((key) & 0xFFFF)
+
 TTMsgQueue::TTMsgQueue()
-    : m_suspender(0)
+    : m_cond(m_mutex)
+    , m_head_seq(0)
+    , m_tail_seq(0)
+    , m_ring_pos(0)
+    , m_ring_count(0)
+    , m_coalesced_count(0)
+    , m_dropped_count(0)
+    , m_overflow(false)
 #if defined(WIN32)
     , m_hKeyWnd(0)
     , m_hWnd(0)
@@ -89,7 +109,14 @@ TTMsgQueue::TTMsgQueue()
 
 #if defined(WIN32)
 TTMsgQueue::TTMsgQueue(HWND m_hWnd, UINT eventMsg)
-    : m_suspender(0)
+    : m_cond(m_mutex)
+    , m_head_seq(0)
+    , m_tail_seq(0)
+    , m_ring_pos(0)
+    , m_ring_count(0)
+    , m_coalesced_count(0)
+    , m_dropped_count(0)
+    , m_overflow(false)
     , m_hKeyWnd(0)
     , m_hWnd(m_hWnd)
     , m_EventHWndMsg(eventMsg)
@@ -105,30 +132,167 @@ TTMsgQueue::~TTMsgQueue()
 
 void TTMsgQueue::InitMsgQueue()
 {
-    m_event_queue.low_water_mark(INTMSG_MAX_SIZE);
-    m_event_queue.high_water_mark(INTMSG_MAX_SIZE);
+    m_ring.resize(INTMSG_RING_SIZE);
 }
 
-void TTMsgQueue::EnqueueMsg(ACE_Message_Block* mb)
+void TTMsgQueue::PushMsg(const TTMessage& msg)
 {
-    size_t old_size = m_event_queue.message_bytes();
-    ACE_Time_Value tv;
-    int ret = m_event_queue.enqueue(mb, &tv);
-    TTASSERT(ret >= 0);
-    if(m_suspender &&
-       old_size < INTMSG_SUSPEND_SIZE &&
-       m_event_queue.message_bytes() >= INTMSG_SUSPEND_SIZE)
+    //once the ring is full events must go to the overflow queue
+    //until it's empty, otherwise events would be out of order
+    if(m_overflow_msgs.empty() && m_ring_count < m_ring.size())
+    {
+        CopyMsg(m_ring[(m_ring_pos + m_ring_count) % m_ring.size()], msg);
+        m_ring_count++;
+    }
+    else
     {
-        m_suspender->SuspendEventHandling();
-
-        IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_INTERNAL_ERROR,
-                                         0, __CLIENTERRORMSG);
-        msg->clienterrmsg->nErrorNo = INTERR_TTMESSAGE_QUEUE_OVERFLOW;
-       
-        ACE_OS::strsncpy(msg->clienterrmsg->szErrorMsg,
-                         ACE_TEXT("The internal message queue has overflowed"),
-                         TT_STRLEN);
-        m_event_queue.enqueue(mb, &tv);
+        m_overflow_msgs.push_back(TTMessage());
+        CopyMsg(m_overflow_msgs.back(), msg);
+    }
+    m_tail_seq++;
+    m_cond.signal();
+}
+
+TTMessage* TTMsgQueue::GetQueuedMsg(ACE_UINT64 seq)
+{
+    if(seq < m_head_seq || seq >= m_tail_seq)
+        return NULL;
+
+    size_t index = size_t(seq - m_head_seq);
+    if(index < m_ring_count)
+        return &m_ring[(m_ring_pos + index) % m_ring.size()];
+    index -= m_ring_count;
+    TTASSERT(index < m_overflow_msgs.size());
+    return &m_overflow_msgs[index];
+}
+
+void TTMsgQueue::PopMsg(TTMessage& msg)
+{
+    TTASSERT(m_head_seq != m_tail_seq);
+
+    TTMessage* queued = GetQueuedMsg(m_head_seq);
+    CopyMsg(msg, *queued);
+
+    //a newer event can no longer be coalesced with this one
+    ACE_UINT64 key;
+    if(GetCoalesceKey(msg, key))
+    {
+        coalesce_msgs_t::iterator ii = m_coalesce_msgs.find(key);
+        if(ii != m_coalesce_msgs.end() && ii->second == m_head_seq)
+            m_coalesce_msgs.erase(ii);
+    }
+
+    if(m_ring_count)
+    {
+        m_ring_pos = (m_ring_pos + 1) % m_ring.size();
+        m_ring_count--;
+    }
+    else
+        m_overflow_msgs.pop_front();
+    m_head_seq++;
+
+    if(m_overflow && m_tail_seq - m_head_seq < INTMSG_COALESCE_COUNT)
+        m_overflow = false;
+}
+
+//A coalescible event must not be replaced by a newer event if an
+//event about the same user has been queued after it since the newer
+//event would then be reported before that event, e.g. a state change
+//before the user joined the channel.
+void TTMsgQueue::ForgetCoalesceMsgs(const TTMessage& msg)
+{
+    int userid;
+    switch(msg.nClientEvent)
+    {
+    case CLIENTEVENT_CON_FAILED :
+    case CLIENTEVENT_CON_LOST :
+    case CLIENTEVENT_CMD_MYSELF_LOGGEDOUT :
+        //all users are gone
+        m_coalesce_msgs.clear();
+        return;
+    case CLIENTEVENT_CMD_USER_LOGGEDIN :
+    case CLIENTEVENT_CMD_USER_LOGGEDOUT :
+    case CLIENTEVENT_CMD_USER_JOINED :
+    case CLIENTEVENT_CMD_USER_LEFT :
+        userid = msg.user.nUserID;
+        break;
+    case CLIENTEVENT_CMD_USER_TEXTMSG :
+        userid = msg.textmessage.nFromUserID;
+        break;
+    case CLIENTEVENT_USER_DESKTOPINPUT :
+    case CLIENTEVENT_USER_RECORD_MEDIAFILE :
+        userid = msg.nSource;
+        break;
+    default :
+        return;
+    }
+
+    coalesce_msgs_t::iterator ii = m_coalesce_msgs.begin();
+    while(ii != m_coalesce_msgs.end())
+    {
+        if(COALESCE_KEY_USERID(ii->first) == userid)
+            m_coalesce_msgs.erase(ii++);
+        else
+            ii++;
+    }
+}
+
+void TTMsgQueue::EnqueueMsg(const TTMessage& msg)
+{
+    //the reactor thread is never suspended when the application
+    //doesn't drain the queue. Instead events which are superseded by
+    //newer events are coalesced and the rest are dropped.
+    {
+        ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+
+        size_t queue_count = size_t(m_tail_seq - m_head_seq);
+        ACE_UINT64 key;
+        bool coalesce = GetCoalesceKey(msg, key);
+        TTMessage* queued = NULL;
+        if(coalesce && queue_count >= INTMSG_COALESCE_COUNT)
+        {
+            coalesce_msgs_t::const_iterator ii = m_coalesce_msgs.find(key);
+            if(ii != m_coalesce_msgs.end())
+                queued = GetQueuedMsg(ii->second);
+        }
+
+        if(queued)
+        {
+            //update queued event with newest content
+            TTASSERT(queued->ttType == msg.ttType);
+            CopyMsg(*queued, msg);
+            m_coalesced_count++;
+            return;
+        }
+
+        if(coalesce && queue_count >= INTMSG_OVERFLOW_COUNT)
+        {
+            m_dropped_count++;
+            return;
+        }
+
+        //events which cannot be coalesced, e.g. command replies and
+        //users joining or leaving, are never dropped since the
+        //application's model would no longer match the server's
+        if(!coalesce)
+            ForgetCoalesceMsgs(msg);
+
+        if(coalesce)
+            m_coalesce_msgs[key] = m_tail_seq;
+        PushMsg(msg);
+
+        if(!m_overflow && m_tail_seq - m_head_seq >= INTMSG_OVERFLOW_COUNT)
+        {
+            m_overflow = true;
+
+            TTMessage errmsg;
+            InitMsg(errmsg, CLIENTEVENT_INTERNAL_ERROR, 0, __CLIENTERRORMSG);
+            errmsg.clienterrormsg.nErrorNo = INTERR_TTMESSAGE_QUEUE_OVERFLOW;
+            ACE_OS::strsncpy(errmsg.clienterrormsg.szErrorMsg,
+                             ACE_TEXT("The internal message queue has overflowed"),
+                             TT_STRLEN);
+            PushMsg(errmsg);
+        }
     }
 
 #if defined(WIN32)
@@ -139,203 +303,201 @@ void TTMsgQueue::EnqueueMsg(ACE_Message_Block* mb)
 
 TTBOOL TTMsgQueue::GetMessage(TTMessage& msg, ACE_Time_Value* tv)
 {
-    size_t old_size = m_event_queue.message_bytes();
-    ACE_Message_Block* mb;
+    int count = 1;
+    return GetMessages(&msg, count, tv);
+}
+
+TTBOOL TTMsgQueue::GetMessages(TTMessage* msgs, int& count, ACE_Time_Value* tv)
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
 
-    if(m_event_queue.dequeue(mb, tv)>=0)
+    //'tv' is absolute time
+    while(m_head_seq == m_tail_seq)
     {
-        IntTTMessage* intmsg = reinterpret_cast<IntTTMessage*>(mb->rd_ptr());
-        msg.nClientEvent = intmsg->event;
-        msg.nSource = intmsg->nSource;
-        msg.ttType = intmsg->ttType;
-        int size = TT_DBG_SIZEOF(intmsg->ttType);
-        TTASSERT(!size || intmsg->any);
-        if(size>0 && intmsg->any)
-            ACE_OS::memcpy(msg.data, intmsg->any, size);
-        mb->release();
-
-        if(m_suspender &&
-            old_size >= INTMSG_SUSPEND_SIZE &&
-            m_event_queue.message_bytes()<INTMSG_SUSPEND_SIZE)
-            m_suspender->ResumeEventHandling();
-        return TRUE;
+        if(m_cond.wait(tv) < 0)
+        {
+            count = 0;
+            return FALSE;
+        }
     }
-    return FALSE;
+
+    int n = 0;
+    while(n < count && m_head_seq != m_tail_seq)
+        PopMsg(msgs[n++]);
+    count = n;
+    return TRUE;
+}
+
+int TTMsgQueue::GetCoalescedCount()
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+    return m_coalesced_count;
 }
 
-void TTMsgQueue::RegisterEventSuspender(teamtalk::EventSuspender* suspender)
+int TTMsgQueue::GetDroppedCount()
 {
-    m_suspender = suspender;
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+    return m_dropped_count;
 }
 
 void TTMsgQueue::OnConnectSuccess()
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CON_SUCCESS,
-                                     0, __NONE);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CON_SUCCESS, 0, __NONE);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnConnectFailed()
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CON_FAILED,
-                                     0, __NONE);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CON_FAILED, 0, __NONE);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnConnectionLost()
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CON_LOST,
-                                     0, __NONE);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CON_LOST, 0, __NONE);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnAccepted(int myuserid, const teamtalk::UserAccount& account)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_MYSELF_LOGGEDIN,
-                                     myuserid, __USERACCOUNT);
-    Convert(account, *msg->useraccount);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_MYSELF_LOGGEDIN, myuserid, __USERACCOUNT);
+    Convert(account, msg.useraccount);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnLoggedOut()
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_MYSELF_LOGGEDOUT,
-                                     0, __NONE);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_MYSELF_LOGGEDOUT, 0, __NONE);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserLoggedIn(const teamtalk::ClientUser& user)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_USER_LOGGEDIN,
-                                     0, __USER);
-    Convert(user, *msg->user);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_USER_LOGGEDIN, 0, __USER);
+    Convert(user, msg.user);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserLoggedOut(const teamtalk::ClientUser& user)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_USER_LOGGEDOUT,
-                                     0, __USER);
-    Convert(user, *msg->user);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_USER_LOGGEDOUT, 0, __USER);
+    Convert(user, msg.user);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserUpdate(const teamtalk::ClientUser& user)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_USER_UPDATE,
-                                     0, __USER);
-    Convert(user, *msg->user);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_USER_UPDATE, 0, __USER);
+    Convert(user, msg.user);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserJoinChannel(const teamtalk::ClientUser& user,
                                    const teamtalk::ClientChannel& chan)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_USER_JOINED,
-                                     0, __USER);
-    Convert(user, *msg->user);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_USER_JOINED, 0, __USER);
+    Convert(user, msg.user);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserLeftChannel(const teamtalk::ClientUser& user,
                                    const teamtalk::ClientChannel& chan)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_USER_LEFT,
-                                     chan.GetChannelID(),
-                                     __USER);
-    Convert(user, *msg->user);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_USER_LEFT,
+            chan.GetChannelID(),
+            __USER);
+    Convert(user, msg.user);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnAddChannel(const teamtalk::ClientChannel& chan)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_CHANNEL_NEW,
-                                     0,
-                                     __CHANNEL);
-    Convert(chan.GetChannelProp(), *msg->chan);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_CHANNEL_NEW,
+            0,
+            __CHANNEL);
+    Convert(chan.GetChannelProp(), msg.channel);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUpdateChannel(const teamtalk::ClientChannel& chan)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_CHANNEL_UPDATE,
-                                     0,
-                                     __CHANNEL);
-    Convert(chan.GetChannelProp(), *msg->chan);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_CHANNEL_UPDATE,
+            0,
+            __CHANNEL);
+    Convert(chan.GetChannelProp(), msg.channel);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnRemoveChannel(const teamtalk::ClientChannel& chan)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_CHANNEL_REMOVE,
-                                     0,
-                                     __CHANNEL);
-    Convert(chan.GetChannelProp(), *msg->chan);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_CHANNEL_REMOVE,
+            0,
+            __CHANNEL);
+    Convert(chan.GetChannelProp(), msg.channel);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnAddFile(const teamtalk::ClientChannel& chan,
                            const teamtalk::RemoteFile& file)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_FILE_NEW,
-                                     0,
-                                     __REMOTEFILE);
-    Convert(file, *msg->remotefile);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_FILE_NEW,
+            0,
+            __REMOTEFILE);
+    Convert(file, msg.remotefile);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnRemoveFile(const teamtalk::ClientChannel& chan,
                               const teamtalk::RemoteFile& file)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_FILE_REMOVE,
-                                     0,
-                                     __REMOTEFILE);
-    Convert(file, *msg->remotefile);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_FILE_REMOVE,
+            0,
+            __REMOTEFILE);
+    Convert(file, msg.remotefile);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserAccount(const teamtalk::UserAccount& account)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_USERACCOUNT,
-                                     0,
-                                     __USERACCOUNT);
-    Convert(account, *msg->useraccount);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_USERACCOUNT,
+            0,
+            __USERACCOUNT);
+    Convert(account, msg.useraccount);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnBannedUser(const teamtalk::BannedUser& banuser)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_BANNEDUSER,
-                                     0,
-                                     __BANNEDUSER);
-    Convert(banuser, *msg->banneduser);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_BANNEDUSER,
+            0,
+            __BANNEDUSER);
+    Convert(banuser, msg.banneduser);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnTextMessage(const teamtalk::TextMessage& textmsg)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_USER_TEXTMSG,
-                                     0, __TEXTMESSAGE);
-    Convert(textmsg, *msg->textmessage);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_USER_TEXTMSG, 0, __TEXTMESSAGE);
+    Convert(textmsg, msg.textmessage);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnJoinedChannel(int channelid)
@@ -348,180 +510,162 @@ void TTMsgQueue::OnLeftChannel(int channelid)
 
 void TTMsgQueue::OnKicked(const teamtalk::clientuser_t& user, int channelid)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_MYSELF_KICKED,
-                                     channelid, !user.null()? __USER : __NONE);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_MYSELF_KICKED,
+            channelid, !user.null()? __USER : __NONE);
     if(!user.null())
-        Convert(*user, *msg->user);
-    EnqueueMsg(mb);
+        Convert(*user, msg.user);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnServerUpdate(const teamtalk::ServerInfo& serverinfo)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_SERVER_UPDATE,
-                                     0, __SERVERPROPERTIES);
-    Convert(serverinfo, *msg->serverproperties);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_SERVER_UPDATE, 0, __SERVERPROPERTIES);
+    Convert(serverinfo, msg.serverproperties);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnServerStatistics(const teamtalk::ServerStats& serverstats)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_SERVERSTATISTICS,
-                                     0, __SERVERSTATISTICS);
-    Convert(serverstats, *msg->serverstatistics);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_SERVERSTATISTICS, 0, __SERVERSTATISTICS);
+    Convert(serverstats, msg.serverstatistics);
+    EnqueueMsg(msg);
 }
 
 
 void TTMsgQueue::OnFileTransferStatus(const teamtalk::FileTransfer& transfer)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_FILETRANSFER,
-                                     0, __FILETRANSFER);
-    Convert(transfer, *msg->filetransfer);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_FILETRANSFER, 0, __FILETRANSFER);
+    Convert(transfer, msg.filetransfer);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnCommandProcessing(int cmdid, bool begin_end)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_PROCESSING,
-                                     cmdid, __TTBOOL);
-    *msg->active = !begin_end;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_PROCESSING, cmdid, __TTBOOL);
+    msg.bActive = !begin_end;
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnCommandError(int cmdid, int err_num, const ACE_TString& msg_)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_ERROR,
-                                     cmdid, __CLIENTERRORMSG);
-    msg->clienterrmsg->nErrorNo = err_num;
-    ACE_OS::strsncpy(msg->clienterrmsg->szErrorMsg, msg_.c_str(), TT_STRLEN);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_ERROR, cmdid, __CLIENTERRORMSG);
+    msg.clienterrormsg.nErrorNo = err_num;
+    ACE_OS::strsncpy(msg.clienterrormsg.szErrorMsg, msg_.c_str(), TT_STRLEN);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnCommandSuccess(int cmdid)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CMD_SUCCESS,
-                                     cmdid, __NONE);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CMD_SUCCESS, cmdid, __NONE);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnInternalError(int errorno, const ACE_TString& msg_)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_INTERNAL_ERROR,
-                                     0, __CLIENTERRORMSG);
-    msg->clienterrmsg->nErrorNo = errorno;
-    ACE_OS::strsncpy(msg->clienterrmsg->szErrorMsg, msg_.c_str(), TT_STRLEN);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_INTERNAL_ERROR, 0, __CLIENTERRORMSG);
+    msg.clienterrormsg.nErrorNo = errorno;
+    ACE_OS::strsncpy(msg.clienterrormsg.szErrorMsg, msg_.c_str(), TT_STRLEN);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnVoiceActivated(bool enabled)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_VOICE_ACTIVATION,
-                                     0, __TTBOOL);
-    *msg->active = enabled;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_VOICE_ACTIVATION, 0, __TTBOOL);
+    msg.bActive = enabled;
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserStateChange(const teamtalk::ClientUser& user)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_USER_STATECHANGE,
-                                     0, __USER);    
-    Convert(user, *msg->user);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_USER_STATECHANGE, 0, __USER);    
+    Convert(user, msg.user);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserVideoCaptureFrame(int userid, int stream_id)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_USER_VIDEOCAPTURE,
-                                     userid, __INT32);
-    *msg->stream_id = stream_id;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_USER_VIDEOCAPTURE, userid, __INT32);
+    msg.nStreamID = stream_id;
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserMediaFileVideoFrame(int userid, int stream_id)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_USER_MEDIAFILE_VIDEO,
-                                     userid, __INT32);
-    *msg->stream_id = stream_id;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_USER_MEDIAFILE_VIDEO, userid, __INT32);
+    msg.nStreamID = stream_id;
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnDesktopTransferUpdate(int session_id, int remain_bytes)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_DESKTOPWINDOW_TRANSFER,
-                                     session_id, __INT32);
-    *msg->bytesremain = remain_bytes;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_DESKTOPWINDOW_TRANSFER, session_id, __INT32);
+    msg.nBytesRemain = remain_bytes;
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserDesktopWindow(int userid, int session_id)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_USER_DESKTOPWINDOW,
-                                     userid, __INT32);
-    *msg->stream_id = session_id;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_USER_DESKTOPWINDOW, userid, __INT32);
+    msg.nStreamID = session_id;
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserDesktopCursor(int src_userid, const teamtalk::DesktopInput& input)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_USER_DESKTOPCURSOR,
-                                     src_userid, __DESKTOPINPUT);
-    Convert(input, *msg->desktopinput);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_USER_DESKTOPCURSOR, src_userid, __DESKTOPINPUT);
+    Convert(input, msg.desktopinput);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserDesktopInput(int src_userid, const teamtalk::DesktopInput& input)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_USER_DESKTOPINPUT,
-                                     src_userid, __DESKTOPINPUT);
-    Convert(input, *msg->desktopinput);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_USER_DESKTOPINPUT, src_userid, __DESKTOPINPUT);
+    Convert(input, msg.desktopinput);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnChannelStreamMediaFile(const MediaFileProp& mfp,
                                           teamtalk::MediaFileStatus status)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_STREAM_MEDIAFILE,
-                                     0, __MEDIAFILEINFO);
-    Convert(mfp, *msg->mediafileinfo);
-    msg->mediafileinfo->nStatus = (MediaFileStatus)status;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_STREAM_MEDIAFILE, 0, __MEDIAFILEINFO);
+    Convert(mfp, msg.mediafileinfo);
+    msg.mediafileinfo.nStatus = (MediaFileStatus)status;
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnUserAudioBlock(int userid, teamtalk::StreamType stream_type)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_USER_AUDIOBLOCK,
-                                     userid, __STREAMTYPE);
-    *msg->streamtype = (StreamType)stream_type;
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_USER_AUDIOBLOCK, userid, __STREAMTYPE);
+    msg.nStreamType = (StreamType)stream_type;
     assert((StreamType)stream_type == STREAMTYPE_VOICE || 
            (StreamType)stream_type == STREAMTYPE_MEDIAFILE_AUDIO);
-    EnqueueMsg(mb);
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnMTUQueryComplete(int payload_size)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_CON_MAX_PAYLOAD_UPDATED,
-                                     0, __INT32);
-    *msg->payload_size = payload_size;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_CON_MAX_PAYLOAD_UPDATED, 0, __INT32);
+    msg.nPayloadSize = payload_size;
+    EnqueueMsg(msg);
 }
 
 //VoiceLogListener
@@ -529,40 +673,36 @@ void TTMsgQueue::OnMediaFileStatus(int userid,
                                    teamtalk::MediaFileStatus status, 
                                    const teamtalk::VoiceLogFile& vlog)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_USER_RECORD_MEDIAFILE,
-                                     userid, __MEDIAFILEINFO);
-    Convert(status, vlog, *msg->mediafileinfo);
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_USER_RECORD_MEDIAFILE, userid, __MEDIAFILEINFO);
+    Convert(status, vlog, msg.mediafileinfo);
+    EnqueueMsg(msg);
 }
 
 /* HotKeyListener events */
 #if defined(WIN32)
 void TTMsgQueue::OnHotKeyActive(int hotkeyid)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_HOTKEY,
-                                     hotkeyid, __TTBOOL);
-    *msg->active = TRUE;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_HOTKEY, hotkeyid, __TTBOOL);
+    msg.bActive = TRUE;
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnHotKeyInactive(int hotkeyid)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_HOTKEY,
-                                     hotkeyid, __TTBOOL);
-    *msg->active = FALSE;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_HOTKEY, hotkeyid, __TTBOOL);
+    msg.bActive = FALSE;
+    EnqueueMsg(msg);
 }
 
 void TTMsgQueue::OnKeyDown(UINT nVK)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_HOTKEY_TEST,
-                                    nVK, __TTBOOL);
-    *msg->active = TRUE;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_HOTKEY_TEST, nVK, __TTBOOL);
+    msg.bActive = TRUE;
+    EnqueueMsg(msg);
 
     if(m_hKeyWnd)
     {
@@ -572,11 +712,10 @@ void TTMsgQueue::OnKeyDown(UINT nVK)
 
 void TTMsgQueue::OnKeyUp(UINT nVK)
 {
-    ACE_Message_Block* mb;
-    IntTTMessage* msg = MakeMsgBlock(mb, CLIENTEVENT_HOTKEY_TEST,
-                                    nVK, __TTBOOL);
-    *msg->active = FALSE;
-    EnqueueMsg(mb);
+    TTMessage msg;
+    InitMsg(msg, CLIENTEVENT_HOTKEY_TEST, nVK, __TTBOOL);
+    msg.bActive = FALSE;
+    EnqueueMsg(msg);
 
     if(m_hKeyWnd)
     {
@@ -27,6 +27,11 @@
 #include <teamtalk/client/ClientNode.h>
 #include <TeamTalk.h>
 
+#include <ace/Condition_Thread_Mutex.h>
+
+#include <deque>
+#include <vector>
+
 #if defined(WIN32)
 #include <win32/HotKey.h>
 #endif
@@ -37,8 +42,26 @@ class TTMsgQueue
     , public HotKeyListener
 #endif
 {
-    msg_queue_t m_event_queue;
-    teamtalk::EventSuspender* m_suspender;
+    //protects the queue and signals when events are queued
+    ACE_Thread_Mutex m_mutex;
+    ACE_Condition_Thread_Mutex m_cond;
+    //events are placed in a preallocated ring. If the application
+    //falls behind so the ring is full then events are placed in
+    //'m_overflow_msgs' until the application catches up.
+    std::vector<TTMessage> m_ring;
+    std::deque<TTMessage> m_overflow_msgs;
+    //queued events are 'm_head_seq' to 'm_tail_seq'. The first
+    //'m_ring_count' are in the ring starting at 'm_ring_pos'.
+    ACE_UINT64 m_head_seq, m_tail_seq;
+    size_t m_ring_pos, m_ring_count;
+    //queued events which a newer event of the same kind can replace
+    //(coalesce key -> event sequence number)
+    typedef std::map<ACE_UINT64, ACE_UINT64> coalesce_msgs_t;
+    coalesce_msgs_t m_coalesce_msgs;
+    //number of events coalesced and dropped due to queue pressure
+    int m_coalesced_count, m_dropped_count;
+    //overflow has been reported and queue has not yet been drained
+    bool m_overflow;
 #if defined(WIN32)
     HWND m_hKeyWnd;
     HWND m_hWnd;
@@ -46,7 +69,11 @@ class TTMsgQueue
     UINT m_EventHKeyWndMsg;
 #endif
     void InitMsgQueue();
-    void EnqueueMsg(ACE_Message_Block* mb);
+    void EnqueueMsg(const TTMessage& msg);
+    void ForgetCoalesceMsgs(const TTMessage& msg);
+    void PushMsg(const TTMessage& msg);
+    TTMessage* GetQueuedMsg(ACE_UINT64 seq);
+    void PopMsg(TTMessage& msg);
 
 public:
     TTMsgQueue();
@@ -58,10 +85,13 @@ public:
     virtual ~TTMsgQueue();
 
     TTBOOL GetMessage(TTMessage& msg, ACE_Time_Value* tv);
+    //'count' is in/out
+    TTBOOL GetMessages(TTMessage* msgs, int& count, ACE_Time_Value* tv);
 
-    //ClientListener
-    void RegisterEventSuspender(teamtalk::EventSuspender* suspender);
+    int GetCoalescedCount();
+    int GetDroppedCount();
 
+    //ClientListener
     void OnConnectSuccess();
     void OnConnectFailed();
     void OnConnectionLost();
@@ -43,6 +43,7 @@ HINSTANCE hInstance = NULL;
 
 #include <teamtalk/client/ClientNode.h>
 #include <teamtalk/client/AudioContainer.h>
+#include <teamtalk/client/ReactorPool.h>
 #include <teamtalk/ttassert.h>
 
 #include <TeamTalk.h>
@@ -80,6 +81,8 @@ struct ClientInstance
 {
     ClientNode* pClientNode;
     TTMsgQueue* pEventHandler;
+    //shared reactor from REACTORPOOL or NULL
+    ACE_Reactor* pReactor;
     ACE_Recursive_Thread_Mutex mutex_video;
     typedef std::map<VideoFrame*, ACE_Message_Block*> video_frames_t;
     video_frames_t video_frames;
@@ -181,6 +184,7 @@ struct ClientInstance
     {
         pClientNode = NULL;
         pEventHandler = NULL;
+        pReactor = NULL;
     }
 
     ~ClientInstance()
@@ -315,8 +319,10 @@ TEAMTALKDLL_API TTInstance* TT_InitTeamTalk(IN HWND hWnd, IN UINT uMsg)
 
     ClientInstance* pClient = new ClientInstance;
     pClient->pEventHandler = new TTMsgQueue(hWnd, uMsg);
+    pClient->pReactor = REACTORPOOL::instance()->AcquireReactor();
     pClient->pClientNode = new ClientNode(ACE_TEXT( TEAMTALK_VERSION ), 
-                                          pClient->pEventHandler);
+                                          pClient->pEventHandler,
+                                          pClient->pReactor);
 
     wguard_t g(clients_mutex);
     clients.insert(pClient);
@@ -356,8 +362,10 @@ TEAMTALKDLL_API TTInstance* TT_InitTeamTalkPoll()
 
     ClientInstance* pClient = new ClientInstance;
     pClient->pEventHandler = new TTMsgQueue();
+    pClient->pReactor = REACTORPOOL::instance()->AcquireReactor();
     pClient->pClientNode = new ClientNode(ACE_TEXT( TEAMTALK_VERSION ), 
-                                          pClient->pEventHandler);
+                                          pClient->pEventHandler,
+                                          pClient->pReactor);
 
     wguard_t g(clients_mutex);
     clients.insert(pClient);
@@ -365,6 +373,11 @@ TEAMTALKDLL_API TTInstance* TT_InitTeamTalkPoll()
     return pClient;
 }
 
+TEAMTALKDLL_API TTBOOL TT_SetSharedReactorThreads(IN INT32 nThreads)
+{
+    return REACTORPOOL::instance()->SetThreadCount(nThreads);
+}
+
 TEAMTALKDLL_API TTBOOL TT_CloseTeamTalk(IN TTInstance* lpTTInstance)
 {
     CLIENT pClient = GET_CLIENT(lpTTInstance);
@@ -387,6 +400,8 @@ TEAMTALKDLL_API TTBOOL TT_CloseTeamTalk(IN TTInstance* lpTTInstance)
     TTASSERT(ret>=0);
 
     delete pClient->pClientNode;
+    if(pClient->pReactor)
+        REACTORPOOL::instance()->ReleaseReactor(pClient->pReactor);
 
     delete pClient->pEventHandler;
 
@@ -1174,6 +1189,10 @@ TEAMTALKDLL_API TTBOOL TT_GetClientStatistics(IN TTInstance* lpTTInstance,
     if(pClientNode->GetClientStatistics(stats))
     {
         Convert(stats, *lpClientStatistics);
+        //events are counted by the message queue, not the client
+        ClientInstance* pClient = GET_CLIENT(lpTTInstance);
+        lpClientStatistics->nEventsCoalesced = pClient->pEventHandler->GetCoalescedCount();
+        lpClientStatistics->nEventsDropped = pClient->pEventHandler->GetDroppedCount();
         return TRUE;
     }
     return FALSE;
@@ -2210,6 +2229,16 @@ int ConvertBitmap(const DesktopWindow& src_wnd, BitmapFormat outputFormat,
 TEAMTALKDLL_API INT32 TT_SendDesktopWindow(IN TTInstance* lpTTInstance,
                                            IN const DesktopWindow* lpDesktopWindow,
                                            IN BitmapFormat nConvertBmpFormat)
+{
+    return TT_SendDesktopWindowEx(lpTTInstance, lpDesktopWindow,
+                                  nConvertBmpFormat, NULL, 0);
+}
+
+TEAMTALKDLL_API INT32 TT_SendDesktopWindowEx(IN TTInstance* lpTTInstance,
+                                             IN const DesktopWindow* lpDesktopWindow,
+                                             IN BitmapFormat nConvertBmpFormat,
+                                             IN const DesktopRegion* lpDirtyRegions,
+                                             IN INT32 nDirtyRegionsCount)
 {
     ClientNode* pClientNode;
     GET_CLIENTNODE_RET(pClientNode, lpTTInstance, -1);
@@ -2217,6 +2246,16 @@ TEAMTALKDLL_API INT32 TT_SendDesktopWindow(IN TTInstance* lpTTInstance,
     if(!lpDesktopWindow)
         return -1;
 
+    teamtalk::desktop_rects_t dirty_rects;
+    for(int i=0;lpDirtyRegions && i<nDirtyRegionsCount;i++)
+    {
+        dirty_rects.push_back(teamtalk::DesktopRect(lpDirtyRegions[i].nX,
+                                                    lpDirtyRegions[i].nY,
+                                                    lpDirtyRegions[i].nWidth,
+                                                    lpDirtyRegions[i].nHeight));
+    }
+    const teamtalk::desktop_rects_t* rects = lpDirtyRegions? &dirty_rects : NULL;
+
     teamtalk::DesktopSession src_session = 
         teamtalk::MakeDesktopSession(lpDesktopWindow->nWidth, 
                                      lpDesktopWindow->nHeight, 
@@ -2243,7 +2282,8 @@ TEAMTALKDLL_API INT32 TT_SendDesktopWindow(IN TTInstance* lpTTInstance,
                                               (teamtalk::RGBMode)lpDesktopWindow->bmpFormat,
                                               (teamtalk::DesktopProtocol)lpDesktopWindow->nProtocol, 
                                               reinterpret_cast<const char*>(lpDesktopWindow->frameBuffer),
-                                              lpDesktopWindow->nFrameBufferSize);
+                                              lpDesktopWindow->nFrameBufferSize,
+                                              rects);
     else
     {
         MYTRACE(ACE_TEXT("Warning: slow conversion of bitmap\n"));
@@ -2259,13 +2299,13 @@ TEAMTALKDLL_API INT32 TT_SendDesktopWindow(IN TTInstance* lpTTInstance,
                                                   dst_session.GetHeight(), 
                                                   dst_session.GetRGBMode(),
                                                   (teamtalk::DesktopProtocol)lpDesktopWindow->nProtocol,
-                                                  &tmp_buf[0], int(tmp_buf.size()));
+                                                  &tmp_buf[0], int(tmp_buf.size()), rects);
         else
             return pClientNode->SendDesktopWindow(dst_session.GetWidth(), 
                                                   dst_session.GetHeight(), 
                                                   dst_session.GetRGBMode(),
                                                   (teamtalk::DesktopProtocol)lpDesktopWindow->nProtocol,
-                                                  &buf[0], int(buf.size()));
+                                                  &buf[0], int(buf.size()), rects);
     }
 }
 
@@ -2540,6 +2580,9 @@ TEAMTALKDLL_API TTBOOL TT_PaintDesktopWindowEx(IN TTInstance* lpTTInstance,
 
     BITMAPINFO* pBMI = reinterpret_cast<BITMAPINFO*>(&bmi);
 
+    viewer->DecodeBlocks();
+    wguard_t g(viewer->lock());
+
     BOOL b;
     if(viewer->GetRGBMode() == BMP_RGB8_PALETTE)
     {
@@ -3245,6 +3288,30 @@ TEAMTALKDLL_API TTBOOL TT_GetMessage(IN TTInstance* lpTTInstance,
     return FALSE;
 }
 
+TEAMTALKDLL_API TTBOOL TT_GetMessages(IN TTInstance* lpTTInstance,
+                                      OUT TTMessage* pMsgs,
+                                      IN OUT INT32* pnCount,
+                                      IN INT32 nWaitMs)
+{
+    ClientInstance* pClient = GET_CLIENT(lpTTInstance);
+    if(pClient && pMsgs && pnCount && *pnCount > 0)
+    {
+        int count = *pnCount;
+        TTBOOL b;
+        if(nWaitMs != -1)
+        {
+            ACE_Time_Value tv(nWaitMs/1000, (nWaitMs % 1000) * 1000);
+            tv += ACE_OS::gettimeofday();
+            b = pClient->pEventHandler->GetMessages(pMsgs, count, &tv);
+        }
+        else
+            b = pClient->pEventHandler->GetMessages(pMsgs, count, NULL);
+        *pnCount = count;
+        return b;
+    }
+    return FALSE;
+}
+
 TEAMTALKDLL_API TTBOOL TT_PumpMessage(IN TTInstance* lpTTInstance,
                                       ClientEvent nEvent,
                                       INT32 nIdentifier)
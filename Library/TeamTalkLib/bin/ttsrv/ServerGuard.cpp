@@ -468,6 +468,7 @@ void ServerGuard::OnSaveConfiguration(ServerNode& servernode, const ServerUser*
     m_settings.SetMaxLoginAttempts(properties.maxloginattempts);
     m_settings.SetMaxLoginsPerIP(properties.max_logins_per_ipaddr);
     m_settings.SetUserTimeout(properties.usertimeout);
+    m_settings.SetDesktopCacheSize(properties.desktopcachesize);
     m_settings.SetVoiceTxLimit(properties.voicetxlimit);
     m_settings.SetVideoCaptureTxLimit(properties.videotxlimit);
     m_settings.SetMediaFileTxLimit(properties.mediafiletxlimit);
@@ -874,6 +875,7 @@ namespace teamtalk {
         properties.max_logins_per_ipaddr = xmlSettings.GetMaxLoginsPerIP();
         properties.maxloginattempts = xmlSettings.GetMaxLoginAttempts();
         properties.usertimeout = xmlSettings.GetUserTimeout();
+        properties.desktopcachesize = xmlSettings.GetDesktopCacheSize();
         properties.filesroot = Utf8ToUnicode(xmlSettings.GetFilesRoot().c_str());
         properties.diskquota = xmlSettings.GetDefaultDiskQuota();
         properties.maxdiskusage = xmlSettings.GetMaxDiskUsage();
@@ -453,6 +453,27 @@ namespace teamtalk{
         return val;
     }
 
+    bool ServerXML::SetDesktopCacheSize(_INT64 maxbytes)
+    {
+        TiXmlElement* parent = GetGeneralElement();
+        if(parent)
+        {
+            PutInteger(*parent, "desktop-cache-maxsize", maxbytes);
+            return true;
+        }
+        else
+            return false;
+    }
+
+    _INT64 ServerXML::GetDesktopCacheSize()
+    {
+        _INT64 val = 0;
+        TiXmlElement* parent = GetGeneralElement();
+        if(parent)
+            GetInteger(*parent, "desktop-cache-maxsize", val);
+        return val;
+    }
+
     bool ServerXML::SetVoiceTxLimit(int tx_bytes_per_sec)
     {
         TiXmlElement* parent = GetBandwidthLimitElement();
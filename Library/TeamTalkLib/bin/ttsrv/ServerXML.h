@@ -87,6 +87,9 @@ namespace teamtalk {
         bool SetMaxLoginsPerIP(int max_ip_logins);
         int GetMaxLoginsPerIP();
 
+        bool SetDesktopCacheSize(_INT64 maxbytes);
+        _INT64 GetDesktopCacheSize();
+
         /***** <bandwidth-limits> *****/
 
         bool SetVoiceTxLimit(int tx_bytes_per_sec);
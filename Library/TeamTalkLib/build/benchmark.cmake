@@ -0,0 +1,141 @@
+include (ttlib)
+include (ttsrvlib)
+include (openssl)
+include (speex)
+include (speexdsp)
+include (opus)
+include (ffmpeg)
+
+set (RESAMPLERBENCH_INCLUDE_DIR ${ACE_INCLUDE_DIR} ${TEAMTALKLIB_ROOT})
+set (RESAMPLERBENCH_COMPILE_FLAGS ${ACE_COMPILE_FLAGS})
+set (RESAMPLERBENCH_LINK_FLAGS ${ACE_STATIC_LIB} ${ACE_LINK_FLAGS})
+
+set (RESAMPLERBENCH_SOURCES
+  ${TEAMTALKLIB_ROOT}/bin/benchmark/ResamplerBench.cpp
+  ${TEAMTALKLIB_ROOT}/codec/AudioResampler.cpp
+  ${TEAMTALKLIB_ROOT}/codec/PolyphaseResampler.cpp
+  ${TEAMTALKLIB_ROOT}/myace/MyACE.cpp )
+
+set (RESAMPLERBENCH_HEADERS
+  ${TEAMTALKLIB_ROOT}/codec/AudioResampler.h
+  ${TEAMTALKLIB_ROOT}/codec/PolyphaseResampler.h
+  ${TEAMTALKLIB_ROOT}/myace/MyACE.h )
+
+if (SPEEXDSP)
+  list (APPEND RESAMPLERBENCH_SOURCES ${TEAMTALKLIB_ROOT}/codec/SpeexResampler.cpp)
+  list (APPEND RESAMPLERBENCH_HEADERS ${TEAMTALKLIB_ROOT}/codec/SpeexResampler.h)
+  list (APPEND RESAMPLERBENCH_COMPILE_FLAGS -DENABLE_SPEEX)
+  list (APPEND RESAMPLERBENCH_INCLUDE_DIR ${SPEEXDSP_INCLUDE_DIR})
+  list (APPEND RESAMPLERBENCH_LINK_FLAGS ${SPEEXDSP_STATIC_LIB})
+endif()
+
+if (FFMPEG)
+  list (APPEND RESAMPLERBENCH_SOURCES ${TEAMTALKLIB_ROOT}/codec/FFMpeg3Resampler.cpp)
+  list (APPEND RESAMPLERBENCH_HEADERS ${TEAMTALKLIB_ROOT}/codec/FFMpeg3Resampler.h)
+  list (APPEND RESAMPLERBENCH_COMPILE_FLAGS -DENABLE_FFMPEG3 ${FFMPEG_COMPILE_FLAGS})
+  list (APPEND RESAMPLERBENCH_INCLUDE_DIR ${FFMPEG_INCLUDE_DIR})
+  list (APPEND RESAMPLERBENCH_LINK_FLAGS ${FFMPEG_STATIC_LIB} ${FFMPEG_LINK_FLAGS})
+endif()
+
+set (VIDEOCONVERTBENCH_INCLUDE_DIR ${ACE_INCLUDE_DIR} ${TEAMTALKLIB_ROOT})
+set (VIDEOCONVERTBENCH_COMPILE_FLAGS ${ACE_COMPILE_FLAGS})
+set (VIDEOCONVERTBENCH_LINK_FLAGS ${ACE_STATIC_LIB} ${ACE_LINK_FLAGS})
+
+set (VIDEOCONVERTBENCH_SOURCES
+  ${TEAMTALKLIB_ROOT}/bin/benchmark/VideoConvertBench.cpp
+  ${TEAMTALKLIB_ROOT}/codec/VideoConvert.cpp
+  ${TEAMTALKLIB_ROOT}/codec/MediaUtil.cpp
+  ${TEAMTALKLIB_ROOT}/myace/MyACE.cpp )
+
+set (VIDEOCONVERTBENCH_HEADERS
+  ${TEAMTALKLIB_ROOT}/codec/VideoConvert.h
+  ${TEAMTALKLIB_ROOT}/codec/MediaUtil.h
+  ${TEAMTALKLIB_ROOT}/myace/MyACE.h )
+
+set (VIDEORATESIM_INCLUDE_DIR ${TEAMTALKLIB_ROOT})
+
+set (VIDEORATESIM_SOURCES
+  ${TEAMTALKLIB_ROOT}/bin/benchmark/VideoRateSim.cpp
+  ${TEAMTALKLIB_ROOT}/teamtalk/client/VideoRateControl.cpp )
+
+set (VIDEORATESIM_HEADERS
+  ${TEAMTALKLIB_ROOT}/teamtalk/client/VideoRateControl.h )
+
+set (LOADGEN_INCLUDE_DIR ${ACE_INCLUDE_DIR} ${TEAMTALKLIB_ROOT})
+set (LOADGEN_COMPILE_FLAGS ${ACE_COMPILE_FLAGS})
+set (LOADGEN_LINK_FLAGS ${ACE_STATIC_LIB} ${ACE_LINK_FLAGS})
+
+set (LOADGEN_SOURCES
+  ${TEAMTALKLIB_ROOT}/bin/benchmark/LoadGen.cpp
+  ${TEAMTALKLIB_ROOT}/myace/MyACE.cpp
+  ${TEAMTALKLIB_ROOT}/mystd/MyStd.cpp
+  ${TEAMTALKLIB_ROOT}/teamtalk/CodecCommon.cpp
+  ${TEAMTALKLIB_ROOT}/teamtalk/Commands.cpp
+  ${TEAMTALKLIB_ROOT}/teamtalk/Common.cpp
+  ${TEAMTALKLIB_ROOT}/teamtalk/PacketHandler.cpp
+  ${TEAMTALKLIB_ROOT}/teamtalk/PacketLayout.cpp
+  ${TEAMTALKLIB_ROOT}/teamtalk/ttassert.cpp )
+
+set (LOADGEN_HEADERS
+  ${TEAMTALKLIB_ROOT}/myace/MyACE.h
+  ${TEAMTALKLIB_ROOT}/mystd/MyStd.h
+  ${TEAMTALKLIB_ROOT}/teamtalk/CodecCommon.h
+  ${TEAMTALKLIB_ROOT}/teamtalk/Commands.h
+  ${TEAMTALKLIB_ROOT}/teamtalk/Common.h
+  ${TEAMTALKLIB_ROOT}/teamtalk/PacketHandler.h
+  ${TEAMTALKLIB_ROOT}/teamtalk/PacketLayout.h
+  ${TEAMTALKLIB_ROOT}/teamtalk/ttassert.h )
+
+set (MICROBENCH_INCLUDE_DIR ${TTSRVLIB_INCLUDE_DIR} ${OPENSSL_INCLUDE_DIR})
+set (MICROBENCH_COMPILE_FLAGS ${TTSRVLIB_COMPILE_FLAGS} -DENABLE_ENCRYPTION)
+set (MICROBENCH_LINK_FLAGS ${ACESSL_STATIC_LIB} ${TTSRVLIB_LINK_FLAGS} ${OPENSSL_STATIC_LIB})
+
+set (MICROBENCH_SOURCES
+  ${TTSRVLIB_SOURCES}
+  ${TEAMTALKLIB_ROOT}/bin/benchmark/MicroBench.cpp
+  ${TEAMTALKLIB_ROOT}/codec/AudioResampler.cpp
+  ${TEAMTALKLIB_ROOT}/codec/MediaUtil.cpp
+  ${TEAMTALKLIB_ROOT}/codec/PolyphaseResampler.cpp
+  ${TEAMTALKLIB_ROOT}/codec/VideoConvert.cpp
+  ${TEAMTALKLIB_ROOT}/soundsystem/SoundSystem.cpp
+  ${TEAMTALKLIB_ROOT}/soundsystem/SoundSystemBase.cpp )
+
+set (MICROBENCH_HEADERS
+  ${TTSRVLIB_HEADERS}
+  ${TEAMTALKLIB_ROOT}/codec/AudioResampler.h
+  ${TEAMTALKLIB_ROOT}/codec/MediaUtil.h
+  ${TEAMTALKLIB_ROOT}/codec/PolyphaseResampler.h
+  ${TEAMTALKLIB_ROOT}/codec/VideoConvert.h
+  ${TEAMTALKLIB_ROOT}/soundsystem/SoundSystem.h
+  ${TEAMTALKLIB_ROOT}/soundsystem/SoundSystemBase.h )
+
+# ENABLE_SPEEX covers both the Speex codec and the SpeexDSP resampler
+if (SPEEX AND SPEEXDSP)
+  list (APPEND MICROBENCH_SOURCES ${TEAMTALKLIB_ROOT}/codec/SpeexEncoder.cpp)
+  list (APPEND MICROBENCH_SOURCES ${TEAMTALKLIB_ROOT}/codec/SpeexDecoder.cpp)
+  list (APPEND MICROBENCH_SOURCES ${TEAMTALKLIB_ROOT}/codec/SpeexResampler.cpp)
+  list (APPEND MICROBENCH_HEADERS ${TEAMTALKLIB_ROOT}/codec/SpeexEncoder.h)
+  list (APPEND MICROBENCH_HEADERS ${TEAMTALKLIB_ROOT}/codec/SpeexDecoder.h)
+  list (APPEND MICROBENCH_HEADERS ${TEAMTALKLIB_ROOT}/codec/SpeexResampler.h)
+  list (APPEND MICROBENCH_COMPILE_FLAGS -DENABLE_SPEEX)
+  list (APPEND MICROBENCH_INCLUDE_DIR ${SPEEX_INCLUDE_DIR} ${SPEEXDSP_INCLUDE_DIR})
+  list (APPEND MICROBENCH_LINK_FLAGS ${SPEEX_STATIC_LIB} ${SPEEXDSP_STATIC_LIB})
+endif()
+
+if (OPUS)
+  list (APPEND MICROBENCH_SOURCES ${TEAMTALKLIB_ROOT}/codec/OpusEncoder.cpp)
+  list (APPEND MICROBENCH_SOURCES ${TEAMTALKLIB_ROOT}/codec/OpusDecoder.cpp)
+  list (APPEND MICROBENCH_HEADERS ${TEAMTALKLIB_ROOT}/codec/OpusEncoder.h)
+  list (APPEND MICROBENCH_HEADERS ${TEAMTALKLIB_ROOT}/codec/OpusDecoder.h)
+  list (APPEND MICROBENCH_COMPILE_FLAGS -DENABLE_OPUS)
+  list (APPEND MICROBENCH_INCLUDE_DIR ${OPUS_INCLUDE_DIR})
+  list (APPEND MICROBENCH_LINK_FLAGS ${OPUS_STATIC_LIB})
+endif()
+
+if (FFMPEG)
+  list (APPEND MICROBENCH_SOURCES ${TEAMTALKLIB_ROOT}/codec/FFMpeg3Resampler.cpp)
+  list (APPEND MICROBENCH_HEADERS ${TEAMTALKLIB_ROOT}/codec/FFMpeg3Resampler.h)
+  list (APPEND MICROBENCH_COMPILE_FLAGS -DENABLE_FFMPEG3 ${FFMPEG_COMPILE_FLAGS})
+  list (APPEND MICROBENCH_INCLUDE_DIR ${FFMPEG_INCLUDE_DIR})
+  list (APPEND MICROBENCH_LINK_FLAGS ${FFMPEG_STATIC_LIB} ${FFMPEG_LINK_FLAGS})
+endif()
@@ -28,8 +28,10 @@ option (SPEEXDSP "Build SpeexDSP codec classes" ON)
 
 if (SPEEXDSP)
   list (APPEND CODEC_SOURCES ${TEAMTALKLIB_ROOT}/codec/SpeexPreprocess.cpp)
+  list (APPEND CODEC_SOURCES ${TEAMTALKLIB_ROOT}/codec/EchoCanceller.cpp)
   list (APPEND CODEC_SOURCES ${TEAMTALKLIB_ROOT}/codec/SpeexResampler.cpp)
   list (APPEND CODEC_HEADERS ${TEAMTALKLIB_ROOT}/codec/SpeexPreprocess.h)
+  list (APPEND CODEC_HEADERS ${TEAMTALKLIB_ROOT}/codec/EchoCanceller.h)
   list (APPEND CODEC_HEADERS ${TEAMTALKLIB_ROOT}/codec/SpeexResampler.h)
   list (APPEND CODEC_COMPILE_FLAGS -DENABLE_SPEEX)
   list (APPEND CODEC_INCLUDE_DIR ${SPEEXDSP_INCLUDE_DIR})
@@ -29,6 +29,8 @@ set (TTCLIENT_HEADERS
   ${TEAMTALKLIB_ROOT}/codec/BmpFile.h
   ${TEAMTALKLIB_ROOT}/codec/MediaStreamer.h
   ${TEAMTALKLIB_ROOT}/codec/MediaUtil.h
+  ${TEAMTALKLIB_ROOT}/codec/PolyphaseResampler.h
+  ${TEAMTALKLIB_ROOT}/codec/VideoConvert.h
   ${TEAMTALKLIB_ROOT}/codec/WaveFile.h
   ${TEAMTALKLIB_ROOT}/myace/MyACE.h
   ${TEAMTALKLIB_ROOT}/myace/TimerHandler.h
@@ -52,7 +54,10 @@ set (TTCLIENT_HEADERS
   ${TEAMTALKLIB_ROOT}/teamtalk/client/ClientNode.h
   ${TEAMTALKLIB_ROOT}/teamtalk/client/ClientUser.h
   ${TEAMTALKLIB_ROOT}/teamtalk/client/FileNode.h
+  ${TEAMTALKLIB_ROOT}/teamtalk/client/JitterBuffer.h
+  ${TEAMTALKLIB_ROOT}/teamtalk/client/ReactorPool.h
   ${TEAMTALKLIB_ROOT}/teamtalk/client/StreamPlayers.h
+  ${TEAMTALKLIB_ROOT}/teamtalk/client/VideoRateControl.h
   ${TEAMTALKLIB_ROOT}/teamtalk/client/VideoThread.h
   ${TEAMTALKLIB_ROOT}/teamtalk/client/VoiceLogger.h
   ${TEAMTALKLIB_ROOT}/teamtalk/client/AudioMuxer.h
@@ -67,6 +72,8 @@ set ( TTCLIENT_SOURCES
   ${TEAMTALKLIB_ROOT}/codec/BmpFile.cpp
   ${TEAMTALKLIB_ROOT}/codec/MediaStreamer.cpp
   ${TEAMTALKLIB_ROOT}/codec/MediaUtil.cpp
+  ${TEAMTALKLIB_ROOT}/codec/PolyphaseResampler.cpp
+  ${TEAMTALKLIB_ROOT}/codec/VideoConvert.cpp
   ${TEAMTALKLIB_ROOT}/codec/WaveFile.cpp
   ${TEAMTALKLIB_ROOT}/teamtalk/Channel.cpp
   ${TEAMTALKLIB_ROOT}/teamtalk/CodecCommon.cpp
@@ -85,7 +92,10 @@ set ( TTCLIENT_SOURCES
   ${TEAMTALKLIB_ROOT}/teamtalk/client/ClientNode.cpp
   ${TEAMTALKLIB_ROOT}/teamtalk/client/ClientUser.cpp
   ${TEAMTALKLIB_ROOT}/teamtalk/client/FileNode.cpp
+  ${TEAMTALKLIB_ROOT}/teamtalk/client/JitterBuffer.cpp
+  ${TEAMTALKLIB_ROOT}/teamtalk/client/ReactorPool.cpp
   ${TEAMTALKLIB_ROOT}/teamtalk/client/StreamPlayers.cpp
+  ${TEAMTALKLIB_ROOT}/teamtalk/client/VideoRateControl.cpp
   ${TEAMTALKLIB_ROOT}/teamtalk/client/VideoThread.cpp
   ${TEAMTALKLIB_ROOT}/teamtalk/client/VoiceLogger.cpp
   ${TEAMTALKLIB_ROOT}/teamtalk/client/AudioMuxer.cpp
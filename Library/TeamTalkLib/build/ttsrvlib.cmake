@@ -1,8 +1,9 @@
 include (ttlib)
+include (zlib)
 
-set (TTSRVLIB_INCLUDE_DIR ${ACE_INCLUDE_DIR} ${TEAMTALKLIB_ROOT})
+set (TTSRVLIB_INCLUDE_DIR ${ACE_INCLUDE_DIR} ${ZLIB_INCLUDE_DIR} ${TEAMTALKLIB_ROOT})
 set (TTSRVLIB_COMPILE_FLAGS ${ACE_COMPILE_FLAGS})
-set (TTSRVLIB_LINK_FLAGS ${ACE_LINK_FLAGS} ${ACE_STATIC_LIB})
+set (TTSRVLIB_LINK_FLAGS ${ACE_LINK_FLAGS} ${ACE_STATIC_LIB} ${ZLIB_STATIC_LIB})
 
 set ( TTSRVLIB_HEADERS 
   ${TEAMTALKLIB_ROOT}/TeamTalkDefs.h
@@ -22,6 +22,11 @@
  */
 
 #include "AudioResampler.h"
+#include "PolyphaseResampler.h"
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
 
 #if defined(ENABLE_SPEEX)
 #include <codec/SpeexResampler.h>
@@ -36,6 +41,8 @@
 #endif
 
 #define ZERO_IT 0
+//extra room for samples a backend may release from its own delay line
+#define RESAMPLER_SLACK_SAMPLES 32
 
 int CalcSamples(int src_samplerate, int src_samples, int dest_samplerate)
 {
@@ -45,6 +52,96 @@ int CalcSamples(int src_samplerate, int src_samples, int dest_samplerate)
     return (int)samples;
 }
 
+AudioResampler::AudioResampler()
+: m_input_samplerate(0)
+, m_output_samplerate(0)
+, m_output_channels(0)
+, m_fifo_samples(0)
+, m_fifo_primed(false)
+, m_fifo_errors(0)
+{
+}
+
+void AudioResampler::InitFIFO(int input_samplerate, int output_channels,
+                              int output_samplerate)
+{
+    m_input_samplerate = input_samplerate;
+    m_output_channels = output_channels;
+    m_output_samplerate = output_samplerate;
+    m_fifo.clear();
+    m_fifo_samples = 0;
+    m_fifo_primed = false;
+    m_fifo_errors = 0;
+}
+
+int AudioResampler::Resample(const short* input_samples, int input_samples_size,
+                             short* output_samples, int output_samples_size)
+{
+    assert(m_output_channels);
+    if(!m_output_channels)
+        return 0;
+
+    const int channels = m_output_channels;
+    //samples kept in FIFO to absorb rounding of the callers' block sizes
+    const int margin = output_samples_size / 8 + 1;
+
+    int capacity = CalcSamples(m_input_samplerate, input_samples_size,
+                               m_output_samplerate) + RESAMPLER_SLACK_SAMPLES;
+    size_t needed = (m_fifo_samples + capacity) * channels;
+    if(m_fifo.size() < needed)
+        m_fifo.resize(needed);
+
+    int ret = Process(input_samples, input_samples_size,
+                      &m_fifo[m_fifo_samples * channels], capacity);
+    assert(ret >= 0);
+    if(ret < 0)
+        return 0;
+    m_fifo_samples += ret;
+
+    if(!m_fifo_primed)
+    {
+        //delay stream with silence so later calls never run short
+        int prime = std::max(0, output_samples_size - m_fifo_samples) + margin;
+        needed = (m_fifo_samples + prime) * channels;
+        if(m_fifo.size() < needed)
+            m_fifo.resize(needed);
+        memmove(&m_fifo[prime * channels], &m_fifo[0],
+                m_fifo_samples * channels * sizeof(short));
+        memset(&m_fifo[0], 0, prime * channels * sizeof(short));
+        m_fifo_samples += prime;
+        m_fifo_primed = true;
+    }
+
+    int n = std::min(m_fifo_samples, output_samples_size);
+    memcpy(output_samples, &m_fifo[0], n * channels * sizeof(short));
+    m_fifo_samples -= n;
+    memmove(&m_fifo[0], &m_fifo[n * channels], m_fifo_samples * channels * sizeof(short));
+
+    if(n < output_samples_size)
+    {
+        //caller provides less input than its output requires
+        MYTRACE(ACE_TEXT("Resampler FIFO ran dry, %d of %d samples\n"),
+                n, output_samples_size);
+        if(n == 0)
+            memset(output_samples, 0, output_samples_size * channels * sizeof(short));
+        else
+            FillOutput(channels, output_samples, n, output_samples_size);
+        m_fifo_errors++;
+    }
+    else if(m_fifo_samples > output_samples_size + margin)
+    {
+        //caller provides more input than its output requires so drop
+        //oldest samples to bound latency
+        int drop = m_fifo_samples - margin;
+        MYTRACE(ACE_TEXT("Resampler FIFO overflow, dropped %d samples\n"), drop);
+        m_fifo_samples -= drop;
+        memmove(&m_fifo[0], &m_fifo[drop * channels], m_fifo_samples * channels * sizeof(short));
+        m_fifo_errors++;
+    }
+
+    return output_samples_size;
+}
+
 void AudioResampler::FillOutput(int channels, short* output_samples,
                                 int output_samples_written,
                                 int output_samples_total)
@@ -74,59 +171,129 @@ void AudioResampler::FillOutput(int channels, short* output_samples,
 }
 
 
-audio_resampler_t MakeAudioResampler(int input_channels, int input_samplerate, 
-                                     int output_channels, int output_samplerate)
+static audio_resampler_t MakePolyphaseResampler(int input_channels, int input_samplerate, 
+                                                int output_channels, int output_samplerate)
 {
-    audio_resampler_t resampler;
-    bool ret = false;
-#if defined(ACE_WIN32) && defined(ENABLE_DMORESAMPLER)
-    if(IsWindows6OrLater())
-    {
-        DMOResampler* tmp_resample;
-        ACE_NEW_RETURN(tmp_resample, DMOResampler(), audio_resampler_t());
-        resampler = audio_resampler_t(tmp_resample);
-
-        ret  = tmp_resample->Init(SAMPLEFORMAT_INT16, 
-                                  input_channels, 
-                                  input_samplerate,
-                                  SAMPLEFORMAT_INT16, 
-                                  output_channels,
-                                  output_samplerate);
-        MYTRACE(ACE_TEXT("Launched DMOResampler\n"));
-    }
-#elif defined(ENABLE_FFMPEG1) || defined(ENABLE_FFMPEG3)
-    {
-        FFMPEGResampler* tmp_resample;
-        ACE_NEW_RETURN(tmp_resample, FFMPEGResampler(), audio_resampler_t());
-        resampler = audio_resampler_t(tmp_resample);
-
-        ret = tmp_resample->Init(input_samplerate,
-                                 input_channels,
-                                 output_samplerate,
-                                 output_channels);
-        MYTRACE(ACE_TEXT("Launched FFMPEGResampler\n"));
-    }
-#elif defined(ENABLE_SPEEX)
-#if defined(ACE_WIN32) && defined(ENABLE_DMORESAMPLER)
-    else
+    PolyphaseResampler* tmp_resample;
+    ACE_NEW_RETURN(tmp_resample, PolyphaseResampler(), audio_resampler_t());
+    audio_resampler_t resampler(tmp_resample);
+
+    if(!tmp_resample->Init(input_samplerate, input_channels,
+                           output_samplerate, output_channels))
+        return audio_resampler_t();
+
+    MYTRACE(ACE_TEXT("Launched PolyphaseResampler\n"));
+    return resampler;
+}
+
+static audio_resampler_t MakeSpeexResampler(int input_channels, int input_samplerate, 
+                                            int output_channels, int output_samplerate)
+{
+#if defined(ENABLE_SPEEX)
+    SpeexResampler* tmp_resample;
+    ACE_NEW_RETURN(tmp_resample, SpeexResampler(), audio_resampler_t());
+    audio_resampler_t resampler(tmp_resample);
+
+    if(!tmp_resample->Init(5, input_samplerate,
+                           input_channels,
+                           output_samplerate,
+                           output_channels))
+        return audio_resampler_t();
+
+    MYTRACE(ACE_TEXT("Launched SpeexResampler\n"));
+    return resampler;
+#else
+    return audio_resampler_t();
 #endif
-    {
-        SpeexResampler* tmp_resample;
-        ACE_NEW_RETURN(tmp_resample, SpeexResampler(), audio_resampler_t());
-        resampler = audio_resampler_t(tmp_resample);
-
-        ret = tmp_resample->Init(5, input_samplerate,
-                                 input_channels,
-                                 output_samplerate,
-                                 output_channels);
-        MYTRACE(ACE_TEXT("Launched SpeexResampler\n"));
-    }
+}
+
+static audio_resampler_t MakeFFMPEGResampler(int input_channels, int input_samplerate, 
+                                             int output_channels, int output_samplerate)
+{
+#if !defined(ACE_WIN32) && (defined(ENABLE_FFMPEG1) || defined(ENABLE_FFMPEG3))
+    FFMPEGResampler* tmp_resample;
+    ACE_NEW_RETURN(tmp_resample, FFMPEGResampler(), audio_resampler_t());
+    audio_resampler_t resampler(tmp_resample);
+
+    if(!tmp_resample->Init(input_samplerate,
+                           input_channels,
+                           output_samplerate,
+                           output_channels))
+        return audio_resampler_t();
+
+    MYTRACE(ACE_TEXT("Launched FFMPEGResampler\n"));
+    return resampler;
 #else
-#pragma message("No resampler available")
+    return audio_resampler_t();
 #endif
-    if(!ret)
-        resampler.reset();
+}
 
+static audio_resampler_t MakeDMOResampler(int input_channels, int input_samplerate, 
+                                          int output_channels, int output_samplerate)
+{
+#if defined(ACE_WIN32) && defined(ENABLE_DMORESAMPLER)
+    if(!IsWindows6OrLater())
+        return audio_resampler_t();
+
+    DMOResampler* tmp_resample;
+    ACE_NEW_RETURN(tmp_resample, DMOResampler(), audio_resampler_t());
+    audio_resampler_t resampler(tmp_resample);
+
+    if(!tmp_resample->Init(SAMPLEFORMAT_INT16, 
+                           input_channels, 
+                           input_samplerate,
+                           SAMPLEFORMAT_INT16, 
+                           output_channels,
+                           output_samplerate))
+        return audio_resampler_t();
+
+    MYTRACE(ACE_TEXT("Launched DMOResampler\n"));
     return resampler;
+#else
+    return audio_resampler_t();
+#endif
 }
 
+audio_resampler_t MakeAudioResampler(int input_channels, int input_samplerate, 
+                                     int output_channels, int output_samplerate,
+                                     AudioResamplerType type)
+{
+    audio_resampler_t resampler;
+
+    switch(type)
+    {
+    case AUDIORESAMPLER_DEFAULT :
+        resampler = MakePolyphaseResampler(input_channels, input_samplerate,
+                                           output_channels, output_samplerate);
+        //sample rate ratio not supported by polyphase filter bank
+        if(resampler.null())
+            resampler = MakeDMOResampler(input_channels, input_samplerate,
+                                         output_channels, output_samplerate);
+        if(resampler.null())
+            resampler = MakeFFMPEGResampler(input_channels, input_samplerate,
+                                            output_channels, output_samplerate);
+        if(resampler.null())
+            resampler = MakeSpeexResampler(input_channels, input_samplerate,
+                                           output_channels, output_samplerate);
+        break;
+    case AUDIORESAMPLER_POLYPHASE :
+        resampler = MakePolyphaseResampler(input_channels, input_samplerate,
+                                           output_channels, output_samplerate);
+        break;
+    case AUDIORESAMPLER_SPEEX :
+        resampler = MakeSpeexResampler(input_channels, input_samplerate,
+                                       output_channels, output_samplerate);
+        break;
+    case AUDIORESAMPLER_FFMPEG :
+        resampler = MakeFFMPEGResampler(input_channels, input_samplerate,
+                                        output_channels, output_samplerate);
+        break;
+    case AUDIORESAMPLER_DMO :
+        resampler = MakeDMOResampler(input_channels, input_samplerate,
+                                     output_channels, output_samplerate);
+        break;
+    }
+
+    MYTRACE_COND(resampler.null(), ACE_TEXT("No resampler available\n"));
+    return resampler;
+}
@@ -27,30 +27,78 @@
 #include <myace/MyACE.h>
 #include <ace/Bound_Ptr.h>
 
+#include <vector>
+
 //with a callback of 'src_samples' and sample rate of
 //'src_samplerate', how many samples should be provided given a
 //samplerate of 'dest_samplerate'
 int CalcSamples(int src_samplerate, int src_samples, int dest_samplerate);
 
+/* Streaming audio resampler.
+ *
+ * Backends implement Process() which consumes all input and writes
+ * however many samples the conversion yields. Resample() queues the
+ * backend's output in a FIFO so the caller always gets exactly the
+ * number of samples requested, carrying the remainder (and the
+ * backend's fractional state) over to the next call. The FIFO is
+ * primed with silence on the first call and its buffers only grow
+ * until they fit the callers' block sizes. */
 class AudioResampler
 {
 public:
+    AudioResampler();
     virtual ~AudioResampler() {}
 
-    virtual int Resample(const short* input_samples, int input_samples_size,
-                         short* output_samples, int output_samples_size) = 0;
+    //resample all of 'input_samples' and write exactly
+    //'output_samples_size' samples (per channel) to 'output_samples'.
+    //Returns 'output_samples_size' or 0 on error.
+    int Resample(const short* input_samples, int input_samples_size,
+                 short* output_samples, int output_samples_size);
+
+    //samples (per channel) currently held in the FIFO
+    int GetBufferedSamples() const { return m_fifo_samples; }
+    //number of times the FIFO ran dry or overflowed
+    int GetFIFOErrors() const { return m_fifo_errors; }
 
 protected:
+    //resample all of 'input_samples' and return number of samples
+    //(per channel) written to 'output_samples'. At most
+    //'output_samples_size' samples can be written.
+    virtual int Process(const short* input_samples, int input_samples_size,
+                        short* output_samples, int output_samples_size) = 0;
+
+    //backends must call this from their Init()
+    void InitFIFO(int input_samplerate, int output_channels, int output_samplerate);
+
+private:
     void FillOutput(int channels, short* output_samples,
                     int output_samples_written,
                     int output_samples_total);
+
+    int m_input_samplerate, m_output_samplerate;
+    int m_output_channels;
+    //resampled audio not yet returned to caller, interleaved
+    std::vector<short> m_fifo;
+    int m_fifo_samples;
+    bool m_fifo_primed;
+    int m_fifo_errors;
 };
 
 typedef ACE_Strong_Bound_Ptr< AudioResampler, ACE_Null_Mutex > audio_resampler_t;
 
+enum AudioResamplerType
+{
+    AUDIORESAMPLER_DEFAULT  = 0,
+    AUDIORESAMPLER_POLYPHASE,
+    AUDIORESAMPLER_SPEEX,
+    AUDIORESAMPLER_FFMPEG,
+    AUDIORESAMPLER_DMO,
+};
+
 audio_resampler_t MakeAudioResampler(int input_channels, 
                                      int input_samplerate, 
                                      int output_channels, 
-                                     int output_samplerate);
+                                     int output_samplerate,
+                                     AudioResamplerType type = AUDIORESAMPLER_DEFAULT);
 
 #endif
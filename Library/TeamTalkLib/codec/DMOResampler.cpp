@@ -244,6 +244,7 @@ bool DMOResampler::Init(SampleFormat inputSampleFmt, int input_channels,
     if (FAILED(hr))
         goto fail;
 
+    InitFIFO(input_samplerate, output_channels, output_samplerate);
     return true;
 
 fail:
@@ -269,8 +270,8 @@ void DMOResampler::Close()
     m_pDMO = NULL;
 }
 
-int DMOResampler::Resample(const short* input_samples, int input_samples_cnt,
-                           short* output_samples, int output_samples_cnt)
+int DMOResampler::Process(const short* input_samples, int input_samples_cnt,
+                          short* output_samples, int output_samples_cnt)
 {
     assert(m_pDMO);
     if(!m_pDMO)
@@ -317,9 +318,6 @@ int DMOResampler::Resample(const short* input_samples, int input_samples_cnt,
             output_samples_cnt * 2 * pOutputWav->nChannels, status);
 */
 
-    for(int i=0;i<output_samples_cnt*pOutputWav->nChannels;i++)
-        output_samples[i] = 32766;
-
     hr = m_pDMO->ProcessInput(0, input_mb, 0, 0, 0);
     assert(SUCCEEDED(hr));
     if(FAILED(hr))
@@ -338,13 +336,6 @@ int DMOResampler::Resample(const short* input_samples, int input_samples_cnt,
     ret = (dwLen / sizeof(short)) / pOutputWav->nChannels;
     assert(ret <= output_samples_cnt);
 
-    if(ret < output_samples_cnt)
-    {
-        FillOutput(pOutputWav->nChannels, output_samples, ret, output_samples_cnt);
-    }
-    MYTRACE_COND(ret != output_samples_cnt,
-                 ACE_TEXT("Unexpect number of samples %d!=%d, %d\n"), ret, output_samples_cnt, (int)output_samples[output_samples_cnt-1]);
-
 fail:
     if(input_mb)
         input_mb->Release();
@@ -48,9 +48,9 @@ public:
               int output_channels, int output_samplerate);
     void Close();
 
-    //returns no. of samples in output
-    int Resample(const short* input_samples, int input_samples_cnt,
-                 short* output_samples, int output_samples_cnt);
+protected:
+    int Process(const short* input_samples, int input_samples_cnt,
+                short* output_samples, int output_samples_cnt);
 private:
     IMediaObject* m_pDMO;
     DMO_MEDIA_TYPE m_mt_input, m_mt_output;
@@ -0,0 +1,371 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+#include "EchoCanceller.h"
+
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+
+//how often cross-correlation is done
+#define ECHODELAY_UPDATE_MSEC 250
+//required normalized cross-correlation for a delay candidate
+#define ECHODELAY_MIN_CORRELATION 0.5f
+//subtracted from estimated delay so reference always leads echo
+#define ECHODELAY_MARGIN_MSEC 20
+
+EchoDelayEstimator::EchoDelayEstimator()
+{
+    Close();
+}
+
+void EchoDelayEstimator::Open(int samplerate)
+{
+    assert(samplerate > 0);
+    Close();
+
+    m_samplerate = samplerate;
+    m_bin_samples = samplerate * ECHODELAY_BIN_MSEC / 1000;
+    m_max_lag = ECHODELAY_MAX_MSEC / ECHODELAY_BIN_MSEC;
+    m_window = ECHODELAY_WINDOW_MSEC / ECHODELAY_BIN_MSEC;
+    m_ref_env.resize(m_window + m_max_lag);
+    m_cap_env.resize(m_window + m_max_lag);
+}
+
+void EchoDelayEstimator::Close()
+{
+    m_samplerate = m_bin_samples = m_max_lag = m_window = 0;
+    m_bin_pos = 0;
+    m_ref_acc = m_cap_acc = 0;
+    m_ref_env.clear();
+    m_cap_env.clear();
+    m_bins = 0;
+    m_candidate = -1;
+    m_candidate_hits = 0;
+    m_delay = -1;
+}
+
+bool EchoDelayEstimator::Update(const short* reference, const short* capture,
+                                int samples, int channels)
+{
+    assert(m_bin_samples > 0);
+    if(m_bin_samples <= 0)
+        return false;
+
+    const size_t update_bins = ECHODELAY_UPDATE_MSEC / ECHODELAY_BIN_MSEC;
+    bool changed = false;
+    for(int i=0;i<samples;i++)
+    {
+        for(int c=0;c<channels;c++)
+        {
+            m_ref_acc += abs(reference[i*channels + c]);
+            m_cap_acc += abs(capture[i*channels + c]);
+        }
+        if(++m_bin_pos == m_bin_samples)
+        {
+            AddBin(m_ref_acc / m_bin_pos, m_cap_acc / m_bin_pos);
+            m_ref_acc = m_cap_acc = 0;
+            m_bin_pos = 0;
+
+            if(m_bins >= m_ref_env.size() && m_bins % update_bins == 0)
+                changed |= Estimate();
+        }
+    }
+    return changed;
+}
+
+void EchoDelayEstimator::AddBin(float reference, float capture)
+{
+    size_t i = m_bins % m_ref_env.size();
+    m_ref_env[i] = reference;
+    m_cap_env[i] = capture;
+    m_bins++;
+}
+
+bool EchoDelayEstimator::Estimate()
+{
+    const size_t size = m_ref_env.size();
+    //first bin of capture window
+    const size_t first = m_bins - m_window;
+
+    float cap_mean = 0;
+    for(int i=0;i<m_window;i++)
+        cap_mean += m_cap_env[(first + i) % size];
+    cap_mean /= m_window;
+
+    float cap_var = 0;
+    for(int i=0;i<m_window;i++)
+    {
+        float d = m_cap_env[(first + i) % size] - cap_mean;
+        cap_var += d * d;
+    }
+    //nothing captured so the echo path cannot be observed
+    if(cap_var < m_window)
+        return false;
+
+    int best_lag = -1;
+    float best_corr = ECHODELAY_MIN_CORRELATION;
+    for(int lag=0;lag<=m_max_lag;lag++)
+    {
+        const size_t ref_first = first - lag;
+        float ref_mean = 0;
+        for(int i=0;i<m_window;i++)
+            ref_mean += m_ref_env[(ref_first + i) % size];
+        ref_mean /= m_window;
+
+        float ref_var = 0, cov = 0;
+        for(int i=0;i<m_window;i++)
+        {
+            float r = m_ref_env[(ref_first + i) % size] - ref_mean;
+            float c = m_cap_env[(first + i) % size] - cap_mean;
+            ref_var += r * r;
+            cov += r * c;
+        }
+        //reference is silent at this lag
+        if(ref_var < m_window)
+            continue;
+
+        float corr = cov / sqrtf(ref_var * cap_var);
+        if(corr > best_corr)
+        {
+            best_corr = corr;
+            best_lag = lag;
+        }
+    }
+
+    if(best_lag < 0)
+        return false;
+
+    if(m_candidate >= 0 && abs(best_lag - m_candidate) <= 1)
+        m_candidate_hits++;
+    else
+    {
+        m_candidate = best_lag;
+        m_candidate_hits = 1;
+    }
+
+    if(m_candidate_hits < 2)
+        return false;
+
+    int delay = m_candidate * m_bin_samples;
+    if(m_delay >= 0 && abs(delay - m_delay) <= m_bin_samples)
+        return false;
+
+    m_delay = delay;
+    return true;
+}
+
+EchoCanceller::EchoCanceller()
+: m_samplerate(0)
+, m_input_channels(0)
+, m_output_channels(0)
+, m_framesize(0)
+, m_delayline_pos(0)
+, m_delay(0)
+{
+}
+
+EchoCanceller::~EchoCanceller()
+{
+    Close();
+}
+
+bool EchoCanceller::Open(int samplerate, int input_channels, 
+                         int output_channels, int framesize)
+{
+    assert(!IsOpen());
+    assert(input_channels == 1 || input_channels == 2);
+    assert(output_channels == 1 || output_channels == 2);
+    if(IsOpen() || input_channels < 1 || input_channels > 2 ||
+       output_channels < 1 || output_channels > 2 || framesize <= 0)
+        return false;
+
+    for(int c=0;c<input_channels;c++)
+    {
+        if(!m_preprocess[c].Initialize(samplerate, framesize))
+        {
+            Close();
+            return false;
+        }
+        //only residual echo suppression is wanted. Denoise and AGC
+        //are done at the codec's sample rate
+        m_preprocess[c].EnableDenoise(false);
+    }
+
+    m_estimator.Open(samplerate);
+
+    m_samplerate = samplerate;
+    m_input_channels = input_channels;
+    m_output_channels = output_channels;
+    m_framesize = framesize;
+
+    m_reference.resize(framesize * input_channels);
+    int delayline_samples = framesize + samplerate * ECHODELAY_MAX_MSEC / 1000;
+    m_delayline.assign(delayline_samples * input_channels, 0);
+    m_delayline_pos = 0;
+    m_delay = 0;
+
+    m_chan_capture.resize(framesize);
+    m_chan_reference.resize(framesize);
+    m_chan_cancelled.resize(framesize);
+    return true;
+}
+
+void EchoCanceller::Close()
+{
+    for(int c=0;c<2;c++)
+        m_preprocess[c].Close();
+    m_estimator.Close();
+
+    m_samplerate = m_input_channels = m_output_channels = m_framesize = 0;
+    m_reference.clear();
+    m_delayline.clear();
+    m_delayline_pos = 0;
+    m_delay = 0;
+    m_chan_capture.clear();
+    m_chan_reference.clear();
+    m_chan_cancelled.clear();
+}
+
+bool EchoCanceller::EnableEchoCancel(bool enable)
+{
+    bool ret = IsOpen();
+    for(int c=0;c<m_input_channels;c++)
+        ret &= m_preprocess[c].EnableEchoCancel(enable, ECHOCANCEL_TAIL_MSEC);
+    return ret;
+}
+
+bool EchoCanceller::IsEchoCancel() const
+{
+    return IsOpen() && m_preprocess[0].IsEchoCancel();
+}
+
+bool EchoCanceller::SetEchoSuppressLevel(int level)
+{
+    bool ret = IsOpen();
+    for(int c=0;c<m_input_channels;c++)
+        ret &= m_preprocess[c].SetEchoSuppressLevel(level);
+    return ret;
+}
+
+bool EchoCanceller::SetEchoSuppressActive(int level)
+{
+    bool ret = IsOpen();
+    for(int c=0;c<m_input_channels;c++)
+        ret &= m_preprocess[c].SetEchoSuppressActive(level);
+    return ret;
+}
+
+void EchoCanceller::Process(const short* capture, const short* speaker, 
+                            short* cancelled)
+{
+    assert(IsOpen());
+    if(!IsEchoCancel())
+    {
+        memcpy(cancelled, capture, m_framesize * m_input_channels * sizeof(short));
+        return;
+    }
+
+    //convert reference to the channels of the captured signal
+    if(m_output_channels == m_input_channels)
+        memcpy(&m_reference[0], speaker, m_reference.size() * sizeof(short));
+    else if(m_output_channels == 2)
+    {
+        for(int i=0;i<m_framesize;i++)
+            m_reference[i] = short((int(speaker[i*2]) + int(speaker[i*2+1])) / 2);
+    }
+    else
+    {
+        for(int i=0;i<m_framesize;i++)
+            m_reference[i*2] = m_reference[i*2+1] = speaker[i];
+    }
+
+    if(m_estimator.Update(&m_reference[0], capture, m_framesize, m_input_channels))
+    {
+        int delay = m_estimator.GetDelay() - m_samplerate * ECHODELAY_MARGIN_MSEC / 1000;
+        if(delay < 0)
+            delay = 0;
+        if(delay != m_delay)
+        {
+            m_delay = delay;
+            //filter has adapted to the old alignment
+            for(int c=0;c<m_input_channels;c++)
+                m_preprocess[c].ResetEcho();
+        }
+    }
+
+    DelayReference();
+
+    for(int c=0;c<m_input_channels;c++)
+        ProcessChannel(m_preprocess[c], c, capture, cancelled);
+}
+
+int EchoCanceller::GetEchoDelay() const
+{
+    return m_samplerate? m_delay * 1000 / m_samplerate : 0;
+}
+
+void EchoCanceller::DelayReference()
+{
+    const int channels = m_input_channels;
+    const size_t capacity = m_delayline.size() / channels;
+    assert(size_t(m_delay + m_framesize) <= capacity);
+
+    for(int i=0;i<m_framesize;i++)
+    {
+        size_t pos = (m_delayline_pos + i) % capacity;
+        for(int c=0;c<channels;c++)
+            m_delayline[pos*channels + c] = m_reference[i*channels + c];
+    }
+
+    size_t start = m_delayline_pos + capacity - m_delay;
+    for(int i=0;i<m_framesize;i++)
+    {
+        size_t pos = (start + i) % capacity;
+        for(int c=0;c<channels;c++)
+            m_reference[i*channels + c] = m_delayline[pos*channels + c];
+    }
+
+    m_delayline_pos = (m_delayline_pos + m_framesize) % capacity;
+}
+
+void EchoCanceller::ProcessChannel(SpeexPreprocess& preprocess, int channel,
+                                   const short* capture, short* cancelled)
+{
+    const int channels = m_input_channels;
+    for(int i=0;i<m_framesize;i++)
+    {
+        m_chan_capture[i] = capture[i*channels + channel];
+        m_chan_reference[i] = m_reference[i*channels + channel];
+    }
+
+    preprocess.EchoCancel(&m_chan_capture[0], &m_chan_reference[0],
+                          &m_chan_cancelled[0]);
+    //residual echo suppression
+    preprocess.Preprocess(&m_chan_cancelled[0]);
+
+    for(int i=0;i<m_framesize;i++)
+        cancelled[i*channels + channel] = m_chan_cancelled[i];
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+#if !defined(ECHOCANCELLER_H)
+#define ECHOCANCELLER_H
+
+#include <vector>
+#include <cstddef>
+#include <codec/SpeexPreprocess.h>
+
+//longest echo path delay which can be detected
+#define ECHODELAY_MAX_MSEC 500
+//length of signal envelopes which are cross-correlated
+#define ECHODELAY_WINDOW_MSEC 1000
+//envelope resolution
+#define ECHODELAY_BIN_MSEC 2
+//echo path which the adaptive filter must cover after alignment
+#define ECHOCANCEL_TAIL_MSEC 250
+
+/* Estimates the delay between a playback reference and the echo of
+ * it in the captured signal.
+ *
+ * Both signals are reduced to amplitude envelopes with
+ * ECHODELAY_BIN_MSEC resolution and the capture envelope is
+ * periodically cross-correlated with delayed versions of the
+ * reference envelope. A new delay is only accepted once the same
+ * correlation peak has been found twice in a row, so double talk
+ * and silence do not make the estimate jump. */
+class EchoDelayEstimator
+{
+public:
+    EchoDelayEstimator();
+
+    void Open(int samplerate);
+    void Close();
+
+    //returns true if the delay estimate changed
+    bool Update(const short* reference, const short* capture,
+                int samples, int channels);
+
+    //delay in samples, -1 if not yet known
+    int GetDelay() const { return m_delay; }
+
+private:
+    void AddBin(float reference, float capture);
+    bool Estimate();
+
+    int m_samplerate;
+    int m_bin_samples, m_max_lag, m_window;
+    //partial bin
+    int m_bin_pos;
+    float m_ref_acc, m_cap_acc;
+    //circular envelope histories of 'm_window + m_max_lag' bins
+    std::vector<float> m_ref_env, m_cap_env;
+    size_t m_bins;
+    int m_candidate, m_candidate_hits;
+    int m_delay;
+};
+
+/* Echo canceller which runs at the sound device's sample rate in
+ * duplex mode.
+ *
+ * The reference is the exact buffer which was sent to the sound
+ * device so it does not go through a resampler. The reference is
+ * delayed by the echo path latency reported by EchoDelayEstimator
+ * so the adaptive filter only has to cover the acoustic echo tail
+ * (ECHOCANCEL_TAIL_MSEC) instead of both device latencies. */
+class EchoCanceller
+{
+public:
+    EchoCanceller();
+    ~EchoCanceller();
+
+    bool Open(int samplerate, int input_channels, int output_channels,
+              int framesize);
+    void Close();
+    bool IsOpen() const { return m_framesize > 0; }
+
+    bool EnableEchoCancel(bool enable);
+    bool IsEchoCancel() const;
+    bool SetEchoSuppressLevel(int level);
+    bool SetEchoSuppressActive(int level);
+
+    //'capture' and 'cancelled' have input channels and 'speaker' has
+    //output channels. All of 'framesize' samples.
+    void Process(const short* capture, const short* speaker, short* cancelled);
+
+    //delay applied to reference in msec
+    int GetEchoDelay() const;
+
+private:
+    //replaces 'm_reference' with the delayed reference
+    void DelayReference();
+    void ProcessChannel(SpeexPreprocess& preprocess, int channel,
+                        const short* capture, short* cancelled);
+
+    SpeexPreprocess m_preprocess[2];
+    EchoDelayEstimator m_estimator;
+    int m_samplerate, m_input_channels, m_output_channels, m_framesize;
+    //reference converted to input channels
+    std::vector<short> m_reference;
+    //circular delay line of reference
+    std::vector<short> m_delayline;
+    size_t m_delayline_pos;
+    int m_delay;
+    //per channel work buffers
+    std::vector<short> m_chan_capture, m_chan_reference, m_chan_cancelled;
+};
+
+#endif
@@ -56,7 +56,11 @@ bool FFMPEGResampler::Init(int input_samplerate, int input_channels,
     if(!m_ctx)
         return false;
 
-    return swr_init(m_ctx) >= 0;
+    if(swr_init(m_ctx) < 0)
+        return false;
+
+    InitFIFO(input_samplerate, output_channels, output_samplerate);
+    return true;
 }
 
 void FFMPEGResampler::Close()
@@ -66,8 +70,8 @@ void FFMPEGResampler::Close()
     m_ctx = NULL;
 }
 
-int FFMPEGResampler::Resample(const short* input_samples, int input_samples_size,
-                              short* output_samples, int output_samples_size)
+int FFMPEGResampler::Process(const short* input_samples, int input_samples_size,
+                             short* output_samples, int output_samples_size)
 {
     const uint8_t* in_ptr[SWR_CH_MAX] =  {0};
     in_ptr[0] = (uint8_t*)input_samples;
@@ -44,9 +44,9 @@ public:
               int output_samplerate, int output_channels);
     void Close();
 
-    //return number of samples written to 'output_samples'
-    int Resample(const short* input_samples, int input_samples_size,
-                 short* output_samples, int output_samples_size);
+protected:
+    int Process(const short* input_samples, int input_samples_size,
+                short* output_samples, int output_samples_size);
 
 private:
     SwrContext* m_ctx;
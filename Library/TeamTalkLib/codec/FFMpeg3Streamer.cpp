@@ -127,7 +127,11 @@ AVFilterGraph* createVideoFilterGraph(AVFormatContext *fmt_ctx,
                                       AVCodecContext* vid_dec_ctx,
                                       AVFilterContext*& vid_buffersink_ctx,
                                       AVFilterContext*& vid_buffersrc_ctx,
-                                      int video_stream_index);
+                                      int video_stream_index,
+                                      media::FourCC out_fourcc);
+
+ACE_Message_Block* AVFrameToMsgBlock(AVFrame* frame, media::FourCC fourcc,
+                                     ACE_UINT32 timestamp);
 
 void FillMediaFileProp(AVFormatContext *fmt_ctx,
                        AVCodecContext *aud_dec_ctx, 
@@ -326,7 +330,8 @@ int FFMpegStreamer::svc()
         video_filter_graph = createVideoFilterGraph(fmt_ctx, vid_dec_ctx,
                                                     vid_buffersink_ctx,
                                                     vid_buffersrc_ctx,
-                                                    video_stream_index);
+                                                    video_stream_index,
+                                                    m_media_out.video_fourcc);
         if(!video_filter_graph)
         {
             m_open.set(false);
@@ -613,13 +618,9 @@ int FFMpegStreamer::ProcessVideoBuffer(AVFilterContext* vid_buffersink_ctx,
         MYTRACE(ACE_TEXT("Video frame %d at tick %u, frame time: %u, diff: %u, pts: %.3f.\n"),
                 n_vidframe++, ticks, frame_timestamp, ticks - frame_timestamp, frame_sec);
 
-        int bmp_size = filt_frame->height * filt_frame->linesize[0];
-        VideoFrame media_frame(reinterpret_cast<char*>(filt_frame->data[0]),
-                               bmp_size, filt_frame->width, filt_frame->height,
-                               media::FOURCC_RGB32, true);
-        media_frame.timestamp = frame_timestamp;
-
-        ACE_Message_Block* mb = VideoFrameToMsgBlock(media_frame);
+        ACE_Message_Block* mb = AVFrameToMsgBlock(filt_frame,
+                                                  m_media_out.video_fourcc,
+                                                  frame_timestamp);
         assert(filt_frame->width == m_media_in.video_width);
         assert(filt_frame->height == m_media_in.video_height);
         if(mb)
@@ -637,7 +638,7 @@ int FFMpegStreamer::ProcessVideoBuffer(AVFilterContext* vid_buffersink_ctx,
             if(push < 0)
             {
                 mb->release();
-                MYTRACE(ACE_TEXT("Dropped video frame %u\n"), media_frame.timestamp);
+                MYTRACE(ACE_TEXT("Dropped video frame %u\n"), frame_timestamp);
             }
             // MYTRACE_COND(push >= 0,
             //              ACE_TEXT("Insert video frame %u\n"), media_frame.timestamp);
@@ -780,7 +781,8 @@ AVFilterGraph* createVideoFilterGraph(AVFormatContext *fmt_ctx,
                                       AVCodecContext* vid_dec_ctx,
                                       AVFilterContext*& vid_buffersink_ctx,
                                       AVFilterContext*& vid_buffersrc_ctx,
-                                      int video_stream_index)
+                                      int video_stream_index,
+                                      media::FourCC out_fourcc)
 {
     //init filters
     AVFilterGraph *filter_graph;
@@ -790,7 +792,9 @@ AVFilterGraph* createVideoFilterGraph(AVFormatContext *fmt_ctx,
     AVFilter *buffersink = avfilter_get_by_name("buffersink");
     AVFilterInOut *outputs = avfilter_inout_alloc();
     AVFilterInOut *inputs  = avfilter_inout_alloc();
-    const enum AVPixelFormat pix_fmts[] = { AV_PIX_FMT_RGB32, AV_PIX_FMT_NONE };
+    enum AVPixelFormat pix_fmts[] = { AV_PIX_FMT_RGB32, AV_PIX_FMT_NONE };
+    if(out_fourcc == media::FOURCC_I420)
+        pix_fmts[0] = AV_PIX_FMT_YUV420P;
     char filters_descr[100];
 
     snprintf(filters_descr, sizeof(filters_descr), "scale=%d:%d",
@@ -861,3 +865,48 @@ end:
 
 }
 
+ACE_Message_Block* AVFrameToMsgBlock(AVFrame* frame, media::FourCC fourcc,
+                                     ACE_UINT32 timestamp)
+{
+    int width = frame->width, height = frame->height;
+    switch(fourcc)
+    {
+    case media::FOURCC_I420 :
+    {
+        //pack the planes so the frame can be passed to the encoder as is
+        VideoFrame media_frame(NULL, I420_BYTES(width, height), width, height,
+                               media::FOURCC_I420, true);
+        media_frame.timestamp = timestamp;
+
+        ACE_Message_Block* mb = VideoFrameInMsgBlock(media_frame);
+        if(!mb)
+            return NULL;
+
+        char* dst = media_frame.frame;
+        for(int p=0;p<3;p++)
+        {
+            int w = p? (width + 1) / 2 : width;
+            int h = p? (height + 1) / 2 : height;
+            for(int y=0;y<h;y++)
+            {
+                memcpy(dst, frame->data[p] + y * frame->linesize[p], w);
+                dst += w;
+            }
+        }
+        assert(dst == media_frame.frame + media_frame.frame_length);
+        return mb;
+    }
+    case media::FOURCC_RGB32 :
+    {
+        int bmp_size = height * frame->linesize[0];
+        VideoFrame media_frame(reinterpret_cast<char*>(frame->data[0]),
+                               bmp_size, width, height,
+                               media::FOURCC_RGB32, true);
+        media_frame.timestamp = timestamp;
+        return VideoFrameToMsgBlock(media_frame);
+    }
+    default :
+        assert(0);
+        return NULL;
+    }
+}
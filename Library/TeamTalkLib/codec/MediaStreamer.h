@@ -63,12 +63,16 @@ struct MediaStreamOutput
     int audio_samplerate;
     int audio_samples;
 
+    //FOURCC_RGB32 or FOURCC_I420
+    media::FourCC video_fourcc;
+
     MediaStreamOutput()
     : audio(false)
     , video(false)
     , audio_channels(0)
     , audio_samplerate(0)
-    , audio_samples(0) {}
+    , audio_samples(0)
+    , video_fourcc(media::FOURCC_RGB32) {}
 };
 
 bool GetMediaFileProp(const ACE_TString& filename, MediaFileProp& fileprop);
@@ -46,6 +46,113 @@ void MergeStereo(const std::vector<short>& left_chan,
         output_buffer[i*2+1] = right_chan[i];
 }
 
+//keeps buffer size in front of the data and the data 16-byte aligned
+#define VIDEOFRAMEPOOL_HEADER 16
+
+VideoFramePool::VideoFramePool()
+: m_cached_bytes(0)
+{
+}
+
+VideoFramePool::~VideoFramePool()
+{
+    for(buffers_t::iterator i=m_buffers.begin();i!=m_buffers.end();++i)
+    {
+        for(size_t j=0;j<i->second.size();j++)
+            delete [] i->second[j];
+    }
+}
+
+VideoFramePool* VideoFramePool::instance()
+{
+    static VideoFramePool pool;
+    return &pool;
+}
+
+void* VideoFramePool::malloc(size_t nbytes)
+{
+    char* buf = NULL;
+    {
+        ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+        buffers_t::iterator ii = m_buffers.find(nbytes);
+        if(ii != m_buffers.end() && ii->second.size())
+        {
+            buf = ii->second.back();
+            ii->second.pop_back();
+            m_cached_bytes -= nbytes;
+        }
+    }
+
+    if(!buf)
+    {
+        ACE_NEW_RETURN(buf, char[VIDEOFRAMEPOOL_HEADER + nbytes], NULL);
+        *reinterpret_cast<size_t*>(buf) = nbytes;
+    }
+    return buf + VIDEOFRAMEPOOL_HEADER;
+}
+
+void* VideoFramePool::calloc(size_t nbytes, char initial_value)
+{
+    void* ptr = this->malloc(nbytes);
+    if(ptr)
+        memset(ptr, initial_value, nbytes);
+    return ptr;
+}
+
+void* VideoFramePool::calloc(size_t n_elem, size_t elem_size, char initial_value)
+{
+    return this->calloc(n_elem * elem_size, initial_value);
+}
+
+void VideoFramePool::free(void* ptr)
+{
+    if(!ptr)
+        return;
+
+    char* buf = static_cast<char*>(ptr) - VIDEOFRAMEPOOL_HEADER;
+    size_t nbytes = *reinterpret_cast<size_t*>(buf);
+    {
+        ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+
+        //resolution changed, so drop buffers nobody will ask for
+        if(m_cached_bytes + nbytes > VIDEOFRAMEPOOL_MAX_BYTES)
+            EvictOtherSizes(nbytes);
+
+        std::vector<char*>& bufs = m_buffers[nbytes];
+        if(bufs.size() < VIDEOFRAMEPOOL_MAX_FRAMES &&
+           m_cached_bytes + nbytes <= VIDEOFRAMEPOOL_MAX_BYTES)
+        {
+            bufs.push_back(buf);
+            m_cached_bytes += nbytes;
+            return;
+        }
+    }
+    delete [] buf;
+}
+
+size_t VideoFramePool::GetCachedBytes()
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+    return m_cached_bytes;
+}
+
+void VideoFramePool::EvictOtherSizes(size_t nbytes)
+{
+    buffers_t::iterator ii = m_buffers.begin();
+    while(ii != m_buffers.end())
+    {
+        if(ii->first == nbytes)
+        {
+            ++ii;
+            continue;
+        }
+        for(size_t j=0;j<ii->second.size();j++)
+            delete [] ii->second[j];
+        m_cached_bytes -= ii->first * ii->second.size();
+        m_buffers.erase(ii++);
+    }
+}
+
 ACE_Message_Block* VideoFrameInMsgBlock(media::VideoFrame& frm,
                                         ACE_Message_Block::ACE_Message_Type mb_type)
 {
@@ -53,7 +160,8 @@ ACE_Message_Block* VideoFrameInMsgBlock(media::VideoFrame& frm,
     
     ACE_Message_Block* mb;
     ACE_NEW_RETURN(mb, 
-                   ACE_Message_Block(frm.frame_length+sizeof(frm), mb_type), 
+                   ACE_Message_Block(frm.frame_length+sizeof(frm), mb_type,
+                                     NULL, NULL, VideoFramePool::instance()),
                    NULL);
     frm.frame = &mb->rd_ptr()[sizeof(frm)];
     mb->copy(reinterpret_cast<const char*> (&frm), sizeof(frm));
@@ -67,7 +175,9 @@ ACE_Message_Block* VideoFrameToMsgBlock(const media::VideoFrame& frm,
     assert(frm.frame_length);
     media::VideoFrame tmp = frm;
     ACE_Message_Block* mb;
-    ACE_NEW_RETURN(mb, ACE_Message_Block(sizeof(tmp)+frm.frame_length, mb_type), NULL);
+    ACE_NEW_RETURN(mb, ACE_Message_Block(sizeof(tmp)+frm.frame_length, mb_type,
+                                         NULL, NULL, VideoFramePool::instance()),
+                   NULL);
     tmp.frame = &mb->rd_ptr()[sizeof(tmp)];
 
     int ret = mb->copy(reinterpret_cast<const char*>(&tmp), sizeof(tmp));
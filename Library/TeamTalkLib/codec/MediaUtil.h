@@ -25,6 +25,8 @@
 #define MEDIAUTIL_H
 
 #include <myace/MyACE.h>
+#include <ace/Malloc_Allocator.h>
+#include <map>
 
 namespace media
 {
@@ -111,6 +113,38 @@ namespace media
 
 }
 
+/* Allocator which keeps released video frame buffers so the next
+ * frame of the same size reuses one instead of going to the heap.
+ * Message blocks from VideoFrameInMsgBlock() and
+ * VideoFrameToMsgBlock() use this allocator for their data, so a
+ * buffer returns to the pool when the last reference to its
+ * ACE_Message_Block is released. */
+#define VIDEOFRAMEPOOL_MAX_FRAMES   8                   //per frame size
+#define VIDEOFRAMEPOOL_MAX_BYTES    (32 * 1024 * 1024)  //all frame sizes
+
+class VideoFramePool : public ACE_New_Allocator
+{
+public:
+    static VideoFramePool* instance();
+
+    void* malloc(size_t nbytes);
+    void* calloc(size_t nbytes, char initial_value = '\0');
+    void* calloc(size_t n_elem, size_t elem_size, char initial_value = '\0');
+    void free(void* ptr);
+
+    size_t GetCachedBytes();
+
+private:
+    VideoFramePool();
+    ~VideoFramePool();
+    void EvictOtherSizes(size_t nbytes);
+
+    ACE_Thread_Mutex m_mutex;
+    typedef std::map< size_t, std::vector<char*> > buffers_t;
+    buffers_t m_buffers;
+    size_t m_cached_bytes;
+};
+
 ACE_Message_Block* VideoFrameInMsgBlock(media::VideoFrame& frm,
                                         ACE_Message_Block::ACE_Message_Type mb_type = ACE_Message_Block::MB_DATA);
 ACE_Message_Block* VideoFrameToMsgBlock(const media::VideoFrame& frm,
@@ -127,6 +161,9 @@ void MergeStereo(const std::vector<short>& left_chan,
 
 #define RGB32_BYTES(w, h) (h * w * 4)
 
+//Y plane followed by U and V planes of half width and height
+#define I420_BYTES(w, h) ((h) * (w) + 2 * (((w) + 1) / 2) * (((h) + 1) / 2))
+
 #define SOFTGAIN(samples, n_samples, channels, factor) do {     \
     int samples_total = channels*n_samples;                     \
     if(samples_total % 4 == 0)                                  \
@@ -63,3 +63,14 @@ int OpusDecode::Decode(const char* input_buffer, int input_bufsize,
                        input_buffer?input_bufsize:0, output_buffer, 
                        output_samples, input_buffer?0:1);
 }
+
+int OpusDecode::DecodeFEC(const char* input_buffer, int input_bufsize, 
+                          short* output_buffer, int output_samples)
+{
+    assert(m_decoder);
+    assert(input_buffer);
+    assert(output_buffer);
+    return opus_decode(m_decoder, 
+                       reinterpret_cast<const unsigned char*>(input_buffer),
+                       input_bufsize, output_buffer, output_samples, 1);
+}
@@ -43,6 +43,10 @@ public:
 
     int Decode(const char* input_buffer, int input_bufsize, 
                short* output_buffer, int output_samples);
+    // Decode previous (lost) frame from in-band FEC data of
+    // 'input_buffer'
+    int DecodeFEC(const char* input_buffer, int input_bufsize, 
+                  short* output_buffer, int output_samples);
 
 private:
     OpusDecoder* m_decoder;
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+#include "PolyphaseResampler.h"
+
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define POLYPHASE_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define POLYPHASE_NEON 1
+#endif
+
+#if !defined(M_PI)
+#define M_PI 3.14159265358979323846
+#endif
+
+//zero crossings covered by the filter when not downsampling
+#define POLYPHASE_TAPS 32
+//cutoff relative to the lower of the two Nyquist frequencies
+#define POLYPHASE_ROLLOFF 0.92
+
+namespace
+{
+    int GCD(int a, int b)
+    {
+        while(b)
+        {
+            int t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    //'n' must be a multiple of 4
+    inline float DotProduct(const float* a, const float* b, int n)
+    {
+#if defined(POLYPHASE_SSE)
+        __m128 sum = _mm_setzero_ps();
+        for(int i=0;i<n;i+=4)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        __m128 shuf = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1));
+        sum = _mm_add_ps(sum, shuf);
+        shuf = _mm_movehl_ps(shuf, sum);
+        sum = _mm_add_ss(sum, shuf);
+        return _mm_cvtss_f32(sum);
+#elif defined(POLYPHASE_NEON)
+        float32x4_t sum = vdupq_n_f32(0);
+        for(int i=0;i<n;i+=4)
+            sum = vmlaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+        float32x2_t r = vadd_f32(vget_high_f32(sum), vget_low_f32(sum));
+        return vget_lane_f32(vpadd_f32(r, r), 0);
+#else
+        float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for(int i=0;i<n;i+=4)
+        {
+            s0 += a[i] * b[i];
+            s1 += a[i+1] * b[i+1];
+            s2 += a[i+2] * b[i+2];
+            s3 += a[i+3] * b[i+3];
+        }
+        return (s0 + s1) + (s2 + s3);
+#endif
+    }
+
+    inline short ToSample(float v)
+    {
+        long s = lrintf(v);
+        if(s > 32767)
+            return 32767;
+        if(s < -32768)
+            return -32768;
+        return short(s);
+    }
+}
+
+PolyphaseResampler::PolyphaseResampler()
+: m_input_channels(0)
+, m_output_channels(0)
+, m_up(0)
+, m_down(0)
+, m_taps(0)
+, m_history_samples(0)
+, m_pos(0)
+, m_phase(0)
+{
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+    Close();
+}
+
+bool PolyphaseResampler::Init(int input_samplerate, int input_channels, 
+                              int output_samplerate, int output_channels)
+{
+    if(m_taps)
+        return false;
+
+    if(input_samplerate <= 0 || output_samplerate <= 0 ||
+       input_channels < 1 || input_channels > 2 ||
+       output_channels < 1 || output_channels > 2)
+        return false;
+
+    int gcd = GCD(input_samplerate, output_samplerate);
+    int up = output_samplerate / gcd;
+    int down = input_samplerate / gcd;
+    if(up > POLYPHASE_MAX_PHASES)
+        return false;
+
+    //widen filter when downsampling so its cutoff stays sharp
+    double cutoff = std::min(1.0, double(up) / double(down)) * POLYPHASE_ROLLOFF;
+    int taps = int(ceil(POLYPHASE_TAPS / cutoff));
+    taps = (taps + 3) & ~3;
+
+    m_filters.resize(up * taps);
+    const double center = taps / 2 - 1;
+    const double half = taps / 2;
+    for(int p=0;p<up;p++)
+    {
+        float* filter = &m_filters[p * taps];
+        double frac = double(p) / up;
+        double sum = 0;
+        for(int j=0;j<taps;j++)
+        {
+            double d = center + frac - j;
+            double x = M_PI * cutoff * d;
+            double sinc = (fabs(x) < 1e-9)? 1.0 : sin(x) / x;
+            double u = d / half;
+            //Blackman window
+            double w = (fabs(u) >= 1.0)? 0.0 :
+                0.42 + 0.5 * cos(M_PI * u) + 0.08 * cos(2 * M_PI * u);
+            filter[j] = float(cutoff * sinc * w);
+            sum += filter[j];
+        }
+        //unity gain at DC for every phase
+        for(int j=0;j<taps && sum != 0;j++)
+            filter[j] = float(filter[j] / sum);
+    }
+
+    m_input_channels = input_channels;
+    m_output_channels = output_channels;
+    m_up = up;
+    m_down = down;
+    m_taps = taps;
+
+    //center of first filter is aligned with first input sample
+    m_history_samples = taps / 2 - 1;
+    for(int c=0;c<output_channels;c++)
+        m_history[c].assign(m_history_samples, 0.0f);
+    m_pos = m_phase = 0;
+
+    InitFIFO(input_samplerate, output_channels, output_samplerate);
+    return true;
+}
+
+void PolyphaseResampler::Close()
+{
+    m_filters.clear();
+    m_history[0].clear();
+    m_history[1].clear();
+    m_history_samples = m_pos = m_phase = 0;
+    m_up = m_down = m_taps = 0;
+    m_input_channels = m_output_channels = 0;
+}
+
+int PolyphaseResampler::Process(const short* input_samples, int input_samples_size,
+                                short* output_samples, int output_samples_size)
+{
+    assert(m_taps);
+    if(!m_taps)
+        return -1;
+
+    size_t needed = m_history_samples + input_samples_size;
+    for(int c=0;c<m_output_channels;c++)
+    {
+        if(m_history[c].size() < needed)
+            m_history[c].resize(needed);
+    }
+
+    float* left = &m_history[0][m_history_samples];
+    float* right = (m_output_channels == 2)? &m_history[1][m_history_samples] : NULL;
+    if(m_input_channels == m_output_channels)
+    {
+        for(int i=0;i<input_samples_size;i++)
+        {
+            left[i] = input_samples[i * m_input_channels];
+            if(right)
+                right[i] = input_samples[i * 2 + 1];
+        }
+    }
+    else if(m_input_channels == 2) //stereo to mono
+    {
+        for(int i=0;i<input_samples_size;i++)
+            left[i] = (input_samples[i * 2] + input_samples[i * 2 + 1]) * 0.5f;
+    }
+    else //mono to stereo
+    {
+        for(int i=0;i<input_samples_size;i++)
+            left[i] = right[i] = input_samples[i];
+    }
+    m_history_samples += input_samples_size;
+
+    int n = 0;
+    while(n < output_samples_size && m_pos + m_taps <= m_history_samples)
+    {
+        const float* filter = &m_filters[m_phase * m_taps];
+        for(int c=0;c<m_output_channels;c++)
+        {
+            float v = DotProduct(&m_history[c][m_pos], filter, m_taps);
+            output_samples[n * m_output_channels + c] = ToSample(v);
+        }
+        n++;
+
+        m_phase += m_down;
+        m_pos += m_phase / m_up;
+        m_phase %= m_up;
+    }
+
+    //drop input which no longer contributes to output
+    int consumed = std::min(m_pos, m_history_samples);
+    if(consumed)
+    {
+        for(int c=0;c<m_output_channels;c++)
+        {
+            memmove(&m_history[c][0], &m_history[c][consumed],
+                    (m_history_samples - consumed) * sizeof(float));
+        }
+        m_history_samples -= consumed;
+        m_pos -= consumed;
+    }
+    return n;
+}
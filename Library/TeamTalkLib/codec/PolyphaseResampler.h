@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+#if !defined(POLYPHASERESAMPLER_H)
+#define POLYPHASERESAMPLER_H
+
+#include <vector>
+#include <codec/AudioResampler.h>
+
+//largest interpolation factor (output rate / gcd of rates)
+#define POLYPHASE_MAX_PHASES 1024
+
+/* Windowed-sinc polyphase resampler.
+ *
+ * The sample rate ratio is reduced to 'up'/'down' and a bank of
+ * 'up' filters is precomputed so each output sample is a single dot
+ * product, which is vectorized with SSE or NEON when available. The
+ * input history and filter phase are carried across calls so any
+ * input block size can be used. */
+class PolyphaseResampler : public AudioResampler
+{
+public:
+    PolyphaseResampler();
+    virtual ~PolyphaseResampler();
+
+    //fails if rates need more than POLYPHASE_MAX_PHASES filters
+    bool Init(int input_samplerate, int input_channels, 
+              int output_samplerate, int output_channels);
+    void Close();
+
+protected:
+    int Process(const short* input_samples, int input_samples_size,
+                short* output_samples, int output_samples_size);
+
+private:
+    int m_input_channels, m_output_channels;
+    int m_up, m_down;
+    //taps per filter (multiple of 4)
+    int m_taps;
+    //'m_up' filters of 'm_taps' coefficients
+    std::vector<float> m_filters;
+    //input not yet consumed, one buffer per output channel
+    std::vector<float> m_history[2];
+    int m_history_samples;
+    //position in 'm_history' and filter of next output sample
+    int m_pos, m_phase;
+};
+
+#endif
@@ -203,7 +203,7 @@ bool SpeexPreprocess::GetAGCSettings(SpeexAGC& agc)
 #endif
 }
 
-bool SpeexPreprocess::EnableEchoCancel(bool enable)
+bool SpeexPreprocess::EnableEchoCancel(bool enable, int tail_msec)
 {
     if(enable)
     {
@@ -216,7 +216,7 @@ bool SpeexPreprocess::EnableEchoCancel(bool enable)
             EnableEchoCancel(false);
         }
 
-        m_echo_state = speex_echo_state_init(m_framesize, m_samplerate/2);
+        m_echo_state = speex_echo_state_init(m_framesize, m_samplerate * tail_msec / 1000);
         assert(m_echo_state);
         int ret = speex_echo_ctl(m_echo_state, SPEEX_ECHO_SET_SAMPLING_RATE, &m_samplerate);
         assert(ret == 0);
@@ -79,7 +79,8 @@ public:
     bool SetAGCSettings(const SpeexAGC& agc);
     bool GetAGCSettings(SpeexAGC& agc);
 
-    bool EnableEchoCancel(bool enable);
+    //'tail_msec' is the length of the echo path the filter can model
+    bool EnableEchoCancel(bool enable, int tail_msec = 500);
     bool IsEchoCancel() const;
     bool SetEchoSuppressLevel(int level);
     int GetEchoSuppressLevel();
@@ -53,6 +53,7 @@ bool SpeexResampler::Init(int quality, int input_samplerate, int input_channels,
 
     m_input_channels = input_channels;
     m_output_channels = output_channels;
+    InitFIFO(input_samplerate, output_channels, output_samplerate);
 
     return true;
 }
@@ -69,8 +70,8 @@ void SpeexResampler::Close()
     }
 }
 
-int SpeexResampler::Resample(const short* input_samples, int input_samples_size, 
-                             short* output_samples, int output_samples_size)
+int SpeexResampler::Process(const short* input_samples, int input_samples_size, 
+                            short* output_samples, int output_samples_size)
 {
     //setup buffer for mono vs. stereo conversion
     if(m_input_channels != m_output_channels)
@@ -126,12 +127,6 @@ int SpeexResampler::Resample(const short* input_samples, int input_samples_size,
     }
     else { assert(0); return 0; }
     
-    MYTRACE_COND(output_samples_size != (int)output_size,
-                 ACE_TEXT("Unexpect number of samples %d!=%d\n"), output_samples_size, output_size);
     assert((int)output_size <= output_samples_size);
-    if((int)output_size < output_samples_size)
-    {
-        FillOutput(m_output_channels, output_samples, output_size, output_samples_size);
-    }
     return err == 0? output_size : 0;
 }
@@ -0,0 +1,922 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+#include "VideoConvert.h"
+
+#include <string.h>
+#include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VIDEOCONVERT_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define VIDEOCONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(VIDEOCONVERT_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+/* All kernels work on a single row. The SIMD kernels return how many
+ * pixels they converted and the scalar kernel does the rest, so the
+ * scalar code defines the output. */
+
+namespace
+{
+    inline uint8_t CLAMP(int v)
+    {
+        if (v > 255)
+            return 255;
+        else if (v < 0)
+            return 0;
+        return (uint8_t)v;
+    }
+
+    //RGB32 is stored as B, G, R, A
+    inline uint8_t RGB32ToY(const uint8_t* p)
+    {
+        return uint8_t((30 * p[0] + 59 * p[1] + 11 * p[2]) / 100);
+    }
+    inline uint8_t RGB32ToU(const uint8_t* p)
+    {
+        return uint8_t((50 * p[0] - 42 * p[1] - 8 * p[2] + 12800) / 100);
+    }
+    inline uint8_t RGB32ToV(const uint8_t* p)
+    {
+        return uint8_t((-17 * p[0] - 33 * p[1] + 50 * p[2] + 12800) / 100);
+    }
+
+    void I420RowToRGB32_C(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                          uint8_t* rgb32, int width)
+    {
+        for(int j=0;j<width;j++)
+        {
+            int pr = (-56992 + v[j / 2] * 409) >> 8;
+            int pg = (34784 - u[j / 2] * 100 - v[j / 2] * 208) >> 8;
+            int pb = (-70688 + u[j / 2] * 516) >> 8;
+            int yy = 298 * y[j] >> 8;
+            *rgb32++ = CLAMP(yy + pb);
+            *rgb32++ = CLAMP(yy + pg);
+            *rgb32++ = CLAMP(yy + pr);
+            *rgb32++ = 255;
+        }
+    }
+
+    void RGB32RowToY_C(const uint8_t* rgb32, uint8_t* y, int width)
+    {
+        for(int j=0;j<width;j++)
+            y[j] = RGB32ToY(&rgb32[j * 4]);
+    }
+
+    //chroma of the right pixel in each pair
+    void RGB32RowToUV_C(const uint8_t* rgb32, uint8_t* u, uint8_t* v, int width)
+    {
+        for(int i=0;i<(width + 1) / 2;i++)
+        {
+            const uint8_t* p = &rgb32[std::min(i * 2 + 1, width - 1) * 4];
+            u[i] = RGB32ToU(p);
+            v[i] = RGB32ToV(p);
+        }
+    }
+
+    void YUY2RowToY_C(const uint8_t* yuy2, uint8_t* y, int width)
+    {
+        for(int j=0;j<width;j++)
+            y[j] = yuy2[j * 2];
+    }
+
+    void YUY2RowsToUV_C(const uint8_t* yuy2_0, const uint8_t* yuy2_1,
+                        uint8_t* u, uint8_t* v, int width)
+    {
+        for(int i=0;i<(width + 1) / 2;i++)
+        {
+            u[i] = uint8_t((yuy2_0[i * 4 + 1] + yuy2_1[i * 4 + 1] + 1) >> 1);
+            v[i] = uint8_t((yuy2_0[i * 4 + 3] + yuy2_1[i * 4 + 3] + 1) >> 1);
+        }
+    }
+
+    void SplitUVRow_C(const uint8_t* uv, uint8_t* u, uint8_t* v, int uv_width)
+    {
+        for(int i=0;i<uv_width;i++)
+        {
+            u[i] = uv[i * 2];
+            v[i] = uv[i * 2 + 1];
+        }
+    }
+
+#if defined(VIDEOCONVERT_X86)
+
+    /* Divide by 100 as (x * 41944) >> 22 which is exact for
+     * 0 <= x <= 25600. */
+#define SSE2_DIV100(x) \
+    _mm_srli_epi16(_mm_mulhi_epu16(x, _mm_set1_epi16(short(41944))), 6)
+
+    //each 32-bit lane into two 16-bit lanes
+#define SSE2_DUP16(x) \
+    _mm_or_si128(_mm_and_si128(x, _mm_set1_epi32(0xffff)), _mm_slli_epi32(x, 16))
+
+    TARGET_SSE2
+    int I420RowToRGB32_SSE2(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                            uint8_t* rgb32, int width)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        //madd_epi16() coefficients in the low 16 bits of each 32-bit lane
+        const __m128i v_r = _mm_set1_epi32(409);
+        const __m128i u_g = _mm_set1_epi32(uint16_t(-100));
+        const __m128i v_g = _mm_set1_epi32(uint16_t(-208));
+        const __m128i u_b = _mm_set1_epi32(516);
+        const __m128i alpha = _mm_set1_epi16(255);
+
+        int n = 0;
+        for(;n + 8 <= width;n += 8)
+        {
+            __m128i yy = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + n)), zero);
+            yy = _mm_mulhi_epu16(_mm_slli_epi16(yy, 8), _mm_set1_epi16(298));
+
+            int32_t u4, v4;
+            memcpy(&u4, u + n / 2, sizeof(u4));
+            memcpy(&v4, v + n / 2, sizeof(v4));
+            __m128i uu = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(u4), zero), zero);
+            __m128i vv = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v4), zero), zero);
+
+            __m128i pr = _mm_add_epi32(_mm_madd_epi16(vv, v_r), _mm_set1_epi32(-56992));
+            __m128i pg = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(uu, u_g),
+                                                     _mm_madd_epi16(vv, v_g)),
+                                       _mm_set1_epi32(34784));
+            __m128i pb = _mm_add_epi32(_mm_madd_epi16(uu, u_b), _mm_set1_epi32(-70688));
+            pr = SSE2_DUP16(_mm_srai_epi32(pr, 8));
+            pg = SSE2_DUP16(_mm_srai_epi32(pg, 8));
+            pb = SSE2_DUP16(_mm_srai_epi32(pb, 8));
+
+            //saturation gives the same as CLAMP()
+            __m128i bg = _mm_packus_epi16(_mm_add_epi16(yy, pb), _mm_add_epi16(yy, pg));
+            __m128i ra = _mm_packus_epi16(_mm_add_epi16(yy, pr), alpha);
+            bg = _mm_unpacklo_epi8(bg, _mm_srli_si128(bg, 8));
+            ra = _mm_unpacklo_epi8(ra, _mm_srli_si128(ra, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb32 + n * 4),
+                             _mm_unpacklo_epi16(bg, ra));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb32 + n * 4 + 16),
+                             _mm_unpackhi_epi16(bg, ra));
+        }
+        return n;
+    }
+
+    //B, G and R of 8 pixels as 16-bit lanes
+    TARGET_SSE2
+    inline void SSE2_SplitRGB32(__m128i p0, __m128i p1, __m128i& b, __m128i& g, __m128i& r)
+    {
+        const __m128i mask = _mm_set1_epi32(0xff);
+        b = _mm_packs_epi32(_mm_and_si128(p0, mask), _mm_and_si128(p1, mask));
+        g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask),
+                            _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+        r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask),
+                            _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+    }
+
+    TARGET_SSE2
+    int RGB32RowToY_SSE2(const uint8_t* rgb32, uint8_t* y, int width)
+    {
+        int n = 0;
+        for(;n + 8 <= width;n += 8)
+        {
+            __m128i b, g, r;
+            SSE2_SplitRGB32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb32 + n * 4)),
+                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb32 + n * 4 + 16)),
+                            b, g, r);
+            __m128i yy = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(30)),
+                                                     _mm_mullo_epi16(g, _mm_set1_epi16(59))),
+                                       _mm_mullo_epi16(r, _mm_set1_epi16(11)));
+            yy = SSE2_DIV100(yy);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(y + n), _mm_packus_epi16(yy, yy));
+        }
+        return n;
+    }
+
+    TARGET_SSE2
+    int RGB32RowToUV_SSE2(const uint8_t* rgb32, uint8_t* u, uint8_t* v, int width)
+    {
+        int n = 0;
+        for(;n + 16 <= width;n += 16)
+        {
+            const __m128i* src = reinterpret_cast<const __m128i*>(rgb32 + n * 4);
+            //odd pixels 1, 3, 5, ... 15
+            __m128i p0 = _mm_unpacklo_epi64(_mm_shuffle_epi32(_mm_loadu_si128(src), _MM_SHUFFLE(3, 1, 3, 1)),
+                                            _mm_shuffle_epi32(_mm_loadu_si128(src + 1), _MM_SHUFFLE(3, 1, 3, 1)));
+            __m128i p1 = _mm_unpacklo_epi64(_mm_shuffle_epi32(_mm_loadu_si128(src + 2), _MM_SHUFFLE(3, 1, 3, 1)),
+                                            _mm_shuffle_epi32(_mm_loadu_si128(src + 3), _MM_SHUFFLE(3, 1, 3, 1)));
+            __m128i b, g, r;
+            SSE2_SplitRGB32(p0, p1, b, g, r);
+
+            //16-bit wrap-around is fine since the results are 50..25550
+            __m128i uu = _mm_sub_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(50)),
+                                       _mm_add_epi16(_mm_mullo_epi16(g, _mm_set1_epi16(42)),
+                                                     _mm_mullo_epi16(r, _mm_set1_epi16(8))));
+            __m128i vv = _mm_sub_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(50)),
+                                       _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(17)),
+                                                     _mm_mullo_epi16(g, _mm_set1_epi16(33))));
+            uu = SSE2_DIV100(_mm_add_epi16(uu, _mm_set1_epi16(12800)));
+            vv = SSE2_DIV100(_mm_add_epi16(vv, _mm_set1_epi16(12800)));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(u + n / 2), _mm_packus_epi16(uu, uu));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(v + n / 2), _mm_packus_epi16(vv, vv));
+        }
+        return n;
+    }
+
+    TARGET_SSE2
+    int YUY2RowToY_SSE2(const uint8_t* yuy2, uint8_t* y, int width)
+    {
+        const __m128i mask = _mm_set1_epi16(0xff);
+        int n = 0;
+        for(;n + 16 <= width;n += 16)
+        {
+            const __m128i* src = reinterpret_cast<const __m128i*>(yuy2 + n * 2);
+            __m128i yy = _mm_packus_epi16(_mm_and_si128(_mm_loadu_si128(src), mask),
+                                          _mm_and_si128(_mm_loadu_si128(src + 1), mask));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(y + n), yy);
+        }
+        return n;
+    }
+
+    //interleaved U and V of 8 chroma pixels into their planes
+    TARGET_SSE2
+    inline void SSE2_StoreUV(__m128i uv, uint8_t* u, uint8_t* v)
+    {
+        const __m128i mask = _mm_set1_epi16(0xff);
+        __m128i uu = _mm_and_si128(uv, mask);
+        __m128i vv = _mm_srli_epi16(uv, 8);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(u), _mm_packus_epi16(uu, uu));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(v), _mm_packus_epi16(vv, vv));
+    }
+
+    TARGET_SSE2
+    int YUY2RowsToUV_SSE2(const uint8_t* yuy2_0, const uint8_t* yuy2_1,
+                          uint8_t* u, uint8_t* v, int width)
+    {
+        int n = 0;
+        for(;n + 16 <= width;n += 16)
+        {
+            const __m128i* src0 = reinterpret_cast<const __m128i*>(yuy2_0 + n * 2);
+            const __m128i* src1 = reinterpret_cast<const __m128i*>(yuy2_1 + n * 2);
+            //avg_epu8() rounds up like the scalar version
+            __m128i a = _mm_avg_epu8(_mm_loadu_si128(src0), _mm_loadu_si128(src1));
+            __m128i b = _mm_avg_epu8(_mm_loadu_si128(src0 + 1), _mm_loadu_si128(src1 + 1));
+            SSE2_StoreUV(_mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)),
+                         u + n / 2, v + n / 2);
+        }
+        return n;
+    }
+
+    TARGET_SSE2
+    int SplitUVRow_SSE2(const uint8_t* uv, uint8_t* u, uint8_t* v, int uv_width)
+    {
+        int n = 0;
+        for(;n + 8 <= uv_width;n += 8)
+            SSE2_StoreUV(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + n * 2)),
+                         u + n, v + n);
+        return n;
+    }
+
+    TARGET_AVX2
+    int I420RowToRGB32_AVX2(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                            uint8_t* rgb32, int width)
+    {
+        const __m256i low16 = _mm256_set1_epi32(0xffff);
+        const __m256i alpha = _mm256_set1_epi16(255);
+        //within each 128-bit lane: 8 bytes of B (or R) followed by
+        //8 bytes of G (or alpha) into pairs
+        const __m256i interleave = _mm256_setr_epi8(0, 8, 1, 9, 2, 10, 3, 11,
+                                                    4, 12, 5, 13, 6, 14, 7, 15,
+                                                    0, 8, 1, 9, 2, 10, 3, 11,
+                                                    4, 12, 5, 13, 6, 14, 7, 15);
+        int n = 0;
+        for(;n + 16 <= width;n += 16)
+        {
+            __m256i yy = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + n)));
+            yy = _mm256_mulhi_epu16(_mm256_slli_epi16(yy, 8), _mm256_set1_epi16(298));
+
+            __m256i uu = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + n / 2)));
+            __m256i vv = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + n / 2)));
+
+            __m256i pr = _mm256_add_epi32(_mm256_mullo_epi32(vv, _mm256_set1_epi32(409)),
+                                          _mm256_set1_epi32(-56992));
+            __m256i pg = _mm256_sub_epi32(_mm256_set1_epi32(34784),
+                                          _mm256_add_epi32(_mm256_mullo_epi32(uu, _mm256_set1_epi32(100)),
+                                                           _mm256_mullo_epi32(vv, _mm256_set1_epi32(208))));
+            __m256i pb = _mm256_add_epi32(_mm256_mullo_epi32(uu, _mm256_set1_epi32(516)),
+                                          _mm256_set1_epi32(-70688));
+            pr = _mm256_srai_epi32(pr, 8);
+            pg = _mm256_srai_epi32(pg, 8);
+            pb = _mm256_srai_epi32(pb, 8);
+            pr = _mm256_or_si256(_mm256_and_si256(pr, low16), _mm256_slli_epi32(pr, 16));
+            pg = _mm256_or_si256(_mm256_and_si256(pg, low16), _mm256_slli_epi32(pg, 16));
+            pb = _mm256_or_si256(_mm256_and_si256(pb, low16), _mm256_slli_epi32(pb, 16));
+
+            __m256i bg = _mm256_packus_epi16(_mm256_add_epi16(yy, pb), _mm256_add_epi16(yy, pg));
+            __m256i ra = _mm256_packus_epi16(_mm256_add_epi16(yy, pr), alpha);
+            bg = _mm256_shuffle_epi8(bg, interleave);
+            ra = _mm256_shuffle_epi8(ra, interleave);
+            //pixels 0-3, 8-11 and 4-7, 12-15
+            __m256i lo = _mm256_unpacklo_epi16(bg, ra);
+            __m256i hi = _mm256_unpackhi_epi16(bg, ra);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgb32 + n * 4),
+                                _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgb32 + n * 4 + 32),
+                                _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+        return n;
+    }
+
+    bool HasSSE2()
+    {
+#if defined(__x86_64__) || defined(_M_X64)
+        return true;
+#elif defined(_MSC_VER)
+        int regs[4];
+        __cpuid(regs, 1);
+        return (regs[3] & (1 << 26)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+#endif
+    }
+
+    bool HasAVX2()
+    {
+#if defined(_MSC_VER)
+        int regs[4];
+        __cpuid(regs, 0);
+        if(regs[0] < 7)
+            return false;
+        __cpuid(regs, 1);
+        //OS must save YMM registers
+        const int osxsave_avx = (1 << 27) | (1 << 28);
+        if((regs[2] & osxsave_avx) != osxsave_avx || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(regs, 7, 0);
+        return (regs[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+#endif /* VIDEOCONVERT_X86 */
+
+#if defined(VIDEOCONVERT_NEON)
+
+    //(x * 41944) >> 22 like SSE2_DIV100()
+    inline uint8x8_t NEON_Div100(uint16x8_t x)
+    {
+        uint32x4_t lo = vshrq_n_u32(vmull_n_u16(vget_low_u16(x), 41944), 16);
+        uint32x4_t hi = vshrq_n_u32(vmull_n_u16(vget_high_u16(x), 41944), 16);
+        return vmovn_u16(vshrq_n_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)), 6));
+    }
+
+    inline int16x8_t NEON_Dup16(int32x4_t x)
+    {
+        int16x4_t n = vmovn_s32(x);
+        int16x4x2_t z = vzip_s16(n, n);
+        return vcombine_s16(z.val[0], z.val[1]);
+    }
+
+    int I420RowToRGB32_NEON(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                            uint8_t* rgb32, int width)
+    {
+        int n = 0;
+        for(;n + 8 <= width;n += 8)
+        {
+            uint16x8_t y16 = vmovl_u8(vld1_u8(y + n));
+            uint32x4_t ylo = vmull_n_u16(vget_low_u16(y16), 298);
+            uint32x4_t yhi = vmull_n_u16(vget_high_u16(y16), 298);
+            int16x8_t yy = vreinterpretq_s16_u16(vcombine_u16(vshrn_n_u32(ylo, 8),
+                                                              vshrn_n_u32(yhi, 8)));
+            uint32_t u4, v4;
+            memcpy(&u4, u + n / 2, sizeof(u4));
+            memcpy(&v4, v + n / 2, sizeof(v4));
+            int32x4_t uu = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8(u4)))));
+            int32x4_t vv = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8(v4)))));
+
+            int32x4_t pr = vshrq_n_s32(vaddq_s32(vmulq_n_s32(vv, 409), vdupq_n_s32(-56992)), 8);
+            int32x4_t pg = vshrq_n_s32(vaddq_s32(vmlaq_n_s32(vmulq_n_s32(uu, -100), vv, -208),
+                                                 vdupq_n_s32(34784)), 8);
+            int32x4_t pb = vshrq_n_s32(vaddq_s32(vmulq_n_s32(uu, 516), vdupq_n_s32(-70688)), 8);
+
+            uint8x8x4_t bgra;
+            bgra.val[0] = vqmovun_s16(vaddq_s16(yy, NEON_Dup16(pb)));
+            bgra.val[1] = vqmovun_s16(vaddq_s16(yy, NEON_Dup16(pg)));
+            bgra.val[2] = vqmovun_s16(vaddq_s16(yy, NEON_Dup16(pr)));
+            bgra.val[3] = vdup_n_u8(255);
+            vst4_u8(rgb32 + n * 4, bgra);
+        }
+        return n;
+    }
+
+    int RGB32RowToY_NEON(const uint8_t* rgb32, uint8_t* y, int width)
+    {
+        int n = 0;
+        for(;n + 8 <= width;n += 8)
+        {
+            uint8x8x4_t bgra = vld4_u8(rgb32 + n * 4);
+            uint16x8_t yy = vmull_u8(bgra.val[0], vdup_n_u8(30));
+            yy = vmlal_u8(yy, bgra.val[1], vdup_n_u8(59));
+            yy = vmlal_u8(yy, bgra.val[2], vdup_n_u8(11));
+            vst1_u8(y + n, NEON_Div100(yy));
+        }
+        return n;
+    }
+
+    int RGB32RowToUV_NEON(const uint8_t* rgb32, uint8_t* u, uint8_t* v, int width)
+    {
+        int n = 0;
+        for(;n + 16 <= width;n += 16)
+        {
+            uint8x16x4_t bgra = vld4q_u8(rgb32 + n * 4);
+            //odd pixels are the high bytes of each 16-bit lane
+            uint16x8_t b = vshrq_n_u16(vreinterpretq_u16_u8(bgra.val[0]), 8);
+            uint16x8_t g = vshrq_n_u16(vreinterpretq_u16_u8(bgra.val[1]), 8);
+            uint16x8_t r = vshrq_n_u16(vreinterpretq_u16_u8(bgra.val[2]), 8);
+
+            //16-bit wrap-around is fine since the results are 50..25550
+            uint16x8_t uu = vdupq_n_u16(12800);
+            uu = vmlaq_n_u16(uu, b, 50);
+            uu = vmlsq_n_u16(uu, g, 42);
+            uu = vmlsq_n_u16(uu, r, 8);
+            uint16x8_t vv = vdupq_n_u16(12800);
+            vv = vmlaq_n_u16(vv, r, 50);
+            vv = vmlsq_n_u16(vv, g, 33);
+            vv = vmlsq_n_u16(vv, b, 17);
+            vst1_u8(u + n / 2, NEON_Div100(uu));
+            vst1_u8(v + n / 2, NEON_Div100(vv));
+        }
+        return n;
+    }
+
+    int YUY2RowToY_NEON(const uint8_t* yuy2, uint8_t* y, int width)
+    {
+        int n = 0;
+        for(;n + 16 <= width;n += 16)
+            vst1q_u8(y + n, vld2q_u8(yuy2 + n * 2).val[0]);
+        return n;
+    }
+
+    int YUY2RowsToUV_NEON(const uint8_t* yuy2_0, const uint8_t* yuy2_1,
+                          uint8_t* u, uint8_t* v, int width)
+    {
+        int n = 0;
+        for(;n + 16 <= width;n += 16)
+        {
+            uint8x8x4_t a = vld4_u8(yuy2_0 + n * 2);
+            uint8x8x4_t b = vld4_u8(yuy2_1 + n * 2);
+            vst1_u8(u + n / 2, vrhadd_u8(a.val[1], b.val[1]));
+            vst1_u8(v + n / 2, vrhadd_u8(a.val[3], b.val[3]));
+        }
+        return n;
+    }
+
+    int SplitUVRow_NEON(const uint8_t* uv, uint8_t* u, uint8_t* v, int uv_width)
+    {
+        int n = 0;
+        for(;n + 16 <= uv_width;n += 16)
+        {
+            uint8x16x2_t s = vld2q_u8(uv + n * 2);
+            vst1q_u8(u + n, s.val[0]);
+            vst1q_u8(v + n, s.val[1]);
+        }
+        return n;
+    }
+
+#endif /* VIDEOCONVERT_NEON */
+
+    struct ConvertFuncs
+    {
+        VideoConvertImpl impl;
+        int (*i420_to_rgb32)(const uint8_t*, const uint8_t*, const uint8_t*, uint8_t*, int);
+        int (*rgb32_to_y)(const uint8_t*, uint8_t*, int);
+        int (*rgb32_to_uv)(const uint8_t*, uint8_t*, uint8_t*, int);
+        int (*yuy2_to_y)(const uint8_t*, uint8_t*, int);
+        int (*yuy2_to_uv)(const uint8_t*, const uint8_t*, uint8_t*, uint8_t*, int);
+        int (*split_uv)(const uint8_t*, uint8_t*, uint8_t*, int);
+    };
+
+    const ConvertFuncs scalar_funcs = { VIDEOCONVERT_SCALAR, NULL, NULL, NULL, NULL, NULL, NULL };
+#if defined(VIDEOCONVERT_X86)
+    const ConvertFuncs sse2_funcs = { VIDEOCONVERT_SSE2, I420RowToRGB32_SSE2,
+                                      RGB32RowToY_SSE2, RGB32RowToUV_SSE2,
+                                      YUY2RowToY_SSE2, YUY2RowsToUV_SSE2,
+                                      SplitUVRow_SSE2 };
+    //only I420 to RGB32 benefits from the wider registers
+    const ConvertFuncs avx2_funcs = { VIDEOCONVERT_AVX2, I420RowToRGB32_AVX2,
+                                      RGB32RowToY_SSE2, RGB32RowToUV_SSE2,
+                                      YUY2RowToY_SSE2, YUY2RowsToUV_SSE2,
+                                      SplitUVRow_SSE2 };
+#endif
+#if defined(VIDEOCONVERT_NEON)
+    const ConvertFuncs neon_funcs = { VIDEOCONVERT_NEON, I420RowToRGB32_NEON,
+                                      RGB32RowToY_NEON, RGB32RowToUV_NEON,
+                                      YUY2RowToY_NEON, YUY2RowsToUV_NEON,
+                                      SplitUVRow_NEON };
+#endif
+
+    const ConvertFuncs* FindFuncs(VideoConvertImpl impl)
+    {
+        switch(impl)
+        {
+        case VIDEOCONVERT_AUTO :
+#if defined(VIDEOCONVERT_X86)
+            if(HasAVX2())
+                return &avx2_funcs;
+            if(HasSSE2())
+                return &sse2_funcs;
+#endif
+#if defined(VIDEOCONVERT_NEON)
+            return &neon_funcs;
+#endif
+            return &scalar_funcs;
+        case VIDEOCONVERT_SCALAR :
+            return &scalar_funcs;
+#if defined(VIDEOCONVERT_X86)
+        case VIDEOCONVERT_SSE2 :
+            return HasSSE2()? &sse2_funcs : NULL;
+        case VIDEOCONVERT_AVX2 :
+            return HasAVX2()? &avx2_funcs : NULL;
+#endif
+#if defined(VIDEOCONVERT_NEON)
+        case VIDEOCONVERT_NEON :
+            return &neon_funcs;
+#endif
+        default :
+            return NULL;
+        }
+    }
+
+    std::atomic<const ConvertFuncs*> current_funcs(NULL);
+
+    const ConvertFuncs& Funcs()
+    {
+        const ConvertFuncs* funcs = current_funcs.load(std::memory_order_acquire);
+        if(!funcs)
+        {
+            funcs = FindFuncs(VIDEOCONVERT_AUTO);
+            current_funcs.store(funcs, std::memory_order_release);
+        }
+        return *funcs;
+    }
+
+    void I420Planes(const char* buf, int width, int height,
+                    const uint8_t*& y, const uint8_t*& u, const uint8_t*& v,
+                    int& y_stride, int& uv_stride)
+    {
+        y_stride = width;
+        uv_stride = (width + 1) / 2;
+        y = reinterpret_cast<const uint8_t*>(buf);
+        u = y + width * height;
+        v = u + uv_stride * ((height + 1) / 2);
+    }
+
+    void I420Planes(char* buf, int width, int height,
+                    uint8_t*& y, uint8_t*& u, uint8_t*& v,
+                    int& y_stride, int& uv_stride)
+    {
+        const uint8_t *cy, *cu, *cv;
+        I420Planes(buf, width, height, cy, cu, cv, y_stride, uv_stride);
+        y = const_cast<uint8_t*>(cy);
+        u = const_cast<uint8_t*>(cu);
+        v = const_cast<uint8_t*>(cv);
+    }
+
+    //same result as ScalePlaneDown() for exactly half the size
+    void ScalePlaneHalf(const uint8_t* src, int src_stride,
+                        uint8_t* dst, int dst_stride, int dst_width, int dst_height)
+    {
+        for(int dy=0;dy<dst_height;dy++)
+        {
+            const uint8_t* line0 = src + dy * 2 * src_stride;
+            const uint8_t* line1 = line0 + src_stride;
+            uint8_t* out = dst + dy * dst_stride;
+            for(int dx=0;dx<dst_width;dx++)
+            {
+                out[dx] = uint8_t((line0[dx * 2] + line0[dx * 2 + 1] +
+                                   line1[dx * 2] + line1[dx * 2 + 1] + 2) >> 2);
+            }
+        }
+    }
+
+    void ScalePlaneDown(const uint8_t* src, int src_stride, int src_width, int src_height,
+                        uint8_t* dst, int dst_stride, int dst_width, int dst_height)
+    {
+        if(src_width == dst_width * 2 && src_height == dst_height * 2)
+        {
+            ScalePlaneHalf(src, src_stride, dst, dst_stride, dst_width, dst_height);
+            return;
+        }
+
+        std::vector<uint32_t> sums(src_width);
+        std::vector<int> x_start(dst_width + 1);
+        for(int dx=0;dx<=dst_width;dx++)
+            x_start[dx] = dx * src_width / dst_width;
+
+        for(int dy=0;dy<dst_height;dy++)
+        {
+            int y0 = dy * src_height / dst_height;
+            int y1 = std::max(y0 + 1, (dy + 1) * src_height / dst_height);
+            std::fill(sums.begin(), sums.end(), 0);
+            for(int sy=y0;sy<y1;sy++)
+            {
+                const uint8_t* line = src + sy * src_stride;
+                for(int sx=0;sx<src_width;sx++)
+                    sums[sx] += line[sx];
+            }
+
+            uint8_t* out = dst + dy * dst_stride;
+            for(int dx=0;dx<dst_width;dx++)
+            {
+                int x0 = x_start[dx];
+                int x1 = std::max(x0 + 1, x_start[dx + 1]);
+                uint32_t sum = 0;
+                for(int sx=x0;sx<x1;sx++)
+                    sum += sums[sx];
+                uint32_t count = uint32_t((x1 - x0) * (y1 - y0));
+                out[dx] = uint8_t((sum + count / 2) / count);
+            }
+        }
+    }
+
+    //source position in 16.16 fixed point of pixel centers
+    inline int BilinearPos(int dst, int src_size, int dst_size)
+    {
+        int64_t pos = ((2 * int64_t(dst) + 1) * src_size * 65536) / (2 * dst_size) - 32768;
+        return int(std::max<int64_t>(pos, 0));
+    }
+
+    void ScalePlaneBilinear(const uint8_t* src, int src_stride, int src_width, int src_height,
+                            uint8_t* dst, int dst_stride, int dst_width, int dst_height)
+    {
+        for(int dy=0;dy<dst_height;dy++)
+        {
+            int sy = BilinearPos(dy, src_height, dst_height);
+            int y0 = std::min(sy >> 16, src_height - 1);
+            int y1 = std::min(y0 + 1, src_height - 1);
+            int fy = (sy >> 8) & 0xff;
+            const uint8_t* line0 = src + y0 * src_stride;
+            const uint8_t* line1 = src + y1 * src_stride;
+            uint8_t* out = dst + dy * dst_stride;
+            for(int dx=0;dx<dst_width;dx++)
+            {
+                int sx = BilinearPos(dx, src_width, dst_width);
+                int x0 = std::min(sx >> 16, src_width - 1);
+                int x1 = std::min(x0 + 1, src_width - 1);
+                int fx = (sx >> 8) & 0xff;
+                int top = line0[x0] * (256 - fx) + line0[x1] * fx;
+                int bottom = line1[x0] * (256 - fx) + line1[x1] * fx;
+                out[dx] = uint8_t((top * (256 - fy) + bottom * fy + 32768) >> 16);
+            }
+        }
+    }
+
+    void ScalePlane(const uint8_t* src, int src_stride, int src_width, int src_height,
+                    uint8_t* dst, int dst_stride, int dst_width, int dst_height)
+    {
+        if(src_width == dst_width && src_height == dst_height)
+        {
+            for(int i=0;i<dst_height;i++)
+                memcpy(dst + i * dst_stride, src + i * src_stride, dst_width);
+        }
+        else if(dst_width <= src_width && dst_height <= src_height)
+            ScalePlaneDown(src, src_stride, src_width, src_height,
+                           dst, dst_stride, dst_width, dst_height);
+        else
+            ScalePlaneBilinear(src, src_stride, src_width, src_height,
+                               dst, dst_stride, dst_width, dst_height);
+    }
+}
+
+bool SetVideoConvertImpl(VideoConvertImpl impl)
+{
+    const ConvertFuncs* funcs = FindFuncs(impl);
+    if(!funcs)
+        return false;
+    current_funcs.store(funcs, std::memory_order_release);
+    return true;
+}
+
+VideoConvertImpl GetVideoConvertImpl()
+{
+    return Funcs().impl;
+}
+
+const char* GetVideoConvertImplName(VideoConvertImpl impl)
+{
+    switch(impl)
+    {
+    case VIDEOCONVERT_AUTO :   return "auto";
+    case VIDEOCONVERT_SCALAR : return "scalar";
+    case VIDEOCONVERT_SSE2 :   return "sse2";
+    case VIDEOCONVERT_AVX2 :   return "avx2";
+    case VIDEOCONVERT_NEON :   return "neon";
+    }
+    return "unknown";
+}
+
+void I420ToRGB32(const uint8_t* y, int y_stride,
+                 const uint8_t* u, int u_stride,
+                 const uint8_t* v, int v_stride,
+                 int width, int height,
+                 uint8_t* rgb32, int rgb32_stride)
+{
+    const ConvertFuncs& funcs = Funcs();
+    for(int i=0;i<height;i++)
+    {
+        const uint8_t* y_line = y + i * y_stride;
+        const uint8_t* u_line = u + (i / 2) * u_stride;
+        const uint8_t* v_line = v + (i / 2) * v_stride;
+        uint8_t* out = rgb32 + i * rgb32_stride;
+
+        int n = funcs.i420_to_rgb32? funcs.i420_to_rgb32(y_line, u_line, v_line, out, width) : 0;
+        I420RowToRGB32_C(y_line + n, u_line + n / 2, v_line + n / 2, out + n * 4, width - n);
+    }
+}
+
+void I420ToRGB32(const char* i420, int width, int height, char* rgb32)
+{
+    const uint8_t *y, *u, *v;
+    int y_stride, uv_stride;
+    I420Planes(i420, width, height, y, u, v, y_stride, uv_stride);
+    I420ToRGB32(y, y_stride, u, uv_stride, v, uv_stride, width, height,
+                reinterpret_cast<uint8_t*>(rgb32), width * 4);
+}
+
+void RGB32ToI420(const uint8_t* rgb32, int rgb32_stride,
+                 int width, int height,
+                 uint8_t* y, int y_stride,
+                 uint8_t* u, int u_stride,
+                 uint8_t* v, int v_stride)
+{
+    const ConvertFuncs& funcs = Funcs();
+    for(int i=0;i<height;i++)
+    {
+        const uint8_t* line = rgb32 + i * rgb32_stride;
+        uint8_t* y_line = y + i * y_stride;
+        int n = funcs.rgb32_to_y? funcs.rgb32_to_y(line, y_line, width) : 0;
+        RGB32RowToY_C(line + n * 4, y_line + n, width - n);
+
+        //chroma from the lower line of each pair
+        if((i & 1) || i == height - 1)
+        {
+            uint8_t* u_line = u + (i / 2) * u_stride;
+            uint8_t* v_line = v + (i / 2) * v_stride;
+            n = funcs.rgb32_to_uv? funcs.rgb32_to_uv(line, u_line, v_line, width) : 0;
+            RGB32RowToUV_C(line + n * 4, u_line + n / 2, v_line + n / 2, width - n);
+        }
+    }
+}
+
+void RGB32ToI420(const char* rgb32, int width, int height,
+                 bool bottom_up, char* i420)
+{
+    uint8_t *y, *u, *v;
+    int y_stride, uv_stride;
+    I420Planes(i420, width, height, y, u, v, y_stride, uv_stride);
+
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(rgb32);
+    int src_stride = width * 4;
+    if(bottom_up)
+    {
+        src += (height - 1) * src_stride;
+        src_stride = -src_stride;
+    }
+    RGB32ToI420(src, src_stride, width, height,
+                y, y_stride, u, uv_stride, v, uv_stride);
+}
+
+void YUY2ToI420(const uint8_t* yuy2, int yuy2_stride,
+                int width, int height,
+                uint8_t* y, int y_stride,
+                uint8_t* u, int u_stride,
+                uint8_t* v, int v_stride)
+{
+    const ConvertFuncs& funcs = Funcs();
+    for(int i=0;i<height;i++)
+    {
+        const uint8_t* line = yuy2 + i * yuy2_stride;
+        uint8_t* y_line = y + i * y_stride;
+        int n = funcs.yuy2_to_y? funcs.yuy2_to_y(line, y_line, width) : 0;
+        YUY2RowToY_C(line + n * 2, y_line + n, width - n);
+
+        if((i & 1) || i == height - 1)
+        {
+            const uint8_t* upper = (i & 1)? line - yuy2_stride : line;
+            uint8_t* u_line = u + (i / 2) * u_stride;
+            uint8_t* v_line = v + (i / 2) * v_stride;
+            n = funcs.yuy2_to_uv? funcs.yuy2_to_uv(upper, line, u_line, v_line, width) : 0;
+            YUY2RowsToUV_C(upper + n * 2, line + n * 2, u_line + n / 2, v_line + n / 2, width - n);
+        }
+    }
+}
+
+void YUY2ToI420(const char* yuy2, int width, int height, char* i420)
+{
+    uint8_t *y, *u, *v;
+    int y_stride, uv_stride;
+    I420Planes(i420, width, height, y, u, v, y_stride, uv_stride);
+    YUY2ToI420(reinterpret_cast<const uint8_t*>(yuy2), ((width + 1) / 2) * 4,
+               width, height, y, y_stride, u, uv_stride, v, uv_stride);
+}
+
+void NV12ToI420(const uint8_t* y_src, int y_src_stride,
+                const uint8_t* uv, int uv_stride,
+                int width, int height,
+                uint8_t* y, int y_stride,
+                uint8_t* u, int u_stride,
+                uint8_t* v, int v_stride)
+{
+    const ConvertFuncs& funcs = Funcs();
+    for(int i=0;i<height;i++)
+        memcpy(y + i * y_stride, y_src + i * y_src_stride, width);
+
+    int uv_width = (width + 1) / 2;
+    for(int i=0;i<(height + 1) / 2;i++)
+    {
+        const uint8_t* line = uv + i * uv_stride;
+        uint8_t* u_line = u + i * u_stride;
+        uint8_t* v_line = v + i * v_stride;
+        int n = funcs.split_uv? funcs.split_uv(line, u_line, v_line, uv_width) : 0;
+        SplitUVRow_C(line + n * 2, u_line + n, v_line + n, uv_width - n);
+    }
+}
+
+void I420Scale(const uint8_t* src_y, int src_y_stride,
+               const uint8_t* src_u, int src_u_stride,
+               const uint8_t* src_v, int src_v_stride,
+               int src_width, int src_height,
+               uint8_t* dst_y, int dst_y_stride,
+               uint8_t* dst_u, int dst_u_stride,
+               uint8_t* dst_v, int dst_v_stride,
+               int dst_width, int dst_height)
+{
+    assert(src_width > 0 && src_height > 0);
+    assert(dst_width > 0 && dst_height > 0);
+
+    ScalePlane(src_y, src_y_stride, src_width, src_height,
+               dst_y, dst_y_stride, dst_width, dst_height);
+
+    int src_uv_width = (src_width + 1) / 2, src_uv_height = (src_height + 1) / 2;
+    int dst_uv_width = (dst_width + 1) / 2, dst_uv_height = (dst_height + 1) / 2;
+    ScalePlane(src_u, src_u_stride, src_uv_width, src_uv_height,
+               dst_u, dst_u_stride, dst_uv_width, dst_uv_height);
+    ScalePlane(src_v, src_v_stride, src_uv_width, src_uv_height,
+               dst_v, dst_v_stride, dst_uv_width, dst_uv_height);
+}
+
+void I420Scale(const char* src, int src_width, int src_height,
+               char* dst, int dst_width, int dst_height)
+{
+    const uint8_t *src_y, *src_u, *src_v;
+    int src_y_stride, src_uv_stride;
+    I420Planes(src, src_width, src_height, src_y, src_u, src_v,
+               src_y_stride, src_uv_stride);
+
+    uint8_t *dst_y, *dst_u, *dst_v;
+    int dst_y_stride, dst_uv_stride;
+    I420Planes(dst, dst_width, dst_height, dst_y, dst_u, dst_v,
+               dst_y_stride, dst_uv_stride);
+
+    I420Scale(src_y, src_y_stride, src_u, src_uv_stride, src_v, src_uv_stride,
+              src_width, src_height,
+              dst_y, dst_y_stride, dst_u, dst_uv_stride, dst_v, dst_uv_stride,
+              dst_width, dst_height);
+}
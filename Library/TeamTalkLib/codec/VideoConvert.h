@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+#ifndef VIDEOCONVERT_H
+#define VIDEOCONVERT_H
+
+#include <stdint.h>
+
+/* Color space conversion and scaling of video frames.
+ *
+ * Every conversion has a scalar implementation and SIMD versions
+ * (SSE2 and AVX2 on x86, NEON on ARM) which give exactly the same
+ * output. The fastest implementation supported by the CPU is picked
+ * the first time a conversion is made.
+ *
+ * Planes are passed with their stride in bytes. A negative stride
+ * for the RGB32 source reads the image bottom-up. Odd widths and
+ * heights round chroma dimensions up like I420_BYTES(). */
+
+enum VideoConvertImpl
+{
+    VIDEOCONVERT_AUTO   = 0,
+    VIDEOCONVERT_SCALAR = 1,
+    VIDEOCONVERT_SSE2   = 2,
+    VIDEOCONVERT_AVX2   = 3,
+    VIDEOCONVERT_NEON   = 4,
+};
+
+//for benchmarks. Returns false if the CPU doesn't support 'impl'
+bool SetVideoConvertImpl(VideoConvertImpl impl);
+VideoConvertImpl GetVideoConvertImpl();
+const char* GetVideoConvertImplName(VideoConvertImpl impl);
+
+//output is top-down RGB32 with alpha 255
+void I420ToRGB32(const uint8_t* y, int y_stride,
+                 const uint8_t* u, int u_stride,
+                 const uint8_t* v, int v_stride,
+                 int width, int height,
+                 uint8_t* rgb32, int rgb32_stride);
+
+//'i420' is I420_BYTES(width, height). 'rgb32' is top-down RGB32_BYTES(width, height)
+void I420ToRGB32(const char* i420, int width, int height, char* rgb32);
+
+/* Chroma is taken from the bottom-right pixel of each 2x2 block and
+ * uses the same integer coefficients as the original VP8 encoder
+ * input conversion, so encoded output is unchanged. */
+void RGB32ToI420(const uint8_t* rgb32, int rgb32_stride,
+                 int width, int height,
+                 uint8_t* y, int y_stride,
+                 uint8_t* u, int u_stride,
+                 uint8_t* v, int v_stride);
+
+//'i420' is I420_BYTES(width, height)
+void RGB32ToI420(const char* rgb32, int width, int height,
+                 bool bottom_up, char* i420);
+
+//chroma of two lines is averaged
+void YUY2ToI420(const uint8_t* yuy2, int yuy2_stride,
+                int width, int height,
+                uint8_t* y, int y_stride,
+                uint8_t* u, int u_stride,
+                uint8_t* v, int v_stride);
+
+//'i420' is I420_BYTES(width, height)
+void YUY2ToI420(const char* yuy2, int width, int height, char* i420);
+
+void NV12ToI420(const uint8_t* y_src, int y_src_stride,
+                const uint8_t* uv, int uv_stride,
+                int width, int height,
+                uint8_t* y, int y_stride,
+                uint8_t* u, int u_stride,
+                uint8_t* v, int v_stride);
+
+/* Area average when downscaling, bilinear when upscaling. Each
+ * plane is scaled separately. */
+void I420Scale(const uint8_t* src_y, int src_y_stride,
+               const uint8_t* src_u, int src_u_stride,
+               const uint8_t* src_v, int src_v_stride,
+               int src_width, int src_height,
+               uint8_t* dst_y, int dst_y_stride,
+               uint8_t* dst_u, int dst_u_stride,
+               uint8_t* dst_v, int dst_v_stride,
+               int dst_width, int dst_height);
+
+//'src' is I420_BYTES(src_width, src_height) and 'dst' I420_BYTES(dst_width, dst_height)
+void I420Scale(const char* src, int src_width, int src_height,
+               char* dst, int dst_width, int dst_height);
+
+#endif
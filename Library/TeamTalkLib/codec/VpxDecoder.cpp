@@ -24,11 +24,10 @@
 #include "VpxDecoder.h"
 #include <assert.h>
 #include <codec/MediaUtil.h>
+#include <codec/VideoConvert.h>
 #include "vpx/vp8dx.h"
 #define dec_interface vpx_codec_vp8_dx()
 
-void I420toRGB32(vpx_image_t* img, uint8_t* outbuf, int outlen);
-
 VpxDecoder::VpxDecoder()
 : m_codec()
 , m_cfg()
@@ -48,7 +47,13 @@ bool VpxDecoder::Open(int width, int height)
     if(m_codec.iface)
         return false;
     
-    m_cfg.threads = 0;
+    //VP8 decodes token partitions in parallel, see VpxEncoder::Open()
+    if(width * height >= 1280 * 720)
+        m_cfg.threads = 4;
+    else if(width * height >= 640 * 480)
+        m_cfg.threads = 2;
+    else
+        m_cfg.threads = 0;
     m_cfg.w = width;
     m_cfg.h = height;
     ret = vpx_codec_dec_init(&m_codec, dec_interface, &m_cfg, flags);
@@ -83,70 +88,15 @@ bool VpxDecoder::GetRGB32Image(char* outbuf, int buflen)
     assert(RGB32_BYTES(m_cfg.w, m_cfg.h) == buflen);
     if((img = vpx_codec_get_frame(&m_codec, &m_iter)))
     {
-        I420toRGB32(img, reinterpret_cast<uint8_t*>(outbuf), buflen);
+        assert(int(RGB32_BYTES(img->d_w, img->d_h)) <= buflen);
+        I420ToRGB32(img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y],
+                    img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U],
+                    img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V],
+                    img->d_w, img->d_h,
+                    reinterpret_cast<uint8_t*>(outbuf), img->d_w * 4);
     }
     else
         m_iter = NULL;
 
     return img != NULL;
 }
-
-inline uint8_t CLAMP(short v)    
-{
-    if (v > 255)
-        return 255;
-    else if (v < 0)
-        return 0;
-    return (uint8_t)v;
-}
-
-void I420toRGB32(vpx_image_t* img, uint8_t* outbuf, int outlen)
-{
-    int plane_size = img->d_w * img->d_h;
-    uint8_t * ptry = img->planes[VPX_PLANE_Y];
-    uint8_t * ptru = img->planes[VPX_PLANE_U];
-    uint8_t * ptrv = img->planes[VPX_PLANE_V];
-    uint8_t * ptro = outbuf;
-
-    for (unsigned int i = 0; i < img->d_h; i++) 
-    {
-        uint8_t* ptro2 = ptro;
-        for (unsigned int j = 0; j < img->d_w; j += 2) 
-        {
-            short pr, pg, pb, y;
-            short r, g, b;
-
-            pr = (-56992 + ptrv[j / 2] * 409) >> 8;
-            pg = (34784 - ptru[j / 2] * 100 - ptrv[j / 2] * 208) >> 8;
-            pb = (short)((-70688 + ptru[j / 2] * 516) >> 8);
-
-            y = 298*ptry[j] >> 8;
-            r = y + pr;
-            g = y + pg;
-            b = y + pb;
-
-            *ptro2++ = CLAMP(b);
-            *ptro2++ = CLAMP(g);
-            *ptro2++ = CLAMP(r);
-            assert(ptro2 < outbuf + outlen);
-            *ptro2++ = 255;
-            y = 298*ptry[j + 1] >> 8;
-            r = y + pr;
-            g = y + pg;
-            b = y + pb;
-
-            *ptro2++ = CLAMP(b);
-            *ptro2++ = CLAMP(g);
-            *ptro2++ = CLAMP(r);
-            assert(ptro2 < outbuf + outlen);
-            *ptro2++ = 255;
-        }
-        ptry += img->stride[VPX_PLANE_Y];
-        if (i & 1) 
-        {
-            ptru += img->stride[VPX_PLANE_U];
-            ptrv += img->stride[VPX_PLANE_V];
-        }
-        ptro += img->d_w * 4;
-    }
-}
@@ -24,20 +24,17 @@
 #include "VpxEncoder.h"
 #include <assert.h>
 #include <codec/MediaUtil.h>
+#include <codec/VideoConvert.h>
 #include <vpx/vp8cx.h>
 #define enc_interface vpx_codec_vp8_cx()
 
-void RGB32toYUV420P(const unsigned char * rgb,
-                    unsigned char * yuv,
-                    unsigned rgbIncrement,
-                    unsigned char flip,
-                    int srcFrameWidth, int srcFrameHeight);
-
 VpxEncoder::VpxEncoder()
 : m_codec()
 , m_cfg()
 , m_iter(NULL)
 , m_frame_index(0)
+, m_force_keyframe(false)
+, m_rgb32_img(NULL)
 {
 }
 
@@ -67,36 +64,119 @@ bool VpxEncoder::Open(int width, int height, int target_bitrate, int fps)
 
     ret = vpx_codec_enc_init(&m_codec, enc_interface, &m_cfg, 0);
     assert(ret == VPX_CODEC_OK);
-    return ret == VPX_CODEC_OK;
+    if(ret != VPX_CODEC_OK)
+        return false;
+
+    //token partitions let receivers decode large frames on several threads
+    int partitions = VP8_ONE_TOKENPARTITION;
+    if(width * height >= 1280 * 720)
+        partitions = VP8_FOUR_TOKENPARTITION;
+    else if(width * height >= 640 * 480)
+        partitions = VP8_TWO_TOKENPARTITION;
+    ret = vpx_codec_control(&m_codec, VP8E_SET_TOKEN_PARTITIONS, partitions);
+    assert(ret == VPX_CODEC_OK);
+
+    m_rgb32_img = vpx_img_alloc(NULL, VPX_IMG_FMT_YV12, m_cfg.g_w, m_cfg.g_h, 1);
+    assert(m_rgb32_img);
+    if(!m_rgb32_img)
+    {
+        Close();
+        return false;
+    }
+    return true;
 }
 
 void VpxEncoder::Close()
 {
     if(m_codec.iface)
         vpx_codec_destroy(&m_codec);
+    if(m_rgb32_img)
+        vpx_img_free(m_rgb32_img);
+    m_rgb32_img = NULL;
     memset(&m_codec, 0, sizeof(m_codec));
     m_iter = NULL;
     m_frame_index = 0;
+    m_force_keyframe = false;
+}
+
+bool VpxEncoder::SetBitrate(int target_bitrate)
+{
+    assert(m_codec.iface);
+    if(!m_codec.iface || target_bitrate <= 0)
+        return false;
+
+    if(m_cfg.rc_target_bitrate == unsigned(target_bitrate))
+        return true;
+
+    unsigned int prev_bitrate = m_cfg.rc_target_bitrate;
+    m_cfg.rc_target_bitrate = target_bitrate;
+    vpx_codec_err_t ret = vpx_codec_enc_config_set(&m_codec, &m_cfg);
+    assert(ret == VPX_CODEC_OK);
+    if(ret != VPX_CODEC_OK)
+    {
+        m_cfg.rc_target_bitrate = prev_bitrate;
+        return false;
+    }
+    return true;
 }
 
 vpx_codec_err_t VpxEncoder::EncodeRGB32(const char* imgbuf, int imglen, bool bottom_up_bmp,
-                                        unsigned long /* tm */, int enc_deadline)
+                                        unsigned long /* tm */, int enc_deadline,
+                                        int duration)
 {
     vpx_codec_err_t ret;
-    vpx_image_t* img;
+    vpx_image_t* img = m_rgb32_img;
 
     assert(m_codec.iface);
-    img = vpx_img_alloc(NULL, VPX_IMG_FMT_YV12, m_cfg.g_w, m_cfg.g_h, 1);
     assert(img);
     assert(imglen == RGB32_BYTES(m_cfg.g_w, m_cfg.g_h));
-    RGB32toYUV420P(reinterpret_cast<const unsigned char *>(imgbuf), 
-                   img->img_data, 4, bottom_up_bmp, m_cfg.g_w, m_cfg.g_h);
-
-    ret = vpx_codec_encode(&m_codec, img, m_frame_index++, 1 /*duration*/, 
-                           0, enc_deadline);
+    const uint8_t* rgb32 = reinterpret_cast<const uint8_t*>(imgbuf);
+    int rgb32_stride = m_cfg.g_w * 4;
+    if(bottom_up_bmp)
+    {
+        rgb32 += (m_cfg.g_h - 1) * rgb32_stride;
+        rgb32_stride = -rgb32_stride;
+    }
+    RGB32ToI420(rgb32, rgb32_stride, m_cfg.g_w, m_cfg.g_h,
+                img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y],
+                img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U],
+                img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V]);
+
+    vpx_enc_frame_flags_t flags = m_force_keyframe? VPX_EFLAG_FORCE_KF : 0;
+    ret = vpx_codec_encode(&m_codec, img, m_frame_index, duration,
+                           flags, enc_deadline);
     assert(ret == VPX_CODEC_OK);
-    vpx_img_free(img);
+    m_frame_index += duration;
+    m_force_keyframe = false;
+
+    return ret;
+}
+
+vpx_codec_err_t VpxEncoder::EncodeI420(const char* imgbuf, int imglen,
+                                       unsigned long /* tm */, int enc_deadline,
+                                       int duration)
+{
+    vpx_image_t img;
+
+    assert(m_codec.iface);
+    assert(imglen == I420_BYTES(m_cfg.g_w, m_cfg.g_h));
+
+    unsigned char* buf = reinterpret_cast<unsigned char*>(const_cast<char*>(imgbuf));
+    if(!vpx_img_wrap(&img, VPX_IMG_FMT_I420, m_cfg.g_w, m_cfg.g_h, 1, buf))
+        return VPX_CODEC_INVALID_PARAM;
+
+    //vpx_img_wrap() rounds chroma dimensions down for odd sizes
+    int uv_width = (m_cfg.g_w + 1) / 2, uv_height = (m_cfg.g_h + 1) / 2;
+    img.planes[VPX_PLANE_U] = buf + m_cfg.g_w * m_cfg.g_h;
+    img.planes[VPX_PLANE_V] = img.planes[VPX_PLANE_U] + uv_width * uv_height;
+    img.stride[VPX_PLANE_U] = img.stride[VPX_PLANE_V] = uv_width;
 
+    vpx_enc_frame_flags_t flags = m_force_keyframe? VPX_EFLAG_FORCE_KF : 0;
+    vpx_codec_err_t ret = vpx_codec_encode(&m_codec, &img, m_frame_index,
+                                           duration, flags, enc_deadline);
+    assert(ret == VPX_CODEC_OK);
+    m_frame_index += duration;
+    m_force_keyframe = false;
     return ret;
 }
 
@@ -126,64 +206,3 @@ const char* VpxEncoder::GetEncodedData(int& len)
 
     return NULL;
 }
-
-
-#define rgbtoy(b, g, r, y) \
-y=(unsigned char)(((int)(30*r) + (int)(59*g) + (int)(11*b))/100)
-
-#define rgbtoyuv(b, g, r, y, u, v) \
-rgbtoy(b, g, r, y); \
-u=(unsigned char)(((int)(-17*r) - (int)(33*g) + (int)(50*b)+12800)/100); \
-v=(unsigned char)(((int)(50*r) - (int)(42*g) - (int)(8*b)+12800)/100)
-
-
-void RGB32toYUV420P(const unsigned char * rgb,
-                    unsigned char * yuv,
-                    unsigned rgbIncrement,
-                    unsigned char flip,
-                    int srcFrameWidth, int srcFrameHeight)
-{
-    unsigned int planeSize;
-    unsigned int halfWidth;
-
-    unsigned char * yplane;
-    unsigned char * uplane;
-    unsigned char * vplane;
-    const unsigned char * rgbIndex;
-
-    int x, y;
-    unsigned char * yline;
-    unsigned char * uline;
-    unsigned char * vline;
-
-    planeSize = srcFrameWidth * srcFrameHeight;
-    halfWidth = srcFrameWidth >> 1;
-
-    // get pointers to the data
-    yplane = yuv;
-    uplane = yuv + planeSize;
-    vplane = yuv + planeSize + (planeSize >> 2);
-    rgbIndex = rgb;
-
-    for (y = 0; y < srcFrameHeight; y++)
-    {
-        yline = yplane + (y * srcFrameWidth);
-        uline = uplane + ((y >> 1) * halfWidth);
-        vline = vplane + ((y >> 1) * halfWidth);
-
-        if (flip)
-            rgbIndex = rgb + (srcFrameWidth*(srcFrameHeight-1-y)*rgbIncrement);
-
-        for (x = 0; x < (int) srcFrameWidth; x+=2)
-        {
-            rgbtoyuv(rgbIndex[2], rgbIndex[1], rgbIndex[0], *yline, *uline, *vline);
-            rgbIndex += rgbIncrement;
-            yline++;
-            rgbtoyuv(rgbIndex[2], rgbIndex[1], rgbIndex[0], *yline, *uline, *vline);
-            rgbIndex += rgbIncrement;
-            yline++;
-            uline++;
-            vline++;
-        }
-    }
-}
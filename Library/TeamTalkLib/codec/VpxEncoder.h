@@ -39,8 +39,18 @@ public:
     bool Open(int width, int height, int target_bitrate, int fps);
     void Close();
 
+    //'duration' is the number of frame intervals (1/fps) the frame covers
     vpx_codec_err_t EncodeRGB32(const char* imgbuf, int imglen, bool bottom_up_bmp,
-                                unsigned long tm, int enc_deadline);
+                                unsigned long tm, int enc_deadline, int duration = 1);
+    //'imgbuf' holds Y, U and V planes without padding (I420_BYTES)
+    vpx_codec_err_t EncodeI420(const char* imgbuf, int imglen,
+                               unsigned long tm, int enc_deadline, int duration = 1);
+
+    //change target bitrate (kbit/sec) while encoding
+    bool SetBitrate(int target_bitrate);
+    int GetBitrate() const { return m_cfg.rc_target_bitrate; }
+    //encode next frame as key frame
+    void RequestKeyFrame() { m_force_keyframe = true; }
 
     const char* GetEncodedData(int& len);
 
@@ -49,5 +59,8 @@ private:
     vpx_codec_enc_cfg_t m_cfg;
     vpx_codec_iter_t m_iter;
     vpx_codec_pts_t m_frame_index;
+    bool m_force_keyframe;
+    //conversion target for EncodeRGB32(), allocated once in Open()
+    vpx_image_t* m_rgb32_img;
 };
 #endif
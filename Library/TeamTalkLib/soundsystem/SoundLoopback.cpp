@@ -240,10 +240,7 @@ void SoundLoopback::StreamCaptureCb(const soundsystem::InputStreamer& streamer,
         int ret = m_capture_resampler->Resample(buffer, samples, 
                                                 &m_resample_buffer[0],
                                                 int(m_preprocess_buffer_left.size()));
-        assert(ret > 0);
-        MYTRACE_COND(ret != output_samples,
-                     ACE_TEXT("Resampler output incorrect no. samples, expect %d, got %d\n"),
-                     output_samples, ret);
+        assert(ret == output_samples);
 
         if(output_channels == 1)
         {
@@ -333,11 +330,7 @@ void SoundLoopback::StreamDuplexEchoCb(const soundsystem::DuplexStreamer& stream
         int ret = m_capture_resampler->Resample(input_buffer, samples, 
                                                 &m_resample_buffer[0],
                                                 output_samples);
-        assert(ret > 0);
-        assert(ret <= output_samples);
-        MYTRACE_COND(ret != output_samples,
-                     ACE_TEXT("Resampler output incorrect no. samples, expect %d, got %d\n"),
-                     output_samples, ret);
+        assert(ret == output_samples);
         tmp_input_buffer = &m_resample_buffer[0];
     }
 
@@ -324,6 +324,31 @@ namespace teamtalk
         }
     }
 
+    bool GetAudioCodecDTXMode(const AudioCodec& codec)
+    {
+        switch(codec.codec)
+        {
+        case CODEC_OPUS :
+            return codec.opus.dtx;
+        default :
+            return false;
+        }
+    }
+
+    bool IsAudioCodecDTXFrame(const AudioCodec& codec,
+                              const std::vector<uint16_t>& enc_frame_sizes)
+    {
+        if(codec.codec != CODEC_OPUS || enc_frame_sizes.empty())
+            return false;
+
+        for(size_t i=0;i<enc_frame_sizes.size();i++)
+        {
+            if(enc_frame_sizes[i] > AUDIOCODEC_DTX_MAX_FRAMESIZE)
+                return false;
+        }
+        return true;
+    }
+
     bool GetAudioCodecSimulateStereo(const AudioCodec& codec)
     {
         switch(codec.codec)
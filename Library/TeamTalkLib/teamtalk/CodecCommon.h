@@ -26,6 +26,11 @@
 
 #include "Common.h"
 
+//Opus frames of this size or smaller carry no speech (DTX)
+#define AUDIOCODEC_DTX_MAX_FRAMESIZE 2
+//interval for transmitting a DTX frame during silence
+#define AUDIOCODEC_DTX_REFRESH_MSEC 400
+
 namespace teamtalk
 {
     bool ValidAudioCodec(const AudioCodec& codec);
@@ -40,6 +45,10 @@ namespace teamtalk
     int GetAudioCodecFrameSize(const AudioCodec& codec);
     int GetAudioCodecFramesPerPacket(const AudioCodec& codec);
     bool GetAudioCodecVBRMode(const AudioCodec& codec);
+    //silence suppression is only supported by OPUS
+    bool GetAudioCodecDTXMode(const AudioCodec& codec);
+    bool IsAudioCodecDTXFrame(const AudioCodec& codec,
+                              const std::vector<uint16_t>& enc_frame_sizes);
     bool GetAudioCodecSimulateStereo(const AudioCodec& codec);
     int GetAudioCodecBitRate(const AudioCodec& codec);
 
@@ -129,6 +129,21 @@ namespace teamtalk {
         return errmsg;
     }
 
+    bool ProtocolSameOrLater(const ACE_TString& protocol,
+                             const ACE_TString& version)
+    {
+        strings_t p_tokens = tokenize(protocol, ACE_TEXT("."));
+        strings_t v_tokens = tokenize(version, ACE_TEXT("."));
+        for(size_t i=0;i<v_tokens.size();i++)
+        {
+            int p = i < p_tokens.size()? string2i(p_tokens[i]) : 0;
+            int v = string2i(v_tokens[i]);
+            if(p != v)
+                return p > v;
+        }
+        return true;
+    }
+
     bool HasProperty(const mstrings_t& properties, 
                      const ACE_TString& prop)
     {
@@ -32,7 +32,13 @@
 #include <ace/SString.h>
 #include "Common.h"
 
-#define TEAMTALK_PROTOCOL_VERSION ACE_TEXT("5.3")
+#define TEAMTALK_PROTOCOL_VERSION ACE_TEXT("5.5")
+
+//first protocol version where desktop updates can contain block moves
+#define TEAMTALK_PROTOCOL_DESKTOPMOVE ACE_TEXT("5.4")
+//first protocol version where a client starts a new desktop session
+//when the server NAKs the client's own session
+#define TEAMTALK_PROTOCOL_DESKTOPREFRESH ACE_TEXT("5.5")
 
 /* parameter names */
 #define TT_USERID ACE_TEXT("userid")
@@ -128,6 +134,7 @@
 #define TT_CLIENTNAME ACE_TEXT("clientname") // v5.1
 #define TT_TRANSMITQUEUE ACE_TEXT("transmitqueue") // v5.2
 #define TT_CMDFLOOD ACE_TEXT("cmdflood") // v5.3
+#define TT_VOICESUPPRESSED ACE_TEXT("voicesuppressed")
 #define TT_BANTYPE ACE_TEXT("type") // v5.3
 
 //    Client ---> Server
@@ -270,6 +277,10 @@ namespace teamtalk {
     //obtain error message to error number TT_CMDERR_*
     ACE_TString GetErrorDescription(int nError);
 
+    //compare protocol versions of the form "major.minor"
+    bool ProtocolSameOrLater(const ACE_TString& protocol,
+                             const ACE_TString& version);
+
     struct ErrorMsg
     {
         int errorno;
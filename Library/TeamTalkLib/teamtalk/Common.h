@@ -81,6 +81,7 @@ namespace teamtalk {
         ACE_INT64 last_desktop_bytessent;
         ACE_INT64 files_bytesreceived;
         ACE_INT64 files_bytessent;
+        ACE_INT64 voice_frames_suppressed;
 
         int userspeak;
         int usersservered;
@@ -97,6 +98,7 @@ namespace teamtalk {
             , desktop_bytessent(0), last_desktop_bytessent(0)
             , mediafile_bytessent(0), last_mediafile_bytessent(0), userspeak(0)
             , usersservered(0), files_bytesreceived(0), files_bytessent(0)
+            , voice_frames_suppressed(0)
         {}
     };
 
@@ -463,7 +465,8 @@ namespace teamtalk {
     enum DesktopProtocol
     {
         DESKTOPPROTOCOL_NONE    = 0,
-        DESKTOPPROTOCOL_ZLIB_1  = 1
+        DESKTOPPROTOCOL_ZLIB_1  = 1,
+        DESKTOPPROTOCOL_ZLIB_FAST = 2
     };
 
     struct DesktopWindow
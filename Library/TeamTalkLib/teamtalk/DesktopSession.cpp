@@ -24,6 +24,27 @@
 #include "DesktopSession.h"
 #include "ttassert.h"
 
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DESKTOPCRC_X86
+#include <nmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+#define DESKTOPCRC_ARM
+#include <arm_acle.h>
+#endif
+
+#if defined(DESKTOPCRC_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define TARGET_SSE42
+#endif
+
 using namespace std;
 using namespace teamtalk;
 
@@ -97,6 +118,17 @@ void DesktopSession::Init()
     }
 }
 
+DesktopRect DesktopSession::GetBlockRect(int block_no) const
+{
+    int h = block_no / m_w_blocks;
+    int w = block_no - h * m_w_blocks;
+    int height = (h == m_h_blocks-1 && (GetHeight() % m_block_height))? 
+        GetHeight() % m_block_height : m_block_height;
+    int width = (w == m_w_blocks-1 && (GetWidth() % m_block_width))? 
+        GetWidth() % m_block_width : m_block_width;
+    return DesktopRect(w * m_block_width, h * m_block_height, width, height);
+}
+
 RGBMode DesktopSession::GetRGBMode() const
 {
     switch(m_pixel_size)
@@ -353,6 +385,105 @@ size_t teamtalk::ConvertBitmap(const std::vector<char>& src_bitmap,
     return rgbdest_pos;
 }
 
+namespace
+{
+    //CRC32C (Castagnoli), reflected polynomial 0x82F63B78
+    struct CRC32CTable
+    {
+        uint32_t table[256];
+        CRC32CTable()
+        {
+            for(uint32_t i=0;i<256;i++)
+            {
+                uint32_t crc = i;
+                for(int j=0;j<8;j++)
+                    crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+                table[i] = crc;
+            }
+        }
+    };
+
+    uint32_t CRC32C_SW(uint32_t crc, const uint8_t* data, size_t len)
+    {
+        static const CRC32CTable t;
+        for(size_t i=0;i<len;i++)
+            crc = t.table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+
+#if defined(DESKTOPCRC_X86)
+    bool HasSSE42()
+    {
+#if defined(_MSC_VER)
+        int regs[4];
+        __cpuid(regs, 1);
+        return (regs[2] & (1 << 20)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    }
+
+    TARGET_SSE42 uint32_t CRC32C_SSE42(uint32_t crc, const uint8_t* data, size_t len)
+    {
+#if defined(__x86_64__) || defined(_M_X64)
+        uint64_t crc64 = crc;
+        for(;len >= 8;len -= 8, data += 8)
+        {
+            uint64_t v;
+            memcpy(&v, data, 8);
+            crc64 = _mm_crc32_u64(crc64, v);
+        }
+        crc = uint32_t(crc64);
+#endif
+        for(;len >= 4;len -= 4, data += 4)
+        {
+            uint32_t v;
+            memcpy(&v, data, 4);
+            crc = _mm_crc32_u32(crc, v);
+        }
+        for(;len;len--, data++)
+            crc = _mm_crc32_u8(crc, *data);
+        return crc;
+    }
+#endif /* DESKTOPCRC_X86 */
+
+#if defined(DESKTOPCRC_ARM)
+    uint32_t CRC32C_ARM(uint32_t crc, const uint8_t* data, size_t len)
+    {
+        for(;len >= 8;len -= 8, data += 8)
+        {
+            uint64_t v;
+            memcpy(&v, data, 8);
+            crc = __crc32cd(crc, v);
+        }
+        for(;len;len--, data++)
+            crc = __crc32cb(crc, *data);
+        return crc;
+    }
+#endif
+
+    typedef uint32_t (*crc32c_func_t)(uint32_t, const uint8_t*, size_t);
+
+    crc32c_func_t FindCRC32C()
+    {
+#if defined(DESKTOPCRC_X86)
+        if(HasSSE42())
+            return CRC32C_SSE42;
+#endif
+#if defined(DESKTOPCRC_ARM)
+        return CRC32C_ARM;
+#endif
+        return CRC32C_SW;
+    }
+}
+
+uint32_t teamtalk::BlockCRC32C(const char* data, size_t len)
+{
+    static const crc32c_func_t crc32c = FindCRC32C();
+    return ~crc32c(~0u, reinterpret_cast<const uint8_t*>(data), len);
+}
+
 //void rgb_to_hsv(unsigned r, unsigned g, unsigned b, double* h, double* s, double* v);
 //void hsv_to_rgb(double hue, double s, double v, unsigned* r, unsigned* g, unsigned* b);
 
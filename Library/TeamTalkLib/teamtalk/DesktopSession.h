@@ -51,6 +51,15 @@
 
 namespace teamtalk {
 
+    //region of a bitmap in pixels, 'y' is the scan-line in the bitmap
+    struct DesktopRect
+    {
+        int x, y, width, height;
+        DesktopRect() : x(0), y(0), width(0), height(0) {}
+        DesktopRect(int x_, int y_, int w, int h)
+            : x(x_), y(y_), width(w), height(h) {}
+    };
+
     class DesktopSession
     {
     public:
@@ -68,6 +77,14 @@ namespace teamtalk {
         int GetBytesPerLine() const;
         int GetWidthSize() const { return GetWidth() * m_pixel_size; }
         DesktopProtocol GetDesktopProtocol() const { return m_wnd.desktop_protocol; }
+        int GetPixelSize() const { return m_pixel_size; }
+        int GetBlocksPerRow() const { return m_w_blocks; }
+        //position and size of a block in pixels
+        DesktopRect GetBlockRect(int block_no) const;
+        //block containing pixel (x, y)
+        int GetBlockNo(int x, int y) const { return x / m_block_width + (y / m_block_height) * m_w_blocks; }
+        //byte offset of pixel (x, y) in bitmap
+        int GetPixelOffset(int x, int y) const { return (x + y * GetWidth()) * m_pixel_size + GetHeight() * m_padding; }
 
     protected:
         void Init();
@@ -96,6 +113,13 @@ namespace teamtalk {
 
     DesktopSession MakeDesktopSession(int width, int height, RGBMode rgb_mode, 
                                       int bytes_per_line = 0);
+
+    typedef std::vector<DesktopRect> desktop_rects_t;
+
+    /* CRC32C of a block. Uses the SSE4.2 or ARMv8 CRC instructions
+     * when available. Only for comparing blocks locally, it is not
+     * compatible with ACE::crc32(). */
+    uint32_t BlockCRC32C(const char* data, size_t len);
     
     size_t ConvertBitmap(const std::vector<char>& src_bitmap,
                          const DesktopSession& src_ses,
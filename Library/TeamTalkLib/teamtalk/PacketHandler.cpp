@@ -25,102 +25,227 @@
 #include "ttassert.h"
 #include "Commands.h"
 #include <vector>
-#include <queue>
 
 #include <ace/OS_NS_sys_socket.h>
 using namespace std;
 using namespace teamtalk;
 
+//limit per lane, same as the old ACE_Message_Queue water mark
+#define PACKETQUEUE_MAX_LANE_PACKETS 1000
+
 PacketQueue::PacketQueue()
+    : m_notified(false)
 {
-    this->high_water_mark(sizeof(FieldPacket*)*1000);
-    this->low_water_mark(sizeof(FieldPacket*)*1000);
+    for(int i=0;i<TXLANE_COUNT;i++)
+    {
+        m_pushed[i] = NULL;
+        m_count[i] = 0;
+    }
 }
 
-void PacketQueue::Reset()
+PacketQueue::~PacketQueue()
+{
+    Reset();
+}
+
+int PacketQueue::GetLane(uint8_t kind)
 {
-    ACE_Time_Value tv;
-    ACE_Message_Block* mb;
-    while(dequeue(mb, &tv)>=0)
+    switch(kind)
     {
-        FieldPacket* p;
-        memcpy(&p, mb->rd_ptr(), sizeof(p));
-        mb->release();
-        delete p;
+    case PACKET_KIND_MEDIAFILE_AUDIO :
+    case PACKET_KIND_MEDIAFILE_AUDIO_CRYPT :
+    case PACKET_KIND_MEDIAFILE_VIDEO :
+    case PACKET_KIND_MEDIAFILE_VIDEO_CRYPT :
+        return TXLANE_MEDIAFILE;
+    case PACKET_KIND_VIDEO :
+    case PACKET_KIND_VIDEO_CRYPT :
+        return TXLANE_VIDEO;
+    case PACKET_KIND_DESKTOP :
+    case PACKET_KIND_DESKTOP_CRYPT :
+        return TXLANE_DESKTOP;
+    default :
+        return TXLANE_VOICE;
     }
 }
 
-void PacketQueue::RemovePackets(PacketKind kind)
+void PacketQueue::CollectPackets()
 {
-    std::queue<FieldPacket*> packets;
-    FieldPacket* p;
-    while((p = GetNextPacket()))
+    for(int i=0;i<TXLANE_COUNT;i++)
     {
-        if(p->GetKind() == kind)
-            delete p;
-        else
-            packets.push(p);
+        if(!m_pushed[i].load())
+            continue;
+
+        //pushed packets are in reverse order so reverse the list
+        //before appending it to the lane
+        TxNode* node = m_pushed[i].exchange(NULL);
+        TxNode* prev = NULL;
+        while(node)
+        {
+            TxNode* next = node->next;
+            node->next = prev;
+            prev = node;
+            node = next;
+        }
+        node = prev;
+        while(node)
+        {
+            m_lanes[i].push_back(node->packet);
+            TxNode* next = node->next;
+            delete node;
+            node = next;
+        }
     }
-    while(packets.size())
+}
+
+void PacketQueue::Reset()
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_consumer_mtx);
+
+    CollectPackets();
+    for(int i=0;i<TXLANE_COUNT;i++)
     {
-        QueuePacket(packets.front());
-        packets.pop();
+        m_count[i] -= int(m_lanes[i].size());
+        while(m_lanes[i].size())
+        {
+            delete m_lanes[i].front();
+            m_lanes[i].pop_front();
+        }
     }
+    //a pending notification may have been discarded
+    m_notified = false;
 }
 
-void PacketQueue::RemoveChannelPackets(uint16_t chanid)
+void PacketQueue::RemovePackets(PacketKind kind)
 {
-    std::queue<FieldPacket*> packets;
-    FieldPacket* p;
-    while((p = GetNextPacket()))
+    ACE_Guard<ACE_Thread_Mutex> g(m_consumer_mtx);
+
+    CollectPackets();
+    int l = GetLane(kind);
+    std::deque<FieldPacket*>& lane = m_lanes[l];
+    for(std::deque<FieldPacket*>::iterator i=lane.begin();i!=lane.end();)
     {
-        if(p->GetChannel() == chanid)
-            delete p;
-        else
-            packets.push(p);
+        if((*i)->GetKind() == kind)
+        {
+            delete *i;
+            i = lane.erase(i);
+            m_count[l]--;
+        }
+        else ++i;
     }
-    while(packets.size())
+}
+
+void PacketQueue::RemoveChannelPackets(uint16_t chanid)
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_consumer_mtx);
+
+    CollectPackets();
+    for(int l=0;l<TXLANE_COUNT;l++)
     {
-        QueuePacket(packets.front());
-        packets.pop();
+        std::deque<FieldPacket*>& lane = m_lanes[l];
+        for(std::deque<FieldPacket*>::iterator i=lane.begin();i!=lane.end();)
+        {
+            if((*i)->GetChannel() == chanid)
+            {
+                delete *i;
+                i = lane.erase(i);
+                m_count[l]--;
+            }
+            else ++i;
+        }
     }
 }
 
 FieldPacket* PacketQueue::GetNextPacket()
 {
-    FieldPacket* p = NULL;
-    ACE_Message_Block* mb;
-    ACE_Time_Value tv;
-    if(this->dequeue(mb, &tv)>=0)
+    ACE_Guard<ACE_Thread_Mutex> g(m_consumer_mtx);
+
+    CollectPackets();
+    for(int pass=0;pass<2;pass++)
     {
-        memcpy(&p, mb->rd_ptr(), sizeof(p));
-        mb->release();
+        for(int i=0;i<TXLANE_COUNT;i++)
+        {
+            if(m_lanes[i].size())
+            {
+                FieldPacket* p = m_lanes[i].front();
+                m_lanes[i].pop_front();
+                m_count[i]--;
+                return p;
+            }
+        }
+
+        //queue is empty so next producer must notify. Collect once
+        //more since a producer may have pushed without notifying
+        //just before the flag was cleared.
+        if(pass == 0)
+        {
+            m_notified = false;
+            CollectPackets();
+        }
     }
-    return p;
+    return NULL;
 }
 
-
 int PacketQueue::QueuePacket(FieldPacket* packet)
 {
-    ACE_Message_Block* mb;
-    ACE_NEW_RETURN(mb, ACE_Message_Block(sizeof(packet)), -1);
-    mb->copy((const char*)&packet, sizeof(packet));
-    ACE_Time_Value tv;
-    return this->enqueue(mb, &tv);
+    if(!packet)
+        return -1;
+
+    int l = GetLane(packet->GetKind());
+    if(m_count[l].fetch_add(1) >= PACKETQUEUE_MAX_LANE_PACKETS)
+    {
+        m_count[l]--;
+        return -1;
+    }
+
+    TxNode* node;
+    ACE_NEW_NORETURN(node, TxNode);
+    if(!node)
+    {
+        m_count[l]--;
+        return -1;
+    }
+    node->packet = packet;
+
+    std::atomic<TxNode*>& head = m_pushed[l];
+    node->next = head.load();
+    while(!head.compare_exchange_weak(node->next, node));
+
+    return m_notified.exchange(true)? 0 : 1;
+}
+
+void PacketQueue::NotifyFailed()
+{
+    m_notified = false;
 }
 
 int PacketQueue::PacketCount()
 {
-    return (int)this->message_count();
+    int count = 0;
+    for(int i=0;i<TXLANE_COUNT;i++)
+        count += m_count[i];
+    return count;
 }
 
-
-
 PacketHandler::PacketHandler(ACE_Reactor* r) 
 : ACE_Event_Handler(r, HI_PRIORITY)
 {
     TTASSERT(r);
     m_buffer = new char[PACKETBUFFER];
+
+#if defined(PACKETHANDLER_RECV_BATCH)
+    const int slot_size = PACKETBUFFER / PACKETHANDLER_RECV_BATCH;
+    m_msgs.resize(PACKETHANDLER_RECV_BATCH);
+    m_iovecs.resize(PACKETHANDLER_RECV_BATCH);
+    m_addrs.resize(PACKETHANDLER_RECV_BATCH);
+    for(int i=0;i<PACKETHANDLER_RECV_BATCH;i++)
+    {
+        m_iovecs[i].iov_base = &m_buffer[i * slot_size];
+        m_iovecs[i].iov_len = slot_size;
+        m_msgs[i].msg_hdr.msg_iov = &m_iovecs[i];
+        m_msgs[i].msg_hdr.msg_iovlen = 1;
+        m_msgs[i].msg_hdr.msg_name = &m_addrs[i];
+    }
+#endif
 }
 
 PacketHandler::~PacketHandler()
@@ -184,6 +309,40 @@ int PacketHandler::handle_input(ACE_HANDLE)
     //receive the data
     ACE_INET_Addr addr;
 
+#if defined(PACKETHANDLER_RECV_BATCH)
+    //read the pending datagrams with one system call instead of
+    //one per datagram
+    for(int i=0;i<PACKETHANDLER_RECV_BATCH;i++)
+        m_msgs[i].msg_hdr.msg_namelen = sizeof(m_addrs[i]);
+
+    int n_msgs = recvmmsg(sock_i().get_handle(), &m_msgs[0],
+                          PACKETHANDLER_RECV_BATCH, MSG_DONTWAIT, NULL);
+    if(n_msgs < 0)
+    {
+        int err = ACE_OS::last_error();
+        MYTRACE(ACE_TEXT("UDP receive failed, errno: %d\n"), err);
+        return 0;
+    }
+
+    for(int i=0;i<n_msgs;i++)
+    {
+        const mmsghdr& msg = m_msgs[i];
+        if(msg.msg_len == 0)
+            continue;
+        if(msg.msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            MYTRACE(ACE_TEXT("Dropped truncated UDP packet of %u bytes\n"), msg.msg_len);
+            continue;
+        }
+
+        addr.set(reinterpret_cast<const sockaddr_in*>(msg.msg_hdr.msg_name),
+                 int(msg.msg_hdr.msg_namelen));
+        const char* data = reinterpret_cast<const char*>(msg.msg_hdr.msg_iov->iov_base);
+        packetlisteners_t::iterator ite;
+        for(ite=m_setListeners.begin();ite != m_setListeners.end();ite++)
+            (*ite)->ReceivedPacket(data, (int)msg.msg_len, addr);
+    }
+#else
     ssize_t ret = sock_i().recv(m_buffer, PACKETBUFFER, addr);
     if(ret > 0)
     {    
@@ -196,6 +355,11 @@ int PacketHandler::handle_input(ACE_HANDLE)
         int err = ACE_OS::last_error();
         MYTRACE(ACE_TEXT("UDP receive failed from %s, errno: %d\n"), InetAddrToString(addr).c_str(), err);
     }
+#endif
+
+    packetlisteners_t::iterator ite;
+    for(ite=m_setListeners.begin();ite != m_setListeners.end();ite++)
+        (*ite)->ReceivedPacketsDone();
 
     return 0;
 }
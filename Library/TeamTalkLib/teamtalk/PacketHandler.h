@@ -32,6 +32,12 @@
 #include <myace/MyACE.h>
 #include <vector>
 #include <set>
+#include <deque>
+#include <atomic>
+
+#if defined(__linux__) && !defined(__ANDROID_API__)
+#include <sys/socket.h>
+#endif
 
 #include "PacketLayout.h"
 
@@ -41,26 +47,75 @@ namespace teamtalk {
 
 #define PACKETBUFFER 0x10000
 
+#if defined(__linux__) && !defined(__ANDROID_API__)
+//datagrams read by one recvmmsg() call. Each gets an equal share of
+//PACKETBUFFER which is far above MAX_PACKET_SIZE
+#define PACKETHANDLER_RECV_BATCH 8
+#endif
+
     class PacketListener
     {
     public:
         virtual void ReceivedPacket(const char* data_buf, int data_len, 
                                     const ACE_INET_Addr& addr) = 0;
+        //called after the datagrams of one handle_input() have been
+        //passed to ReceivedPacket()
+        virtual void ReceivedPacketsDone(){}
         virtual void SendPackets(){}
     };
 
     typedef std::set<PacketListener*> packetlisteners_t;
 
-    class PacketQueue : private ACE_Message_Queue<ACE_MT_SYNCH>
+    // Multi-producer transmit queue with one lane per stream class
+    // so voice is never delayed by a burst of video or desktop
+    // packets. Producers push lock-free. The consumer (the reactor
+    // thread) takes the packets in strict priority order.
+    class PacketQueue
     {
     public:
         PacketQueue();
+        ~PacketQueue();
         void Reset();
         void RemovePackets(PacketKind kind);
         void RemoveChannelPackets(uint16_t chanid);
+        // Returns -1 if the packet's lane is full, 1 if the queue was
+        // idle so the consumer must be notified, otherwise 0.
         int QueuePacket(FieldPacket* packet);
+        // Notifying the consumer failed so the next producer must
+        // notify instead.
+        void NotifyFailed();
         FieldPacket* GetNextPacket();
         int PacketCount();
+
+    private:
+        enum
+        {
+            TXLANE_VOICE, // also control packets
+            TXLANE_MEDIAFILE,
+            TXLANE_VIDEO,
+            TXLANE_DESKTOP,
+            TXLANE_COUNT
+        };
+        static int GetLane(uint8_t kind);
+
+        struct TxNode
+        {
+            FieldPacket* packet;
+            TxNode* next;
+        };
+        // pull packets pushed by producers into the consumer's lanes
+        void CollectPackets();
+
+        // LIFO of pushed packets per lane
+        std::atomic<TxNode*> m_pushed[TXLANE_COUNT];
+        // FIFO per lane only accessed by consumer
+        std::deque<FieldPacket*> m_lanes[TXLANE_COUNT];
+        ACE_Thread_Mutex m_consumer_mtx;
+        // packets per lane. Each lane has its own limit so e.g. a
+        // desktop burst cannot fill the queue and block voice.
+        std::atomic<int> m_count[TXLANE_COUNT];
+        // consumer has been notified and hasn't seen an empty queue yet
+        std::atomic<bool> m_notified;
     };
 
     class PacketHandler : public ACE_Event_Handler
@@ -90,6 +145,11 @@ namespace teamtalk {
         ACE_SOCK_Dgram sock_;
         packetlisteners_t m_setListeners;
         char* m_buffer;
+#if defined(PACKETHANDLER_RECV_BATCH)
+        std::vector<mmsghdr> m_msgs;
+        std::vector<iovec> m_iovecs;
+        std::vector<sockaddr_storage> m_addrs;
+#endif
     };
 }
 
@@ -25,9 +25,17 @@
 #include <teamtalk/ttassert.h>
 #include <myace/MyACE.h>
 
+#include <algorithm>
+#include <string.h>
+
 using namespace std;
 
-#define MAX_PACKETS_ON_WIRE 16
+#define MAX_PACKETS_ON_WIRE 64
+//initial and minimum congestion window of a desktop transmitter
+#define DESKTOP_CWND_INIT 4
+#define DESKTOP_CWND_MIN 2
+//packets a desktop transmitter can send back-to-back
+#define DESKTOP_TX_BURST 4
 
 namespace teamtalk {
 
@@ -418,7 +426,7 @@ void UpdateBlocksCRC(const map_blocks_t& blocks,
             //store new CRC32 value in 'crc_blocks'
             map_blocks_t::const_iterator bi = blocks.find(*si);
             TTASSERT(bi!=blocks.end());
-            crc32 = ACE::crc32(&bi->second[0], bi->second.size());
+            crc32 = BlockCRC32C(&bi->second[0], bi->second.size());
             block_crcs[*si] = crc32;
         }
         else
@@ -428,7 +436,7 @@ void UpdateBlocksCRC(const map_blocks_t& blocks,
             TTASSERT(bi!=blocks.end()); //this should never happen since a block is reported dirty which is not in the list of blocks
             if(bi!=blocks.end())
             {
-                crc32 = ACE::crc32(&bi->second[0], bi->second.size());
+                crc32 = BlockCRC32C(&bi->second[0], bi->second.size());
                 block_crcs[*si] = crc32;
             }
             else continue;
@@ -563,6 +571,137 @@ bool ExtractBlockRange(const std::set<uint16_t>& blocknums,
     return !result_range.empty();
 }
 
+namespace
+{
+    bool BlockMoveGreater(const std::pair<int, block_move>& a,
+                          const std::pair<int, block_move>& b)
+    {
+        return a.first > b.first;
+    }
+}
+
+block_moves_t BuildBlockMoves(const map_block_offsets_t& block_offsets,
+                              int blocks_per_row, size_t max_moves)
+{
+    //offset -> blocks
+    typedef std::map< std::pair<int, int>, std::set<uint16_t> > offset_blocks_t;
+    offset_blocks_t offsets;
+    map_block_offsets_t::const_iterator ii = block_offsets.begin();
+    for(;ii!=block_offsets.end();ii++)
+        offsets[ii->second].insert(ii->first);
+
+    //size -> grid rectangle
+    std::vector< std::pair<int, block_move> > rects;
+    offset_blocks_t::iterator oi = offsets.begin();
+    for(;oi!=offsets.end();oi++)
+    {
+        std::set<uint16_t>& blocks = oi->second;
+        while(blocks.size())
+        {
+            //extend right from the top-left block and then down as long
+            //as the row below has the same blocks
+            uint16_t top_left = *blocks.begin();
+            int width = 1;
+            while((top_left + width) % blocks_per_row &&
+                  blocks.find(uint16_t(top_left + width)) != blocks.end())
+                width++;
+
+            int height = 1;
+            for(;;height++)
+            {
+                int row_start = top_left + height * blocks_per_row;
+                int w = 0;
+                while(w < width && blocks.find(uint16_t(row_start + w)) != blocks.end())
+                    w++;
+                if(w < width)
+                    break;
+            }
+
+            for(int h=0;h<height;h++)
+            {
+                for(int w=0;w<width;w++)
+                    blocks.erase(uint16_t(top_left + w + h * blocks_per_row));
+            }
+
+            block_move move;
+            move.dx = int16_t(oi->first.first);
+            move.dy = int16_t(oi->first.second);
+            move.top_left = top_left;
+            move.bottom_right = uint16_t(top_left + width - 1 + (height - 1) * blocks_per_row);
+            rects.push_back(std::make_pair(width * height, move));
+        }
+    }
+
+    std::stable_sort(rects.begin(), rects.end(), BlockMoveGreater);
+    if(rects.size() > max_moves)
+        rects.resize(max_moves);
+
+    block_moves_t moves;
+    for(size_t i=0;i<rects.size();i++)
+        moves.push_back(rects[i].second);
+    return moves;
+}
+
+bool GetMovedBlocks(const block_moves_t& moves, int blocks_per_row,
+                    int blocks_count, map_block_offsets_t& block_offsets)
+{
+    if(blocks_per_row <= 0)
+        return false;
+
+    block_moves_t::const_iterator mi = moves.begin();
+    for(;mi!=moves.end();mi++)
+    {
+        int col0 = mi->top_left % blocks_per_row, row0 = mi->top_left / blocks_per_row;
+        int col1 = mi->bottom_right % blocks_per_row, row1 = mi->bottom_right / blocks_per_row;
+        if(col0 > col1 || row0 > row1 || mi->bottom_right >= blocks_count)
+            return false;
+
+        for(int h=row0;h<=row1;h++)
+        {
+            for(int w=col0;w<=col1;w++)
+                block_offsets[uint16_t(w + h * blocks_per_row)] = std::make_pair(int(mi->dx), int(mi->dy));
+        }
+    }
+    return true;
+}
+
+bool CopyBlocksRegion(const DesktopSession& session, 
+                      const map_blocks_t& blocks,
+                      const DesktopRect& rect, std::vector<char>& outbuf)
+{
+    if(rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0 ||
+       rect.x + rect.width > session.GetWidth() ||
+       rect.y + rect.height > session.GetHeight())
+        return false;
+
+    const int pixel_size = session.GetPixelSize();
+    outbuf.resize(rect.width * rect.height * pixel_size);
+    char* out_ptr = &outbuf[0];
+
+    for(int y=rect.y;y<rect.y+rect.height;y++)
+    {
+        //a line in the region can span several blocks
+        int x = rect.x;
+        while(x < rect.x + rect.width)
+        {
+            int block_no = session.GetBlockNo(x, y);
+            DesktopRect block_rect = session.GetBlockRect(block_no);
+            map_blocks_t::const_iterator bi = blocks.find(uint16_t(block_no));
+            if(bi == blocks.end() ||
+               (int)bi->second.size() != block_rect.width * block_rect.height * pixel_size)
+                return false;
+
+            int n_pixels = std::min(rect.x + rect.width, block_rect.x + block_rect.width) - x;
+            int offset = ((y - block_rect.y) * block_rect.width + (x - block_rect.x)) * pixel_size;
+            memcpy(out_ptr, &bi->second[offset], n_pixels * pixel_size);
+            out_ptr += n_pixels * pixel_size;
+            x += n_pixels;
+        }
+    }
+    TTASSERT(out_ptr == &outbuf[0] + outbuf.size());
+    return true;
+}
+
 desktoppackets_t BuildDesktopPackets(bool new_session,
                                      uint16_t src_userid,
                                      uint32_t time,
@@ -572,12 +711,22 @@ desktoppackets_t BuildDesktopPackets(bool new_session,
                                      const map_blocks_t& blocks,
                                      const map_dup_blocks_t& dup_blocks,
                                      const std::set<uint16_t>* inc_blocks/* = NULL*/,
-                                     const std::set<uint16_t>* ignore_blocks/* = NULL*/)
+                                     const std::set<uint16_t>* ignore_blocks/* = NULL*/,
+                                     const block_moves_t* moves/* = NULL*/)
 {
     desktoppackets_t result;
     uint16_t packet_index = 0;
     int packets_size = 0;
 
+    //a new session has no previous update to move blocks from
+    TTASSERT(!new_session || !moves || moves->empty());
+    if(new_session || (moves && moves->empty()))
+        moves = NULL;
+
+    //block moves are repeated in every packet of the update
+    if(moves)
+        max_payload_size -= DESKTOPPACKET_MOVEUSAGE(uint16_t(moves->size()));
+
     map_block_t send_blocks;
     block_frags_t send_frags;
     map_dup_blocks_t send_dup_blocks(dup_blocks); //TODO: fragment if too many dup single-blocks
@@ -625,7 +774,7 @@ desktoppackets_t BuildDesktopPackets(bool new_session,
         }
     }
 
-    assert(send_blocks.size() || send_frags.size() || send_dup_blocks.size());
+    assert(send_blocks.size() || send_frags.size() || send_dup_blocks.size() || moves);
 
     map_block_t packet_blocks;
     block_frags_t packet_frags;
@@ -663,7 +812,7 @@ desktoppackets_t BuildDesktopPackets(bool new_session,
                                           0, //specified in UpdatePacketCount()
                                           packet_blocks, 
                                           packet_frags,
-                                          packet_dup_blocks));
+                                          packet_dup_blocks, moves));
 
         result.push_back(desktoppacket_t(p));
         packets_size += p->GetPacketSize();
@@ -691,7 +840,7 @@ desktoppackets_t BuildDesktopPackets(bool new_session,
                                           0, //specified in UpdatePacketCount()
                                           packet_blocks, 
                                           packet_frags,
-                                          packet_dup_blocks));
+                                          packet_dup_blocks, moves));
 
         packet_blocks.clear();
         packet_frags.clear();
@@ -950,8 +1099,15 @@ int RemoveObsoleteDesktopPackets(const DesktopPacket& packet,
 DesktopTransmitter::DesktopTransmitter(uint8_t session_id, uint32_t upd_timeid)
 : m_session_id(session_id)
 , m_update_timeid(upd_timeid)
-, m_tx_count(4)
-, m_pingtime(0)
+, m_cwnd(DESKTOP_CWND_INIT)
+, m_cwnd_acks(0)
+, m_ssthresh(MAX_PACKETS_ON_WIRE)
+, m_srtt(0)
+, m_rttvar(0)
+, m_recover_time(GETTIMESTAMP())
+, m_tx_credit(DESKTOP_TX_BURST * 1000)
+, m_credit_time(GETTIMESTAMP())
+, m_superseded(false)
 {
 }
 
@@ -961,6 +1117,21 @@ void DesktopTransmitter::AddDesktopPacketToQueue(desktoppacket_t& packet)
     TTASSERT(packet->GetTime() == m_update_timeid);
     TTASSERT(packet->GetPacketIndex() != DesktopPacket::INVALID_PACKET_INDEX);
     m_queued_pkts[packet->GetPacketIndex()] = packet;
+
+    //a block can only be superseded if its duplicates are as well
+    map_dup_blocks_t dup_blocks;
+    packet->GetDuplicateBlocks(dup_blocks);
+    map_dup_blocks_t::const_iterator dbi = dup_blocks.begin();
+    for(;dbi!=dup_blocks.end();dbi++)
+        m_dup_blocks[dbi->first].insert(dbi->second.begin(), dbi->second.end());
+}
+
+void DesktopTransmitter::CopyCongestionState(const DesktopTransmitter& prev_tx)
+{
+    m_cwnd = prev_tx.m_cwnd;
+    m_ssthresh = prev_tx.m_ssthresh;
+    m_srtt = prev_tx.m_srtt;
+    m_rttvar = prev_tx.m_rttvar;
 }
 
 void DesktopTransmitter::AddSentDesktopPacket(const DesktopPacket& packet)
@@ -976,7 +1147,8 @@ void DesktopTransmitter::AddSentDesktopPacket(const DesktopPacket& packet)
         GetSessionID(), GetUpdateID(), packet_no, GETTIMESTAMP());
     TTASSERT(packet.GetTime() == GetUpdateID());
 
-    //store time of first transmission of packet
+    //store time of first transmission of packet (retransmitted
+    //packets cannot be used for measuring round-trip)
     if(m_sent_times.find(packet_no) == m_sent_times.end())
         m_sent_ack_times[packet_no] = GETTIMESTAMP();
     else
@@ -985,10 +1157,59 @@ void DesktopTransmitter::AddSentDesktopPacket(const DesktopPacket& packet)
     //store time of transmission
     m_sent_times[packet_no] = GETTIMESTAMP();
 
-    TTASSERT(m_tx_count>=0);
     TTASSERT(m_sent_pkts.size() <= MAX_PACKETS_ON_WIRE);
 }
 
+void DesktopTransmitter::DesktopPacketLost(uint16_t packet_no, bool timeout)
+{
+    //only one window reduction for packets lost in the same round-trip
+    map_sent_time_t::const_iterator sti = m_sent_times.find(packet_no);
+    if(sti != m_sent_times.end() && W32_LT(sti->second, m_recover_time))
+        return;
+
+    m_ssthresh = ACE_MAX(m_cwnd / 2, DESKTOP_CWND_MIN);
+    m_cwnd = timeout? DESKTOP_CWND_MIN : m_ssthresh;
+    m_cwnd_acks = 0;
+    m_recover_time = GETTIMESTAMP();
+
+    MYTRACE(ACE_TEXT("Desktop tx %d:%u lost packet %d, cwnd is now %d\n"),
+            GetSessionID(), GetUpdateID(), packet_no, m_cwnd);
+}
+
+int DesktopTransmitter::GetPacketsInFlight() const
+{
+    int missing = 0;
+    map_acked_missing_t::const_iterator ali = m_acked_missing.begin();
+    for(;ali!=m_acked_missing.end();ali++)
+    {
+        if(m_sent_pkts.find(ali->first) != m_sent_pkts.end())
+            missing++;
+    }
+    return int(m_sent_pkts.size()) - missing;
+}
+
+bool DesktopTransmitter::PacePacket()
+{
+    //no pacing until round-trip is known
+    if(m_srtt == 0)
+        return true;
+
+    //send 'm_cwnd' packets evenly spread over a round-trip
+    uint32_t now = GETTIMESTAMP();
+    //(more than a round-trip of credit is never needed)
+    uint32_t elapsed = ACE_MIN(now - m_credit_time, m_srtt);
+    m_credit_time = now;
+    int credit = int(elapsed * 1000 / m_srtt * m_cwnd);
+    m_tx_credit = ACE_MIN(m_tx_credit + credit, DESKTOP_TX_BURST * 1000);
+
+    //the ACK clock stops if nothing is on the wire
+    if(m_tx_credit < 1000 && GetPacketsInFlight() > 0)
+        return false;
+
+    m_tx_credit = ACE_MAX(m_tx_credit - 1000, 0);
+    return true;
+}
+
 bool DesktopTransmitter::IsDesktopPacketAcked(uint16_t packet_no) const
 {
     return m_queued_pkts.find(packet_no) == m_queued_pkts.end() &&
@@ -997,7 +1218,6 @@ bool DesktopTransmitter::IsDesktopPacketAcked(uint16_t packet_no) const
 
 bool DesktopTransmitter::ProcessDesktopAckPacket(const DesktopAckPacket& ack_packet)
 {
-    uint32_t tm = GETTIMESTAMP();
     //static int ack_size = ack_packet.GetPacketSize();
     //MYTRACE(ACE_TEXT("Ack Packet is %d bytes\n"), ack_size);
     //if(ack_packet.GetPacketSize()> ack_size)
@@ -1044,32 +1264,37 @@ bool DesktopTransmitter::ProcessDesktopAckPacket(const DesktopAckPacket& ack_pac
             m_sent_times.erase(ack_packetno);
             m_acked_missing.erase(ack_packetno);
 
-            //calc round-trip
+            //calc smoothed round-trip (RFC 6298)
             map_sent_time_t::iterator sti = m_sent_ack_times.find(ack_packetno);
             if(sti != m_sent_ack_times.end())
             {
-                m_pingtime = ACE_MAX((uint32_t)GETTIMESTAMP() - sti->second, m_pingtime);
-                m_pingtime = ACE_MAX((uint32_t)1, m_pingtime);
-                
+                uint32_t rtt = ACE_MAX((uint32_t)GETTIMESTAMP() - sti->second, (uint32_t)1);
+                if(m_srtt == 0)
+                {
+                    m_srtt = rtt;
+                    m_rttvar = rtt / 2;
+                }
+                else
+                {
+                    uint32_t delta = (m_srtt > rtt)? m_srtt - rtt : rtt - m_srtt;
+                    m_rttvar = (3 * m_rttvar + delta) / 4;
+                    m_srtt = ACE_MAX((7 * m_srtt + rtt) / 8, (uint32_t)1);
+                }
                 m_sent_ack_times.erase(ack_packetno);
             }
 
             m_sent_pkts.erase(dpi++);
 
-            //an ACK releases two more packets for sending
-            m_tx_count += 2;
-            
-            TTASSERT(m_sent_pkts.size() || m_tx_count>0);
+            //slow-start until first loss, then one packet per round-trip
+            if(m_cwnd < m_ssthresh)
+                m_cwnd++;
+            else if(++m_cwnd_acks >= m_cwnd)
+            {
+                m_cwnd++;
+                m_cwnd_acks = 0;
+            }
             //never allow more than MAX_PACKETS_ON_WIRE packets on the wire
-            if((int)m_sent_pkts.size() >= MAX_PACKETS_ON_WIRE)
-                m_tx_count = 0;
-            else if((int)m_sent_pkts.size() + m_tx_count >= MAX_PACKETS_ON_WIRE)
-                m_tx_count = MAX_PACKETS_ON_WIRE - (int)m_sent_pkts.size();
-
-            TTASSERT(m_tx_count>=0);
-            TTASSERT(m_tx_count<=MAX_PACKETS_ON_WIRE);
-            //MYTRACE(ACE_TEXT("Ack'ed desktop packet %d, tx_count is now %d\n"), ack_packetno, m_tx_count);
-            TTASSERT(m_sent_pkts.size() || m_tx_count>0);
+            m_cwnd = ACE_MIN(m_cwnd, MAX_PACKETS_ON_WIRE);
         }
         else dpi++;
     }
@@ -1088,21 +1313,11 @@ bool DesktopTransmitter::ProcessDesktopAckPacket(const DesktopAckPacket& ack_pac
         if(ali == m_acked_missing.end())
         {
             m_acked_missing[packet_no] = 1;
-            m_tx_count -= 4;
-            //if there's holes and not outstanding packets we need to
-            //allow at least one packet in order to continue
-            //transmission
-            if(m_sent_pkts.empty())
-                m_tx_count = ACE_MAX(m_tx_count, 1);
-            else
-                m_tx_count = ACE_MAX(m_tx_count, 0);
+            DesktopPacketLost(packet_no, false);
         }
         else
             ali->second++;
     }
-//     MYTRACE(ACE_TEXT("Ack took %u, max packet index %d\n"), GETTIMESTAMP() - tm, max_packet_no);
-
-    TTASSERT(m_sent_pkts.size() || m_tx_count>0);
 
     return true;
 }
@@ -1121,7 +1336,8 @@ int DesktopTransmitter::GetRemainingBytes() const
 
 void DesktopTransmitter::GetNextDesktopPackets(desktoppackets_t& packets)
 {
-    while(!m_queued_pkts.empty() && m_tx_count>0)
+    while(!m_queued_pkts.empty() && GetPacketsInFlight() < m_cwnd &&
+          PacePacket())
     {
         packets.push_back(m_queued_pkts.begin()->second);
         AddSentDesktopPacket(*m_queued_pkts.begin()->second);
@@ -1129,7 +1345,6 @@ void DesktopTransmitter::GetNextDesktopPackets(desktoppackets_t& packets)
         TTASSERT(m_sent_pkts.find(m_queued_pkts.begin()->first) == m_sent_pkts.end());
         m_sent_pkts[m_queued_pkts.begin()->first] = m_queued_pkts.begin()->second;
         m_queued_pkts.erase(m_queued_pkts.begin());
-        m_tx_count--;
     }
 }
 
@@ -1144,25 +1359,31 @@ void DesktopTransmitter::GetSentDesktopPackets(desktoppackets_t& packets) const
 
 void DesktopTransmitter::GetDupAckLostDesktopPackets(desktoppackets_t& packets)
 {
-    //rtx dup-acks
+    if(m_srtt == 0)
+        return;
+
+    //rtx dup-acks. Retransmissions are paced as well so a lossy
+    //receiver cannot cause a burst of retransmissions.
+    int window = m_cwnd;
     map_acked_missing_t::const_iterator ali = m_acked_missing.begin();
-    while(ali != m_acked_missing.end() && m_tx_count>0)
+    while(ali != m_acked_missing.end() && window > 0)
     {
         map_sent_time_t::const_iterator sti = m_sent_times.find(ali->first);
-        if(m_pingtime && sti != m_sent_times.end())
+        if(sti != m_sent_times.end() &&
+           W32_GEQ(GETTIMESTAMP() - sti->second, m_srtt * 2))
         {
-            if(W32_GEQ(GETTIMESTAMP() - sti->second, m_pingtime * 2))
+            map_desktop_packets_t::const_iterator dpi = m_sent_pkts.find(ali->first);
+            if(dpi != m_sent_pkts.end())
             {
-                map_desktop_packets_t::const_iterator dpi = m_sent_pkts.find(ali->first);
-                if(dpi != m_sent_pkts.end())
-                {
-                    packets.push_back(dpi->second);
-                    m_tx_count--;
-                    AddSentDesktopPacket(*dpi->second);
+                if(!PacePacket())
+                    break;
 
-                    MYTRACE(ACE_TEXT("Desktop packet %d in session %d:%u DUP ack lost, tx_count is %d\n"),
-                        dpi->first, GetSessionID(), GetUpdateID(), m_tx_count);
-                }
+                packets.push_back(dpi->second);
+                window--;
+                AddSentDesktopPacket(*dpi->second);
+
+                MYTRACE(ACE_TEXT("Desktop packet %d in session %d:%u DUP ack lost, cwnd is %d\n"),
+                    dpi->first, GetSessionID(), GetUpdateID(), m_cwnd);
             }
         }
         ali++;
@@ -1179,20 +1400,21 @@ void DesktopTransmitter::GetLostDesktopPackets(const ACE_Time_Value& rtx_timeout
     {
         if(W32_GEQ(cur_time, ii->second + rtx_ms))
         {
-            MYTRACE(ACE_TEXT("Desktop packet %d in session %d:%u lost by %d, tx_count is %d\n"),
+            MYTRACE(ACE_TEXT("Desktop packet %d in session %d:%u lost by %d, cwnd is %d\n"),
                     ii->first, GetSessionID(), GetUpdateID(),
-                    cur_time - ii->second, m_tx_count);
+                    cur_time - ii->second, m_cwnd);
             map_desktop_packets_t::const_iterator dpi = m_sent_pkts.find(ii->first);
             TTASSERT(dpi != m_sent_pkts.end());
             if(dpi != m_sent_pkts.end())
             {
+                DesktopPacketLost(ii->first, true);
                 packets.push_back(dpi->second);
                 AddSentDesktopPacket(*dpi->second);
             }
         }
     }
-//     MYTRACE(ACE_TEXT("Sent packets %d, queued packets %d, tx_count = %d\n"), 
-//             m_sent_pkts.size(), m_queued_pkts.size(), m_tx_count);
+//     MYTRACE(ACE_TEXT("Sent packets %d, queued packets %d, cwnd = %d\n"), 
+//             m_sent_pkts.size(), m_queued_pkts.size(), m_cwnd);
     
     //'m_sent_pkts' is not filled unless a transmission is successful,
     //i.e. AddSentDesktopPacket() is called with the packet. So we
@@ -1205,6 +1427,108 @@ void DesktopTransmitter::GetLostDesktopPackets(const ACE_Time_Value& rtx_timeout
     }
 }
 
+int DesktopTransmitter::SupersedeBlocks(const std::set<uint16_t>& newer_blocks)
+{
+    int count = 0;
+    map_desktop_packets_t* queues[] = { &m_sent_pkts, &m_queued_pkts };
+    for(size_t q=0;q<sizeof(queues)/sizeof(queues[0]);q++)
+    {
+        map_desktop_packets_t::iterator dpi = queues[q]->begin();
+        for(;dpi!=queues[q]->end();dpi++)
+        {
+            const DesktopPacket& p = *dpi->second;
+
+            map_block_t blocks;
+            block_frags_t frags;
+            map_dup_blocks_t dups;
+            p.GetBlocks(blocks);
+            p.GetBlockFragments(frags);
+            p.GetDuplicateBlocks(dups);
+            //already an empty packet
+            if(blocks.empty() && frags.empty() && dups.empty())
+                continue;
+
+            //all blocks must be replaced by newer update including
+            //the blocks which are duplicated from them
+            std::set<uint16_t> block_nums;
+            map_block_t::const_iterator bi = blocks.begin();
+            for(;bi!=blocks.end();bi++)
+                block_nums.insert(bi->first);
+            block_frags_t::const_iterator fi = frags.begin();
+            for(;fi!=frags.end();fi++)
+                block_nums.insert(fi->block_no);
+            map_dup_blocks_t::const_iterator dbi = dups.begin();
+            for(;dbi!=dups.end();dbi++)
+                block_nums.insert(dbi->second.begin(), dbi->second.end());
+
+            bool superseded = true;
+            std::set<uint16_t>::const_iterator si = block_nums.begin();
+            for(;si!=block_nums.end() && superseded;si++)
+            {
+                superseded = newer_blocks.find(*si) != newer_blocks.end();
+                dbi = m_dup_blocks.find(*si);
+                if(superseded && dbi != m_dup_blocks.end())
+                    superseded = std::includes(newer_blocks.begin(), newer_blocks.end(),
+                                               dbi->second.begin(), dbi->second.end());
+            }
+            if(!superseded)
+                continue;
+
+            //moves apply to the previous update so they must remain
+            block_moves_t moves;
+            p.GetBlockMoves(moves);
+
+            DesktopPacket* empty_pkt;
+            uint8_t session_id;
+            uint16_t width, height, pkt_index, pkt_count;
+            uint8_t bmp_mode;
+            if(p.GetSessionProperties(&session_id, &width, &height, &bmp_mode,
+                                      &pkt_index, &pkt_count))
+            {
+                ACE_NEW_RETURN(empty_pkt,
+                               DesktopPacket(p.GetSrcUserID(), p.GetTime(),
+                                             session_id, width, height,
+                                             bmp_mode, pkt_index, pkt_count,
+                                             map_block_t(), block_frags_t(),
+                                             mmap_dup_blocks_t()), count);
+            }
+            else if(p.GetUpdateProperties(&session_id, &pkt_index, &pkt_count))
+            {
+                ACE_NEW_RETURN(empty_pkt,
+                               DesktopPacket(p.GetSrcUserID(), p.GetTime(),
+                                             session_id, pkt_index, pkt_count,
+                                             map_block_t(), block_frags_t(),
+                                             mmap_dup_blocks_t(),
+                                             moves.size()? &moves : NULL), count);
+            }
+            else continue;
+
+            empty_pkt->SetChannel(p.GetChannel());
+            dpi->second = desktoppacket_t(empty_pkt);
+            m_superseded = true;
+            count++;
+        }
+    }
+
+    MYTRACE_COND(count, ACE_TEXT("Desktop tx %d:%u superseded %d packets\n"),
+                 GetSessionID(), GetUpdateID(), count);
+    return count;
+}
+
+ACE_Time_Value DesktopTransmitter::GetRTxTimeout() const
+{
+    if(m_srtt == 0)
+        return DESKTOP_DEFAULT_RTX_TIMEOUT;
+
+    uint32_t rto = m_srtt + 4 * m_rttvar;
+    ACE_Time_Value rtx_timeout(rto / 1000, (rto % 1000) * 1000);
+    if(rtx_timeout < DESKTOP_RTX_MIN_TIMEOUT)
+        return DESKTOP_RTX_MIN_TIMEOUT;
+    if(rtx_timeout > DESKTOP_DEFAULT_RTX_TIMEOUT)
+        return DESKTOP_DEFAULT_RTX_TIMEOUT;
+    return rtx_timeout;
+}
+
 void GetPacketRanges(const std::set<uint16_t>& packet_indexes,
                      packet_range_t& pkt_index_ranges, 
                      std::set<uint16_t>& pkt_single_indexes)
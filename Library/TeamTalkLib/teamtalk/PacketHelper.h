@@ -104,6 +104,22 @@ namespace teamtalk {
     bool ExtractBlockRange(const std::set<uint16_t>& blocknums, 
                            std::set<uint16_t>& result_range); 
 
+    //blockno -> pixel offset (dx, dy) of its pixels in previous update
+    typedef std::map< uint16_t, std::pair<int, int> > map_block_offsets_t;
+
+    //merge blocks with the same offset into grid rectangles. Only the
+    //'max_moves' largest rectangles are kept.
+    block_moves_t BuildBlockMoves(const map_block_offsets_t& block_offsets,
+                                  int blocks_per_row, size_t max_moves);
+    //expand grid rectangles to the blocks they cover
+    bool GetMovedBlocks(const block_moves_t& moves, int blocks_per_row,
+                        int blocks_count, map_block_offsets_t& block_offsets);
+
+    //copy the pixels of 'rect' from the uncompressed 'blocks' to 'outbuf'
+    bool CopyBlocksRegion(const DesktopSession& session, 
+                          const map_blocks_t& blocks,
+                          const DesktopRect& rect, std::vector<char>& outbuf);
+
     desktoppackets_t BuildDesktopPackets(bool new_session,
                                          uint16_t src_userid,
                                          uint32_t time,
@@ -113,7 +129,8 @@ namespace teamtalk {
                                          const map_blocks_t& blocks,
                                          const map_dup_blocks_t& dup_blocks,
                                          const std::set<uint16_t>* inc_blocks = NULL,
-                                         const std::set<uint16_t>* ignore_blocks = NULL);
+                                         const std::set<uint16_t>* ignore_blocks = NULL,
+                                         const block_moves_t* moves = NULL);
 
     //select desktop packets for next transmission
     int SelectDesktopBlocks(bool initial_desktoppacket, 
@@ -148,6 +165,10 @@ namespace teamtalk {
         void AddDesktopPacketToQueue(desktoppacket_t& packet);
         bool IsDesktopPacketAcked(uint16_t packet_no) const;
 
+        //continue with the congestion window and round-trip of the
+        //transmitter of the previous update
+        void CopyCongestionState(const DesktopTransmitter& prev_tx);
+
         bool ProcessDesktopAckPacket(const DesktopAckPacket& ack_packet);
 
         int GetPacketSentSize() const { return (int)m_sent_pkts.size(); }
@@ -169,11 +190,29 @@ namespace teamtalk {
         void GetLostDesktopPackets(const ACE_Time_Value& rtx_timeout,
                                    desktoppackets_t& packets, int count);
 
+        //replace unacked packets which only contain blocks in
+        //'newer_blocks' by empty packets. The receiver still needs
+        //the packet to complete the update but not the stale blocks.
+        int SupersedeBlocks(const std::set<uint16_t>& newer_blocks);
+        //receiver didn't get all blocks of this update so the next
+        //update cannot be sent as block moves
+        bool HasSupersededBlocks() const { return m_superseded; }
+
+        //retransmission timeout derived from the round-trip of ACKs
+        ACE_Time_Value GetRTxTimeout() const;
+        int GetCongestionWindow() const { return m_cwnd; }
+
         uint8_t GetSessionID() const { return m_session_id; }
         uint32_t GetUpdateID() const { return m_update_timeid; }
 
     private:
         void AddSentDesktopPacket(const DesktopPacket& packet);
+        //shrink congestion window (once per round-trip)
+        void DesktopPacketLost(uint16_t packet_no, bool timeout);
+        //packets which are sent and not reported missing
+        int GetPacketsInFlight() const;
+        //whether the pacing rate allows another packet now
+        bool PacePacket();
 
         uint8_t m_session_id;
         uint32_t m_update_timeid;
@@ -190,9 +229,20 @@ namespace teamtalk {
         //packet id -> sent time
         typedef std::map<uint16_t, uint32_t> map_sent_time_t;
         map_sent_time_t m_sent_times, m_sent_ack_times;
-        int m_tx_count;
-        //round trip time (sent -> ack time)
-        uint32_t m_pingtime;
+        //src block -> duplicate blocks in all packets of the update
+        map_dup_blocks_t m_dup_blocks;
+        //congestion window in packets and slow-start threshold
+        int m_cwnd, m_cwnd_acks, m_ssthresh;
+        //smoothed round trip time and its variance (msec)
+        uint32_t m_srtt, m_rttvar;
+        //losses of packets sent before this time are part of the
+        //same congestion event
+        uint32_t m_recover_time;
+        //pacing credit (1/1000 packet) and time it was last refilled
+        int m_tx_credit;
+        uint32_t m_credit_time;
+        //SupersedeBlocks() replaced packets in this update
+        bool m_superseded;
     };
 
     typedef ACE_Strong_Bound_Ptr< DesktopTransmitter, ACE_Null_Mutex > desktop_transmitter_t;
@@ -1187,7 +1187,7 @@ namespace teamtalk
 #ifdef ENABLE_ENCRYPTION
         m_crypt_sections.insert(uint8_t(m_iovec.size())-1);
 #endif
-        uint16_t fieldsize_alloced = InitCommon(blocks, fragments, dup_blocks);
+        uint16_t fieldsize_alloced = InitCommon(blocks, fragments, dup_blocks, NULL);
 
 #ifdef _DEBUG
         size_t data_size = 0;
@@ -1225,7 +1225,8 @@ namespace teamtalk
                                  uint16_t pkt_upd_count, 
                                  const map_block_t& blocks, 
                                  const block_frags_t& fragments,
-                                 const mmap_dup_blocks_t& dup_blocks)
+                                 const mmap_dup_blocks_t& dup_blocks,
+                                 const block_moves_t* moves/* = NULL*/)
         : FieldPacket(PACKETHDR_CHANNEL_ONLY, PACKET_KIND_DESKTOP, src_userid, time)
     {
         int alloc_size = 0;
@@ -1261,7 +1262,7 @@ namespace teamtalk
 #ifdef ENABLE_ENCRYPTION
         m_crypt_sections.insert(uint8_t(m_iovec.size())-1);
 #endif
-        uint16_t fieldsize_alloced = InitCommon(blocks, fragments, dup_blocks);
+        uint16_t fieldsize_alloced = InitCommon(blocks, fragments, dup_blocks, moves);
 
 #ifdef _DEBUG
         int data_size = 0;
@@ -1287,6 +1288,7 @@ namespace teamtalk
         fields += DESKTOPPACKET_DATAUSAGE(uint16_t(blocks.size()), uint16_t(fragments.size()));
         fields += DESKTOPPACKET_BLOCKUSAGE(single_entries, single_blocks);
         fields += DESKTOPPACKET_BLOCKRANGEUSAGE(range_blocks);
+        fields += DESKTOPPACKET_MOVEUSAGE(moves? uint16_t(moves->size()) : 0);
 
         assert(fields + data_size == fieldsize_alloced + (uint16_t)v.iov_len);
         assert(GetPacketSize() <= MAX_PACKET_SIZE);
@@ -1351,7 +1353,8 @@ namespace teamtalk
 
     uint16_t DesktopPacket::InitCommon(const map_block_t& blocks, 
                                        const block_frags_t& fragments,
-                                       const mmap_dup_blocks_t& dup_blocks)
+                                       const mmap_dup_blocks_t& dup_blocks,
+                                       const block_moves_t* moves)
     {
         uint16_t alloced = 0;
         if(blocks.size())
@@ -1566,6 +1569,40 @@ namespace teamtalk
             }
             m_iovec.push_back(v);
 
+#ifdef ENABLE_ENCRYPTION
+            m_crypt_sections.insert(uint8_t(m_iovec.size())-1);
+#endif
+            alloced += (uint16_t)v.iov_len;
+        }
+
+        if(moves && moves->size())
+        {
+            //[[dx(int16_t), dy(int16_t), top_left(uint12_t), bottom_right(uint12_t)], ...] = 7 bytes
+            int alloc_size = DESKTOPPACKET_MOVEUSAGE(int(moves->size()));
+
+            uint8_t* data_buf;
+            ACE_NEW_RETURN(data_buf, uint8_t[alloc_size], alloced);
+
+            uint8_t* data_ptr = data_buf;
+            iovec v;
+            v.iov_base = reinterpret_cast<char*>(data_buf);
+            v.iov_len = alloc_size;
+
+            //write FIELDTYPE_BLOCK_MOVE
+            WRITEFIELD_TYPE(data_ptr, FIELDTYPE_BLOCK_MOVE,
+                            int(moves->size()) * 7, data_ptr);
+
+            block_moves_t::const_iterator mi = moves->begin();
+            for(;mi!=moves->end();mi++)
+            {
+                set_uint16_ptr(data_ptr, uint16_t(mi->dx), data_ptr);
+                set_uint16_ptr(data_ptr, uint16_t(mi->dy), data_ptr);
+                set2_uint12_ptr(data_ptr, mi->top_left, mi->bottom_right, data_ptr);
+            }
+
+            assert(alloc_size == data_ptr - reinterpret_cast<const uint8_t*>(v.iov_base));
+            m_iovec.push_back(v);
+
 #ifdef ENABLE_ENCRYPTION
             m_crypt_sections.insert(uint8_t(m_iovec.size())-1);
 #endif
@@ -1813,6 +1850,29 @@ namespace teamtalk
         return ok;
     }
 
+    bool DesktopPacket::GetBlockMoves(block_moves_t& moves) const
+    {
+        const uint8_t* info_ptr = FindField(FIELDTYPE_BLOCK_MOVE);
+        if(!info_ptr)
+            return false;
+
+        uint16_t info_size = READFIELD_SIZE(info_ptr);
+        info_ptr = READFIELD_DATAPTR(info_ptr);
+
+        const uint8_t* u8_info_ptr = reinterpret_cast<const uint8_t*>(info_ptr);
+        for(uint16_t i=0;i+7<=info_size;i+=7)
+        {
+            block_move bm;
+            bm.dx = int16_t(get_uint16(u8_info_ptr));
+            u8_info_ptr += 2;
+            bm.dy = int16_t(get_uint16(u8_info_ptr));
+            u8_info_ptr += 2;
+            get2_uint12_ptr(u8_info_ptr, bm.top_left, bm.bottom_right, u8_info_ptr);
+            moves.push_back(bm);
+        }
+        return true;
+    }
+
     const char* DesktopPacket::GetBlock(uint16_t block_no, 
                                         uint16_t& length) const
     {
@@ -2355,4 +2415,137 @@ namespace teamtalk
         return packetno;
     }
 
+    VideoFeedbackPacket::VideoFeedbackPacket(uint16_t src_userid, uint32_t time,
+                                             const VideoFeedback& feedback)
+                                             : FieldPacket(PACKETHDR_DEST_USER,
+                                                           PACKET_KIND_VIDEOFEEDBACK,
+                                                           src_userid, time)
+    {
+        int alloc_size = 0;
+
+        //FIELDTYPE_VIDEOFEEDBACK
+        //[streamid(uint8_t), frames_recv(uint16_t), frames_lost(uint16_t),
+        // flags(uint8_t), echo_time(uint32_t), echo_delay(uint16_t)]
+        int info_size = sizeof(uint8_t) + sizeof(uint16_t) * 2 + sizeof(uint8_t) +
+            sizeof(uint32_t) + sizeof(uint16_t);
+        alloc_size += FIELDVALUE_PREFIX + info_size;
+
+        uint8_t* data_buf;
+        ACE_NEW(data_buf, uint8_t[alloc_size]);
+        
+        uint8_t* data_ptr = data_buf;
+        iovec v;
+        v.iov_base = reinterpret_cast<char*>(data_buf);
+        v.iov_len = alloc_size;
+
+        uint8_t flags = 0;
+        if(feedback.keyframe_request)
+            flags |= FEEDBACK_FLAG_KEYFRAME;
+
+        WRITEFIELD_TYPE(data_ptr, FIELDTYPE_VIDEOFEEDBACK, info_size, data_ptr);
+        set_uint8_ptr(data_ptr, feedback.stream_id, data_ptr);
+        set_uint16_ptr(data_ptr, feedback.frames_recv, data_ptr);
+        set_uint16_ptr(data_ptr, feedback.frames_lost, data_ptr);
+        set_uint8_ptr(data_ptr, flags, data_ptr);
+        set_uint32_ptr(data_ptr, feedback.echo_time, data_ptr);
+        set_uint16_ptr(data_ptr, feedback.echo_delay, data_ptr);
+
+        m_iovec.push_back(v);
+#ifdef ENABLE_ENCRYPTION
+        m_crypt_sections.insert(uint8_t(m_iovec.size())-1);
+#endif
+    }
+
+    bool VideoFeedbackPacket::GetFeedback(VideoFeedback& feedback) const
+    {
+        const uint8_t* ptr = FindField(FIELDTYPE_VIDEOFEEDBACK);
+        if(!ptr)
+            return false;
+
+        uint16_t field_size = READFIELD_SIZE(ptr);
+        if(field_size < sizeof(uint8_t) + sizeof(uint16_t) * 2 + sizeof(uint8_t) +
+           sizeof(uint32_t) + sizeof(uint16_t))
+            return false;
+
+        uint8_t flags;
+        const uint8_t* field_ptr = READFIELD_DATAPTR(ptr);
+        get_uint8_ptr(feedback.stream_id, field_ptr, field_ptr);
+        get_uint16_ptr(feedback.frames_recv, field_ptr, field_ptr);
+        get_uint16_ptr(feedback.frames_lost, field_ptr, field_ptr);
+        get_uint8_ptr(flags, field_ptr, field_ptr);
+        get_uint32_ptr(feedback.echo_time, field_ptr, field_ptr);
+        get_uint16_ptr(feedback.echo_delay, field_ptr, field_ptr);
+        feedback.keyframe_request = (flags & FEEDBACK_FLAG_KEYFRAME);
+        return true;
+    }
+
+    /* ContainerPacket */
+
+    ContainerPacket::ContainerPacket(uint16_t src_userid, uint32_t time)
+        : FieldPacket(PACKETHDR_CHANNEL_ONLY, PACKET_KIND_CONTAINER, src_userid, time)
+        , m_packet_count(0)
+    {
+        //all packets are written to the same buffer
+        char* data_buf;
+        ACE_NEW(data_buf, char[MAX_PACKET_SIZE]);
+
+        iovec v;
+        v.iov_base = data_buf;
+        v.iov_len = 0;
+        m_iovec.push_back(v);
+    }
+
+    bool ContainerPacket::AddPacket(const FieldPacket& packet,
+                                    uint16_t max_packet_size)
+    {
+        assert(m_iovec.size() == 2);
+        assert(max_packet_size <= MAX_PACKET_SIZE);
+
+        uint16_t packet_size = packet.GetPacketSize();
+        if(packet_size > MAX_FIELD_SIZE ||
+           GetPacketSize() + FIELDVALUE_PREFIX + packet_size > max_packet_size)
+            return false;
+
+        uint8_t* ptr = reinterpret_cast<uint8_t*>(m_iovec[1].iov_base) + m_iovec[1].iov_len;
+        WRITEFIELD_TYPE(ptr, FIELDTYPE_PACKET, packet_size, ptr);
+
+        int buffers = 0;
+        const iovec* vv = packet.GetPacket(buffers);
+        for(int i=0;i<buffers;i++)
+        {
+            memcpy(ptr, vv[i].iov_base, vv[i].iov_len);
+            ptr += vv[i].iov_len;
+        }
+        m_iovec[1].iov_len += FIELDVALUE_PREFIX + packet_size;
+        m_packet_count++;
+        return true;
+    }
+
+    std::vector<iovec> ContainerPacket::GetPackets() const
+    {
+        std::vector<iovec> packets;
+        size_t pos = GetFieldsStart() - reinterpret_cast<const uint8_t*>(m_iovec[0].iov_base);
+        for(size_t i=0;i<m_iovec.size();i++)
+        {
+            const uint8_t* buf = reinterpret_cast<const uint8_t*>(m_iovec[i].iov_base);
+            while(pos + FIELDVALUE_PREFIX <= m_iovec[i].iov_len)
+            {
+                uint16_t field_size = READFIELD_SIZE(&buf[pos]);
+                if(pos + FIELDVALUE_PREFIX + field_size > m_iovec[i].iov_len)
+                    break;
+                if(READFIELD_TYPE(&buf[pos]) == FIELDTYPE_PACKET &&
+                   field_size >= TT_CHANNEL_HEADER_SIZE)
+                {
+                    iovec v;
+                    v.iov_base = const_cast<char*>(reinterpret_cast<const char*>(READFIELD_DATAPTR(&buf[pos])));
+                    v.iov_len = field_size;
+                    packets.push_back(v);
+                }
+                pos += FIELDVALUE_PREFIX + field_size;
+            }
+            pos = 0;
+        }
+        return packets;
+    }
+
 } /* namespace */
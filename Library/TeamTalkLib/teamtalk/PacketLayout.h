@@ -58,7 +58,9 @@ typedef ACE_INT64   int64_t;
 *    TEAMTALK 4 PACKET LAYOUT
 *******************************/
 
-#define TEAMTALK_PACKET_PROTOCOL 1
+#define TEAMTALK_PACKET_PROTOCOL 2
+
+#define TEAMTALK_CONTAINER_PACKET_PROTOCOL  2 //first protocol which accepts PACKET_KIND_CONTAINER
 
 #define TEAMTALK_DEFAULT_PACKET_PROTOCOL    1
 
@@ -70,10 +72,12 @@ typedef ACE_INT64   int64_t;
 #define MAX_PAYLOAD_DATA_SIZE   1250   //The raw data must be split in at most this size
 #define MAX_PACKET_PAYLOAD_SIZE (MAX_PAYLOAD_DATA_SIZE + FIELDHEADER_PAYLOAD)   //The maximum size of fields and raw data
 
-static uint16_t MTU_QUERY_SIZES[] = {MIN_PAYLOAD_DATA_SIZE, 800, 1000, MAX_PAYLOAD_DATA_SIZE};
+#define MAX_PMTU_PAYLOAD_DATA_SIZE 1350  //The largest raw data size which fits an unfragmented 1500 byte Ethernet frame (IPv6)
+
+static uint16_t MTU_QUERY_SIZES[] = {MIN_PAYLOAD_DATA_SIZE, 800, 1000, MAX_PAYLOAD_DATA_SIZE, MAX_PMTU_PAYLOAD_DATA_SIZE};
 #define MTU_QUERY_SIZES_COUNT (sizeof(MTU_QUERY_SIZES)/sizeof(MTU_QUERY_SIZES[0]))
 
-#define MAX_PACKET_SIZE 1350           //The maximum size of a packet
+#define MAX_PACKET_SIZE (MAX_PMTU_PAYLOAD_DATA_SIZE + 100) //The maximum size of a packet
 
 namespace teamtalk {
 
@@ -393,6 +397,11 @@ namespace teamtalk {
         PACKET_KIND_DESKTOPINPUT_CRYPT              = 20,
         PACKET_KIND_DESKTOPINPUT_ACK                = 21,
         PACKET_KIND_DESKTOPINPUT_ACK_CRYPT          = 22,
+
+        PACKET_KIND_VIDEOFEEDBACK                   = 23,
+        PACKET_KIND_VIDEOFEEDBACK_CRYPT             = 24,
+
+        PACKET_KIND_CONTAINER                       = 25,
     };
 
     //byte indexes for all packet types
@@ -722,6 +731,16 @@ namespace teamtalk {
     //blockno -> set(block_nums)
     typedef std::multimap< uint16_t, std::set<uint16_t> > mmap_dup_blocks_t;
     typedef std::pair< uint16_t, std::set<uint16_t> > dup_block_pair_t;
+    //blocks in the grid rectangle from block 'top_left' to block
+    //'bottom_right' are copied from the previous update at pixel
+    //offset (dx, dy)
+    struct block_move
+    {
+        int16_t dx, dy;
+        uint16_t top_left, bottom_right;
+        block_move() : dx(0), dy(0), top_left(0), bottom_right(0) {}
+    };
+    typedef std::vector<block_move> block_moves_t;
 
     bool IsBlockRange(const std::set<uint16_t>& blocks);
 
@@ -735,11 +754,14 @@ namespace teamtalk {
                       const map_block_t& blocks, const block_frags_t& fragments,
                       const mmap_dup_blocks_t& dup_blocks);
 
-        //Update session (packet based on FIELDTYPE_SESSIONID_UPD)
+        //Update session (packet based on FIELDTYPE_SESSIONID_UPD). Block
+        //moves must be in every packet of the update since they apply
+        //to the previous update and so must be processed first.
         DesktopPacket(uint16_t src_userid, uint32_t time, uint8_t session_id,
                       uint16_t pkt_upd_index, uint16_t pkt_upd_count,
                       const map_block_t& blocks, const block_frags_t& fragments,
-                      const mmap_dup_blocks_t& dup_blocks);
+                      const mmap_dup_blocks_t& dup_blocks,
+                      const block_moves_t* moves = NULL);
 
         DesktopPacket(uint8_t kind, const FieldPacket& crypt_pkt,
                       iovec& decrypt_fields)
@@ -769,6 +791,7 @@ namespace teamtalk {
         bool GetBlocks(map_block_t& blocks) const;
         bool GetBlockFragments(block_frags_t& fragments) const;
         bool GetDuplicateBlocks(map_dup_blocks_t& dup_blocks) const;
+        bool GetBlockMoves(block_moves_t& moves) const;
 
         const char* GetBlock(uint16_t block_no, uint16_t& length) const;
         
@@ -777,7 +800,8 @@ namespace teamtalk {
     private:
         uint16_t InitCommon(const map_block_t& blocks, 
                             const block_frags_t& fragments,
-                            const mmap_dup_blocks_t& dup_blocks);
+                            const mmap_dup_blocks_t& dup_blocks,
+                            const block_moves_t* moves);
 
         enum
         {
@@ -797,7 +821,9 @@ namespace teamtalk {
             //[[blockno(uint12_t), ..., 0xFFF], ...]
             FIELDTYPE_BLOCK_DUP,
             //[[blockno(uint12_t), startno(uint12_t), endno(uint12_t)], ...]
-            FIELDTYPE_BLOCK_DUP_RANGE
+            FIELDTYPE_BLOCK_DUP_RANGE,
+            //[[dx(int16_t), dy(int16_t), top_left(uint12_t), bottom_right(uint12_t)], ...]
+            FIELDTYPE_BLOCK_MOVE
         };
     };
 
@@ -827,6 +853,10 @@ namespace teamtalk {
     ((block_range_cnt) * 3 * 12) / 8))) : 0)
     //FIELDTYPE_BLOCK_DUP_RANGE
 
+#define DESKTOPPACKET_MOVEUSAGE(moves_cnt)                                     \
+    ((moves_cnt)? (FIELDVALUE_PREFIX + (moves_cnt) * 7) : 0)
+    //FIELDTYPE_BLOCK_MOVE
+
     
     //packetno -> packetno
     typedef std::map<uint16_t, uint16_t> packet_range_t;
@@ -991,6 +1021,85 @@ namespace teamtalk {
         };
     };
 
+    /* Receiver report for a video capture stream. Sent to the
+     * video's owner once per second (VideoRateControl). */
+    struct VideoFeedback
+    {
+        uint8_t stream_id;
+        uint16_t frames_recv;
+        uint16_t frames_lost;
+        bool keyframe_request;
+        //time of newest video packet received and msec it was held
+        //by receiver before feedback was sent (for RTT)
+        uint32_t echo_time;
+        uint16_t echo_delay;
+        VideoFeedback() : stream_id(0), frames_recv(0), frames_lost(0)
+                        , keyframe_request(false), echo_time(0), echo_delay(0) {}
+    };
+
+    class VideoFeedbackPacket : public FieldPacket
+    {
+    public:
+        VideoFeedbackPacket(uint16_t src_userid, uint32_t time,
+                            const VideoFeedback& feedback);
+
+        VideoFeedbackPacket(uint8_t kind, const FieldPacket& crypt_pkt,
+                            iovec& decrypt_fields)
+                            : FieldPacket(kind, crypt_pkt, decrypt_fields){}
+
+        VideoFeedbackPacket(const char* packet, uint16_t packet_size)
+            : FieldPacket(packet, packet_size) { }
+
+        VideoFeedbackPacket(const VideoFeedbackPacket& packet)
+            : FieldPacket(packet) { }
+
+        bool GetFeedback(VideoFeedback& feedback) const;
+
+    private:
+       enum
+        {
+            //[streamid(uint8_t), frames_recv(uint16_t), frames_lost(uint16_t),
+            // flags(uint8_t), echo_time(uint32_t), echo_delay(uint16_t)]
+            FIELDTYPE_VIDEOFEEDBACK = FIELDTYPE_LAST+1,
+        };
+        enum
+        {
+            FEEDBACK_FLAG_KEYFRAME = 0x01,
+        };
+    };
+
+
+    /* Several packets to the same destination bundled in one
+     * datagram. Each packet is stored unmodified (i.e. encrypted
+     * packets stay encrypted) in a field of its own.
+     * Requires TEAMTALK_CONTAINER_PACKET_PROTOCOL. */
+    class ContainerPacket : public FieldPacket
+    {
+    public:
+        ContainerPacket(uint16_t src_userid, uint32_t time);
+
+        ContainerPacket(const char* packet, uint16_t packet_size)
+            : FieldPacket(packet, packet_size), m_packet_count(0) { }
+
+        //returns false if 'packet' would make the container exceed
+        //'max_packet_size'
+        bool AddPacket(const FieldPacket& packet, uint16_t max_packet_size);
+        //the packets point into the container's buffer
+        std::vector<iovec> GetPackets() const;
+        //number of packets added by AddPacket()
+        int GetPacketCount() const { return m_packet_count; }
+
+    private:
+        enum
+        {
+            /* FIELDTYPE must NOT conflict with parent class packet */
+            FIELDTYPE_PACKET = FIELDTYPE_LAST+1,
+            /* New fields here to be compatible */
+        };
+        int m_packet_count;
+    };
+
+    typedef std::unique_ptr<ContainerPacket> container_packet_t;
 
 #ifdef ENABLE_ENCRYPTION
 
@@ -1029,6 +1138,8 @@ namespace teamtalk {
     typedef CryptPacket<DesktopInputPacket, PACKET_KIND_DESKTOPINPUT_CRYPT, PACKET_KIND_DESKTOPINPUT> CryptDesktopInputPacket;
 
     typedef CryptPacket<DesktopInputAckPacket, PACKET_KIND_DESKTOPINPUT_ACK_CRYPT, PACKET_KIND_DESKTOPINPUT_ACK> CryptDesktopInputAckPacket;
+
+    typedef CryptPacket<VideoFeedbackPacket, PACKET_KIND_VIDEOFEEDBACK_CRYPT, PACKET_KIND_VIDEOFEEDBACK> CryptVideoFeedbackPacket;
     
 #endif
 }
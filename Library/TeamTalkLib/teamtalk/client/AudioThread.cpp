@@ -33,8 +33,97 @@
 using namespace std;
 using namespace teamtalk;
 
+AudioFrameRing::AudioFrameRing()
+: m_input_size(0)
+, m_output_size(0)
+, m_head(0)
+, m_tail(0)
+, m_overruns(0)
+{
+}
+
+bool AudioFrameRing::Open(int frames, int samples, int input_channels, int output_channels)
+{
+    TTASSERT(frames > 0);
+    TTASSERT(samples > 0);
+    if(frames <= 0 || samples <= 0)
+        return false;
+
+    m_input_size = samples * input_channels;
+    m_output_size = samples * output_channels;
+    m_frames.resize(frames);
+    m_buffers.resize(frames * (m_input_size + m_output_size));
+    m_head = m_tail = 0;
+    m_overruns = 0;
+    return true;
+}
+
+void AudioFrameRing::Close()
+{
+    m_frames.clear();
+    m_buffers.clear();
+    m_input_size = m_output_size = 0;
+    m_head = m_tail = 0;
+}
+
+bool AudioFrameRing::Push(const media::AudioFrame& audframe)
+{
+    if(m_frames.empty())
+        return false;
+
+    size_t input_size = audframe.input_samples * audframe.input_channels;
+    size_t output_size = audframe.output_buffer? audframe.output_samples * audframe.output_channels : 0;
+    TTASSERT(input_size <= m_input_size);
+    TTASSERT(output_size <= m_output_size);
+    if(input_size > m_input_size || output_size > m_output_size)
+        return false;
+
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if(tail - m_head.load(std::memory_order_acquire) >= m_frames.size())
+    {
+        //encoder has fallen behind so drop the new frame
+        m_overruns.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    size_t slot = tail % m_frames.size();
+    short* buffer = &m_buffers[slot * (m_input_size + m_output_size)];
+
+    media::AudioFrame& frame = m_frames[slot];
+    frame = audframe;
+    frame.input_buffer = buffer;
+    memcpy(frame.input_buffer, audframe.input_buffer, input_size * sizeof(short));
+    if(output_size)
+    {
+        memcpy(buffer + m_input_size, audframe.output_buffer, output_size * sizeof(short));
+        frame.output_buffer = buffer + m_input_size;
+    }
+    else
+        frame.output_buffer = NULL;
+
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+media::AudioFrame* AudioFrameRing::Front()
+{
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if(head == m_tail.load(std::memory_order_acquire))
+        return NULL;
+    return &m_frames[head % m_frames.size()];
+}
+
+void AudioFrameRing::Pop()
+{
+    size_t head = m_head.load(std::memory_order_relaxed);
+    TTASSERT(head != m_tail.load(std::memory_order_acquire));
+    m_head.store(head + 1, std::memory_order_release);
+}
+
 AudioThread::AudioThread()
 :  m_listener(NULL)
+, m_queue_sem(0)
+, m_overruns_reported(0)
 #if defined(ENABLE_SPEEX)
 , m_speex(NULL)
 #endif
@@ -45,6 +134,9 @@ AudioThread::AudioThread()
 , m_voiceactlevel(VU_METER_MIN)
 , m_gainlevel(GAIN_NORMAL)
 , m_enc_cleared(true)
+, m_dtx_active(false)
+, m_dtx_frames(0)
+, m_frames_suppressed(0)
 , m_voiceact_delay(1, 500000)
 , m_tone_sample_index(0)
 , m_tone_frequency(0)
@@ -195,9 +287,19 @@ bool AudioThread::StartEncoder(AudioEncListener* listener,
     m_listener = listener;
 
     //allow one second of audio to build up in the queue
+    int max_frames = 1 + (sample_rate / callback_samples);
+    if(!m_framering.Open(max_frames, callback_samples, channels, channels))
+    {
+        StopEncoder();
+        return false;
+    }
+    m_overruns_reported = 0;
+    m_dtx_active = false;
+    m_dtx_frames = 0;
+    m_frames_suppressed = 0;
 
     int max_queue = PCM16_BYTES(sample_rate, GetAudioCodecChannels(codec));
-    max_queue += (1 + (sample_rate / callback_samples)) * sizeof(media::AudioFrame);
+    max_queue += max_frames * sizeof(media::AudioFrame);
 
     this->msg_queue()->activate();
     this->msg_queue()->high_water_mark(max_queue);
@@ -232,8 +334,11 @@ void AudioThread::StopEncoder()
 {
     int ret = this->msg_queue()->close();
     TTASSERT(ret >= 0);
+    m_queue_sem.release();
     wait();
 
+    m_framering.Close();
+
 #if defined(ENABLE_SPEEX)
     m_preprocess_left.Close();
     m_preprocess_right.Close();
@@ -252,7 +357,6 @@ void AudioThread::StopEncoder()
     m_enc_cleared = true;
 
     m_encbuf.clear();
-    m_echobuf.clear();
 
     m_listener = NULL;
 
@@ -272,32 +376,9 @@ void AudioThread::QueueAudio(const media::AudioFrame& audframe)
     assert(audframe.input_channels == audframe.output_channels || audframe.output_channels == 0);
     assert(audframe.input_samples == audframe.output_samples || audframe.output_samples == 0);
 
-    ACE_Message_Block* mb;
-    int frame_bytes = sizeof(audframe);
-    int input_bytes = audframe.input_channels*sizeof(short)*audframe.input_samples;
-    int output_bytes = audframe.output_channels*sizeof(short)*audframe.output_samples;
-
-    ACE_NEW(mb, ACE_Message_Block(frame_bytes + input_bytes + output_bytes));
-
-    //assign pointers to inside ACE_Message_Block
-    media::AudioFrame copy_frame = audframe;
-    copy_frame.input_buffer = reinterpret_cast<short*>(mb->rd_ptr()+frame_bytes);
-    copy_frame.output_buffer = 
-        reinterpret_cast<short*>(mb->rd_ptr()+(frame_bytes+input_bytes));
-
-    int ret;
-    ret = mb->copy(reinterpret_cast<const char*>(&copy_frame), 
-                   frame_bytes);
-    TTASSERT(ret>=0);
-    ret = mb->copy(reinterpret_cast<const char*>(audframe.input_buffer),
-                   input_bytes);
-    TTASSERT(ret>=0);
-    if(copy_frame.output_buffer)
-        ret = mb->copy(reinterpret_cast<const char*>(audframe.output_buffer),
-                       output_bytes);
-    TTASSERT(ret>=0);
-
-    QueueAudio(mb);
+    //drop policy is handled by ring (new frame is dropped if full)
+    if(m_framering.Push(audframe))
+        m_queue_sem.release();
 }
 
 void AudioThread::QueueAudio(ACE_Message_Block* mb_audio)
@@ -309,6 +390,8 @@ void AudioThread::QueueAudio(ACE_Message_Block* mb_audio)
         MYTRACE(ACE_TEXT("AudioThread msg_q full, dropped frame\n"));
         mb_audio->release();
     }
+    else
+        m_queue_sem.release();
 }
 
 
@@ -322,13 +405,40 @@ void AudioThread::ProcessQueue(ACE_Time_Value* tm)
 {
     TTASSERT(m_codec.codec != CODEC_NO_CODEC);
     TTASSERT(m_listener);
-    ACE_Message_Block* mb;
-    while(getq(mb, tm) >= 0)
+    while(m_queue_sem.acquire(tm) >= 0)
+    {
+        //StopEncoder() closes message queue and signals semaphore
+        if(this->msg_queue()->deactivated())
+            break;
+
+        ProcessRing();
+
+        ACE_Message_Block* mb;
+        ACE_Time_Value tv;
+        while(getq(mb, &tv) >= 0)
+        {
+            media::AudioFrame* audframe = reinterpret_cast<media::AudioFrame*>(mb->rd_ptr());
+            ProcessAudioFrame(*audframe);
+            mb->release();
+        }
+    }
+}
+
+void AudioThread::ProcessRing()
+{
+    media::AudioFrame* audframe;
+    while((audframe = m_framering.Front()) != NULL)
     {
-        media::AudioFrame* audframe = reinterpret_cast<media::AudioFrame*>(mb->rd_ptr());
+        m_listener->CapturedAudioFrame(*audframe);
         ProcessAudioFrame(*audframe);
-        mb->release();
+        m_framering.Pop();
     }
+
+    ACE_UINT32 overruns = m_framering.GetOverruns();
+    MYTRACE_COND(overruns != m_overruns_reported,
+                 ACE_TEXT("AudioThread encoder overrun, dropped %u frames\n"),
+                 overruns - m_overruns_reported);
+    m_overruns_reported = overruns;
 }
 
 int AudioThread::svc(void)
@@ -386,7 +496,7 @@ void AudioThread::ProcessAudioFrame(media::AudioFrame& audblock)
             break;
 
         }
-        if(enc_data)
+        if(enc_data && !IsSuppressedFrame(enc_frame_sizes))
         {
             int nbBytes = 0;
             for(size_t i=0;i<enc_frame_sizes.size();i++)
@@ -408,11 +518,46 @@ void AudioThread::ProcessAudioFrame(media::AudioFrame& audblock)
 #endif
             m_enc_cleared = true;
         }
+        m_dtx_active = false;
 
         m_listener->EncodedAudioFrame(m_codec, NULL, 0, std::vector<int>(), audblock);
     }
 }
 
+bool AudioThread::IsSuppressedFrame(const std::vector<int>& enc_frame_sizes)
+{
+    if(!GetAudioCodecDTXMode(m_codec))
+        return false;
+
+    for(size_t i=0;i<enc_frame_sizes.size();i++)
+    {
+        if(enc_frame_sizes[i] > AUDIOCODEC_DTX_MAX_FRAMESIZE)
+        {
+            m_dtx_active = false;
+            return false;
+        }
+    }
+
+    //transmit first DTX frame so receiver knows the following gap
+    //is silence and not packet loss
+    if(!m_dtx_active)
+    {
+        m_dtx_active = true;
+        m_dtx_frames = 0;
+        return false;
+    }
+
+    //keep receiver's comfort noise alive
+    if(++m_dtx_frames * GetAudioCodecCbMillis(m_codec) >= AUDIOCODEC_DTX_REFRESH_MSEC)
+    {
+        m_dtx_frames = 0;
+        return false;
+    }
+
+    m_frames_suppressed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
 #if defined(ENABLE_SPEEX)
 void AudioThread::PreprocessAudioFrame(media::AudioFrame& audblock)
 {
@@ -420,7 +565,6 @@ void AudioThread::PreprocessAudioFrame(media::AudioFrame& audblock)
 
     bool preprocess = false;
 
-    preprocess |= m_preprocess_left.IsEchoCancel();
     preprocess |= m_preprocess_left.IsDenoising();
     //don't include dereverb since it's not user configurable
 //    preprocess |= m_preprocess_left.IsDereverbing();
@@ -431,17 +575,6 @@ void AudioThread::PreprocessAudioFrame(media::AudioFrame& audblock)
 
     if(audblock.input_channels == 1) 
     {
-        if(m_preprocess_left.IsEchoCancel() &&
-           audblock.output_channels == 1 && audblock.output_buffer)
-        {
-            if(m_echobuf.size() != (size_t)audblock.input_samples)
-                m_echobuf.resize(audblock.input_samples);
-
-            m_preprocess_left.EchoCancel(audblock.input_buffer,
-                                         audblock.output_buffer,
-                                         &m_echobuf[0]);
-            audblock.input_buffer = &m_echobuf[0];
-        }
         m_preprocess_left.Preprocess(audblock.input_buffer); //denoise, AGC, etc
     }
     else if(audblock.input_channels == 2)
@@ -450,26 +583,6 @@ void AudioThread::PreprocessAudioFrame(media::AudioFrame& audblock)
                       in_rightchan(audblock.input_samples);
         SplitStereo(audblock.input_buffer, audblock.input_samples, in_leftchan, in_rightchan);
 
-        if(m_preprocess_left.IsEchoCancel() && m_preprocess_right.IsEchoCancel() &&
-           audblock.output_channels == 2 && audblock.output_buffer)
-        {
-            assert(audblock.input_samples == audblock.output_samples);
-
-            vector<short> out_leftchan(audblock.output_samples), 
-                          out_rightchan(audblock.output_samples),
-                          echobuf_left(audblock.output_samples),
-                          echobuf_right(audblock.output_samples);
-            SplitStereo(audblock.output_buffer, audblock.output_samples,
-                        out_leftchan, out_rightchan);
-
-            m_preprocess_left.EchoCancel(&in_leftchan[0], &out_leftchan[0], 
-                                         &echobuf_left[0]);
-            in_leftchan.swap(echobuf_left);
-            m_preprocess_right.EchoCancel(&in_rightchan[0], &out_rightchan[0], 
-                                         &echobuf_right[0]);
-            in_rightchan.swap(echobuf_right);
-        }
-
         m_preprocess_left.Preprocess(&in_leftchan[0]); //denoise, AGC, etc
         m_preprocess_right.Preprocess(&in_rightchan[0]); //denoise, AGC, etc
 
@@ -28,6 +28,8 @@
 #include <ace/Thread_Semaphore.h> 
 #include <ace/Bound_Ptr.h>
 
+#include <atomic>
+
 #if defined(ENABLE_SPEEX)
 #include <codec/SpeexEncoder.h>
 #include <codec/SpeexPreprocess.h>
@@ -50,6 +52,42 @@ public:
                                    const char* enc_data, int enc_len,
                                    const std::vector<int>& enc_frame_sizes,
                                    const media::AudioFrame& org_frame) = 0;
+    // Unprocessed frame from the ring, i.e. from
+    // QueueAudio(const media::AudioFrame&), before it is encoded
+    virtual void CapturedAudioFrame(const media::AudioFrame& audframe) = 0;
+};
+
+/* Single-producer/single-consumer ring of preallocated audio
+ * frames. The sound system's capture callback is the producer and
+ * AudioThread's encoder is the consumer. Pushing a frame never blocks
+ * and never allocates. If the ring is full, i.e. the encoder has
+ * fallen behind, the incoming frame is dropped and counted as an
+ * overrun. */
+class AudioFrameRing
+{
+public:
+    AudioFrameRing();
+
+    // Not thread-safe. Only call while producer and consumer are idle
+    bool Open(int frames, int samples, int input_channels, int output_channels);
+    void Close();
+
+    // producer
+    bool Push(const media::AudioFrame& audframe);
+    // consumer. Returned frame is valid until Pop()
+    media::AudioFrame* Front();
+    void Pop();
+
+    bool IsEmpty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+    ACE_UINT32 GetOverruns() const { return m_overruns.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<media::AudioFrame> m_frames;
+    std::vector<short> m_buffers;
+    size_t m_input_size, m_output_size;
+    // 'm_head' is only written by consumer, 'm_tail' only by producer
+    std::atomic<size_t> m_head, m_tail;
+    std::atomic<ACE_UINT32> m_overruns;
 };
 
 class AudioThread : protected ACE_Task<ACE_MT_SYNCH>
@@ -65,9 +103,14 @@ public:
 
     void EnableTone(int frequency) { m_tone_frequency = frequency; }
 
+    // Lock-free, called from sound system's capture callback
     void QueueAudio(const media::AudioFrame& audframe);
     void QueueAudio(ACE_Message_Block* mb_audio);
     bool IsVoiceActive() const;
+    // Frames dropped because encoder couldn't keep up
+    ACE_UINT32 GetOverruns() const { return m_framering.GetOverruns(); }
+    // DTX frames which were not transmitted
+    ACE_UINT32 GetFramesSuppressed() const { return m_frames_suppressed.load(std::memory_order_relaxed); }
 
     ACE_Recursive_Thread_Mutex m_preprocess_lock;
 #if defined(ENABLE_SPEEX)
@@ -90,6 +133,7 @@ private:
     int close(u_long);
     int svc(void);
 
+    void ProcessRing();
     void ProcessAudioFrame(media::AudioFrame& audblock);
 #if defined(ENABLE_SPEEX)
     void PreprocessAudioFrame(media::AudioFrame& audblock);
@@ -101,6 +145,11 @@ private:
                             std::vector<int>& env_frame_sizes);
 #endif
     AudioEncListener* m_listener;
+    // frames from QueueAudio(const media::AudioFrame&)
+    AudioFrameRing m_framering;
+    // signalled when either 'm_framering' or msg_queue() has data
+    ACE_Thread_Semaphore m_queue_sem;
+    ACE_UINT32 m_overruns_reported;
 #if defined(ENABLE_SPEEX)
     SpeexEncoder* m_speex;
 #endif
@@ -108,12 +157,18 @@ private:
     OpusEncode* m_opus;
 #endif
     std::vector<char> m_encbuf;
-    std::vector<short> m_echobuf;
     teamtalk::AudioCodec m_codec;
 
     //encoder state has been reset
     bool m_enc_cleared;
 
+    //discontinuous transmission. Only the first DTX frame of a
+    //silence period and periodic refreshes are transmitted
+    bool IsSuppressedFrame(const std::vector<int>& enc_frame_sizes);
+    bool m_dtx_active;
+    int m_dtx_frames;
+    std::atomic<ACE_UINT32> m_frames_suppressed;
+
     //voice activation
     ACE_Time_Value m_lastActive;
 
@@ -24,6 +24,7 @@
 #include "ClientNode.h"
 
 #include <codec/BmpFile.h>
+#include <codec/VideoConvert.h>
 #include <teamtalk/CodecCommon.h>
 #include <teamtalk/ttassert.h>
 #include <teamtalk/Commands.h>
@@ -37,6 +38,7 @@
 #include <ace/Synch_Options.h>
 
 #include "AudioContainer.h"
+#include "ReactorPool.h"
 
 using namespace teamtalk;
 using namespace std;
@@ -59,13 +61,17 @@ using namespace vidcap;
 
 #define LOCAL_USERID 0
 
-ClientNode::ClientNode(const ACE_TString& version, ClientListener* listener)
-                       : m_reactor(new ACE_Select_Reactor(), true) //Ensure we don't use ACE_WFMO_Reactor!!!
+ClientNode::ClientNode(const ACE_TString& version, ClientListener* listener,
+                       ACE_Reactor* reactor /*= NULL*/)
+                       : m_own_reactor(reactor? NULL :
+                                       new ACE_Reactor(new ACE_Select_Reactor(), true)) //Ensure we don't use ACE_WFMO_Reactor!!!
+                       , m_reactor(reactor? *reactor : *m_own_reactor)
 #ifdef _DEBUG
                        , m_reactor_thr_id(0)
                        , m_active_timerid(0)
                        , m_reactor_wait(0)
 #endif
+                       , m_reactor_closed(0)
                        , m_flags(CLIENT_CLOSED)
                        , m_connector(&m_reactor, ACE_NONBLOCK)
                        , m_def_stream(NULL)
@@ -85,23 +91,28 @@ ClientNode::ClientNode(const ACE_TString& version, ClientListener* listener)
                        , m_mediafile_stream_id(0)
                        , m_audiofile_pkt_counter(0)
                        , m_desktop_session_id(0)
+                       , m_desktop_restart(false)
+                       , m_tx_bundling(false)
                        , m_cmdid_counter(0)
                        , m_current_cmdid(0)
                        , m_mtu_data_size(MAX_PAYLOAD_DATA_SIZE)
                        , m_mtu_max_payload_size(MAX_PACKET_PAYLOAD_SIZE)
+                       , m_mtu_query_max(MTU_QUERY_SIZES[MTU_QUERY_SIZES_COUNT-1])
+                       , m_mtu_verify_lost(0)
                        , m_version(version)
 {
 
     this->reactor(&m_reactor);
 
-    m_listener->RegisterEventSuspender(this);
-
     m_local_voicelog = clientuser_t(new ClientUser(LOCAL_USERID, this, m_listener));
 
-    this->activate();
+    if(m_own_reactor)
+    {
+        this->activate();
 #if defined(_DEBUG)
-    m_reactor_wait.acquire();
+        m_reactor_wait.acquire();
 #endif
+    }
 
 #if defined(ENABLE_SOUNDSYSTEM)
     m_soundprop.soundgroupid = SOUNDSYSTEM->OpenSoundGroup();
@@ -110,10 +121,21 @@ ClientNode::ClientNode(const ACE_TString& version, ClientListener* listener)
 
 ClientNode::~ClientNode()
 {
-    //close reactor so no one can register new handlers
-    int ret = m_reactor.end_reactor_event_loop();
-    TTASSERT(ret>=0);
-    this->wait();
+    if(m_own_reactor)
+    {
+        //close reactor so no one can register new handlers
+        int ret = m_reactor.end_reactor_event_loop();
+        TTASSERT(ret>=0);
+        this->wait();
+    }
+    else if(m_reactor.notify(this, ACE_Event_Handler::EXCEPT_MASK) >= 0)
+    {
+        //a shared reactor keeps running so a pool thread may be
+        //dispatching a timer or packet to this client instance. Let
+        //the reactor thread cancel timers and remove handlers so
+        //nothing is dispatched to members after they're destroyed
+        m_reactor_closed.acquire();
+    }
 
     {
         //guard needed for disconnect since Logout and LeaveChannel are called
@@ -126,6 +148,11 @@ ClientNode::~ClientNode()
         CloseSoundDuplexDevices();
     }
 
+    //a shared reactor keeps running so wait for notifications
+    //queued to 'm_packethandler' before it's destroyed
+    if(!m_own_reactor)
+        ReactorPool::FlushNotifications(m_reactor);
+
     audiomuxer().StopThread();
 
     AUDIOCONTAINER::instance()->ReleaseAllAudio(m_soundprop.soundgroupid);
@@ -158,34 +185,23 @@ int ClientNode::svc(void)
     return 0;
 }
 
-void ClientNode::SuspendEventHandling()
+int ClientNode::handle_exception(ACE_HANDLE fd)
 {
-    if(this->thr_count())
-    {
-        m_reactor.end_reactor_event_loop();
-        MYTRACE( (ACE_TEXT("ClientNode reactor thread suspended.\n")) );
-    }
-}
+    ASSERT_REACTOR_THREAD(m_reactor);
 
-void ClientNode::ResumeEventHandling()
-{
-    if(this->thr_count() == 0)
     {
-        ACE_thread_t thr_id = 0;
-        m_reactor.owner(&thr_id);
-        TTASSERT(thr_id != ACE_OS::thr_self());
-
-        MYTRACE( (ACE_TEXT("ClientNode reactor thread waiting.\n")) );
-        if(thr_id != ACE_OS::thr_self())
-            this->wait();
-        MYTRACE( (ACE_TEXT("ClientNode reactor thread activating.\n")) );
-        m_reactor.reset_reactor_event_loop();
-        int ret = this->activate();
-        assert(ret >= 0);
-        MYTRACE( (ACE_TEXT("ClientNode reactor thread activated.\n")) );
+        GUARD_REACTOR(this);
+        Disconnect();
     }
+    m_reactor_closed.release();
+    return 0;
 }
 
+//NOTE: on a shared reactor this lock is shared by all client
+//instances on the reactor's thread. A lock per instance would
+//deadlock since the reactor thread holds the reactor's lock while
+//dispatching and calls from the application thread, e.g.
+//StartTimer(), need it too.
 ACE_Lock& ClientNode::reactor_lock()
 {
     // char name[100] = "";
@@ -254,6 +270,10 @@ bool ClientNode::GetClientStatistics(ClientStats& stats)
         else
             m_clientstats.tcp_ping_dirty = true;
 
+        stats.voicecapture_overruns = m_voice_thread.GetOverruns();
+        stats.voiceframes_suppressed = m_voice_thread.GetFramesSuppressed();
+        stats.max_payload_size = m_mtu_max_payload_size;
+
         return true;
     }
     return false;
@@ -609,6 +629,9 @@ int ClientNode::TimerEvent(ACE_UINT32 timer_event_id, long userdata)
     case TIMER_QUERY_MTU_ID :
         ret = Timer_QueryMTU(userdata);
         break;
+    case TIMER_VERIFY_MTU_ID :
+        ret = Timer_VerifyMTU();
+        break;
     case USER_TIMER_VOICE_PLAYBACK_ID :
     {
         clientuser_t user = GetUser(userid);
@@ -809,6 +832,9 @@ int ClientNode::Timer_OneSecond()
         }
     }
 
+    SendVideoFeedback();
+    UpdateVideoRate();
+
     return 0;
 }
 
@@ -917,8 +943,7 @@ int ClientNode::Timer_DesktopPacketRTX()
     TTASSERT(!m_desktop_tx.null());
     if(!m_desktop_tx.null())
     {
-        ACE_Time_Value rtx_timeout(DESKTOP_DEFAULT_RTX_TIMEOUT);
-            /*GetDesktopPacketRTxTimeout(m_clientstats.udpping_time);*/
+        ACE_Time_Value rtx_timeout = m_desktop_tx->GetRTxTimeout();
         desktoppackets_t rtx_packets;
         m_desktop_tx->GetLostDesktopPackets(rtx_timeout, rtx_packets, 1);
         desktoppackets_t::iterator dpi = rtx_packets.begin();
@@ -967,6 +992,7 @@ int ClientNode::Timer_QueryMTU(int mtu_index)
     if(m_mtu_packets.size() >= MTU_QUERY_RETRY_COUNT)
     {
         m_mtu_packets.clear();
+        MTUQueryCompleted();
         //MTU query failed
         if(mtu_index == 0)
             m_listener->OnMTUQueryComplete(0);
@@ -990,6 +1016,70 @@ int ClientNode::Timer_QueryMTU(int mtu_index)
     return 0;
 }
 
+int ClientNode::Timer_VerifyMTU()
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    TTASSERT(m_mtu_data_size > MAX_PAYLOAD_DATA_SIZE);
+
+    if(!m_mtu_verify_packet.null() && ++m_mtu_verify_lost >= MTU_VERIFY_LOSS_COUNT)
+    {
+        MYTRACE(ACE_TEXT("Payload size %d no longer reaches server, falling back to %d\n"),
+                m_mtu_data_size, MAX_PAYLOAD_DATA_SIZE);
+
+        m_mtu_verify_packet = ka_mtu_packet_t();
+        m_mtu_data_size = MAX_PAYLOAD_DATA_SIZE;
+        m_mtu_max_payload_size = MAX_PACKET_PAYLOAD_SIZE;
+        //don't grow again in this session
+        m_mtu_query_max = MAX_PAYLOAD_DATA_SIZE;
+        //desktop session was created with the larger payload size
+        if(!m_desktop.null())
+            m_desktop_restart = true;
+
+        //server uses the payload size when forwarding our desktop
+        KeepAlivePacket ka_pkt(GetUserID(), GETTIMESTAMP(), m_mtu_data_size);
+        SendPacket(ka_pkt, m_serverinfo.udpaddr);
+
+        m_listener->OnMTUQueryComplete(m_mtu_max_payload_size);
+        return -1;
+    }
+
+    KeepAlivePacket* ka_pkt;
+    ACE_NEW_RETURN(ka_pkt, KeepAlivePacket(GetUserID(), GETTIMESTAMP(),
+                                           m_mtu_data_size), 0);
+    m_mtu_verify_packet = ka_mtu_packet_t(ka_pkt);
+    SendPacket(*m_mtu_verify_packet, m_serverinfo.udpaddr);
+
+    return 0;
+}
+
+void ClientNode::MTUQueryCompleted()
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    //a payload size above the default was only verified by a single
+    //packet so keep checking that it reaches the server
+    if(m_mtu_data_size > MAX_PAYLOAD_DATA_SIZE)
+    {
+        m_mtu_verify_packet = ka_mtu_packet_t();
+        m_mtu_verify_lost = 0;
+        StartTimer(TIMER_VERIFY_MTU_ID, 0, CLIENT_VERIFY_MTU_INTERVAL,
+                   CLIENT_VERIFY_MTU_INTERVAL);
+    }
+}
+
+void ClientNode::ResetMTU()
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    m_mtu_packets.clear();
+    m_mtu_verify_packet = ka_mtu_packet_t();
+    m_mtu_verify_lost = 0;
+    m_mtu_data_size = MAX_PAYLOAD_DATA_SIZE;
+    m_mtu_max_payload_size = MAX_PACKET_PAYLOAD_SIZE;
+    m_mtu_query_max = MTU_QUERY_SIZES[MTU_QUERY_SIZES_COUNT-1];
+}
+
 void ClientNode::RecreateUdpSocket()
 {
     ASSERT_REACTOR_LOCKED(this);
@@ -1061,26 +1151,28 @@ void ClientNode::OpenAudioCapture(const AudioCodec& codec)
     bool b;
     if(m_flags & CLIENT_SNDINOUTPUT_DUPLEX)
     {
-        DeviceInfo dev;
-        SOUNDSYSTEM->GetDevice(m_soundprop.outputdeviceid, dev);
-        assert(dev.SupportsOutputFormat(output_channels, input_samplerate));
-        if(!dev.SupportsOutputFormat(output_channels, input_samplerate))
+#if defined(ENABLE_SPEEX)
+        //echo cancel at the shared sample rate of the duplex stream
+        //so the output reference doesn't have to be resampled
+        wguard_t ge(m_echo_lock);
+        if(m_echo_canceller.Open(input_samplerate, input_channels,
+                                 output_channels, input_samples))
         {
-            m_playback_resampler = MakeAudioResampler(output_channels,
-                                                      input_samplerate, //sample rate shared in dpx mode
-                                                      codec_channels,
-                                                      codec_samplerate);
-
-            if(m_playback_resampler.null())
+            m_echo_buffer.resize(input_samples * input_channels);
+            ge.release();
+            if(!UpdateSoundInputPreprocess())
             {
-                m_playback_resampler.reset();
-                m_listener->OnInternalError(TT_INTERR_SNDOUTPUT_FAILURE,
-                                            ACE_TEXT("Cannot create resampler for sound output device"));
-                return;
+                m_listener->OnInternalError(TT_INTERR_AUDIOCONFIG_INIT_FAILED,
+                                            GetErrorDescription(TT_INTERR_AUDIOCONFIG_INIT_FAILED));
             }
-
-            m_playback_buffer.resize(codec_samples * codec_channels);
         }
+        else
+        {
+            ge.release();
+            m_listener->OnInternalError(TT_INTERR_AUDIOCONFIG_INIT_FAILED,
+                                        GetErrorDescription(TT_INTERR_AUDIOCONFIG_INIT_FAILED));
+        }
+#endif
 
         b = SOUNDSYSTEM->OpenDuplexStream(this, m_soundprop.inputdeviceid,
                                         m_soundprop.outputdeviceid,
@@ -1093,6 +1185,7 @@ void ClientNode::OpenAudioCapture(const AudioCodec& codec)
                                        m_soundprop.soundgroupid,
                                        input_samplerate, input_channels, 
                                        input_samples);
+    m_soundprop.capture_active = b;
     if(!b)
     {
         if(m_listener)
@@ -1112,18 +1205,25 @@ void ClientNode::CloseAudioCapture()
     else
         SOUNDSYSTEM->CloseInputStream(this);
 #endif
+    //AudioThread may still be processing captured frames
+    rguard_t g_snd(lock_sndprop());
     audiomuxer().QueueUserAudio(MUX_MYSELF_USERID, NULL, 
                                 m_soundprop.samples_transmitted, true,
                                 0, 0);
     m_soundprop.samples_transmitted = 0;
     m_soundprop.samples_recorded = 0;
+    m_soundprop.capture_active = false;
+    g_snd.release();
 
     //clear capture resampler if initiated (in duplex mode)
     m_capture_resampler.reset();
     m_capture_buffer.clear();
-    //clear playback resampler if initiated (in duplex mode)
-    m_playback_resampler.reset();
-    m_playback_buffer.clear();
+#if defined(ENABLE_SPEEX)
+    //clear echo canceller if initiated (in duplex mode)
+    wguard_t ge(m_echo_lock);
+    m_echo_canceller.Close();
+    m_echo_buffer.clear();
+#endif
 }
 
 bool ClientNode::UpdateSoundInputPreprocess()
@@ -1161,14 +1261,16 @@ bool ClientNode::UpdateSoundInputPreprocess()
     ret &= m_voice_thread.m_preprocess_left.SetDenoiseLevel(m_soundprop.speexdsp.maxnoisesuppressdb);
     ret &= (channels == 1 || m_voice_thread.m_preprocess_right.SetDenoiseLevel(m_soundprop.speexdsp.maxnoisesuppressdb));
 
-    //set AEC
-    ret &= m_voice_thread.m_preprocess_left.EnableEchoCancel(m_soundprop.speexdsp.enable_aec);
-    ret &= (channels == 1 || m_voice_thread.m_preprocess_right.EnableEchoCancel(m_soundprop.speexdsp.enable_aec));
-
-    ret &= m_voice_thread.m_preprocess_left.SetEchoSuppressLevel(m_soundprop.speexdsp.aec_suppress_level);
-    ret &= (channels == 1 || m_voice_thread.m_preprocess_right.SetEchoSuppressLevel(m_soundprop.speexdsp.aec_suppress_level));
-    ret &= m_voice_thread.m_preprocess_left.SetEchoSuppressActive(m_soundprop.speexdsp.aec_suppress_active);
-    ret &= (channels == 1 || m_voice_thread.m_preprocess_right.SetEchoSuppressActive(m_soundprop.speexdsp.aec_suppress_active));
+    //set AEC. Only available in duplex mode where echo cancellation
+    //is done at the sound device's sample rate
+    wguard_t ge(m_echo_lock);
+    if(m_echo_canceller.IsOpen())
+    {
+        ret &= m_echo_canceller.EnableEchoCancel(m_soundprop.speexdsp.enable_aec);
+        ret &= m_echo_canceller.SetEchoSuppressLevel(m_soundprop.speexdsp.aec_suppress_level);
+        ret &= m_echo_canceller.SetEchoSuppressActive(m_soundprop.speexdsp.aec_suppress_active);
+    }
+    ge.release();
 
     //set dereverb
     m_voice_thread.m_preprocess_left.EnableDereverb(m_soundprop.dereverb);
@@ -1198,7 +1300,19 @@ void ClientNode::QueueAudioFrame(const media::AudioFrame& audframe)
 {
     TTASSERT(audframe.userdata == STREAMTYPE_VOICE);
 
+    //muxing and recording is done by AudioThread in
+    //CapturedAudioFrame() so the capture callback never blocks
     m_voice_thread.QueueAudio(audframe);
+}
+
+void ClientNode::CapturedAudioFrame(const media::AudioFrame& audframe)
+{
+    TTASSERT(audframe.userdata == STREAMTYPE_VOICE);
+
+    rguard_t g_snd(lock_sndprop());
+
+    if(!m_soundprop.capture_active)
+        return;
 
     if((m_flags & CLIENT_TX_VOICE) ||
        ((m_flags & CLIENT_SNDINPUT_VOICEACTIVATED) && 
@@ -1216,7 +1330,7 @@ void ClientNode::QueueAudioFrame(const media::AudioFrame& audframe)
                                     m_soundprop.samples_transmitted, true,
                                     0, 0);
 
-    if(AUDIOCONTAINER::instance()->AddAudio(m_soundprop.soundgroupid,
+    if(AUDIOCONTAINER::instance()->AddAudio(audframe.soundgrpid,
                                             0, STREAMTYPE_VOICE,
                                             m_voice_stream_id, 
                                             audframe.input_samplerate,
@@ -1384,7 +1498,9 @@ void ClientNode::EncodedAudioFrame(const teamtalk::AudioCodec& codec,
 void ClientNode::StreamCaptureCb(const soundsystem::InputStreamer& streamer,
                                  const short* buffer, int n_samples)
 {
-    rguard_t g_snd(lock_sndprop());
+    // Don't lock sound properties here since the capture callback
+    // must never block. Capture resampler and voice encoder are only
+    // changed while the sound input stream is closed.
 
     int codec_samplerate = GetAudioCodecSampleRate(m_voice_thread.codec());
     int codec_samples = GetAudioCodecCbSamples(m_voice_thread.codec());
@@ -1397,11 +1513,7 @@ void ClientNode::StreamCaptureCb(const soundsystem::InputStreamer& streamer,
         int ret = m_capture_resampler->Resample(buffer, n_samples, 
                                                 &m_capture_buffer[0],
                                                 codec_samples);
-        assert(ret > 0);
-        assert(ret <= codec_samples);
-        MYTRACE_COND(ret != codec_samples,
-                     ACE_TEXT("Resampler output incorrect no. samples, expect %d, got %d\n"),
-                     codec_samples, ret);
+        assert(ret == codec_samples);
         capture_buffer = &m_capture_buffer[0];
     }
     else
@@ -1424,47 +1536,39 @@ void ClientNode::StreamDuplexEchoCb(const soundsystem::DuplexStreamer& streamer,
                                     const short* input_buffer, 
                                     const short* prev_output_buffer, int n_samples)
 {
-    rguard_t g_snd(lock_sndprop());
+    // See StreamCaptureCb() for why sound properties are not locked
 
     int codec_samplerate = GetAudioCodecSampleRate(m_voice_thread.codec());
     int codec_samples = GetAudioCodecCbSamples(m_voice_thread.codec());
     int codec_channels = GetAudioCodecChannels(m_voice_thread.codec());
 
-    const short* capture_buffer = NULL;
+    const short* capture_buffer = input_buffer;
+#if defined(ENABLE_SPEEX)
+    // 'prev_output_buffer' is what was played by the sound device so
+    // echo cancellation is done before resampling. If the echo
+    // canceller is being reconfigured then skip it instead of waiting.
+    if(m_echo_lock.tryacquire() == 0)
+    {
+        if(m_echo_canceller.IsEchoCancel())
+        {
+            m_echo_canceller.Process(input_buffer, prev_output_buffer,
+                                     &m_echo_buffer[0]);
+            capture_buffer = &m_echo_buffer[0];
+        }
+        m_echo_lock.release();
+    }
+#endif
+
     if(!m_capture_resampler.null())
     {
         assert((int)m_capture_buffer.size() == codec_samples * codec_channels);
-        int ret = m_capture_resampler->Resample(input_buffer, n_samples, 
+        int ret = m_capture_resampler->Resample(capture_buffer, n_samples, 
                                                 &m_capture_buffer[0],
                                                 codec_samples);
-        assert(ret > 0);
-        assert(ret <= codec_samples);
-        MYTRACE_COND(ret != codec_samples,
-                     ACE_TEXT("Resampler output incorrect no. samples, expect %d, got %d\n"),
-                     codec_samples, ret);
+        assert(ret == codec_samples);
 
         capture_buffer = &m_capture_buffer[0];
     }
-    else
-        capture_buffer = input_buffer;
-
-    const short* playback_buffer = NULL;
-    if(!m_playback_resampler.null())
-    {
-        assert((int)m_playback_buffer.size() == codec_samples * codec_channels);
-        int ret = m_playback_resampler->Resample(prev_output_buffer, n_samples, 
-                                                 &m_playback_buffer[0],
-                                                 codec_samples);
-        assert(ret>0);
-        assert(ret <= codec_samples);
-        MYTRACE_COND(ret != codec_samples,
-                     ACE_TEXT("Resampler output incorrect no. samples, expect %d, got %d\n"),
-                     codec_samples, ret);
-
-        playback_buffer = &m_playback_buffer[0];
-    }
-    else
-        playback_buffer = prev_output_buffer;
 
     AudioFrame audframe;
     audframe.force_enc = (m_flags & CLIENT_TX_VOICE);
@@ -1474,10 +1578,6 @@ void ClientNode::StreamDuplexEchoCb(const soundsystem::DuplexStreamer& streamer,
     audframe.input_buffer = const_cast<short*>(capture_buffer);
     audframe.input_samples = codec_samples;
     audframe.input_samplerate = codec_samplerate;
-    audframe.output_channels = codec_channels;
-    audframe.output_buffer = playback_buffer;
-    audframe.output_samples = codec_samples;
-    audframe.output_samplerate = codec_samplerate;
     audframe.userdata = STREAMTYPE_VOICE;
 
     QueueAudioFrame(audframe);
@@ -1658,6 +1758,31 @@ void ClientNode::ReceivedPacket(const char* packet_data, int packet_size,
     if(!packet.ValidatePacket())
         return;
 
+    if(packet.GetKind() == PACKET_KIND_CONTAINER)
+    {
+        ContainerPacket container(packet_data, packet_size);
+        std::vector<iovec> packets = container.GetPackets();
+        for(size_t i=0;i<packets.size();i++)
+        {
+            const char* data = reinterpret_cast<const char*>(packets[i].iov_base);
+            FieldPacket p(data, uint16_t(packets[i].iov_len));
+            //containers cannot be nested
+            if(p.ValidatePacket() && p.GetKind() != PACKET_KIND_CONTAINER)
+                DispatchPacket(data, int(packets[i].iov_len), addr);
+        }
+        return;
+    }
+
+    DispatchPacket(packet_data, packet_size, addr);
+}
+
+void ClientNode::DispatchPacket(const char* packet_data, int packet_size,
+                                const ACE_INET_Addr& addr)
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    FieldPacket packet(packet_data, packet_size);
+
     clientuser_t user = GetUser(packet.GetSrcUserID());
 
     switch(packet.GetKind())
@@ -1932,6 +2057,26 @@ void ClientNode::ReceivedPacket(const char* packet_data, int packet_size,
         m_clientstats.desktopbytes_recv += packet_size;
     }
     break;
+#ifdef ENABLE_ENCRYPTION
+    case PACKET_KIND_VIDEOFEEDBACK_CRYPT :
+    {
+        CryptVideoFeedbackPacket crypt_pkt(packet_data, packet_size);
+        VideoFeedbackPacket* decrypt_pkt = crypt_pkt.Decrypt(chan->GetEncryptKey());
+        if(!decrypt_pkt)
+            return;
+        packet_ptr_t ptr(decrypt_pkt);
+        ReceivedVideoFeedbackPacket(*decrypt_pkt);
+        m_clientstats.vidcapbytes_recv += packet_size;
+    }
+    break;
+#endif
+    case PACKET_KIND_VIDEOFEEDBACK :
+    {
+        VideoFeedbackPacket fb_pkt(packet_data, packet_size);
+        ReceivedVideoFeedbackPacket(fb_pkt);
+        m_clientstats.vidcapbytes_recv += packet_size;
+    }
+    break;
     default :
         MYTRACE_COND(user.get(),
                      ACE_TEXT("Received unknown packet type %d from #%d, %s\n"), 
@@ -1995,6 +2140,15 @@ void ClientNode::ReceivedKeepAliveReplyPacket(const KeepAlivePacket& packet,
     m_clientstats.udpping_time = GETTIMESTAMP() - packet.GetTime();
     m_clientstats.udp_ping_dirty = false;
 
+    //this is a reply to a verification of the current payload size
+    if(!m_mtu_verify_packet.null() &&
+       m_mtu_verify_packet->GetTime() == packet.GetTime())
+    {
+        m_mtu_verify_packet = ka_mtu_packet_t();
+        m_mtu_verify_lost = 0;
+        return;
+    }
+
     //this is a reply to a MTU query
     mtu_packets_t::iterator ii = m_mtu_packets.find(packet.GetTime());
     if(ii != m_mtu_packets.end())
@@ -2011,7 +2165,7 @@ void ClientNode::ReceivedKeepAliveReplyPacket(const KeepAlivePacket& packet,
         m_mtu_data_size = payload_size;
         m_mtu_max_payload_size = m_mtu_data_size + FIELDHEADER_PAYLOAD;
 
-        if(payload_size < MTU_QUERY_SIZES[MTU_QUERY_SIZES_COUNT-1])
+        if(payload_size < m_mtu_query_max)
         {
             size_t i;
             for(i=1;i<MTU_QUERY_SIZES_COUNT;i++)
@@ -2024,6 +2178,7 @@ void ClientNode::ReceivedKeepAliveReplyPacket(const KeepAlivePacket& packet,
         }
         else
         {
+            MTUQueryCompleted();
             m_listener->OnMTUQueryComplete(m_mtu_max_payload_size);
         }
     }
@@ -2109,6 +2264,19 @@ void ClientNode::ReceivedDesktopNakPacket(const DesktopNakPacket& nak_pkt)
 {
     ASSERT_REACTOR_THREAD(m_reactor);
 
+    //server evicted our desktop session from its cache and needs a
+    //new session for the users who haven't received it
+    if(nak_pkt.GetSrcUserID() == GetUserID())
+    {
+        if(!m_desktop.null() && m_desktop->GetSessionID() == nak_pkt.GetSessionID())
+        {
+            MYTRACE(ACE_TEXT("Server requested new desktop session to replace %d\n"),
+                    nak_pkt.GetSessionID());
+            m_desktop_restart = true;
+        }
+        return;
+    }
+
     clientuser_t user = GetUser(nak_pkt.GetSrcUserID());
     MYTRACE_COND(user.null(), ACE_TEXT("Asked to delete desktop session #%d ")
                  ACE_TEXT("from user who doesn't exist\n"), nak_pkt.GetSessionID());
@@ -2250,12 +2418,86 @@ void ClientNode::ReceivedDesktopInputAckPacket(const DesktopInputAckPacket& ack_
     }
 }
 
+void ClientNode::ReceivedVideoFeedbackPacket(const VideoFeedbackPacket& fb_pkt)
+{
+    ASSERT_REACTOR_THREAD(m_reactor);
+
+    if(fb_pkt.GetDestUserID() != m_myuserid ||
+       (m_flags & CLIENT_TX_VIDEOCAPTURE) == 0)
+        return;
+
+    VideoFeedback fb;
+    if(!fb_pkt.GetFeedback(fb) || fb.stream_id != m_vidcap_stream_id)
+        return;
+
+    //'echo_time' is the time stamp we put in the video packet
+    ACE_UINT32 now = GETTIMESTAMP();
+    int rtt = int(now - fb.echo_time) - fb.echo_delay;
+    m_vidcap_ratectrl.ReceiverReport(fb_pkt.GetSrcUserID(), now,
+                                     fb.frames_recv, fb.frames_lost,
+                                     rtt >= 0? rtt : -1, fb.keyframe_request);
+}
+
+void ClientNode::SendVideoFeedback()
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    if(m_mychannel.null())
+        return;
+
+    const ClientChannel::users_t& users = m_mychannel->GetUsers();
+    for(size_t i=0;i<users.size();i++)
+    {
+        if(users[i]->GetUserID() == m_myuserid)
+            continue;
+
+        VideoFeedback fb;
+        if(!users[i]->GetVideoCaptureFeedback(fb))
+            continue;
+
+        VideoFeedbackPacket* fb_pkt;
+        ACE_NEW_NORETURN(fb_pkt, VideoFeedbackPacket(m_myuserid, GETTIMESTAMP(), fb));
+        if(!fb_pkt)
+            break;
+        fb_pkt->SetChannel(m_mychannel->GetChannelID());
+        fb_pkt->SetDestUser(users[i]->GetUserID());
+        if(!QueuePacket(fb_pkt))
+            delete fb_pkt;
+    }
+}
+
+void ClientNode::UpdateVideoRate()
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    if((m_flags & CLIENT_TX_VIDEOCAPTURE) == 0 ||
+       m_vidcap_thread.GetCodec().codec != CODEC_WEBM_VP8)
+        return;
+
+    //server's video limit is shared by everyone receiving our video
+    int receivers = 0;
+    if(!m_mychannel.null())
+        receivers = m_mychannel->GetUsersCount() - 1;
+    m_vidcap_ratectrl.SetTxLimit(m_serverinfo.videotxlimit, receivers);
+    m_vidcap_ratectrl.LocalFramesDropped(m_vidcap_thread.GetQueueDrops(true));
+
+    VideoRateTarget target = m_vidcap_ratectrl.Update(GETTIMESTAMP());
+    m_vidcap_thread.SetEncoderTarget(target.bitrate, target.fps, target.keyframe);
+
+    MYTRACE_COND(target.keyframe, ACE_TEXT("Video capture key frame requested, %d kbit/s, %d fps\n"),
+                 target.bitrate, target.fps);
+}
+
 void ClientNode::SendPackets()
 {
     ASSERT_REACTOR_THREAD(m_reactor);
 
     GUARD_REACTOR(this);
 
+    //packets which are queued at the same time go in the same
+    //datagram if the server supports it
+    m_tx_bundling = m_serverinfo.packetprotocol >= TEAMTALK_CONTAINER_PACKET_PROTOCOL;
+
     int ret;
     FieldPacket* p;
     while( (p = m_tx_queue.GetNextPacket()) )
@@ -2594,26 +2836,124 @@ void ClientNode::SendPackets()
             }
         }
         break;
+        case PACKET_KIND_VIDEOFEEDBACK :
+        {
+            VideoFeedbackPacket* fb_pkt = dynamic_cast<VideoFeedbackPacket*>(p);
+            TTASSERT(fb_pkt);
+            TTASSERT(fb_pkt->Finalized());
+
+#ifdef ENABLE_ENCRYPTION
+            if(m_crypt_stream)
+            {
+                clientchannel_t chan = GetChannel(fb_pkt->GetChannel());
+                if(chan.null())
+                    break;
+                CryptVideoFeedbackPacket crypt_pkt(*fb_pkt, chan->GetEncryptKey());
+                ret = SendPacket(crypt_pkt, m_serverinfo.udpaddr);
+                TTASSERT(crypt_pkt.ValidatePacket());
+            }
+            else
+#endif
+            {
+                ret = SendPacket(*fb_pkt, m_serverinfo.udpaddr);
+                TTASSERT(fb_pkt->ValidatePacket());
+            }
+        }
+        break;
         default :
             TTASSERT(0);
             ret = SendPacket(*p, m_serverinfo.udpaddr);
         }
     }
     ACE_UNUSED_ARG(ret);
+
+    SendBundledPackets();
+    m_tx_bundling = false;
+}
+
+bool ClientNode::BundlePacket(const FieldPacket& packet)
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    //a packet which cannot share a datagram with a packet of the same
+    //size is sent as it is. Bundled packets go first to keep order.
+    uint16_t max_packet_size = m_mtu_max_payload_size;
+    if(packet.GetPacketSize() > max_packet_size / 2)
+    {
+        SendBundledPackets();
+        return false;
+    }
+
+    if(m_tx_container &&
+       !m_tx_container->AddPacket(packet, max_packet_size))
+        SendBundledPackets();
+
+    if(!m_tx_container)
+    {
+        m_tx_container.reset(new ContainerPacket(m_myuserid, GETTIMESTAMP()));
+        if(!m_tx_container->AddPacket(packet, max_packet_size))
+        {
+            m_tx_container.reset();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ClientNode::SendBundledPackets()
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    if(!m_tx_container)
+        return;
+
+    container_packet_t container;
+    container.swap(m_tx_container);
+
+    ssize_t ret;
+    if(container->GetPacketCount() == 1)
+    {
+        //a single packet is sent without the container header
+        std::vector<iovec> packets = container->GetPackets();
+        TTASSERT(packets.size() == 1);
+        ret = m_packethandler.sock_i().send(&packets[0], 1, m_serverinfo.udpaddr);
+    }
+    else
+    {
+        int buffers;
+        const iovec* vv = container->GetPacket(buffers);
+        ret = m_packethandler.sock_i().send(vv, buffers, m_serverinfo.udpaddr);
+        //the contained packets were counted by SendPacket()
+        if(ret > 0)
+            m_clientstats.udpbytes_sent += TT_CHANNEL_HEADER_SIZE +
+                FIELDVALUE_PREFIX * container->GetPacketCount();
+    }
+
+    MYTRACE_COND(ret <= 0, ACE_TEXT("Failed to send %d bundled packets of size %d\n"),
+                 container->GetPacketCount(), (int)container->GetPacketSize());
 }
 
 bool ClientNode::QueuePacket(FieldPacket* packet)
 {
-    bool b = m_tx_queue.QueuePacket(packet) >= 0;
+    int ret = m_tx_queue.QueuePacket(packet);
 
-    MYTRACE_COND(!b, ACE_TEXT("Failed to queue packet kind %d to channel %d\n"),
+    MYTRACE_COND(ret < 0 && packet, ACE_TEXT("Failed to queue packet kind %d to channel %d\n"),
                  (int)packet->GetKind(), (int)packet->GetChannel());
 
-    ACE_Time_Value tv;
-    int ret = m_reactor.notify(&m_packethandler, 
+    //only wake up the reactor if it's not already about to send
+    if(ret > 0)
+    {
+        ACE_Time_Value tv;
+        ret = m_reactor.notify(&m_packethandler, 
                                ACE_Event_Handler::WRITE_MASK, &tv);
-    TTASSERT(ret>=0);
-    return b;
+        TTASSERT(ret>=0);
+        //packet stays queued but the next packet must notify the
+        //reactor again, otherwise the queue is never drained
+        if(ret < 0)
+            m_tx_queue.NotifyFailed();
+        return true;
+    }
+    return ret >= 0;
 }
 
 //Send packet to address
@@ -2628,9 +2968,15 @@ int ClientNode::SendPacket(const FieldPacket& packet, const ACE_INET_Addr& addr)
 #endif
 
     //normal send without encryption
-    int buffers;
-    const iovec* vv = packet.GetPacket(buffers);
-    ssize_t ret = m_packethandler.sock_i().send(vv, buffers, addr);
+    ssize_t ret;
+    if(m_tx_bundling && addr == m_serverinfo.udpaddr && BundlePacket(packet))
+        ret = packet.GetPacketSize();
+    else
+    {
+        int buffers;
+        const iovec* vv = packet.GetPacket(buffers);
+        ret = m_packethandler.sock_i().send(vv, buffers, addr);
+    }
     if(ret>0)
     {
         switch(packet.GetKind())
@@ -2654,6 +3000,8 @@ int ClientNode::SendPacket(const FieldPacket& packet, const ACE_INET_Addr& addr)
             TTASSERT(m_def_stream); //sending unencrypted
 #endif
         case PACKET_KIND_VIDEO_CRYPT :
+        case PACKET_KIND_VIDEOFEEDBACK :
+        case PACKET_KIND_VIDEOFEEDBACK_CRYPT :
             m_clientstats.vidcapbytes_sent += ret; break;
         case PACKET_KIND_MEDIAFILE_AUDIO :
 #ifdef ENABLE_ENCRYPTION
@@ -3037,6 +3385,10 @@ bool ClientNode::StartMTUQuery()
         return false;
 
     m_mtu_packets.clear();
+    m_mtu_query_max = MTU_QUERY_SIZES[MTU_QUERY_SIZES_COUNT-1];
+    if(TimerExists(TIMER_VERIFY_MTU_ID))
+        StopTimer(TIMER_VERIFY_MTU_ID);
+    m_mtu_verify_packet = ka_mtu_packet_t();
 
     return StartTimer(TIMER_QUERY_MTU_ID, 0, ACE_Time_Value::zero,
                       CLIENT_QUERY_MTU_INTERVAL)>=0;
@@ -3232,6 +3584,14 @@ bool ClientNode::OpenVideoCaptureSession(const VideoCodec& codec)
     }
     GEN_NEXT_ID(m_vidcap_stream_id);
 
+    if(codec.codec == CODEC_WEBM_VP8)
+    {
+        int fps = 1;
+        if(cap_format.fps_denominator)
+            fps = cap_format.fps_numerator / cap_format.fps_denominator;
+        m_vidcap_ratectrl.Reset(codec.webm_vp8.rc_target_bitrate, fps);
+    }
+
     m_flags |= CLIENT_TX_VIDEOCAPTURE;
 
     return true;
@@ -3255,7 +3615,24 @@ ACE_Message_Block* ClientNode::AcquireVideoCaptureFrame()
 
     ACE_Message_Block* mb = NULL;
     ACE_Time_Value tm_zero;
-    m_local_vidcapframes.dequeue(mb, &tm_zero);
+    if(m_local_vidcapframes.dequeue(mb, &tm_zero) < 0)
+        return NULL;
+
+    //local video frames are kept in the capture format so only
+    //convert to RGB32 when the frame is actually requested
+    const VideoFrame* vid = reinterpret_cast<const VideoFrame*>(mb->rd_ptr());
+    if(vid->fourcc == FOURCC_I420)
+    {
+        VideoFrame rgb_frame = *vid;
+        rgb_frame.fourcc = FOURCC_RGB32;
+        rgb_frame.frame_length = RGB32_BYTES(vid->width, vid->height);
+        rgb_frame.top_down = true;
+        ACE_Message_Block* mb_rgb = VideoFrameInMsgBlock(rgb_frame);
+        if(mb_rgb)
+            I420ToRGB32(vid->frame, vid->width, vid->height, rgb_frame.frame);
+        mb->release();
+        mb = mb_rgb;
+    }
     return mb;
 }
 
@@ -3270,8 +3647,8 @@ bool ClientNode::EncodedVideoFrame(const VideoThread* video_encoder,
         if(enc_data)
         {
             //max supported is uint16 * MAX_PAYLOAD_SIZE
-            uint16_t w = (uint16_t)video_encoder->GetVideoFormat().width;
-            uint16_t h = (uint16_t)video_encoder->GetVideoFormat().height;
+            uint16_t w = (uint16_t)video_encoder->GetEncodeFormat().width;
+            uint16_t h = (uint16_t)video_encoder->GetEncodeFormat().height;
             videopackets_t packets = BuildVideoPackets(PACKET_KIND_MEDIAFILE_VIDEO,
                                                        m_myuserid, timestamp,
                                                        m_mtu_data_size,
@@ -3303,8 +3680,8 @@ bool ClientNode::EncodedVideoFrame(const VideoThread* video_encoder,
         if(enc_data && (m_flags & CLIENT_AUTHORIZED) &&
            (m_flags & CLIENT_TX_VIDEOCAPTURE))
         {
-            uint16_t w = (uint16_t)video_encoder->GetVideoFormat().width;
-            uint16_t h = (uint16_t)video_encoder->GetVideoFormat().height;
+            uint16_t w = (uint16_t)video_encoder->GetEncodeFormat().width;
+            uint16_t h = (uint16_t)video_encoder->GetEncodeFormat().height;
             //max supported is uint16 * MAX_PAYLOAD_SIZE
             videopackets_t packets = BuildVideoPackets(PACKET_KIND_VIDEO,
                                                        m_myuserid, timestamp,
@@ -3351,9 +3728,9 @@ bool ClientNode::EncodedVideoFrame(const VideoThread* video_encoder,
 
 int ClientNode::SendDesktopWindow(int width, int height, RGBMode rgb,
                                   DesktopProtocol protocol, 
-                                  const char* bmp_buf, int bmp_buf_len)
+                                  const char* bmp_buf, int bmp_buf_len,
+                                  const desktop_rects_t* dirty_rects/* = NULL*/)
 {
-    ACE_UNUSED_ARG(protocol);
     ASSERT_REACTOR_LOCKED(this);
 
     if(m_mychannel.null() ||
@@ -3363,21 +3740,32 @@ int ClientNode::SendDesktopWindow(int width, int height, RGBMode rgb,
     if(!m_mychannel->CanTransmit(m_myuserid, STREAMTYPE_DESKTOP))
         return -1;
 
+    //both protocols produce a zlib stream so viewers decode either
+    if(protocol != DESKTOPPROTOCOL_ZLIB_FAST)
+        protocol = DESKTOPPROTOCOL_ZLIB_1;
+
     //start new session or update existing
     if(m_desktop.null() || m_desktop->GetWidth() != width ||
-       m_desktop->GetHeight() != height || m_desktop->GetRGBMode() != rgb)
+       m_desktop->GetHeight() != height || m_desktop->GetRGBMode() != rgb ||
+       m_desktop->GetDesktopProtocol() != protocol || m_desktop_restart)
     {
         CloseDesktopSession(true);
+        m_desktop_restart = false;
 
         GEN_NEXT_ID(m_desktop_session_id);
 
         DesktopWindow new_wnd(m_desktop_session_id, width, height, rgb, 
-                              DESKTOPPROTOCOL_ZLIB_1);
+                              protocol);
+
+        //older servers cannot forward moved blocks
+        bool detect_moves = ProtocolSameOrLater(m_serverinfo.protocol,
+                                                TEAMTALK_PROTOCOL_DESKTOPMOVE);
 
         DesktopInitiator* desktop;
         ACE_NEW_RETURN(desktop, DesktopInitiator(GetUserID(), new_wnd,
                                                  m_mtu_data_size,
-                                                 m_mtu_max_payload_size),
+                                                 m_mtu_max_payload_size,
+                                                 detect_moves),
                                                  false);
         m_desktop = desktop_initiator_t(desktop);
 
@@ -3406,7 +3794,7 @@ int ClientNode::SendDesktopWindow(int width, int height, RGBMode rgb,
     uint32_t tm = GETTIMESTAMP();
 
     //process new bitmap
-    int ret = m_desktop->NewBitmap(bmp_buf, bmp_buf_len, tm);
+    int ret = m_desktop->NewBitmap(bmp_buf, bmp_buf_len, tm, dirty_rects);
 
     if(ret > 0)
     {
@@ -3417,6 +3805,8 @@ int ClientNode::SendDesktopWindow(int width, int height, RGBMode rgb,
             CloseDesktopSession(false);
             return -1;
         }
+        if(!m_desktop_tx.null())
+            dtx->CopyCongestionState(*m_desktop_tx);
         m_desktop_tx = desktop_transmitter_t(dtx);
 
         //TODO: find a better way to query for 'complete' instead of busy wait
@@ -3749,7 +4139,10 @@ void ClientNode::Disconnect()
 {
     ASSERT_REACTOR_LOCKED(this);
 
-    ASSERT_NOT_REACTOR_THREAD(m_reactor);
+    //a shared reactor's thread calls Disconnect() from
+    //handle_exception(), i.e. never inside a stream callback
+    if(m_own_reactor)
+        ASSERT_NOT_REACTOR_THREAD(m_reactor);
 
     while(m_timers.size())
     {
@@ -3760,6 +4153,9 @@ void ClientNode::Disconnect()
     //set latest keepalives to 0
     m_clientstats.tcp_silence_sec = m_clientstats.udp_silence_sec = 0;
 
+    //payload size must be probed again for next server
+    ResetMTU();
+
     ACE_HANDLE h = ACE_INVALID_HANDLE;
 #if defined(ENABLE_ENCRYPTION)
     if(m_crypt_stream)
@@ -5394,6 +5790,7 @@ void ClientNode::HandleServerStats(const mstrings_t& properties)
     GetProperty(properties, TT_USERSPEAK, serverstats.userspeak);
     GetProperty(properties, TT_FILESTX, serverstats.files_bytessent);
     GetProperty(properties, TT_FILESRX, serverstats.files_bytesreceived);
+    GetProperty(properties, TT_VOICESUPPRESSED, serverstats.voice_frames_suppressed);
 
     GetProperty(properties, TT_UPTIME, uptime);
     //not really stored as "start time"
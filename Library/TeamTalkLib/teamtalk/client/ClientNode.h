@@ -29,6 +29,7 @@
 #include "AudioThread.h"
 #include "FileNode.h"
 #include "VideoThread.h"
+#include "VideoRateControl.h"
 #include "VoiceLogger.h"
 #include "AudioMuxer.h"
 #include "DesktopShare.h"
@@ -42,6 +43,9 @@
 #endif
 
 #include <codec/MediaStreamer.h>
+#if defined(ENABLE_SPEEX)
+#include <codec/EchoCanceller.h>
+#endif
 
 // ACE
 #include <ace/Reactor.h>
@@ -54,6 +58,7 @@
 #include <ace/Null_Mutex.h> 
 #include <ace/Connector.h> 
 #include <ace/SString.h>
+#include <memory>
 
 #if defined(ENABLE_ENCRYPTION)
 #include <ace/SSL/SSL_SOCK_Connector.h>
@@ -72,10 +77,12 @@
 #define CLIENT_P2P_CONNECT_TIMEOUT          ACE_Time_Value(5) //Give up p2p connect after this many seconds
 #define CLIENT_DESKTOPNAK_TIMEOUT           ACE_Time_Value(4) //close a desktop session
 #define CLIENT_QUERY_MTU_INTERVAL           ACE_Time_Value(0, 500000) //time between MTU query packets
+#define CLIENT_VERIFY_MTU_INTERVAL          ACE_Time_Value(5) //time between verifying a payload size above MAX_PAYLOAD_DATA_SIZE
 #define CLIENT_DESKTOPINPUT_RTX_TIMEOUT     ACE_Time_Value(1)
 #define CLIENT_DESKTOPINPUT_ACK_DELAY       ACE_Time_Value(0, 10000)
 
 #define MTU_QUERY_RETRY_COUNT 20 //20 * 500ms = 10 seconds for MTU query (CLIENT_QUERY_MTU_INTERVAL)
+#define MTU_VERIFY_LOSS_COUNT 3 //3 * 5s = 15 seconds before falling back to MAX_PAYLOAD_DATA_SIZE (CLIENT_VERIFY_MTU_INTERVAL)
 
 #define SOUNDDEVICE_IGNORE_ID -1
 
@@ -111,6 +118,7 @@ enum ClientTimer
     TIMER_DESKTOPNAKPACKET_TIMEOUT_ID       = 9,
     TIMER_BUILD_DESKTOPPACKETS_ID           = 10,
     TIMER_QUERY_MTU_ID                      = 11,
+    TIMER_VERIFY_MTU_ID                     = 12, //check payload size above default still reaches server
 
     //User instance timers (termination not handled by ClientNode::StopTimer())
     USER_TIMER_MASK                         = 0x8000,
@@ -186,6 +194,9 @@ namespace teamtalk {
         ACE_INT64 desktopbytes_recv;
         ACE_INT32 udpping_time;
         ACE_INT32 tcpping_time;
+        ACE_UINT32 voicecapture_overruns;
+        ACE_UINT32 voiceframes_suppressed;
+        ACE_INT32 max_payload_size;
         //internal use
         ACE_UINT32 tcp_silence_sec;
         ACE_UINT32 udp_silence_sec;
@@ -201,6 +212,8 @@ namespace teamtalk {
                 mediafile_audio_bytes_sent = mediafile_audio_bytes_recv = 
                 mediafile_video_bytes_sent = mediafile_video_bytes_recv = 0;
                 udpping_time = tcpping_time = -1;
+                voicecapture_overruns = voiceframes_suppressed = 0;
+                max_payload_size = MAX_PACKET_PAYLOAD_SIZE;
                 tcp_silence_sec = udp_silence_sec = 0;
                 tcp_ping_dirty = udp_ping_dirty = true;
             }
@@ -233,6 +246,9 @@ namespace teamtalk {
         ACE_UINT32 samples_transmitted;
         //total samples recorded
         ACE_UINT32 samples_recorded;
+        //sound input stream is open. Samples queued before the stream
+        //was closed are not muxed or recorded
+        bool capture_active;
 
         SoundProperties()
         {
@@ -242,16 +258,10 @@ namespace teamtalk {
             dereverb = true;
             samples_transmitted = 0;
             samples_recorded = 0;
+            capture_active = false;
         }
     };
 
-    class EventSuspender
-    {
-    public:
-        virtual void SuspendEventHandling() = 0;
-        virtual void ResumeEventHandling() = 0;
-    };
-
     //forward decl.
     class ClientListener;
 
@@ -274,16 +284,19 @@ namespace teamtalk {
 #endif
         , public MediaStreamListener
         , public FileTransferListener
-        , public EventSuspender
     {
     public:
-        ClientNode(const ACE_TString& version, ClientListener* listener);
+        // If 'reactor' is NULL the client instance runs its own
+        // reactor thread, otherwise it's multiplexed on 'reactor',
+        // e.g. from ReactorPool.
+        ClientNode(const ACE_TString& version, ClientListener* listener,
+                   ACE_Reactor* reactor = NULL);
         virtual ~ClientNode();
 
         int svc(void);
-
-        void SuspendEventHandling();
-        void ResumeEventHandling();
+        // Notified by ~ClientNode() to tear down on the shared
+        // reactor's thread
+        int handle_exception(ACE_HANDLE fd);
 
         ACE_Lock& reactor_lock();
 #if defined(_DEBUG)
@@ -295,6 +308,10 @@ namespace teamtalk {
         ACE_Recursive_Thread_Mutex& lock_timers() { return m_timers_lock; }
         VoiceLogger& voicelogger();
         AudioMuxer& audiomuxer();
+#if defined(ENABLE_VPX)
+        WebMDecoderPool& decoderpool() { return *WEBMDECODERPOOL::instance(); }
+#endif
+        DesktopDecoderPool& desktoppool() { return m_desktop_pool; }
 
         //server properties
         bool GetServerInfo(ServerInfo& info);
@@ -376,7 +393,8 @@ namespace teamtalk {
         //returns -1 on error, 0 no changes, >0 num packets
         int SendDesktopWindow(int width, int height, RGBMode rgb, 
                               DesktopProtocol protocol, 
-                              const char* bmp_buf, int bmp_buf_len);
+                              const char* bmp_buf, int bmp_buf_len,
+                              const desktop_rects_t* dirty_rects = NULL);
         bool CloseDesktopWindow();
         bool SendDesktopCursor(int x, int y);
         bool SendDesktopInput(int userid,
@@ -423,6 +441,7 @@ namespace teamtalk {
                                const char* enc_data, int enc_length,
                                const std::vector<int>& enc_frame_sizes,
                                const media::AudioFrame& org_frame);
+        void CapturedAudioFrame(const media::AudioFrame& audframe);
         //VideoEncListener - separate thread
         bool EncodedVideoFrame(const VideoThread* video_encoder,
                                ACE_Message_Block* org_frame,
@@ -566,6 +585,9 @@ namespace teamtalk {
         int Timer_DesktopPacketRTX();
         int Timer_DesktopNAKPacket();
         int Timer_QueryMTU(int mtu_index);
+        int Timer_VerifyMTU();
+        void MTUQueryCompleted();
+        void ResetMTU();
 
         //audio start/stop/update
         void OpenAudioCapture(const AudioCodec& codec);
@@ -575,7 +597,13 @@ namespace teamtalk {
 
         void SendVoicePacket(const VoicePacket& packet);
         void SendAudioFilePacket(const AudioFilePacket& packet);
+        //bundle packets sent by SendPackets() in PACKET_KIND_CONTAINER
+        bool BundlePacket(const FieldPacket& packet);
+        void SendBundledPackets();
 
+        //handle packet which is not a container
+        void DispatchPacket(const char* packet_data, int packet_size,
+                            const ACE_INET_Addr& addr);
         void ReceivedHelloAckPacket(const HelloPacket& packet,
                                     const ACE_INET_Addr& addr); //called when ACK packet is received from server
         void ReceivedKeepAliveReplyPacket(const KeepAlivePacket& packet,
@@ -588,13 +616,22 @@ namespace teamtalk {
         void ReceivedDesktopCursorPacket(const DesktopCursorPacket& csr_pkt);
         void ReceivedDesktopInputPacket(const DesktopInputPacket& csr_pkt);
         void ReceivedDesktopInputAckPacket(const DesktopInputAckPacket& ack_pkt);
+        void ReceivedVideoFeedbackPacket(const VideoFeedbackPacket& fb_pkt);
         void SendDesktopAckPacket(int userid);
+        //receiver reports and rate control of video capture, see Timer_OneSecond()
+        void SendVideoFeedback();
+        void UpdateVideoRate();
         void CloseDesktopSession(bool stop_nak_timer);
 
         void ResetAudioPlayers();
 
+        //reactor owned by this client instance if not shared
+        std::unique_ptr<ACE_Reactor> m_own_reactor;
         //the reactor associated with this client instance
-        ACE_Reactor m_reactor;
+        ACE_Reactor& m_reactor;
+        //released by handle_exception() when shared reactor is done
+        //with this client instance
+        ACE_Semaphore m_reactor_closed;
         ClientFlags m_flags; //Mask of ClientFlag-enum
         //set of timers currently in use. Protected by lock_timers().
         timer_handlers_t m_timers;
@@ -645,9 +682,13 @@ namespace teamtalk {
         //audio resampler for capture
         audio_resampler_t m_capture_resampler;
         std::vector<short> m_capture_buffer;
-        //audio resampler for playback (in duplex mode)
-        audio_resampler_t m_playback_resampler;
-        std::vector<short> m_playback_buffer;
+#if defined(ENABLE_SPEEX)
+        //echo cancellation at sound device's sample rate (in duplex
+        //mode). Never block on 'm_echo_lock' in duplex callback.
+        ACE_Recursive_Thread_Mutex m_echo_lock;
+        EchoCanceller m_echo_canceller;
+        std::vector<short> m_echo_buffer;
+#endif
 
         //encode voice from sound input
         AudioThread m_voice_thread;
@@ -660,6 +701,8 @@ namespace teamtalk {
         typedef std::map<int, ACE_Message_Block*> user_video_frames_t;
         user_video_frames_t m_user_vidcapframes; //cached video frames
         uint8_t m_vidcap_stream_id; //0 means not used
+        //adapts video capture encoder to receivers' feedback
+        VideoRateControl m_vidcap_ratectrl;
 
         //media streamer
         media_streamer_t m_media_streamer;
@@ -672,14 +715,22 @@ namespace teamtalk {
         //encode video of media file
         video_thread_t m_videofile_thread;
 
+        //decompress desktop blocks of remote users
+        DesktopDecoderPool m_desktop_pool;
+
         //desktop session
         desktop_initiator_t m_desktop;
         desktop_transmitter_t m_desktop_tx;
         desktop_nak_tx_t m_desktop_nak_tx;
         uint8_t m_desktop_session_id;
+        //server evicted desktop session so start a new session
+        bool m_desktop_restart;
 
         //UDP packets waiting for transmission
         PacketQueue m_tx_queue;
+        //packets bundled while SendPackets() drains 'm_tx_queue'
+        container_packet_t m_tx_container;
+        bool m_tx_bundling;
 
         //unique IDs for Do* commands
         uint16_t m_cmdid_counter; 
@@ -692,6 +743,11 @@ namespace teamtalk {
         typedef std::map<uint32_t, ka_mtu_packet_t> mtu_packets_t;
         mtu_packets_t m_mtu_packets;
         uint16_t m_mtu_data_size, m_mtu_max_payload_size;
+        //largest size in MTU_QUERY_SIZES to probe in this session
+        uint16_t m_mtu_query_max;
+        //outstanding verification of a payload size above the default
+        ka_mtu_packet_t m_mtu_verify_packet;
+        int m_mtu_verify_lost;
 
         //the client's version number
         ACE_TString m_version;
@@ -706,8 +762,6 @@ namespace teamtalk {
     public:
         virtual ~ClientListener() {}
 
-        virtual void RegisterEventSuspender(EventSuspender* suspender) = 0;
-
         virtual void OnConnectSuccess() = 0;
         virtual void OnConnectFailed() = 0;
         virtual void OnConnectionLost() = 0;
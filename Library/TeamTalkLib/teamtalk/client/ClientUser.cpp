@@ -28,6 +28,8 @@
 #include <teamtalk/Commands.h>
 #include <teamtalk/CodecCommon.h>
 
+#include <algorithm>
+
 #if defined(ENABLE_SOUNDSYSTEM)
 using namespace soundsystem;
 #endif
@@ -50,6 +52,9 @@ ClientUser::ClientUser(int userid, ClientNode* clientnode,
                        , m_userdata(0)
                        , m_voice_active(false)
                        , m_voice_buf_msec(VOICE_BUFFER_MSEC)
+#if defined(ENABLE_VPX)
+                       , m_vidcap_feedback_rx(0)
+#endif
                        , m_audiofile_active(false)
                        , m_media_buf_msec(MEDIAFILE_BUFFER_MSEC)
                        , m_desktop_packets_expected(0)
@@ -138,6 +143,9 @@ int ClientUser::TimerMonitorVoicePlayback()
     int n_blocks = m_voice_player->GetNumAudioBlocks(true);
     m_stats.voicepackets_recv += m_voice_player->GetNumAudioPacketsRecv(true);
     m_stats.voicepackets_lost += m_voice_player->GetNumAudioPacketsLost(true);
+    m_stats.voicepackets_late += m_voice_player->GetNumAudioPacketsLate(true);
+    m_stats.voiceframes_concealed += m_voice_player->GetNumAudioFramesConcealed(true);
+    m_stats.voice_jitter_msec = m_voice_player->GetJitterMSec();
 
     //MYTRACE_COND(n_blocks, ACE_TEXT("User #%d has %d new voice block at %u\n"), GetUserID(), n_blocks, GETTIMESTAMP());
     while(n_blocks--)
@@ -171,6 +179,9 @@ int ClientUser::TimerMonitorAudioFilePlayback()
     int n_blocks = m_audiofile_player->GetNumAudioBlocks(true);
     m_stats.mediafile_audiopackets_recv += m_audiofile_player->GetNumAudioPacketsRecv(true);
     m_stats.mediafile_audiopackets_lost += m_audiofile_player->GetNumAudioPacketsLost(true);
+    m_stats.mediafile_audiopackets_late += m_audiofile_player->GetNumAudioPacketsLate(true);
+    m_stats.mediafile_audioframes_concealed += m_audiofile_player->GetNumAudioFramesConcealed(true);
+    m_stats.mediafile_audio_jitter_msec = m_audiofile_player->GetJitterMSec();
 
     while(n_blocks--)
         m_listener->OnUserAudioBlock(GetUserID(), STREAMTYPE_MEDIAFILE_AUDIO);
@@ -368,6 +379,8 @@ void ClientUser::AddVideoCapturePacket(const VideoCapturePacket& p,
         WebMPlayer* webm_player;
         ACE_NEW(webm_player, WebMPlayer(GetUserID(), p.GetStreamID()));
         m_vidcap_player = webm_player_t(webm_player);
+        m_vidcap_feedback = VideoFeedback();
+        m_vidcap_feedback.stream_id = p.GetStreamID();
         new_vidframe = m_vidcap_player->AddPacket(p);
         m_listener->OnUserStateChange(*this);
     }
@@ -377,12 +390,28 @@ void ClientUser::AddVideoCapturePacket(const VideoCapturePacket& p,
     }
 
     if(new_vidframe)
+    {
+        m_clientnode->decoderpool().QueueDecode(m_vidcap_player);
         m_listener->OnUserVideoCaptureFrame(GetUserID(), p.GetStreamID());
+    }
 
+    int frames_recv = m_vidcap_player->GetVideoFramesRecv(true);
+    int frames_lost = m_vidcap_player->GetVideoFramesLost(true);
     m_stats.vidcappackets_recv += m_vidcap_player->GetVideoPacketRecv(true);
-    m_stats.vidcapframes_recv += m_vidcap_player->GetVideoFramesRecv(true);
+    m_stats.vidcapframes_recv += frames_recv;
     m_stats.vidcapframes_dropped += m_vidcap_player->GetVideoFramesDropped(true);
-    m_stats.vidcapframes_lost += m_vidcap_player->GetVideoFramesLost(true);
+    m_stats.vidcapframes_skipped += m_vidcap_player->GetVideoFramesSkipped(true);
+    m_stats.vidcapframes_lost += frames_lost;
+
+    m_vidcap_feedback.frames_recv = uint16_t(std::min(0xFFFF, m_vidcap_feedback.frames_recv + frames_recv));
+    m_vidcap_feedback.frames_lost = uint16_t(std::min(0xFFFF, m_vidcap_feedback.frames_lost + frames_lost));
+    if(frames_lost)
+        m_vidcap_feedback.keyframe_request = true;
+    if(m_vidcap_feedback_rx == 0 || W32_GT(p.GetTime(), m_vidcap_feedback.echo_time))
+    {
+        m_vidcap_feedback.echo_time = p.GetTime();
+        m_vidcap_feedback_rx = GETTIMESTAMP();
+    }
 #endif
 }
 
@@ -438,6 +467,8 @@ void ClientUser::AddVideoFilePacket(const VideoFilePacket& p,
 
     if(new_vidframe)
     {
+        m_clientnode->decoderpool().QueueDecode(m_videofile_player);
+
         if(!m_audiofile_player.null() && 
            GetAudioStreamBufferSize(STREAMTYPE_MEDIAFILE_AUDIO))
         {
@@ -459,6 +490,7 @@ void ClientUser::AddVideoFilePacket(const VideoFilePacket& p,
     m_stats.mediafile_video_packets_recv += m_videofile_player->GetVideoPacketRecv(true);
     m_stats.mediafile_video_frames_recv += m_videofile_player->GetVideoFramesRecv(true);
     m_stats.mediafile_video_frames_dropped += m_videofile_player->GetVideoFramesDropped(true);
+    m_stats.mediafile_video_frames_skipped += m_videofile_player->GetVideoFramesSkipped(true);
     m_stats.mediafile_video_frames_lost += m_videofile_player->GetVideoFramesLost(true);
 #endif
 }
@@ -576,6 +608,10 @@ void ClientUser::AddPacket(const DesktopPacket& p, const ClientChannel& chan)
     if(m_acked_desktoppackets.find(pkt_index) != m_acked_desktoppackets.end())
         return;
 
+    //block moves are in every packet of an update and must be
+    //processed before any block of the update is written
+    bool first_packet = m_acked_desktoppackets.empty();
+
     m_acked_desktoppackets.insert(pkt_index);
 
     TTASSERT(m_desktop_packets_expected == pkt_count);
@@ -585,12 +621,19 @@ void ClientUser::AddPacket(const DesktopPacket& p, const ClientChannel& chan)
 
     bool updated_window = block_nums.size();
 
+    block_moves_t moves;
+    if(first_packet && p.GetBlockMoves(moves))
+    {
+        m_desktop->QueueMoveBlocks(moves);
+        updated_window = true;
+    }
+
     //process complete blocks
     map_block_t::const_iterator ii = block_nums.begin();
     while(ii != block_nums.end())
     {
-        m_desktop->AddCompressedBlock(ii->first, ii->second.block_data, 
-                                      ii->second.block_size);
+        m_desktop->QueueCompressedBlock(ii->first, ii->second.block_data, 
+                                        ii->second.block_size);
         ii++;
     }
 
@@ -636,7 +679,7 @@ void ClientUser::AddPacket(const DesktopPacket& p, const ClientChannel& chan)
         map_blocks_t::iterator bi = blocks.begin();
         while(bi != blocks.end())
         {
-            m_desktop->AddCompressedBlock(bi->first, &bi->second[0], 
+            m_desktop->QueueCompressedBlock(bi->first, &bi->second[0], 
                 int(bi->second.size()));
             bi++;
         }
@@ -653,7 +696,7 @@ void ClientUser::AddPacket(const DesktopPacket& p, const ClientChannel& chan)
         {
             set<uint16_t>::iterator si = dbi->second.begin();
             for(;si!=dbi->second.end();si++)
-                m_desktop->AddDuplicateBlock(dbi->first, *si);
+                m_desktop->QueueDuplicateBlock(dbi->first, *si);
         }
         m_dup_blocks.clear();
     }
@@ -668,6 +711,9 @@ void ClientUser::AddPacket(const DesktopPacket& p, const ClientChannel& chan)
         ACE_TEXT("Desktop update for #%d update id %d:%u\n"), GetUserID(), 
         m_desktop->GetSessionID(), GetLastTimeStamp(p));
 
+    //blocks are decompressed on a worker thread
+    m_clientnode->desktoppool().QueueDecode(m_desktop);
+
     if(updated_window)
         m_listener->OnUserDesktopWindow(GetUserID(), m_desktop->GetSessionID());
 }
@@ -1328,7 +1374,11 @@ ACE_Message_Block* ClientUser::GetVideoCaptureFrame()
 
         //    return m_vidcap_player->GetNextFrame();
         //}
-        return m_vidcap_player->GetNextFrame();
+        webm_player_t player = m_vidcap_player;
+        ACE_Message_Block* mb = player->GetNextFrame();
+        //keep decoding ahead
+        m_clientnode->decoderpool().QueueDecode(player);
+        return mb;
     }
 #endif /* ENABLE_VPX */
     return NULL;
@@ -1352,6 +1402,8 @@ void ClientUser::CloseVideoCapturePlayer()
     //notify that we're closing video player
     bool notify = !m_vidcap_player.null();
     m_vidcap_player.reset();
+    m_vidcap_feedback = VideoFeedback();
+    m_vidcap_feedback_rx = 0;
 
     if(notify)
     {
@@ -1361,18 +1413,45 @@ void ClientUser::CloseVideoCapturePlayer()
 #endif
 }
 
+bool ClientUser::GetVideoCaptureFeedback(VideoFeedback& feedback)
+{
+#if defined(ENABLE_VPX)
+    if(m_vidcap_player.null() || m_vidcap_feedback_rx == 0)
+        return false;
+
+    feedback = m_vidcap_feedback;
+    ACE_UINT32 held = GETTIMESTAMP() - m_vidcap_feedback_rx;
+    feedback.echo_delay = uint16_t(held > 0xFFFF? 0xFFFF : held);
+
+    uint8_t stream_id = m_vidcap_feedback.stream_id;
+    m_vidcap_feedback = VideoFeedback();
+    m_vidcap_feedback.stream_id = stream_id;
+    m_vidcap_feedback.echo_time = feedback.echo_time;
+    m_vidcap_feedback_rx = 0;
+    return true;
+#else
+    return false;
+#endif
+}
+
 ACE_Message_Block* ClientUser::GetVideoFileFrame()
 {
 #if defined(ENABLE_VPX)
     if(!m_videofile_player.null())
     {
+        webm_player_t player = m_videofile_player;
+        ACE_Message_Block* mb;
         if(!m_audiofile_player.null() && GetAudioStreamBufferSize(STREAMTYPE_MEDIAFILE_AUDIO) &&
            m_audiofile_player->GetPlayedPacketNo())
         {
             uint32_t audio_tm = m_audiofile_player->GetPlayedPacketTime();
-            return m_videofile_player->GetNextFrame(&audio_tm);
+            mb = player->GetNextFrame(&audio_tm);
         }
-        return m_videofile_player->GetNextFrame();
+        else
+            mb = player->GetNextFrame();
+        //keep decoding ahead
+        m_clientnode->decoderpool().QueueDecode(player);
+        return mb;
     }
 #endif /* ENABLE_VPX */
 
@@ -1425,6 +1504,9 @@ bool ClientUser::GetDesktopWindow(char* buffer, int length)
     if(m_desktop.null())
         return false;
 
+    m_desktop->DecodeBlocks();
+
+    wguard_t g(m_desktop->lock());
     int bmp_size = 0;
     const char* bmp = m_desktop->GetBitmap(&bmp_size);
     TTASSERT(length == bmp_size);
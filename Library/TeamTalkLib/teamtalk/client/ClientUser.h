@@ -55,6 +55,7 @@ namespace teamtalk {
         ACE_INT64 vidcapframes_recv;
         ACE_INT64 vidcapframes_lost;
         ACE_INT64 vidcapframes_dropped;
+        ACE_INT64 vidcapframes_skipped;
 
         ACE_INT64 mediafile_audiopackets_recv;
         ACE_INT64 mediafile_audiopackets_lost;
@@ -63,6 +64,14 @@ namespace teamtalk {
         ACE_INT64 mediafile_video_frames_recv;
         ACE_INT64 mediafile_video_frames_lost;
         ACE_INT64 mediafile_video_frames_dropped;
+        ACE_INT64 mediafile_video_frames_skipped;
+
+        ACE_INT64 voicepackets_late;
+        ACE_INT64 voiceframes_concealed;
+        ACE_INT64 mediafile_audiopackets_late;
+        ACE_INT64 mediafile_audioframes_concealed;
+        int voice_jitter_msec;
+        int mediafile_audio_jitter_msec;
 
         ClientUserStats() 
             : voicepackets_recv(0)
@@ -71,12 +80,20 @@ namespace teamtalk {
             , vidcapframes_recv(0)
             , vidcapframes_lost(0)
             , vidcapframes_dropped(0)
+            , vidcapframes_skipped(0)
             , mediafile_audiopackets_recv(0)
             , mediafile_audiopackets_lost(0)
             , mediafile_video_packets_recv(0)
             , mediafile_video_frames_recv(0)
             , mediafile_video_frames_lost(0)
             , mediafile_video_frames_dropped(0)
+            , mediafile_video_frames_skipped(0)
+            , voicepackets_late(0)
+            , voiceframes_concealed(0)
+            , mediafile_audiopackets_late(0)
+            , mediafile_audioframes_concealed(0)
+            , voice_jitter_msec(0)
+            , mediafile_audio_jitter_msec(0)
         {}
     };
 
@@ -157,6 +174,9 @@ namespace teamtalk {
         ACE_Message_Block* GetVideoCaptureFrame();
         bool GetVideoCaptureCodec(VideoCodec& codec) const;
         void CloseVideoCapturePlayer();
+        //receiver report for user's video capture stream since
+        //previous call. False if nothing has been received.
+        bool GetVideoCaptureFeedback(VideoFeedback& feedback);
 
         ACE_Message_Block* GetVideoFileFrame();
         bool GetVideoFileCodec(VideoCodec& codec) const;
@@ -225,6 +245,9 @@ namespace teamtalk {
         //video playback
 #if defined(ENABLE_VPX)
         webm_player_t m_vidcap_player;
+        //receiver report for 'm_vidcap_player'
+        VideoFeedback m_vidcap_feedback;
+        uint32_t m_vidcap_feedback_rx; //time newest packet was received
 #endif
 
         //audio file playback
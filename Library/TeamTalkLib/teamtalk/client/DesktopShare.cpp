@@ -31,21 +31,37 @@
 #include <ace/FILE_Addr.h>
 
 #include <zlib.h>
+#include <algorithm>
 
 using namespace std;
 using namespace teamtalk;
 
 #define DEFAULT_COLOR 127
 
+//don't spawn a compressor thread for less than this number of dirty blocks
+#define COMPRESS_BLOCKS_PER_THREAD 32
+#define COMPRESS_THREADS_MAX 4
+//a block never exceeds BLOCK_MAX_BYTESIZE so a 4 KB window is enough
+#define COMPRESS_WINDOW_BITS 12
+//max grid rectangles of moved blocks in an update (repeated in every packet)
+#define BLOCK_MOVES_MAX 16
+//don't try a line as source of a move if it is this common, e.g. blank lines
+#define MOVE_CANDIDATES_MAX 32
+#define DECODER_THREADS_MAX 2
+
 DesktopInitiator::DesktopInitiator(int userid, const DesktopWindow& wnd,
                                    uint16_t max_chunk_size, 
-                                   uint16_t max_payload_size)
+                                   uint16_t max_payload_size,
+                                   bool detect_moves/* = false*/)
 : DesktopSession(wnd)
 , m_userid(userid)
 , m_newsession(true)
 , m_abort(false)
 , m_max_chunk_size(max_chunk_size)
 , m_max_payload_size(max_payload_size)
+, m_compress_index(0)
+, m_compress_threads(0)
+, m_detect_moves(detect_moves)
 {
 }
 
@@ -55,7 +71,8 @@ DesktopInitiator::~DesktopInitiator()
     MYTRACE(ACE_TEXT("DesktopInitiator::~DesktopInitiator()\n"));
 }
 
-int DesktopInitiator::NewBitmap(const char* bmp_bits, int size, uint32_t tm)
+int DesktopInitiator::NewBitmap(const char* bmp_bits, int size, uint32_t tm,
+                                const desktop_rects_t* dirty_rects/* = NULL*/)
 {
     TTASSERT(this->thr_count() == 0);
 
@@ -74,6 +91,34 @@ int DesktopInitiator::NewBitmap(const char* bmp_bits, int size, uint32_t tm)
 
     TTASSERT(m_dirty_blocknums.empty());
 
+    bool first_bmp = (int)m_blocks.size() != GetBlocksCount();
+
+    //only blocks intersecting 'dirty_rects' can have changed. The
+    //first bitmap has to be scanned entirely.
+    std::vector<bool> scan_blocks;
+    if(dirty_rects && !first_bmp)
+    {
+        scan_blocks.resize(GetBlocksCount(), false);
+        for(size_t r=0;r<dirty_rects->size();r++)
+        {
+            const DesktopRect& rect = (*dirty_rects)[r];
+            int x1 = std::max(rect.x, 0), y1 = std::max(rect.y, 0);
+            int x2 = std::min(rect.x + rect.width, GetWidth());
+            int y2 = std::min(rect.y + rect.height, GetHeight());
+            if(x1 >= x2 || y1 >= y2)
+                continue;
+
+            for(int h=y1 / m_block_height;h<=(y2-1) / m_block_height;h++)
+            {
+                for(int w=x1 / m_block_width;w<=(x2-1) / m_block_width;w++)
+                    scan_blocks[w + h * m_w_blocks] = true;
+            }
+        }
+    }
+
+    //first line which differs from previous bitmap (same index as block)
+    std::vector<int> first_lines(GetBlocksCount(), -1);
+
     for(int h=0;h<m_h_blocks;h++)
     {
         int height = (h == m_h_blocks-1 && (GetHeight() % m_block_height))? GetHeight() % m_block_height : m_block_height;
@@ -82,39 +127,72 @@ int DesktopInitiator::NewBitmap(const char* bmp_bits, int size, uint32_t tm)
         {
             int width = (w == m_w_blocks-1 && (GetWidth() % m_block_width))? GetWidth() % m_block_width : m_block_width;
 
-            if((int)m_tmp_block.size() != width * height * m_pixel_size)
-            {
-                char def_color = DEFAULT_COLOR;
-                m_tmp_block.resize(width * height * m_pixel_size, def_color);
-            }
+            const int BLOCK_INDEX = w + h * m_w_blocks;
+            if(scan_blocks.size() && !scan_blocks[BLOCK_INDEX])
+                continue;
+
+            const int line_size = width * m_pixel_size;
+            const std::vector<char>& block = m_blocks[BLOCK_INDEX];
+            int first_line = (int)block.size() != line_size * height? 0 : -1;
 
-            for(int i=0;i<height;i++)
+            //compare with previous bitmap line by line
+            for(int i=0;i<height && first_line < 0;i++)
             {
                 int pixel_x = w * m_block_width;
                 int pixel_y = h * m_block_height + i;
                 TTASSERT(pixel_x < GetWidth());
                 TTASSERT(pixel_y < GetHeight());
 
-                int byte_pos = (pixel_x + pixel_y * GetWidth()) * m_pixel_size;
-                byte_pos += GetHeight() * m_padding;
+                int byte_pos = GetPixelOffset(pixel_x, pixel_y);
                 TTASSERT(byte_pos < size);
-                const char* byte_pos_ptr = &bmp_bits[byte_pos];
-                memcpy(&m_tmp_block[width*i*m_pixel_size], byte_pos_ptr, width * m_pixel_size);
+                if(memcmp(&block[line_size * i], &bmp_bits[byte_pos], line_size))
+                    first_line = i;
             }
 
-            const int BLOCK_INDEX = w + h * m_w_blocks;
-
-            ACE_UINT32 crc = ACE::crc32(&m_tmp_block[0], m_tmp_block.size());
-            
-            //only replace if it's different
-            map_blocks_t::iterator ii = m_blocks.find(BLOCK_INDEX);
-            if(ii == m_blocks.end() || crc != m_block_crcs[BLOCK_INDEX]/*ii->second != m_tmp_block*/)
+            if(first_line >= 0)
             {
-                m_blocks[BLOCK_INDEX].swap(m_tmp_block);
                 m_dirty_blocknums.insert(BLOCK_INDEX);
+                first_lines[BLOCK_INDEX] = first_line;
             }
         }
     }
+
+    //the line and column hashes of the dirty blocks must be compared
+    //to the previous bitmap before they're replaced
+    m_moved_blocks.clear();
+    m_moves.clear();
+    if(m_detect_moves)
+    {
+        std::vector<uint32_t> line_crcs(m_line_crcs), column_hashes(m_column_hashes);
+        line_crcs.resize(GetHeight() * m_w_blocks);
+        column_hashes.resize(m_h_blocks * GetWidth());
+
+        std::set<uint16_t>::const_iterator di = m_dirty_blocknums.begin();
+        for(;di!=m_dirty_blocknums.end();di++)
+            UpdateBlockHashes(bmp_bits, *di, line_crcs, column_hashes);
+
+        if(!first_bmp && m_dirty_blocknums.size())
+            DetectMovedBlocks(bmp_bits, line_crcs, column_hashes);
+
+        m_line_crcs.swap(line_crcs);
+        m_column_hashes.swap(column_hashes);
+    }
+
+    //copy dirty lines to blocks
+    std::set<uint16_t>::const_iterator di = m_dirty_blocknums.begin();
+    for(;di!=m_dirty_blocknums.end();di++)
+    {
+        DesktopRect rect = GetBlockRect(*di);
+        const int line_size = rect.width * m_pixel_size;
+        std::vector<char>& block = m_blocks[*di];
+        block.resize(line_size * rect.height);
+        for(int i=first_lines[*di];i<rect.height;i++)
+        {
+            memcpy(&block[line_size * i],
+                   &bmp_bits[GetPixelOffset(rect.x, rect.y + i)], line_size);
+        }
+    }
+
     TTASSERT(m_w_blocks*m_h_blocks == (int)m_blocks.size());
     TTASSERT(m_abort == false);
 
@@ -126,11 +204,31 @@ int DesktopInitiator::NewBitmap(const char* bmp_bits, int size, uint32_t tm)
     {
         uint32_t tmp = m_timestamp;
         m_timestamp = tm;
-        
+
+        //dirty blocks are claimed by compressor threads in block
+        //order and stored at the same index so packets are built
+        //in block order no matter which thread compressed them.
+        //Moved blocks are not sent so they're not compressed.
+        m_compress_blocknums.clear();
+        for(di=m_dirty_blocknums.begin();di!=m_dirty_blocknums.end();di++)
+        {
+            if(m_moved_blocks.find(*di) == m_moved_blocks.end())
+                m_compress_blocknums.push_back(*di);
+        }
+        int n_compress = int(m_compress_blocknums.size());
+        m_compressed.clear();
+        m_compressed.resize(n_compress);
+        m_compress_index = 0;
+
+        int n_threads = (n_compress + COMPRESS_BLOCKS_PER_THREAD - 1) / COMPRESS_BLOCKS_PER_THREAD;
+        n_threads = std::min(n_threads, ACE_OS::num_processors_online());
+        n_threads = std::max(1, std::min(n_threads, COMPRESS_THREADS_MAX));
+        m_compress_threads = n_threads;
+
         // ensure thread is shut down properly before activating next one
         this->wait();
 
-        if(this->activate() < 0)
+        if(this->activate(THR_NEW_LWP | THR_JOINABLE | THR_INHERIT_SCHED, n_threads) < 0)
         {
             m_timestamp = tmp;
             return -1;
@@ -162,20 +260,45 @@ int DesktopInitiator::svc(void)
     TTASSERT(m_dirty_blocknums.size());
     TTASSERT(m_desktop_packets.empty());
 
-    //compressed dirty blocks
-    map_blocks_t dirty_blocks;
+    CompressDirtyBlocks();
+
+    //last compressor thread to finish builds the desktop packets
+    if(--m_compress_threads > 0)
+        return 0;
 
-    CompressDirtyBlocks(dirty_blocks);
     if(m_abort)
         return 0;
 
+    BuildPackets();
+    return 0;
+}
+
+void DesktopInitiator::BuildPackets()
+{
+    //compressed dirty blocks
+    map_blocks_t dirty_blocks;
+    for(size_t i=0;i<m_compress_blocknums.size();i++)
+    {
+        if(m_compressed[i].size())
+            dirty_blocks[m_compress_blocknums[i]].swap(m_compressed[i]);
+    }
+    m_compress_blocknums.clear();
+    m_compressed.clear();
+
     //update CRC values
     UpdateBlocksCRC(m_blocks, m_dirty_blocknums, m_block_crcs, m_crc_blocks);
 
-    //process duplicate blocks
+    //process duplicate blocks (moved blocks are neither sent nor duplicated)
+    set<uint16_t> send_blocknums;
+    set<uint16_t>::const_iterator di = m_dirty_blocknums.begin();
+    for(;di!=m_dirty_blocknums.end();di++)
+    {
+        if(m_moved_blocks.find(*di) == m_moved_blocks.end())
+            send_blocknums.insert(*di);
+    }
     map_dup_blocks_t dups;
     set<uint16_t> ignore_blocks;
-    DuplicateBlocks(m_dirty_blocknums, m_block_crcs,
+    DuplicateBlocks(send_blocknums, m_block_crcs,
                     m_crc_blocks, dups, ignore_blocks);
     
     m_dirty_blocknums.clear();
@@ -184,44 +307,245 @@ int DesktopInitiator::svc(void)
                                             m_timestamp, m_max_chunk_size,
                                             m_max_payload_size, 
                                             GetDesktopWindow(),
-                                            dirty_blocks, dups, NULL, &ignore_blocks);
+                                            dirty_blocks, dups, NULL, &ignore_blocks,
+                                            &m_moves);
     m_newsession = false;
     TTASSERT(m_desktop_packets.size());
-    return 0;
 }
 
-void DesktopInitiator::CompressDirtyBlocks(map_blocks_t& blocks)
+void DesktopInitiator::UpdateBlockHashes(const char* bmp_bits, int block_no,
+                                         std::vector<uint32_t>& line_crcs,
+                                         std::vector<uint32_t>& column_hashes) const
 {
-    std::set<uint16_t>::iterator ii=m_dirty_blocknums.begin();
-    while(ii != m_dirty_blocknums.end() && !m_abort)
+    DesktopRect rect = GetBlockRect(block_no);
+    const int line_size = rect.width * m_pixel_size;
+    const int block_row = block_no / m_w_blocks, block_col = block_no % m_w_blocks;
+
+    //FNV-1a of each pixel column is updated line by line
+    uint32_t* hashes = &column_hashes[block_row * GetWidth() + rect.x];
+    for(int x=0;x<rect.width;x++)
+        hashes[x] = 2166136261U;
+
+    for(int i=0;i<rect.height;i++)
     {
-        blocks[*ii] = vector<char>(BLOCK_MAX_BYTESIZE);
-        if(!CompressBlock(*ii, blocks[*ii]))
-            blocks.erase(*ii);
-        ii++;
+        const char* line = &bmp_bits[GetPixelOffset(rect.x, rect.y + i)];
+        line_crcs[(rect.y + i) * m_w_blocks + block_col] = BlockCRC32C(line, line_size);
+
+        const uint8_t* pixel = reinterpret_cast<const uint8_t*>(line);
+        for(int x=0;x<rect.width;x++)
+        {
+            for(int b=0;b<m_pixel_size;b++)
+                hashes[x] = (hashes[x] ^ *pixel++) * 16777619U;
+        }
     }
 }
 
-bool DesktopInitiator::CompressBlock(int block_no, std::vector<char>& outbuf)
+void DesktopInitiator::DetectMovedBlocks(const char* bmp_bits,
+                                         const std::vector<uint32_t>& line_crcs,
+                                         const std::vector<uint32_t>& column_hashes)
 {
-    map_blocks_t::iterator ii = m_blocks.find(block_no);
-    if(ii == m_blocks.end())
-        return false;
+    //line CRC -> lines (of a block column) and column hash -> columns
+    //(of a block row) in previous bitmap. Built when needed.
+    typedef std::map< uint32_t, std::vector<int> > map_hash_positions_t;
+    std::map<int, map_hash_positions_t> block_col_lines, block_row_columns;
 
-    int ret;
-    bool success;
+    //blocks usually move by the same offset as the previous block
+    int last_dy = 0, last_dx = 0;
 
-    z_stream strm = {Z_NULL};
+    map_block_offsets_t moved_blocks;
+    std::set<uint16_t>::const_iterator di = m_dirty_blocknums.begin();
+    for(;di!=m_dirty_blocknums.end() && !m_abort;di++)
+    {
+        const DesktopRect rect = GetBlockRect(*di);
+        const int block_row = *di / m_w_blocks, block_col = *di % m_w_blocks;
+        bool found = false;
 
+        //vertical move, i.e. lines of the same block column
+        if(block_col_lines.find(block_col) == block_col_lines.end())
+        {
+            map_hash_positions_t& lines = block_col_lines[block_col];
+            for(int y=0;y<GetHeight();y++)
+                lines[m_line_crcs[y * m_w_blocks + block_col]].push_back(y);
+        }
+        const map_hash_positions_t& lines = block_col_lines[block_col];
+
+        //use the least common line of the block to find candidates
+        const std::vector<int>* candidates = NULL;
+        int candidate_line = 0;
+        for(int i=0;i<rect.height;i++)
+        {
+            map_hash_positions_t::const_iterator li =
+                lines.find(line_crcs[(rect.y + i) * m_w_blocks + block_col]);
+            if(li == lines.end())
+            {
+                candidates = NULL;
+                break;
+            }
+            if(!candidates || li->second.size() < candidates->size())
+            {
+                candidates = &li->second;
+                candidate_line = i;
+            }
+        }
+
+        std::vector<int> offsets;
+        if(candidates && candidates->size() <= MOVE_CANDIDATES_MAX)
+        {
+            offsets.push_back(last_dy);
+            for(size_t c=0;c<candidates->size();c++)
+                offsets.push_back((*candidates)[c] - (rect.y + candidate_line));
+        }
+
+        for(size_t o=0;o<offsets.size() && !found;o++)
+        {
+            int dy = offsets[o];
+            if(dy == 0 || rect.y + dy < 0 || rect.y + dy + rect.height > GetHeight())
+                continue;
+
+            int i = 0;
+            while(i < rect.height && m_line_crcs[(rect.y + dy + i) * m_w_blocks + block_col] ==
+                  line_crcs[(rect.y + i) * m_w_blocks + block_col])
+                i++;
+
+            if(i == rect.height && IsPreviousRegion(bmp_bits, rect, 0, dy))
+            {
+                moved_blocks[*di] = std::make_pair(0, dy);
+                last_dy = dy;
+                found = true;
+            }
+        }
+
+        if(found)
+            continue;
+
+        //horizontal move, i.e. columns of the same block row
+        if(block_row_columns.find(block_row) == block_row_columns.end())
+        {
+            map_hash_positions_t& columns = block_row_columns[block_row];
+            for(int x=0;x<GetWidth();x++)
+                columns[m_column_hashes[block_row * GetWidth() + x]].push_back(x);
+        }
+        const map_hash_positions_t& columns = block_row_columns[block_row];
+
+        candidates = NULL;
+        int candidate_column = 0;
+        for(int x=0;x<rect.width;x++)
+        {
+            map_hash_positions_t::const_iterator ci =
+                columns.find(column_hashes[block_row * GetWidth() + rect.x + x]);
+            if(ci == columns.end())
+            {
+                candidates = NULL;
+                break;
+            }
+            if(!candidates || ci->second.size() < candidates->size())
+            {
+                candidates = &ci->second;
+                candidate_column = x;
+            }
+        }
+
+        offsets.clear();
+        if(candidates && candidates->size() <= MOVE_CANDIDATES_MAX)
+        {
+            offsets.push_back(last_dx);
+            for(size_t c=0;c<candidates->size();c++)
+                offsets.push_back((*candidates)[c] - (rect.x + candidate_column));
+        }
+
+        for(size_t o=0;o<offsets.size() && !found;o++)
+        {
+            int dx = offsets[o];
+            if(dx == 0 || rect.x + dx < 0 || rect.x + dx + rect.width > GetWidth())
+                continue;
+
+            int x = 0;
+            while(x < rect.width && m_column_hashes[block_row * GetWidth() + rect.x + dx + x] ==
+                  column_hashes[block_row * GetWidth() + rect.x + x])
+                x++;
+
+            if(x == rect.width && IsPreviousRegion(bmp_bits, rect, dx, 0))
+            {
+                moved_blocks[*di] = std::make_pair(dx, 0);
+                last_dx = dx;
+                found = true;
+            }
+        }
+    }
+
+    if(moved_blocks.empty())
+        return;
+
+    //only the blocks covered by the largest rectangles are moved, the
+    //rest are sent as usual
+    m_moves = BuildBlockMoves(moved_blocks, m_w_blocks, BLOCK_MOVES_MAX);
+    GetMovedBlocks(m_moves, m_w_blocks, GetBlocksCount(), m_moved_blocks);
+
+    MYTRACE(ACE_TEXT("Desktop update has %u moved blocks in %u rectangles of %u dirty blocks\n"),
+            (unsigned)m_moved_blocks.size(), (unsigned)m_moves.size(),
+            (unsigned)m_dirty_blocknums.size());
+}
+
+bool DesktopInitiator::IsPreviousRegion(const char* bmp_bits,
+                                        const DesktopRect& rect,
+                                        int dx, int dy)
+{
+    DesktopRect src_rect(rect.x + dx, rect.y + dy, rect.width, rect.height);
+    if(!CopyBlocksRegion(*this, m_blocks, src_rect, m_region))
+        return false;
+
+    const int line_size = rect.width * m_pixel_size;
+    for(int i=0;i<rect.height;i++)
+    {
+        if(memcmp(&m_region[line_size * i],
+                  &bmp_bits[GetPixelOffset(rect.x, rect.y + i)], line_size))
+            return false;
+    }
+    return true;
+}
+
+void DesktopInitiator::CompressDirtyBlocks()
+{
     //Z_BEST_COMPRESSION
     //Z_DEFAULT_COMPRESSION
     //Z_BEST_SPEED
-    ret = deflateInit(&strm, Z_DEFAULT_COMPRESSION);
+    int level = Z_DEFAULT_COMPRESSION;
+    if(GetDesktopProtocol() == DESKTOPPROTOCOL_ZLIB_FAST)
+        level = Z_BEST_SPEED;
 
+    //reuse one stream per thread since deflateInit() is more
+    //expensive than compressing a block
+    z_stream strm = {Z_NULL};
+    int ret = deflateInit2(&strm, level, Z_DEFLATED, COMPRESS_WINDOW_BITS,
+                           8, Z_DEFAULT_STRATEGY);
+    assert(ret == Z_OK);
+    if(ret != Z_OK)
+        return;
+
+    int i;
+    while((i = m_compress_index++) < int(m_compress_blocknums.size()) && !m_abort)
+    {
+        std::vector<char>& outbuf = m_compressed[i];
+        outbuf.resize(BLOCK_MAX_BYTESIZE);
+        if(!CompressBlock(strm, m_compress_blocknums[i], outbuf))
+            outbuf.clear();
+    }
+
+    ret = deflateEnd(&strm);
+    assert(ret == Z_OK || ret == Z_DATA_ERROR);
+}
+
+bool DesktopInitiator::CompressBlock(z_stream_s& strm, int block_no, std::vector<char>& outbuf)
+{
+    map_blocks_t::const_iterator ii = m_blocks.find(block_no);
+    if(ii == m_blocks.end())
+        return false;
+
+    int ret = deflateReset(&strm);
     assert(ret == Z_OK);
 
     strm.avail_in = (uInt)ii->second.size();
-    strm.next_in = reinterpret_cast<Bytef*>(&ii->second[0]);
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(&ii->second[0]));
 
     strm.avail_out = (uInt)outbuf.size();
     strm.next_out = reinterpret_cast<Bytef*>(&outbuf[0]);
@@ -229,16 +553,11 @@ bool DesktopInitiator::CompressBlock(int block_no, std::vector<char>& outbuf)
     ret = deflate(&strm, Z_FINISH);
     assert(ret == Z_STREAM_END);
 
-    success = ret == Z_STREAM_END;
-
-    std::vector<char> tmp = outbuf;
+    bool success = ret == Z_STREAM_END;
 
     if(success)
         outbuf.resize(outbuf.size() - strm.avail_out);
 
-    ret = deflateEnd(&strm);
-    assert(ret == Z_OK);
-
     return success;
 }
 
@@ -246,24 +565,118 @@ bool DesktopInitiator::CompressBlock(int block_no, std::vector<char>& outbuf)
 
 DesktopViewer::DesktopViewer(const DesktopWindow& wnd)
 : DesktopSession(wnd)
+, m_decode_scheduled(false)
 {
     char gray = DEFAULT_COLOR;
     m_bitmap.assign(GetBitmapSize(), gray);
 }
 
-void DesktopViewer::AddCompressedBlock(int block_no, const char* inbuf, int in_size)
+void DesktopViewer::QueueCompressedBlock(int block_no, const char* inbuf, int in_size)
 {
     assert(block_no < m_w_blocks * m_h_blocks);
     if(block_no >= m_w_blocks * m_h_blocks)
         return;
 
-    std::vector<char> outbuf(BLOCK_MAX_BYTESIZE);
-    if(!DecompressBlock(inbuf, in_size, outbuf))
+    wguard_t g(m_mutex);
+    m_updates.push_back(block_update());
+    block_update& update = m_updates.back();
+    update.type = block_update::UPDATE_BLOCK;
+    update.block_no = block_no;
+    update.dest_block_no = 0;
+    update.compressed.assign(inbuf, inbuf + in_size);
+}
+
+void DesktopViewer::QueueDuplicateBlock(int src_block_no, int dest_block_no)
+{
+    wguard_t g(m_mutex);
+    m_updates.push_back(block_update());
+    block_update& update = m_updates.back();
+    update.type = block_update::UPDATE_DUPLICATE;
+    update.block_no = src_block_no;
+    update.dest_block_no = dest_block_no;
+}
+
+void DesktopViewer::QueueMoveBlocks(const block_moves_t& moves)
+{
+    wguard_t g(m_mutex);
+    m_updates.push_back(block_update());
+    block_update& update = m_updates.back();
+    update.type = block_update::UPDATE_MOVES;
+    update.block_no = update.dest_block_no = 0;
+    update.moves = moves;
+}
+
+bool DesktopViewer::ScheduleDecode()
+{
+    wguard_t g(m_mutex);
+
+    if(m_decode_scheduled || m_updates.empty())
+        return false;
+
+    m_decode_scheduled = true;
+    return true;
+}
+
+void DesktopViewer::CancelDecode()
+{
+    wguard_t g(m_mutex);
+    m_decode_scheduled = false;
+}
+
+void DesktopViewer::DecodeBlocks()
+{
+    wguard_t gd(m_decode_mutex);
+
+    std::vector<char> pixels;
+    while(true)
     {
-        assert(0);
-        return;
+        block_update update;
+        {
+            wguard_t g(m_mutex);
+            if(m_updates.empty())
+            {
+                m_decode_scheduled = false;
+                return;
+            }
+            update = std::move(m_updates.front());
+            m_updates.pop_front();
+        }
+
+        switch(update.type)
+        {
+        case block_update::UPDATE_BLOCK :
+        {
+            //decompress without holding 'm_mutex' so readers of the
+            //bitmap are not blocked
+            pixels.resize(BLOCK_MAX_BYTESIZE);
+            if(update.compressed.empty() ||
+               !DecompressBlock(&update.compressed[0], int(update.compressed.size()), pixels))
+            {
+                assert(0);
+                break;
+            }
+            wguard_t g(m_mutex);
+            WriteBlock(update.block_no, pixels);
+            break;
+        }
+        case block_update::UPDATE_DUPLICATE :
+        {
+            wguard_t g(m_mutex);
+            AddDuplicateBlock(update.block_no, update.dest_block_no);
+            break;
+        }
+        case block_update::UPDATE_MOVES :
+        {
+            wguard_t g(m_mutex);
+            MoveBlocks(update.moves);
+            break;
+        }
+        }
     }
+}
 
+void DesktopViewer::WriteBlock(int block_no, const std::vector<char>& pixels)
+{
     int h = block_no / m_w_blocks;
     int w = block_no - h * m_w_blocks;
 
@@ -275,6 +688,10 @@ void DesktopViewer::AddCompressedBlock(int block_no, const char* inbuf, int in_s
     int width = (w == m_w_blocks-1 && (GetWidth() % m_block_width))? 
         GetWidth() % m_block_width : m_block_width;
 
+    TTASSERT(int(pixels.size()) >= width * height * m_pixel_size);
+    if(int(pixels.size()) < width * height * m_pixel_size)
+        return;
+
     for(int i=0;i<height;i++)
     {
         int pixel_x = w * m_block_width;
@@ -284,7 +701,7 @@ void DesktopViewer::AddCompressedBlock(int block_no, const char* inbuf, int in_s
         byte_pos += GetHeight() * m_padding;
         TTASSERT(byte_pos < (int)m_bitmap.size());
         char* byte_pos_ptr = &m_bitmap[byte_pos];
-        memcpy(byte_pos_ptr, &outbuf[width*i*m_pixel_size], width * m_pixel_size);
+        memcpy(byte_pos_ptr, &pixels[width*i*m_pixel_size], width * m_pixel_size);
     }
 }
 
@@ -327,8 +744,53 @@ void DesktopViewer::AddDuplicateBlock(int src_block_no, int dest_block_no)
     }
 }
 
+bool DesktopViewer::MoveBlocks(const block_moves_t& moves)
+{
+    map_block_offsets_t moved_blocks;
+    if(!GetMovedBlocks(moves, m_w_blocks, GetBlocksCount(), moved_blocks))
+        return false;
+
+    //all moved blocks are read before any is written since they can
+    //overlap each other
+    map_blocks_t blocks;
+    map_block_offsets_t::const_iterator ii = moved_blocks.begin();
+    for(;ii!=moved_blocks.end();ii++)
+    {
+        DesktopRect rect = GetBlockRect(ii->first);
+        rect.x += ii->second.first;
+        rect.y += ii->second.second;
+        if(rect.x < 0 || rect.y < 0 || rect.x + rect.width > GetWidth() ||
+           rect.y + rect.height > GetHeight())
+            return false;
+
+        const int line_size = rect.width * m_pixel_size;
+        std::vector<char>& block = blocks[ii->first];
+        block.resize(line_size * rect.height);
+        for(int i=0;i<rect.height;i++)
+        {
+            memcpy(&block[line_size * i],
+                   &m_bitmap[GetPixelOffset(rect.x, rect.y + i)], line_size);
+        }
+    }
+
+    map_blocks_t::const_iterator bi = blocks.begin();
+    for(;bi!=blocks.end();bi++)
+    {
+        DesktopRect rect = GetBlockRect(bi->first);
+        const int line_size = rect.width * m_pixel_size;
+        for(int i=0;i<rect.height;i++)
+        {
+            memcpy(&m_bitmap[GetPixelOffset(rect.x, rect.y + i)],
+                   &bi->second[line_size * i], line_size);
+        }
+    }
+    return true;
+}
+
 void DesktopViewer::ResetBitmap(const std::vector<char>* bmp/* = 0*/)
 {
+    wguard_t g(m_mutex);
+
     if(bmp && bmp->size() == m_bitmap.size())
         m_bitmap =  *bmp;
     else
@@ -372,6 +834,9 @@ bool DesktopViewer::DecompressBlock(const char* inbuf,
 
 void DesktopViewer::WriteBitmapToFile(const ACE_TString& filename)
 {
+    DecodeBlocks();
+
+    wguard_t g(m_mutex);
     WriteBitmap(filename, GetWidth(), GetHeight(), m_pixel_size,
                 &m_bitmap[0], int(m_bitmap.size()));
 }
@@ -382,3 +847,108 @@ const char* DesktopViewer::GetBitmap(int* size/* = 0*/) const
         *size = (int)m_bitmap.size();
     return &m_bitmap[0];
 }
+
+DesktopDecoderPool::DesktopDecoderPool()
+: m_stopped(false)
+{
+}
+
+DesktopDecoderPool::~DesktopDecoderPool()
+{
+    StopThreads();
+}
+
+void DesktopDecoderPool::QueueDecode(const desktop_viewer_t& viewer)
+{
+    if(!viewer->ScheduleDecode())
+        return;
+
+    desktop_viewer_t* job = NULL;
+    ACE_Message_Block* mb = NULL;
+    ACE_NEW_NORETURN(job, desktop_viewer_t(viewer));
+    ACE_NEW_NORETURN(mb, ACE_Message_Block(sizeof(job)));
+
+    ACE_Time_Value tm_zero;
+    if(job && mb && StartThreads() &&
+       mb->copy(reinterpret_cast<const char*>(&job), sizeof(job)) >= 0 &&
+       this->putq(mb, &tm_zero) >= 0)
+        return;
+
+    //reader of the bitmap will decode instead
+    if(mb)
+        mb->release();
+    delete job;
+    viewer->CancelDecode();
+}
+
+bool DesktopDecoderPool::StartThreads()
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+
+    if(m_stopped)
+        return false;
+    if(this->thr_count())
+        return true;
+
+    int n_threads = ACE_OS::num_processors_online();
+    n_threads = std::max(1, std::min(n_threads, DECODER_THREADS_MAX));
+    MYTRACE(ACE_TEXT("Starting %d desktop decoder threads\n"), n_threads);
+    return this->activate(THR_NEW_LWP | THR_JOINABLE | THR_INHERIT_SCHED,
+                          n_threads) >= 0;
+}
+
+void DesktopDecoderPool::StopThreads()
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+
+    m_stopped = true;
+
+    size_t n_threads = this->thr_count();
+    for(size_t i=0;i<n_threads;i++)
+    {
+        ACE_Message_Block* mb;
+        ACE_NEW_NORETURN(mb, ACE_Message_Block(0, ACE_Message_Block::MB_HANGUP));
+        if(!mb || this->putq(mb) < 0)
+        {
+            if(mb)
+                mb->release();
+            this->msg_queue()->deactivate();
+            break;
+        }
+    }
+    this->wait();
+
+    //viewers queued after the hangups
+    this->msg_queue()->activate();
+    ACE_Message_Block* mb;
+    ACE_Time_Value tm_zero;
+    while(this->getq(mb, &tm_zero) >= 0)
+    {
+        if(mb->msg_type() != ACE_Message_Block::MB_HANGUP)
+        {
+            desktop_viewer_t* job = *reinterpret_cast<desktop_viewer_t**>(mb->rd_ptr());
+            (*job)->CancelDecode();
+            delete job;
+        }
+        mb->release();
+    }
+}
+
+int DesktopDecoderPool::svc()
+{
+    ACE_Message_Block* mb;
+    while(this->getq(mb) >= 0)
+    {
+        if(mb->msg_type() == ACE_Message_Block::MB_HANGUP)
+        {
+            mb->release();
+            break;
+        }
+
+        desktop_viewer_t* job = *reinterpret_cast<desktop_viewer_t**>(mb->rd_ptr());
+        (*job)->DecodeBlocks();
+        delete job;
+        mb->release();
+    }
+    return 0;
+}
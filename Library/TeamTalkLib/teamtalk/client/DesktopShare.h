@@ -27,6 +27,8 @@
 #include <map>
 #include <vector>
 #include <set>
+#include <deque>
+#include <atomic>
 
 #include <ace/Task.h>
 #include <ace/Bound_Ptr.h>
@@ -34,10 +36,13 @@
 #include <ace/Reactor.h>
 #include <ace/Semaphore.h>
 
+#include <myace/MyACE.h>
 #include <teamtalk/PacketLayout.h>
 #include <teamtalk/PacketHelper.h>
 #include <teamtalk/DesktopSession.h>
 
+struct z_stream_s;
+
 namespace teamtalk {
 
     class DesktopInitiator 
@@ -45,10 +50,14 @@ namespace teamtalk {
         , public ACE_Task_Base
     {
     public:
+        //'detect_moves' requires that receivers support block moves
         DesktopInitiator(int userid, const DesktopWindow& wnd,
-                         uint16_t max_chunk_size, uint16_t max_payload_size);
+                         uint16_t max_chunk_size, uint16_t max_payload_size,
+                         bool detect_moves = false);
         virtual ~DesktopInitiator();
-        int NewBitmap(const char* bmp_bits, int size, uint32_t tm);
+        //only blocks intersecting 'dirty_rects' are checked for changes
+        int NewBitmap(const char* bmp_bits, int size, uint32_t tm,
+                      const desktop_rects_t* dirty_rects = NULL);
 
         void Abort();
 
@@ -58,19 +67,46 @@ namespace teamtalk {
         int svc(void);
 
     private:
-        void CompressDirtyBlocks(map_blocks_t& blocks);
-        bool CompressBlock(int block_no, std::vector<char>& outbuf);
+        //find dirty blocks which are the previous bitmap moved
+        //vertically or horizontally
+        void DetectMovedBlocks(const char* bmp_bits,
+                               const std::vector<uint32_t>& line_crcs,
+                               const std::vector<uint32_t>& column_hashes);
+        bool IsPreviousRegion(const char* bmp_bits, const DesktopRect& rect,
+                              int dx, int dy);
+        void UpdateBlockHashes(const char* bmp_bits, int block_no,
+                               std::vector<uint32_t>& line_crcs,
+                               std::vector<uint32_t>& column_hashes) const;
+        void CompressDirtyBlocks();
+        bool CompressBlock(z_stream_s& strm, int block_no, std::vector<char>& outbuf);
+        void BuildPackets();
 
         //the grid of blocks
         map_blocks_t m_blocks;
-        //tmp buffer
-        std::vector<char> m_tmp_block;
         //the blocknums which became dirty by last call to NewBitmap()
         std::set<uint16_t> m_dirty_blocknums;
+        //dirty blocknums in order and their compressed data (same index)
+        std::vector<uint16_t> m_compress_blocknums;
+        std::vector< std::vector<char> > m_compressed;
+        //next index in 'm_compress_blocknums' to be claimed by a thread
+        std::atomic<int> m_compress_index;
+        //compressor threads which have not yet finished
+        std::atomic<int> m_compress_threads;
         //blocks' crc value
         map_block_crc_t m_block_crcs;
         //crc value for blocks
         map_crc_blocks_t m_crc_blocks;
+        //find blocks which are moved from the previous bitmap
+        bool m_detect_moves;
+        //CRC32C of every line in a block column [y * blocks per row + column]
+        //and hash of every pixel column in a block row [row * width + x]
+        //of the previous bitmap
+        std::vector<uint32_t> m_line_crcs, m_column_hashes;
+        //dirty blocks which are moved from the previous bitmap
+        map_block_offsets_t m_moved_blocks;
+        block_moves_t m_moves;
+        //pixels of previous bitmap when verifying a move
+        std::vector<char> m_region;
         //timestamp of dirty blocks
         uint32_t m_timestamp;
         //generated desktop packets from new bitmap
@@ -87,26 +123,89 @@ namespace teamtalk {
 
     typedef ACE_Strong_Bound_Ptr< DesktopInitiator, ACE_MT_SYNCH::RECURSIVE_MUTEX > desktop_initiator_t;
 
+    /* Updates of the bitmap are queued by the reactor thread and
+     * applied in order by DecodeBlocks(), normally on a
+     * DesktopDecoderPool thread, so zlib decompression never runs on
+     * the thread which handles keepalives and voice packets. */
     class DesktopViewer : public DesktopSession
     {
     public:
         DesktopViewer(const DesktopWindow& wnd);
 
-        void AddCompressedBlock(int block_no, const char* inbuf, int in_size);
-        void AddDuplicateBlock(int src_block_no, int dest_block_no);
+        void QueueCompressedBlock(int block_no, const char* inbuf, int in_size);
+        void QueueDuplicateBlock(int src_block_no, int dest_block_no);
+        //copy blocks from their position in the previous update. Must
+        //be queued before any block of the update.
+        void QueueMoveBlocks(const block_moves_t& moves);
+
+        //@return false if already scheduled or nothing is queued
+        bool ScheduleDecode();
+        void CancelDecode();
+        //apply all queued updates to the bitmap
+        void DecodeBlocks();
 
         void ResetBitmap(const std::vector<char>* bmp = 0);
 
         void WriteBitmapToFile(const ACE_TString& filename);
 
+        //hold 'lock()' while reading the bitmap. Call DecodeBlocks()
+        //first to include queued updates
         const char* GetBitmap(int* size = 0) const;
+        ACE_Recursive_Thread_Mutex& lock() { return m_mutex; }
 
     private:
+        void WriteBlock(int block_no, const std::vector<char>& pixels);
+        void AddDuplicateBlock(int src_block_no, int dest_block_no);
+        bool MoveBlocks(const block_moves_t& moves);
         bool DecompressBlock(const char* inbuf, int in_size, 
                              std::vector<char>& outbuf);
+
+        struct block_update
+        {
+            enum
+            {
+                UPDATE_BLOCK,
+                UPDATE_DUPLICATE,
+                UPDATE_MOVES
+            } type;
+            //UPDATE_BLOCK: the block, UPDATE_DUPLICATE: source block
+            int block_no;
+            int dest_block_no;
+            std::vector<char> compressed;
+            block_moves_t moves;
+        };
+        std::deque<block_update> m_updates;
+        bool m_decode_scheduled;
+
         std::vector<char> m_bitmap;
+        //protects 'm_updates', 'm_decode_scheduled' and 'm_bitmap'
+        ACE_Recursive_Thread_Mutex m_mutex;
+        //serializes DecodeBlocks(). Never acquired while holding 'm_mutex'
+        ACE_Recursive_Thread_Mutex m_decode_mutex;
     };
 
     typedef ACE_Strong_Bound_Ptr< DesktopViewer, ACE_MT_SYNCH::RECURSIVE_MUTEX > desktop_viewer_t;
+
+    /* Worker threads shared by all DesktopViewers of a client
+     * instance. A DesktopViewer is only decoded by one worker at a
+     * time since block moves and duplicates depend on the blocks
+     * before them. */
+    class DesktopDecoderPool : private ACE_Task<ACE_MT_SYNCH>
+    {
+    public:
+        DesktopDecoderPool();
+        ~DesktopDecoderPool();
+
+        //start workers if needed and queue decoding of 'viewer'
+        void QueueDecode(const desktop_viewer_t& viewer);
+        void StopThreads();
+
+    private:
+        int svc(void);
+        bool StartThreads();
+
+        ACE_Thread_Mutex m_mutex;
+        bool m_stopped;
+    };
 }
 #endif
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+#include "JitterBuffer.h"
+#include <teamtalk/ttassert.h>
+
+#include <algorithm>
+#include <stdlib.h>
+
+namespace teamtalk {
+
+#define JITTER_MIN_SLOTS 16
+#define JITTER_MAX_SLOTS 4096
+
+AudioJitterBuffer::AudioJitterBuffer()
+: m_count(0)
+, m_frame_msec(0)
+, m_max_msec(0)
+, m_started(false)
+, m_playing(false)
+, m_play_pkt_no(0)
+, m_newest_pkt_no(0)
+, m_jitter_q4(0)
+, m_has_transit(false)
+, m_last_transit(0)
+, m_target_msec(0)
+, m_decay_count(0)
+, m_underrun(false)
+, m_packets_late(0)
+{
+}
+
+void AudioJitterBuffer::Init(int frame_msec, int max_msec)
+{
+    m_frame_msec = std::max(frame_msec, 1);
+    m_max_msec = std::max(max_msec, m_frame_msec);
+
+    size_t slots = JITTER_MIN_SLOTS;
+    while(slots < size_t(m_max_msec / m_frame_msec + 2) && slots < JITTER_MAX_SLOTS)
+        slots <<= 1;
+
+    m_slots.clear();
+    m_slots.resize(slots);
+    m_count = 0;
+
+    m_jitter_q4 = 0;
+    m_has_transit = false;
+    m_target_msec = m_frame_msec;
+    m_decay_count = 0;
+
+    Reset();
+}
+
+void AudioJitterBuffer::Reset()
+{
+    for(size_t i=0;i<m_slots.size() && m_count;i++)
+    {
+        if(m_slots[i].valid)
+        {
+            m_slots[i].valid = false;
+            m_count--;
+        }
+    }
+    TTASSERT(m_count == 0);
+    m_count = 0;
+    m_started = m_playing = m_underrun = false;
+    m_play_pkt_no = m_newest_pkt_no = 0;
+}
+
+encframe* AudioJitterBuffer::Insert(uint16_t pkt_no, uint32_t pkt_time)
+{
+    if(m_slots.empty())
+        return NULL;
+
+    UpdateJitter(pkt_time);
+
+    if(!m_started)
+    {
+        m_play_pkt_no = m_newest_pkt_no = pkt_no;
+        m_started = true;
+    }
+
+    if(W16_LT(pkt_no, m_play_pkt_no))
+    {
+        m_packets_late++;
+        return NULL;
+    }
+
+    if(m_underrun && pkt_no == m_play_pkt_no)
+    {
+        //packet missed its playout deadline so increase delay
+        m_target_msec = std::min(m_target_msec + m_frame_msec, m_max_msec / 2);
+        m_underrun = false;
+    }
+
+    //packet is too far ahead to keep anything currently buffered
+    if(uint16_t(pkt_no - m_play_pkt_no) >= m_slots.size())
+    {
+        bool playing = m_playing;
+        Reset();
+        m_started = true;
+        m_playing = playing;
+        m_play_pkt_no = m_newest_pkt_no = pkt_no;
+    }
+
+    //make room by ejecting the oldest packets
+    while(uint16_t(pkt_no - m_play_pkt_no) >= m_slots.size() ||
+          (uint16_t(pkt_no - m_play_pkt_no) + 1) * m_frame_msec > m_max_msec)
+    {
+        Pop();
+    }
+
+    jitterslot& slot = m_slots[pkt_no % m_slots.size()];
+    if(slot.valid)
+    {
+        TTASSERT(slot.pkt_no == pkt_no);
+        return NULL; //duplicate
+    }
+
+    slot.valid = true;
+    slot.pkt_no = pkt_no;
+    slot.frame.reset();
+    m_count++;
+
+    if(m_count == 1 || W16_GT(pkt_no, m_newest_pkt_no))
+        m_newest_pkt_no = pkt_no;
+
+    return &slot.frame;
+}
+
+void AudioJitterBuffer::Remove(uint16_t pkt_no)
+{
+    if(m_slots.empty())
+        return;
+
+    jitterslot& slot = m_slots[pkt_no % m_slots.size()];
+    if(slot.valid && slot.pkt_no == pkt_no)
+    {
+        slot.valid = false;
+        m_count--;
+    }
+}
+
+encframe* AudioJitterBuffer::Get(uint16_t pkt_no)
+{
+    if(m_slots.empty())
+        return NULL;
+
+    jitterslot& slot = m_slots[pkt_no % m_slots.size()];
+    if(slot.valid && slot.pkt_no == pkt_no)
+        return &slot.frame;
+    return NULL;
+}
+
+void AudioJitterBuffer::Pop()
+{
+    Remove(m_play_pkt_no);
+    m_play_pkt_no++;
+    m_underrun = false;
+}
+
+void AudioJitterBuffer::Underrun()
+{
+    m_underrun = true;
+}
+
+int AudioJitterBuffer::GetBufferedMSec() const
+{
+    if(m_count == 0)
+        return 0;
+    return (uint16_t(m_newest_pkt_no - m_play_pkt_no) + 1) * m_frame_msec;
+}
+
+int AudioJitterBuffer::GetNumPacketsLate(bool reset)
+{
+    int n = m_packets_late;
+    if(reset)
+        m_packets_late = 0;
+    return n;
+}
+
+void AudioJitterBuffer::UpdateJitter(uint32_t pkt_time)
+{
+    //J(i) = J(i-1) + (|D(i-1,i)| - J(i-1))/16
+    uint32_t transit = GETTIMESTAMP() - pkt_time;
+    if(m_has_transit)
+    {
+        int d = abs(int(ACE_INT32(transit - m_last_transit)));
+        m_jitter_q4 += d - ((m_jitter_q4 + 8) >> 4);
+    }
+    m_last_transit = transit;
+    m_has_transit = true;
+
+    //room for twice the mean deviation rounded up to whole frames
+    int jitter_msec = 2 * GetJitterMSec();
+    int desired = m_frame_msec * (1 + (jitter_msec + m_frame_msec - 1) / m_frame_msec);
+    desired = std::min(desired, m_max_msec / 2);
+
+    if(desired >= m_target_msec)
+    {
+        m_target_msec = desired;
+        m_decay_count = 0;
+    }
+    else if(++m_decay_count >= 8)
+    {
+        //shrink slowly, i.e. 1 msec for every 8 packets
+        m_target_msec--;
+        m_decay_count = 0;
+    }
+    m_target_msec = std::max(m_target_msec, m_frame_msec);
+}
+
+}
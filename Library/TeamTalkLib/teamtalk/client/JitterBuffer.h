@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+#include <myace/MyACE.h>
+
+#include <vector>
+
+namespace teamtalk {
+
+    struct encframe
+    {
+        std::vector<char> enc_frames;
+        std::vector<uint16_t> enc_frame_sizes;
+        uint32_t timestamp;
+        int stream_id;
+
+        encframe() : timestamp(0), stream_id(0) {}
+        void reset()
+        {
+            timestamp = 0;
+            enc_frames.clear();
+            enc_frame_sizes.clear();
+            stream_id = 0;
+        }
+    };
+
+    /* Adaptive jitter buffer for encoded audio frames. Frames are
+     * stored in a flat ring indexed by packet number so slots (and
+     * their encoded data buffers) are reused once the ring has warmed
+     * up.
+     *
+     * The playout delay follows the inter-arrival jitter (RFC 3550)
+     * measured on the packets' time stamps. The delay grows
+     * immediately when jitter increases or a packet arrives after
+     * its playout deadline, and it shrinks slowly when the network
+     * calms down. */
+    class AudioJitterBuffer
+    {
+    public:
+        AudioJitterBuffer();
+
+        // 'frame_msec' is the duration of a packet, 'max_msec' is the
+        // maximum amount of audio which can be buffered
+        void Init(int frame_msec, int max_msec);
+        // Clear frames but keep jitter estimate
+        void Reset();
+
+        // Get slot where packet should be stored. Returns NULL if the
+        // packet arrived too late or is a duplicate.
+        encframe* Insert(uint16_t pkt_no, uint32_t pkt_time);
+        void Remove(uint16_t pkt_no);
+        // NULL if packet has not been received
+        encframe* Get(uint16_t pkt_no);
+
+        bool IsEmpty() const { return m_count == 0; }
+        bool IsStarted() const { return m_started; }
+
+        // Playout has begun (initial delay has been reached)
+        bool IsPlaying() const { return m_playing; }
+        void SetPlaying(bool playing) { m_playing = playing; }
+        // Check whether enough audio is buffered to start playout
+        bool IsPrimed() const { return GetBufferedMSec() >= m_target_msec; }
+
+        uint16_t GetPlayPacketNo() const { return m_play_pkt_no; }
+        // NULL if packet at play position is missing
+        encframe* GetPlayFrame() { return Get(m_play_pkt_no); }
+        // Advance play position
+        void Pop();
+        // Playout ran dry while stream was active
+        void Underrun();
+
+        int GetBufferedMSec() const;
+        int GetTargetDelayMSec() const { return m_target_msec; }
+        int GetJitterMSec() const { return m_jitter_q4 >> 4; }
+
+        int GetNumPacketsLate(bool reset);
+
+    private:
+        void UpdateJitter(uint32_t pkt_time);
+
+        struct jitterslot
+        {
+            encframe frame;
+            uint16_t pkt_no;
+            bool valid;
+            jitterslot() : pkt_no(0), valid(false) {}
+        };
+        std::vector<jitterslot> m_slots;
+        int m_count;
+
+        int m_frame_msec, m_max_msec;
+        bool m_started, m_playing;
+        // next packet to be played
+        uint16_t m_play_pkt_no;
+        // highest packet number received
+        uint16_t m_newest_pkt_no;
+
+        // inter-arrival jitter in 1/16 msec
+        int m_jitter_q4;
+        bool m_has_transit;
+        uint32_t m_last_transit;
+        int m_target_msec;
+        int m_decay_count;
+        // packet at play position wasn't there in time
+        bool m_underrun;
+
+        // stats
+        int m_packets_late;
+    };
+}
+
+#endif
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+#include "ReactorPool.h"
+#include <ace/Select_Reactor.h>
+#include <ace/Semaphore.h>
+#include <teamtalk/ttassert.h>
+#include <myace/MyACE.h>
+
+using namespace teamtalk;
+
+//upper limit of threads in the pool
+#define REACTORPOOL_MAX_THREADS 64
+
+ReactorThread::ReactorThread()
+    : m_clients(0)
+    , m_reactor(new ACE_Select_Reactor(), true) //Ensure we don't use ACE_WFMO_Reactor!!!
+{
+}
+
+bool ReactorThread::Start()
+{
+    return this->activate() >= 0;
+}
+
+void ReactorThread::Stop()
+{
+    int ret = m_reactor.end_reactor_event_loop();
+    TTASSERT(ret >= 0);
+    this->wait();
+}
+
+int ReactorThread::svc()
+{
+    int ret = m_reactor.owner(ACE_OS::thr_self());
+    TTASSERT(ret >= 0);
+    m_reactor.run_reactor_event_loop();
+    MYTRACE(ACE_TEXT("Pooled reactor thread exited.\n"));
+    return 0;
+}
+
+ReactorPool::ReactorPool()
+    : m_thread_count(0)
+{
+}
+
+ReactorPool::~ReactorPool()
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+    MYTRACE_COND(m_threads.size(), ACE_TEXT("Reactor pool destroyed with %u threads\n"),
+                 (unsigned)m_threads.size());
+    m_thread_count = 0;
+    StopIdleThreads();
+}
+
+bool ReactorPool::SetThreadCount(int count)
+{
+    if(count < 0 || count > REACTORPOOL_MAX_THREADS)
+        return false;
+
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+
+    //threads beyond 'count' keep running until their client
+    //instances are closed
+    m_thread_count = count;
+    while(int(m_threads.size()) < count)
+    {
+        ReactorThread* thr;
+        ACE_NEW_RETURN(thr, ReactorThread(), false);
+        if(!thr->Start())
+        {
+            delete thr;
+            return false;
+        }
+        m_threads.push_back(thr);
+    }
+    StopIdleThreads();
+    return true;
+}
+
+int ReactorPool::GetThreadCount()
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+    return m_thread_count;
+}
+
+ACE_Reactor* ReactorPool::AcquireReactor()
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+
+    //place on the least loaded reactor
+    ReactorThread* best = NULL;
+    for(int i=0;i<m_thread_count && i<int(m_threads.size());i++)
+    {
+        if(!best || m_threads[i]->m_clients < best->m_clients)
+            best = m_threads[i];
+    }
+    if(!best)
+        return NULL;
+
+    best->m_clients++;
+    return &best->reactor_i();
+}
+
+void ReactorPool::ReleaseReactor(ACE_Reactor* reactor)
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+
+    for(size_t i=0;i<m_threads.size();i++)
+    {
+        if(&m_threads[i]->reactor_i() == reactor)
+        {
+            TTASSERT(m_threads[i]->m_clients > 0);
+            m_threads[i]->m_clients--;
+            StopIdleThreads();
+            return;
+        }
+    }
+    TTASSERT(0);
+}
+
+void ReactorPool::StopIdleThreads()
+{
+    for(size_t i=m_thread_count;i<m_threads.size();)
+    {
+        if(m_threads[i]->m_clients == 0)
+        {
+            m_threads[i]->Stop();
+            delete m_threads[i];
+            m_threads.erase(m_threads.begin() + i);
+        }
+        else ++i;
+    }
+}
+
+namespace
+{
+    class NotifyBarrier : public ACE_Event_Handler
+    {
+    public:
+        NotifyBarrier() : m_sem(0) {}
+        int handle_exception(ACE_HANDLE fd)
+        {
+            m_sem.release();
+            return 0;
+        }
+        ACE_Semaphore m_sem;
+    };
+}
+
+void ReactorPool::FlushNotifications(ACE_Reactor& reactor)
+{
+    //notifications are dispatched in order so when the barrier's
+    //notification is dispatched all earlier ones have been too
+    NotifyBarrier barrier;
+    if(reactor.notify(&barrier, ACE_Event_Handler::EXCEPT_MASK) >= 0)
+        barrier.m_sem.acquire();
+}
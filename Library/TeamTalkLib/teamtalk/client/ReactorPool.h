@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+#ifndef REACTORPOOL_H
+#define REACTORPOOL_H
+
+#include <ace/Task.h>
+#include <ace/Reactor.h>
+#include <ace/Singleton.h>
+#include <ace/Thread_Mutex.h>
+
+#include <vector>
+
+namespace teamtalk {
+
+    class ReactorThread : public ACE_Task_Base
+    {
+    public:
+        ReactorThread();
+        bool Start();
+        void Stop();
+        ACE_Reactor& reactor_i() { return m_reactor; }
+        //number of client instances using the reactor
+        int m_clients;
+
+    private:
+        int svc();
+        ACE_Reactor m_reactor;
+    };
+
+    // Fixed-size pool of reactor threads shared by client
+    // instances. Many ClientNodes are multiplexed on each reactor so
+    // their sockets and timers are served by the same event loop
+    // instead of each instance running its own reactor thread.
+    class ReactorPool
+    {
+        friend class ACE_Singleton<ReactorPool, ACE_Thread_Mutex>;
+        ReactorPool();
+    public:
+        ~ReactorPool();
+
+        // Number of reactor threads used by client instances created
+        // afterwards. 0 means every client instance has its own
+        // reactor thread.
+        bool SetThreadCount(int count);
+        int GetThreadCount();
+
+        // Returns NULL if the pool is disabled
+        ACE_Reactor* AcquireReactor();
+        void ReleaseReactor(ACE_Reactor* reactor);
+
+        // Wait until the reactor has dispatched all notifications
+        // which were queued before this call. Must not be called from
+        // the reactor thread or while holding the reactor lock.
+        static void FlushNotifications(ACE_Reactor& reactor);
+
+    private:
+        void StopIdleThreads();
+
+        ACE_Thread_Mutex m_mutex;
+        std::vector<ReactorThread*> m_threads;
+        int m_thread_count;
+    };
+
+    typedef ACE_Singleton<ReactorPool, ACE_Thread_Mutex> REACTORPOOL;
+}
+
+#endif
@@ -34,6 +34,10 @@ using namespace media;
 namespace teamtalk {
 
 #define DEFAULT_BUF_MSEC 1000
+//max frames to interpolate when buffer runs dry
+#define UNDERRUN_CONCEAL_FRAMES 3
+//max time to generate comfort noise without receiving a DTX frame
+#define DTX_COMFORTNOISE_MSEC 1000
 
 AudioPlayer::AudioPlayer(int sndgrpid, int userid, StreamType stream_type,
                          AudioMuxer& audiomuxer, const AudioCodec& codec,
@@ -56,7 +60,12 @@ AudioPlayer::AudioPlayer(int sndgrpid, int userid, StreamType stream_type,
 , m_new_audio_blocks(0)
 , m_audiopackets_recv(0)
 , m_audiopacket_lost(0)
+, m_frames_concealed(0)
 , m_buffer_msec(DEFAULT_BUF_MSEC)
+, m_underrun_frames(0)
+, m_dtx(false)
+, m_dtx_time(0)
+, m_comfort_noise(false)
 {
     MYTRACE(ACE_TEXT("New AudioPlayer() - #%d\n"), m_userid);
 
@@ -163,8 +172,8 @@ void AudioPlayer::Reset()
     wguard_t g(m_mutex);
     m_audfragments.clear();
 
-    m_buffer.clear();
-    m_play_pkt_no = 0;
+    m_jitterbuf.Reset();
+    m_underrun_frames = 0;
     m_stream_id = 0;
 
     //do not reset play time since they're used by ClientUser to check
@@ -192,10 +201,8 @@ bool AudioPlayer::StreamPlayerCb(const soundsystem::OutputStreamer& streamer,
     //increment samples played (used by AudioMuxer)
     m_samples_played += input_samples;
 
-    if(played)
+    if(played || m_comfort_noise)
     {
-        m_last_playback = GETTIMESTAMP();
-
         if(input_channels == 2)
         {
             //If in stereo then choose which channels to output audio to
@@ -220,7 +227,11 @@ bool AudioPlayer::StreamPlayerCb(const soundsystem::OutputStreamer& streamer,
                 break;
             }
         }
+    }
 
+    if(played)
+    {
+        m_last_playback = GETTIMESTAMP();
         m_talking = true;
     }
     else if(m_talking && W32_GEQ(GETTIMESTAMP(), (m_last_playback+m_play_stopped_delay)))
@@ -255,11 +266,7 @@ bool AudioPlayer::StreamPlayerCb(const soundsystem::OutputStreamer& streamer,
     {
         int ret = m_resampler->Resample(tmp_output_buffer, input_samples,
                                         output_buffer, output_samples);
-        assert(ret > 0);
-        assert(ret <= output_samples);
-        MYTRACE_COND(ret != output_samples,
-                     ACE_TEXT("Resampler output incorrect no. samples, expect %d, got %d\n"),
-                     output_samples, ret);
+        assert(ret == output_samples);
     }
     return true;
 }
@@ -298,22 +305,42 @@ int AudioPlayer::GetNumAudioPacketsLost(bool reset)
     return n;
 }
 
+int AudioPlayer::GetNumAudioPacketsLate(bool reset)
+{
+    wguard_t g(m_mutex);
+    return m_jitterbuf.GetNumPacketsLate(reset);
+}
+
+int AudioPlayer::GetNumAudioFramesConcealed(bool reset)
+{
+    wguard_t g(m_mutex);
+    int n = m_frames_concealed;
+    if(reset)
+        m_frames_concealed = 0;
+    return n;
+}
+
+int AudioPlayer::GetJitterMSec()
+{
+    wguard_t g(m_mutex);
+    return m_jitterbuf.GetJitterMSec();
+}
+
 void AudioPlayer::SetAudioBufferSize(int msec)
 {
+    wguard_t g(m_mutex);
+
     m_buffer_msec = std::max(msec, GetAudioCodecCbMillis(m_codec));
+    m_jitterbuf.Init(GetAudioCodecCbMillis(m_codec), m_buffer_msec);
+    m_underrun_frames = 0;
+    m_stream_id = 0;
 }
 
 int AudioPlayer::GetBufferedAudioMSec()
 {
     wguard_t g(m_mutex);
 
-    int codec_msec = GetAudioCodecCbMillis(m_codec);
-    if (m_stream_id && m_buffer.size() && codec_msec)
-    {
-        int16_t n_packets = (int16_t)(m_buffer.rbegin()->first - m_play_pkt_no);
-        return codec_msec * (++n_packets);
-    }
-    return int(m_buffer.size()) * codec_msec;
+    return m_jitterbuf.GetBufferedMSec();
 }
 
 void AudioPlayer::AddPacket(const teamtalk::AudioPacket& packet)
@@ -336,78 +363,61 @@ void AudioPlayer::AddPacket(const teamtalk::AudioPacket& packet)
     if(packet.GetStreamID() == 0)
         return;
 
-    if (m_stream_id && W16_LT(pkt_no, m_play_pkt_no))
+    encframe* frame = m_jitterbuf.Insert(pkt_no, packet.GetTime());
+    if(!frame)
     {
-        MYTRACE(ACE_TEXT("User #%d, packet %d arrived too late\n"), m_userid, pkt_no);
+        MYTRACE(ACE_TEXT("User #%d, packet %d arrived too late or is a duplicate. Play pkt %d\n"),
+                m_userid, (int)pkt_no, (int)m_jitterbuf.GetPlayPacketNo());
         return;
     }
 
-    MYTRACE_COND(m_buffer.find(pkt_no) != m_buffer.end(),
-                 ACE_TEXT("User #%d, duplicate packet %d, start %d, end %d\n"), (int)pkt_no,
-                 m_userid, m_buffer.begin()->first, m_buffer.rbegin()->first);
-       
     if(packet.HasFrameSizes())
     {
-        m_buffer[pkt_no].enc_frame_sizes = packet.GetEncodedFrameSizes();
-        MYTRACE_COND(SumFrameSizes(m_buffer[pkt_no].enc_frame_sizes) != enc_len,
+        frame->enc_frame_sizes = packet.GetEncodedFrameSizes();
+        MYTRACE_COND(SumFrameSizes(frame->enc_frame_sizes) != enc_len,
                      ACE_TEXT("User #%d, sum of frame sizes didn't match - %d != %d\n"),
-                     m_userid, SumFrameSizes(m_buffer[pkt_no].enc_frame_sizes), enc_len);
+                     m_userid, SumFrameSizes(frame->enc_frame_sizes), enc_len);
 
-        if(SumFrameSizes(m_buffer[pkt_no].enc_frame_sizes) == enc_len)
-            m_buffer[pkt_no].enc_frames.assign(enc_data, enc_data+enc_len);
+        if(SumFrameSizes(frame->enc_frame_sizes) == enc_len)
+            frame->enc_frames.assign(enc_data, enc_data+enc_len);
         else
         {
-            m_buffer.erase(pkt_no);
+            m_jitterbuf.Remove(pkt_no);
             return;
         }
     }
     else
     {
-        m_buffer[pkt_no].enc_frames.assign(enc_data, enc_data+enc_len);
+        frame->enc_frames.assign(enc_data, enc_data+enc_len);
         if(GetAudioCodecFramesPerPacket(m_codec)>1)
-            m_buffer[pkt_no].enc_frame_sizes.assign(GetAudioCodecFramesPerPacket(m_codec), 
-                                                     GetAudioCodecEncFrameSize(m_codec));
+            frame->enc_frame_sizes.assign(GetAudioCodecFramesPerPacket(m_codec), 
+                                          GetAudioCodecEncFrameSize(m_codec));
         else
-            m_buffer[pkt_no].enc_frame_sizes.push_back(enc_len);
+            frame->enc_frame_sizes.push_back(enc_len);
     }
-    m_buffer[pkt_no].timestamp = packet.GetTime();
+    frame->timestamp = packet.GetTime();
     TTASSERT(packet.GetStreamID());
-    m_buffer[pkt_no].stream_id = packet.GetStreamID();
-
-    //ensure buffer doesn't overflow
-    while(GetBufferedAudioMSec() > m_buffer_msec && m_buffer.size())
-    {
-        MYTRACE(ACE_TEXT("User #%d, removing pkt_no %d to limit buffer to %d msec, cur buffer is %d msec. Play pkt %d\n"),
-                m_userid, m_buffer.begin()->first, m_buffer_msec, 
-                GetBufferedAudioMSec(), (int)m_play_pkt_no);
-        m_buffer.erase(m_buffer.begin());
-        //update next packet to be played
-        if(m_buffer.size())
-            m_play_pkt_no = m_buffer.begin()->first;
-    }
+    frame->stream_id = packet.GetStreamID();
 
     MYTRACE_COND(GetBufferedAudioMSec() > m_buffer_msec,
                  ACE_TEXT("User #%d buffer size is foobar, msec: %d\n"),
                  m_userid, GetBufferedAudioMSec());
 
     if (m_stream_id == 0)
-    {
-        m_play_pkt_no = pkt_no;
         m_stream_id = packet.GetStreamID();
-    }
-    //MYTRACE(ACE_TEXT("#%d - Packet store no: %d, play: %d\n"), m_user.GetUserID(),
-    //    packet_number, m_play_pkt_no);
 }
 
 bool AudioPlayer::PlayBuffer(short* output_buffer, int n_samples)
 {
     wguard_t g(m_mutex);
     bool played = false;
+    m_comfort_noise = false;
 
-    //play until last packet arrived
-    if(m_buffer.size())
+    //wait for initial delay before starting playout
+    if(!m_jitterbuf.IsEmpty() &&
+       (m_jitterbuf.IsPlaying() || m_jitterbuf.IsPrimed()))
     {
-        TTASSERT(W16_GEQ(m_buffer.begin()->first, m_play_pkt_no));
+        m_jitterbuf.SetPlaying(true);
 
         int maxbuf_msec = m_buffer_msec;
         switch(m_streamtype)
@@ -419,48 +429,95 @@ bool AudioPlayer::PlayBuffer(short* output_buffer, int n_samples)
             break;
         }
 
-        while(m_stream_id &&
-              GetBufferedAudioMSec() > maxbuf_msec)
+        while(m_jitterbuf.GetBufferedMSec() > maxbuf_msec)
         {
-            MYTRACE(ACE_TEXT("User #%d, dropped packet %d, max %d\n"), 
-                    m_userid, m_buffer.begin()->first, m_buffer.rbegin()->first);
-            m_buffer.erase(m_buffer.begin());
-
-            if (m_buffer.size())
-            {
-                MYTRACE(ACE_TEXT("User #%d, skipped %d-%d packets\n"),
-                        m_userid, m_play_pkt_no, m_buffer.begin()->first-1);
-                m_play_pkt_no = m_buffer.begin()->first;
-            }
+            MYTRACE(ACE_TEXT("User #%d, dropped packet %d, buffered %d msec\n"), 
+                    m_userid, (int)m_jitterbuf.GetPlayPacketNo(),
+                    m_jitterbuf.GetBufferedMSec());
+            m_jitterbuf.Pop();
         }
 
-        // MYTRACE_COND(m_play_pkt_no % 100 == 0,
-        //              ACE_TEXT("User #%d, streamtype %u, stream id %d, cur_pkt %d, max pkt %d, tm: %u\n"),
-        //              m_userid, m_streamtype, m_stream_id, m_play_pkt_no, m_buffer.rbegin()->first,
-        //              GETTIMESTAMP());
+        //reduce latency when more is buffered than jitter requires
+        int frame_msec = GetAudioCodecCbMillis(m_codec);
+        if(m_jitterbuf.GetBufferedMSec() > m_jitterbuf.GetTargetDelayMSec() + 2 * frame_msec)
+        {
+            MYTRACE(ACE_TEXT("User #%d, skipped packet %d, buffered %d msec, target %d msec\n"),
+                    m_userid, (int)m_jitterbuf.GetPlayPacketNo(),
+                    m_jitterbuf.GetBufferedMSec(), m_jitterbuf.GetTargetDelayMSec());
+            m_jitterbuf.Pop();
+        }
 
-        if(DecodeFrame(m_buffer[m_play_pkt_no], output_buffer, n_samples))
+        encframe* frame = m_jitterbuf.GetPlayFrame();
+        if(frame && DecodeFrame(*frame, output_buffer, n_samples))
         {
-            m_played_packet_time = m_buffer[m_play_pkt_no].timestamp;
-            MYTRACE_COND(m_stream_id != m_buffer[m_play_pkt_no].stream_id,
+            //a DTX frame means the sender stopped transmitting due
+            //to silence
+            m_dtx = IsAudioCodecDTXFrame(m_codec, frame->enc_frame_sizes);
+            if(m_dtx)
+                m_dtx_time = GETTIMESTAMP();
+            m_played_packet_time = frame->timestamp;
+            MYTRACE_COND(m_stream_id != frame->stream_id,
                          ACE_TEXT("User #%d started new audio stream %d\n"), m_userid, 
-                         m_buffer[m_play_pkt_no].stream_id);
-            m_stream_id = m_buffer[m_play_pkt_no].stream_id;
+                         frame->stream_id);
+            m_stream_id = frame->stream_id;
         }
         else
         {
+            uint16_t pkt_no = m_jitterbuf.GetPlayPacketNo();
+            bool recovered = ConcealFrame(m_jitterbuf.Get(pkt_no + 1),
+                                          output_buffer, n_samples);
+            MYTRACE(ACE_TEXT("User #%d is missing packet %d, %s\n"), 
+                    m_userid, (int)pkt_no, recovered? ACE_TEXT("recovered") : ACE_TEXT("concealed"));
             m_audiopacket_lost++;
+            m_frames_concealed++;
+            m_dtx = false;
         }
 
-        //clear slot
-        m_buffer.erase(m_play_pkt_no);
-
         //increment packet number to be played next time
-        m_play_pkt_no++;
+        m_jitterbuf.Pop();
+        m_underrun_frames = 0;
+        //DTX frames are comfort noise and not talking
+        played = !m_dtx;
+        m_comfort_noise = m_dtx;
+    }
+    else if(m_dtx && W32_LT(GETTIMESTAMP(), m_dtx_time + DTX_COMFORTNOISE_MSEC))
+    {
+        //frames suppressed by sender's DTX are not lost so neither
+        //count them as concealed nor increase the playout delay.
+        //Next talk spurt starts over with initial delay.
+        encframe* frame = m_jitterbuf.GetPlayFrame();
+        if(frame && IsAudioCodecDTXFrame(m_codec, frame->enc_frame_sizes) &&
+           DecodeFrame(*frame, output_buffer, n_samples))
+        {
+            //comfort noise refresh doesn't need to wait for initial delay
+            m_dtx_time = GETTIMESTAMP();
+            m_jitterbuf.Pop();
+        }
+        else
+            ConcealFrame(NULL, output_buffer, n_samples);
+        if(m_jitterbuf.IsEmpty())
+            m_jitterbuf.SetPlaying(false);
+        m_underrun_frames = 0;
+        m_comfort_noise = true;
+    }
+    else if(m_jitterbuf.IsPlaying() && m_underrun_frames < UNDERRUN_CONCEAL_FRAMES)
+    {
+        //buffer ran dry during playout so interpolate rather than
+        //play silence. Play position is not advanced so a late
+        //packet will still be played.
+        ConcealFrame(NULL, output_buffer, n_samples);
+        m_jitterbuf.Underrun();
+        m_underrun_frames++;
+        m_frames_concealed++;
         played = true;
     }
     else
     {
+        m_dtx = false;
+        //start over with initial delay
+        if(m_jitterbuf.IsEmpty())
+            m_jitterbuf.SetPlaying(false);
+
         memset(output_buffer, 0, GetAudioCodecCbBytes(m_codec));
         played = false;
     }
@@ -520,22 +577,23 @@ void SpeexPlayer::Reset()
 bool SpeexPlayer::DecodeFrame(const encframe& enc_frame,
                               short* output_buffer, int n_samples)
 {
-    if(enc_frame.enc_frames.size()) //packet available
-    {
-        m_Decoder.DecodeMultiple(&enc_frame.enc_frames[0], 
-                                 ConvertFrameSizes(enc_frame.enc_frame_sizes),
-                                 output_buffer);
-        return true;
-    }
-    else  //packet lost
-    {
-        MYTRACE(ACE_TEXT("User #%d is missing packet %d\n"), 
-                m_userid, m_play_pkt_no);
-        std::vector<int> frm_sizes(GetAudioCodecFramesPerPacket(m_codec), 0);
-        m_Decoder.DecodeMultiple(NULL, frm_sizes, output_buffer);
-        //increment 'm_played_packet_time' with GetAudioCodecCbMillis()?
+    if(enc_frame.enc_frames.empty())
         return false;
-    }
+
+    m_Decoder.DecodeMultiple(&enc_frame.enc_frames[0], 
+                             ConvertFrameSizes(enc_frame.enc_frame_sizes),
+                             output_buffer);
+    return true;
+}
+
+bool SpeexPlayer::ConcealFrame(const encframe* /*next_frame*/,
+                               short* output_buffer, int n_samples)
+{
+    //Speex has no in-band FEC so use its packet loss concealment
+    std::vector<int> frm_sizes(GetAudioCodecFramesPerPacket(m_codec), 0);
+    m_Decoder.DecodeMultiple(NULL, frm_sizes, output_buffer);
+    //increment 'm_played_packet_time' with GetAudioCodecCbMillis()?
+    return false;
 }
 #endif /* ENABLE_SPEEX */
 
@@ -570,21 +628,30 @@ void OpusPlayer::Reset()
 bool OpusPlayer::DecodeFrame(const encframe& enc_frame,
                               short* output_buffer, int n_samples)
 {
-    if(enc_frame.enc_frames.size()) //packet available
+    if(enc_frame.enc_frames.empty())
+        return false;
+
+    m_decoder.Decode(&enc_frame.enc_frames[0], 
+                     enc_frame.enc_frame_sizes[0],
+                     output_buffer, n_samples);
+    return true;
+}
+
+bool OpusPlayer::ConcealFrame(const encframe* next_frame,
+                              short* output_buffer, int n_samples)
+{
+    //recover lost frame from LBRR data in the next packet
+    if(next_frame && next_frame->enc_frames.size() && m_codec.opus.fec &&
+       m_decoder.DecodeFEC(&next_frame->enc_frames[0],
+                           next_frame->enc_frame_sizes[0],
+                           output_buffer, n_samples) == n_samples)
     {
-        m_decoder.Decode(&enc_frame.enc_frames[0], 
-                         enc_frame.enc_frame_sizes[0],
-                         output_buffer, n_samples);
         return true;
     }
-    else  //packet lost
-    {
-        MYTRACE(ACE_TEXT("User #%d is missing packet %d\n"), 
-                m_userid, m_play_pkt_no);
-        m_decoder.Decode(NULL, 0, output_buffer, n_samples);
-        //increment 'm_played_packet_time' with GetAudioCodecCbMillis()?
-        return false;
-    }
+
+    m_decoder.Decode(NULL, 0, output_buffer, n_samples);
+    //increment 'm_played_packet_time' with GetAudioCodecCbMillis()?
+    return false;
 }
 #endif
 
@@ -592,6 +659,9 @@ bool OpusPlayer::DecodeFrame(const encframe& enc_frame,
 
 #define VPX_MAX_FRAG_PACKETS 3000
 #define VPX_MAX_PACKETS 3000
+//frames decoded ahead of GetNextFrame()
+#define VPX_MAX_DECODED_FRAMES 3
+#define VPX_DECODER_THREADS_MAX 4
 
 WebMPlayer::WebMPlayer(int userid, int stream_id)
 : m_userid(userid)
@@ -599,9 +669,12 @@ WebMPlayer::WebMPlayer(int userid, int stream_id)
 , m_videoframes_recv(0)
 , m_videoframes_lost(0)
 , m_videoframes_dropped(0)
+, m_videoframes_skipped(0)
 , m_videostream_id(stream_id)
 , m_packet_no(0)
 , m_local_timestamp(GETTIMESTAMP())
+, m_decode_scheduled(false)
+, m_decode_ahead(false)
 , m_decoder_ready(false)
 {
     MYTRACE(ACE_TEXT("New WebMPlayer() - #%d stream id %d\n"), m_userid, stream_id);
@@ -612,6 +685,12 @@ WebMPlayer::~WebMPlayer()
     MYTRACE(ACE_TEXT("~WebMPlayer() - #%d stream id %d. Fragments: %u, frames: %u\n"),
             m_userid, m_videostream_id, (unsigned)m_video_fragments.size(), 
             (unsigned)m_video_frames.size());
+
+    while(m_decoded_frames.size())
+    {
+        m_decoded_frames.begin()->second->release();
+        m_decoded_frames.erase(m_decoded_frames.begin());
+    }
 }
 
 bool WebMPlayer::AddPacket(const VideoPacket& packet,
@@ -637,16 +716,13 @@ bool WebMPlayer::AddPacket(const VideoPacket& packet,
         m_decoder_ready = true;
     }
 
-    size_t n_frames = m_video_frames.size();
-    ProcessVideoPacket(packet);
-
     // dumpFragments();
 
     //return true if packet has ended up in the packet queue
-    return m_video_frames.find(packet.GetTime()) != m_video_frames.end();
+    return ProcessVideoPacket(packet);
 }
 
-void WebMPlayer::ProcessVideoPacket(const VideoPacket& packet)
+bool WebMPlayer::ProcessVideoPacket(const VideoPacket& packet)
 {
     wguard_t g(m_mutex);
 
@@ -656,7 +732,7 @@ void WebMPlayer::ProcessVideoPacket(const VideoPacket& packet)
                  packet.GetPacketNo(), m_userid, m_packet_no);
                  
     if(W32_LT(packet_no, m_packet_no))
-        return;
+        return false;
 
     uint16_t fragno = packet.GetFragmentNo();
     if(fragno == VideoPacket::INVALID_FRAGMENT_NO)
@@ -665,7 +741,7 @@ void WebMPlayer::ProcessVideoPacket(const VideoPacket& packet)
         const char* data = packet.GetEncodedData(frame_size);
         assert(data);
         if(!data)
-            return;
+            return false;
 
         enc_frame new_frame;
         new_frame.enc_data.assign(data, data+frame_size);
@@ -732,26 +808,121 @@ void WebMPlayer::ProcessVideoPacket(const VideoPacket& packet)
     }
 
     RemoveObsoletePackets();
+
+    //a worker may take the frame as soon as 'm_mutex' is released
+    return m_video_frames.find(packet.GetTime()) != m_video_frames.end();
 }
 
 ACE_Message_Block* WebMPlayer::GetNextFrame(uint32_t* timestamp)
+{
+    ACE_Message_Block* mb = PopDecodedFrame(timestamp);
+    if(mb)
+        return mb;
+
+    //not decoded by WebMDecoderPool so decode it here. Waits for a
+    //worker which is currently decoding
+    {
+        wguard_t gd(m_decode_mutex);
+        mb = PopDecodedFrame(timestamp);
+        if(mb || !NextFrameDue(timestamp))
+            return mb;
+
+        DecodeNextFrame();
+    }
+    return PopDecodedFrame(timestamp);
+}
+
+ACE_Message_Block* WebMPlayer::PopDecodedFrame(uint32_t* timestamp)
 {
     wguard_t g(m_mutex);
 
-    dumpFragments();
+    decoded_frames_t::iterator ii = m_decoded_frames.begin();
+    if(ii == m_decoded_frames.end() ||
+       (timestamp && W32_GT(ii->first, *timestamp)))
+        return NULL;
+
+    ACE_Message_Block* mb = ii->second;
+    m_decoded_frames.erase(ii);
+    m_decode_ahead = true;
+    return mb;
+}
+
+bool WebMPlayer::NextFrameDue(uint32_t* timestamp)
+{
+    wguard_t g(m_mutex);
 
     //m_video_frames are sorted with UINT32 wrap
     video_frames_t::iterator ii = m_video_frames.begin();
-    if(!m_decoder_ready || ii == m_video_frames.end() ||
-       (timestamp && W32_GT(ii->first, *timestamp)))
-        return NULL;
+    return m_decoder_ready && ii != m_video_frames.end() &&
+        (!timestamp || W32_LEQ(ii->first, *timestamp));
+}
 
-    // MYTRACE(ACE_TEXT("GetNextFrame(), process video packet %d, size %d, csum 0x%x\n"),
-    //         ii->second.packet_no, ii->second.enc_data.size(), 
-    //         ACE::crc32(&ii->second.enc_data[0], ii->second.enc_data.size()));
+bool WebMPlayer::ScheduleDecode()
+{
+    wguard_t g(m_mutex);
 
-    int ret = m_decoder.PushDecoder(&ii->second.enc_data[0], 
-                                    int(ii->second.enc_data.size()));
+    if(m_decode_scheduled || !m_decode_ahead || !m_decoder_ready ||
+       m_video_frames.empty() || m_decoded_frames.size() >= VPX_MAX_DECODED_FRAMES)
+        return false;
+
+    m_decode_scheduled = true;
+    return true;
+}
+
+void WebMPlayer::CancelDecode()
+{
+    wguard_t g(m_mutex);
+    m_decode_scheduled = false;
+}
+
+void WebMPlayer::DecodeFrames()
+{
+    wguard_t gd(m_decode_mutex);
+
+    while(true)
+    {
+        {
+            wguard_t g(m_mutex);
+            if(!m_decode_ahead || !m_decoder_ready || m_video_frames.empty() ||
+               m_decoded_frames.size() >= VPX_MAX_DECODED_FRAMES)
+            {
+                m_decode_scheduled = false;
+                return;
+            }
+        }
+        DecodeNextFrame();
+    }
+}
+
+void WebMPlayer::DecodeNextFrame()
+{
+    enc_frame frame;
+    uint32_t frame_time;
+    {
+        wguard_t g(m_mutex);
+
+        dumpFragments();
+
+        //m_video_frames are sorted with UINT32 wrap
+        video_frames_t::iterator ii = m_video_frames.begin();
+        if(!m_decoder_ready || ii == m_video_frames.end())
+            return;
+
+        frame_time = ii->first;
+        frame.packet_no = ii->second.packet_no;
+        frame.enc_data.swap(ii->second.enc_data);
+        m_packet_no = frame.packet_no;
+        m_video_frames.erase(ii);
+
+        RemoveObsoletePackets();
+    }
+
+    // MYTRACE(ACE_TEXT("DecodeNextFrame(), process video packet %d, size %d, csum 0x%x\n"),
+    //         frame.packet_no, frame.enc_data.size(), 
+    //         ACE::crc32(&frame.enc_data[0], frame.enc_data.size()));
+
+    int ret = m_decoder.PushDecoder(&frame.enc_data[0], 
+                                    int(frame.enc_data.size()));
 
     switch(ret)
     {
@@ -767,36 +938,47 @@ ACE_Message_Block* WebMPlayer::GetNextFrame(uint32_t* timestamp)
     }
     default :
         MYTRACE(ACE_TEXT("VPX decoder reported error %d in packet %d for user #%d\n"),
-                ret, ii->second.packet_no, m_userid);
-        m_packet_no = ii->second.packet_no;
-        m_video_frames.erase(ii);
-        return NULL;
+                ret, frame.packet_no, m_userid);
+        return;
     case VPX_CODEC_OK :
         break;
     }
 
-    m_packet_no = ii->second.packet_no;
-    m_video_frames.erase(ii);
-
-    RemoveObsoletePackets();
-
     int w = m_decoder.GetConfig().w, h = m_decoder.GetConfig().h;
     int bytes = RGB32_BYTES(w, h);
     VideoFrame vid_frame(NULL, bytes, w, h, FOURCC_RGB32, true);
     vid_frame.key_frame = false; //TODO: detect key frame
     vid_frame.stream_id = m_videostream_id;
+    //buffer comes from VideoFramePool so steady-state decoding
+    //reuses the frames the application has released
     ACE_Message_Block* mb = VideoFrameInMsgBlock(vid_frame);
+    if(!mb)
+        return;
 
     //sweep the decoder clean
     while(m_decoder.GetRGB32Image(vid_frame.frame, vid_frame.frame_length));
 
-    return mb;
+    wguard_t g(m_mutex);
+    m_decoded_frames[frame_time] = mb;
+    //application isn't extracting frames so stop decoding ahead
+    while(m_decoded_frames.size() > VPX_MAX_DECODED_FRAMES)
+    {
+        m_decoded_frames.begin()->second->release();
+        m_decoded_frames.erase(m_decoded_frames.begin());
+        m_videoframes_skipped++;
+        m_decode_ahead = false;
+    }
 }
 
 bool WebMPlayer::GetNextFrameTime(uint32_t* tm)
 {
     wguard_t g(m_mutex);
 
+    if(tm && m_decoded_frames.size())
+    {
+        *tm = m_decoded_frames.begin()->first;
+        return true;
+    }
     if(tm && m_video_frames.size())
     {
         *tm = m_video_frames.begin()->first;
@@ -909,6 +1091,121 @@ int WebMPlayer::GetVideoFramesDropped(bool reset)
         m_videoframes_dropped = 0;
     return n;
 }
+
+int WebMPlayer::GetVideoFramesSkipped(bool reset)
+{
+    wguard_t g(m_mutex);
+
+    int n = m_videoframes_skipped;
+    if(reset)
+        m_videoframes_skipped = 0;
+    return n;
+}
+
+WebMDecoderPool::WebMDecoderPool()
+: m_stopped(false)
+{
+}
+
+WebMDecoderPool::~WebMDecoderPool()
+{
+    StopThreads();
+}
+
+void WebMDecoderPool::QueueDecode(const webm_player_t& player)
+{
+    if(!player->ScheduleDecode())
+        return;
+
+    webm_player_t* job = NULL;
+    ACE_Message_Block* mb = NULL;
+    ACE_NEW_NORETURN(job, webm_player_t(player));
+    ACE_NEW_NORETURN(mb, ACE_Message_Block(sizeof(job)));
+
+    ACE_Time_Value tm_zero;
+    if(job && mb && StartThreads() &&
+       mb->copy(reinterpret_cast<const char*>(&job), sizeof(job)) >= 0 &&
+       this->putq(mb, &tm_zero) >= 0)
+        return;
+
+    //GetNextFrame() will decode instead
+    if(mb)
+        mb->release();
+    delete job;
+    player->CancelDecode();
+}
+
+bool WebMDecoderPool::StartThreads()
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+
+    if(m_stopped)
+        return false;
+    if(this->thr_count())
+        return true;
+
+    int n_threads = ACE_OS::num_processors_online();
+    n_threads = std::max(1, std::min(n_threads, VPX_DECODER_THREADS_MAX));
+    MYTRACE(ACE_TEXT("Starting %d video decoder threads\n"), n_threads);
+    return this->activate(THR_NEW_LWP | THR_JOINABLE | THR_INHERIT_SCHED,
+                          n_threads) >= 0;
+}
+
+void WebMDecoderPool::StopThreads()
+{
+    ACE_Guard<ACE_Thread_Mutex> g(m_mutex);
+
+    m_stopped = true;
+
+    size_t n_threads = this->thr_count();
+    for(size_t i=0;i<n_threads;i++)
+    {
+        ACE_Message_Block* mb;
+        ACE_NEW_NORETURN(mb, ACE_Message_Block(0, ACE_Message_Block::MB_HANGUP));
+        if(!mb || this->putq(mb) < 0)
+        {
+            if(mb)
+                mb->release();
+            this->msg_queue()->deactivate();
+            break;
+        }
+    }
+    this->wait();
+
+    //players queued after the hangups
+    this->msg_queue()->activate();
+    ACE_Message_Block* mb;
+    ACE_Time_Value tm_zero;
+    while(this->getq(mb, &tm_zero) >= 0)
+    {
+        if(mb->msg_type() != ACE_Message_Block::MB_HANGUP)
+        {
+            webm_player_t* job = *reinterpret_cast<webm_player_t**>(mb->rd_ptr());
+            (*job)->CancelDecode();
+            delete job;
+        }
+        mb->release();
+    }
+}
+
+int WebMDecoderPool::svc()
+{
+    ACE_Message_Block* mb;
+    while(this->getq(mb) >= 0)
+    {
+        if(mb->msg_type() == ACE_Message_Block::MB_HANGUP)
+        {
+            mb->release();
+            break;
+        }
+
+        webm_player_t* job = *reinterpret_cast<webm_player_t**>(mb->rd_ptr());
+        (*job)->DecodeFrames();
+        delete job;
+        mb->release();
+    }
+    return 0;
+}
 #endif
 
 }//namespace
@@ -25,6 +25,8 @@
 #define STREAMPLAYERS_H
 
 #include <ace/Bound_Ptr.h>
+#include <ace/Task.h>
+#include <ace/Singleton.h>
 
 #include <myace/MyACE.h>
 
@@ -49,6 +51,7 @@
 #endif
 #include <codec/AudioResampler.h>
 #include "VideoThread.h"
+#include "JitterBuffer.h"
 
 #define STOPPED_TALKING_DELAY 500 //msec
 
@@ -66,23 +69,6 @@ namespace teamtalk {
 
     typedef unsigned char StereoMask;
 
-    struct encframe
-    {
-        std::vector<char> enc_frames;
-        std::vector<uint16_t> enc_frame_sizes;
-        uint32_t timestamp;
-        int stream_id;
-
-        encframe() : timestamp(0), stream_id(0) {}
-        void reset()
-        {
-            timestamp = 0;
-            enc_frames.clear();
-            enc_frame_sizes.clear();
-            stream_id = 0;
-        }
-    };
-
     class AudioPlayer
 #if defined(ENABLE_SOUNDSYSTEM)
         : public soundsystem::StreamPlayer
@@ -105,9 +91,14 @@ namespace teamtalk {
         bool PlayBuffer(short* output_buffer, int n_samples);
         virtual bool DecodeFrame(const encframe& enc_frame,
                                  short* output_buffer, int n_samples) = 0;
+        // Generate audio for a lost frame. 'next_frame' is the
+        // following frame if it has been received. Returns true if
+        // frame was recovered instead of interpolated.
+        virtual bool ConcealFrame(const encframe* next_frame,
+                                  short* output_buffer, int n_samples) = 0;
 
         uint32_t GetLastPlaytime() const { return m_last_playback; }
-        uint16_t GetPlayedPacketNo() const { return m_play_pkt_no; }
+        uint16_t GetPlayedPacketNo() const { return m_jitterbuf.GetPlayPacketNo(); }
         uint32_t GetPlayedPacketTime() const { return m_played_packet_time; }
         int GetBufferedAudioMSec();
 
@@ -122,6 +113,9 @@ namespace teamtalk {
         int GetNumAudioBlocks(bool reset);
         int GetNumAudioPacketsRecv(bool reset);
         int GetNumAudioPacketsLost(bool reset);
+        int GetNumAudioPacketsLate(bool reset);
+        int GetNumAudioFramesConcealed(bool reset);
+        int GetJitterMSec();
 
         const AudioCodec& GetAudioCodec() const { return m_codec; }
 
@@ -156,13 +150,19 @@ namespace teamtalk {
         int m_new_audio_blocks;
         int m_audiopackets_recv;
         int m_audiopacket_lost;
+        int m_frames_concealed;
 
         //received frames
-        typedef std::map<uint16_t, encframe, w16_less_comp> enc_frames_t;
-        enc_frames_t m_buffer;
+        AudioJitterBuffer m_jitterbuf;
         int m_buffer_msec;
-        //current packet number being played
-        uint16_t m_play_pkt_no;
+        //frames concealed since buffer ran dry
+        int m_underrun_frames;
+        //sender is in DTX so missing frames are silence, not loss
+        bool m_dtx;
+        //local timestamp when last DTX frame was played
+        uint32_t m_dtx_time;
+        //last call to PlayBuffer() generated comfort noise
+        bool m_comfort_noise;
 
         //container for fragmented packets
         //packet no -> fragments
@@ -184,6 +184,8 @@ namespace teamtalk {
 
         bool DecodeFrame(const encframe& enc_frame,
                          short* output_buffer, int n_samples);
+        bool ConcealFrame(const encframe* next_frame,
+                          short* output_buffer, int n_samples);
 
     protected:
         void Reset();
@@ -202,6 +204,8 @@ namespace teamtalk {
 
         bool DecodeFrame(const encframe& enc_frame,
                          short* output_buffer, int n_samples);
+        bool ConcealFrame(const encframe* next_frame,
+                          short* output_buffer, int n_samples);
 
     protected:
         void Reset();
@@ -223,6 +227,13 @@ namespace teamtalk {
         ACE_Message_Block* GetNextFrame(uint32_t* timestamp = NULL);
         bool GetNextFrameTime(uint32_t* tm);
 
+        //used by WebMDecoderPool to decode frames before GetNextFrame().
+        //Only done once the application has fetched a frame.
+        //@return true if caller should queue a call to DecodeFrames()
+        bool ScheduleDecode();
+        void CancelDecode();
+        void DecodeFrames();
+
         VideoCodec GetVideoCodec() const;
         media::VideoFormat GetVideoFormat() const;
 
@@ -230,14 +241,21 @@ namespace teamtalk {
         int GetVideoFramesRecv(bool reset);
         int GetVideoFramesLost(bool reset);
         int GetVideoFramesDropped(bool reset);
+        //decoded ahead but not fetched by the application in time
+        int GetVideoFramesSkipped(bool reset);
 
         uint8_t GetStreamID() const { return m_videostream_id; }
 
         uint32_t GetLastTimeStamp() const { return m_local_timestamp; }
 
     private:
-        void ProcessVideoPacket(const VideoPacket& packet);
+        //@return true if 'packet' completed a frame
+        bool ProcessVideoPacket(const VideoPacket& packet);
         void RemoveObsoletePackets();
+        //decode oldest frame in 'm_video_frames'. Caller must hold 'm_decode_mutex'
+        void DecodeNextFrame();
+        bool NextFrameDue(uint32_t* timestamp);
+        ACE_Message_Block* PopDecodedFrame(uint32_t* timestamp);
 
         void dumpFragments();
 
@@ -246,6 +264,7 @@ namespace teamtalk {
         int m_videoframes_recv;
         int m_videoframes_lost;
         int m_videoframes_dropped;
+        int m_videoframes_skipped;
 
         uint8_t m_videostream_id;
         uint32_t m_packet_no;
@@ -267,14 +286,51 @@ namespace teamtalk {
         typedef std::map<uint32_t, enc_frame, w32_less_comp > video_frames_t;
         video_frames_t m_video_frames;
 
+        //timestamp -> RGB32 frame (sorted by UINT32 wrap)
+        typedef std::map<uint32_t, ACE_Message_Block*, w32_less_comp > decoded_frames_t;
+        decoded_frames_t m_decoded_frames;
+        bool m_decode_scheduled;
+        //application is fetching frames so decode ahead
+        bool m_decode_ahead;
+
         VpxDecoder m_decoder;
         bool m_decoder_ready;
 
         ACE_Recursive_Thread_Mutex m_mutex;
+        //serializes use of 'm_decoder'. Never acquired while holding 'm_mutex'
+        ACE_Recursive_Thread_Mutex m_decode_mutex;
     };
 
     typedef ACE_Strong_Bound_Ptr< WebMPlayer, ACE_MT_SYNCH::RECURSIVE_MUTEX > webm_player_t;
 
+    /* Worker threads shared by all WebMPlayers of all client
+     * instances. Once the application fetches frames from a
+     * WebMPlayer its frames are decoded as soon as they have been
+     * reassembled, so the application thread calling GetNextFrame()
+     * usually gets a frame which has already been decoded. A
+     * WebMPlayer is only decoded by one worker at a time since VP8
+     * frames depend on the previous frame. */
+    class WebMDecoderPool : private ACE_Task<ACE_MT_SYNCH>
+    {
+        friend class ACE_Singleton<WebMDecoderPool, ACE_Thread_Mutex>;
+        WebMDecoderPool();
+    public:
+        ~WebMDecoderPool();
+
+        //start workers if needed and queue decoding of 'player'
+        void QueueDecode(const webm_player_t& player);
+        void StopThreads();
+
+    private:
+        int svc(void);
+        bool StartThreads();
+
+        ACE_Thread_Mutex m_mutex;
+        bool m_stopped;
+    };
+
+    typedef ACE_Singleton<WebMDecoderPool, ACE_Thread_Mutex> WEBMDECODERPOOL;
+
 #endif /* ENABLE_VPX */
 }
 
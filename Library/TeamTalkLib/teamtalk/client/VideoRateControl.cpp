@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+#include "VideoRateControl.h"
+
+#include <algorithm>
+
+//loss fraction above which bitrate is reduced proportionally to loss
+#define LOSS_DECREASE_THRESHOLD     0.10
+//loss fraction which reduces bitrate even if RTT is stable
+#define LOSS_RANDOM_THRESHOLD       0.30
+//loss fraction below which bitrate may increase
+#define LOSS_INCREASE_THRESHOLD     0.02
+//RTT above baseline + max(this, baseline/2) means congestion
+#define DELAY_THRESHOLD_MSEC        50
+//bitrate reduction when RTT shows queues building up
+#define DELAY_DECREASE_MAX          0.85
+#define DELAY_DECREASE_MIN          0.5
+#define INCREASE_FACTOR             0.10
+#define INCREASE_MIN_KBPS           8
+//headroom for packet headers when splitting server's tx limit
+#define TXLIMIT_PAYLOAD_FACTOR      0.9
+
+namespace teamtalk {
+
+VideoRateControl::Receiver::Receiver()
+: last_report(0)
+, frames_recv(0)
+, frames_lost(0)
+, rtt_count(0)
+, rtt_last(0)
+{
+}
+
+int VideoRateControl::Receiver::GetBaseRTT() const
+{
+    int n = std::min(rtt_count, VIDEORATE_RTT_WINDOW);
+    if(n == 0)
+        return 0;
+    return *std::min_element(rtt_samples, rtt_samples + n);
+}
+
+VideoRateControl::VideoRateControl()
+{
+    Reset(0, 0);
+}
+
+void VideoRateControl::Reset(int max_bitrate, int max_fps)
+{
+    m_receivers.clear();
+    m_max_bitrate = max_bitrate > 0? max_bitrate : VIDEORATE_DEFAULT_BITRATE;
+    m_min_bitrate = std::min(m_max_bitrate,
+                             std::max(VIDEORATE_MIN_BITRATE, m_max_bitrate / 8));
+    m_bitrate = m_max_bitrate;
+    m_cap_bitrate = 0;
+    m_max_fps = std::max(max_fps, 1);
+    m_local_drops = 0;
+    m_loss = 0;
+    m_keyframe_pending = false;
+    m_keyframe_sent = false;
+    m_last_keyframe = 0;
+}
+
+void VideoRateControl::SetTxLimit(int bytes_per_sec, int receivers)
+{
+    if(bytes_per_sec <= 0 || receivers <= 0)
+        m_cap_bitrate = 0;
+    else
+        m_cap_bitrate = int(TXLIMIT_PAYLOAD_FACTOR * bytes_per_sec * 8 /
+                            1000 / receivers);
+}
+
+void VideoRateControl::ReceiverReport(int userid, uint32_t now, int frames_recv,
+                                      int frames_lost, int rtt_msec,
+                                      bool keyframe_request)
+{
+    Receiver& r = m_receivers[userid];
+    r.last_report = now;
+    r.frames_recv += frames_recv;
+    r.frames_lost += frames_lost;
+    if(rtt_msec >= 0)
+    {
+        r.rtt_samples[r.rtt_count % VIDEORATE_RTT_WINDOW] = rtt_msec;
+        r.rtt_count++;
+        r.rtt_last = rtt_msec;
+    }
+    if(keyframe_request)
+        m_keyframe_pending = true;
+}
+
+void VideoRateControl::LocalFramesDropped(int frames)
+{
+    m_local_drops += frames;
+}
+
+VideoRateTarget VideoRateControl::Update(uint32_t now)
+{
+    double worst_loss = 0;
+    //< 1 if a receiver's RTT is above its baseline
+    double delay_factor = 1;
+
+    receivers_t::iterator ii = m_receivers.begin();
+    while(ii != m_receivers.end())
+    {
+        Receiver& r = ii->second;
+        if(int32_t(now - r.last_report) > VIDEORATE_RECEIVER_TIMEOUT)
+        {
+            m_receivers.erase(ii++);
+            continue;
+        }
+
+        int frames = r.frames_recv + r.frames_lost;
+        if(frames > 0)
+            worst_loss = std::max(worst_loss, double(r.frames_lost) / frames);
+        r.frames_recv = r.frames_lost = 0;
+
+        if(r.rtt_count >= 3)
+        {
+            int base = r.GetBaseRTT();
+            int limit = base + std::max(DELAY_THRESHOLD_MSEC, base / 2);
+            //the further above the limit the more queued data must be drained
+            if(r.rtt_last > limit)
+                delay_factor = std::min(delay_factor, double(limit) / r.rtt_last);
+        }
+        ++ii;
+    }
+
+    m_loss = 0.5 * m_loss + 0.5 * worst_loss;
+
+    //loss without growing RTT is most likely not caused by our
+    //bitrate (e.g. wireless) so it's left to key frames to repair
+    //unless it is severe
+    bool delay_congested = delay_factor < 1;
+    double bitrate = m_bitrate;
+    if(m_loss > LOSS_DECREASE_THRESHOLD &&
+       (delay_congested || m_loss > LOSS_RANDOM_THRESHOLD))
+        bitrate *= 1.0 - 0.5 * m_loss;
+    else if(delay_congested)
+        bitrate *= std::max(DELAY_DECREASE_MIN, std::min(DELAY_DECREASE_MAX, delay_factor));
+    else if(m_local_drops > 0)
+        bitrate *= DELAY_DECREASE_MAX;
+    else if(m_loss < LOSS_INCREASE_THRESHOLD)
+        bitrate += std::max(bitrate * INCREASE_FACTOR, double(INCREASE_MIN_KBPS));
+    m_local_drops = 0;
+
+    int upper = m_max_bitrate;
+    if(m_cap_bitrate > 0)
+        upper = std::min(upper, m_cap_bitrate);
+    m_bitrate = std::max(m_min_bitrate, std::min(upper, int(bitrate)));
+
+    VideoRateTarget target;
+    target.bitrate = m_bitrate;
+
+    //below half the bitrate the frame rate is reduced so the
+    //remaining frames don't get too blurry
+    double ratio = double(m_bitrate) / m_max_bitrate;
+    if(ratio >= 0.5)
+        target.fps = m_max_fps;
+    else
+        target.fps = std::max(1, std::max(m_max_fps / 4, int(m_max_fps * ratio * 2 + 0.5)));
+
+    if(m_keyframe_pending &&
+       (!m_keyframe_sent || int32_t(now - m_last_keyframe) >= VIDEORATE_KEYFRAME_INTERVAL))
+    {
+        target.keyframe = true;
+        m_keyframe_pending = false;
+        m_keyframe_sent = true;
+        m_last_keyframe = now;
+    }
+    return target;
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2005-2018, BearWare.dk
+ * 
+ * Contact Information:
+ *
+ * Bjoern D. Rasmussen
+ * Kirketoften 5
+ * DK-8260 Viby J
+ * Denmark
+ * Email: contact@bearware.dk
+ * Phone: +45 20 20 54 59
+ * Web: http://www.bearware.dk
+ *
+ * This source code is part of the TeamTalk SDK owned by
+ * BearWare.dk. Use of this file, or its compiled unit, requires a
+ * TeamTalk SDK License Key issued by BearWare.dk.
+ *
+ * The TeamTalk SDK License Agreement along with its Terms and
+ * Conditions are outlined in the file License.txt included with the
+ * TeamTalk SDK distribution.
+ *
+ */
+
+
+#ifndef VIDEORATECONTROL_H
+#define VIDEORATECONTROL_H
+
+#include <stdint.h>
+#include <map>
+
+#define VIDEORATE_MIN_BITRATE          32    //kbit/sec
+#define VIDEORATE_DEFAULT_BITRATE      256   //kbit/sec. VP8's default target
+#define VIDEORATE_KEYFRAME_INTERVAL    1000  //msec. Minimum time between requested key frames
+#define VIDEORATE_RECEIVER_TIMEOUT     5000  //msec. Forget receiver without reports
+#define VIDEORATE_RTT_WINDOW           30    //number of RTT samples in baseline
+
+namespace teamtalk {
+
+    struct VideoRateTarget
+    {
+        int bitrate; //kbit/sec
+        int fps;
+        bool keyframe;
+        VideoRateTarget() : bitrate(0), fps(0), keyframe(false) {}
+    };
+
+    /* Congestion controller for the video capture encoder.
+     *
+     * Receivers report how many frames they received and lost since
+     * their previous report together with the round-trip time of
+     * their last report. Bitrate is cut when the worst receiver's RTT
+     * grows beyond its baseline (queues filling up) or when it sees
+     * congestion loss, and it is slowly increased again when the
+     * path is clean. Lost frames make the receiver request a key
+     * frame. The frame rate follows the bitrate so each frame keeps
+     * a reasonable number of bits. */
+    class VideoRateControl
+    {
+    public:
+        VideoRateControl();
+
+        // 'max_bitrate' in kbit/sec (0 = VP8 default). 'max_fps' is
+        // the capture frame rate.
+        void Reset(int max_bitrate, int max_fps);
+        // Server's limit in bytes/sec for all forwarded video
+        // (0 = unlimited). The limit is shared by 'receivers'.
+        void SetTxLimit(int bytes_per_sec, int receivers);
+
+        void ReceiverReport(int userid, uint32_t now, int frames_recv,
+                            int frames_lost, int rtt_msec, bool keyframe_request);
+        // Frames which never reached the encoder due to a full queue
+        void LocalFramesDropped(int frames);
+
+        // Call once per report interval
+        VideoRateTarget Update(uint32_t now);
+
+        int GetBitrate() const { return m_bitrate; }
+        int GetMaxBitrate() const { return m_max_bitrate; }
+
+    private:
+        struct Receiver
+        {
+            uint32_t last_report;
+            int frames_recv, frames_lost;
+            int rtt_samples[VIDEORATE_RTT_WINDOW];
+            int rtt_count, rtt_last;
+            Receiver();
+            int GetBaseRTT() const;
+        };
+        typedef std::map<int, Receiver> receivers_t;
+        receivers_t m_receivers;
+
+        int m_max_bitrate, m_min_bitrate, m_bitrate, m_cap_bitrate;
+        int m_max_fps;
+        int m_local_drops;
+        double m_loss; //smoothed loss fraction of worst receiver
+        bool m_keyframe_pending;
+        bool m_keyframe_sent;
+        uint32_t m_last_keyframe;
+    };
+}
+
+#endif
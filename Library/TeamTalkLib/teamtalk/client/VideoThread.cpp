@@ -24,9 +24,8 @@
 #include "VideoThread.h"
 #include <teamtalk/ttassert.h>
 #include <codec/MediaUtil.h>
-#if defined(ENABLE_LIBVIDCAP)
-#include <vidcap/converters.h>
-#endif
+#include <codec/VideoConvert.h>
+#include <algorithm>
 using namespace media;
 using namespace teamtalk;
 
@@ -47,6 +46,12 @@ VideoThread::VideoThread()
 , m_codec()
 , m_frames_passed(0)
 , m_frames_dropped(0)
+, m_target_bitrate(0)
+, m_target_fps(0)
+, m_keyframe_request(false)
+, m_queue_drops(0)
+, m_cap_fps(1)
+, m_frames_skipped(0)
 {
     m_codec.codec = CODEC_NO_CODEC;
 }
@@ -54,7 +59,8 @@ VideoThread::VideoThread()
 bool VideoThread::StartEncoder(VideoEncListener* listener,
                                const media::VideoFormat& cap_format,
                                const teamtalk::VideoCodec& codec,
-                               int max_frames_queued)
+                               int max_frames_queued,
+                               int enc_width, int enc_height)
 {
     TTASSERT(m_codec.codec == CODEC_NO_CODEC);
     if(this->thr_count() != 0)
@@ -70,8 +76,23 @@ bool VideoThread::StartEncoder(VideoEncListener* listener,
 
     m_listener = listener;
     m_cap_format = cap_format;
+    m_enc_format = cap_format;
+    if(enc_width > 0 && enc_height > 0)
+    {
+        m_enc_format.width = enc_width;
+        m_enc_format.height = enc_height;
+    }
     m_codec = codec;
 
+    m_cap_fps = 1;
+    if(cap_format.fps_denominator)
+        m_cap_fps = std::max(1, cap_format.fps_numerator / cap_format.fps_denominator);
+    m_target_bitrate = 0;
+    m_target_fps = m_cap_fps;
+    m_keyframe_request = false;
+    m_queue_drops = 0;
+    m_frames_skipped = 0;
+
     switch(codec.codec)
     {
     case CODEC_NO_CODEC :
@@ -86,12 +107,8 @@ bool VideoThread::StartEncoder(VideoEncListener* listener,
 #if defined(ENABLE_VPX)
     case CODEC_WEBM_VP8 :
     {
-        int fps = 1;
-        if(cap_format.fps_denominator)
-            fps = cap_format.fps_numerator / cap_format.fps_denominator;
-        
-        if(!m_vpx_encoder.Open(cap_format.width, cap_format.height, 
-                               m_codec.webm_vp8.rc_target_bitrate, fps))
+        if(!m_vpx_encoder.Open(m_enc_format.width, m_enc_format.height, 
+                               m_codec.webm_vp8.rc_target_bitrate, m_cap_fps))
         {
             StopEncoder();
             return false;
@@ -131,10 +148,39 @@ void VideoThread::StopEncoder()
     m_listener = NULL;
     m_packet_counter = 0;
     m_cap_format = VideoFormat();
+    m_enc_format = VideoFormat();
     m_codec = VideoCodec();
     m_frames_passed = m_frames_dropped = 0;
 }
 
+void VideoThread::SetEncoderTarget(int bitrate, int fps, bool keyframe)
+{
+    if(bitrate > 0)
+        m_target_bitrate = bitrate;
+    m_target_fps = fps;
+    if(keyframe)
+        m_keyframe_request = true;
+}
+
+int VideoThread::GetQueueDrops(bool reset)
+{
+    return reset? m_queue_drops.exchange(0) : m_queue_drops.load();
+}
+
+int VideoThread::NextFrameDuration()
+{
+    //drop capture frames evenly to reach target frame rate
+    int fps = m_target_fps;
+    int step = 1;
+    if(fps > 0 && fps < m_cap_fps)
+        step = (m_cap_fps + fps / 2) / fps;
+
+    if(++m_frames_skipped < step)
+        return 0;
+    m_frames_skipped = 0;
+    return step;
+}
+
 int VideoThread::close(u_long)
 {
     MYTRACE( ACE_TEXT("Video Encoder thread closed\n") );
@@ -151,53 +197,78 @@ int VideoThread::svc(void)
         const VideoFrame* vid = reinterpret_cast<const VideoFrame*>(mb->rd_ptr());
         VideoFrame vid_tmp = *vid;
 
-        if(vid->fourcc != FOURCC_RGB32)
+        //I420 is passed to the encoder as is. RGB32 for local preview
+        //is only made when requested, see ClientNode::AcquireVideoCaptureFrame()
+        if(vid->fourcc == FOURCC_YUY2)
         {
-            vid_tmp.frame_length = RGB32_BYTES(m_cap_format.width, m_cap_format.height);
+            vid_tmp.fourcc = FOURCC_I420;
+            vid_tmp.frame_length = I420_BYTES(vid->width, vid->height);
             ACE_Message_Block* mb_tmp = VideoFrameInMsgBlock(vid_tmp, mb->msg_type());
             if(!mb_tmp)
             {
                 mb->release();
                 continue;
             }
-            switch(vid->fourcc)
-            {
-            case FOURCC_I420 :
-            {
-#if defined(ENABLE_LIBVIDCAP)
-                vidcap_i420_to_rgb32(vid_tmp.width, vid_tmp.height,
-                                     vid->frame, vid_tmp.frame);
-#endif
-            }
-            break;
-            case FOURCC_YUY2 :
-#if defined(ENABLE_LIBVIDCAP)
-                vidcap_yuy2_to_rgb32(vid_tmp.width, vid_tmp.height,
-                                     vid->frame, vid_tmp.frame);
-#endif
-                break;
-            default :
-                TTASSERT(0);
-                mb->release();
-                mb_tmp->release();
-                continue;
-            }
+            YUY2ToI420(vid->frame, vid->width, vid->height, vid_tmp.frame);
             mb->release();
             mb = mb_tmp;
             vid = &vid_tmp;
         }
+        else if(vid->fourcc != FOURCC_RGB32 && vid->fourcc != FOURCC_I420)
+        {
+            TTASSERT(0);
+            mb->release();
+            continue;
+        }
 
         bool b = false;
-        if(mb->msg_type() == MB_ENC_VIDEOFRAME)
+        int duration = 1;
+#if defined(ENABLE_VPX)
+        if(mb->msg_type() == MB_ENC_VIDEOFRAME && m_codec.codec == CODEC_WEBM_VP8)
+        {
+            int bitrate = m_target_bitrate.exchange(0);
+            if(bitrate)
+                m_vpx_encoder.SetBitrate(bitrate);
+            if(m_keyframe_request.exchange(false))
+                m_vpx_encoder.RequestKeyFrame();
+            duration = NextFrameDuration();
+        }
+#endif
+        if(mb->msg_type() == MB_ENC_VIDEOFRAME && duration > 0)
         {
             switch(m_codec.codec)
             {
 #if defined(ENABLE_VPX)
             case CODEC_WEBM_VP8 :
             {
-                m_vpx_encoder.EncodeRGB32(vid->frame, vid->frame_length,
-                                          !vid->top_down, vid->timestamp, 
-                                          m_codec.webm_vp8.encode_deadline);
+                //'mb' stays at capture size for local preview
+                ACE_Message_Block* mb_enc = NULL;
+                const VideoFrame* enc = vid;
+                if(vid->width != m_enc_format.width ||
+                   vid->height != m_enc_format.height)
+                {
+                    mb_enc = ScaleToEncoder(*vid);
+                    if(!mb_enc)
+                    {
+                        mb->release();
+                        continue;
+                    }
+                    enc = reinterpret_cast<const VideoFrame*>(mb_enc->rd_ptr());
+                }
+
+                if(enc->fourcc == FOURCC_I420)
+                    m_vpx_encoder.EncodeI420(enc->frame, enc->frame_length,
+                                             enc->timestamp,
+                                             m_codec.webm_vp8.encode_deadline,
+                                             duration);
+                else
+                    m_vpx_encoder.EncodeRGB32(enc->frame, enc->frame_length,
+                                              !enc->top_down, enc->timestamp, 
+                                              m_codec.webm_vp8.encode_deadline,
+                                              duration);
+                if(mb_enc)
+                    mb_enc->release();
+
                 int enc_len;
                 const char* enc_data = m_vpx_encoder.GetEncodedData(enc_len);
                 b = m_listener->EncodedVideoFrame(this, mb, enc_data, enc_len,
@@ -221,6 +292,37 @@ int VideoThread::svc(void)
     return 0;
 }
 
+ACE_Message_Block* VideoThread::ScaleToEncoder(const media::VideoFrame& frm)
+{
+    //RGB32 is converted to I420 at capture size before scaling
+    ACE_Message_Block* mb_i420 = NULL;
+    const char* i420 = frm.frame;
+    if(frm.fourcc == FOURCC_RGB32)
+    {
+        VideoFrame vid_i420(NULL, I420_BYTES(frm.width, frm.height),
+                            frm.width, frm.height, FOURCC_I420, true);
+        mb_i420 = VideoFrameInMsgBlock(vid_i420);
+        if(!mb_i420)
+            return NULL;
+        RGB32ToI420(frm.frame, frm.width, frm.height, !frm.top_down, vid_i420.frame);
+        i420 = vid_i420.frame;
+    }
+
+    VideoFrame vid_enc(NULL, I420_BYTES(m_enc_format.width, m_enc_format.height),
+                       m_enc_format.width, m_enc_format.height, FOURCC_I420, true);
+    vid_enc.timestamp = frm.timestamp;
+    vid_enc.key_frame = frm.key_frame;
+    vid_enc.stream_id = frm.stream_id;
+    ACE_Message_Block* mb_enc = VideoFrameInMsgBlock(vid_enc);
+    if(mb_enc)
+        I420Scale(i420, frm.width, frm.height, vid_enc.frame,
+                  m_enc_format.width, m_enc_format.height);
+
+    if(mb_i420)
+        mb_i420->release();
+    return mb_enc;
+}
+
 void VideoThread::QueueFrame(const media::VideoFrame& video_frame, bool encode)
 {
     ACE_Message_Block* mb = VideoFrameToMsgBlock(video_frame);
@@ -238,6 +340,7 @@ void VideoThread::QueueFrame(ACE_Message_Block* mb_video,
     if(this->msg_queue()->enqueue(mb_video, &tm_zero)<0)
     {
         m_frames_dropped++;
+        m_queue_drops++;
         MYTRACE(ACE_TEXT("Dropped video frame of size %d, buffer holds %u. %d/%d\n"),
                 (int)mb_video->length(), (int)this->msg_queue()->message_bytes(), 
                 m_frames_dropped, m_frames_dropped + m_frames_passed);
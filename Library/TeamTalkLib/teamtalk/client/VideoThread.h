@@ -37,6 +37,8 @@
 
 #include <teamtalk/Common.h>
 
+#include <atomic>
+
 //Get VideoFrame from ACE_Message_Block
 #define GET_VIDEOFRAME_FROM_MB(video_frame, msg_block) \
     memcpy(&video_frame, msg_block->rd_ptr(), sizeof(video_frame))
@@ -54,7 +56,9 @@ public:
     bool StartEncoder(VideoEncListener* listener, 
                       const media::VideoFormat& cap_format,
                       const teamtalk::VideoCodec& codec,
-                      int max_frames_queued);
+                      int max_frames_queued,
+                      //frames are scaled to this size before encoding. 0 = capture size
+                      int enc_width = 0, int enc_height = 0);
     void StopEncoder();
 
     void QueueFrame(const media::VideoFrame& video_frame, bool encode);
@@ -62,20 +66,37 @@ public:
 
     const teamtalk::VideoCodec& GetCodec() const { return m_codec; }
     const media::VideoFormat& GetVideoFormat() const { return m_cap_format; }
+    const media::VideoFormat& GetEncodeFormat() const { return m_enc_format; }
+
+    //adapt encoder to network conditions. Applied by encoder thread
+    //before next frame. 'bitrate' in kbit/sec, 0 = unchanged.
+    void SetEncoderTarget(int bitrate, int fps, bool keyframe);
+    //frames dropped because encoder queue was full
+    int GetQueueDrops(bool reset);
 
 private:
     int close(u_long);
     int svc(void);
+    //returns I420 frame of 'm_enc_format' size
+    ACE_Message_Block* ScaleToEncoder(const media::VideoFrame& frm);
+    //number of capture frames next encoded frame should cover. 0 = skip frame
+    int NextFrameDuration();
 
     VideoEncListener* m_listener;
 #if defined(ENABLE_VPX)
     VpxEncoder m_vpx_encoder;
 #endif
     ACE_UINT32 m_packet_counter;
-    media::VideoFormat m_cap_format;
+    media::VideoFormat m_cap_format, m_enc_format;
     teamtalk::VideoCodec m_codec;
 
     int m_frames_passed, m_frames_dropped;
+
+    //rate control, see SetEncoderTarget()
+    std::atomic<int> m_target_bitrate, m_target_fps;
+    std::atomic<bool> m_keyframe_request;
+    std::atomic<int> m_queue_drops;
+    int m_cap_fps, m_frames_skipped;
 };
 
 typedef ACE_Strong_Bound_Ptr< VideoThread, ACE_Null_Mutex > video_thread_t;
@@ -24,6 +24,9 @@
 #include "DesktopCache.h"
 
 #include <teamtalk/ttassert.h>
+#include <myace/MyACE.h>
+
+#include <zlib.h>
 
 using namespace std;
 using namespace teamtalk;
@@ -33,6 +36,10 @@ DesktopCache::DesktopCache(int src_userid, const DesktopWindow& wnd,
 : DesktopSession(wnd)
 , m_current_desktop_time(initial_time)
 , m_pending_update_time(initial_time)
+, m_moves_base_time(initial_time)
+, m_tx_chunk_size(0)
+, m_tx_payload_size(0)
+, m_last_activity(GETTIMESTAMP())
 , m_userid(src_userid)
 {
 }
@@ -117,14 +124,22 @@ bool DesktopCache::AddDesktopPacket(const DesktopPacket& packet)
     if(W32_GT(packet_time, m_current_desktop_time))
         m_block_updates.erase(m_current_desktop_time);
 
+    //block moves are relative to the previous update
+    m_moves_base_time = m_current_desktop_time;
     //update time which will be the new current view
     m_current_desktop_time = packet_time;
     TTASSERT(packet_time == m_pending_update_time);
 
     UpdateCurrentDesktopWindow(update_packets);
 
+    //the blocks are now in 'm_blocks' so the packets are no longer
+    //needed. Retransmissions are detected by 'm_expected_packets'.
+    m_block_updates.erase(dui);
+
     LimitUpdateHistory(m_current_desktop_time, 100);
 
+    m_last_activity = GETTIMESTAMP();
+
     return true;
 }
 
@@ -170,23 +185,92 @@ bool DesktopCache::GetReceivedPackets(uint32_t upd_time,
     return true;
 }
 
+bool DesktopCache::GetUpdatedBlocks(uint32_t upd_time,
+                                    std::set<uint16_t>& block_nums) const
+{
+    map_updated_blocks_t::const_iterator ubi = m_updated_blocks.begin();
+    for(;ubi!=m_updated_blocks.end();ubi++)
+    {
+        if(W32_GT(ubi->first, upd_time))
+            block_nums.insert(ubi->second.begin(), ubi->second.end());
+    }
+    return block_nums.size();
+}
+
 bool DesktopCache::GetDesktopPackets(uint32_t last_upd_time,
                                      uint16_t max_chunk_size,
                                      uint16_t max_payload_size,
-                                     desktoppackets_t& packets) const
+                                     desktoppackets_t& packets,
+                                     bool block_moves/* = false*/) const
 {
     map_updated_blocks_t::const_iterator ubi = m_updated_blocks.find(GetCurrentDesktopTime());
     TTASSERT(ubi != m_updated_blocks.end());
     if(ubi == m_updated_blocks.end())
         return false;
 
+    m_last_activity = GETTIMESTAMP();
+
     map_updated_blocks_t::const_iterator ubi_last = m_updated_blocks.find(last_upd_time);
 
+    //an update containing all blocks is stored as current update time
+    bool all_blocks = last_upd_time == GetCurrentDesktopTime() ||
+                      ubi_last == m_updated_blocks.end();
+    uint32_t tx_key = all_blocks? GetCurrentDesktopTime() : last_upd_time;
+
+    //a receiver of the previous update can move the blocks itself
+    bool use_moves = block_moves && m_moves.size() && !all_blocks &&
+                     last_upd_time == m_moves_base_time;
+
+    //reuse the packets if another transmitter already requested them
+    if(m_tx_chunk_size != max_chunk_size || m_tx_payload_size != max_payload_size)
+    {
+        m_tx_packets.clear();
+        m_tx_move_packets.clear();
+        m_tx_chunk_size = max_chunk_size;
+        m_tx_payload_size = max_payload_size;
+    }
+    if(use_moves && m_tx_move_packets.size())
+    {
+        packets.insert(packets.end(), m_tx_move_packets.begin(), m_tx_move_packets.end());
+        return true;
+    }
+    map_desktop_updates_t::const_iterator txi = m_tx_packets.find(tx_key);
+    if(!use_moves && txi != m_tx_packets.end())
+    {
+        packets.insert(packets.end(), txi->second.begin(), txi->second.end());
+        return true;
+    }
+
     desktoppackets_t new_packets;
 
+    if(use_moves)
+    {
+        map_block_offsets_t moved_blocks;
+        GetMovedBlocks(m_moves, GetBlocksPerRow(), GetBlocksCount(), moved_blocks);
+
+        set<uint16_t> blocks_updated;
+        set<uint16_t>::const_iterator bi = ubi->second.begin();
+        for(;bi!=ubi->second.end();bi++)
+        {
+            if(moved_blocks.find(*bi) == moved_blocks.end())
+                blocks_updated.insert(*bi);
+        }
+
+        //process duplicate blocks
+        map_dup_blocks_t dups;
+        set<uint16_t> ignore_blocks;
+        DuplicateBlocks(blocks_updated, m_block_crcs,
+                        m_crc_blocks, dups, ignore_blocks);
+
+        new_packets = BuildDesktopPackets(false, m_userid,
+                                          GetCurrentDesktopTime(),
+                                          max_chunk_size, max_payload_size,
+                                          this->GetDesktopWindow(),
+                                          m_blocks, dups, &blocks_updated,
+                                          &ignore_blocks, &m_moves);
+    }
     //get all the updated block between 'current upd time' and 'last_upd_time'
-    if(last_upd_time != GetCurrentDesktopTime() &&
-       ubi_last != m_updated_blocks.end())
+    else if(!all_blocks)
     {
         set<uint16_t> blocks_updated;
         blocks_updated.insert(ubi->second.begin(), ubi->second.end());
@@ -260,13 +344,60 @@ bool DesktopCache::GetDesktopPackets(uint32_t last_upd_time,
         packets.push_back(*ldi);
     }
 
+    if(use_moves)
+        m_tx_move_packets = new_packets;
+    else
+        m_tx_packets[tx_key] = new_packets;
+
     return true;
 }
 
+namespace
+{
+    size_t GetPacketsSize(const desktoppackets_t& packets)
+    {
+        size_t bytes = 0;
+        desktoppackets_t::const_iterator ii = packets.begin();
+        for(;ii != packets.end();ii++)
+            bytes += (*ii)->GetPacketSize();
+        return bytes;
+    }
+}
+
+size_t DesktopCache::GetMemoryUsage() const
+{
+    size_t bytes = 0;
+    map_blocks_t::const_iterator bi = m_blocks.begin();
+    for(;bi != m_blocks.end();bi++)
+        bytes += bi->second.size();
+
+    map_desktop_updates_t::const_iterator ui = m_block_updates.begin();
+    for(;ui != m_block_updates.end();ui++)
+        bytes += GetPacketsSize(ui->second);
+
+    for(ui = m_tx_packets.begin();ui != m_tx_packets.end();ui++)
+        bytes += GetPacketsSize(ui->second);
+
+    bytes += GetPacketsSize(m_tx_move_packets);
+
+    return bytes;
+}
+
 void DesktopCache::UpdateCurrentDesktopWindow(const desktoppackets_t& update_packets)
 {
     set<uint16_t> upd_block_nums;
 
+    //moved blocks are copied from the previous update so they must be
+    //processed before the blocks of this update replace it
+    m_moves.clear();
+    if(update_packets.size() && update_packets.front()->GetBlockMoves(m_moves) &&
+       !MoveBlocks(m_moves, upd_block_nums))
+    {
+        MYTRACE(ACE_TEXT("Invalid block moves in desktop update %d:%u for #%d\n"),
+                GetSessionID(), m_current_desktop_time, m_userid);
+        m_moves.clear();
+    }
+
     map_block_t blocks;
     block_frags_t frags;
 
@@ -332,6 +463,109 @@ void DesktopCache::UpdateCurrentDesktopWindow(const desktoppackets_t& update_pac
     m_updated_blocks[m_current_desktop_time] = upd_block_nums;
 
     TTASSERT(m_blocks.size() == (size_t)GetBlocksCount());
+
+    //packets built for the previous update are now outdated
+    m_tx_packets.clear();
+    m_tx_move_packets.clear();
+}
+
+bool DesktopCache::MoveBlocks(const block_moves_t& moves,
+                              std::set<uint16_t>& upd_block_nums)
+{
+    map_block_offsets_t moved_blocks;
+    if(!GetMovedBlocks(moves, GetBlocksPerRow(), GetBlocksCount(), moved_blocks))
+        return false;
+
+    //the server compresses for the receivers which cannot move blocks
+    //themselves, so favour speed over size
+    z_stream dstrm = {Z_NULL};
+    if(deflateInit(&dstrm, Z_BEST_SPEED) != Z_OK)
+        return false;
+
+    bool success = true;
+    //decompressed blocks of previous update
+    map_blocks_t src_blocks;
+    //recompressed moved blocks
+    map_blocks_t new_blocks;
+    std::vector<char> region;
+
+    map_block_offsets_t::const_iterator ii = moved_blocks.begin();
+    for(;ii!=moved_blocks.end() && success;ii++)
+    {
+        DesktopRect rect = GetBlockRect(ii->first);
+        rect.x += ii->second.first;
+        rect.y += ii->second.second;
+        if(rect.x < 0 || rect.y < 0 || rect.x + rect.width > GetWidth() ||
+           rect.y + rect.height > GetHeight())
+        {
+            success = false;
+            break;
+        }
+
+        //decompress the blocks which the region spans
+        int first_block = GetBlockNo(rect.x, rect.y);
+        int last_block = GetBlockNo(rect.x + rect.width - 1, rect.y + rect.height - 1);
+        for(int h=first_block / GetBlocksPerRow();h<=last_block / GetBlocksPerRow() && success;h++)
+        {
+            for(int w=first_block % GetBlocksPerRow();w<=last_block % GetBlocksPerRow();w++)
+            {
+                uint16_t block_no = uint16_t(w + h * GetBlocksPerRow());
+                if(src_blocks.find(block_no) != src_blocks.end())
+                    continue;
+
+                map_blocks_t::const_iterator bi = m_blocks.find(block_no);
+                if(bi == m_blocks.end() || bi->second.empty())
+                {
+                    success = false;
+                    break;
+                }
+
+                z_stream istrm = {Z_NULL};
+                if(inflateInit(&istrm) != Z_OK)
+                {
+                    success = false;
+                    break;
+                }
+                std::vector<char>& block = src_blocks[block_no];
+                block.resize(BLOCK_MAX_BYTESIZE);
+                istrm.avail_in = (uInt)bi->second.size();
+                istrm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(&bi->second[0]));
+                istrm.avail_out = (uInt)block.size();
+                istrm.next_out = reinterpret_cast<Bytef*>(&block[0]);
+                success = inflate(&istrm, Z_FINISH) == Z_STREAM_END;
+                block.resize(block.size() - istrm.avail_out);
+                inflateEnd(&istrm);
+            }
+        }
+
+        if(!success || !CopyBlocksRegion(*this, src_blocks, rect, region))
+        {
+            success = false;
+            break;
+        }
+
+        deflateReset(&dstrm);
+        std::vector<char>& outbuf = new_blocks[ii->first];
+        outbuf.resize(deflateBound(&dstrm, (uLong)region.size()));
+        dstrm.avail_in = (uInt)region.size();
+        dstrm.next_in = reinterpret_cast<Bytef*>(&region[0]);
+        dstrm.avail_out = (uInt)outbuf.size();
+        dstrm.next_out = reinterpret_cast<Bytef*>(&outbuf[0]);
+        success = deflate(&dstrm, Z_FINISH) == Z_STREAM_END;
+        outbuf.resize(outbuf.size() - dstrm.avail_out);
+    }
+    deflateEnd(&dstrm);
+
+    if(!success)
+        return false;
+
+    map_blocks_t::iterator bi = new_blocks.begin();
+    for(;bi!=new_blocks.end();bi++)
+    {
+        m_blocks[bi->first].swap(bi->second);
+        upd_block_nums.insert(bi->first);
+    }
+    return true;
 }
 
 void DesktopCache::LimitUpdateHistory(uint32_t update_ref_time, int count)
@@ -30,6 +30,11 @@
 #include <teamtalk/DesktopSession.h>
 #include <teamtalk/PacketHelper.h>
 
+//a desktop session isn't evicted from cache unless it has been idle for this long
+#define DESKTOPCACHE_EVICT_IDLE_MSEC        10000
+//interval for asking the owner of an evicted session to start a new session
+#define DESKTOPCACHE_REFRESH_INTERVAL_MSEC  1000
+
 namespace teamtalk {
 
     //updateid (time) -> packets
@@ -54,14 +59,29 @@ namespace teamtalk {
         bool GetReceivedPackets(uint32_t upd_time, 
                                 std::set<uint16_t>& recv_packets) const;
 
+        //blocks updated in the updates after 'upd_time'
+        bool GetUpdatedBlocks(uint32_t upd_time,
+                              std::set<uint16_t>& block_nums) const;
+
+        //'block_moves' if receiver supports block moves
         bool GetDesktopPackets(uint32_t last_upd_time,
                                uint16_t max_chunk_size,
                                uint16_t max_payload_size,
-                               desktoppackets_t& packets) const;
+                               desktoppackets_t& packets,
+                               bool block_moves = false) const;
 
         bool IsReady() const { return !m_blocks.empty(); }
+
+        //bytes of block data and packets held by the cache
+        size_t GetMemoryUsage() const;
+        //GETTIMESTAMP() when an update last completed or was
+        //requested by a transmitter
+        uint32_t GetLastActivityTime() const { return m_last_activity; }
+
     private:
         void UpdateCurrentDesktopWindow(const desktoppackets_t& update_packets);
+        //replace moved blocks with the recompressed pixels of previous update
+        bool MoveBlocks(const block_moves_t& moves, std::set<uint16_t>& upd_block_nums);
         void LimitUpdateHistory(uint32_t update_ref_time, int count);
         //container of the packets which were part of an update
         //(for now this could actually be a vector, since only the latest 
@@ -83,6 +103,18 @@ namespace teamtalk {
         map_block_crc_t m_block_crcs;
         //crc value for blocks
         map_crc_blocks_t m_crc_blocks;
+        //packets built by GetDesktopPackets() for the current update
+        //so transmitters starting from the same update share them
+        //(last update time -> packets)
+        mutable map_desktop_updates_t m_tx_packets;
+        //packets of current update with block moves for receivers of
+        //'m_moves_base_time'
+        mutable desktoppackets_t m_tx_move_packets;
+        //blocks moved in current update from update 'm_moves_base_time'
+        block_moves_t m_moves;
+        uint32_t m_moves_base_time;
+        mutable uint16_t m_tx_chunk_size, m_tx_payload_size;
+        mutable uint32_t m_last_activity;
         //owner user id
         int m_userid;
     };
@@ -58,6 +58,7 @@ ServerNode::ServerNode(const ACE_TString& version,
 #endif
                        , m_def_acceptor(tcpReactor)
                        , m_packethandler(udpReactor)
+                       , m_udpbundling(false)
                        , m_timer_reactor(timerReactor)
                        , m_srvguard(pListener)
                        , m_onesec_timerid(-1)
@@ -570,6 +571,8 @@ int ServerNode::TimerEvent(ACE_UINT32 timer_event_id, long userdata)
 
         UpdateSoloTransmitChannels();
 
+        LimitDesktopCaches();
+
         break;
     }
     case TIMER_DESKTOPACKPACKET_ID :
@@ -778,7 +781,10 @@ bool ServerNode::RetransmitDesktopPackets(int src_userid, int dest_userid)
     TTASSERT(chan == dest_user->GetChannel());
 
     desktoppackets_t rtx_packets;
-    desktop_tx->GetLostDesktopPackets(DESKTOP_DEFAULT_RTX_TIMEOUT, rtx_packets, 1);
+    desktop_tx->GetLostDesktopPackets(desktop_tx->GetRTxTimeout(), rtx_packets, 1);
+    //packets held back by pacing
+    if(rtx_packets.empty())
+        desktop_tx->GetNextDesktopPackets(rtx_packets);
     desktoppackets_t::iterator dpi = rtx_packets.begin();
 //     MYTRACE_COND(dpi == rtx_packets.end(), ACE_TEXT("No packets for RTO\n"));
     for(;dpi != rtx_packets.end();dpi++)
@@ -899,9 +905,10 @@ bool ServerNode::StartDesktopTransmitter(const ServerUser& src_user,
                                       tm_data.userdata));
     if(th)
     {
+        //check often since retransmission timeout is based on round-trip
         long timerid = m_timer_reactor->schedule_timer(th, 0, 
-                                                    DESKTOP_DEFAULT_RTX_TIMEOUT, 
-                                                    DESKTOP_DEFAULT_RTX_TIMEOUT);
+                                                    DESKTOP_RTX_TIMER_INTERVAL, 
+                                                    DESKTOP_RTX_TIMER_INTERVAL);
         if(timerid>=0)
             m_desktop_rtx_timers[tm_data.userdata] = timerid;
     }
@@ -940,6 +947,82 @@ void ServerNode::StopDesktopTransmitter(const ServerUser& src_user,
     }
 }
 
+void ServerNode::LimitDesktopCaches()
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    if(m_properties.desktopcachesize <= 0)
+        return;
+
+    uint32_t now = GETTIMESTAMP();
+    ACE_INT64 total = 0;
+    //idle time -> user (idle for longest time is last)
+    std::multimap<uint32_t, serveruser_t> idle_users;
+    for(mapusers_t::iterator ii=m_mUsers.begin();ii!=m_mUsers.end();ii++)
+    {
+        desktop_cache_t desktop = ii->second->GetDesktopSession();
+        if(desktop.null())
+            continue;
+        total += desktop->GetMemoryUsage();
+        //older clients ignore the request for a new session so
+        //their sessions must be kept
+        if(!ProtocolSameOrLater(ii->second->GetStreamProtocol(),
+                                TEAMTALK_PROTOCOL_DESKTOPREFRESH))
+            continue;
+        //don't evict a session which is being updated
+        if(desktop->GetMissingPacketsCount(desktop->GetPendingUpdateTime()) > 0)
+            continue;
+        uint32_t idle = now - desktop->GetLastActivityTime();
+        if(idle >= DESKTOPCACHE_EVICT_IDLE_MSEC)
+            idle_users.insert(std::make_pair(idle, ii->second));
+    }
+
+    //transmitters keep a reference to the packets they're sending so
+    //active transmissions complete after eviction
+    std::multimap<uint32_t, serveruser_t>::reverse_iterator ui = idle_users.rbegin();
+    for(;ui != idle_users.rend() && total > m_properties.desktopcachesize;ui++)
+    {
+        desktop_cache_t desktop = ui->second->GetDesktopSession();
+        total -= desktop->GetMemoryUsage();
+        MYTRACE(ACE_TEXT("Evicting desktop session %d:%u of #%d, idle %u msec. Cache size %d KB\n"),
+                desktop->GetSessionID(), desktop->GetCurrentDesktopTime(),
+                ui->second->GetUserID(), ui->first, int(total / 1024));
+        ui->second->EvictDesktopSession();
+    }
+}
+
+void ServerNode::RequestDesktopRefresh(ServerUser& user)
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    if(!user.DesktopRefreshDue(GETTIMESTAMP()))
+        return;
+
+    serverchannel_t chan = user.GetChannel();
+    if(chan.null())
+        return;
+
+    //a NAK of the user's own session makes the client start a new session
+    DesktopNakPacket nak_pkt(user.GetUserID(), user.GetEvictedDesktopUpdateID(),
+                             user.GetEvictedDesktopSessionID());
+    nak_pkt.SetChannel(chan->GetChannelID());
+#ifdef ENABLE_ENCRYPTION
+    if(m_crypt_acceptor.get_handle() != ACE_INVALID_HANDLE)
+    {
+        CryptDesktopNakPacket crypt_pkt(nak_pkt, chan->GetEncryptKey());
+        SendPacket(crypt_pkt, user.GetUdpAddress());
+    }
+    else
+    {
+        SendPacket(nak_pkt, user.GetUdpAddress());
+    }
+#else
+    SendPacket(nak_pkt, user.GetUdpAddress());
+#endif
+    MYTRACE(ACE_TEXT("Requested new desktop session from #%d to replace evicted session %d\n"),
+            user.GetUserID(), user.GetEvictedDesktopSessionID());
+}
+
 bool ServerNode::StartServer(bool encrypted, const ACE_TString& sysid)
 {
     GUARD_OBJ(this, lock());
@@ -1355,7 +1438,11 @@ int ServerNode::SendPackets(const FieldPacket& packet,
             continue;
 
         //ok to send packet
-        ssize_t ret = m_packethandler.sock_i().send(vv, buffers, vecaddr[i]);
+        ssize_t ret;
+        if(m_udpbundling && BundlePacket(packet, vecaddr[i]))
+            ret = packet.GetPacketSize();
+        else
+            ret = m_packethandler.sock_i().send(vv, buffers, vecaddr[i]);
         TTASSERT(ret);
         if(ret<=0)
             continue;
@@ -1387,6 +1474,16 @@ int ServerNode::SendPackets(const FieldPacket& packet,
             m_stats.vidcap_bytessent += ret;
 #if defined(ENABLE_ENCRYPTION)
             TTASSERT(m_crypt_acceptor.get_handle() != ACE_INVALID_HANDLE);
+#endif
+            break;
+        case PACKET_KIND_VIDEOFEEDBACK :
+            m_stats.vidcap_bytessent += ret;
+            TTASSERT(m_def_acceptor.get_handle() != ACE_INVALID_HANDLE);
+            break;
+        case PACKET_KIND_VIDEOFEEDBACK_CRYPT :
+            m_stats.vidcap_bytessent += ret;
+#if defined(ENABLE_ENCRYPTION)
+            TTASSERT(m_crypt_acceptor.get_handle() != ACE_INVALID_HANDLE);
 #endif
             break;
         case PACKET_KIND_MEDIAFILE_AUDIO :
@@ -1430,6 +1527,105 @@ int ServerNode::SendPackets(const FieldPacket& packet,
     return (int)sent;
 }
 
+bool ServerNode::BundlePacket(const FieldPacket& packet, const ACE_INET_Addr& addr)
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    wguard_t g(m_sendmutex);
+
+    std::map<ACE_INET_Addr, int>::const_iterator ic = m_container_users.find(addr);
+    if(ic == m_container_users.end())
+        return false;
+
+    serveruser_t user = GetUser(ic->second);
+    if(user.null() || user->GetUdpAddress() != addr)
+        return false;
+
+    //a packet which cannot share a datagram with a packet of the same
+    //size is sent as it is. Bundled packets go first to keep order.
+    uint16_t max_packet_size = user->GetMaxPayloadSize();
+    if(packet.GetPacketSize() > max_packet_size / 2)
+    {
+        SendBundledPackets(addr);
+        return false;
+    }
+
+    container_packet_t& container = m_udpbundles[addr];
+    if(container && !container->AddPacket(packet, max_packet_size))
+        SendBundledPackets(addr);
+
+    if(!container)
+    {
+        container.reset(new ContainerPacket(0, GETTIMESTAMP()));
+        if(!container->AddPacket(packet, max_packet_size))
+        {
+            container.reset();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ServerNode::SendBundledPackets(const ACE_INET_Addr& addr)
+{
+    wguard_t g(m_sendmutex);
+
+    udpbundles_t::iterator ib = m_udpbundles.find(addr);
+    if(ib == m_udpbundles.end() || !ib->second)
+        return;
+
+    container_packet_t container;
+    container.swap(ib->second);
+
+    ssize_t ret;
+    if(container->GetPacketCount() == 1)
+    {
+        //a single packet is sent without the container header
+        std::vector<iovec> packets = container->GetPackets();
+        TTASSERT(packets.size() == 1);
+        ret = m_packethandler.sock_i().send(&packets[0], 1, addr);
+    }
+    else
+    {
+        int buffers;
+        const iovec* vv = container->GetPacket(buffers);
+        ret = m_packethandler.sock_i().send(vv, buffers, addr);
+        //the contained packets were counted by SendPackets()
+        if(ret > 0)
+            m_stats.total_bytessent += TT_CHANNEL_HEADER_SIZE +
+                FIELDVALUE_PREFIX * container->GetPacketCount();
+    }
+    TTASSERT(ret > 0);
+}
+
+void ServerNode::SetUserUdpAddress(ServerUser& user, const ACE_INET_Addr& addr)
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    std::map<ACE_INET_Addr, int>::iterator ic = m_container_users.find(user.GetUdpAddress());
+    if(ic != m_container_users.end() && ic->second == user.GetUserID())
+        m_container_users.erase(ic);
+
+    user.SetUdpAddress(addr);
+
+    if(user.GetPacketProtocol() >= TEAMTALK_CONTAINER_PACKET_PROTOCOL)
+        m_container_users[addr] = user.GetUserID();
+}
+
+void ServerNode::ReceivedPacketsDone()
+{
+    GUARD_OBJ(this, lock());
+
+    wguard_t g2(m_sendmutex);
+
+    m_udpbundling = false;
+    while(m_udpbundles.size())
+    {
+        SendBundledPackets(m_udpbundles.begin()->first);
+        m_udpbundles.erase(m_udpbundles.begin());
+    }
+}
+
 void ServerNode::ReceivedPacket(const char* packet_data, int packet_size, 
                                 const ACE_INET_Addr& addr)
 {
@@ -1472,6 +1668,41 @@ void ServerNode::ReceivedPacket(const char* packet_data, int packet_size,
         return;
     }
 
+    //packets forwarded while handling this batch of received
+    //packets are bundled until ReceivedPacketsDone()
+    {
+        wguard_t g2(m_sendmutex);
+        m_udpbundling = true;
+    }
+
+    if(packet.GetKind() == PACKET_KIND_CONTAINER)
+    {
+        ContainerPacket container(packet_data, packet_size);
+        std::vector<iovec> packets = container.GetPackets();
+        for(size_t i=0;i<packets.size();i++)
+        {
+            const char* data = reinterpret_cast<const char*>(packets[i].iov_base);
+            FieldPacket p(data, uint16_t(packets[i].iov_len));
+            //a user can only bundle its own packets and containers
+            //cannot be nested
+            if(p.ValidatePacket() && p.GetSrcUserID() == user->GetUserID() &&
+               p.GetKind() != PACKET_KIND_CONTAINER)
+                DispatchPacket(user, data, int(packets[i].iov_len), addr);
+        }
+        return;
+    }
+
+    DispatchPacket(user, packet_data, packet_size, addr);
+}
+
+void ServerNode::DispatchPacket(const serveruser_t& user,
+                                const char* packet_data, int packet_size,
+                                const ACE_INET_Addr& addr)
+{
+    ASSERT_REACTOR_LOCKED(this);
+
+    FieldPacket packet(packet_data, packet_size);
+
     switch(packet.GetKind())
     {
     case PACKET_KIND_HELLO :
@@ -1624,6 +1855,20 @@ void ServerNode::ReceivedPacket(const char* packet_data, int packet_size,
                                       addr);
         m_stats.desktop_bytesreceived += packet_size;
         break;
+#ifdef ENABLE_ENCRYPTION
+    case PACKET_KIND_VIDEOFEEDBACK_CRYPT :
+        ReceivedVideoFeedbackPacket(*user,
+                                    CryptVideoFeedbackPacket(packet_data, packet_size),
+                                    addr);
+        m_stats.vidcap_bytesreceived += packet_size;
+        break;
+#endif
+    case PACKET_KIND_VIDEOFEEDBACK :
+        ReceivedVideoFeedbackPacket(*user,
+                                    VideoFeedbackPacket(packet_data, packet_size),
+                                    addr);
+        m_stats.vidcap_bytesreceived += packet_size;
+        break;
     default :
         MYTRACE(ACE_TEXT("Received an unknown packet %d from #%d\n"),
                 (int)packet.GetKind(), packet.GetSrcUserID());
@@ -1644,8 +1889,8 @@ void ServerNode::ReceivedHelloPacket(ServerUser& user,
     if(user.GetUdpAddress() != addr && user.GetUdpAddress() != ACE_INET_Addr())
         m_updUserIPs.insert(user.GetUserID());
 
-    user.SetUdpAddress(addr);
     user.SetPacketProtocol(version);
+    SetUserUdpAddress(user, addr);
 
     //send acknowledge packet
     HelloPacket ackpacket((uint16_t)0, packet.GetTime());
@@ -1666,7 +1911,7 @@ void ServerNode::ReceivedKeepAlivePacket(ServerUser& user,
     KeepAlivePacket ka_pkt(v, buffers);
     uint16_t payload_data_size = ka_pkt.GetPayloadSize();
     bool is_set = false;
-    if(payload_data_size > 0 && 
+    if(payload_data_size > 0 && payload_data_size <= MAX_PMTU_PAYLOAD_DATA_SIZE &&
        (W32_GEQ(packet.GetTime(), user.GetLastTimeStamp(&is_set)) || !is_set))
     {
         user.SetMaxDataChunkSize(payload_data_size);
@@ -1679,7 +1924,7 @@ void ServerNode::ReceivedKeepAlivePacket(ServerUser& user,
     KeepAlivePacket reply((uint16_t)0, packet.GetTime());
     if(addr != user.GetUdpAddress())
     {
-        user.SetUdpAddress(addr);
+        SetUserUdpAddress(user, addr);
         m_updUserIPs.insert(user.GetUserID());
     }
     SendPacket(reply, user.GetUdpAddress());
@@ -1726,7 +1971,7 @@ serverchannel_t ServerNode::GetPacketChannel(ServerUser& user,
     //update IP if changed
     if(addr != user.GetUdpAddress())
     {
-        user.SetUdpAddress(addr);
+        SetUserUdpAddress(user, addr);
         m_updUserIPs.insert(user.GetUserID());
     }
 
@@ -1872,6 +2117,15 @@ void ServerNode::ReceivedVoicePacket(ServerUser& user,
     if(!tx_ok)
         return;
 
+    //encrypted packets' stream fields cannot be inspected
+    if(packet.GetKind() == PACKET_KIND_VOICE &&
+       GetAudioCodecDTXMode(chan.GetAudioCodec()))
+    {
+        int frame_msec = GetAudioCodecCbMillis(chan.GetAudioCodec());
+        m_stats.voice_frames_suppressed += 
+            user.AddVoicePacket(static_cast<const VoicePacket&>(packet), frame_msec);
+    }
+
     vector<ACE_INET_Addr> addrs;
     GetPacketDestinations(user, chan, packet, SUBSCRIBE_VOICE,
                           SUBSCRIBE_INTERCEPT_VOICE, addrs);
@@ -2003,6 +2257,14 @@ void ServerNode::ReceivedDesktopPacket(ServerUser& user,
     if(!chan.CanTransmit(user.GetUserID(), STREAMTYPE_DESKTOP))
        return;
 
+    //session was evicted from cache so it can't be forwarded
+    if(user.GetEvictedDesktopSessionID() &&
+       user.GetEvictedDesktopSessionID() == packet.GetSessionID())
+    {
+        RequestDesktopRefresh(user);
+        return;
+    }
+
     uint8_t prev_session_id = 0;
     uint32_t prev_update_id = 0;
     bool prev_session_ready = false;
@@ -2087,7 +2349,14 @@ void ServerNode::ReceivedDesktopPacket(ServerUser& user,
             if(dtx->GetSessionID() != desktop.GetSessionID())
                 StopDesktopTransmitter(user, *(*ui), false);
             else if(!dtx->Done())
+            {
+                //a lossy receiver shouldn't spend its bandwidth on
+                //blocks which the new update replaces
+                std::set<uint16_t> newer_blocks;
+                if(desktop.GetUpdatedBlocks(dtx->GetUpdateID(), newer_blocks))
+                    dtx->SupersedeBlocks(newer_blocks);
                 continue; //skip new transmitter if one is already active
+            }
         }
         MYTRACE(ACE_TEXT("Starting new DTX for #%d\n"), (*ui)->GetUserID());
         //start or resume transmitter
@@ -2486,6 +2755,58 @@ void ServerNode::ReceivedDesktopInputAckPacket(ServerUser& user,
     }
 }
 
+#ifdef ENABLE_ENCRYPTION
+void ServerNode::ReceivedVideoFeedbackPacket(ServerUser& user, 
+                                             const CryptVideoFeedbackPacket& crypt_pkt, 
+                                             const ACE_INET_Addr& addr)
+{
+    serverchannel_t tmp_chan = GetPacketChannel(user, crypt_pkt, addr);
+    if(tmp_chan.null())
+        return;
+
+    ServerChannel& chan = *tmp_chan;
+
+    VideoFeedbackPacket* tmp_pkt = crypt_pkt.Decrypt(chan.GetEncryptKey());
+    if(!tmp_pkt)
+        return;
+    VideoFeedbackPacket& packet = *tmp_pkt;
+    packet_ptr_t ptr(tmp_pkt);
+
+    ReceivedVideoFeedbackPacket(user, packet, addr);
+}
+#endif
+
+void ServerNode::ReceivedVideoFeedbackPacket(ServerUser& user, 
+                                             const VideoFeedbackPacket& packet, 
+                                             const ACE_INET_Addr& addr)
+{
+    serverchannel_t tmp_chan = GetPacketChannel(user, packet, addr);
+    if(tmp_chan.null())
+        return;
+
+    ServerChannel& chan = *tmp_chan;
+
+    //only relay to the video's owner in the same channel
+    serveruser_t dest_user = GetUser(packet.GetDestUserID());
+    if(dest_user.null() || dest_user->GetChannel() != tmp_chan)
+        return;
+
+#ifdef ENABLE_ENCRYPTION
+    if(m_crypt_acceptor.get_handle() != ACE_INVALID_HANDLE)
+    {
+        CryptVideoFeedbackPacket crypt_pkt(packet, chan.GetEncryptKey());
+        SendPacket(crypt_pkt, dest_user->GetUdpAddress());
+    }
+    else
+    {
+        SendPacket(packet, dest_user->GetUdpAddress());
+    }
+#else
+    ACE_UNUSED_ARG(chan);
+    SendPacket(packet, dest_user->GetUdpAddress());
+#endif
+}
+
 void ServerNode::CheckKeepAlive()
 {
     ASSERT_REACTOR_LOCKED(this);
@@ -2900,6 +3221,11 @@ ErrorMsg ServerNode::UserJoinChannel(int userid, const ChannelProp& chanprop)
             long timerid = m_timer_reactor->schedule_timer(th, 0, ACE_Time_Value(1));
             TTASSERT(timerid>=0);
         }
+        else if(users[i]->GetEvictedDesktopSessionID() &&
+                (user->GetSubscriptions(*users[i]) & SUBSCRIBE_DESKTOP))
+        {
+            RequestDesktopRefresh(*users[i]);
+        }
         //TODO: user could actually reuse the desktop session (but restarts at the moment)
 //         if(!user->GetDesktopSession().null() && 
 //            users[i]->GetUserID() != user->GetUserID())
@@ -3005,6 +3331,9 @@ void ServerNode::UserDisconnected(int userid)
             m_filetransfers.erase(user->GetFileTransferID());
 
         m_updUserIPs.erase(userid);
+        std::map<ACE_INET_Addr, int>::iterator ic = m_container_users.find(user->GetUdpAddress());
+        if(ic != m_container_users.end() && ic->second == userid)
+            m_container_users.erase(ic);
         m_mUsers.erase(userid);
         TTASSERT(m_rootchannel.null() || m_rootchannel->GetUser(userid) == NULL);
     }
@@ -106,6 +106,9 @@ namespace teamtalk {
     struct ServerProperties : public ServerProp
     {
         ACE_TString filesroot; //files root directory            
+        //soft limit of bytes for all desktop sessions (0 = unlimited),
+        //see LimitDesktopCaches()
+        ACE_INT64 desktopcachesize;
 
         ServerProperties()
             {
@@ -114,6 +117,7 @@ namespace teamtalk {
                 diskquota = 0;
                 maxdiskusage = 0;
                 usertimeout = USER_TIMEOUT;
+                desktopcachesize = 0;
             }
     };
 
@@ -165,10 +169,27 @@ namespace teamtalk {
         //send udp packet
         int SendPacket(const FieldPacket& packet, const ACE_INET_Addr& addr);
         int SendPackets(const FieldPacket& packet, const std::vector< ACE_INET_Addr >& vecaddr);
+        //bundle packets to the same user while handling received packets
+        bool BundlePacket(const FieldPacket& packet, const ACE_INET_Addr& addr);
+        void SendBundledPackets(const ACE_INET_Addr& addr);
+        void SetUserUdpAddress(ServerUser& user, const ACE_INET_Addr& addr);
+        //get destination IP-addresses and users of packet
+        void GetPacketDestinations(const ServerUser& user,
+                                   const ServerChannel& channel,
+                                   const FieldPacket& packet,
+                                   Subscriptions subscrip_check,
+                                   Subscriptions intercept_check,
+                                   std::vector<ACE_INET_Addr>& addrs,
+                                   std::list<serveruser_t>* dest_users = NULL);
 
         //UDP packet handling functions
         void ReceivedPacket(const char* packet_data, int packet_size, 
                             const ACE_INET_Addr& addr);
+        void ReceivedPacketsDone();
+        //handle packet which is not a container
+        void DispatchPacket(const serveruser_t& user,
+                            const char* packet_data, int packet_size,
+                            const ACE_INET_Addr& addr);
         void ReceivedHelloPacket(ServerUser& user, const HelloPacket& packet, 
                                  const ACE_INET_Addr& addr);
         void ReceivedKeepAlivePacket(ServerUser& user, const KeepAlivePacket& packet, 
@@ -239,6 +260,14 @@ namespace teamtalk {
         void ReceivedDesktopInputAckPacket(ServerUser& user, 
                                            const DesktopInputAckPacket& packet, 
                                            const ACE_INET_Addr& addr);
+#ifdef ENABLE_ENCRYPTION
+        void ReceivedVideoFeedbackPacket(ServerUser& user, 
+                                         const CryptVideoFeedbackPacket& crypt_pkt, 
+                                         const ACE_INET_Addr& addr);
+#endif
+        void ReceivedVideoFeedbackPacket(ServerUser& user, 
+                                         const VideoFeedbackPacket& packet, 
+                                         const ACE_INET_Addr& addr);
 
         //server properties
         void SetServerProperties(const ServerProperties& srvprop);
@@ -360,14 +389,6 @@ namespace teamtalk {
         serverchannel_t GetPacketChannel(ServerUser& user,
                                          const FieldPacket& packet,
                                          const ACE_INET_Addr& addr);
-        //get destination IP-addresses and users of packet
-        void GetPacketDestinations(const ServerUser& user,
-                                   const ServerChannel& channel,
-                                   const FieldPacket& packet,
-                                   Subscriptions subscrip_check,
-                                   Subscriptions intercept_check,
-                                   std::vector<ACE_INET_Addr>& addrs,
-                                   std::list<serveruser_t>* dest_users = NULL);
         //send desktop ack packet (client desktop -> server)
         bool SendDesktopAckPacket(int userid);
         //process desktop transmitter (server -> client)
@@ -380,6 +401,15 @@ namespace teamtalk {
         void StopDesktopTransmitter(const ServerUser& src_user,
                                     ServerUser& dest_user,
                                     bool start_nak_timer);
+        //evict idle desktop sessions when over 'desktopcachesize'. The
+        //limit is soft: it's only checked once a second by
+        //TIMER_ONE_SECOND_ID and only sessions which have been idle for
+        //DESKTOPCACHE_EVICT_IDLE_MSEC and whose owner supports
+        //TEAMTALK_PROTOCOL_DESKTOPREFRESH are evicted. The total can
+        //therefore stay above the limit.
+        void LimitDesktopCaches();
+        //ask owner of evicted desktop session to start a new session
+        void RequestDesktopRefresh(ServerUser& user);
 
         //all connected users
         typedef std::map<int, serveruser_t> mapusers_t;
@@ -402,6 +432,12 @@ namespace teamtalk {
         PacketHandler m_packethandler;
         //mutex for clients
         ACE_Recursive_Thread_Mutex m_sendmutex;
+        //UDP address -> user ID of users who accept PACKET_KIND_CONTAINER
+        std::map<ACE_INET_Addr, int> m_container_users;
+        //packets bundled per destination until ReceivedPacketsDone()
+        typedef std::map<ACE_INET_Addr, container_packet_t> udpbundles_t;
+        udpbundles_t m_udpbundles;
+        bool m_udpbundling;
         //the channels
         serverchannel_t m_rootchannel;
 
@@ -50,6 +50,12 @@ ServerUser::ServerUser(int userid,
                        , m_servernode(servernode) //init parent class
                        , m_stream_handle(h)
                        , m_cmdsuspended(false)
+                       , m_voice_stream_id(0)
+                       , m_voice_pkt_no(0)
+                       , m_voice_pkt_time(0)
+                       , m_desktop_evicted_id(0)
+                       , m_desktop_evicted_upd(0)
+                       , m_desktop_refresh_time(0)
 {
     //MYTRACE("StreamHandler for userid %d is %d\n", GetUserID(), handler.get_handle());
     //TTASSERT(handler.get_handle() != ACE_INVALID_HANDLE);
@@ -1733,6 +1739,7 @@ void ServerUser::DoServerStats()
     AppendProperty(TT_FILESTX, stats.files_bytessent, command);
     AppendProperty(TT_FILESRX, stats.files_bytesreceived, command);
     AppendProperty(TT_UPTIME, (ACE_INT64)msec, command);
+    AppendProperty(TT_VOICESUPPRESSED, stats.voice_frames_suppressed, command);
     command += EOL;
 
     TransmitCommand(command);
@@ -1772,8 +1779,47 @@ void ServerUser::TransmitCommand(const ACE_TString& cmdline)
     }
 }
 
+int ServerUser::AddVoicePacket(const VoicePacket& packet, int frame_msec)
+{
+    uint8_t frag_no = AudioPacket::INVALID_FRAGMENT_NO;
+    uint16_t pkt_no;
+    if(packet.HasFragments())
+        pkt_no = packet.GetPacketNumberAndFragNo(frag_no, NULL);
+    else
+        pkt_no = packet.GetPacketNumber();
+
+    //only first fragment counts
+    if(frag_no != AudioPacket::INVALID_FRAGMENT_NO && frag_no != 0)
+        return 0;
+
+    int suppressed = 0;
+    uint8_t stream_id = packet.GetStreamID();
+    if(stream_id == m_voice_stream_id)
+    {
+        //suppressed frames don't consume packet numbers so a gap in
+        //time stamps between consecutive packets is DTX. Allow half
+        //a frame of jitter on sender's timer.
+        uint32_t gap = packet.GetTime() - m_voice_pkt_time;
+        if(pkt_no == uint16_t(m_voice_pkt_no + 1) && frame_msec > 0 &&
+           W32_GT(gap, frame_msec + frame_msec / 2))
+            suppressed = (gap + frame_msec / 2) / frame_msec - 1;
+
+        if(!PACKETNO_GEQ(pkt_no, m_voice_pkt_no))
+            return suppressed;
+    }
+
+    m_voice_stream_id = stream_id;
+    m_voice_pkt_no = pkt_no;
+    m_voice_pkt_time = packet.GetTime();
+    return suppressed;
+}
+
 bool ServerUser::AddDesktopPacket(const DesktopPacket& packet)
 {
+    //wait for new session if current session was evicted
+    if(m_desktop_evicted_id && m_desktop_evicted_id == packet.GetSessionID())
+        return false;
+
     if(!m_desktop_cache.null() && 
         m_desktop_cache->GetSessionID() != packet.GetSessionID() &&
         W32_GEQ(packet.GetTime(), m_desktop_cache->GetCurrentDesktopTime()))
@@ -1811,6 +1857,7 @@ bool ServerUser::AddDesktopPacket(const DesktopPacket& packet)
                        false);
 
         m_desktop_cache = desktop_cache_t(dcache);
+        m_desktop_evicted_id = 0;
         TTASSERT(m_desktop_cache->GetBlocksCount());
         if(m_desktop_cache->GetBlocksCount() == 0)
         {
@@ -1840,6 +1887,32 @@ void ServerUser::CloseDesktopSession()
 {
     m_desktop_cache.reset();
     m_desktop_queue.clear();
+    m_desktop_evicted_id = 0;
+}
+
+void ServerUser::EvictDesktopSession()
+{
+    if(m_desktop_cache.null())
+        return;
+
+    m_desktop_evicted_id = m_desktop_cache->GetSessionID();
+    m_desktop_evicted_upd = m_desktop_cache->GetCurrentDesktopTime();
+    m_desktop_refresh_time = 0;
+    m_desktop_cache.reset();
+    m_desktop_queue.clear();
+}
+
+bool ServerUser::DesktopRefreshDue(uint32_t tm)
+{
+    if(!m_desktop_evicted_id)
+        return false;
+
+    if(m_desktop_refresh_time &&
+       W32_LT(tm, m_desktop_refresh_time + DESKTOPCACHE_REFRESH_INTERVAL_MSEC))
+        return false;
+
+    m_desktop_refresh_time = tm;
+    return true;
 }
 
 desktop_transmitter_t ServerUser::StartDesktopTransmitter(
@@ -1902,15 +1975,23 @@ desktop_transmitter_t ServerUser::ResumeDesktopTransmitter(
 
     //place updated packets in transmission queue
     desktoppackets_t packets;
+    //receivers of the previous update can move blocks themselves
+    //unless they didn't get the blocks which were superseded
+    bool block_moves = ProtocolSameOrLater(GetStreamProtocol(),
+                                           TEAMTALK_PROTOCOL_DESKTOPMOVE) &&
+                       !dtx->HasSupersededBlocks();
     if(!desktop.GetDesktopPackets(last_update_time, 
                                   src_user.GetMaxDataChunkSize(),
-                                  src_user.GetMaxPayloadSize(), packets))
+                                  src_user.GetMaxPayloadSize(), packets,
+                                  block_moves))
         return desktop_transmitter_t();
     
     DesktopTransmitter* desktop_tx;
     ACE_NEW_RETURN(desktop_tx, DesktopTransmitter(desktop.GetSessionID(),
                                                   desktop.GetCurrentDesktopTime()),
                    desktop_transmitter_t());
+    //pacing is per receiver so keep what was learned in previous update
+    desktop_tx->CopyCongestionState(*dtx);
     dtx = desktop_transmitter_t(desktop_tx);
 
     desktoppackets_t::iterator dpi = packets.begin();
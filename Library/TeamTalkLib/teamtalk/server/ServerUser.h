@@ -167,11 +167,22 @@ namespace teamtalk {
         void DoOk();
         void DoQuit();
 
+        //returns number of frames which a DTX sender didn't transmit
+        //between the previous and this voice packet
+        int AddVoicePacket(const VoicePacket& packet, int frame_msec);
+
         //desktop packets processing from this user
         bool AddDesktopPacket(const DesktopPacket& packet);
         const desktoppackets_t& GetDesktopSessionQueue() const { return m_desktop_queue; }
         const desktop_cache_t& GetDesktopSession() const { return m_desktop_cache; }
         void CloseDesktopSession();
+        //drop desktop session from cache. The user must start a new
+        //session before it can be forwarded again.
+        void EvictDesktopSession();
+        uint8_t GetEvictedDesktopSessionID() const { return m_desktop_evicted_id; }
+        uint32_t GetEvictedDesktopUpdateID() const { return m_desktop_evicted_upd; }
+        //true if it's time to ask the user to restart evicted session
+        bool DesktopRefreshDue(uint32_t tm);
 
         //desktop packets being transmitted to this user
         desktop_transmitter_t StartDesktopTransmitter(const ServerUser& src_user,
@@ -251,6 +262,10 @@ namespace teamtalk {
         ACE_HANDLE m_stream_handle;
             
         int m_nLastKeepAlive;
+        //last voice packet received
+        uint8_t m_voice_stream_id;
+        uint16_t m_voice_pkt_no;
+        uint32_t m_voice_pkt_time;
         ACE_Weak_Bound_Ptr< ServerChannel, ACE_Null_Mutex > m_channel;
         ACE_Time_Value m_LogonTime;
 
@@ -266,6 +281,10 @@ namespace teamtalk {
         //desktop session, from this user
         desktop_cache_t m_desktop_cache;
         desktoppackets_t m_desktop_queue;
+        //session evicted from 'm_desktop_cache' (0 = none)
+        uint8_t m_desktop_evicted_id;
+        uint32_t m_desktop_evicted_upd;
+        uint32_t m_desktop_refresh_time;
         //desktop session, to this user, src-user -> desktop transmitter
         typedef std::map<int, desktop_transmitter_t> user_desktoptx_t;
         user_desktoptx_t m_user_desktop_tx;
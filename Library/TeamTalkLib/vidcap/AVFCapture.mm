@@ -76,7 +76,7 @@ public:
     media::VideoFormat GetVideoFormat()
     {
         media::VideoFormat fmt = m_vidfmt;
-        fmt.fourcc = FOURCC_RGB32;
+        fmt.fourcc = FOURCC_I420;
         return fmt;
     }
 };
@@ -66,6 +66,8 @@ bool FFMpeg3Capture::StartVideoCapture(const ACE_TString& deviceid,
 
     MediaStreamOutput out_prop;
     out_prop.video = true;
+    //VideoThread encodes I420 without conversion
+    out_prop.video_fourcc = media::FOURCC_I420;
 
     if(!streamer->OpenFile(in_prop, out_prop))
         return false;
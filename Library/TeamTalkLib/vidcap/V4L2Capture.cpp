@@ -74,7 +74,22 @@ public:
         os << m_media_in.video_width << "x" << m_media_in.video_height;
         av_dict_set(&options, "video_size", os.str().c_str(), 0);
 
-        av_dict_set(&options, "pixel_format", "0rgb", 0);
+        // capture in the camera's native format. The filter graph
+        // converts it to I420 which is what the encoder wants
+        switch(m_vidfmt.fourcc)
+        {
+        case FOURCC_I420 :
+            av_dict_set(&options, "pixel_format", "yuv420p", 0);
+            break;
+        case FOURCC_YUY2 :
+            av_dict_set(&options, "pixel_format", "yuyv422", 0);
+            break;
+        case FOURCC_RGB32 :
+            av_dict_set(&options, "pixel_format", "0rgb", 0);
+            break;
+        case FOURCC_NONE :
+            break;
+        }
 
         return FFMpegVideoInput::SetupInput(iformat, options, fmt_ctx,
                                             aud_dec_ctx, vid_dec_ctx,
@@ -85,7 +100,7 @@ public:
     media::VideoFormat GetVideoFormat()
     {
         media::VideoFormat fmt = m_vidfmt;
-        // fmt.fourcc = FOURCC_RGB32;
+        fmt.fourcc = FOURCC_I420;
         return fmt;
     }
 };
@@ -689,12 +689,19 @@ extern "C" {
     /** @brief The protocols supported for transferring a
      * #DesktopWindow.
      *
-     * So far only one, UDP-based, protocol is supported. */
+     * Both protocols are UDP-based and produce ZLIB compressed
+     * blocks, so a receiver can decode either. A receiver's
+     * #DesktopWindow always reports #DESKTOPPROTOCOL_ZLIB_1. */
     typedef enum DesktopProtocol
     {
         /** @brief Desktop protocol based on ZLIB for image
          * compression and UDP for data transmission. */
-        DESKTOPPROTOCOL_ZLIB_1  = 1
+        DESKTOPPROTOCOL_ZLIB_1  = 1,
+        /** @brief Same as #DESKTOPPROTOCOL_ZLIB_1 but blocks are
+         * compressed for speed instead of size. Reduces the time
+         * it takes to process a desktop update at the cost of
+         * more bandwidth. */
+        DESKTOPPROTOCOL_ZLIB_FAST = 2
     } DesktopProtocol;
 
     /**
@@ -730,6 +737,24 @@ extern "C" {
         INT32 nFrameBufferSize;
     } DesktopWindow;
 
+    /**
+     * @brief A rectangle in the bitmap of a #DesktopWindow which has
+     * changed since the previous desktop update.
+     *
+     * @see TT_SendDesktopWindowEx() */
+    typedef struct DesktopRegion
+    {
+        /** @brief The left position in pixels. */
+        INT32 nX;
+        /** @brief The scan-line in @c frameBuffer of #DesktopWindow
+         * where the region starts. */
+        INT32 nY;
+        /** @brief The width in pixels of the region. */
+        INT32 nWidth;
+        /** @brief The number of scan-lines in the region. */
+        INT32 nHeight;
+    } DesktopRegion;
+
     /**
      * @brief The state of a key (or mouse button), i.e. if it's
      * pressed or released. @see DesktopInput */
@@ -969,7 +994,12 @@ extern "C" {
          * For echo cancellation to work the sound input and output device
          * must be the same sound card since the input and output stream
          * must be completely synchronized. Also it is recommended to also
-         * enable denoising and AGC for better echo cancellation. */
+         * enable denoising and AGC for better echo cancellation.
+         *
+         * Echo cancellation runs at the sample rate of the sound devices
+         * and the latency between the output and input stream is
+         * estimated automatically, so it also works when the audio codec
+         * uses a lower sample rate than the sound devices. */
         TTBOOL bEnableEchoCancellation;
         /** @brief Set maximum attenuation of the residual echo in dB 
          * (negative number). Default is -40.
@@ -1339,6 +1369,11 @@ extern "C" {
         INT64 nFilesRx;
         /** @brief The server's uptime in msec. */
         INT64 nUptimeMSec;
+        /** @brief The number of silent voice frames which clients
+         * did not transmit because of discontinuous transmission
+         * (DTX). Only unencrypted voice packets are counted.
+         * @see OpusCodec.bDTX */
+        INT64 nVoiceFramesSuppressed;
     } ServerStatistics;
 
     /**
@@ -1769,6 +1804,36 @@ extern "C" {
         /** @brief Number of media file video frames dropped because user 
          * application didn't retrieve video frames in time. */
         INT64 nMediaFileVideoFramesDropped;
+        /** @brief Number of voice packets which arrived after their
+         * playout deadline and were discarded. */
+        INT64 nVoicePacketsLate;
+        /** @brief Number of voice frames which were lost and instead
+         * recovered from forward error correction data or
+         * interpolated by the audio codec. */
+        INT64 nVoiceFramesConcealed;
+        /** @brief Number of media file audio packets which arrived
+         * after their playout deadline and were discarded. */
+        INT64 nMediaFileAudioPacketsLate;
+        /** @brief Number of media file audio frames which were lost
+         * and instead recovered or interpolated by the audio codec. */
+        INT64 nMediaFileAudioFramesConcealed;
+        /** @brief Inter-arrival jitter of voice packets in msec. The
+         * jitter buffer adapts its playout delay to this value. */
+        INT32 nVoiceJitterMSec;
+        /** @brief Inter-arrival jitter of media file audio packets in
+         * msec. */
+        INT32 nMediaFileAudioJitterMSec;
+        /** @brief Number of video frames which were decoded ahead of
+         * #TT_AcquireUserVideoCaptureFrame but discarded because the
+         * user application didn't retrieve them in time. Frames are
+         * only decoded ahead once the user application has retrieved
+         * a video frame. */
+        INT64 nVideoCaptureFramesSkipped;
+        /** @brief Number of media file video frames which were
+         * decoded ahead of #TT_AcquireUserMediaVideoFrame but
+         * discarded because the user application didn't retrieve them
+         * in time. */
+        INT64 nMediaFileVideoFramesSkipped;
     } UserStatistics;
 
     /** 
@@ -2057,6 +2122,31 @@ extern "C" {
         /** @brief The number of seconds nothing has been received by
          * the client on UDP. */
         INT32 nUdpServerSilenceSec;
+        /** @brief The number of voice frames from the sound input
+         * device which were dropped because the audio encoder could
+         * not keep up. */
+        INT32 nVoiceCaptureOverruns;
+        /** @brief The number of silent voice frames which were not
+         * transmitted because of discontinuous transmission (DTX).
+         * @see OpusCodec.bDTX */
+        INT32 nVoiceFramesSuppressed;
+        /** @brief The number of events which were merged into an
+         * event of the same kind already in the #TTMessage queue
+         * because TT_GetMessage() could not keep up. E.g. two
+         * #CLIENTEVENT_USER_STATECHANGE for the same user become one
+         * event with the latest #User state. */
+        INT32 nEventsCoalesced;
+        /** @brief The number of events which were dropped because
+         * the #TTMessage queue overflowed.
+         * @see INTERR_TTMESSAGE_QUEUE_OVERFLOW */
+        INT32 nEventsDropped;
+        /** @brief The maximum size in bytes of the payload data
+         * currently put in UDP packets to the server. This is
+         * raised above the default by TT_QueryMaxPayload() if the
+         * path to the server allows it and reverted if packets of
+         * this size are lost.
+         * @see CLIENTEVENT_CON_MAX_PAYLOAD_UPDATED */
+        INT32 nMaxPayloadSize;
     } ClientStatistics;
 
     /** @addtogroup errorhandling
@@ -2341,10 +2431,12 @@ extern "C" {
         /** @brief #TTMessage event queue overflowed.
          *
          * The message queue for events has overflowed because
-         * TT_GetMessage() has not drained the queue in time. The
-         * #TTMessage message queue will suspend event handling once
-         * the queue overflows and resumes event handling again when
-         * the message queue has been drained. */
+         * TT_GetMessage() has not drained the queue in time. Event
+         * handling continues but events which only report the latest
+         * state of a user or stream, e.g. #CLIENTEVENT_USER_STATECHANGE
+         * and #CLIENTEVENT_USER_AUDIOBLOCK, are dropped until the
+         * message queue has been drained. Other events are never
+         * dropped. @see ClientStatistics.nEventsDropped */
         INTERR_TTMESSAGE_QUEUE_OVERFLOW = 10004,
     } ClientError;
 
@@ -2415,7 +2507,10 @@ extern "C" {
          * @param ttType #__INT32
          * @param nPayloadSize Placed in union of #TTMessage. The
          * maximum size in bytes of the payload data which is put in
-         * UDP packets. 0 means the max payload query failed.  @see
+         * UDP packets. 0 means the max payload query failed. Also
+         * posted when a payload size above the default found by
+         * TT_QueryMaxPayload() falls back to the default size due
+         * to packet loss.  @see
          * TT_QueryMaxPayload() */
         CLIENTEVENT_CON_MAX_PAYLOAD_UPDATED = CLIENTEVENT_NONE + 40,
         /** 
@@ -2758,6 +2853,10 @@ extern "C" {
          *
          * Call TT_AcquireUserAudioBlock() to extract the #AudioBlock.
          *
+         * If TT_GetMessage() cannot keep up then one event can
+         * represent several audio blocks, so keep calling
+         * TT_AcquireUserAudioBlock() until it returns NULL.
+         *
          * @param nSource The user ID.
          * @param ttType #__STREAMTYPE */
         CLIENTEVENT_USER_AUDIOBLOCK = CLIENTEVENT_NONE + 570,
@@ -3144,6 +3243,32 @@ extern "C" {
      * @see TT_CloseTeamTalk */
     TEAMTALKDLL_API TTInstance* TT_InitTeamTalkPoll();
 
+    /**
+     * @brief Share a fixed number of threads between client instances.
+     *
+     * By default every client instance runs its own network thread
+     * which handles its sockets and timers. Applications which create
+     * many client instances in the same process, e.g. bots, can
+     * instead let the client instances share @c nThreads network
+     * threads.
+     *
+     * The setting applies to client instances created after this call
+     * by #TT_InitTeamTalk or #TT_InitTeamTalkPoll. Client instances
+     * already created keep their network thread.
+     *
+     * Client instances on the same network thread also share its
+     * lock, so a TT_* call on one client instance, e.g. one which
+     * opens a sound device, blocks the TT_* calls and network
+     * traffic of the other client instances on that thread until it
+     * returns. Use more threads if the client instances must not
+     * wait for each other.
+     *
+     * @param nThreads Number of shared network threads. Maximum is 64.
+     * 0 means every client instance has its own network thread.
+     * @return FALSE if @c nThreads is invalid or the threads could
+     * not be created. */
+    TEAMTALKDLL_API TTBOOL TT_SetSharedReactorThreads(IN INT32 nThreads);
+
     /** 
      * @brief Close the TeamTalk client instance and release its
      * resources.
@@ -3172,6 +3297,30 @@ extern "C" {
                                          OUT TTMessage* pMsg,
                                          IN const INT32* pnWaitMs);
 
+    /**
+     * @brief Poll for several events in the client instance.
+     *
+     * Same as TT_GetMessage() but retrieves all queued events, up to
+     * @c pnCount, in one call. This is more efficient for
+     * applications which process many events, e.g. bots on servers
+     * with many users.
+     *
+     * @param lpTTInstance Pointer to client instance created by
+     * #TT_InitTeamTalk.
+     * @param pMsgs Array of TTMessage instances which will hold the
+     * events that have occured.
+     * @param pnCount In: The number of elements in @c pMsgs. Out: The
+     * number of events placed in @c pMsgs.
+     * @param nWaitMs The amount of time to wait for the first event. If
+     * -1 the function will block forever or until the next event occurs.
+     * @return Returns TRUE if at least one event has occured otherwise
+     * FALSE.
+     * @see TT_GetMessage */
+    TEAMTALKDLL_API TTBOOL TT_GetMessages(IN TTInstance* lpTTInstance,
+                                          OUT TTMessage* pMsgs,
+                                          IN OUT INT32* pnCount,
+                                          IN INT32 nWaitMs);
+
     /**
      * @brief Cause client instance event thread to schedule an update
      * event.
@@ -4090,6 +4239,37 @@ extern "C" {
                                                IN const DesktopWindow* lpDesktopWindow,
                                                IN BitmapFormat nConvertBmpFormat);
 
+    /**
+     * @brief Transmit a desktop window (bitmap) where only the
+     * specified regions have changed.
+     *
+     * Same as TT_SendDesktopWindow() except only the parts of the
+     * bitmap which intersect @c lpDirtyRegions are checked for
+     * changes. Use this if e.g. the operating system reports which
+     * parts of the screen have been redrawn since it avoids scanning
+     * the entire bitmap. Changes outside the regions are not
+     * transmitted. If the call fails the regions must be included
+     * again in the next call.
+     *
+     * The first bitmap of a desktop session is always transmitted
+     * entirely.
+     *
+     * @param lpTTInstance Pointer to client instance created by
+     * #TT_InitTeamTalk. 
+     * @param lpDesktopWindow Properties of the bitmap. Set the @c nSessionID 
+     * property to 0.
+     * @param nConvertBmpFormat Before transmission convert the bitmap to this 
+     * format.
+     * @param lpDirtyRegions Array of regions which have changed since
+     * the previous call.
+     * @param nDirtyRegionsCount Number of elements in @c lpDirtyRegions.
+     * @return See TT_SendDesktopWindow(). */
+    TEAMTALKDLL_API INT32 TT_SendDesktopWindowEx(IN TTInstance* lpTTInstance,
+                                                 IN const DesktopWindow* lpDesktopWindow,
+                                                 IN BitmapFormat nConvertBmpFormat,
+                                                 IN const DesktopRegion* lpDirtyRegions,
+                                                 IN INT32 nDirtyRegionsCount);
+
     /**
      * @brief Close the current desktop session.
      *
@@ -4530,6 +4710,10 @@ extern "C" {
      * The #CLIENTEVENT_CON_MAX_PAYLOAD_UPDATED event is posted when
      * the query has finished.
      *
+     * The query may find a payload size above the default. The
+     * server forwards packets of this size unchanged to other users
+     * so only query when their paths are also known to allow it.
+     *
      * @param lpTTInstance Pointer to client instance created by
      * #TT_InitTeamTalk. 
      * @param nUserID The ID of the user to query or 0 for querying 